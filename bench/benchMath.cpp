@@ -0,0 +1,1035 @@
+﻿//-----------------------------------------------------------------------------
+// File : benchMath.cpp
+// Desc : Micro Benchmark for asdxMath.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <asdxMath.h>
+#include <asdxMathPacket.h>
+#include <asdxMathFast.h>
+#include <asdxStopWatch.h>
+#include <asdxLogger.h>
+#include <bvh.h>
+#include "verifyMath.h"
+#include "verifyScene.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// Config structure
+///////////////////////////////////////////////////////////////////////////////
+struct Config
+{
+    size_t      Count       = 1 << 14;      //!< 1回の計測で処理する要素数.
+    size_t      Instances   = 1 << 20;      //!< インスタンス準備の計測で処理するインスタンス数.
+    uint32_t    Repeat      = 15;           //!< 計測回数.
+    double      WarmupMsec  = 200.0;        //!< ウォームアップ時間(ミリ秒).
+    double      SampleMsec  = 5.0;          //!< 1回の計測の最低時間(ミリ秒).
+    int         Cpu         = 0;            //!< 固定するCPU番号(負の場合は固定しない).
+    const char* Filter      = nullptr;      //!< 名前に含まれる文字列で絞り込みます.
+    const char* JsonPath    = nullptr;      //!< JSONの出力先.
+    const char* Baseline    = nullptr;      //!< 比較元のJSON(スカラー版の出力など).
+    bool        Verify      = false;        //!< 計測せずに検証だけを行います.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Result structure
+///////////////////////////////////////////////////////////////////////////////
+struct Result
+{
+    std::string Name;           //!< ベンチマーク名.
+    size_t      Count;          //!< 1回の計測で処理した要素数.
+    uint64_t    Iterations;     //!< 1回の計測での繰り返し数.
+    double      NsPerOpMin;     //!< 1要素あたりの時間(最小値).
+    double      NsPerOpMedian;  //!< 1要素あたりの時間(中央値).
+    double      GBPerSec;       //!< 最小値から求めた帯域(読み込み + 書き込み).
+};
+
+//-----------------------------------------------------------------------------
+// Global Variables.
+//-----------------------------------------------------------------------------
+volatile uint32_t g_Sink = 0;
+
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+#if ASDX_SIMD
+constexpr bool ENABLE_SSE4 = true;
+#else
+constexpr bool ENABLE_SSE4 = false;
+#endif
+#if ASDX_SIMD_AVX2
+constexpr bool ENABLE_AVX2 = true;
+#else
+constexpr bool ENABLE_AVX2 = false;
+#endif
+#if ASDX_SIMD_F16C
+constexpr bool ENABLE_F16C = true;
+#else
+constexpr bool ENABLE_F16C = false;
+#endif
+#if ASDX_SIMD_AVX512
+constexpr bool ENABLE_AVX512 = true;
+#else
+constexpr bool ENABLE_AVX512 = false;
+#endif
+
+//-----------------------------------------------------------------------------
+//      真偽値を文字列に変換します.
+//-----------------------------------------------------------------------------
+const char* ToString(bool value)
+{ return value ? "true" : "false"; }
+
+//-----------------------------------------------------------------------------
+//      計測結果を最適化で消されないように参照します.
+//-----------------------------------------------------------------------------
+template<typename T>
+void Consume(const T* values, size_t count)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &values[count / 2], std::min(sizeof(bits), sizeof(T)));
+    g_Sink = g_Sink + bits;
+}
+
+//-----------------------------------------------------------------------------
+//      スレッドをCPUに固定し, 優先度を上げます.
+//-----------------------------------------------------------------------------
+void PinThread(int cpu)
+{
+    if (cpu < 0)
+    { return; }
+
+#if defined(_WIN32)
+    SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS);
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu);
+#else
+    // 優先度の引き上げは権限が無ければ失敗するが, 計測自体は続行する.
+    setpriority(PRIO_PROCESS, 0, -10);
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Runner class
+///////////////////////////////////////////////////////////////////////////////
+class Runner
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    explicit Runner(const Config& config)
+    : m_Config(config)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ベンチマークを実行します.
+    //!
+    //! @param[in]      name        ベンチマーク名.
+    //! @param[in]      bytesPerOp  1要素あたりの読み書きバイト数.
+    //! @param[in]      func        Count 要素を処理する関数.
+    //-------------------------------------------------------------------------
+    template<typename Func>
+    void Run(const char* name, size_t bytesPerOp, Func func)
+    { Run(name, m_Config.Count, bytesPerOp, func); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      要素数を指定してベンチマークを実行します.
+    //!
+    //! @param[in]      name        ベンチマーク名.
+    //! @param[in]      count       func が1回で処理する要素数.
+    //! @param[in]      bytesPerOp  1要素あたりの読み書きバイト数.
+    //! @param[in]      func        count 要素を処理する関数.
+    //-------------------------------------------------------------------------
+    template<typename Func>
+    void Run(const char* name, size_t count, size_t bytesPerOp, Func func)
+    {
+        if (m_Config.Filter != nullptr && strstr(name, m_Config.Filter) == nullptr)
+        { return; }
+
+        asdx::StopWatch timer;
+
+        // ウォームアップ.
+        uint64_t calls = 0;
+        timer.Start();
+        do
+        {
+            func();
+            calls++;
+            timer.End();
+        }
+        while (timer.GetElapsedMsec() < m_Config.WarmupMsec);
+
+        // 1回の計測が SampleMsec 以上になるように繰り返し数を決める.
+        auto msecPerCall = timer.GetElapsedMsec() / double(calls);
+        auto iterations  = std::max<uint64_t>(1, uint64_t(m_Config.SampleMsec / std::max(msecPerCall, 1e-6)));
+
+        std::vector<double> samples;
+        samples.reserve(m_Config.Repeat);
+        for(auto i=0u; i<m_Config.Repeat; ++i)
+        {
+            timer.Start();
+            for(auto j=0u; j<iterations; ++j)
+            { func(); }
+            timer.End();
+
+            samples.push_back(timer.GetElapsedSec() * 1e9 / double(iterations * count));
+        }
+        std::sort(samples.begin(), samples.end());
+
+        Result result;
+        result.Name          = name;
+        result.Count         = count;
+        result.Iterations    = iterations;
+        result.NsPerOpMin    = samples.front();
+        result.NsPerOpMedian = samples[samples.size() / 2];
+        result.GBPerSec      = double(bytesPerOp) / result.NsPerOpMin;
+
+        printf("%-32s %10.3f ns/op  %10.3f ns/op (median)  %8.2f GB/s",
+            name, result.NsPerOpMin, result.NsPerOpMedian, result.GBPerSec);
+
+        // 比較元に同じ名前があれば, 最小値どうしの比を速度向上率として表示する.
+        auto itr = m_Baseline.find(result.Name);
+        if (itr != m_Baseline.end())
+        { printf("  %7.2fx", itr->second / result.NsPerOpMin); }
+        printf("\n");
+
+        m_Results.push_back(result);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      比較元の結果を WriteJson() の出力から読み込みます.
+    //!
+    //! @param[in]      path        JSONファイルパス.
+    //! @retval true    読み込みに成功.
+    //! @retval false   ファイルを開けないか, 結果が1件も無い.
+    //-------------------------------------------------------------------------
+    bool LoadBaseline(const char* path)
+    {
+        FILE* pFile = nullptr;
+    #if defined(_WIN32)
+        if (fopen_s(&pFile, path, "r") != 0)
+        { pFile = nullptr; }
+    #else
+        pFile = fopen(path, "r");
+    #endif
+        if (pFile == nullptr)
+        { return false; }
+
+        // WriteJson() は1行に1件ずつ書くので, 行ごとに名前と ns_per_op を拾う.
+        static const char NAME_KEY[] = "\"name\": \"";
+        static const char TIME_KEY[] = "\"ns_per_op\": ";
+
+        char line[1024];
+        while (fgets(line, sizeof(line), pFile) != nullptr)
+        {
+            auto name = strstr(line, NAME_KEY);
+            auto time = strstr(line, TIME_KEY);
+            if (name == nullptr || time == nullptr)
+            { continue; }
+
+            name += sizeof(NAME_KEY) - 1;
+            auto end = strchr(name, '"');
+            if (end == nullptr)
+            { continue; }
+
+            m_Baseline[std::string(name, end)] = atof(time + sizeof(TIME_KEY) - 1);
+        }
+
+        fclose(pFile);
+        return !m_Baseline.empty();
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      結果をJSONで出力します.
+    //-------------------------------------------------------------------------
+    bool WriteJson(const char* path) const
+    {
+        FILE* pFile = nullptr;
+    #if defined(_WIN32)
+        if (fopen_s(&pFile, path, "w") != 0)
+        { pFile = nullptr; }
+    #else
+        pFile = fopen(path, "w");
+    #endif
+        if (pFile == nullptr)
+        { return false; }
+
+        fprintf(pFile, "{\n");
+        fprintf(pFile, "  \"benchmark\": \"asdxMath\",\n");
+        fprintf(pFile, "  \"config\": { \"count\": %zu, \"repeat\": %u, \"warmup_ms\": %.1f, \"cpu\": %d },\n",
+            m_Config.Count, m_Config.Repeat, m_Config.WarmupMsec, m_Config.Cpu);
+        fprintf(pFile, "  \"simd\": { \"sse4\": %s, \"avx2\": %s, \"f16c\": %s, \"avx512\": %s },\n",
+            ToString(ENABLE_SSE4),
+            ToString(ENABLE_AVX2),
+            ToString(ENABLE_F16C),
+            ToString(ENABLE_AVX512));
+        fprintf(pFile, "  \"results\": [\n");
+        for(size_t i=0; i<m_Results.size(); ++i)
+        {
+            const auto& r = m_Results[i];
+            fprintf(pFile, "    { \"name\": \"%s\", \"count\": %zu, \"iterations\": %llu, \"ns_per_op\": %.4f, \"ns_per_op_median\": %.4f, \"gb_per_sec\": %.4f }%s\n",
+                r.Name.c_str(), r.Count, (unsigned long long)r.Iterations, r.NsPerOpMin, r.NsPerOpMedian, r.GBPerSec,
+                (i + 1 < m_Results.size()) ? "," : "");
+        }
+        fprintf(pFile, "  ]\n");
+        fprintf(pFile, "}\n");
+
+        fclose(pFile);
+        return true;
+    }
+
+private:
+    Config                          m_Config;
+    std::vector<Result>             m_Results;
+    std::map<std::string, double>   m_Baseline;     // 名前ごとの比較元の ns/op(最小値).
+};
+
+//-----------------------------------------------------------------------------
+//      コマンドライン引数を解析します.
+//-----------------------------------------------------------------------------
+bool ParseArgs(int argc, char** argv, Config& config)
+{
+    for(auto i=1; i<argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--json") == 0 && hasValue)
+        { config.JsonPath = argv[++i]; }
+        else if (strcmp(argv[i], "--baseline") == 0 && hasValue)
+        { config.Baseline = argv[++i]; }
+        else if (strcmp(argv[i], "--filter") == 0 && hasValue)
+        { config.Filter = argv[++i]; }
+        else if (strcmp(argv[i], "--count") == 0 && hasValue)
+        { config.Count = std::max<size_t>(16, strtoull(argv[++i], nullptr, 10) & ~size_t(15)); }
+        else if (strcmp(argv[i], "--instances") == 0 && hasValue)
+        { config.Instances = std::max<size_t>(1, strtoull(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--repeat") == 0 && hasValue)
+        { config.Repeat = std::max(1u, uint32_t(strtoul(argv[++i], nullptr, 10))); }
+        else if (strcmp(argv[i], "--warmup") == 0 && hasValue)
+        { config.WarmupMsec = atof(argv[++i]); }
+        else if (strcmp(argv[i], "--cpu") == 0 && hasValue)
+        { config.Cpu = atoi(argv[++i]); }
+        else if (strcmp(argv[i], "--verify") == 0)
+        { config.Verify = true; }
+        else
+        {
+            printf("usage : %s [--json path] [--baseline path] [--filter text] [--count n] [--instances n] [--repeat n] [--warmup msec] [--cpu index(-1 = no pinning)] [--verify]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    using namespace asdx;
+
+    Config config;
+    if (!ParseArgs(argc, argv, config))
+    { return -1; }
+
+    // 一括処理とスカラー版の結果が一致するかを確かめる.
+    if (config.Verify)
+    {
+        // 読み込み時間などの情報ログは結果の表と混ざるので出さない.
+        SystemLogger::Instance().SetFilter(LOG_WARNING);
+
+        auto result = true;
+        result &= VerifyHalf();
+        result &= VerifyFast();
+        result &= VerifyOct();
+        result &= VerifyTable();
+        result &= VerifyRandom();
+        result &= VerifyBVH();
+        result &= VerifyGeometryMemory();
+        result &= VerifyMeshLoad();
+        result &= VerifySceneCache();
+        result &= VerifyInstanceBVH();
+        result &= VerifyMeshDedup();
+        result &= VerifyRefit();
+        result &= VerifyMotion();
+        result &= VerifyTessellation();
+        result &= VerifyCurves();
+        result &= VerifyAttributes();
+        result &= VerifyAlphaTest();
+        return result ? 0 : -1;
+    }
+
+    PinThread(config.Cpu);
+
+    const auto count = config.Count;
+
+    // 入力データ.
+    std::vector<Vector3>    v3a(count), v3b(count), v3r(count);
+    std::vector<Vector4>    v4a(count), v4r(count);
+    std::vector<Matrix>     ma(count), mb(count), mr(count);
+    std::vector<Quaternion> qa(count), qb(count), qr(count);
+    std::vector<float>      fa(count * 4), fr(count * 4);
+    std::vector<float>      fu(count), fp(count), fs(count);
+    std::vector<half>       ha(count * 4);
+    std::vector<uint32_t>   ua(count), ur(count);
+
+    {
+        XorShift rng(12345);
+        for(size_t i=0; i<count; ++i)
+        {
+            v3a[i] = Vector3(rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(0.1f, 1.0f));
+            v3b[i] = Vector3(rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(0.1f, 1.0f));
+            v4a[i] = Vector4(rng.GetAsF32(), rng.GetAsF32(), rng.GetAsF32(), rng.GetAsF32());
+
+            auto r = Matrix::CreateRotationFromYawPitchRoll(rng.GetAsF32(0.0f, F_2PI), rng.GetAsF32(0.0f, F_2PI), rng.GetAsF32(0.0f, F_2PI));
+            ma[i] = r * Matrix::CreateTranslation(rng.GetAsF32(-10.0f, 10.0f), rng.GetAsF32(-10.0f, 10.0f), rng.GetAsF32(-10.0f, 10.0f));
+            mb[i] = Matrix::CreateScale(rng.GetAsF32(0.5f, 2.0f)) * ma[i];
+
+            qa[i] = Quaternion::CreateFromYawPitchRoll(rng.GetAsF32(0.0f, F_2PI), rng.GetAsF32(0.0f, F_2PI), rng.GetAsF32(0.0f, F_2PI));
+            qb[i] = Quaternion::CreateFromYawPitchRoll(rng.GetAsF32(0.0f, F_2PI), rng.GetAsF32(0.0f, F_2PI), rng.GetAsF32(0.0f, F_2PI));
+
+            ua[i] = rng.GetAsU32();
+
+            fu[i] = rng.GetAsF32(-1.0f, 1.0f);
+            fp[i] = rng.GetAsF32(1e-4f, 1.0f);
+        }
+        for(size_t i=0; i<count * 4; ++i)
+        { fa[i] = rng.GetAsF32(-100.0f, 100.0f); }
+        ToHalf(fa.data(), ha.data(), count * 4);
+    }
+
+    const auto world = ma[0];
+
+    Runner runner(config);
+    if (config.Baseline != nullptr && !runner.LoadBaseline(config.Baseline))
+    {
+        printf("Error : Baseline Load Failed. path = %s\n", config.Baseline);
+        return -1;
+    }
+
+    // Vector3.
+    runner.Run("Vector3::Dot", sizeof(Vector3) * 2 + sizeof(float), [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = Vector3::Dot(v3a[i], v3b[i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("Vector3::Cross", sizeof(Vector3) * 3, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { v3r[i] = Vector3::Cross(v3a[i], v3b[i]); }
+        Consume(v3r.data(), count);
+    });
+    runner.Run("Vector3::Normalize", sizeof(Vector3) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { v3r[i] = Vector3::Normalize(v3a[i]); }
+        Consume(v3r.data(), count);
+    });
+    runner.Run("Vector3::Transform", sizeof(Vector3) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { v3r[i] = Vector3::Transform(v3a[i], world); }
+        Consume(v3r.data(), count);
+    });
+
+    // Vector3 の8レーン版(1要素あたりの時間なので Vector3 と直接比べられる).
+    {
+        const auto packets = count / 8;
+        std::vector<Vector3x8> p3a(packets), p3b(packets), p3r(packets);
+        std::vector<Floatx8>   pfr(packets);
+        for(size_t i=0; i<packets * 8; ++i)
+        {
+            p3a[i / 8].Set(uint32_t(i % 8), v3a[i]);
+            p3b[i / 8].Set(uint32_t(i % 8), v3b[i]);
+        }
+
+        runner.Run("Vector3::Dot(x8)", sizeof(Vector3) * 2 + sizeof(float), [&]()
+        {
+            for(size_t i=0; i<packets; ++i)
+            { pfr[i] = Vector3x8::Dot(p3a[i], p3b[i]); }
+            Consume(pfr.data(), packets);
+        });
+        runner.Run("Vector3::Cross(x8)", sizeof(Vector3) * 3, [&]()
+        {
+            for(size_t i=0; i<packets; ++i)
+            { p3r[i] = Vector3x8::Cross(p3a[i], p3b[i]); }
+            Consume(p3r.data(), packets);
+        });
+        runner.Run("Vector3::Normalize(x8)", sizeof(Vector3) * 2, [&]()
+        {
+            for(size_t i=0; i<packets; ++i)
+            { p3r[i] = Vector3x8::Normalize(p3a[i]); }
+            Consume(p3r.data(), packets);
+        });
+        runner.Run("Vector3::Transform(x8)", sizeof(Vector3) * 2, [&]()
+        {
+            for(size_t i=0; i<packets; ++i)
+            { p3r[i] = Vector3x8::Transform(p3a[i], world); }
+            Consume(p3r.data(), packets);
+        });
+    }
+
+    // Vector4.
+    runner.Run("Vector4::Dot", sizeof(Vector4) * 2 + sizeof(float), [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = Vector4::Dot(v4a[i], v4a[count - 1 - i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("Vector4::Normalize", sizeof(Vector4) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { v4r[i] = Vector4::Normalize(v4a[i]); }
+        Consume(v4r.data(), count);
+    });
+    runner.Run("Vector4::Transform", sizeof(Vector4) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { v4r[i] = Vector4::Transform(v4a[i], world); }
+        Consume(v4r.data(), count);
+    });
+
+    // Matrix.
+    runner.Run("Matrix::Multiply", sizeof(Matrix) * 3, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { Matrix::Multiply(ma[i], mb[i], mr[i]); }
+        Consume(mr.data(), count);
+    });
+    runner.Run("Matrix::Invert", sizeof(Matrix) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { Matrix::Invert(mb[i], mr[i]); }
+        Consume(mr.data(), count);
+    });
+    runner.Run("Matrix::InvertAffine[]", sizeof(Matrix) * 2, [&]()
+    {
+        Matrix::InvertAffine(mb.data(), mr.data(), count);
+        Consume(mr.data(), count);
+    });
+    runner.Run("Matrix::InvertRigid[]", sizeof(Matrix) * 2, [&]()
+    {
+        Matrix::InvertRigid(ma.data(), mr.data(), count);
+        Consume(mr.data(), count);
+    });
+
+    // インスタンスの準備(1M 個規模の変換行列とインスタンスBVHで, 1インスタンスあたりの時間).
+    // 要素数が小さいとキャッシュに収まってしまうので, 実際のシーンに近い個数で計測する.
+    {
+        const auto instances = config.Instances;
+
+        std::vector<Matrix> transforms(instances), inverses(instances);
+        {
+            XorShift rng(54321);
+            for(size_t i=0; i<instances; ++i)
+            {
+                auto r = Matrix::CreateRotationFromYawPitchRoll(rng.GetAsF32(0.0f, F_2PI), rng.GetAsF32(0.0f, F_2PI), rng.GetAsF32(0.0f, F_2PI));
+                transforms[i] = Matrix::CreateScale(rng.GetAsF32(0.5f, 2.0f)) * r
+                    * Matrix::CreateTranslation(rng.GetAsF32(-1000.0f, 1000.0f), rng.GetAsF32(-1000.0f, 1000.0f), rng.GetAsF32(-1000.0f, 1000.0f));
+            }
+        }
+
+        runner.Run("Instance Matrix::Invert", instances, sizeof(Matrix) * 2, [&]()
+        {
+            for(size_t i=0; i<instances; ++i)
+            { Matrix::Invert(transforms[i], inverses[i]); }
+            Consume(inverses.data(), instances);
+        });
+        runner.Run("Instance Matrix::InvertAffine[]", instances, sizeof(Matrix) * 2, [&]()
+        {
+            Matrix::InvertAffine(transforms.data(), inverses.data(), instances);
+            Consume(inverses.data(), instances);
+        });
+
+        // プロトタイプは立方体1個. 走査はしないので形状は問わない.
+        const Vector3 corners[8] = {
+            Vector3(-1.0f, -1.0f, -1.0f), Vector3( 1.0f, -1.0f, -1.0f), Vector3(-1.0f,  1.0f, -1.0f), Vector3( 1.0f,  1.0f, -1.0f),
+            Vector3(-1.0f, -1.0f,  1.0f), Vector3( 1.0f, -1.0f,  1.0f), Vector3(-1.0f,  1.0f,  1.0f), Vector3( 1.0f,  1.0f,  1.0f) };
+        const uint32_t faces[36] = {
+            0, 2, 1, 1, 2, 3,   4, 5, 6, 5, 7, 6,   0, 1, 4, 1, 5, 4,
+            2, 6, 3, 3, 6, 7,   0, 4, 2, 2, 4, 6,   1, 3, 5, 3, 7, 5 };
+        BVH prototype;
+        prototype.AddTriangles(corners, faces, 12);
+        prototype.Build(1);
+
+        InstanceBVH scene;
+        runner.Run("InstanceBVH::AddInstance", instances, sizeof(Matrix), [&]()
+        {
+            scene.Clear();
+            auto id = scene.AddPrototype(&prototype);
+            for(size_t i=0; i<instances; ++i)
+            { scene.AddInstance(id, transforms[i], uint32_t(i)); }
+        });
+        runner.Run("InstanceBVH::Build", instances, sizeof(Matrix), [&]()
+        { scene.Build(); });
+
+        const auto& stats = scene.GetStats();
+        const auto  MB    = 1.0 / (1024.0 * 1024.0);
+        printf("%-32s %10zu instances  build = %.2f ms  memory = %.2f MB (%.1f B/instance)  peak = %.2f MB\n",
+            "InstanceBVH", instances, stats.BuildMsec,
+            double(stats.MemorySize) * MB, double(stats.MemorySize) / double(instances),
+            double(stats.PeakMemorySize) * MB);
+    }
+
+    // Quaternion.
+    runner.Run("Quaternion::Slerp", sizeof(Quaternion) * 3, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { Quaternion::Slerp(qa[i], qb[i], 0.3f, qr[i]); }
+        Consume(qr.data(), count);
+    });
+
+    // 乱数.
+    {
+        XorShift xorshift(1);
+        PCG      pcg(1);
+
+        int      seeds32[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        uint64_t seeds64[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        XorShiftx8 xorshift8(seeds32);
+        PCGx8      pcg8(seeds64);
+
+        runner.Run("XorShift::GetAsU32", sizeof(uint32_t), [&]()
+        {
+            for(size_t i=0; i<count; ++i)
+            { ur[i] = xorshift.GetAsU32(); }
+            Consume(ur.data(), count);
+        });
+        runner.Run("XorShift::GetAsF32", sizeof(float), [&]()
+        {
+            for(size_t i=0; i<count; ++i)
+            { fr[i] = xorshift.GetAsF32(); }
+            Consume(fr.data(), count);
+        });
+        runner.Run("PCG::GetAsU32", sizeof(uint32_t), [&]()
+        {
+            for(size_t i=0; i<count; ++i)
+            { ur[i] = pcg.GetAsU32(); }
+            Consume(ur.data(), count);
+        });
+        runner.Run("PCG::GetAsF32", sizeof(float), [&]()
+        {
+            for(size_t i=0; i<count; ++i)
+            { fr[i] = pcg.GetAsF32(); }
+            Consume(fr.data(), count);
+        });
+        runner.Run("XorShiftx8::Fill", sizeof(uint32_t), [&]()
+        {
+            xorshift8.Fill(ur.data(), count);
+            Consume(ur.data(), count);
+        });
+        runner.Run("PCGx8::Fill", sizeof(uint32_t), [&]()
+        {
+            pcg8.Fill(ur.data(), count);
+            Consume(ur.data(), count);
+        });
+    }
+
+    // 半精度.
+    runner.Run("ToHalf", sizeof(float) + sizeof(half), [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { ha[i] = ToHalf(fa[i]); }
+        Consume(ha.data(), count);
+    });
+    runner.Run("ToFloat", sizeof(half) + sizeof(float), [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = ToFloat(ha[i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("ToHalf[]", sizeof(float) + sizeof(half), [&]()
+    {
+        ToHalf(fa.data(), ha.data(), count);
+        Consume(ha.data(), count);
+    });
+    runner.Run("ToFloat[]", sizeof(half) + sizeof(float), [&]()
+    {
+        ToFloat(ha.data(), fr.data(), count);
+        Consume(fr.data(), count);
+    });
+
+    // 超越関数(libm と asdx::fast).
+    runner.Run("exp2f", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = exp2f(fu[i] * 10.0f); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Exp2", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = fast::Exp2(fu[i] * 10.0f); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Exp2(x8)", sizeof(float) * 2, [&]()
+    {
+        const auto scale = Floatx8::Set1(10.0f);
+        for(size_t i=0; i<count; i+=8)
+        { fast::Exp2(Floatx8::Load(&fu[i]) * scale).Store(&fr[i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("log2f", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = log2f(fp[i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Log2", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = fast::Log2(fp[i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Log2(x8)", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; i+=8)
+        { fast::Log2(Floatx8::Load(&fp[i])).Store(&fr[i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("powf", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = powf(fp[i], 1.0f / 2.4f); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Pow", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = fast::Pow(fp[i], 1.0f / 2.4f); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Pow(x8)", sizeof(float) * 2, [&]()
+    {
+        const auto y = Floatx8::Set1(1.0f / 2.4f);
+        for(size_t i=0; i<count; i+=8)
+        { fast::Pow(Floatx8::Load(&fp[i]), y).Store(&fr[i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("sinf/cosf", sizeof(float) * 3, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        {
+            fr[i] = sinf(fu[i] * F_PI);
+            fs[i] = cosf(fu[i] * F_PI);
+        }
+        Consume(fr.data(), count);
+        Consume(fs.data(), count);
+    });
+    runner.Run("fast::SinCos", sizeof(float) * 3, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fast::SinCos(fu[i] * F_PI, fr[i], fs[i]); }
+        Consume(fr.data(), count);
+        Consume(fs.data(), count);
+    });
+    runner.Run("fast::SinCos(x8)", sizeof(float) * 3, [&]()
+    {
+        const auto scale = Floatx8::Set1(F_PI);
+        for(size_t i=0; i<count; i+=8)
+        {
+            Floatx8 s, c;
+            fast::SinCos(Floatx8::Load(&fu[i]) * scale, s, c);
+            s.Store(&fr[i]);
+            c.Store(&fs[i]);
+        }
+        Consume(fr.data(), count);
+        Consume(fs.data(), count);
+    });
+    runner.Run("acosf", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = acosf(fu[i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Acos", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = fast::Acos(fu[i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Acos(x8)", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; i+=8)
+        { fast::Acos(Floatx8::Load(&fu[i])).Store(&fr[i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("atan2f", sizeof(float) * 3, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = atan2f(fu[i], fp[i] - 0.5f); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Atan2", sizeof(float) * 3, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = fast::Atan2(fu[i], fp[i] - 0.5f); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Atan2(x8)", sizeof(float) * 3, [&]()
+    {
+        const auto offset = Floatx8::Set1(0.5f);
+        for(size_t i=0; i<count; i+=8)
+        { fast::Atan2(Floatx8::Load(&fu[i]), Floatx8::Load(&fp[i]) - offset).Store(&fr[i]); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("erff", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = erff(fu[i] * 3.0f); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Erf", sizeof(float) * 2, [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { fr[i] = fast::Erf(fu[i] * 3.0f); }
+        Consume(fr.data(), count);
+    });
+    runner.Run("fast::Erf(x8)", sizeof(float) * 2, [&]()
+    {
+        const auto scale = Floatx8::Set1(3.0f);
+        for(size_t i=0; i<count; i+=8)
+        { fast::Erf(Floatx8::Load(&fu[i]) * scale).Store(&fr[i]); }
+        Consume(fr.data(), count);
+    });
+
+    // UNORM/SNORM.
+    runner.Run("EncodeUnorm4", sizeof(Vector4) + sizeof(uint32_t), [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { ur[i] = EncodeUnorm4(v4a[i]); }
+        Consume(ur.data(), count);
+    });
+    runner.Run("DecodeUnorm4", sizeof(uint32_t) + sizeof(Vector4), [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { v4r[i] = DecodeUnorm4(ua[i]); }
+        Consume(v4r.data(), count);
+    });
+    runner.Run("EncodeSnorm4", sizeof(Vector4) + sizeof(uint32_t), [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { ur[i] = EncodeSnorm4(v4a[i]); }
+        Consume(ur.data(), count);
+    });
+    runner.Run("DecodeSnorm4", sizeof(uint32_t) + sizeof(Vector4), [&]()
+    {
+        for(size_t i=0; i<count; ++i)
+        { v4r[i] = DecodeSnorm4(ua[i]); }
+        Consume(v4r.data(), count);
+    });
+
+    // 八面体法線.
+    std::vector<Oct24> oa(count);
+    EncodeOct24(v3a.data(), oa.data(), count);
+    runner.Run("EncodeOct24[]", sizeof(Vector3) + sizeof(Oct24), [&]()
+    {
+        EncodeOct24(v3a.data(), oa.data(), count);
+        Consume(oa.data(), count);
+    });
+    runner.Run("DecodeOct24[]", sizeof(Oct24) + sizeof(Vector3), [&]()
+    {
+        DecodeOct24(oa.data(), v3r.data(), count);
+        Consume(v3r.data(), count);
+    });
+    runner.Run("EncodeOct32[]", sizeof(Vector3) + sizeof(uint32_t), [&]()
+    {
+        EncodeOct32(v3a.data(), ur.data(), count);
+        Consume(ur.data(), count);
+    });
+    runner.Run("DecodeOct32[]", sizeof(uint32_t) + sizeof(Vector3), [&]()
+    {
+        DecodeOct32(ua.data(), v3r.data(), count);
+        Consume(v3r.data(), count);
+    });
+
+    // レイ交差判定.
+    {
+        // 原点付近の三角形群に, Z軸負方向から撃ったレイを当てる.
+        const auto packets = (count + 7) / 8;
+        std::vector<Ray>        rays(count);
+        std::vector<Vector3>    invDirs(count);
+        std::vector<AABB>       boxes(count);
+        std::vector<AABBx4>     boxes4(packets * 2);
+        std::vector<AABBx8>     boxes8(packets);
+        std::vector<Vector3>    tris(count * 3);
+        std::vector<Trianglex4> tris4(packets * 2);
+        std::vector<Trianglex8> tris8(packets);
+        std::vector<uint32_t>   masks(packets * 2);
+
+        XorShift rng(54321);
+        for(size_t i=0; i<count; ++i)
+        {
+            auto target = Vector3(rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f), 0.0f);
+            auto origin = Vector3(rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f), -5.0f);
+            rays[i]    = Ray(origin, Vector3::Normalize(target - origin));
+            invDirs[i] = rays[i].GetInvDir();
+
+            auto center = Vector3(rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f));
+            for(auto k=0; k<3; ++k)
+            {
+                auto p = center + Vector3(rng.GetAsF32(-0.2f, 0.2f), rng.GetAsF32(-0.2f, 0.2f), rng.GetAsF32(-0.2f, 0.2f));
+                tris[i * 3 + k] = p;
+                boxes[i].Expand(p);
+            }
+
+            boxes4[i / 4].Set(uint32_t(i % 4), boxes[i]);
+            boxes8[i / 8].Set(uint32_t(i % 8), boxes[i]);
+            tris4 [i / 4].Set(uint32_t(i % 4), tris[i * 3 + 0], tris[i * 3 + 1], tris[i * 3 + 2]);
+            tris8 [i / 8].Set(uint32_t(i % 8), tris[i * 3 + 0], tris[i * 3 + 1], tris[i * 3 + 2]);
+        }
+
+        runner.Run("IntersectRayAABB", sizeof(AABB), [&]()
+        {
+            for(size_t i=0; i<count; ++i)
+            {
+                float tnear;
+                ur[i] = IntersectRayAABB(rays[i], invDirs[i], boxes[i], tnear) ? 1 : 0;
+            }
+            Consume(ur.data(), count);
+        });
+        runner.Run("IntersectRayAABB(x4)", sizeof(AABB), [&]()
+        {
+            for(size_t i=0; i<packets * 2; ++i)
+            {
+                float tnear[4];
+                masks[i] = IntersectRayAABB(rays[i * 4], invDirs[i * 4], boxes4[i], tnear);
+            }
+            Consume(masks.data(), packets * 2);
+        });
+        runner.Run("IntersectRayAABB(x8)", sizeof(AABB), [&]()
+        {
+            for(size_t i=0; i<packets; ++i)
+            {
+                Floatx8 tnear;
+                masks[i] = IntersectRayAABB(rays[i * 8], invDirs[i * 8], boxes8[i], tnear).Bits();
+            }
+            Consume(masks.data(), packets);
+        });
+
+        runner.Run("IntersectRayTriangle", sizeof(Vector3) * 3, [&]()
+        {
+            for(size_t i=0; i<count; ++i)
+            {
+                float t, u, v;
+                ur[i] = IntersectRayTriangle(rays[i], tris[i * 3 + 0], tris[i * 3 + 1], tris[i * 3 + 2], t, u, v) ? 1 : 0;
+            }
+            Consume(ur.data(), count);
+        });
+        runner.Run("IntersectRayTriangle(x4)", sizeof(Vector3) * 3, [&]()
+        {
+            for(size_t i=0; i<packets * 2; ++i)
+            {
+                float t[4], u[4], v[4];
+                masks[i] = IntersectRayTriangle(rays[i * 4], tris4[i], t, u, v);
+            }
+            Consume(masks.data(), packets * 2);
+        });
+        runner.Run("IntersectRayTriangle(x8)", sizeof(Vector3) * 3, [&]()
+        {
+            for(size_t i=0; i<packets; ++i)
+            {
+                Floatx8 t, u, v;
+                masks[i] = IntersectRayTriangle(rays[i * 8], tris8[i], t, u, v).Bits();
+            }
+            Consume(masks.data(), packets);
+        });
+
+        runner.Run("IntersectRayTriangleWatertight", sizeof(Vector3) * 3, [&]()
+        {
+            for(size_t i=0; i<count; ++i)
+            {
+                float t, u, v;
+                ur[i] = IntersectRayTriangleWatertight(rays[i], tris[i * 3 + 0], tris[i * 3 + 1], tris[i * 3 + 2], t, u, v) ? 1 : 0;
+            }
+            Consume(ur.data(), count);
+        });
+        runner.Run("IntersectRayTriangleWatertight(x4)", sizeof(Vector3) * 3, [&]()
+        {
+            for(size_t i=0; i<packets * 2; ++i)
+            {
+                float t[4], u[4], v[4];
+                masks[i] = IntersectRayTriangleWatertight(rays[i * 4], tris4[i], t, u, v);
+            }
+            Consume(masks.data(), packets * 2);
+        });
+        runner.Run("IntersectRayTriangleWatertight(x8)", sizeof(Vector3) * 3, [&]()
+        {
+            for(size_t i=0; i<packets; ++i)
+            {
+                Floatx8 t, u, v;
+                masks[i] = IntersectRayTriangleWatertight(rays[i * 8], tris8[i], t, u, v).Bits();
+            }
+            Consume(masks.data(), packets);
+        });
+
+        // BVH(構築は三角形あたり, 走査はレイあたりの時間).
+        std::vector<uint32_t> indices(count * 3);
+        for(size_t i=0; i<indices.size(); ++i)
+        { indices[i] = uint32_t(i); }
+
+        BVH bvh;
+        runner.Run("BVH::Build", sizeof(Vector3) * 3, [&]()
+        {
+            bvh.Clear();
+            bvh.AddTriangles(tris.data(), indices.data(), uint32_t(count));
+            bvh.Build();
+        });
+        runner.Run("BVH::Intersect", sizeof(Ray), [&]()
+        {
+            for(size_t i=0; i<count; ++i)
+            {
+                auto   ray = rays[i];
+                BVHHit hit;
+                ur[i] = bvh.Intersect(ray, hit) ? hit.PrimID : 0;
+            }
+            Consume(ur.data(), count);
+        });
+        runner.Run("BVH::Occluded", sizeof(Ray), [&]()
+        {
+            for(size_t i=0; i<count; ++i)
+            { ur[i] = bvh.Occluded(rays[i]) ? 1 : 0; }
+            Consume(ur.data(), count);
+        });
+    }
+
+    if (config.JsonPath != nullptr)
+    {
+        if (!runner.WriteJson(config.JsonPath))
+        {
+            printf("Error : Json Write Failed. path = %s\n", config.JsonPath);
+            return -1;
+        }
+    }
+
+    return 0;
+}
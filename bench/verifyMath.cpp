@@ -0,0 +1,851 @@
+﻿//-----------------------------------------------------------------------------
+// File : verifyMath.cpp
+// Desc : Verification for asdxMath.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <asdxMath.h>
+#include <asdxMathFast.h>
+#include <asdxMathPacket.h>
+#include <asdxMathTable.h>
+#include "verifyMath.h"
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t MAX_REPORT = 8;  //!< 不一致を表示する最大件数.
+
+//-----------------------------------------------------------------------------
+//      float型のビット列を取得します.
+//-----------------------------------------------------------------------------
+inline uint32_t AsBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+//-----------------------------------------------------------------------------
+//      ビット列からfloat型を生成します.
+//-----------------------------------------------------------------------------
+inline float AsFloat(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//-----------------------------------------------------------------------------
+// コンパイル時に生成した表が定数式として評価できることを確かめる.
+//-----------------------------------------------------------------------------
+static_assert(asdx::HAMMERSLEY_16[1].x == 1.0f / 16.0f, "Hammersley table is broken.");
+static_assert(asdx::HAMMERSLEY_16[1].y == 0.5f,         "Hammersley table is broken.");
+static_assert(asdx::HALTON23_64  [0].x == 0.5f,         "Halton table is broken.");
+static_assert(asdx::R2_64        [0].x == 0.5f,         "R2 table is broken.");
+static_assert(asdx::SRGB_TO_XYZ._12 == 0.2126390f,      "Color matrix must be transposed.");
+
+//-----------------------------------------------------------------------------
+//      検証結果を表示します.
+//-----------------------------------------------------------------------------
+bool Report(const char* name, size_t count, size_t mismatch)
+{
+    printf("%-32s %10zu values  %8zu mismatches  %s\n",
+        name, count, mismatch, (mismatch == 0) ? "OK" : "NG");
+    return mismatch == 0;
+}
+
+//-----------------------------------------------------------------------------
+//      サンプル表が実行時の関数とビット単位で一致するか検証します.
+//-----------------------------------------------------------------------------
+template<size_t N, typename Func>
+bool CheckSamples(const char* name, const std::array<asdx::Vector2, N>& table, Func func)
+{
+    size_t mismatch = 0;
+    for(uint32_t i=0; i<N; ++i)
+    {
+        auto expect = func(i);
+        if (AsBits(table[i].x) == AsBits(expect.x) && AsBits(table[i].y) == AsBits(expect.y))
+        { continue; }
+
+        if (mismatch < MAX_REPORT)
+        {
+            printf("  %s[%u] : (%.9g, %.9g) != (%.9g, %.9g)\n",
+                name, i, table[i].x, table[i].y, expect.x, expect.y);
+        }
+        mismatch++;
+    }
+    return Report(name, N, mismatch);
+}
+
+//-----------------------------------------------------------------------------
+//      色変換行列の組が互いの逆行列になっているか検証します.
+//-----------------------------------------------------------------------------
+bool CheckInverse(const char* name, const asdx::Matrix& a, const asdx::Matrix& b, double tolerance)
+{
+    // 係数は有効数字 7 桁なので, 積は倍精度で求めて丸め誤差を持ち込まない.
+    size_t mismatch = 0;
+    for(auto r=0; r<3; ++r)
+    {
+        for(auto c=0; c<3; ++c)
+        {
+            auto value = 0.0;
+            for(auto k=0; k<3; ++k)
+            { value += double(a.m[r][k]) * double(b.m[k][c]); }
+
+            auto expect = (r == c) ? 1.0 : 0.0;
+            if (fabs(value - expect) <= tolerance)
+            { continue; }
+
+            if (mismatch < MAX_REPORT)
+            { printf("  %s[%d][%d] : %.9g != %.9g\n", name, r, c, value, expect); }
+            mismatch++;
+        }
+    }
+    return Report(name, 9, mismatch);
+}
+
+//-----------------------------------------------------------------------------
+//      白色 (1, 1, 1) の変換結果が期待する白色点になるか検証します.
+//-----------------------------------------------------------------------------
+bool CheckWhite(const char* name, const asdx::Matrix& matrix, const asdx::Vector3& expect, float tolerance)
+{
+    auto value = asdx::Vector3::TransformNormal(asdx::Vector3(1.0f, 1.0f, 1.0f), matrix);
+    auto error = std::max(fabsf(value.x - expect.x), std::max(fabsf(value.y - expect.y), fabsf(value.z - expect.z)));
+    if (error > tolerance)
+    {
+        printf("  %s : (%.7f, %.7f, %.7f) != (%.7f, %.7f, %.7f)\n",
+            name, value.x, value.y, value.z, expect.x, expect.y, expect.z);
+    }
+    return Report(name, 3, (error > tolerance) ? 1 : 0);
+}
+
+//-----------------------------------------------------------------------------
+//      8レーンの乱数がレーンごとにスカラー版の数列と一致するか検証します.
+//-----------------------------------------------------------------------------
+template<typename Generator, typename Packet, typename Init>
+bool CheckRandomLanes(const char* name, const Init* inits, size_t count)
+{
+    // U32, F32, Fill(U32), Fill(F32) を順に引き, スカラー版も同じ順で進める.
+    Packet packet(inits);
+    std::vector<Generator> lanes;
+    for(auto i=0; i<8; ++i)
+    { lanes.emplace_back(inits[i]); }
+
+    std::vector<uint32_t> bits (8 * count);
+    std::vector<float>    value(8 * count);
+
+    size_t total    = 0;
+    size_t mismatch = 0;
+    auto check = [&](uint32_t lane, size_t index, uint32_t actual, uint32_t expect)
+    {
+        total++;
+        if (actual == expect)
+        { return; }
+
+        if (mismatch < MAX_REPORT)
+        { printf("  %s lane %u [%zu] : 0x%08x != 0x%08x\n", name, lane, index, actual, expect); }
+        mismatch++;
+    };
+
+    for(size_t k=0; k<count; ++k)
+    {
+        uint32_t u[8];
+        packet.GetAsU32(u);
+        for(uint32_t i=0; i<8; ++i)
+        { check(i, k, u[i], lanes[i].GetAsU32()); }
+
+        auto f = packet.GetAsF32();
+        for(uint32_t i=0; i<8; ++i)
+        { check(i, k, AsBits(f.Get(i)), AsBits(lanes[i].GetAsF32())); }
+    }
+
+    packet.Fill(bits.data(), bits.size());
+    packet.Fill(value.data(), value.size());
+    for(uint32_t i=0; i<8; ++i)
+    {
+        for(size_t k=0; k<count; ++k)
+        { check(i, k, bits[8 * k + i], lanes[i].GetAsU32()); }
+        for(size_t k=0; k<count; ++k)
+        { check(i, k, AsBits(value[8 * k + i]), AsBits(lanes[i].GetAsF32())); }
+    }
+
+    return Report(name, total, mismatch);
+}
+
+//-----------------------------------------------------------------------------
+//      Advance(n) が n 回の逐次生成と一致するか検証します.
+//-----------------------------------------------------------------------------
+template<typename Generator>
+bool CheckAdvance(const char* name, const Generator& origin)
+{
+    const uint64_t steps[] = { 0, 1, 2, 3, 31, 32, 33, 63, 64, 65, 127, 1000, 4093, 65536, 1000003 };
+
+    size_t mismatch = 0;
+    for(auto n : steps)
+    {
+        auto sequential = origin;
+        for(uint64_t i=0; i<n; ++i)
+        { sequential.GetAsU32(); }
+
+        auto jumped = origin;
+        jumped.Advance(n);
+
+        // 状態は非公開なので, 続きの数列が一致するかで比べる.
+        for(auto i=0; i<16; ++i)
+        {
+            auto a = jumped    .GetAsU32();
+            auto b = sequential.GetAsU32();
+            if (a == b)
+            { continue; }
+
+            if (mismatch < MAX_REPORT)
+            { printf("  %s n = %llu [%d] : 0x%08x != 0x%08x\n", name, (unsigned long long)n, i, a, b); }
+            mismatch++;
+            break;
+        }
+    }
+    return Report(name, sizeof(steps) / sizeof(steps[0]), mismatch);
+}
+
+//-----------------------------------------------------------------------------
+//      2つの生成器の続きの数列が一致するか比べます.
+//-----------------------------------------------------------------------------
+template<typename Generator>
+bool IsSameSequence(Generator a, Generator b)
+{
+    for(auto i=0; i<64; ++i)
+    {
+        if (a.GetAsU32() != b.GetAsU32())
+        { return false; }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      倍精度の真値に対する誤差を ULP 単位で求めます.
+//-----------------------------------------------------------------------------
+double UlpError(float value, double expect)
+{
+    // 同じ非数・無限大なら誤差なし, 片方だけなら無限大の誤差とする.
+    if (std::isnan(expect) || std::isinf(expect))
+    {
+        auto same = (std::isnan(expect) && std::isnan(value)) || (double(value) == expect);
+        return same ? 0.0 : INFINITY;
+    }
+
+    // 非正規化数は 0 として扱う仕様なので, 真値が非正規化数なら 0 への切り捨ても許し,
+    // それ以外は最小の正規化数の ULP で測る.
+    if (fabs(expect) < double(FLT_MIN) && fabsf(value) <= FLT_MIN)
+    { return 0.0; }
+
+    int exponent;
+    frexp(std::max(fabs(expect), double(FLT_MIN)), &exponent);
+    auto ulp = ldexp(1.0, exponent - 24);
+    return fabs(double(value) - expect) / ulp;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// UlpChecker class
+// スカラー版と Floatx8 版の誤差をまとめて調べます.
+///////////////////////////////////////////////////////////////////////////////
+class UlpChecker
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      誤差を検証します.
+    //!
+    //! @param[in]      name        表示名.
+    //! @param[in]      count       入力数.
+    //! @param[in]      scalar      i 番目の入力に対するスカラー版の結果を返す関数.
+    //! @param[in]      packet      i 番目から8個の入力に対する Floatx8 版の結果を返す関数.
+    //! @param[in]      expect      i 番目の入力に対する倍精度の真値を返す関数.
+    //! @param[in]      bound       i 番目の入力に対する誤差の上限(ULP)を返す関数.
+    //! @param[in]      input       i 番目の入力を返す関数(表示用).
+    //-------------------------------------------------------------------------
+    template<typename Scalar, typename Packet, typename Expect, typename Bound, typename Input>
+    bool Check(const char* name, size_t count, Scalar scalar, Packet packet, Expect expect, Bound bound, Input input)
+    {
+        double  maxScalar = 0.0;
+        double  maxPacket = 0.0;
+        size_t  failed    = 0;
+        float   worst     = 0.0f;
+
+        alignas(32) float lanes[8];
+        for(size_t i=0; i + 8 <= count; i += 8)
+        {
+            packet(i).Store(lanes);
+            for(size_t j=0; j<8; ++j)
+            {
+                auto ref   = expect(i + j);
+                auto limit = bound(i + j);
+                auto errS  = UlpError(scalar(i + j), ref);
+                auto errP  = UlpError(lanes[j], ref);
+                if (errS > maxScalar) { maxScalar = errS; worst = input(i + j); }
+                if (errP > maxPacket) { maxPacket = errP; }
+                if (errS > limit || errP > limit)
+                {
+                    if (failed++ < MAX_REPORT)
+                    { printf("  %s : x = %.9g, %.2f ULP (x8 %.2f ULP), bound %.2f ULP\n", name, double(input(i + j)), errS, errP, limit); }
+                }
+            }
+        }
+
+        printf("%-32s %10zu values  max %6.2f ULP (x8 %6.2f ULP) at %-14g %s\n",
+            name, count, maxScalar, maxPacket, double(worst), (failed == 0) ? "OK" : "NG");
+        return failed == 0;
+    }
+};
+
+//-----------------------------------------------------------------------------
+//      [lo, hi] を等間隔に区切った入力を生成します.
+//-----------------------------------------------------------------------------
+std::vector<float> Linear(float lo, float hi, size_t count)
+{
+    std::vector<float> result(count);
+    for(size_t i=0; i<count; ++i)
+    { result[i] = float(double(lo) + (double(hi) - double(lo)) * double(i) / double(count - 1)); }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      [lo, hi] のビット列を等間隔に区切った入力を生成します(指数が偏らないようにする).
+//-----------------------------------------------------------------------------
+std::vector<float> Bitwise(float lo, float hi, size_t count)
+{
+    auto a = AsBits(lo);
+    auto b = AsBits(hi);
+    std::vector<float> result(count);
+    for(size_t i=0; i<count; ++i)
+    { result[i] = AsFloat(uint32_t(a + (uint64_t(b - a) * i) / (count - 1))); }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      3次元ベクトルがビット単位で一致するかチェックします.
+//-----------------------------------------------------------------------------
+inline bool IsSameBits(const asdx::Vector3& a, const asdx::Vector3& b)
+{ return AsBits(a.x) == AsBits(b.x) && AsBits(a.y) == AsBits(b.y) && AsBits(a.z) == AsBits(b.z); }
+
+//-----------------------------------------------------------------------------
+//      2つの方向のなす角を度で求めます.
+//-----------------------------------------------------------------------------
+double AngleDegree(const asdx::Vector3& a, const asdx::Vector3& b)
+{
+    auto cx  = double(a.y) * b.z - double(a.z) * b.y;
+    auto cy  = double(a.z) * b.x - double(a.x) * b.z;
+    auto cz  = double(a.x) * b.y - double(a.y) * b.x;
+    auto dot = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z;
+    return atan2(sqrt(cx * cx + cy * cy + cz * cz), dot) * 180.0 / 3.14159265358979323846;
+}
+
+//-----------------------------------------------------------------------------
+//      八面体形式の一括処理をスカラー版と比べ, 角度誤差を調べます.
+//
+//      T       : 格納型.
+//      Encode  : スカラー版の変換関数.
+//      Decode  : スカラー版の展開関数.
+//      EncodeN : 一括変換関数.
+//      DecodeN : 一括展開関数.
+//      codes   : 展開を調べる符号の一覧.
+//      dirs    : 変換を調べる方向の一覧.
+//      bound   : 文書化した最大角度誤差(度).
+//-----------------------------------------------------------------------------
+template<typename T, typename Encode, typename Decode, typename EncodeN, typename DecodeN>
+bool CheckOct
+(
+    const char*                         name,
+    Encode                              encode,
+    Decode                              decode,
+    EncodeN                             encodeN,
+    DecodeN                             decodeN,
+    const std::vector<T>&               codes,
+    const std::vector<asdx::Vector3>&   dirs,
+    double                              bound
+)
+{
+    using namespace asdx;
+
+    auto result = true;
+    char label[64];
+
+    // 一括展開 == スカラー版展開.
+    {
+        std::vector<Vector3> bulk(codes.size());
+        decodeN(codes.data(), bulk.data(), codes.size());
+
+        size_t mismatch = 0;
+        double maxLength = 0.0;
+        for(size_t i=0; i<codes.size(); ++i)
+        {
+            auto expect = decode(codes[i]);
+            maxLength = std::max(maxLength, fabs(sqrt(double(Vector3::Dot(expect, expect))) - 1.0));
+            if (IsSameBits(expect, bulk[i]))
+            { continue; }
+
+            if (mismatch++ < MAX_REPORT)
+            {
+                printf("  %s[] : (%.9g, %.9g, %.9g) (scalar (%.9g, %.9g, %.9g))\n", name,
+                    bulk[i].x, bulk[i].y, bulk[i].z, expect.x, expect.y, expect.z);
+            }
+        }
+        snprintf(label, sizeof(label), "Decode%s[] == Decode%s", name, name);
+        result &= Report(label, codes.size(), mismatch);
+
+        // 展開結果は単位ベクトルであること.
+        if (maxLength > 1e-6)
+        {
+            printf("  Decode%s : |length - 1| = %g\n", name, maxLength);
+            result = false;
+        }
+    }
+
+    // 一括変換 == スカラー版変換.
+    std::vector<T> packed(dirs.size());
+    {
+        encodeN(dirs.data(), packed.data(), dirs.size());
+
+        size_t mismatch = 0;
+        for(size_t i=0; i<dirs.size(); ++i)
+        {
+            auto expect = encode(dirs[i]);
+            if (memcmp(&expect, &packed[i], sizeof(T)) == 0)
+            { continue; }
+
+            if (mismatch++ < MAX_REPORT)
+            { printf("  Encode%s[] : (%.9g, %.9g, %.9g)\n", name, dirs[i].x, dirs[i].y, dirs[i].z); }
+        }
+        snprintf(label, sizeof(label), "Encode%s[] == Encode%s", name, name);
+        result &= Report(label, dirs.size(), mismatch);
+    }
+
+    // 往復後の角度誤差.
+    {
+        double maxError = 0.0;
+        double sumError = 0.0;
+        for(size_t i=0; i<dirs.size(); ++i)
+        {
+            auto error = AngleDegree(dirs[i], decode(packed[i]));
+            maxError  = std::max(maxError, error);
+            sumError += error;
+        }
+
+        auto ok = (maxError <= bound);
+        printf("%-32s %10zu values  max %.5f deg, mean %.5f deg (bound %.5f deg)  %s\n",
+            name, dirs.size(), maxError, sumError / double(dirs.size()), bound, ok ? "OK" : "NG");
+        result &= ok;
+    }
+
+    return result;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      半精度の一括変換がスカラー版とビット単位で一致するか検証します.
+//-----------------------------------------------------------------------------
+bool VerifyHalf()
+{
+    using namespace asdx;
+
+    auto result = true;
+
+    // half -> float は全 65536 通りを調べる.
+    // 先頭を1要素ずらして, SIMD 部分と端数部分の両方を非整列アドレスで通す.
+    {
+        const size_t count = 0x10000;
+        std::vector<half>  values(count + 1);
+        std::vector<float> bulk  (count + 1);
+        for(size_t i=0; i<count; ++i)
+        { values[i + 1] = half(i); }
+
+        ToFloat(values.data() + 1, bulk.data() + 1, count);
+
+        size_t mismatch = 0;
+        for(size_t i=0; i<count; ++i)
+        {
+            auto expect = AsBits(ToFloat(values[i + 1]));
+            auto actual = AsBits(bulk[i + 1]);
+            if (expect == actual)
+            { continue; }
+
+            if (mismatch++ < MAX_REPORT)
+            { printf("  ToFloat[] : 0x%04x -> 0x%08x (scalar 0x%08x)\n", uint32_t(values[i + 1]), actual, expect); }
+        }
+        result &= Report("ToFloat[] == ToFloat", count, mismatch);
+    }
+
+    // float -> half は上位16bitを全て回し, 丸めに効く下位16bitは境界付近の値に絞る.
+    // 最大値と最小の非正規化数の丸め境界を末尾に足し, 要素数を 16 の倍数からずらして端数処理も通す.
+    {
+        const uint32_t lows[] = {
+            0x0000, 0x0001, 0x0fff, 0x1000, 0x1001, 0x1fff, 0x2000, 0x2001,
+            0x3fff, 0x4000, 0x5fff, 0x6000, 0x7fff, 0x8000, 0x9fff, 0xa000,
+            0xbfff, 0xc000, 0xdfff, 0xe000, 0xefff, 0xf000, 0xffff,
+        };
+        const float extras[] = {
+            65504.0f, 65519.996f, 65520.0f, 5.9604645e-8f, 2.9802322e-8f,
+        };
+        const size_t lowCount   = sizeof(lows)   / sizeof(lows[0]);
+        const size_t extraCount = sizeof(extras) / sizeof(extras[0]);
+        const size_t count      = 0x10000 * lowCount + extraCount;
+
+        std::vector<float> values(count + 1);
+        std::vector<half>  bulk  (count + 1);
+        for(size_t hi=0; hi<0x10000; ++hi)
+        {
+            for(size_t lo=0; lo<lowCount; ++lo)
+            { values[hi * lowCount + lo + 1] = AsFloat(uint32_t(hi << 16) | lows[lo]); }
+        }
+        for(size_t i=0; i<extraCount; ++i)
+        { values[0x10000 * lowCount + i + 1] = extras[i]; }
+
+        ToHalf(values.data() + 1, bulk.data() + 1, count);
+
+        size_t mismatch = 0;
+        for(size_t i=0; i<count; ++i)
+        {
+            auto expect = ToHalf(values[i + 1]);
+            auto actual = bulk[i + 1];
+            if (expect == actual)
+            { continue; }
+
+            if (mismatch++ < MAX_REPORT)
+            { printf("  ToHalf[] : 0x%08x -> 0x%04x (scalar 0x%04x)\n", AsBits(values[i + 1]), uint32_t(actual), uint32_t(expect)); }
+        }
+        result &= Report("ToHalf[] == ToHalf", count, mismatch);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      asdx::fast の誤差を倍精度 libm と比べ, 文書化した上限に収まるか検証します.
+//-----------------------------------------------------------------------------
+bool VerifyFast()
+{
+    using namespace asdx;
+
+    const size_t count = 1 << 20;
+
+    UlpChecker checker;
+    auto result = true;
+
+    auto at = [](const std::vector<float>& v)
+    { return [&v](size_t i) { return v[i]; }; };
+    auto constant = [](double value)
+    { return [value](size_t) { return value; }; };
+
+    // Exp2 : 最大 1.2 ULP.
+    {
+        auto x = Linear(-126.0f, 127.99f, count);
+        result &= checker.Check("fast::Exp2", count,
+            [&](size_t i) { return fast::Exp2(x[i]); },
+            [&](size_t i) { return fast::Exp2(Floatx8::Load(x.data() + i)); },
+            [&](size_t i) { return exp2(double(x[i])); },
+            constant(1.2), at(x));
+    }
+
+    // Log2 : 最大 1.4 ULP. 正規化数全体を指数ごとに均等に調べる.
+    {
+        auto x = Bitwise(FLT_MIN, FLT_MAX, count);
+        result &= checker.Check("fast::Log2", count,
+            [&](size_t i) { return fast::Log2(x[i]); },
+            [&](size_t i) { return fast::Log2(Floatx8::Load(x.data() + i)); },
+            [&](size_t i) { return log2(double(x[i])); },
+            constant(1.4), at(x));
+    }
+
+    // Pow : 最大 (2 + 1.4 * |y * log2(x)|) ULP. sRGB の OETF(1/2.4) と逆変換(2.2)で調べる.
+    {
+        const float exponents[] = { 1.0f / 2.4f, 2.2f };
+        const char* names    [] = { "fast::Pow(y = 1/2.4)", "fast::Pow(y = 2.2)" };
+
+        auto x = Bitwise(FLT_MIN, 1.0f, count);
+        for(auto k=0; k<2; ++k)
+        {
+            auto y  = exponents[k];
+            auto yx = Floatx8::Set1(y);
+            result &= checker.Check(names[k], count,
+                [&](size_t i) { return fast::Pow(x[i], y); },
+                [&](size_t i) { return fast::Pow(Floatx8::Load(x.data() + i), yx); },
+                [&](size_t i) { return pow(double(x[i]), double(y)); },
+                [&](size_t i) { return 2.0 + 1.4 * fabs(double(y) * log2(double(x[i]))); },
+                at(x));
+        }
+
+        // SavePNG() の OETF が使う範囲は 3 ULP 以下.
+        auto oetf = Linear(0.0031308f, 1.0f, count);
+        auto y    = 1.0f / 2.4f;
+        auto yx   = Floatx8::Set1(y);
+        result &= checker.Check("fast::Pow(sRGB OETF)", count,
+            [&](size_t i) { return fast::Pow(oetf[i], y); },
+            [&](size_t i) { return fast::Pow(Floatx8::Load(oetf.data() + i), yx); },
+            [&](size_t i) { return pow(double(oetf[i]), double(y)); },
+            constant(3.0), at(oetf));
+    }
+
+    // SinCos : |x| <= π で最大 1.6 ULP.
+    {
+        auto x = Linear(-F_PI, F_PI, count);
+        result &= checker.Check("fast::SinCos(sin)", count,
+            [&](size_t i) { float s, c; fast::SinCos(x[i], s, c); return s; },
+            [&](size_t i) { Floatx8 s, c; fast::SinCos(Floatx8::Load(x.data() + i), s, c); return s; },
+            [&](size_t i) { return sin(double(x[i])); },
+            constant(1.6), at(x));
+        result &= checker.Check("fast::SinCos(cos)", count,
+            [&](size_t i) { float s, c; fast::SinCos(x[i], s, c); return c; },
+            [&](size_t i) { Floatx8 s, c; fast::SinCos(Floatx8::Load(x.data() + i), s, c); return c; },
+            [&](size_t i) { return cos(double(x[i])); },
+            constant(1.6), at(x));
+    }
+
+    // Acos : 最大 1.3 ULP.
+    {
+        auto x = Linear(-1.0f, 1.0f, count);
+        result &= checker.Check("fast::Acos", count,
+            [&](size_t i) { return fast::Acos(x[i]); },
+            [&](size_t i) { return fast::Acos(Floatx8::Load(x.data() + i)); },
+            [&](size_t i) { return acos(double(x[i])); },
+            constant(1.3), at(x));
+    }
+
+    // Atan2 : 最大 3.1 ULP. 全象限と大小の比を混ぜる.
+    {
+        std::vector<float> y(count), x(count);
+        XorShift rng(123);
+        for(size_t i=0; i<count; ++i)
+        {
+            auto scale = exp2f(rng.GetAsF32(-20.0f, 20.0f));
+            y[i] = rng.GetAsF32(-1.0f, 1.0f) * scale;
+            x[i] = rng.GetAsF32(-1.0f, 1.0f);
+        }
+        result &= checker.Check("fast::Atan2", count,
+            [&](size_t i) { return fast::Atan2(y[i], x[i]); },
+            [&](size_t i) { return fast::Atan2(Floatx8::Load(y.data() + i), Floatx8::Load(x.data() + i)); },
+            [&](size_t i) { return atan2(double(y[i]), double(x[i])); },
+            constant(3.1), at(y));
+    }
+
+    // Erf : 最大 1.4 ULP.
+    {
+        auto x = Linear(-4.0f, 4.0f, count);
+        result &= checker.Check("fast::Erf", count,
+            [&](size_t i) { return fast::Erf(x[i]); },
+            [&](size_t i) { return fast::Erf(Floatx8::Load(x.data() + i)); },
+            [&](size_t i) { return erf(double(x[i])); },
+            constant(1.4), at(x));
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      八面体形式の一括処理とスカラー版の一致, および角度誤差を検証します.
+//-----------------------------------------------------------------------------
+bool VerifyOct()
+{
+    using namespace asdx;
+
+    // 球面上に一様な方向と, 軸や八面体の稜線上の方向を混ぜる.
+    // 端数処理も通るよう, 個数は 4 の倍数からずらしておく.
+    std::vector<Vector3> dirs;
+    {
+        const float edges[] = { -1.0f, -0.5f, 0.0f, 0.5f, 1.0f };
+        for(auto x : edges)
+        {
+            for(auto y : edges)
+            {
+                for(auto z : edges)
+                {
+                    if (x != 0.0f || y != 0.0f || z != 0.0f)
+                    { dirs.push_back(Vector3::Normalize(Vector3(x, y, z))); }
+                }
+            }
+        }
+
+        XorShift rng(321);
+        for(auto i=0; i<(1 << 20); ++i)
+        {
+            auto z   = rng.GetAsF32(-1.0f, 1.0f);
+            auto phi = rng.GetAsF32(0.0f, F_2PI);
+            auto r   = sqrtf(std::max(1.0f - z * z, 0.0f));
+            dirs.push_back(Vector3(r * cosf(phi), r * sinf(phi), z));
+        }
+    }
+
+    auto result = true;
+
+    // 16bit : 全 65536 通りを展開する.
+    {
+        std::vector<uint16_t> codes(0x10000);
+        for(size_t i=0; i<codes.size(); ++i)
+        { codes[i] = uint16_t(i); }
+
+        result &= CheckOct<uint16_t>("Oct16",
+            [](const Vector3& v) { return EncodeOct16(v); },
+            [](uint16_t c) { return DecodeOct16(c); },
+            [](const Vector3* v, uint16_t* r, size_t n) { EncodeOct16(v, r, n); },
+            [](const uint16_t* c, Vector3* r, size_t n) { DecodeOct16(c, r, n); },
+            codes, dirs, 0.96);
+    }
+
+    // 24bit : 全 2^24 通りを展開する. 要素数を 4 の倍数からずらして端数処理も通す.
+    {
+        std::vector<Oct24> codes((1u << 24) + 3);
+        for(uint32_t i=0; i<codes.size(); ++i)
+        {
+            auto c = i & 0xFFFFFF;
+            codes[i].bytes[0] = uint8_t(c);
+            codes[i].bytes[1] = uint8_t(c >> 8);
+            codes[i].bytes[2] = uint8_t(c >> 16);
+        }
+
+        result &= CheckOct<Oct24>("Oct24",
+            [](const Vector3& v) { return EncodeOct24(v); },
+            [](const Oct24& c) { return DecodeOct24(c); },
+            [](const Vector3* v, Oct24* r, size_t n) { EncodeOct24(v, r, n); },
+            [](const Oct24* c, Vector3* r, size_t n) { DecodeOct24(c, r, n); },
+            codes, dirs, 0.059);
+    }
+
+    // 32bit : 符号は乱数で 4M 通りに絞る.
+    {
+        std::vector<uint32_t> codes((1u << 22) + 1);
+        XorShift rng(654);
+        for(size_t i=0; i<codes.size(); ++i)
+        { codes[i] = rng.GetAsU32(); }
+
+        result &= CheckOct<uint32_t>("Oct32",
+            [](const Vector3& v) { return EncodeOct32(v); },
+            [](uint32_t c) { return DecodeOct32(c); },
+            [](const Vector3* v, uint32_t* r, size_t n) { EncodeOct32(v, r, n); },
+            [](const uint32_t* c, Vector3* r, size_t n) { DecodeOct32(c, r, n); },
+            codes, dirs, 0.0037);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      asdxMathTable.h の表を検証します.
+//-----------------------------------------------------------------------------
+bool VerifyTable()
+{
+    using namespace asdx;
+
+    auto result = true;
+
+    // 表は constexpr 関数をコンパイル時に展開したものなので, 実行時の値と完全に一致する.
+    result &= CheckSamples("Table HAMMERSLEY_16",  HAMMERSLEY_16,  [](uint32_t i) { return Hammersley(i, 16); });
+    result &= CheckSamples("Table HAMMERSLEY_64",  HAMMERSLEY_64,  [](uint32_t i) { return Hammersley(i, 64); });
+    result &= CheckSamples("Table HAMMERSLEY_256", HAMMERSLEY_256, [](uint32_t i) { return Hammersley(i, 256); });
+    result &= CheckSamples("Table HALTON23_64",    HALTON23_64,    [](uint32_t i) { return Halton23(i + 1); });
+    result &= CheckSamples("Table HALTON23_256",   HALTON23_256,   [](uint32_t i) { return Halton23(i + 1); });
+    result &= CheckSamples("Table R2_64",          R2_64,          [](uint32_t i) { return R2(i); });
+    result &= CheckSamples("Table R2_256",         R2_256,         [](uint32_t i) { return R2(i); });
+
+    // 係数の丸め(有効数字 7 桁)が積み重なった分だけ許容する.
+    result &= CheckInverse("Table SRGB <-> XYZ",      SRGB_TO_XYZ,      XYZ_TO_SRGB,      2e-6);
+    result &= CheckInverse("Table SRGB <-> ACES2065", SRGB_TO_ACES2065, ACES2065_TO_SRGB, 2e-6);
+    result &= CheckInverse("Table SRGB <-> ACESCG",   SRGB_TO_ACESCG,   ACESCG_TO_SRGB,   2e-6);
+
+    // sRGB の白は XYZ では D65 (xy = 0.3127, 0.3290), ACES では順応後の (1, 1, 1) になる.
+    result &= CheckWhite("Table SRGB_TO_XYZ white",      SRGB_TO_XYZ,      Vector3(0.3127f / 0.3290f, 1.0f, 0.3583f / 0.3290f), 1e-5f);
+    result &= CheckWhite("Table SRGB_TO_ACES2065 white", SRGB_TO_ACES2065, Vector3(1.0f, 1.0f, 1.0f), 1e-5f);
+    result &= CheckWhite("Table SRGB_TO_ACESCG white",   SRGB_TO_ACESCG,   Vector3(1.0f, 1.0f, 1.0f), 1e-5f);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      乱数生成器を検証します.
+//-----------------------------------------------------------------------------
+bool VerifyRandom()
+{
+    using namespace asdx;
+
+    auto result = true;
+
+    // 種から生成した 8 レーンと, ストリームや飛ばしを混ぜた状態から複製した 8 レーン.
+    {
+        const int seeds[8] = { 0, 1, 2, 3, 12345, -1, 0x7FFFFFFF, 42 };
+        XorShift advanced[8] = {
+            XorShift(7), XorShift(7, 1), XorShift(7, 2), XorShift(8, 1000),
+            XorShift(9), XorShift(10),   XorShift(11),   XorShift(12, 3) };
+        for(auto i=0; i<8; ++i)
+        { advanced[i].Advance(uint64_t(i) * 977); }
+
+        result &= CheckRandomLanes<XorShift, XorShiftx8>("XorShiftx8(seeds) == XorShift",   seeds,    100000);
+        result &= CheckRandomLanes<XorShift, XorShiftx8>("XorShiftx8(streams) == XorShift", advanced, 100000);
+    }
+    {
+        const uint64_t seeds[8] = { 0, 1, 2, 3, 12345, ~0ull, 0x853C49E6748FEA9Bull, 42 };
+        PCG advanced[8] = {
+            PCG(7), PCG(7, 1), PCG(7, 2), PCG(8, 1000),
+            PCG(9), PCG(10, ~0ull), PCG(11), PCG(12, 3) };
+        for(auto i=0; i<8; ++i)
+        { advanced[i].Advance(uint64_t(i) * 977); }
+
+        result &= CheckRandomLanes<PCG,      PCGx8>("PCGx8(seeds) == PCG",   seeds,    100000);
+        result &= CheckRandomLanes<PCG,      PCGx8>("PCGx8(streams) == PCG", advanced, 100000);
+    }
+
+    // Advance(n) と n 回の逐次生成.
+    result &= CheckAdvance("XorShift::Advance == steps",        XorShift(123));
+    result &= CheckAdvance("XorShift::Advance == steps (id 5)", XorShift(123, 5));
+    result &= CheckAdvance("PCG::Advance == steps",             PCG(123));
+    result &= CheckAdvance("PCG::Advance == steps (id 5)",      PCG(123, 5));
+
+    // 逐次生成では届かない距離は, 飛ばし同士の関係で確かめる.
+    {
+        size_t mismatch = 0;
+
+        // Jump() は 2^64 個先.
+        XorShift jumped(123);
+        jumped.Jump();
+
+        XorShift halves(123);
+        halves.Advance(1ull << 63);
+        halves.Advance(1ull << 63);
+        mismatch += IsSameSequence(jumped, halves) ? 0 : 1;
+
+        // ストリーム番号 k は Jump() を k 回呼んだ状態.
+        XorShift stream(123);
+        for(uint64_t k=1; k<=4; ++k)
+        {
+            stream.Jump();
+            mismatch += IsSameSequence(XorShift(123, k), stream) ? 0 : 1;
+        }
+
+        result &= Report("XorShift::Jump == Advance x2", 5, mismatch);
+    }
+    {
+        size_t mismatch = 0;
+
+        // PCG の周期は 2^64 なので, 2^64 - 1 個先の次は元に戻る.
+        for(uint64_t id=0; id<4; ++id)
+        {
+            PCG origin(123, id);
+            PCG wrapped = origin;
+            wrapped.Advance(~0ull);
+            wrapped.GetAsU32();
+            mismatch += IsSameSequence(origin, wrapped) ? 0 : 1;
+        }
+
+        result &= Report("PCG::Advance(2^64) == identity", 4, mismatch);
+    }
+
+    return result;
+}
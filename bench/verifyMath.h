@@ -0,0 +1,47 @@
+﻿//-----------------------------------------------------------------------------
+// File : verifyMath.h
+// Desc : Verification for asdxMath.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+
+//-----------------------------------------------------------------------------
+//! @brief      半精度の一括変換がスカラー版とビット単位で一致するか検証します.
+//!
+//! @retval true    全て一致.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyHalf();
+
+//-----------------------------------------------------------------------------
+//! @brief      asdx::fast の誤差を倍精度 libm と比べ, 文書化した上限に収まるか検証します.
+//!
+//! @retval true    全て上限以内.
+//! @retval false   上限を超えた値あり.
+//-----------------------------------------------------------------------------
+bool VerifyFast();
+
+//-----------------------------------------------------------------------------
+//! @brief      八面体形式の一括処理とスカラー版の一致, および角度誤差を検証します.
+//!
+//! @retval true    全て一致し, 誤差も文書化した上限以内.
+//! @retval false   不一致または上限を超えた値あり.
+//-----------------------------------------------------------------------------
+bool VerifyOct();
+
+//-----------------------------------------------------------------------------
+//! @brief      asdxMathTable.h の表が実行時の計算結果と一致するか検証します.
+//!
+//! @retval true    サンプル列はビット単位で一致し, 色変換行列も許容誤差以内.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyTable();
+
+//-----------------------------------------------------------------------------
+//! @brief      8レーンの乱数生成器と飛ばし処理をスカラー版と比べて検証します.
+//!
+//! @retval true    各レーンがスカラー版の数列とビット単位で一致し, Advance() も逐次生成と一致.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyRandom();
@@ -0,0 +1,1911 @@
+﻿//-----------------------------------------------------------------------------
+// File : verifyScene.cpp
+// Desc : Verification for scene components.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <thread>
+#include <asdxMath.h>
+#include <bvh.h>
+#include <mesh.h>
+#include <attribute.h>
+#include <sceneCache.h>
+#include <meshDedup.h>
+#include <tessCache.h>
+#include <curve.h>
+#include <alphaMask.h>
+#include "verifyScene.h"
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t MAX_REPORT    = 8;       //!< 不一致を表示する最大件数.
+constexpr float    T_TOLERANCE   = 1e-4f;   //!< 交差距離の許容誤差(距離に対する比).
+constexpr float    UV_TOLERANCE  = 1e-3f;   //!< 重心座標の許容誤差(インスタンスは逆変換したレイで判定するので, 浅い角度では誤差が増える).
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Triangles structure
+///////////////////////////////////////////////////////////////////////////////
+struct Triangles
+{
+    std::vector<asdx::Vector3>  Vertices;   //!< 頂点座標です.
+    std::vector<uint32_t>       Indices;    //!< インデックスです(三角形あたり3個).
+    std::vector<uint32_t>       InstIDs;    //!< 三角形ごとの期待するインスタンス番号です(空なら BVH::INVALID_ID).
+    std::vector<uint32_t>       PrimIDs;    //!< 三角形ごとの期待するプリミティブ番号です(空なら三角形の番号).
+    std::vector<asdx::Vector2>  Params;     //!< 頂点ごとの期待する (U, V) です(空なら重心座標).
+
+    //-------------------------------------------------------------------------
+    //! @brief      三角形数を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetCount() const
+    { return uint32_t(Indices.size() / 3); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ReferenceHit structure
+///////////////////////////////////////////////////////////////////////////////
+struct ReferenceHit
+{
+    bool        Hit;        //!< 交差したかどうか.
+    float       T;          //!< 交差距離です.
+    float       U;          //!< 重心座標(頂点1の重み)です.
+    float       V;          //!< 重心座標(頂点2の重み)です.
+    uint32_t    PrimID;     //!< 三角形番号です.
+    uint32_t    InstID;     //!< インスタンス番号です.
+};
+
+//-----------------------------------------------------------------------------
+//      検証結果を表示します.
+//-----------------------------------------------------------------------------
+bool Report(const char* name, size_t count, size_t mismatch)
+{
+    printf("%-32s %10zu values  %8zu mismatches  %s\n",
+        name, count, mismatch, (mismatch == 0) ? "OK" : "NG");
+    return mismatch == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Checker class
+// 条件ごとの検証結果を数えます.
+///////////////////////////////////////////////////////////////////////////////
+class Checker
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    explicit Checker(const char* name)
+    : m_pName(name)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      条件を検証します.
+    //-------------------------------------------------------------------------
+    bool Check(bool ok, const char* what)
+    {
+        m_Total++;
+        if (ok)
+        { return true; }
+
+        if (m_Mismatch < MAX_REPORT)
+        { printf("  %s : %s\n", m_pName, what); }
+        m_Mismatch++;
+        return false;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      検証結果を表示します.
+    //-------------------------------------------------------------------------
+    bool Report() const;
+
+private:
+    const char* m_pName;
+    size_t      m_Total     = 0;
+    size_t      m_Mismatch  = 0;
+};
+
+//-----------------------------------------------------------------------------
+//      検証結果を表示します.
+//-----------------------------------------------------------------------------
+bool Checker::Report() const
+{ return ::Report(m_pName, m_Total, m_Mismatch); }
+
+//-----------------------------------------------------------------------------
+//      [-1, 1]^3 に小さな三角形を散らし, 座標軸に揃った大きな四角形を加えます.
+//-----------------------------------------------------------------------------
+void MakeTriangles(uint64_t seed, uint32_t count, Triangles& result)
+{
+    asdx::PCG rng(seed);
+
+    result.Vertices.clear();
+    result.Indices .clear();
+    for(uint32_t i=0; i<count; ++i)
+    {
+        auto center = asdx::Vector3(rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f));
+        for(auto j=0; j<3; ++j)
+        {
+            auto offset = asdx::Vector3(rng.GetAsF32(-0.1f, 0.1f), rng.GetAsF32(-0.1f, 0.1f), rng.GetAsF32(-0.1f, 0.1f));
+            result.Indices .push_back(uint32_t(result.Vertices.size()));
+            result.Vertices.push_back(center + offset);
+        }
+    }
+
+    // 方向の成分が 0 のレイで, 量子化した境界の判定が面に張り付いた場合を通す.
+    const float planes[] = { -0.5f, 0.0f, 0.5f };
+    for(auto axis=0; axis<3; ++axis)
+    {
+        for(auto d : planes)
+        {
+            auto base = uint32_t(result.Vertices.size());
+            for(auto k=0; k<4; ++k)
+            {
+                float p[3];
+                p[axis]           = d;
+                p[(axis + 1) % 3] = (k & 1) ? 0.8f : -0.8f;
+                p[(axis + 2) % 3] = (k & 2) ? 0.8f : -0.8f;
+                result.Vertices.push_back(asdx::Vector3(p[0], p[1], p[2]));
+            }
+            const uint32_t quad[] = { 0, 1, 3, 0, 3, 2 };
+            for(auto index : quad)
+            { result.Indices.push_back(base + index); }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      検証用のレイを生成します.
+//-----------------------------------------------------------------------------
+void MakeRays(uint64_t seed, uint32_t count, std::vector<asdx::Ray>& result)
+{
+    asdx::PCG rng(seed);
+
+    auto point = [&](float extent)
+    { return asdx::Vector3(rng.GetAsF32(-extent, extent), rng.GetAsF32(-extent, extent), rng.GetAsF32(-extent, extent)); };
+
+    result.clear();
+    for(uint32_t i=0; i<count; ++i)
+    {
+        switch(i % 4)
+        {
+        // 外側から内側の点に向かうレイ.
+        case 0:
+            {
+                auto pos = point(3.0f);
+                result.push_back(asdx::Ray(pos, point(1.0f) - pos));
+            }
+            break;
+
+        // 内側から任意の方向に向かうレイ.
+        case 1:
+            result.push_back(asdx::Ray(point(1.0f), point(1.0f)));
+            break;
+
+        // 座標軸に平行なレイ(方向の成分が2つ 0).
+        case 2:
+            {
+                auto pos  = point(1.0f);
+                auto axis = (i / 4) % 3;
+                auto sign = ((i / 12) & 1) ? 1.0f : -1.0f;
+                float d[3] = { 0.0f, 0.0f, 0.0f };
+                float p[3] = { pos.x, pos.y, pos.z };
+                d[axis] = sign;
+                p[axis] = -2.0f * sign;
+                result.push_back(asdx::Ray(asdx::Vector3(p[0], p[1], p[2]), asdx::Vector3(d[0], d[1], d[2])));
+            }
+            break;
+
+        // 区間を制限したレイ.
+        case 3:
+            {
+                auto pos = point(3.0f);
+                auto dir = point(1.0f) - pos;
+                result.push_back(asdx::Ray(pos, dir, rng.GetAsF32(0.0f, 0.5f), rng.GetAsF32(0.5f, 1.5f)));
+            }
+            break;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      全三角形と判定して最近傍の交差を求めます.
+//-----------------------------------------------------------------------------
+ReferenceHit BruteForce(const Triangles& tris, const asdx::Ray& ray)
+{
+    ReferenceHit result = {};
+    auto test = ray;
+    for(uint32_t i=0; i<tris.GetCount(); ++i)
+    {
+        float t, u, v;
+        if (!asdx::IntersectRayTriangleWatertight(test,
+            tris.Vertices[tris.Indices[i * 3 + 0]],
+            tris.Vertices[tris.Indices[i * 3 + 1]],
+            tris.Vertices[tris.Indices[i * 3 + 2]], t, u, v))
+        { continue; }
+
+        if (result.Hit && t >= result.T)
+        { continue; }
+
+        result.Hit    = true;
+        result.T      = t;
+        result.U      = u;
+        result.V      = v;
+        if (!tris.Params.empty())
+        {
+            // 頂点のパラメータを重心座標で補間したものが返る.
+            const auto& p0 = tris.Params[tris.Indices[i * 3 + 0]];
+            const auto& p1 = tris.Params[tris.Indices[i * 3 + 1]];
+            const auto& p2 = tris.Params[tris.Indices[i * 3 + 2]];
+            result.U = p0.x * (1.0f - u - v) + p1.x * u + p2.x * v;
+            result.V = p0.y * (1.0f - u - v) + p1.y * u + p2.y * v;
+        }
+        result.PrimID = tris.PrimIDs.empty() ? i : tris.PrimIDs[i];
+        result.InstID = tris.InstIDs.empty() ? BVH::INVALID_ID : tris.InstIDs[i];
+        test.tmax     = t;
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      交差結果が総当たりの結果と一致するかチェックします.
+//-----------------------------------------------------------------------------
+bool IsSameHit(const ReferenceHit& expect, bool hit, float t, const BVHHit& actual)
+{
+    if (expect.Hit != hit)
+    { return false; }
+    if (!hit)
+    { return true; }
+
+    if (fabsf(t - expect.T) > T_TOLERANCE * std::max(1.0f, expect.T))
+    { return false; }
+
+    // 同じ距離で重なった三角形はどちらを返しても正しい.
+    if (actual.PrimID != expect.PrimID || actual.InstID != expect.InstID)
+    { return t == expect.T; }
+
+    return fabsf(actual.U - expect.U) <= UV_TOLERANCE
+        && fabsf(actual.V - expect.V) <= UV_TOLERANCE;
+}
+
+//-----------------------------------------------------------------------------
+//      BVH の交差判定を総当たりの結果と比べます.
+//-----------------------------------------------------------------------------
+template<typename Scene>
+bool CheckClosestHit(const char* name, const Scene& bvh, const Triangles& tris, const std::vector<asdx::Ray>& rays, float time = 0.0f)
+{
+    size_t mismatch = 0;
+    for(size_t i=0; i<rays.size(); ++i)
+    {
+        auto expect = BruteForce(tris, rays[i]);
+
+        auto   ray = rays[i];
+        BVHHit hit = {};
+        auto   result   = bvh.Intersect(ray, hit, time);
+        auto   occluded = bvh.Occluded(rays[i], time);
+        if (IsSameHit(expect, result, ray.tmax, hit) && occluded == expect.Hit)
+        { continue; }
+
+        if (mismatch < MAX_REPORT)
+        {
+            printf("  %s ray %zu : hit %d t %.7g inst %u prim %u occluded %d (expect hit %d t %.7g inst %u prim %u)\n",
+                name, i, int(result), ray.tmax, hit.InstID, hit.PrimID, int(occluded),
+                int(expect.Hit), expect.T, expect.InstID, expect.PrimID);
+        }
+        mismatch++;
+    }
+    return Report(name, rays.size(), mismatch);
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルに書き出します.
+//-----------------------------------------------------------------------------
+bool WriteFile(const char* path, const void* data, size_t size)
+{
+    auto fp = fopen(path, "wb");
+    if (fp == nullptr)
+    {
+        printf("  Error : fopen() Failed. path = %s\n", path);
+        return false;
+    }
+
+    auto ret = fwrite(data, 1, size, fp) == size;
+    fclose(fp);
+    return ret;
+}
+
+//-----------------------------------------------------------------------------
+//      インスタンスの三角形をワールド空間に変換して追加します.
+//-----------------------------------------------------------------------------
+void AppendInstance(const Triangles& proto, const asdx::Matrix& transform, uint32_t id, Triangles& result)
+{
+    auto base = uint32_t(result.Vertices.size());
+    for(auto& v : proto.Vertices)
+    { result.Vertices.push_back(asdx::Vector3::Transform(v, transform)); }
+    for(uint32_t i=0; i<proto.GetCount(); ++i)
+    {
+        for(auto k=0; k<3; ++k)
+        { result.Indices.push_back(base + proto.Indices[i * 3 + k]); }
+        result.InstIDs.push_back(id);
+        result.PrimIDs.push_back(i);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ランダムな回転, 拡縮, 平行移動を持つ変換行列を生成します.
+//-----------------------------------------------------------------------------
+asdx::Matrix MakeTransform(asdx::PCG& rng)
+{
+    auto axis  = asdx::Vector3::Normalize(asdx::Vector3(rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(0.1f, 1.0f)));
+    auto scale = asdx::Matrix::CreateScale(rng.GetAsF32(0.2f, 0.5f), rng.GetAsF32(0.2f, 0.5f), rng.GetAsF32(0.2f, 0.5f));
+    auto rot   = asdx::Matrix::CreateFromAxisAngle(axis, rng.GetAsF32(-3.0f, 3.0f));
+    auto trans = asdx::Matrix::CreateTranslation(rng.GetAsF32(-0.8f, 0.8f), rng.GetAsF32(-0.8f, 0.8f), rng.GetAsF32(-0.8f, 0.8f));
+    return scale * rot * trans;
+}
+
+//-----------------------------------------------------------------------------
+//      三角形をメッシュに複製します.
+//-----------------------------------------------------------------------------
+bool ToMesh(const Triangles& tris, Mesh& mesh)
+{
+    if (!mesh.Positions.Resize(tris.Vertices.size()) || !mesh.Indices.Resize(tris.Indices.size()))
+    { return false; }
+
+    std::copy(tris.Vertices.begin(), tris.Vertices.end(), mesh.Positions.GetData());
+    std::copy(tris.Indices .begin(), tris.Indices .end(), mesh.Indices  .GetData());
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      三角形を OBJ 形式の文字列にします.
+//-----------------------------------------------------------------------------
+std::string ToObj(const Triangles& tris)
+{
+    // 9 桁あれば float に誤差なく戻る.
+    std::string text;
+    char line[128];
+    for(auto& v : tris.Vertices)
+    {
+        snprintf(line, sizeof(line), "v %.9g %.9g %.9g\n", v.x, v.y, v.z);
+        text += line;
+    }
+    for(size_t i=0; i<tris.Indices.size(); i+=3)
+    {
+        snprintf(line, sizeof(line), "f %u %u %u\n", tris.Indices[i + 0] + 1, tris.Indices[i + 1] + 1, tris.Indices[i + 2] + 1);
+        text += line;
+    }
+    return text;
+}
+
+//-----------------------------------------------------------------------------
+//      格子状の四角形メッシュを生成します.
+//-----------------------------------------------------------------------------
+void MakeGrid(uint32_t size, Triangles& result)
+{
+    result.Vertices.clear();
+    result.Indices .clear();
+
+    // 0.25 刻みなら10進数の文字列から誤差なく戻る.
+    for(uint32_t y=0; y<=size; ++y)
+    {
+        for(uint32_t x=0; x<=size; ++x)
+        { result.Vertices.push_back(asdx::Vector3(float(x) * 0.25f, float(y) * 0.25f, 0.0f)); }
+    }
+
+    for(uint32_t y=0; y<size; ++y)
+    {
+        for(uint32_t x=0; x<size; ++x)
+        {
+            auto a = y * (size + 1) + x;
+            const uint32_t quad[] = { a, a + 1, a + size + 2, a, a + size + 2, a + size + 1 };
+            result.Indices.insert(result.Indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      読み込んだメッシュが期待する頂点とインデックスに一致するかチェックします.
+//-----------------------------------------------------------------------------
+size_t CompareMesh(const char* name, const Mesh& mesh, const Triangles& expect)
+{
+    if (mesh.GetVertexCount() != expect.Vertices.size() || mesh.GetTriangleCount() != expect.GetCount())
+    {
+        printf("  %s : %u vertices %u triangles (expect %zu vertices %u triangles)\n",
+            name, mesh.GetVertexCount(), mesh.GetTriangleCount(), expect.Vertices.size(), expect.GetCount());
+        return 1;
+    }
+
+    size_t mismatch = 0;
+    for(uint32_t i=0; i<mesh.GetVertexCount(); ++i)
+    {
+        auto& p = mesh.Positions[i];
+        auto& q = expect.Vertices[i];
+        if (p.x == q.x && p.y == q.y && p.z == q.z)
+        { continue; }
+
+        if (mismatch < MAX_REPORT)
+        { printf("  %s vertex %u : (%.9g, %.9g, %.9g) != (%.9g, %.9g, %.9g)\n", name, i, p.x, p.y, p.z, q.x, q.y, q.z); }
+        mismatch++;
+    }
+    for(size_t i=0; i<expect.Indices.size(); ++i)
+    {
+        if (mesh.Indices[i] == expect.Indices[i])
+        { continue; }
+
+        if (mismatch < MAX_REPORT)
+        { printf("  %s index %zu : %u != %u\n", name, i, mesh.Indices[i], expect.Indices[i]); }
+        mismatch++;
+    }
+
+    // Embree と共有するので, 読み込み結果も共有できる配置になっている.
+    if (uintptr_t(mesh.Positions.GetData()) % AlignedArray<asdx::Vector3>::ALIGNMENT != 0
+     || uintptr_t(mesh.Indices  .GetData()) % AlignedArray<uint32_t>     ::ALIGNMENT != 0)
+    {
+        printf("  %s : buffers are not aligned\n", name);
+        mismatch++;
+    }
+    return mismatch;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルに書き出して読み込み, 期待するメッシュと比べます.
+//-----------------------------------------------------------------------------
+bool CheckLoad(const char* name, const char* path, const std::string& text, const Triangles& expect)
+{
+    auto result = WriteFile(path, text.data(), text.size());
+
+    // チャンクの分け方が変わっても同じ結果になる.
+    size_t mismatch = 0;
+    for(auto threadCount : { 1u, 4u })
+    {
+        Mesh mesh;
+        if (!result || !LoadMesh(path, mesh, threadCount))
+        {
+            printf("  %s : LoadMesh() failed (%u threads)\n", name, threadCount);
+            mismatch++;
+            continue;
+        }
+        mismatch += CompareMesh(name, mesh, expect);
+    }
+
+    remove(path);
+    return Report(name, expect.Vertices.size() + expect.Indices.size(), mismatch);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// WavePatches class
+// [-1, 1]^2 を 8x8 に分けた, 波打つ高さを持つパッチ群です.
+///////////////////////////////////////////////////////////////////////////////
+class WavePatches : public PatchSource
+{
+public:
+    static constexpr uint32_t GRID = 8;     //!< 縦横のパッチ数です.
+    static constexpr uint32_t DIV  = 8;     //!< パッチの縦横の分割数です.
+
+    uint32_t GetPatchCount() const override
+    { return GRID * GRID; }
+
+    asdx::AABB GetPatchBounds(uint32_t patch) const override
+    {
+        auto x = -1.0f + 2.0f * float(patch % GRID) / float(GRID);
+        auto y = -1.0f + 2.0f * float(patch / GRID) / float(GRID);
+        auto w = 2.0f / float(GRID);
+        return asdx::AABB(asdx::Vector3(x, y, -0.1f), asdx::Vector3(x + w, y + w, 0.1f));
+    }
+
+    bool Tessellate(uint32_t patch, PatchMesh& result) const override
+    {
+        auto box = GetPatchBounds(patch);
+        for(uint32_t j=0; j<=DIV; ++j)
+        {
+            for(uint32_t i=0; i<=DIV; ++i)
+            {
+                auto s = float(i) / float(DIV);
+                auto t = float(j) / float(DIV);
+                auto x = box.mini.x + (box.maxi.x - box.mini.x) * s;
+                auto y = box.mini.y + (box.maxi.y - box.mini.y) * t;
+                result.Positions.push_back(asdx::Vector3(x, y, 0.1f * sinf(5.0f * x) * cosf(5.0f * y)));
+                result.Params   .push_back(asdx::Vector2(s, t));
+            }
+        }
+        for(uint32_t j=0; j<DIV; ++j)
+        {
+            for(uint32_t i=0; i<DIV; ++i)
+            {
+                auto a = j * (DIV + 1) + i;
+                const uint32_t quad[] = { a, a + 1, a + DIV + 2, a, a + DIV + 2, a + DIV + 1 };
+                result.Indices.insert(result.Indices.end(), quad, quad + 6);
+            }
+        }
+        return true;
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PatchScene structure
+// パッチの境界のBVHとキャッシュを組にして, BVH と同じ呼び出し方にしたものです.
+///////////////////////////////////////////////////////////////////////////////
+struct PatchScene
+{
+    BoxBVH              Bvh;
+    TessellationCache*  pCache;
+    uint32_t            Group;
+
+    bool Intersect(asdx::Ray& ray, BVHHit& hit, float) const
+    {
+        return Bvh.Intersect(ray, hit, [](void* userPtr, uint32_t primID, asdx::Ray& ray, BVHHit& hit)
+        {
+            auto scene = static_cast<const PatchScene*>(userPtr);
+            return scene->pCache->Intersect(scene->Group, primID, ray, hit);
+        }, const_cast<PatchScene*>(this));
+    }
+
+    bool Occluded(const asdx::Ray& ray, float) const
+    {
+        return Bvh.Occluded(ray, [](void* userPtr, uint32_t primID, const asdx::Ray& ray)
+        {
+            auto scene = static_cast<const PatchScene*>(userPtr);
+            return scene->pCache->Occluded(scene->Group, primID, ray);
+        }, const_cast<PatchScene*>(this));
+    }
+};
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      組み込みBVHの最近傍交差と遮蔽判定を総当たりの結果と比べて検証します.
+//-----------------------------------------------------------------------------
+bool VerifyBVH()
+{
+    Triangles tris;
+    MakeTriangles(1, 4096, tris);
+
+    std::vector<asdx::Ray> rays;
+    MakeRays(2, 8192, rays);
+
+    auto result = true;
+
+    // 単一スレッドと並列で分割が変わっても結果は同じになる.
+    {
+        BVH bvh;
+        bvh.AddTriangles(tris.Vertices.data(), tris.Indices.data(), tris.GetCount());
+        result &= bvh.Build(1);
+        result &= CheckClosestHit("BVH::Intersect (1 thread)", bvh, tris, rays);
+    }
+    {
+        BVH bvh;
+        bvh.AddTriangles(tris.Vertices.data(), tris.Indices.data(), tris.GetCount());
+        result &= bvh.Build(4);
+        result &= CheckClosestHit("BVH::Intersect (4 threads)", bvh, tris, rays);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      頂点を動かして Refit() したBVHを総当たりの結果と比べて検証します.
+//-----------------------------------------------------------------------------
+bool VerifyRefit()
+{
+    Triangles tris;
+    MakeTriangles(12, 2048, tris);
+    const auto rest = tris.Vertices;
+
+    std::vector<asdx::Ray> rays;
+    MakeRays(13, 4096, rays);
+
+    BVH bvh;
+    bvh.AddTriangles(tris.Vertices.data(), tris.Indices.data(), tris.GetCount());
+    auto result = bvh.Build(1);
+
+    // 頂点を書き換えて境界だけを更新する. 三角形が構築時の境界の外に出るほど動かす.
+    for(auto frame=1; frame<=3; ++frame)
+    {
+        for(size_t i=0; i<tris.Vertices.size(); ++i)
+        {
+            const auto& p = rest[i];
+            tris.Vertices[i] = p + asdx::Vector3(
+                0.3f * sinf(float(frame) + 2.0f * p.y),
+                0.2f * float(frame) * p.x,
+                0.3f * cosf(float(frame) + 3.0f * p.x));
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "BVH::Refit (frame %d)", frame);
+        result &= bvh.Refit((frame == 2) ? 4 : 1);
+        result &= CheckClosestHit(name, bvh, tris, rays);
+    }
+
+    // 複製せずに設定したBVHは頂点を持たないので更新できない.
+    {
+        BVH view;
+        view.AddTriangles(tris.Vertices.data(), tris.Indices.data(), tris.GetCount());
+        auto attached = view.Attach(bvh.GetView());
+        auto refit    = view.Refit(1);
+        if (!attached || refit)
+        { printf("  BVH::Refit : Attach() %d Refit() %d (expect 1 0)\n", int(attached), int(refit)); }
+        result &= Report("BVH::Refit (attached)", 1, (attached && !refit) ? 0 : 1);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      変換行列の分解と補間, 時間ステップを持つBVHの交差を検証します.
+//-----------------------------------------------------------------------------
+bool VerifyMotion()
+{
+    auto result = true;
+
+    asdx::PCG rng(14);
+
+    // 分解して戻すと元の行列になる(せん断と鏡映を含む).
+    {
+        Checker checker("DecomposeTransform");
+        for(auto i=0; i<256; ++i)
+        {
+            auto shear = asdx::Matrix::CreateIdentity();
+            shear._21 = rng.GetAsF32(-0.5f, 0.5f);
+            shear._31 = rng.GetAsF32(-0.5f, 0.5f);
+            shear._32 = rng.GetAsF32(-0.5f, 0.5f);
+            auto mirror = asdx::Matrix::CreateScale(1.0f, 1.0f, (i % 4 == 3) ? -1.0f : 1.0f);
+            auto matrix = shear * mirror * MakeTransform(rng);
+
+            MotionKey    key;
+            asdx::Matrix composed;
+            DecomposeTransform(matrix, key);
+            ComposeTransform(key, composed);
+
+            auto error = 0.0f;
+            for(auto r=0; r<4; ++r)
+            {
+                for(auto c=0; c<3; ++c)
+                { error = std::max(error, fabsf(composed.m[r][c] - matrix.m[r][c])); }
+            }
+
+            char what[64];
+            snprintf(what, sizeof(what), "matrix %d error %g", i, error);
+            checker.Check(error <= 1e-5f, what);
+        }
+        result &= checker.Report();
+    }
+
+    // 時間ステップの時刻ではキーそのもの, 間では回転しても潰れない.
+    {
+        Checker checker("InterpolateMotion");
+
+        const asdx::Matrix transforms[3] = {
+            asdx::Matrix::CreateTranslation(0.0f, 0.0f, 0.0f),
+            asdx::Matrix::CreateRotationZ(asdx::F_PIDIV2) * asdx::Matrix::CreateTranslation(1.0f, 0.0f, 0.0f),
+            asdx::Matrix::CreateRotationZ(asdx::F_PI) * asdx::Matrix::CreateTranslation(2.0f, 1.0f, 0.0f),
+        };
+        MotionKey keys[3];
+        for(auto i=0; i<3; ++i)
+        { DecomposeTransform(transforms[i], keys[i]); }
+
+        for(auto i=0; i<3; ++i)
+        {
+            MotionKey    key;
+            asdx::Matrix matrix;
+            InterpolateMotion(keys, 3, float(i) * 0.5f, key);
+            ComposeTransform(key, matrix);
+
+            auto error = 0.0f;
+            for(auto r=0; r<4; ++r)
+            {
+                for(auto c=0; c<3; ++c)
+                { error = std::max(error, fabsf(matrix.m[r][c] - transforms[i].m[r][c])); }
+            }
+            checker.Check(error <= 1e-5f, "key time does not return the key");
+        }
+
+        for(auto t : { 0.1f, 0.25f, 0.6f, 0.9f })
+        {
+            MotionKey    key;
+            asdx::Matrix matrix;
+            InterpolateMotion(keys, 3, t, key);
+            ComposeTransform(key, matrix);
+
+            auto x = asdx::Vector3(matrix._11, matrix._12, matrix._13);
+            auto y = asdx::Vector3(matrix._21, matrix._22, matrix._23);
+            checker.Check(fabsf(x.Length() - 1.0f) <= 1e-5f && fabsf(y.Length() - 1.0f) <= 1e-5f
+                && fabsf(asdx::Vector3::Dot(x, y)) <= 1e-5f, "interpolated rotation is not orthonormal");
+        }
+
+        // 全時刻の境界は, 各時刻で変換した箱の頂点を全て含む.
+        const asdx::AABB box(asdx::Vector3(-1.0f, -0.5f, -0.25f), asdx::Vector3(1.0f, 0.5f, 0.25f));
+        auto bounds = CalcMotionBounds(keys, 3, box);
+        auto inside = true;
+        for(auto i=0; i<=64; ++i)
+        {
+            MotionKey    key;
+            asdx::Matrix matrix;
+            InterpolateMotion(keys, 3, float(i) / 64.0f, key);
+            ComposeTransform(key, matrix);
+            for(auto k=0; k<8; ++k)
+            {
+                auto p = asdx::Vector3::Transform(asdx::Vector3(
+                    (k & 1) ? box.maxi.x : box.mini.x,
+                    (k & 2) ? box.maxi.y : box.mini.y,
+                    (k & 4) ? box.maxi.z : box.mini.z), matrix);
+                inside &= (p.x >= bounds.mini.x - 1e-5f && p.x <= bounds.maxi.x + 1e-5f)
+                       && (p.y >= bounds.mini.y - 1e-5f && p.y <= bounds.maxi.y + 1e-5f)
+                       && (p.z >= bounds.mini.z - 1e-5f && p.z <= bounds.maxi.z + 1e-5f);
+            }
+        }
+        checker.Check(inside, "CalcMotionBounds() does not contain the moving box");
+        result &= checker.Report();
+    }
+
+    std::vector<asdx::Ray> rays;
+    MakeRays(15, 2048, rays);
+    const float times[] = { 0.0f, 0.3f, 0.5f, 0.8f, 1.0f };
+
+    // 変形: 時間ステップの頂点を線形に補間した三角形と一致する.
+    {
+        Triangles tris;
+        MakeTriangles(16, 1024, tris);
+
+        std::vector<asdx::Vector3> steps[3];
+        for(auto s=0; s<3; ++s)
+        {
+            for(auto& v : tris.Vertices)
+            { steps[s].push_back(v + asdx::Vector3(0.4f * float(s) * v.y, 0.0f, -0.3f * float(s * s) * v.x)); }
+        }
+        const asdx::Vector3* pointers[3] = { steps[0].data(), steps[1].data(), steps[2].data() };
+
+        BVH bvh;
+        bvh.AddMotionTriangles(pointers, 3, tris.Indices.data(), tris.GetCount());
+        result &= bvh.Build(1);
+
+        for(auto t : times)
+        {
+            uint32_t segment = 0;
+            auto     f       = GetMotionSegment(3, t, segment);
+            for(size_t i=0; i<tris.Vertices.size(); ++i)
+            { tris.Vertices[i] = steps[segment][i] * (1.0f - f) + steps[segment + 1][i] * f; }
+
+            char name[64];
+            snprintf(name, sizeof(name), "BVH::Intersect (time %.1f)", t);
+            result &= CheckClosestHit(name, bvh, tris, rays, t);
+        }
+    }
+
+    // 変換: 分解して補間した行列で移した三角形と一致する.
+    {
+        Triangles proto;
+        MakeTriangles(17, 256, proto);
+
+        BVH bvh;
+        bvh.AddTriangles(proto.Vertices.data(), proto.Indices.data(), proto.GetCount());
+        bvh.Build(1);
+
+        InstanceBVH scene;
+        auto id = scene.AddPrototype(&bvh);
+
+        std::vector<MotionKey> keys[8];
+        for(uint32_t i=0; i<8; ++i)
+        {
+            asdx::Matrix transforms[2] = { MakeTransform(rng), MakeTransform(rng) };
+            scene.AddMotionInstance(id, transforms, 2, i);
+            keys[i].resize(2);
+            DecomposeTransform(transforms[0], keys[i][0]);
+            DecomposeTransform(transforms[1], keys[i][1]);
+        }
+        result &= scene.Build(1);
+
+        for(auto t : times)
+        {
+            Triangles world;
+            for(uint32_t i=0; i<8; ++i)
+            {
+                MotionKey    key;
+                asdx::Matrix matrix;
+                InterpolateMotion(keys[i].data(), 2, t, key);
+                ComposeTransform(key, matrix);
+                AppendInstance(proto, matrix, i, world);
+            }
+
+            char name[64];
+            snprintf(name, sizeof(name), "InstanceBVH::Intersect (time %.1f)", t);
+            result &= CheckClosestHit(name, scene, world, rays, t);
+        }
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      インスタンスの2階層BVHをワールド空間に展開した三角形の総当たりと比べて検証します.
+//-----------------------------------------------------------------------------
+bool VerifyInstanceBVH()
+{
+    const uint32_t INSTANCE_COUNT = 48;
+
+    Triangles protos[2];
+    MakeTriangles(5, 512, protos[0]);
+    MakeTriangles(6, 128, protos[1]);
+
+    BVH bvhs[2];
+    for(auto i=0; i<2; ++i)
+    {
+        bvhs[i].AddTriangles(protos[i].Vertices.data(), protos[i].Indices.data(), protos[i].GetCount());
+        bvhs[i].Build(1);
+    }
+
+    asdx::PCG rng(7);
+    std::vector<asdx::Matrix> transforms;
+    for(uint32_t i=0; i<INSTANCE_COUNT; ++i)
+    { transforms.push_back(MakeTransform(rng)); }
+
+    // インスタンス番号とは別の番号が BVHHit::InstID に入ることも確かめる.
+    auto makeWorld = [&](Triangles& world)
+    {
+        world = Triangles();
+        for(uint32_t i=0; i<INSTANCE_COUNT; ++i)
+        { AppendInstance(protos[i % 2], transforms[i], 1000 + i, world); }
+    };
+
+    InstanceBVH scene;
+    uint32_t ids[2] = { scene.AddPrototype(&bvhs[0]), scene.AddPrototype(&bvhs[1]) };
+    for(uint32_t i=0; i<INSTANCE_COUNT; ++i)
+    { scene.AddInstance(ids[i % 2], transforms[i], 1000 + i); }
+
+    std::vector<asdx::Ray> rays;
+    MakeRays(8, 2048, rays);
+
+    auto result = scene.Build(1);
+
+    Triangles world;
+    makeWorld(world);
+    result &= CheckClosestHit("InstanceBVH::Intersect", scene, world, rays);
+
+    // 変換行列を変えて Refit() しても, 展開し直した三角形と一致する.
+    for(uint32_t i=0; i<INSTANCE_COUNT; i+=3)
+    {
+        transforms[i] = MakeTransform(rng);
+        scene.SetTransform(i, transforms[i]);
+    }
+    result &= scene.Refit(1);
+    makeWorld(world);
+    result &= CheckClosestHit("InstanceBVH::Refit", scene, world, rays);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      ジオメトリ用の配列のアライメント, 末尾の余白, メモリの集計を検証します.
+//-----------------------------------------------------------------------------
+bool VerifyGeometryMemory()
+{
+    using Array = AlignedArray<asdx::Vector3>;
+
+    size_t total    = 0;
+    size_t mismatch = 0;
+    auto check = [&](bool ok, const char* what, size_t count)
+    {
+        total++;
+        if (ok)
+        { return; }
+
+        if (mismatch < MAX_REPORT)
+        { printf("  AlignedArray : %s (count %zu)\n", what, count); }
+        mismatch++;
+    };
+
+    const auto base = GetGeometryMemorySize();
+    {
+        const size_t counts[] = { 1, 5, 21, 1000, 65537 };
+
+        Array array;
+        for(auto count : counts)
+        {
+            check(array.Resize(count), "Resize() failed", count);
+            check(uintptr_t(array.GetData()) % Array::ALIGNMENT == 0, "not aligned", count);
+            check(array.GetSize() >= sizeof(asdx::Vector3) * count + Array::PADDING, "no padding", count);
+            check(GetGeometryMemorySize() == base + array.GetSize(), "size not tracked", count);
+
+            // Embree が読み込む余白は 0 で埋まっている.
+            auto bytes = reinterpret_cast<const uint8_t*>(array.GetData());
+            auto zero  = true;
+            for(auto i = sizeof(asdx::Vector3) * count; i < array.GetSize(); ++i)
+            { zero &= (bytes[i] == 0); }
+            check(zero, "padding not cleared", count);
+        }
+
+        // ムーブしても集計は変わらず, 移動元は空になる.
+        auto size  = array.GetSize();
+        auto moved = Array(std::move(array));
+        check(array.GetData() == nullptr && array.GetSize() == 0, "source not reset by move", moved.GetCount());
+        check(GetGeometryMemorySize() == base + size, "size changed by move", moved.GetCount());
+
+        // 外部のメモリを参照した配列は解放しない.
+        Array view;
+        view.Attach(moved.GetData(), moved.GetCount(), moved.GetSize());
+        check(view.IsExternal(), "Attach() not external", view.GetCount());
+        view.Clear();
+        check(GetGeometryMemorySize() == base + size, "Clear() freed external memory", moved.GetCount());
+    }
+    check(GetGeometryMemorySize() == base, "memory leaked", 0);
+
+    return Report("AlignedArray", total, mismatch);
+}
+
+//-----------------------------------------------------------------------------
+//      OBJ と PLY の読み込み結果を既知の頂点とインデックスと比べて検証します.
+//-----------------------------------------------------------------------------
+bool VerifyMeshLoad()
+{
+    auto result = true;
+
+    // 四角形 1 枚を分割したもの.
+    Triangles quad;
+    quad.Vertices = {
+        asdx::Vector3(0.0f, 0.0f, 0.0f),
+        asdx::Vector3(1.0f, 0.0f, 0.0f),
+        asdx::Vector3(1.0f, 1.0f, 0.0f),
+        asdx::Vector3(0.0f, 1.0f, 0.0f),
+    };
+    quad.Indices = { 0, 1, 2, 0, 2, 3, 0, 2, 3 };
+
+    // 多角形の扇形分割, 負のインデックス, CRLF, 末尾の改行なし.
+    result &= CheckLoad("LoadMesh (OBJ)", "salty2_verify.obj",
+        "# comment\r\n"
+        "o quad\r\n"
+        "v 0 0 0\r\n"
+        "v 1.0 0 0\r\n"
+        "v 1 1e0 0\r\n"
+        "v 0 1 -0\r\n"
+        "g group\r\n"
+        "s off\r\n"
+        "f 1 2 3 4\r\n"
+        "f -4 -2 -1",
+        quad);
+
+    result &= CheckLoad("LoadMesh (PLY ascii)", "salty2_verify.ply",
+        "ply\n"
+        "format ascii 1.0\n"
+        "comment quad\n"
+        "element vertex 4\n"
+        "property float x\n"
+        "property float y\n"
+        "property float z\n"
+        "element face 2\n"
+        "property list uchar int vertex_indices\n"
+        "end_header\n"
+        "0 0 0\n"
+        "1 0 0\n"
+        "1 1 0\n"
+        "0 1 0\n"
+        "4 0 1 2 3\n"
+        "3 0 2 3\n",
+        quad);
+
+    // 複数のチャンクに分かれる大きさの格子.
+    Triangles grid;
+    MakeGrid(320, grid);
+    {
+        std::string text;
+        char line[128];
+        for(auto& v : grid.Vertices)
+        {
+            snprintf(line, sizeof(line), "v %g %g %g\n", v.x, v.y, v.z);
+            text += line;
+        }
+        for(size_t i=0; i<grid.Indices.size(); i+=6)
+        {
+            snprintf(line, sizeof(line), "f %u %u %u %u\n",
+                grid.Indices[i + 0] + 1, grid.Indices[i + 1] + 1, grid.Indices[i + 2] + 1, grid.Indices[i + 5] + 1);
+            text += line;
+        }
+        result &= CheckLoad("LoadMesh (OBJ grid)", "salty2_verify.obj", text, grid);
+    }
+    {
+        std::string text;
+        char line[128];
+        snprintf(line, sizeof(line), "%zu", grid.Vertices.size());
+        text += "ply\nformat binary_little_endian 1.0\nelement vertex ";
+        text += line;
+        text += "\nproperty float x\nproperty float y\nproperty float z\nelement face ";
+        snprintf(line, sizeof(line), "%zu", grid.Indices.size() / 6);
+        text += line;
+        text += "\nproperty list uchar int vertex_indices\nend_header\n";
+        text.append(reinterpret_cast<const char*>(grid.Vertices.data()), grid.Vertices.size() * sizeof(asdx::Vector3));
+        for(size_t i=0; i<grid.Indices.size(); i+=6)
+        {
+            const int32_t face[] = {
+                int32_t(grid.Indices[i + 0]), int32_t(grid.Indices[i + 1]),
+                int32_t(grid.Indices[i + 2]), int32_t(grid.Indices[i + 5]) };
+            text += char(4);
+            text.append(reinterpret_cast<const char*>(face), sizeof(face));
+        }
+        result &= CheckLoad("LoadMesh (PLY binary grid)", "salty2_verify.ply", text, grid);
+    }
+
+    // vt, vn を持つ OBJ は組ごとに頂点を分け, 属性を量子化して保持する.
+    {
+        const char text[] =
+            "v 0 0 0\n"
+            "v 1 0 0\n"
+            "v 0 1 0\n"
+            "vt 0.25 0.5\n"
+            "vt 0.75 0.5\n"
+            "vn 0 0 1\n"
+            "vn 0 1 0\n"
+            "f 1/1/1 2/2/1 3/1/1\n"
+            "f 1/2/2 3/2/2 2/1/2\n";
+
+        Mesh   mesh;
+        size_t mismatch = 0;
+        if (!WriteFile("salty2_verify.obj", text, sizeof(text) - 1) || !LoadMesh("salty2_verify.obj", mesh, 1))
+        {
+            printf("  LoadMesh (OBJ vt/vn) : LoadMesh() failed\n");
+            mismatch++;
+        }
+        else
+        {
+            // 三角形ごとに (頂点番号, vt, vn) の組が異なるので 6 頂点になる.
+            if (mesh.GetVertexCount() != 6 || mesh.GetTriangleCount() != 2)
+            {
+                printf("  LoadMesh (OBJ vt/vn) : %u vertices %u triangles (expect 6 vertices 2 triangles)\n",
+                    mesh.GetVertexCount(), mesh.GetTriangleCount());
+                mismatch++;
+            }
+
+            const asdx::Vector2 texcoords[2][3] = {
+                { asdx::Vector2(0.25f, 0.5f), asdx::Vector2(0.75f, 0.5f), asdx::Vector2(0.25f, 0.5f) },
+                { asdx::Vector2(0.75f, 0.5f), asdx::Vector2(0.75f, 0.5f), asdx::Vector2(0.25f, 0.5f) },
+            };
+            const asdx::Vector3 normals[2] = { asdx::Vector3(0.0f, 0.0f, 1.0f), asdx::Vector3(0.0f, 1.0f, 0.0f) };
+            const float weights[3][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 0.0f, 1.0f } };
+            for(uint32_t prim=0; prim<mesh.GetTriangleCount() && prim<2; ++prim)
+            {
+                for(auto k=0; k<3; ++k)
+                {
+                    SurfaceAttributes attr;
+                    DecodeAttributes(mesh, prim, weights[k][0], weights[k][1], attr);
+
+                    auto& st = texcoords[prim][k];
+                    auto& n  = normals[prim];
+                    if (fabsf(attr.TexCoord.x - st.x) <= 1e-4f && fabsf(attr.TexCoord.y - st.y) <= 1e-4f
+                     && asdx::Vector3::Dot(attr.Normal, n) >= 0.9999f)
+                    { continue; }
+
+                    if (mismatch < MAX_REPORT)
+                    {
+                        printf("  LoadMesh (OBJ vt/vn) prim %u corner %d : st (%.6f, %.6f) n (%.6f, %.6f, %.6f)\n",
+                            prim, k, attr.TexCoord.x, attr.TexCoord.y, attr.Normal.x, attr.Normal.y, attr.Normal.z);
+                    }
+                    mismatch++;
+                }
+            }
+        }
+        remove("salty2_verify.obj");
+        result &= Report("LoadMesh (OBJ vt/vn)", 6, mismatch);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      シーンキャッシュを書き出してマップし, 元のデータと比べて検証します.
+//-----------------------------------------------------------------------------
+bool VerifySceneCache()
+{
+    const char* source = "salty2_verify.obj";
+    const char* path   = "salty2_verify.cache";
+
+    Checker checker("SceneCache");
+
+    Triangles tris;
+    MakeTriangles(3, 1024, tris);
+
+    auto text = ToObj(tris);
+    Mesh mesh;
+    if (!checker.Check(WriteFile(source, text.data(), text.size()) && LoadMesh(source, mesh, 1), "LoadMesh() failed"))
+    {
+        remove(source);
+        return checker.Report();
+    }
+
+    BVH bvh;
+    bvh.AddTriangles(mesh.Positions.GetData(), mesh.Indices.GetData(), mesh.GetTriangleCount());
+    checker.Check(bvh.Build(1), "BVH::Build() failed");
+
+    std::vector<uint32_t> materialIds(mesh.GetTriangleCount());
+    for(size_t i=0; i<materialIds.size(); ++i)
+    { materialIds[i] = uint32_t(i % 3); }
+
+    const Material materials[2] = {
+        { { 0.5f, 0.25f, 0.125f }, 0.75f, { 0.0f, 0.0f, 0.0f }, 0.0f },
+        { { 1.0f, 1.0f,  1.0f   }, 0.1f,  { 2.0f, 3.0f, 4.0f }, 1.0f },
+    };
+
+    {
+        SceneCacheWriter writer;
+        auto index = writer.AddMesh(source, mesh);
+        writer.AddAttribute(index, SCENE_CACHE_SEMANTIC_MATERIAL_ID, { materialIds.data(), sizeof(uint32_t), uint32_t(materialIds.size()) });
+        writer.SetMaterials(materials, 2);
+        writer.SetBVH(bvh.GetView());
+        checker.Check(writer.Write(path), "Write() failed");
+    }
+
+    SceneCache cache;
+    if (checker.Check(cache.Open(path), "Open() failed"))
+    {
+        checker.Check(cache.GetMeshCount() == 1,             "mesh count differs");
+        checker.Check(cache.IsMeshValid(0, source),          "IsMeshValid() rejected the source");
+        checker.Check(!cache.IsMeshValid(0, "other.obj"),    "IsMeshValid() accepted another path");
+
+        // キャッシュを参照するメッシュとBVHは Close() より先に破棄する.
+        {
+            Mesh cached;
+            checker.Check(cache.AttachMesh(0, cached), "AttachMesh() failed");
+
+            auto same = [](const auto& a, const auto& b)
+            {
+                return a.GetCount() == b.GetCount()
+                    && (a.GetCount() == 0 || memcmp(a.GetData(), b.GetData(), sizeof(a[0]) * a.GetCount()) == 0);
+            };
+            checker.Check(cached.Positions.IsExternal(),                       "positions are copied");
+            checker.Check(uintptr_t(cached.Positions.GetData()) % 16 == 0,     "positions are not aligned");
+            checker.Check(same(cached.Positions, mesh.Positions),              "positions differ");
+            checker.Check(same(cached.Indices,   mesh.Indices),                "indices differ");
+            checker.Check(same(cached.Attributes.Normals,   mesh.Attributes.Normals),   "normals differ");
+            checker.Check(same(cached.Attributes.Tangents,  mesh.Attributes.Tangents),  "tangents differ");
+            checker.Check(same(cached.Attributes.TexCoords, mesh.Attributes.TexCoords), "texcoords differ");
+
+            SceneCacheAttribute attr = {};
+            checker.Check(cache.GetAttribute(0, SCENE_CACHE_SEMANTIC_MATERIAL_ID, attr)
+                && attr.Count == materialIds.size() && attr.Stride == sizeof(uint32_t)
+                && memcmp(attr.pData, materialIds.data(), sizeof(uint32_t) * materialIds.size()) == 0,
+                "material ids differ");
+            checker.Check(!cache.GetAttribute(0, SCENE_CACHE_SEMANTIC_USER, attr), "unknown attribute found");
+            checker.Check(cache.GetMaterialCount() == 2 && memcmp(cache.GetMaterials(), materials, sizeof(materials)) == 0,
+                "materials differ");
+
+            // マップしたBVHは元のBVHとビット単位で同じ結果を返す.
+            BVH::View view = {};
+            BVH mapped;
+            mapped.AddTriangles(cached.Positions.GetData(), cached.Indices.GetData(), cached.GetTriangleCount());
+            if (checker.Check(cache.GetBVH(view) && mapped.Attach(view), "GetBVH() failed"))
+            {
+                std::vector<asdx::Ray> rays;
+                MakeRays(4, 2048, rays);
+
+                size_t differ = 0;
+                for(const auto& ray : rays)
+                {
+                    auto   a = ray;
+                    auto   b = ray;
+                    BVHHit hitA = {};
+                    BVHHit hitB = {};
+                    auto   retA = bvh   .Intersect(a, hitA);
+                    auto   retB = mapped.Intersect(b, hitB);
+                    if (retA != retB || (retA && (a.tmax != b.tmax || hitA.PrimID != hitB.PrimID)))
+                    { differ++; }
+                }
+                checker.Check(differ == 0, "mapped BVH returns different hits");
+            }
+        }
+
+        // 読み込み元が変わったら使わない.
+        text += "# modified\n";
+        WriteFile(source, text.data(), text.size());
+        checker.Check(!cache.IsMeshValid(0, source), "IsMeshValid() accepted a modified source");
+
+        cache.Close();
+    }
+
+    remove(source);
+    remove(path);
+    return checker.Report();
+}
+
+//-----------------------------------------------------------------------------
+//      変換行列だけが異なるメッシュを重複として検出できるか検証します.
+//-----------------------------------------------------------------------------
+bool VerifyMeshDedup()
+{
+    Checker checker("FindDuplicateMeshes");
+
+    Triangles source;
+    MakeTriangles(9, 256, source);
+
+    asdx::PCG rng(10);
+    auto transform = MakeTransform(rng);
+
+    // 0 : 元のメッシュ.
+    // 1 : 0 を変換したコピー(重複).
+    // 2 : 同じ位相で頂点が異なるメッシュ.
+    // 3 : 0 の頂点を1つだけ許容誤差を超えて動かしたコピー.
+    // 4 : 0 の三角形の巡回順を変えたコピー(位相が異なる).
+    // 5 : 1 をさらに変換したコピー(重複).
+    Triangles tris[6];
+    tris[0] = source;
+    for(auto& v : source.Vertices)
+    { tris[1].Vertices.push_back(asdx::Vector3::Transform(v, transform)); }
+    tris[1].Indices = source.Indices;
+    MakeTriangles(11, 256, tris[2]);
+    tris[3] = source;
+    tris[3].Vertices[7].x += 0.01f;
+    tris[4] = source;
+    std::swap(tris[4].Indices[1], tris[4].Indices[2]);
+    auto second = MakeTransform(rng);
+    for(auto& v : tris[1].Vertices)
+    { tris[5].Vertices.push_back(asdx::Vector3::Transform(v, second)); }
+    tris[5].Indices = source.Indices;
+
+    Mesh        meshes  [6];
+    const Mesh* pointers[6];
+    for(auto i=0; i<6; ++i)
+    {
+        checker.Check(ToMesh(tris[i], meshes[i]), "ToMesh() failed");
+        pointers[i] = &meshes[i];
+    }
+
+    MeshDedupResult result;
+    FindDuplicateMeshes(pointers, 6, result);
+
+    const uint32_t prototypes[6] = { 0, 0, 2, 3, 4, 0 };
+    for(auto i=0; i<6; ++i)
+    {
+        char what[64];
+        snprintf(what, sizeof(what), "mesh %d prototype %u (expect %u)", i,
+            (i < int(result.Prototypes.size())) ? result.Prototypes[i] : BVH::INVALID_ID, prototypes[i]);
+        checker.Check(i < int(result.Prototypes.size()) && result.Prototypes[i] == prototypes[i], what);
+    }
+    checker.Check(result.DuplicateCount == 2,                              "DuplicateCount");
+    checker.Check(result.GroupSizes.size() == 6 && result.GroupSizes[0] == 3, "GroupSizes");
+    checker.Check(result.SavedTriangleCount == 2 * source.GetCount(),      "SavedTriangleCount");
+
+    // 代表メッシュを求めた変換行列で移すと, 重複したメッシュの頂点に一致する.
+    if (result.Transforms.size() == 6)
+    {
+        for(auto i : { 1, 5 })
+        {
+            auto error = 0.0f;
+            for(size_t k=0; k<source.Vertices.size(); ++k)
+            {
+                auto p = asdx::Vector3::Transform(source.Vertices[k], result.Transforms[i]);
+                error = std::max(error, asdx::Vector3::Distance(p, tris[i].Vertices[k]));
+            }
+            char what[64];
+            snprintf(what, sizeof(what), "mesh %d transform error %g", i, error);
+            checker.Check(error <= 1e-4f, what);
+        }
+    }
+    else
+    { checker.Check(false, "Transforms"); }
+
+    return checker.Report();
+}
+
+//-----------------------------------------------------------------------------
+//      交差時に分割するパッチの交差と, 分割結果のキャッシュの上限を検証します.
+//-----------------------------------------------------------------------------
+bool VerifyTessellation()
+{
+    const uint32_t THREAD_COUNT = 4;
+
+    WavePatches source;
+
+    // 全パッチを分割した三角形を総当たりの対象にする.
+    Triangles tris;
+    for(uint32_t patch=0; patch<source.GetPatchCount(); ++patch)
+    {
+        PatchMesh mesh;
+        source.Tessellate(patch, mesh);
+
+        auto base = uint32_t(tris.Vertices.size());
+        tris.Vertices.insert(tris.Vertices.end(), mesh.Positions.begin(), mesh.Positions.end());
+        tris.Params  .insert(tris.Params  .end(), mesh.Params   .begin(), mesh.Params   .end());
+        for(size_t i=0; i<mesh.Indices.size(); i+=3)
+        {
+            for(auto k=0; k<3; ++k)
+            { tris.Indices.push_back(base + mesh.Indices[i + k]); }
+            tris.PrimIDs.push_back(patch);
+        }
+    }
+
+    std::vector<asdx::AABB> bounds;
+    for(uint32_t patch=0; patch<source.GetPatchCount(); ++patch)
+    { bounds.push_back(source.GetPatchBounds(patch)); }
+
+    std::vector<asdx::Ray> rays;
+    MakeRays(18, 2048, rays);
+
+    // 分割結果 1 つ分のサイズを測り, 上限をその 8 つ分にする.
+    size_t entrySize = 0;
+    {
+        TessellationCache cache;
+        cache.Init(TessellationCache::DEFAULT_CAPACITY);
+        auto group = cache.Register(&source);
+        asdx::Ray ray(asdx::Vector3(-0.9f, -0.9f, 1.0f), asdx::Vector3(0.0f, 0.0f, -1.0f));
+        BVHHit    hit;
+        cache.Intersect(group, 0, ray, hit);
+        entrySize = cache.GetStats().MemorySize;
+        cache.Term();
+    }
+    const auto capacity = entrySize * 8;
+
+    auto result = true;
+
+    TessellationCache cache;
+    cache.Init(capacity);
+
+    PatchScene scene;
+    scene.pCache = &cache;
+    scene.Group  = cache.Register(&source);
+    result &= scene.Bvh.Build(bounds.data(), uint32_t(bounds.size()), 1);
+    result &= CheckClosestHit("TessellationCache::Intersect", scene, tris, rays);
+
+    // 追い出しと再分割が起きても上限を守る.
+    {
+        Checker checker("TessellationCache (1 thread)");
+        auto stats = cache.GetStats();
+        checker.Check(stats.EvictCount > 0,                                  "nothing evicted");
+        checker.Check(stats.TessellateCount > source.GetPatchCount(),        "nothing re-tessellated");
+        checker.Check(stats.MemorySize <= capacity,                          "MemorySize exceeds the capacity");
+        checker.Check(stats.PeakMemorySize <= capacity + entrySize,          "PeakMemorySize exceeds capacity + 1 entry");
+        result &= checker.Report();
+    }
+
+    // 並列に参照しても結果は同じで, 超えるのは参照中のスレッドごとに 1 つ分まで.
+    {
+        cache.Init(capacity);
+        scene.Group = cache.Register(&source);
+
+        std::vector<ReferenceHit> expects(rays.size());
+        for(size_t i=0; i<rays.size(); ++i)
+        { expects[i] = BruteForce(tris, rays[i]); }
+
+        std::vector<size_t> mismatches(THREAD_COUNT, 0);
+        std::vector<std::thread> threads;
+        for(uint32_t t=0; t<THREAD_COUNT; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                // スレッドごとに異なる順で辿り, 同じパッチの分割と追い出しを競合させる.
+                for(size_t k=0; k<rays.size(); ++k)
+                {
+                    auto   i   = (k * (2 * t + 1) + t * 97) % rays.size();
+                    auto   ray = rays[i];
+                    BVHHit hit = {};
+                    auto   ret = scene.Intersect(ray, hit, 0.0f);
+                    if (!IsSameHit(expects[i], ret, ray.tmax, hit))
+                    { mismatches[t]++; }
+                }
+            });
+        }
+        for(auto& thread : threads)
+        { thread.join(); }
+
+        Checker checker("TessellationCache (4 threads)");
+        size_t mismatch = 0;
+        for(auto count : mismatches)
+        { mismatch += count; }
+
+        auto stats = cache.GetStats();
+        checker.Check(mismatch == 0, "hits differ from brute force");
+        checker.Check(stats.PeakMemorySize <= capacity + entrySize * THREAD_COUNT, "PeakMemorySize exceeds capacity + 1 entry per thread");
+        result &= checker.Report();
+    }
+
+    cache.Term();
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      Bスプライン曲線の評価, 境界, 交差, 画素幅への拡大を検証します.
+//-----------------------------------------------------------------------------
+bool VerifyCurves()
+{
+    const uint32_t counts[3] = { 4, 7, 5 };
+
+    std::vector<asdx::Vector4> points;
+    for(uint32_t i=0; i<3; ++i)
+    {
+        for(uint32_t k=0; k<counts[i]; ++k)
+        {
+            points.push_back(asdx::Vector4(
+                0.3f * float(k),
+                0.5f * float(i) + 0.1f * sinf(0.7f * float(k)),
+                0.1f * cosf(0.5f * float(k) + float(i)),
+                0.02f + 0.005f * float(k)));
+        }
+    }
+
+    auto result = true;
+
+    for(auto type : { CURVE_TYPE_ROUND, CURVE_TYPE_FLAT })
+    {
+        Checker checker((type == CURVE_TYPE_ROUND) ? "Curves (round)" : "Curves (flat)");
+
+        Curves curves;
+        if (!checker.Check(curves.Init(type, points.data(), counts, 3), "Init() failed"))
+        {
+            result &= checker.Report();
+            continue;
+        }
+
+        // 制御点 n 個の毛は n - 3 個のセグメントになり, 毛の根元から毛先まで U が 0 から 1 に進む.
+        checker.Check(curves.GetStrandCount() == 3 && curves.GetSegmentCount() == 7, "segment count");
+        const uint32_t firsts [7] = { 0, 4, 5, 6, 7, 11, 12 };
+        const uint32_t strands[7] = { 0, 1, 1, 1, 1, 2,  2  };
+        for(uint32_t seg=0; seg<7 && seg<curves.GetSegmentCount(); ++seg)
+        {
+            CurveHit begin, end;
+            curves.GetHit(seg, 0.0f, begin);
+            curves.GetHit(seg, 1.0f, end);
+            checker.Check(curves.GetSegments()[seg] == firsts[seg], "segment index");
+            checker.Check(begin.Strand == strands[seg] && end.Strand == strands[seg], "strand of segment");
+            checker.Check(begin.U < end.U, "U does not increase along the strand");
+        }
+        {
+            CurveHit root, tip;
+            curves.GetHit(1, 0.0f, root);
+            curves.GetHit(4, 1.0f, tip);
+            checker.Check(root.U == 0.0f && fabsf(tip.U - 1.0f) <= 1e-6f, "U of root and tip");
+        }
+
+        // 評価は一様3次Bスプラインの定義(倍精度)に一致し, 境界は半径を含めて曲線を包含する.
+        auto maxError = 0.0;
+        auto inside   = true;
+        for(uint32_t seg=0; seg<curves.GetSegmentCount(); ++seg)
+        {
+            const auto* p = curves.GetPoints() + curves.GetSegments()[seg];
+            for(auto i=0; i<=64; ++i)
+            {
+                auto u = double(i) / 64.0;
+                auto s = 1.0 - u;
+                const double w[4] = {
+                    s * s * s / 6.0,
+                    (3.0 * u * u * u - 6.0 * u * u + 4.0) / 6.0,
+                    (-3.0 * u * u * u + 3.0 * u * u + 3.0 * u + 1.0) / 6.0,
+                    u * u * u / 6.0 };
+
+                double expect[4] = {};
+                for(auto k=0; k<4; ++k)
+                {
+                    expect[0] += w[k] * p[k].x;
+                    expect[1] += w[k] * p[k].y;
+                    expect[2] += w[k] * p[k].z;
+                    expect[3] += w[k] * p[k].w;
+                }
+
+                auto value = curves.Evaluate(seg, float(u));
+                maxError = std::max(maxError, fabs(value.x - expect[0]));
+                maxError = std::max(maxError, fabs(value.y - expect[1]));
+                maxError = std::max(maxError, fabs(value.z - expect[2]));
+                maxError = std::max(maxError, fabs(value.w - expect[3]));
+
+                for(auto partCount : { 1u, 2u, 4u })
+                {
+                    auto part = std::min(uint32_t(u * partCount), partCount - 1);
+                    auto box  = curves.GetSegmentBounds(seg, part, partCount);
+                    auto r    = value.w - 1e-5f;
+                    inside &= (value.x - r >= box.mini.x && value.x + r <= box.maxi.x)
+                           && (value.y - r >= box.mini.y && value.y + r <= box.maxi.y)
+                           && (value.z - r >= box.mini.z && value.z + r <= box.maxi.z);
+                }
+            }
+        }
+        checker.Check(maxError <= 1e-5, "Evaluate() differs from the basis functions");
+        checker.Check(inside, "GetSegmentBounds() does not contain the curve");
+
+        // 折れ線の頂点の位置に中心線へ垂直なレイを撃つと, 管なら表面, 帯なら中心線で交差する.
+        // 帯は曲がった側の隣の折れ線にも幅の内側で当たるので, 距離は半径, u は折れ線1本分まで許す.
+        // 半径の2倍だけ横にずらしたレイは交差しない.
+        size_t hitMismatch  = 0;
+        size_t missMismatch = 0;
+        for(uint32_t seg=0; seg<curves.GetSegmentCount(); ++seg)
+        {
+            for(uint32_t i=1; i<Curves::MAX_PART_COUNT; ++i)
+            {
+                auto u      = float(i) / float(Curves::MAX_PART_COUNT);
+                auto center = curves.Evaluate(seg, u);
+                CurveHit info;
+                curves.GetHit(seg, u, info);
+
+                auto side   = asdx::Vector3::Normalize(asdx::Vector3::Cross(info.Tangent, asdx::Vector3(0.0f, 0.0f, 1.0f)));
+                auto across = asdx::Vector3::Cross(info.Tangent, side);
+                auto pos    = asdx::Vector3(center.x, center.y, center.z) + side;
+
+                asdx::Ray ray(pos, -side);
+                BVHHit    hit = {};
+                auto round   = (type == CURVE_TYPE_ROUND);
+                auto expectT = round ? 1.0f - center.w : 1.0f;
+                auto tolT    = round ? 1e-4f : center.w;
+                auto tolU    = round ? 1e-4f : 1.0f / float(Curves::MAX_PART_COUNT);
+                auto ret     = curves.Intersect(seg, ray, hit);
+                if (!ret || fabsf(ray.tmax - expectT) > tolT || fabsf(hit.U - u) > tolU
+                 || hit.PrimID != seg || !curves.Occluded(seg, asdx::Ray(pos, -side)))
+                {
+                    if (hitMismatch < MAX_REPORT)
+                    {
+                        printf("  Curves segment %u u %.3f : hit %d t %.7f u %.7f (expect t %.7f)\n",
+                            seg, u, int(ret), ray.tmax, hit.U, expectT);
+                    }
+                    hitMismatch++;
+                }
+
+                asdx::Ray away(pos + across * (2.0f * center.w), -side);
+                if (curves.Intersect(seg, away, hit) || curves.Occluded(seg, away))
+                { missMismatch++; }
+            }
+        }
+        checker.Check(hitMismatch  == 0, "rays toward the center line");
+        checker.Check(missMismatch == 0, "rays offset by twice the radius hit");
+
+        // 画素より細い制御点だけを広げ, 広げた割合を Coverage で返す. 画素が小さくなれば元に戻す.
+        {
+            const asdx::Vector3 eye(0.0f, 0.0f, -10.0f);
+            const auto          pixelAngle = 0.01f;
+            auto widened = curves.WidenToPixel(eye, pixelAngle);
+
+            uint32_t expect = 0;
+            for(auto& p : points)
+            {
+                auto distance = asdx::Vector3(p.x - eye.x, p.y - eye.y, p.z - eye.z).Length();
+                expect += (p.w < 0.5f * pixelAngle * distance) ? 1 : 0;
+            }
+            checker.Check(widened == expect && expect > 0, "WidenToPixel() count");
+
+            CurveHit info;
+            curves.GetHit(0, 0.0f, info);
+            auto original = (points[0].w + 4.0f * points[1].w + points[2].w) / 6.0f;
+            checker.Check(info.Coverage < 1.0f && fabsf(info.Radius * info.Coverage - original) <= original * 0.05f,
+                "Coverage does not keep the original width");
+
+            checker.Check(curves.WidenToPixel(eye, 1e-6f) == 0, "WidenToPixel() with a small pixel");
+            auto restored = true;
+            for(uint32_t i=0; i<curves.GetPointCount(); ++i)
+            { restored &= fabsf(curves.GetPoints()[i].w - points[i].w) <= points[i].w * 1e-6f; }
+            checker.Check(restored, "radius not restored");
+            curves.GetHit(0, 0.0f, info);
+            checker.Check(info.Coverage == 1.0f, "Coverage not restored");
+        }
+
+        curves.Term();
+        result &= checker.Report();
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      量子化した頂点属性の復元誤差と, 交差位置で復元した属性を検証します.
+//-----------------------------------------------------------------------------
+bool VerifyAttributes()
+{
+    // 1 に近い内積から acos で求めると float の丸めが角度に大きく出るので, 外積の長さと合わせて倍精度で求める.
+    auto angle = [](const asdx::Vector3& a, const asdx::Vector3& b)
+    {
+        auto x = double(a.y) * b.z - double(a.z) * b.y;
+        auto y = double(a.z) * b.x - double(a.x) * b.z;
+        auto z = double(a.x) * b.y - double(a.y) * b.x;
+        auto d = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z;
+        return atan2(sqrt(x * x + y * y + z * z), d) * 180.0 / 3.14159265358979;
+    };
+
+    auto result = true;
+
+    // 八面体写像は 0.0075 度程度, テクスチャ座標は刻みの半分まで.
+    {
+        Checker checker("Attributes (quantize)");
+        asdx::PCG rng(11);
+
+        auto maxAngle     = 0.0;
+        auto maxDirection = 0.0f;
+        for(auto i=0; i<65536 + 6; ++i)
+        {
+            asdx::Vector3 n;
+            if (i < 6)
+            {
+                n = asdx::Vector3(0.0f, 0.0f, 0.0f);
+                (&n.x)[i / 2] = (i & 1) ? -1.0f : 1.0f;
+            }
+            else
+            {
+                auto z   = rng.GetAsF32(-1.0f, 1.0f);
+                auto phi = rng.GetAsF32(0.0f, 2.0f * asdx::F_PI);
+                auto r   = sqrtf(std::max(1.0f - z * z, 0.0f));
+                n = asdx::Vector3(r * cosf(phi), r * sinf(phi), z);
+            }
+
+            auto code    = EncodeOctNormal(n);
+            auto decoded = DecodeOctNormal(code);
+            maxAngle     = std::max(maxAngle, angle(n, decoded));
+
+            auto direction = asdx::Vector3::Normalize(DecodeOctDirection(code));
+            maxDirection   = std::max(maxDirection, (direction - decoded).Length());
+        }
+        if (maxAngle > 0.008)
+        { printf("  Attributes : oct normal error %.5f degrees\n", maxAngle); }
+        checker.Check(maxAngle <= 0.008, "EncodeOctNormal() error");
+        checker.Check(maxDirection <= 1e-6f, "DecodeOctDirection() differs from DecodeOctNormal()");
+
+        const asdx::Vector4 range(-3.0f, 0.5f, 8.0f, 0.25f);
+        auto tolU = range.z / 65535.0f * 0.5f + 4.0f * FLT_EPSILON;
+        auto tolV = range.w / 65535.0f * 0.5f + 4.0f * FLT_EPSILON;
+        auto inside = true;
+        for(auto i=0; i<65536; ++i)
+        {
+            asdx::Vector2 value(
+                rng.GetAsF32(range.x, range.x + range.z),
+                rng.GetAsF32(range.y, range.y + range.w));
+            auto decoded = DecodeTexCoord(EncodeTexCoord(value, range), range);
+            inside &= fabsf(decoded.x - value.x) <= tolU && fabsf(decoded.y - value.y) <= tolV;
+        }
+        checker.Check(inside, "EncodeTexCoord() error exceeds half a step");
+
+        // 範囲外は端に丸める.
+        auto lower = DecodeTexCoord(EncodeTexCoord(asdx::Vector2(-10.0f, 0.0f), range), range);
+        auto upper = DecodeTexCoord(EncodeTexCoord(asdx::Vector2( 10.0f, 1.0f), range), range);
+        checker.Check(lower.x == range.x && lower.y == range.y, "texcoord below the range");
+        checker.Check(fabsf(upper.x - (range.x + range.z)) <= tolU && fabsf(upper.y - (range.y + range.w)) <= tolV,
+            "texcoord above the range");
+
+        result &= checker.Report();
+    }
+
+    // 起伏のある格子に解析的な法線と, 位置の1次式のテクスチャ座標を与える.
+    // u は +x, v は -y に進むので, 接線は +x, 従法線は -y の向きになる.
+    Triangles grid;
+    MakeGrid(16, grid);
+
+    std::vector<asdx::Vector3> normals;
+    std::vector<asdx::Vector2> texcoords;
+    for(auto& p : grid.Vertices)
+    {
+        p.z = 0.1f * sinf(p.x) * cosf(p.y);
+        auto dzdx =  0.1f * cosf(p.x) * cosf(p.y);
+        auto dzdy = -0.1f * sinf(p.x) * sinf(p.y);
+        normals  .push_back(asdx::Vector3::Normalize(asdx::Vector3(-dzdx, -dzdy, 1.0f)));
+        texcoords.push_back(asdx::Vector2(2.0f * p.x + 0.3f, -3.0f * p.y + 1.0f));
+    }
+
+    for(auto withTexCoord : { true, false })
+    {
+        Checker checker(withTexCoord ? "Attributes (decode)" : "Attributes (no texcoord)");
+
+        Mesh mesh;
+        if (!checker.Check(ToMesh(grid, mesh), "ToMesh() failed")
+         || !checker.Check(EncodeAttributes(mesh, normals.data(), withTexCoord ? texcoords.data() : nullptr, mesh.Attributes), "EncodeAttributes() failed"))
+        {
+            result &= checker.Report();
+            continue;
+        }
+
+        const auto& range = mesh.Attributes.TexCoordRange;
+        auto tolU = range.z / 65535.0f + 1e-5f;
+        auto tolV = range.w / 65535.0f + 1e-5f;
+
+        asdx::PCG rng(12);
+        size_t mismatch = 0;
+        for(auto i=0; i<4096; ++i)
+        {
+            auto prim = uint32_t(rng.GetAsF32(0.0f, float(grid.GetCount()) - 0.5f));
+            auto u    = rng.GetAsF32(0.0f, 1.0f);
+            auto v    = rng.GetAsF32(0.0f, 1.0f);
+            if (u + v > 1.0f)
+            {
+                u = 1.0f - u;
+                v = 1.0f - v;
+            }
+            auto w = 1.0f - u - v;
+
+            const auto i0 = grid.Indices[prim * 3 + 0];
+            const auto i1 = grid.Indices[prim * 3 + 1];
+            const auto i2 = grid.Indices[prim * 3 + 2];
+
+            SurfaceAttributes attr;
+            DecodeAttributes(mesh, prim, u, v, attr);
+
+            auto position = grid.Vertices[i0] * w + grid.Vertices[i1] * u + grid.Vertices[i2] * v;
+            auto normal   = asdx::Vector3::Normalize(normals[i0] * w + normals[i1] * u + normals[i2] * v);
+            auto texcoord = texcoords[i0] * w + texcoords[i1] * u + texcoords[i2] * v;
+
+            auto ok = (attr.Position - position).Length() <= 1e-5f
+                   && angle(attr.Normal, normal) <= 0.01
+                   && asdx::Vector3::Dot(attr.GeometryNormal, attr.Normal) > 0.9f;
+
+            // 接線空間は正規直交で右手系か左手系のどちらか.
+            ok &= fabsf(attr.Normal   .Length() - 1.0f) <= 1e-5f
+               && fabsf(attr.Tangent  .Length() - 1.0f) <= 1e-5f
+               && fabsf(attr.Bitangent.Length() - 1.0f) <= 1e-5f
+               && fabsf(asdx::Vector3::Dot(attr.Normal,  attr.Tangent  )) <= 1e-5f
+               && fabsf(asdx::Vector3::Dot(attr.Normal,  attr.Bitangent)) <= 1e-5f
+               && fabsf(asdx::Vector3::Dot(attr.Tangent, attr.Bitangent)) <= 1e-5f;
+
+            if (withTexCoord)
+            {
+                auto dzdx =  0.1f * cosf(position.x) * cosf(position.y);
+                auto dzdy = -0.1f * sinf(position.x) * sinf(position.y);
+                auto dpdu = asdx::Vector3::Normalize(asdx::Vector3(1.0f, 0.0f,  dzdx));
+                auto dpdv = asdx::Vector3::Normalize(asdx::Vector3(0.0f, -1.0f, -dzdy));
+
+                ok &= fabsf(attr.TexCoord.x - texcoord.x) <= tolU
+                   && fabsf(attr.TexCoord.y - texcoord.y) <= tolV
+                   && asdx::Vector3::Dot(attr.Tangent,   dpdu) > 0.99f
+                   && asdx::Vector3::Dot(attr.Bitangent, dpdv) > 0.99f;
+            }
+            else
+            { ok &= (attr.TexCoord.x == u && attr.TexCoord.y == v); }
+
+            // 走査中に使う軽い復元も同じ値を返す.
+            auto light = DecodeTexCoord(mesh, prim, u, v);
+            ok &= (light.x == attr.TexCoord.x && light.y == attr.TexCoord.y);
+
+            if (!ok)
+            {
+                if (mismatch < MAX_REPORT)
+                {
+                    printf("  Attributes prim %u (%.3f, %.3f) : texcoord (%.6f, %.6f) expect (%.6f, %.6f) normal error %.5f degrees\n",
+                        prim, u, v, attr.TexCoord.x, attr.TexCoord.y, texcoord.x, texcoord.y, angle(attr.Normal, normal));
+                }
+                mismatch++;
+            }
+        }
+        checker.Check(mismatch == 0, "decoded attributes");
+
+        result &= checker.Report();
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      抜き型のマスクと, BVHの交差判定関数によるアルファテストを検証します.
+//-----------------------------------------------------------------------------
+bool VerifyAlphaTest()
+{
+    auto result = true;
+
+    // タイルの辺で割り切れない大きさの RGBA8 画像を, 行の末尾に余白を付けて渡す.
+    const uint32_t width     = 37;
+    const uint32_t height    = 21;
+    const uint32_t rowPitch  = width * 4 + 12;
+    const uint8_t  threshold = 100;
+
+    std::vector<uint8_t> image(size_t(rowPitch) * height, 0xcd);
+    {
+        asdx::PCG rng(13);
+        for(uint32_t y=0; y<height; ++y)
+        {
+            for(uint32_t x=0; x<width; ++x)
+            { image[size_t(y) * rowPitch + x * 4 + 3] = uint8_t(rng.GetAsF32(0.0f, 255.99f)); }
+        }
+    }
+    auto alphaAt = [&](uint32_t x, uint32_t y)
+    { return image[size_t(y) * rowPitch + x * 4 + 3]; };
+
+    AlphaMask mask;
+    {
+        Checker checker("AlphaMask");
+        checker.Check(mask.IsOpaque(0.5f, 0.5f), "uninitialized mask is not opaque");
+
+        if (checker.Check(mask.Init(width, height, image.data() + 3, 4, rowPitch, threshold), "Init() failed"))
+        {
+            // 画素の中心は元の画素に, 整数だけずらした座標は同じ画素に戻る.
+            size_t mismatch = 0;
+            size_t opaque   = 0;
+            for(uint32_t y=0; y<height; ++y)
+            {
+                for(uint32_t x=0; x<width; ++x)
+                {
+                    auto u = (float(x) + 0.5f) / float(width);
+                    auto v = (float(y) + 0.5f) / float(height);
+                    auto expect = alphaAt(x, y) >= threshold;
+                    opaque += expect ? 1 : 0;
+
+                    if (mask.IsOpaque(u, v) != expect
+                     || mask.IsOpaque(u + 1.0f, v - 2.0f) != expect
+                     || mask.IsOpaque(u - 3.0f, v + 1.0f) != expect)
+                    { mismatch++; }
+                }
+            }
+            checker.Check(mismatch == 0, "IsOpaque() differs from the image");
+            checker.Check(mask.GetWidth() == width && mask.GetHeight() == height, "size");
+            checker.Check(fabsf(mask.GetCoverage() - float(opaque) / float(width * height)) <= 1e-6f, "GetCoverage()");
+
+            auto tiles = ((width + AlphaMask::TILE_SIZE - 1) / AlphaMask::TILE_SIZE)
+                       * ((height + AlphaMask::TILE_SIZE - 1) / AlphaMask::TILE_SIZE);
+            checker.Check(mask.GetMemorySize() == tiles * sizeof(uint64_t), "GetMemorySize()");
+        }
+
+        result &= checker.Report();
+    }
+
+    // テクスチャ座標を位置と揃えた [0, 1]^2 の格子を手前に, 全面を覆う四角形を奥に置き,
+    // 画素の中心を通るレイを撃つ. 透明な画素では手前の三角形を棄却して奥に交差する.
+    {
+        Checker checker("AlphaTest");
+
+        Triangles front;
+        MakeGrid(8, front);
+
+        std::vector<asdx::Vector2> texcoords;
+        for(auto& p : front.Vertices)
+        {
+            p *= 0.5f;
+            texcoords.push_back(asdx::Vector2(p.x, p.y));
+        }
+
+        Mesh mesh;
+        if (!checker.Check(ToMesh(front, mesh), "ToMesh() failed")
+         || !checker.Check(EncodeAttributes(mesh, nullptr, texcoords.data(), mesh.Attributes), "EncodeAttributes() failed"))
+        { return checker.Report() && result; }
+
+        const asdx::Vector3 back[4] = {
+            asdx::Vector3(-1.0f, -1.0f, 1.0f),
+            asdx::Vector3( 2.0f, -1.0f, 1.0f),
+            asdx::Vector3( 2.0f,  2.0f, 1.0f),
+            asdx::Vector3(-1.0f,  2.0f, 1.0f),
+        };
+        const uint32_t backIndices[6] = { 0, 1, 2, 0, 2, 3 };
+
+        BVH bvh;
+        auto frontID = bvh.AddTriangles(mesh.Positions.GetData(), mesh.Indices.GetData(), mesh.GetTriangleCount());
+        auto backID  = bvh.AddTriangles(back, backIndices, 2);
+        checker.Check(bvh.Build(1), "Build() failed");
+
+        AlphaTestSource source = { &mesh, &mask };
+
+        for(auto filtered : { true, false })
+        {
+            bvh.SetFilter(frontID, filtered ? AlphaTest : nullptr, filtered ? &source : nullptr);
+
+            size_t hitMismatch      = 0;
+            size_t occludedMismatch = 0;
+            for(uint32_t y=0; y<height; ++y)
+            {
+                for(uint32_t x=0; x<width; ++x)
+                {
+                    auto u = (float(x) + 0.5f) / float(width);
+                    auto v = (float(y) + 0.5f) / float(height);
+                    auto opaque = !filtered || alphaAt(x, y) >= threshold;
+
+                    asdx::Ray ray(asdx::Vector3(u, v, -1.0f), asdx::Vector3(0.0f, 0.0f, 1.0f));
+                    BVHHit hit = {};
+                    auto ret = bvh.Intersect(ray, hit);
+                    if (!ret || hit.GeomID != (opaque ? frontID : backID)
+                     || fabsf(ray.tmax - (opaque ? 1.0f : 2.0f)) > T_TOLERANCE)
+                    {
+                        if (hitMismatch < MAX_REPORT)
+                        {
+                            printf("  AlphaTest pixel (%u, %u) : hit %d geom %u t %.7f (expect geom %u)\n",
+                                x, y, int(ret), hit.GeomID, ray.tmax, opaque ? frontID : backID);
+                        }
+                        hitMismatch++;
+                    }
+
+                    // 手前と奥の間までのレイは不透明な画素でだけ遮られる.
+                    asdx::Ray shadow(asdx::Vector3(u, v, -1.0f), asdx::Vector3(0.0f, 0.0f, 1.0f), 0.0f, 1.5f);
+                    if (bvh.Occluded(shadow) != opaque)
+                    { occludedMismatch++; }
+                }
+            }
+            checker.Check(hitMismatch      == 0, filtered ? "Intersect() with filter" : "Intersect() after removing filter");
+            checker.Check(occludedMismatch == 0, filtered ? "Occluded() with filter"  : "Occluded() after removing filter");
+        }
+
+        result &= checker.Report();
+    }
+
+    return result;
+}
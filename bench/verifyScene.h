@@ -0,0 +1,103 @@
+﻿//-----------------------------------------------------------------------------
+// File : verifyScene.h
+// Desc : Verification for scene components.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+
+//-----------------------------------------------------------------------------
+//! @brief      組み込みBVHの最近傍交差と遮蔽判定を総当たりの結果と比べて検証します.
+//!
+//! @retval true    全てのレイで交差の有無, 距離, 三角形番号が一致.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyBVH();
+
+//-----------------------------------------------------------------------------
+//! @brief      ジオメトリ用の配列のアライメント, 末尾の余白, メモリの集計を検証します.
+//!
+//! @retval true    Embree と共有できる配置で, 解放後に集計が元に戻る.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyGeometryMemory();
+
+//-----------------------------------------------------------------------------
+//! @brief      OBJ と PLY の読み込み結果を既知の頂点とインデックスと比べて検証します.
+//!
+//! @retval true    単一スレッドでも並列でも期待通りに読み込める.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyMeshLoad();
+
+//-----------------------------------------------------------------------------
+//! @brief      シーンキャッシュを書き出してマップし, 元のデータと比べて検証します.
+//!
+//! @retval true    メッシュ, 頂点属性, マテリアル, BVH が元と一致し, 更新の検出も働く.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifySceneCache();
+
+//-----------------------------------------------------------------------------
+//! @brief      インスタンスの2階層BVHをワールド空間に展開した三角形の総当たりと比べて検証します.
+//!
+//! @retval true    変換行列の更新後も含め, 交差の有無, 距離, インスタンス番号, 三角形番号が一致.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyInstanceBVH();
+
+//-----------------------------------------------------------------------------
+//! @brief      変換行列だけが異なるメッシュを重複として検出できるか検証します.
+//!
+//! @retval true    変換したコピーだけを重複とし, 求めた変換行列で頂点が一致する.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyMeshDedup();
+
+//-----------------------------------------------------------------------------
+//! @brief      頂点を動かして Refit() したBVHを総当たりの結果と比べて検証します.
+//!
+//! @retval true    更新後の交差が動かした三角形の総当たりと一致.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyRefit();
+
+//-----------------------------------------------------------------------------
+//! @brief      変換行列の分解と補間, 時間ステップを持つBVHの交差を検証します.
+//!
+//! @retval true    分解して戻した行列が元に一致し, 各時刻の交差が補間した三角形の総当たりと一致.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyMotion();
+
+//-----------------------------------------------------------------------------
+//! @brief      交差時に分割するパッチの交差と, 分割結果のキャッシュの上限を検証します.
+//!
+//! @retval true    交差が全パッチを分割した三角形の総当たりと一致し, 保持サイズが上限内に収まる.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyTessellation();
+
+//-----------------------------------------------------------------------------
+//! @brief      Bスプライン曲線の評価, 境界, 交差, 画素幅への拡大を検証します.
+//!
+//! @retval true    評価が基底関数の定義に一致し, 境界が曲線を包含し, 交差が中心線と半径に一致.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyCurves();
+
+//-----------------------------------------------------------------------------
+//! @brief      量子化した頂点属性の復元誤差と, 交差位置で復元した属性を検証します.
+//!
+//! @retval true    復元誤差が量子化の刻みに収まり, 補間した属性が float の補間と一致し, 接線空間が正規直交.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyAttributes();
+
+//-----------------------------------------------------------------------------
+//! @brief      抜き型のマスクと, BVHの交差判定関数によるアルファテストを検証します.
+//!
+//! @retval true    マスクが元の画素に一致し, 透明な画素を通るレイが奥の面に交差する.
+//! @retval false   不一致あり.
+//-----------------------------------------------------------------------------
+bool VerifyAlphaTest();
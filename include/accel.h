@@ -0,0 +1,470 @@
+﻿//-----------------------------------------------------------------------------
+// File : accel.h
+// Desc : Acceleration Structure.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <memory>
+#include <asdxMath.h>
+#include <bvh.h>
+#include <tessCache.h>
+#include <curve.h>
+
+// Embree を使用するかどうか(既定ではビルド済みライブラリがある Windows のみ).
+#ifndef SALTY2_USE_EMBREE
+    #if defined(_WIN32)
+        #define SALTY2_USE_EMBREE   1
+    #else
+        #define SALTY2_USE_EMBREE   0
+    #endif
+#endif//SALTY2_USE_EMBREE
+
+#if SALTY2_USE_EMBREE
+#include <embree3/rtcore.h>
+#else
+
+//-----------------------------------------------------------------------------
+// Constant Values
+//-----------------------------------------------------------------------------
+#define RTC_INVALID_GEOMETRY_ID         ((unsigned int)-1)
+#define RTC_MAX_INSTANCE_LEVEL_COUNT    1
+#define RTC_MAX_TIME_STEP_COUNT         129
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RTCBuildQuality enum
+///////////////////////////////////////////////////////////////////////////////
+enum RTCBuildQuality
+{
+    RTC_BUILD_QUALITY_LOW    = 0,
+    RTC_BUILD_QUALITY_MEDIUM = 1,
+    RTC_BUILD_QUALITY_HIGH   = 2,
+    RTC_BUILD_QUALITY_REFIT  = 3,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// RTCSceneFlags enum
+///////////////////////////////////////////////////////////////////////////////
+enum RTCSceneFlags
+{
+    RTC_SCENE_FLAG_NONE                    = 0,
+    RTC_SCENE_FLAG_DYNAMIC                 = (1 << 0),
+    RTC_SCENE_FLAG_COMPACT                 = (1 << 1),
+    RTC_SCENE_FLAG_ROBUST                  = (1 << 2),
+    RTC_SCENE_FLAG_CONTEXT_FILTER_FUNCTION = (1 << 3)
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RTCRay structure
+// Embree を使わない場合の代替定義です(メモリレイアウトは rtcore_ray.h と同じ).
+///////////////////////////////////////////////////////////////////////////////
+struct alignas(16) RTCRay
+{
+    float           org_x;
+    float           org_y;
+    float           org_z;
+    float           tnear;
+    float           dir_x;
+    float           dir_y;
+    float           dir_z;
+    float           time;
+    float           tfar;
+    unsigned int    mask;
+    unsigned int    id;
+    unsigned int    flags;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// RTCHit structure
+///////////////////////////////////////////////////////////////////////////////
+struct alignas(16) RTCHit
+{
+    float           Ng_x;
+    float           Ng_y;
+    float           Ng_z;
+    float           u;
+    float           v;
+    unsigned int    primID;
+    unsigned int    geomID;
+    unsigned int    instID[RTC_MAX_INSTANCE_LEVEL_COUNT];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// RTCRayHit structure
+///////////////////////////////////////////////////////////////////////////////
+struct alignas(16) RTCRayHit
+{
+    RTCRay  ray;
+    RTCHit  hit;
+};
+
+#endif//SALTY2_USE_EMBREE
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ACCEL_BACKEND enum
+///////////////////////////////////////////////////////////////////////////////
+enum ACCEL_BACKEND : uint32_t
+{
+    ACCEL_BACKEND_EMBREE = 0,   //!< Embree を使用します(無効な場合は組み込みBVHに切り替え).
+    ACCEL_BACKEND_BVH,          //!< 組み込みBVHを使用します.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AccelDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct AccelDesc
+{
+    ACCEL_BACKEND   Backend      = ACCEL_BACKEND_EMBREE;        //!< バックエンドです.
+    const char*     DeviceConfig = nullptr;                     //!< デバイス設定文字列です(例: "threads=8,isa=avx2,set_affinity=1").
+    RTCBuildQuality BuildQuality = RTC_BUILD_QUALITY_MEDIUM;    //!< シーンの構築品質です.
+    RTCSceneFlags   SceneFlags   = RTC_SCENE_FLAG_NONE;         //!< シーンフラグです(更新するなら RTC_SCENE_FLAG_DYNAMIC).
+    float           RebuildThreshold  = 0.05f;                  //!< 更新時に再構築する変形量です(前回の再構築からの相対変位の二乗平均平方根).
+    double          RebuildBudgetMsec = 0.0;                    //!< 1回の更新で再構築に使う時間の目安(ミリ秒)です. 0 なら無制限.
+    size_t          TessellationCacheSize = 0;                  //!< パッチの分割結果を保持する上限サイズ(バイト)です. 0 なら既定値.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// AccelStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct AccelStats
+{
+    double      BuildMsec;          //!< 直近の Commit() にかかった時間(ミリ秒)です.
+    size_t      MemorySize;         //!< 現在の使用メモリ(バイト)です.
+    size_t      PeakMemorySize;     //!< 使用メモリの最大値(バイト)です.
+    uint32_t    RefitCount;         //!< 直近の Commit() で境界だけ更新したジオメトリ数です.
+    uint32_t    RebuildCount;       //!< 直近の Commit() で再構築したジオメトリ数です.
+    TessellationStats Tessellation; //!< パッチの分割結果のキャッシュの統計です(MemorySize には含みません).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Accel class
+// rtcIntersect1() / rtcOccluded1() と同じ規約でレイを判定するインタフェースです.
+///////////////////////////////////////////////////////////////////////////////
+class Accel
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    virtual ~Accel() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      desc        構成設定です.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------
+    virtual bool Init(const AccelDesc& desc) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    virtual void Term() = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      三角形メッシュを追加します.
+    //!
+    //! @param[in]      vertices        頂点座標です.
+    //! @param[in]      vertexCount     頂点数です.
+    //! @param[in]      indices         インデックスです(三角形あたり3個).
+    //! @param[in]      triangleCount   三角形数です.
+    //! @return     ジオメトリ番号を返却します. 失敗時は RTC_INVALID_GEOMETRY_ID を返却します.
+    //-------------------------------------------------------------------------
+    virtual uint32_t AddTriangles(
+        const asdx::Vector3*    vertices,
+        uint32_t                vertexCount,
+        const uint32_t*         indices,
+        uint32_t                triangleCount) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      三角形メッシュを複製せずに追加します.
+    //!
+    //! @param[in]      vertices        頂点座標です(末尾に16バイト以上の余白が必要).
+    //! @param[in]      vertexCount     頂点数です.
+    //! @param[in]      indices         インデックスです(三角形あたり3個).
+    //! @param[in]      triangleCount   三角形数です.
+    //! @return     ジオメトリ番号を返却します. 失敗時は RTC_INVALID_GEOMETRY_ID を返却します.
+    //! @note       バッファは Term() を呼ぶまで解放しないでください.
+    //-------------------------------------------------------------------------
+    virtual uint32_t AddSharedTriangles(
+        const asdx::Vector3*    vertices,
+        uint32_t                vertexCount,
+        const uint32_t*         indices,
+        uint32_t                triangleCount) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      時間ステップごとの頂点を持つ三角形メッシュを複製せずに追加します.
+    //!
+    //! @param[in]      vertices        時間ステップごとの頂点座標です(それぞれ末尾に16バイト以上の余白が必要).
+    //! @param[in]      timeStepCount   時間ステップ数です(RTC_MAX_TIME_STEP_COUNT 以下).
+    //! @param[in]      vertexCount     頂点数です.
+    //! @param[in]      indices         インデックスです(三角形あたり3個).
+    //! @param[in]      triangleCount   三角形数です.
+    //! @return     ジオメトリ番号を返却します. 失敗時は RTC_INVALID_GEOMETRY_ID を返却します.
+    //! @note       時間ステップは [0, 1] を等間隔に分割した時刻に置き, レイの time で線形に補間します.
+    //!             UpdateTriangles() による更新はできません. バッファは Term() を呼ぶまで解放しないでください.
+    //-------------------------------------------------------------------------
+    virtual uint32_t AddSharedMotionTriangles(
+        const asdx::Vector3* const* vertices,
+        uint32_t                    timeStepCount,
+        uint32_t                    vertexCount,
+        const uint32_t*             indices,
+        uint32_t                    triangleCount) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      インスタンスで参照するプロトタイプを複製せずに追加します.
+    //!
+    //! @param[in]      vertices        頂点座標です(末尾に16バイト以上の余白が必要).
+    //! @param[in]      vertexCount     頂点数です.
+    //! @param[in]      indices         インデックスです(三角形あたり3個).
+    //! @param[in]      triangleCount   三角形数です.
+    //! @return     プロトタイプ番号を返却します. 失敗時は RTC_INVALID_GEOMETRY_ID を返却します.
+    //! @note       プロトタイプ自体は交差判定の対象になりません. バッファは Term() を呼ぶまで解放しないでください.
+    //-------------------------------------------------------------------------
+    virtual uint32_t AddPrototype(
+        const asdx::Vector3*    vertices,
+        uint32_t                vertexCount,
+        const uint32_t*         indices,
+        uint32_t                triangleCount) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      プロトタイプのインスタンスを追加します.
+    //!
+    //! @param[in]      prototype       プロトタイプ番号です.
+    //! @param[in]      transform       オブジェクト空間からワールド空間への変換行列です.
+    //! @return     ジオメトリ番号を返却します. 失敗時は RTC_INVALID_GEOMETRY_ID を返却します.
+    //! @note       交差した場合, hit.instID[0] にこの番号が, hit.geomID に 0 が入ります.
+    //!             hit.Ng はオブジェクト空間のままです.
+    //-------------------------------------------------------------------------
+    virtual uint32_t AddInstance(uint32_t prototype, const asdx::Matrix& transform) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      時間ステップごとの変換行列を持つインスタンスを追加します.
+    //!
+    //! @param[in]      prototype       プロトタイプ番号です.
+    //! @param[in]      transforms      時間ステップごとのオブジェクト空間からワールド空間への変換行列です.
+    //! @param[in]      timeStepCount   時間ステップ数です(RTC_MAX_TIME_STEP_COUNT 以下).
+    //! @return     ジオメトリ番号を返却します. 失敗時は RTC_INVALID_GEOMETRY_ID を返却します.
+    //! @note       行列は 平行移動 * 回転 * 拡縮・せん断 に分解し, 回転は球面線形に, それ以外は線形に補間します.
+    //!             行列をそのまま線形に補間すると回転中に物体が縮むので, それを避けるためです.
+    //-------------------------------------------------------------------------
+    virtual uint32_t AddMotionInstance(uint32_t prototype, const asdx::Matrix* transforms, uint32_t timeStepCount) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      交差判定の時点で三角形に分割するパッチ群を追加します.
+    //!
+    //! @param[in]      source          パッチ群です. Term() を呼ぶまで破棄しないでください.
+    //! @return     ジオメトリ番号を返却します. 失敗時は RTC_INVALID_GEOMETRY_ID を返却します.
+    //! @note       構築時はパッチの境界だけを使い, レイが初めて境界に入った時点で分割します.
+    //!             分割結果は全ジオメトリで共有する上限付きのキャッシュ(TessellationCacheSize)に入れるので,
+    //!             表面積が増えても使用メモリは上限に, 走査スレッドごとに参照中の分割結果1つ分を加えた値までに収まります.
+    //!             交差した場合, hit.primID にパッチ番号が, hit.u と hit.v にパッチ上のパラメータが入ります.
+    //-------------------------------------------------------------------------
+    virtual uint32_t AddPatches(const PatchSource* source) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      Bスプライン曲線(髪や毛皮)を複製せずに追加します.
+    //!
+    //! @param[in]      curves          曲線です. Term() を呼ぶまで破棄しないでください.
+    //! @return     ジオメトリ番号を返却します. 失敗時は RTC_INVALID_GEOMETRY_ID を返却します.
+    //! @note       三角形の管に分割せず, 制御点のまま判定します.
+    //!             交差した場合, hit.primID にセグメント番号が, hit.u にセグメント内のパラメータが入ります.
+    //!             毛の番号, 毛全体でのパラメータ, 接線は Curves::GetHit() で求めてください.
+    //-------------------------------------------------------------------------
+    virtual uint32_t AddCurves(const Curves* curves) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      三角形メッシュの交差を判定する関数(アルファテスト)を設定します.
+    //!
+    //! @param[in]      geomID          AddTriangles(), AddSharedTriangles(), AddSharedMotionTriangles() で取得したジオメトリ番号です.
+    //! @param[in]      func            判定関数です. nullptr なら設定を解除します.
+    //! @param[in]      userPtr         判定関数に渡すポインタです. Term() を呼ぶまで破棄しないでください.
+    //! @retval true    設定に成功. 次の Commit() から反映します.
+    //! @retval false   三角形メッシュではない.
+    //! @note       判定関数は走査中に交差の候補ごとに呼ばれ, 棄却した候補は交差しなかったものとして走査を続けます.
+    //!             透過する層ごとに Intersect1() を呼び直すのと違い, 根から辿り直す必要がありません.
+    //!             候補は距離順に来るとは限らず, 同じ三角形で複数回呼ばれることもあります.
+    //!             Embree では交差と遮蔽のフィルタ関数として登録します.
+    //-------------------------------------------------------------------------
+    virtual bool SetHitFilter(uint32_t geomID, BVH::FilterFunc func, const void* userPtr) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      プロトタイプの交差を判定する関数(アルファテスト)を設定します.
+    //!
+    //! @param[in]      prototype       AddPrototype() で取得したプロトタイプ番号です.
+    //! @param[in]      func            判定関数です. nullptr なら設定を解除します.
+    //! @param[in]      userPtr         判定関数に渡すポインタです. Term() を呼ぶまで破棄しないでください.
+    //! @retval true    設定に成功. 次の Commit() から反映します.
+    //! @retval false   プロトタイプ番号が不正.
+    //! @note       プロトタイプを参照する全インスタンスで共有します. 判定関数の primID, u, v はプロトタイプ内のものです.
+    //-------------------------------------------------------------------------
+    virtual bool SetPrototypeHitFilter(uint32_t prototype, BVH::FilterFunc func, const void* userPtr) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      インスタンスが参照するプロトタイプ番号を取得します.
+    //!
+    //! @param[in]      instID          AddInstance() で取得したジオメトリ番号です.
+    //! @return     プロトタイプ番号を返却します. インスタンスでなければ RTC_INVALID_GEOMETRY_ID を返却します.
+    //-------------------------------------------------------------------------
+    virtual uint32_t GetInstancePrototype(uint32_t instID) const = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      インスタンスの変換行列を取得します.
+    //!
+    //! @param[in]      instID          AddInstance() で取得したジオメトリ番号です.
+    //! @param[out]     transform       オブジェクト空間からワールド空間への変換行列です.
+    //! @param[in]      time            時刻です(時間ステップを持つインスタンスはこの時刻で補間します).
+    //! @retval true    取得に成功.
+    //! @retval false   インスタンスではない.
+    //! @note       hit.Ng をワールド空間に戻す場合は, レイと同じ時刻の行列の逆転置行列で変換してください.
+    //-------------------------------------------------------------------------
+    virtual bool GetInstanceTransform(uint32_t instID, asdx::Matrix& transform, float time = 0.0f) const = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      三角形メッシュの頂点を書き換えたことを通知します.
+    //!
+    //! @param[in]      geomID          AddSharedTriangles() で取得したジオメトリ番号です.
+    //! @retval true    通知に成功. 次の Commit() で反映します.
+    //! @retval false   共有した三角形メッシュではないか, 更新できない構成.
+    //! @note       頂点数とインデックスは変えられません. 共有したバッファをそのまま書き換えてください.
+    //!             組み込みBVHでは RTC_SCENE_FLAG_DYNAMIC を指定して初期化する必要があります.
+    //-------------------------------------------------------------------------
+    virtual bool UpdateTriangles(uint32_t geomID) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      インスタンスの変換行列を変更します.
+    //!
+    //! @param[in]      instID          AddInstance() で取得したジオメトリ番号です.
+    //! @param[in]      transform       オブジェクト空間からワールド空間への変換行列です.
+    //! @retval true    変更に成功. 次の Commit() で反映します.
+    //! @retval false   インスタンスではない.
+    //! @note       時間ステップを持つインスタンスは, 全時刻でこの行列を使うようになります.
+    //-------------------------------------------------------------------------
+    virtual bool SetInstanceTransform(uint32_t instID, const asdx::Matrix& transform) = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      追加したジオメトリから加速構造を構築します.
+    //!
+    //! @retval true    構築に成功.
+    //! @retval false   構築に失敗.
+    //! @note       2回目以降は変更のあったジオメトリだけを更新します.
+    //!             変形量が RebuildThreshold 未満なら境界だけ更新(リフィット)し, 超えたものは
+    //!             変形の大きい順に RebuildBudgetMsec に収まる分だけ再構築します.
+    //-------------------------------------------------------------------------
+    virtual bool Commit() = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      構築済みの組み込みBVHを設定します.
+    //!
+    //! @param[in]      view        構築済みのデータです(追加したジオメトリと同じ順序で構築したもの).
+    //! @retval true    設定に成功. 次の Commit() は構築を省略します.
+    //! @retval false   このバックエンドでは利用できないか, データが不正.
+    //! @note       参照先は Term() を呼ぶまで解放しないでください.
+    //-------------------------------------------------------------------------
+    virtual bool AttachBVH(const BVH::View& view)
+    {
+        (void)view;
+        return false;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      構築済みの組み込みBVHを取得します.
+    //!
+    //! @param[out]     view        構築済みのデータです.
+    //! @retval true    取得に成功.
+    //! @retval false   このバックエンドでは利用できないか, 未構築.
+    //-------------------------------------------------------------------------
+    virtual bool GetBVH(BVH::View& view) const
+    {
+        (void)view;
+        return false;
+    }
+
+#if SALTY2_USE_EMBREE
+    //-------------------------------------------------------------------------
+    //! @brief      Embree のデバイスを取得します.
+    //!
+    //! @return     Embree バックエンド以外では nullptr を返却します.
+    //-------------------------------------------------------------------------
+    virtual RTCDevice GetDevice() const
+    { return nullptr; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      Embree のシーンを取得します.
+    //!
+    //! @return     Embree バックエンド以外では nullptr を返却します.
+    //! @note       ジオメトリを直接追加した場合は Commit() を呼び出してください.
+    //-------------------------------------------------------------------------
+    virtual RTCScene GetScene() const
+    { return nullptr; }
+#endif//SALTY2_USE_EMBREE
+
+    //-------------------------------------------------------------------------
+    //! @brief      最近傍の交差を求めます.
+    //!
+    //! @param[in,out]  rayHit      レイと交差情報です. 交差した場合は tfar と hit を更新します.
+    //! @note       ray.time ([0, 1]) で時間ステップを持つジオメトリを補間します.
+    //-------------------------------------------------------------------------
+    virtual void Intersect1(RTCRayHit& rayHit) const = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      遮蔽されているかどうかチェックします.
+    //!
+    //! @param[in,out]  ray         レイです. 遮蔽されている場合は tfar を -inf にします.
+    //-------------------------------------------------------------------------
+    virtual void Occluded1(RTCRay& ray) const = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      バックエンドを取得します.
+    //-------------------------------------------------------------------------
+    virtual ACCEL_BACKEND GetBackend() const = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------
+    virtual AccelStats GetStats() const = 0;
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      加速構造を生成します.
+//!
+//! @param[in]      backend     バックエンドです.
+//! @return     生成した加速構造を返却します.
+//! @note       Embree が無効な場合は組み込みBVHを生成します.
+//-----------------------------------------------------------------------------
+std::unique_ptr<Accel> CreateAccel(ACCEL_BACKEND backend);
+
+//-----------------------------------------------------------------------------
+//! @brief      バックエンド名を取得します.
+//-----------------------------------------------------------------------------
+const char* GetAccelBackendName(ACCEL_BACKEND backend);
+
+//-----------------------------------------------------------------------------
+//! @brief      構築品質の名前を取得します.
+//-----------------------------------------------------------------------------
+const char* GetBuildQualityName(RTCBuildQuality quality);
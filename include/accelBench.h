@@ -0,0 +1,38 @@
+﻿//-----------------------------------------------------------------------------
+// File : accelBench.h
+// Desc : Acceleration Structure Benchmark.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <accel.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AccelBenchDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct AccelBenchDesc
+{
+    uint32_t    TriangleCount   = 1 << 20;  //!< 生成する三角形数の目安です.
+    uint32_t    RayCount        = 1 << 20;  //!< 1回の計測で追跡するレイ数です.
+    uint32_t    StrandCount     = 1 << 16;  //!< 曲線と三角形の管を比較する毛の数です. 0 なら比較しません.
+    uint32_t    LeafCount       = 1 << 16;  //!< 抜き型のある葉の数です. 0 ならアルファテストを計測しません.
+    const char* DeviceConfig    = nullptr;  //!< 全設定に共通するデバイス設定文字列です.
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      加速構造のベンチマークを実行します.
+//!
+//! @param[in]      desc        構成設定です.
+//! @retval true    全設定の計測に成功.
+//! @retval false   いずれかの設定で失敗.
+//! @note       利用可能なバックエンド, 構築品質, シーンフラグの組み合わせごとに
+//!             構築時間, 使用メモリ, 単一スレッドでの追跡性能をログに出力します.
+//!             続けて毛皮を曲線(平ら, 円形)と三角形の管で追加した場合の, 毛あたりのメモリと追跡性能を比較します.
+//!             最後に抜き型のある葉の茂みで, 走査中のフィルタ関数と透明な層ごとに辿り直す場合の追跡性能を比較します.
+//-----------------------------------------------------------------------------
+bool RunAccelBench(const AccelBenchDesc& desc);
@@ -0,0 +1,158 @@
+﻿//-----------------------------------------------------------------------------
+// File : alphaMask.h
+// Desc : Alpha Mask for Cutout Geometry.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <mesh.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AlphaMask class
+// 葉や柵の抜き型を1画素1bitで保持するマスクです.
+// 8x8 画素を1つの uint64_t に詰めるので, 近い画素の参照は同じキャッシュラインに収まります.
+// 走査中のアルファテストで参照するので, 参照は最近傍の1画素だけにしています.
+///////////////////////////////////////////////////////////////////////////////
+class AlphaMask
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static constexpr uint32_t TILE_SIZE = 8;    //!< 1タイル(64bit)の辺の画素数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    AlphaMask() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      width           画像の幅です.
+    //! @param[in]      height          画像の高さです.
+    //! @param[in]      alpha           先頭画素のアルファ値(8bit)へのポインタです.
+    //! @param[in]      pixelStride     画素の間隔(バイト)です. RGBA8 の画像なら 4 を指定します.
+    //! @param[in]      rowPitch        行の間隔(バイト)です. 0 なら width * pixelStride とします.
+    //! @param[in]      threshold       不透明とみなすアルファ値の下限です.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //! @note       RGBA8 の画像なら alpha に先頭画素のアルファ成分(先頭 + 3 バイト)を渡してください.
+    //-------------------------------------------------------------------------
+    bool Init(
+        uint32_t        width,
+        uint32_t        height,
+        const uint8_t*  alpha,
+        uint32_t        pixelStride = 1,
+        uint32_t        rowPitch    = 0,
+        uint8_t         threshold   = 128);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      テクスチャ座標の画素が不透明かどうかチェックします.
+    //!
+    //! @param[in]      u           テクスチャ座標(横)です.
+    //! @param[in]      v           テクスチャ座標(縦, 0 が画像の先頭行)です.
+    //! @retval true    不透明. 未初期化の場合も true を返却します.
+    //! @retval false   透明.
+    //! @note       [0, 1] の外は繰り返し(ラップ)で参照します.
+    //-------------------------------------------------------------------------
+    inline bool IsOpaque(float u, float v) const
+    {
+        if (m_Tiles.empty())
+        { return true; }
+
+        auto x = std::min(uint32_t((u - floorf(u)) * float(m_Width)),  m_Width  - 1);
+        auto y = std::min(uint32_t((v - floorf(v)) * float(m_Height)), m_Height - 1);
+
+        auto bits = m_Tiles[(y / TILE_SIZE) * m_TileCountX + (x / TILE_SIZE)];
+        return ((bits >> ((y % TILE_SIZE) * TILE_SIZE + (x % TILE_SIZE))) & 1) != 0;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      画像の幅を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetWidth() const
+    { return m_Width; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      画像の高さを取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetHeight() const
+    { return m_Height; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      不透明な画素の割合を取得します.
+    //-------------------------------------------------------------------------
+    inline float GetCoverage() const
+    { return m_Coverage; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      使用メモリ(バイト)を取得します.
+    //-------------------------------------------------------------------------
+    inline size_t GetMemorySize() const
+    { return m_Tiles.size() * sizeof(uint64_t); }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<uint64_t>   m_Tiles;                // 8x8 画素ごとの不透明ビットです(行優先).
+    uint32_t                m_Width         = 0;
+    uint32_t                m_Height        = 0;
+    uint32_t                m_TileCountX    = 0;
+    float                   m_Coverage      = 0.0f;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    AlphaMask            (const AlphaMask&) = delete;
+    AlphaMask& operator= (const AlphaMask&) = delete;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AlphaTestSource structure
+// AlphaTest() に渡すメッシュとマスクの組です.
+///////////////////////////////////////////////////////////////////////////////
+struct AlphaTestSource
+{
+    const Mesh*         pMesh;      //!< テクスチャ座標を持つメッシュです.
+    const AlphaMask*    pMask;      //!< 抜き型のマスクです.
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      交差位置のアルファテストを行います.
+//!
+//! @param[in]      userPtr     AlphaTestSource へのポインタです.
+//! @param[in]      primID      三角形番号です.
+//! @param[in]      u           重心座標です.
+//! @param[in]      v           重心座標です.
+//! @retval true    不透明なので交差を受け入れる.
+//! @retval false   透明なので交差を棄却する.
+//! @note       Accel::SetHitFilter() に渡す判定関数です(BVH::FilterFunc).
+//!             量子化したテクスチャ座標だけを復元してマスクを参照します.
+//-----------------------------------------------------------------------------
+bool AlphaTest(const void* userPtr, uint32_t primID, float u, float v);
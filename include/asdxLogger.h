@@ -22,6 +22,25 @@ namespace asdx {
 #define ASDX_WIDE( _string )        __ASDX_WIDE( _string )
 #endif//ASDX_WIDE
 
+// ログ書式で char* 文字列を受ける変換指定子です. "path = %" ASDX_PRIs のように使います.
+// MSVC の UNICODE ビルドはワイド書式になるので h で char* を明示し, それ以外は標準の s にします.
+#ifndef ASDX_PRIs
+  #if defined(_MSC_VER)
+    #define ASDX_PRIs               "hs"
+  #else
+    #define ASDX_PRIs               "s"
+  #endif
+#endif//ASDX_PRIs
+
+// GCC/Clang で WriteA() の書式と引数の不一致を検出します.
+#ifndef ASDX_CHECK_FORMAT
+  #if defined(__GNUC__)
+    #define ASDX_CHECK_FORMAT( _format, _args )     __attribute__(( format( printf, _format, _args ) ))
+  #else
+    #define ASDX_CHECK_FORMAT( _format, _args )
+  #endif
+#endif//ASDX_CHECK_FORMAT
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // LOG_LEVEL enum
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -46,7 +65,7 @@ struct ILogger
     //! @param[in]      level       ログレベルです.
     //! @param[in]      format      フォーマットです.
     //---------------------------------------------------------------------------------------------
-    virtual void WriteA(LOG_LEVEL level, const char* format, ... ) = 0;
+    virtual void WriteA(LOG_LEVEL level, const char* format, ... ) ASDX_CHECK_FORMAT(3, 4) = 0;
 
     //---------------------------------------------------------------------------------------------
     //! @brief      ログを出力します.
@@ -105,7 +124,7 @@ public:
     //! @param[in]      level       ログレベルです.
     //! @param[in]      format      フォーマットです.
     //---------------------------------------------------------------------------------------------
-    void WriteA(LOG_LEVEL level, const char* format, ... ) override;
+    void WriteA(LOG_LEVEL level, const char* format, ... ) override ASDX_CHECK_FORMAT(3, 4);
 
     //---------------------------------------------------------------------------------------------
     //! @brief      ログを出力します.
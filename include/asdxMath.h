@@ -16,6 +16,35 @@
 #include <cstring>
 #include <climits>
 
+//-----------------------------------------------------------------------------
+// SIMD Configuration
+//-----------------------------------------------------------------------------
+// ASDX_ENABLE_SIMD を定義するか /arch:AVX 以上でコンパイルした場合に
+// SSE4.1 実装が有効になります. AVX2 が有効な場合は FMA と 256bit 演算を使用します.
+// F16C / AVX-512F が有効な場合は半精度浮動小数の一括変換に使用します.
+// ASDX_DISABLE_SIMD を定義するとスカラー実装を強制します.
+#if !defined(ASDX_DISABLE_SIMD) && (defined(ASDX_ENABLE_SIMD) || defined(__SSE4_1__) || defined(__AVX__))
+    #ifndef ASDX_SIMD
+    #define ASDX_SIMD       1
+    #endif//ASDX_SIMD
+    #if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+        #ifndef ASDX_SIMD_AVX2
+        #define ASDX_SIMD_AVX2  1
+        #endif//ASDX_SIMD_AVX2
+    #endif
+    #if defined(__F16C__) || (defined(ASDX_SIMD_AVX2) && defined(_MSC_VER) && !defined(__clang__))
+        #ifndef ASDX_SIMD_F16C
+        #define ASDX_SIMD_F16C  1
+        #endif//ASDX_SIMD_F16C
+    #endif
+    #if defined(__AVX512F__)
+        #ifndef ASDX_SIMD_AVX512
+        #define ASDX_SIMD_AVX512    1
+        #endif//ASDX_SIMD_AVX512
+    #endif
+    #include <immintrin.h>
+#endif
+
 
 namespace asdx {
 
@@ -27,6 +56,8 @@ struct Vector3;
 struct Vector4;
 struct Matrix;
 struct Quaternion;
+struct Ray;
+struct AABB;
 
 //-----------------------------------------------------------------------------
 // Type defines.
@@ -100,7 +131,7 @@ constexpr double     ToDegree( double radian ) noexcept;
 //! @param [in]     value       判定する値.
 //! @return     値がゼロであるとみなせる場合にtrueを返却します.
 //-----------------------------------------------------------------------------
-bool    IsZero( float value ) noexcept;
+constexpr bool    IsZero( float value ) noexcept;
 
 //-----------------------------------------------------------------------------
 //! @brief      値がゼロであるかどうか判定します.
@@ -108,7 +139,7 @@ bool    IsZero( float value ) noexcept;
 //! @param [in]     value       判定する値.
 //! @return     値がゼロであるとみなせる場合にtrueを返却します.
 //-----------------------------------------------------------------------------
-bool    IsZero( double value ) noexcept;
+constexpr bool    IsZero( double value ) noexcept;
 
 //-----------------------------------------------------------------------------
 //! @brief      値が等価であるか判定します.
@@ -117,7 +148,7 @@ bool    IsZero( double value ) noexcept;
 //! @param [in]     b           判定する値.
 //! @return     値が等価であるとみなせる場合にtrueを返却します.
 //-----------------------------------------------------------------------------
-bool    IsEqual( float a, float b ) noexcept;
+constexpr bool    IsEqual( float a, float b ) noexcept;
 
 //-----------------------------------------------------------------------------
 //! @brief      値が等価であるか判定します.
@@ -126,7 +157,7 @@ bool    IsEqual( float a, float b ) noexcept;
 //! @param [in]     b           判定する値.
 //! @return     値が等価であるとみなせる場合にtrueを返却します.
 //-----------------------------------------------------------------------------
-bool    IsEqual( double a, double b ) noexcept;
+constexpr bool    IsEqual( double a, double b ) noexcept;
 
 //-----------------------------------------------------------------------------
 //! @brief      非数であるか判定します.
@@ -270,6 +301,26 @@ half     ToHalf( float value );
 //-----------------------------------------------------------------------------
 float     ToFloat( half value );
 
+//-----------------------------------------------------------------------------
+//! @brief      float型配列をhalf型配列に一括変換します.
+//!
+//! @param [in]     values      half型に変換する値の配列.
+//! @param [out]    results     変換結果の格納先.
+//! @param [in]     count       要素数.
+//! @note       結果は ToHalf() とビット単位で一致します.
+//-----------------------------------------------------------------------------
+void     ToHalf( const float* values, half* results, size_t count );
+
+//-----------------------------------------------------------------------------
+//! @brief      half型配列をfloat型配列に一括変換します.
+//!
+//! @param [in]     values      float型に変換する値の配列.
+//! @param [out]    results     変換結果の格納先.
+//! @param [in]     count       要素数.
+//! @note       結果は ToFloat() とビット単位で一致します.
+//-----------------------------------------------------------------------------
+void     ToFloat( const half* values, float* results, size_t count );
+
 //-----------------------------------------------------------------------------
 //! @brief      線形補間を行います.
 //!
@@ -361,7 +412,7 @@ struct Vector2
     //! @param [in]     value       乗算されるベクトル.
     //! @return     乗算結果を返却します.
     //-------------------------------------------------------------------------
-    friend Vector2   operator*   ( float, const Vector2& );
+    friend constexpr Vector2   operator*   ( float, const Vector2& );
 
 public:
     //=========================================================================
@@ -392,7 +443,14 @@ public:
     //! @param [in]     nx           X成分.
     //! @param [in]     ny           Y成分.
     //-------------------------------------------------------------------------
-    Vector2( float nx, float ny );
+    constexpr Vector2( float nx, float ny );
+
+    //-------------------------------------------------------------------------
+    //! @brief      コピーコンストラクタです.
+    //!
+    //! @param [in]     value       複製元の値.
+    //-------------------------------------------------------------------------
+    constexpr Vector2( const Vector2& ) = default;
 
     //-------------------------------------------------------------------------
     //! @brief      float*型への演算子です.
@@ -414,7 +472,7 @@ public:
     //! @param [in]     value       加算する値.
     //! @return     加算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector2&         operator += ( const Vector2& );
+    constexpr Vector2&         operator += ( const Vector2& );
 
     //-------------------------------------------------------------------------
     //! @brief      減算代入演算子です.
@@ -422,7 +480,7 @@ public:
     //! @param [in]     value       減算する値.
     //! @return     減算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector2&         operator -= ( const Vector2& );
+    constexpr Vector2&         operator -= ( const Vector2& );
 
     //-------------------------------------------------------------------------
     //! @brief      乗算代入演算子です.
@@ -430,7 +488,7 @@ public:
     //! @param [in]     scalar      乗算するスカラー値.
     //! @return     乗算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector2&         operator *= ( float );
+    constexpr Vector2&         operator *= ( float );
 
     //-------------------------------------------------------------------------
     //! @brief      除算代入演算子です.
@@ -438,7 +496,7 @@ public:
     //! @param [in]     scalar      除算するスカラー値.
     //! @return     除算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector2&         operator /= ( float );
+    constexpr Vector2&         operator /= ( float );
 
     //-------------------------------------------------------------------------
     //! @brief      代入演算子です.
@@ -446,21 +504,21 @@ public:
     //! @param [in]     value       代入する値.
     //! @return     代入結果を返却します.
     //-------------------------------------------------------------------------
-    Vector2&         operator =  ( const Vector2& );
+    constexpr Vector2&         operator =  ( const Vector2& );
 
     //-------------------------------------------------------------------------
     //! @brief      正符号演算子です.
     //!
     //! @return     自分自身の値を返却します.
     //-------------------------------------------------------------------------
-    Vector2          operator +  () const;
+    constexpr Vector2          operator +  () const;
 
     //-------------------------------------------------------------------------
     //! @brief      負符号演算子です.
     //!
     //! @return     負符号を付けた値を返却します.
     //-------------------------------------------------------------------------
-    Vector2          operator -  () const;
+    constexpr Vector2          operator -  () const;
 
     //-------------------------------------------------------------------------
     //! @brief      加算演算子です.
@@ -468,7 +526,7 @@ public:
     //! @param [in]     value       加算する値.
     //! @return     加算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector2          operator +  ( const Vector2& ) const;
+    constexpr Vector2          operator +  ( const Vector2& ) const;
 
     //-------------------------------------------------------------------------
     //! @brief      減算演算子です.
@@ -476,7 +534,7 @@ public:
     //! @param [in]     value       減算する値.
     //! @return     減算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector2          operator -  ( const Vector2& ) const;
+    constexpr Vector2          operator -  ( const Vector2& ) const;
 
     //-------------------------------------------------------------------------
     //! @brief      乗算演算子です.
@@ -484,7 +542,7 @@ public:
     //! @param [in]     scalar      乗算するスカラー値.
     //! @return     乗算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector2          operator *  ( float ) const;
+    constexpr Vector2          operator *  ( float ) const;
 
     //-------------------------------------------------------------------------
     //! @brief      除算演算子です.
@@ -492,7 +550,7 @@ public:
     //! @param [in]     scalar      除算するスカラー値.
     //! @return     除算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector2          operator /  ( float ) const;
+    constexpr Vector2          operator /  ( float ) const;
 
     //-------------------------------------------------------------------------
     //! @brief      等価比較演算子です.
@@ -522,7 +580,7 @@ public:
     //!
     //! @return     ベクトルの長さの2乗値を返却します.
     //-------------------------------------------------------------------------
-    float             LengthSq        () const;
+    constexpr float             LengthSq        () const;
 
     //-------------------------------------------------------------------------
     //! @brief      ベクトルを正規化します.
@@ -635,7 +693,7 @@ public:
     //! @param [in]     b           入力ベクトル.
     //! @return     ベクトルの内積を返却します.
     //-------------------------------------------------------------------------
-    static float     Dot( const Vector2& a, const Vector2& b );
+    static constexpr float     Dot( const Vector2& a, const Vector2& b );
 
     //-------------------------------------------------------------------------
     //! @brief      ベクトルの内積を求めます.
@@ -706,7 +764,7 @@ public:
     //! @param [in]     b           比較する値.
     //! @return     各成分の最小値を求め，その結果を返却します.
     //-------------------------------------------------------------------------
-    static Vector2 Min( const Vector2& a, const Vector2& b );
+    static constexpr Vector2 Min( const Vector2& a, const Vector2& b );
 
     //-------------------------------------------------------------------------
     //! @brief      各成分の最小値を求めます.
@@ -724,7 +782,7 @@ public:
     //! @param [in]     b           比較する値.
     //! @return     各成分の最大値を求め，その結果を返却します.
     //-------------------------------------------------------------------------
-    static Vector2 Max( const Vector2& a, const Vector2& b );
+    static constexpr Vector2 Max( const Vector2& a, const Vector2& b );
 
     //-------------------------------------------------------------------------
     //! @brief      各成分の最大値を求めます.
@@ -742,7 +800,7 @@ public:
     //! @param [in]     n           法線ベクトル.
     //! @return     反射ベクトルを返却します.
     //-------------------------------------------------------------------------
-    static Vector2 Reflect( const Vector2& i, const Vector2& n );
+    static constexpr Vector2 Reflect( const Vector2& i, const Vector2& n );
 
     //-------------------------------------------------------------------------
     //! @brief      指定された法線を持つ表面の入射ベクトルから，反射ベクトルを求めます.
@@ -853,7 +911,7 @@ public:
     //! @param [in]     amount      重み(0～1の値範囲で指定).
     //! @return     線形補間の結果を返却します.
     //-------------------------------------------------------------------------
-    static Vector2 Lerp( const Vector2& a, const Vector2& b, float amount );
+    static constexpr Vector2 Lerp( const Vector2& a, const Vector2& b, float amount );
 
     //-------------------------------------------------------------------------
     //! @brief      線形補間を行います.
@@ -892,7 +950,7 @@ public:
     //! @param [in]     matrix      変換行列.
     //! @return     変換されたベクトルを返却します.
     //-------------------------------------------------------------------------
-    static Vector2 Transform( const Vector2& position, const Matrix& matrix );
+    static constexpr Vector2 Transform( const Vector2& position, const Matrix& matrix );
 
     //-------------------------------------------------------------------------
     //! @brief      指定された行列を用いて，ベクトルを変換します.
@@ -910,7 +968,7 @@ public:
     //! @param [in]     matrix      変換行列.
     //! @return     変換された法線ベクトル.
     //-------------------------------------------------------------------------
-    static Vector2 TransformNormal( const Vector2& normal, const Matrix& matrix );
+    static constexpr Vector2 TransformNormal( const Vector2& normal, const Matrix& matrix );
 
     //-------------------------------------------------------------------------
     //! @brief      指定された行列を用いて，法線ベクトルを変換します.
@@ -958,7 +1016,7 @@ struct Vector3
     //! @param [in]     value       乗算されるベクトル.
     //! @return     乗算結果を返却します.
     //-------------------------------------------------------------------------
-    friend Vector3   operator *  ( float, const Vector3& );
+    friend constexpr Vector3   operator *  ( float, const Vector3& );
 
 public:
     //=========================================================================
@@ -990,7 +1048,7 @@ public:
     //! @param [in]     value       2次元ベクトル.
     //! @param [in]     nz          Z成分.
     //-------------------------------------------------------------------------
-    Vector3( const Vector2& value, float nz );
+    constexpr Vector3( const Vector2& value, float nz );
 
     //-------------------------------------------------------------------------
     //! @brief      引数付きコンストラクタです.
@@ -999,7 +1057,14 @@ public:
     //! @param [in]     ny           Y成分.
     //! @param [in]     nz           Z成分.
     //-------------------------------------------------------------------------
-    Vector3( float nx, float ny, float nz );
+    constexpr Vector3( float nx, float ny, float nz );
+
+    //-------------------------------------------------------------------------
+    //! @brief      コピーコンストラクタです.
+    //!
+    //! @param [in]     value       複製元の値.
+    //-------------------------------------------------------------------------
+    constexpr Vector3( const Vector3& ) = default;
 
     //-------------------------------------------------------------------------
     //! @brief      float*型への演算子です.
@@ -1021,7 +1086,7 @@ public:
     //! @param [in]     value       加算する値.
     //! @return     加算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector3&         operator += ( const Vector3& );
+    constexpr Vector3&         operator += ( const Vector3& );
 
     //-------------------------------------------------------------------------
     //! @brief      減算代入演算子です.
@@ -1029,7 +1094,7 @@ public:
     //! @param [in]     value       減算する値.
     //! @return     減算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector3&         operator -= ( const Vector3& );
+    constexpr Vector3&         operator -= ( const Vector3& );
 
     //-------------------------------------------------------------------------
     //! @brief      乗算代入演算子です.
@@ -1037,7 +1102,7 @@ public:
     //! @param [in]     scalar      乗算するスカラー値.
     //! @return     乗算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector3&         operator *= ( float );
+    constexpr Vector3&         operator *= ( float );
 
     //-------------------------------------------------------------------------
     //! @brief      除算代入演算子です.
@@ -1045,7 +1110,7 @@ public:
     //! @param [in]     scalar      除算するスカラー値.
     //! @return     除算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector3&         operator /= ( float );
+    constexpr Vector3&         operator /= ( float );
 
     //-------------------------------------------------------------------------
     //! @brief      代入演算子です.
@@ -1053,21 +1118,21 @@ public:
     //! @param [in]     value       代入する値.
     //! @return     代入結果を返却します.
     //-------------------------------------------------------------------------
-    Vector3&         operator =  ( const Vector3& );
+    constexpr Vector3&         operator =  ( const Vector3& );
 
     //-------------------------------------------------------------------------
     //! @brief      正符号演算子です.
     //!
     //! @return     自分自身の値を返却します.
     //-------------------------------------------------------------------------
-    Vector3          operator +  () const;
+    constexpr Vector3          operator +  () const;
 
     //-------------------------------------------------------------------------
     //! @brief      負符号演算子です.
     //!
     //! @return     負符号を付けた値を返却します.
     //-------------------------------------------------------------------------
-    Vector3          operator -  () const;
+    constexpr Vector3          operator -  () const;
 
     //-------------------------------------------------------------------------
     //! @brief      加算演算子です.
@@ -1075,7 +1140,7 @@ public:
     //! @param [in]     value       加算する値.
     //! @return     加算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector3          operator +  ( const Vector3& ) const;
+    constexpr Vector3          operator +  ( const Vector3& ) const;
 
     //-------------------------------------------------------------------------
     //! @brief      減算演算子です.
@@ -1083,7 +1148,7 @@ public:
     //! @param [in]     value       減算する値.
     //! @return     減算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector3          operator -  ( const Vector3& ) const;
+    constexpr Vector3          operator -  ( const Vector3& ) const;
 
     //-------------------------------------------------------------------------
     //! @brief      乗算演算子です.
@@ -1091,7 +1156,7 @@ public:
     //! @param [in]     scalar      乗算するスカラー値.
     //! @return     乗算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector3          operator *  ( float ) const;
+    constexpr Vector3          operator *  ( float ) const;
 
     //-------------------------------------------------------------------------
     //! @brief      除算演算子です.
@@ -1099,7 +1164,7 @@ public:
     //! @param [in]     scalar      除算するスカラー値.
     //! @return     除算結果を返却します.
     //-------------------------------------------------------------------------
-    Vector3          operator /  ( float ) const;
+    constexpr Vector3          operator /  ( float ) const;
 
     //-------------------------------------------------------------------------
     //! @brief      等価比較演算子です.
@@ -1129,7 +1194,7 @@ public:
     //!
     //! @return     ベクトルの長さの2乗値を返却します.
     //-------------------------------------------------------------------------
-    float             LengthSq        () const;
+    constexpr float             LengthSq        () const;
 
     //-------------------------------------------------------------------------
     //! @brief      ベクトルを正規化します.
@@ -1242,7 +1307,7 @@ public:
     //! @param [in]     b           入力ベクトル.
     //! @return     ベクトルの内積を返却します.
     //-------------------------------------------------------------------------
-    static float     Dot( const Vector3& a, const Vector3& b );
+    static constexpr float     Dot( const Vector3& a, const Vector3& b );
 
     //-------------------------------------------------------------------------
     //! @brief      ベクトルの内積を求めます.
@@ -1260,7 +1325,7 @@ public:
     //! @param [in]     b           入力ベクトル.
     //! @return     ベクトルの外積を返却します.
     //-------------------------------------------------------------------------
-    static Vector3 Cross( const Vector3& a, const Vector3& b );
+    static constexpr Vector3 Cross( const Vector3& a, const Vector3& b );
 
     //-------------------------------------------------------------------------
     //! @brief      ベクトルの外積を求めます.
@@ -1373,7 +1438,7 @@ public:
     //! @param [in]     b           比較する値.
     //! @return     各成分の最小値を求め，その結果を返却します.
     //-------------------------------------------------------------------------
-    static Vector3 Min( const Vector3& a, const Vector3& b );
+    static constexpr Vector3 Min( const Vector3& a, const Vector3& b );
 
     //-------------------------------------------------------------------------
     //! @brief      各成分の最小値を求めます.
@@ -1391,7 +1456,7 @@ public:
     //! @param [in]     b           比較する値.
     //! @return     各成分の最大値を求め，その結果を返却します.
     //-------------------------------------------------------------------------
-    static Vector3 Max( const Vector3& a, const Vector3& b );
+    static constexpr Vector3 Max( const Vector3& a, const Vector3& b );
 
     //-------------------------------------------------------------------------
     //! @brief      各成分の最大値を求めます.
@@ -1409,7 +1474,7 @@ public:
     //! @param [in]     n           法線ベクトル.
     //! @return     反射ベクトルを返却します.
     //-------------------------------------------------------------------------
-    static Vector3 Reflect( const Vector3& i, const Vector3& n );
+    static constexpr Vector3 Reflect( const Vector3& i, const Vector3& n );
 
     //-------------------------------------------------------------------------
     //! @brief      指定された法線を持つ表面の入射ベクトルから，反射ベクトルを求めます.
@@ -1520,7 +1585,7 @@ public:
     //! @param [in]     amount      重み(0～1の値範囲で指定).
     //! @return     線形補間の結果を返却します.
     //-------------------------------------------------------------------------
-    static Vector3 Lerp( const Vector3& a, const Vector3& b, float amount );
+    static constexpr Vector3 Lerp( const Vector3& a, const Vector3& b, float amount );
 
     //-------------------------------------------------------------------------
     //! @brief      線形補間を行います.
@@ -1559,7 +1624,7 @@ public:
     //! @param [in]     matrix      変換行列.
     //! @return     変換されたベクトルを返却します.
     //-------------------------------------------------------------------------
-    static Vector3 Transform( const Vector3& position, const Matrix& matrix );
+    static constexpr Vector3 Transform( const Vector3& position, const Matrix& matrix );
 
     //-------------------------------------------------------------------------
     //! @brief      指定された行列を用いて，ベクトルを変換します.
@@ -1577,7 +1642,7 @@ public:
     //! @param [in]     matrix      変換行列.
     //! @return     変換された法線ベクトル.
     //-------------------------------------------------------------------------
-    static Vector3 TransformNormal( const Vector3& normal, const Matrix& matrix );
+    static constexpr Vector3 TransformNormal( const Vector3& normal, const Matrix& matrix );
 
     //-------------------------------------------------------------------------
     //! @brief      指定された行列を用いて，法線ベクトルを変換します.
@@ -1734,7 +1799,7 @@ public:
     //! @param [in]     nz          Z成分.
     //! @param [in]     nw          W成分.
     //-------------------------------------------------------------------------
-    Vector4( const Vector2& value, float nz, float nw );
+    constexpr Vector4( const Vector2& value, float nz, float nw );
 
     //-------------------------------------------------------------------------
     //! @brief      引数付きコンストラクタです.
@@ -1742,7 +1807,7 @@ public:
     //! @param [in]     value       3次元ベクトル.
     //! @param [in]     nw          W成分.
     //-------------------------------------------------------------------------
-    Vector4( const Vector3& value, float nw );
+    constexpr Vector4( const Vector3& value, float nw );
 
     //-------------------------------------------------------------------------
     //! @brief      引数付きコンストラクタです.
@@ -1752,7 +1817,14 @@ public:
     //! @param [in]     nz           Z成分.
     //! @param [in]     nw           W成分.
     //-------------------------------------------------------------------------
-    Vector4( float nx, float ny, float nz, float nw );
+    constexpr Vector4( float nx, float ny, float nz, float nw );
+
+    //-------------------------------------------------------------------------
+    //! @brief      コピーコンストラクタです.
+    //!
+    //! @param [in]     value       複製元の値.
+    //-------------------------------------------------------------------------
+    constexpr Vector4( const Vector4& ) = default;
 
     //-------------------------------------------------------------------------
     //! @brief      float*型への演算子です.
@@ -2299,12 +2371,19 @@ public:
     //! @param [in]     m43         4行3列の値.
     //! @param [in]     m44         4行4列の値.
     //-------------------------------------------------------------------------
-    explicit Matrix (
+    constexpr explicit Matrix (
         float m11, float m12, float m13, float m14,
         float m21, float m22, float m23, float m24,
         float m31, float m32, float m33, float m34,
         float m41, float m42, float m43, float m44 );
 
+    //-------------------------------------------------------------------------
+    //! @brief      コピーコンストラクタです.
+    //!
+    //! @param [in]     value       複製元の値.
+    //-------------------------------------------------------------------------
+    constexpr Matrix( const Matrix& ) = default;
+
     //---------------------------------------------------------------------------------------------
     //! @brief      引数付きコンストラクタです.
     //!
@@ -2313,7 +2392,7 @@ public:
     //! @param[in]      v2      3行目の値です.
     //! @param[in]      v3      4行目の値です.
     //---------------------------------------------------------------------------------------------
-    explicit Matrix( const Vector4& v1, const Vector4& v2, const Vector4& v3, const Vector4& v4 );
+    constexpr explicit Matrix( const Vector4& v1, const Vector4& v2, const Vector4& v3, const Vector4& v4 );
 
     //-------------------------------------------------------------------------
     //! @brief      インデクサです.
@@ -2485,7 +2564,7 @@ public:
     //!
     //! @return     単位行列を返却します.
     //-------------------------------------------------------------------------
-    static Matrix   CreateIdentity();
+    static constexpr Matrix   CreateIdentity();
 
     //-------------------------------------------------------------------------
     //! @brief      単位行列であるか判定します.
@@ -2581,6 +2660,56 @@ public:
     //-------------------------------------------------------------------------
     static void    Invert( const Matrix& value, Matrix &result );
 
+    //-------------------------------------------------------------------------
+    //! @brief      アフィン変換行列の逆行列を求めます.
+    //!
+    //! @param [in]     value       逆行列を求める値(4列目が(0, 0, 0, 1)であること).
+    //! @return     逆行列を返却します.
+    //-------------------------------------------------------------------------
+    static Matrix  InvertAffine( const Matrix& value );
+
+    //-------------------------------------------------------------------------
+    //! @brief      アフィン変換行列の逆行列を求めます.
+    //!
+    //! @param [in]     value       逆行列を求める値(4列目が(0, 0, 0, 1)であること).
+    //! @param [out]    result      逆行列.
+    //-------------------------------------------------------------------------
+    static void    InvertAffine( const Matrix& value, Matrix &result );
+
+    //-------------------------------------------------------------------------
+    //! @brief      アフィン変換行列の逆行列をまとめて求めます.
+    //!
+    //! @param [in]     values      逆行列を求める値の配列.
+    //! @param [out]    results     逆行列の格納先(values と同一でも構いません).
+    //! @param [in]     count       行列数.
+    //-------------------------------------------------------------------------
+    static void    InvertAffine( const Matrix* values, Matrix* results, size_t count );
+
+    //-------------------------------------------------------------------------
+    //! @brief      剛体変換(回転+平行移動)行列の逆行列を求めます.
+    //!
+    //! @param [in]     value       逆行列を求める値.
+    //! @return     逆行列を返却します.
+    //-------------------------------------------------------------------------
+    static Matrix  InvertRigid( const Matrix& value );
+
+    //-------------------------------------------------------------------------
+    //! @brief      剛体変換(回転+平行移動)行列の逆行列を求めます.
+    //!
+    //! @param [in]     value       逆行列を求める値.
+    //! @param [out]    result      逆行列.
+    //-------------------------------------------------------------------------
+    static void    InvertRigid( const Matrix& value, Matrix &result );
+
+    //-------------------------------------------------------------------------
+    //! @brief      剛体変換(回転+平行移動)行列の逆行列をまとめて求めます.
+    //!
+    //! @param [in]     values      逆行列を求める値の配列.
+    //! @param [out]    results     逆行列の格納先(values と同一でも構いません).
+    //! @param [in]     count       行列数.
+    //-------------------------------------------------------------------------
+    static void    InvertRigid( const Matrix* values, Matrix* results, size_t count );
+
     //-------------------------------------------------------------------------
     //! @brief      拡大縮小行列を生成します.
     //!
@@ -3181,7 +3310,7 @@ public:
     //! @param [in]     nz          Z成分.
     //! @param [in]     nw          W成分.
     //-------------------------------------------------------------------------
-    Quaternion( float nx, float ny, float nz, float nw );
+    constexpr Quaternion( float nx, float ny, float nz, float nw );
 
     //-------------------------------------------------------------------------
     //! @brief      float*型へのキャストです.
@@ -3350,7 +3479,7 @@ public:
     //!
     //! @return     単位四元数を返却します.
     //-------------------------------------------------------------------------
-    static Quaternion   CreateIdentity();
+    static constexpr Quaternion   CreateIdentity();
 
     //-------------------------------------------------------------------------
     //! @brief      単位四元数かどうかチェックします.
@@ -3572,6 +3701,198 @@ public:
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Ray structure
+///////////////////////////////////////////////////////////////////////////////
+struct Ray
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables
+    //=========================================================================
+    Vector3 pos;        //!< 原点です.
+    float   tmin;       //!< 交差区間の最小値です.
+    Vector3 dir;        //!< 方向ベクトルです(正規化されていなくても構いません).
+    float   tmax;       //!< 交差区間の最大値です.
+
+    //=========================================================================
+    // public methods
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    Ray();
+
+    //-------------------------------------------------------------------------
+    //! @brief      引数付きコンストラクタです.
+    //!
+    //! @param [in]     position    原点.
+    //! @param [in]     direction   方向ベクトル.
+    //! @param [in]     nearClip    交差区間の最小値.
+    //! @param [in]     farClip     交差区間の最大値.
+    //-------------------------------------------------------------------------
+    Ray( const Vector3& position, const Vector3& direction, float nearClip = 0.0f, float farClip = FLT_MAX );
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定距離の位置を求めます.
+    //!
+    //! @param [in]     t           距離.
+    //! @return     pos + dir * t を返却します.
+    //-------------------------------------------------------------------------
+    Vector3 GetPoint( float t ) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      方向ベクトルの逆数を求めます.
+    //!
+    //! @return     成分ごとの 1 / dir を返却します(0 の成分は符号付きの無限大になります).
+    //-------------------------------------------------------------------------
+    Vector3 GetInvDir() const;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AABB structure
+///////////////////////////////////////////////////////////////////////////////
+struct AABB
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables
+    //=========================================================================
+    Vector3 mini;       //!< 最小値です.
+    Vector3 maxi;       //!< 最大値です.
+
+    //=========================================================================
+    // public methods
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです(空のボックスで初期化します).
+    //-------------------------------------------------------------------------
+    AABB();
+
+    //-------------------------------------------------------------------------
+    //! @brief      引数付きコンストラクタです.
+    //!
+    //! @param [in]     minValue    最小値.
+    //! @param [in]     maxValue    最大値.
+    //-------------------------------------------------------------------------
+    AABB( const Vector3& minValue, const Vector3& maxValue );
+
+    //-------------------------------------------------------------------------
+    //! @brief      点を含むように拡張します.
+    //!
+    //! @param [in]     point       含める点.
+    //-------------------------------------------------------------------------
+    void Expand( const Vector3& point );
+
+    //-------------------------------------------------------------------------
+    //! @brief      ボックスを含むように拡張します.
+    //!
+    //! @param [in]     box         含めるボックス.
+    //-------------------------------------------------------------------------
+    void Merge( const AABB& box );
+
+    //-------------------------------------------------------------------------
+    //! @brief      空かどうかチェックします.
+    //!
+    //! @retval true    いずれかの軸で最小値が最大値より大きいです.
+    //! @retval false   空ではありません.
+    //-------------------------------------------------------------------------
+    bool IsEmpty() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      中心を求めます.
+    //-------------------------------------------------------------------------
+    Vector3 GetCenter() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      大きさ(最大値 - 最小値)を求めます.
+    //-------------------------------------------------------------------------
+    Vector3 GetExtent() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      表面積を求めます.
+    //-------------------------------------------------------------------------
+    float GetSurfaceArea() const;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AABBx4 structure
+// 4個のAABBをSoA形式で保持します.
+///////////////////////////////////////////////////////////////////////////////
+struct alignas(16) AABBx4
+{
+    float minX[4];      //!< 最小値のX成分です.
+    float minY[4];      //!< 最小値のY成分です.
+    float minZ[4];      //!< 最小値のZ成分です.
+    float maxX[4];      //!< 最大値のX成分です.
+    float maxY[4];      //!< 最大値のY成分です.
+    float maxZ[4];      //!< 最大値のZ成分です.
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定レーンにボックスを設定します.
+    //-------------------------------------------------------------------------
+    void Set( uint32_t lane, const AABB& box );
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trianglex4 structure
+// 4個の三角形をSoA形式で保持します.
+///////////////////////////////////////////////////////////////////////////////
+struct alignas(16) Trianglex4
+{
+    float v0x[4];       //!< 頂点0のX成分です.
+    float v0y[4];       //!< 頂点0のY成分です.
+    float v0z[4];       //!< 頂点0のZ成分です.
+    float v1x[4];       //!< 頂点1のX成分です.
+    float v1y[4];       //!< 頂点1のY成分です.
+    float v1z[4];       //!< 頂点1のZ成分です.
+    float v2x[4];       //!< 頂点2のX成分です.
+    float v2y[4];       //!< 頂点2のY成分です.
+    float v2z[4];       //!< 頂点2のZ成分です.
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定レーンに三角形を設定します.
+    //-------------------------------------------------------------------------
+    void Set( uint32_t lane, const Vector3& v0, const Vector3& v1, const Vector3& v2 );
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// WatertightRay structure
+// 水密な三角形判定用にレイを +Z 軸向きに剪断する係数です.
+// 同じレイで何度も判定する場合は一度だけ求めて使い回します.
+///////////////////////////////////////////////////////////////////////////////
+struct WatertightRay
+{
+    int     kx;     //!< 剪断後のX軸の成分番号です.
+    int     ky;     //!< 剪断後のY軸の成分番号です.
+    int     kz;     //!< 方向ベクトルの絶対値が最大の成分番号です.
+    float   sx;     //!< X軸の剪断係数です.
+    float   sy;     //!< Y軸の剪断係数です.
+    float   sz;     //!< Z軸の拡縮係数です.
+
+    //-------------------------------------------------------------------------
+    //! @brief      レイから剪断係数を求めます.
+    //-------------------------------------------------------------------------
+    explicit WatertightRay( const Ray& ray );
+};
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // XorShif class
 ///////////////////////////////////////////////////////////////////////////////
@@ -3580,7 +3901,7 @@ class XorShift
     //=========================================================================
     // list of friend classes and methods.
     //=========================================================================
-    /* NOTHING */
+    friend class XorShiftx8;
 
 public:
     //=========================================================================
@@ -3599,6 +3920,14 @@ public:
     //-------------------------------------------------------------------------
     XorShift( int seed );
 
+    //-------------------------------------------------------------------------
+    //! @brief      ストリーム番号付きコンストラクタです.
+    //!
+    //! @param [in]     seed        設定する種.
+    //! @param [in]     streamId    ストリーム番号(streamId * 2^64 だけ先に進めた数列になります).
+    //-------------------------------------------------------------------------
+    XorShift( int seed, uint64_t streamId );
+
     //-------------------------------------------------------------------------
     //! @brief      コピーコンストラクタです.
     //!
@@ -3618,6 +3947,26 @@ public:
     //-------------------------------------------------------------------------
     void SetSeed ( int seed );
 
+    //-------------------------------------------------------------------------
+    //! @brief      ランダム種とストリーム番号を設定します.
+    //!
+    //! @param [in]     seed        設定する種.
+    //! @param [in]     streamId    ストリーム番号.
+    //-------------------------------------------------------------------------
+    void SetSeed ( int seed, uint64_t streamId );
+
+    //-------------------------------------------------------------------------
+    //! @brief      数列を n 個先に進めます (O(log n)).
+    //!
+    //! @param [in]     n           進める数.
+    //-------------------------------------------------------------------------
+    void Advance ( uint64_t n );
+
+    //-------------------------------------------------------------------------
+    //! @brief      数列を 2^64 個先に進めます.
+    //-------------------------------------------------------------------------
+    void Jump    ();
+
     //-------------------------------------------------------------------------
     //! @brief      乱数をuint32_t型として取得します.
     //!
@@ -3732,10 +4081,16 @@ private:
     uint32_t     m_Z;            //!< 変数です.
     uint32_t     m_W;            //!< 変数です.
 
+    // 遷移行列の特性多項式 P(x) = x^128 + s_Poly と, ジャンプ多項式 x^(2^64) mod P(x) です.
+    static constexpr uint64_t s_Poly[2] = { 0xF985D65FFD3C8001ull, 0x000000010046D8B3ull };
+    static constexpr uint64_t s_Jump[2] = { 0x821E534335AAC71Cull, 0xD8CD644EF52E65C4ull };
+
     //=========================================================================
     // private methods
     //=========================================================================
-    /* NOTHING */
+    static void MulMod  ( const uint64_t* a, const uint64_t* b, uint64_t* result );
+    static void PowMod  ( const uint64_t* base, uint64_t exponent, uint64_t* result );
+    void        JumpPoly( const uint64_t* poly );
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -3746,7 +4101,7 @@ class PCG
     //=========================================================================
     // list of friend classes and methods.
     //=========================================================================
-    /* NOTHING */
+    friend class PCGx8;
 
 public:
     //=========================================================================
@@ -3765,6 +4120,14 @@ public:
     //-------------------------------------------------------------------------
     PCG( uint64_t seed );
 
+    //-------------------------------------------------------------------------
+    //! @brief      ストリーム番号付きコンストラクタです.
+    //!
+    //! @param [in]     seed        設定する種.
+    //! @param [in]     streamId    ストリーム番号(異なる番号は独立した数列になります).
+    //-------------------------------------------------------------------------
+    PCG( uint64_t seed, uint64_t streamId );
+
     //-------------------------------------------------------------------------
     //! @brief      コピーコンストラクタです.
     //!
@@ -3784,6 +4147,21 @@ public:
     //-------------------------------------------------------------------------
     void SetSeed( uint64_t seed );
 
+    //-------------------------------------------------------------------------
+    //! @brief      ランダム種とストリーム番号を設定します.
+    //!
+    //! @param [in]     seed        設定する種.
+    //! @param [in]     streamId    ストリーム番号.
+    //-------------------------------------------------------------------------
+    void SetSeed( uint64_t seed, uint64_t streamId );
+
+    //-------------------------------------------------------------------------
+    //! @brief      数列を n 個先に進めます (O(log n)).
+    //!
+    //! @param [in]     n           進める数.
+    //-------------------------------------------------------------------------
+    void Advance( uint64_t n );
+
     //-------------------------------------------------------------------------
     //! @brief      乱数をuint32_t型として取得します.
     //!
@@ -3896,6 +4274,7 @@ private:
     static const uint64_t s_Multiplier = 6364136223846793005u;
     static const uint64_t s_Increment  = 1442695040888963407u;
     uint64_t              m_State      = 0x4d595df4d0f33173;
+    uint64_t              m_Increment  = s_Increment;
 
     //=========================================================================
     // private methods
@@ -3912,13 +4291,42 @@ private:
 //-----------------------------------------------------------------------------
 void CalcONB(const Vector3& N, Vector3& T, Vector3& B);
 
+//-----------------------------------------------------------------------------
+//! @brief      底2の Radical Inverse (Van der Corput 列) を求めます.
+//!
+//! @param[in]      i               サンプリング番号.
+//-----------------------------------------------------------------------------
+constexpr float RadicalInverse2( uint32_t i );
+
+//-----------------------------------------------------------------------------
+//! @brief      任意の底の Radical Inverse を求めます.
+//!
+//! @param[in]      base            底.
+//! @param[in]      i               サンプリング番号.
+//-----------------------------------------------------------------------------
+constexpr float RadicalInverse( uint32_t base, uint32_t i );
+
 //-----------------------------------------------------------------------------
 //! @brief      Hammersleyサンプルを行います.
 //!
 //! @param[in]      i               サンプリング番号.
 //! @param[in]      numSamples      サンプル数.
 //-----------------------------------------------------------------------------
-Vector2 Hammersley( uint32_t i, uint32_t numSamples );
+constexpr Vector2 Hammersley( uint32_t i, uint32_t numSamples );
+
+//-----------------------------------------------------------------------------
+//! @brief      Haltonサンプル(底2, 3)を行います.
+//!
+//! @param[in]      i               サンプリング番号(0番目は原点になります).
+//-----------------------------------------------------------------------------
+constexpr Vector2 Halton23( uint32_t i );
+
+//-----------------------------------------------------------------------------
+//! @brief      R2列(加法的再帰列)によるサンプルを行います.
+//!
+//! @param[in]      i               サンプリング番号.
+//-----------------------------------------------------------------------------
+constexpr Vector2 R2( uint32_t i );
 
 //-----------------------------------------------------------------------------
 //! @brief      平面式を正規化します.
@@ -3954,6 +4362,98 @@ Vector3 ComputeIntersection(const Vector4& plane, const Vector3& orig, const Vec
 //-----------------------------------------------------------------------------
 void GetCorners(const Vector4* planes, Vector3* corners);
 
+//-----------------------------------------------------------------------------
+//! @brief      レイとAABBの交差判定を行います(スラブ法).
+//!
+//! @param[in]      ray         レイです.
+//! @param[in]      invDir      ray.GetInvDir() の値です.
+//! @param[in]      box         ボックスです.
+//! @param[out]     tnear       交差区間の開始距離です.
+//! @retval true    [ray.tmin, ray.tmax] の範囲で交差します.
+//! @retval false   交差しません.
+//! @note       浮動小数の誤差で見逃さないように遠方側を 1 + 2γ(3) 倍した保守的な判定です.
+//-----------------------------------------------------------------------------
+bool IntersectRayAABB(const Ray& ray, const Vector3& invDir, const AABB& box, float& tnear);
+
+//-----------------------------------------------------------------------------
+//! @brief      レイと4個のAABBの交差判定を行います.
+//!
+//! @param[in]      ray         レイです.
+//! @param[in]      invDir      ray.GetInvDir() の値です.
+//! @param[in]      boxes       ボックスです.
+//! @param[out]     tnear       レーンごとの交差区間の開始距離です(要素数4).
+//! @return     交差したレーンのビットマスクを返却します.
+//-----------------------------------------------------------------------------
+uint32_t IntersectRayAABB(const Ray& ray, const Vector3& invDir, const AABBx4& boxes, float* tnear);
+
+//-----------------------------------------------------------------------------
+//! @brief      レイと三角形の交差判定を行います(Moller-Trumbore法, 両面).
+//!
+//! @param[in]      ray         レイです.
+//! @param[in]      v0          頂点0です.
+//! @param[in]      v1          頂点1です.
+//! @param[in]      v2          頂点2です.
+//! @param[out]     t           交差距離です.
+//! @param[out]     u           頂点1の重心座標です.
+//! @param[out]     v           頂点2の重心座標です.
+//! @retval true    [ray.tmin, ray.tmax] の範囲で交差します.
+//! @retval false   交差しません.
+//-----------------------------------------------------------------------------
+bool IntersectRayTriangle(const Ray& ray, const Vector3& v0, const Vector3& v1, const Vector3& v2, float& t, float& u, float& v);
+
+//-----------------------------------------------------------------------------
+//! @brief      レイと4個の三角形の交差判定を行います(Moller-Trumbore法, 両面).
+//!
+//! @param[in]      ray         レイです.
+//! @param[in]      tris        三角形です.
+//! @param[out]     t           レーンごとの交差距離です(要素数4).
+//! @param[out]     u           レーンごとの頂点1の重心座標です(要素数4).
+//! @param[out]     v           レーンごとの頂点2の重心座標です(要素数4).
+//! @return     交差したレーンのビットマスクを返却します.
+//-----------------------------------------------------------------------------
+uint32_t IntersectRayTriangle(const Ray& ray, const Trianglex4& tris, float* t, float* u, float* v);
+
+//-----------------------------------------------------------------------------
+//! @brief      レイと三角形の交差判定を行います(Woop らの水密な判定, 両面).
+//!
+//! @param[in]      ray         レイです.
+//! @param[in]      v0          頂点0です.
+//! @param[in]      v1          頂点1です.
+//! @param[in]      v2          頂点2です.
+//! @param[out]     t           交差距離です.
+//! @param[out]     u           頂点1の重心座標です.
+//! @param[out]     v           頂点2の重心座標です.
+//! @retval true    [ray.tmin, ray.tmax] の範囲で交差します.
+//! @retval false   交差しません.
+//! @note       共有辺上の交差は隣接する三角形の両方で交差と判定されるため, 隙間から抜けることはありません.
+//-----------------------------------------------------------------------------
+bool IntersectRayTriangleWatertight(const Ray& ray, const Vector3& v0, const Vector3& v1, const Vector3& v2, float& t, float& u, float& v);
+
+//-----------------------------------------------------------------------------
+//! @brief      レイと4個の三角形の交差判定を行います(Woop らの水密な判定, 両面).
+//!
+//! @param[in]      ray         レイです.
+//! @param[in]      tris        三角形です.
+//! @param[out]     t           レーンごとの交差距離です(要素数4).
+//! @param[out]     u           レーンごとの頂点1の重心座標です(要素数4).
+//! @param[out]     v           レーンごとの頂点2の重心座標です(要素数4).
+//! @return     交差したレーンのビットマスクを返却します.
+//-----------------------------------------------------------------------------
+uint32_t IntersectRayTriangleWatertight(const Ray& ray, const Trianglex4& tris, float* t, float* u, float* v);
+
+//-----------------------------------------------------------------------------
+//! @brief      レイと4個の三角形の交差判定を行います(Woop らの水密な判定, 両面).
+//!
+//! @param[in]      ray         レイです.
+//! @param[in]      shear       ray から求めた剪断係数です.
+//! @param[in]      tris        三角形です.
+//! @param[out]     t           レーンごとの交差距離です(要素数4).
+//! @param[out]     u           レーンごとの頂点1の重心座標です(要素数4).
+//! @param[out]     v           レーンごとの頂点2の重心座標です(要素数4).
+//! @return     交差したレーンのビットマスクを返却します.
+//-----------------------------------------------------------------------------
+uint32_t IntersectRayTriangleWatertight(const Ray& ray, const WatertightRay& shear, const Trianglex4& tris, float* t, float* u, float* v);
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Half2 union
@@ -4039,6 +4539,60 @@ Half4 EncodeHalf4(const Vector4& value);
 //-----------------------------------------------------------------------------
 Vector4 DecodeHalf4(const Half4& value);
 
+//-----------------------------------------------------------------------------
+//! @brief      半精度浮動小数点形式に一括変換します.
+//!
+//! @param[in]      values      単精度浮動小数の配列です.
+//! @param[out]     results     変換結果の格納先です.
+//! @param[in]      count       要素数です.
+//-----------------------------------------------------------------------------
+void EncodeHalf2(const Vector2* values, Half2* results, size_t count);
+
+//-----------------------------------------------------------------------------
+//! @brief      単精度浮動小数点形式に一括変換します.
+//!
+//! @param[in]      values      半精度浮動小数の配列です.
+//! @param[out]     results     変換結果の格納先です.
+//! @param[in]      count       要素数です.
+//-----------------------------------------------------------------------------
+void DecodeHalf2(const Half2* values, Vector2* results, size_t count);
+
+//-----------------------------------------------------------------------------
+//! @brief      半精度浮動小数点形式に一括変換します.
+//!
+//! @param[in]      values      単精度浮動小数の配列です.
+//! @param[out]     results     変換結果の格納先です.
+//! @param[in]      count       要素数です.
+//-----------------------------------------------------------------------------
+void EncodeHalf3(const Vector3* values, Half3* results, size_t count);
+
+//-----------------------------------------------------------------------------
+//! @brief      単精度浮動小数点形式に一括変換します.
+//!
+//! @param[in]      values      半精度浮動小数の配列です.
+//! @param[out]     results     変換結果の格納先です.
+//! @param[in]      count       要素数です.
+//-----------------------------------------------------------------------------
+void DecodeHalf3(const Half3* values, Vector3* results, size_t count);
+
+//-----------------------------------------------------------------------------
+//! @brief      半精度浮動小数点形式に一括変換します.
+//!
+//! @param[in]      values      単精度浮動小数の配列です.
+//! @param[out]     results     変換結果の格納先です.
+//! @param[in]      count       要素数です.
+//-----------------------------------------------------------------------------
+void EncodeHalf4(const Vector4* values, Half4* results, size_t count);
+
+//-----------------------------------------------------------------------------
+//! @brief      単精度浮動小数点形式に一括変換します.
+//!
+//! @param[in]      values      半精度浮動小数の配列です.
+//! @param[out]     results     変換結果の格納先です.
+//! @param[in]      count       要素数です.
+//-----------------------------------------------------------------------------
+void DecodeHalf4(const Half4* values, Vector4* results, size_t count);
+
 //-----------------------------------------------------------------------------
 //! @brief      4要素のUNORM形式に変換します.
 //!
@@ -4103,6 +4657,146 @@ uint16_t EncodeSnorm2(const Vector2& value);
 //-----------------------------------------------------------------------------
 Vector2 DecodeSnorm2(uint16_t value);
 
+///////////////////////////////////////////////////////////////////////////////
+// Oct24 structure
+// 24bit八面体形式(12bit SNORM x 2)を3バイトに詰めた値です.
+// 下位12bitが x, 上位12bitが y で, リトルエンディアンで格納します.
+///////////////////////////////////////////////////////////////////////////////
+struct Oct24
+{
+    uint8_t bytes[3];
+};
+static_assert(sizeof(Oct24) == 3, "Oct24 must be packed into 3 bytes.");
+
+//-----------------------------------------------------------------------------
+//! @brief      単位ベクトルを八面体写像で2次元座標に変換します.
+//!
+//! @param[in]      value       ゼロでない3次元ベクトル(正規化されていなくても構いません).
+//! @return     [-1, 1]^2 の2次元座標を返却します.
+//-----------------------------------------------------------------------------
+Vector2 EncodeOct(const Vector3& value);
+
+//-----------------------------------------------------------------------------
+//! @brief      八面体写像の2次元座標を単位ベクトルに展開します.
+//!
+//! @param[in]      value       [-1, 1]^2 の2次元座標.
+//! @return     正規化された3次元ベクトルを返却します.
+//! @note       一括展開とビット単位で一致させるため, 乗算と加算の融合は無効にしてビルドしてください
+//!             (GCC/Clang は -ffp-contract=off).
+//-----------------------------------------------------------------------------
+Vector3 DecodeOct(const Vector2& value);
+
+//-----------------------------------------------------------------------------
+//! @brief      単位ベクトルを16bit八面体形式(8bit SNORM x 2)に変換します.
+//!
+//! @param[in]      value       ゼロでない3次元ベクトル.
+//! @return     16bit八面体形式にパッキングした値を返却します.
+//! @note       展開後の最大角度誤差は 0.96 度です.
+//-----------------------------------------------------------------------------
+uint16_t EncodeOct16(const Vector3& value);
+
+//-----------------------------------------------------------------------------
+//! @brief      16bit八面体形式を展開します.
+//!
+//! @param[in]      value       16bit八面体形式.
+//! @return     正規化された3次元ベクトルを返却します.
+//-----------------------------------------------------------------------------
+Vector3 DecodeOct16(uint16_t value);
+
+//-----------------------------------------------------------------------------
+//! @brief      単位ベクトルを24bit八面体形式(12bit SNORM x 2)に変換します.
+//!
+//! @param[in]      value       ゼロでない3次元ベクトル.
+//! @return     3バイトに詰めた24bit八面体形式を返却します.
+//! @note       展開後の最大角度誤差は 0.059 度です.
+//-----------------------------------------------------------------------------
+Oct24 EncodeOct24(const Vector3& value);
+
+//-----------------------------------------------------------------------------
+//! @brief      24bit八面体形式を展開します.
+//!
+//! @param[in]      value       24bit八面体形式.
+//! @return     正規化された3次元ベクトルを返却します.
+//-----------------------------------------------------------------------------
+Vector3 DecodeOct24(const Oct24& value);
+
+//-----------------------------------------------------------------------------
+//! @brief      単位ベクトルを32bit八面体形式(16bit SNORM x 2)に変換します.
+//!
+//! @param[in]      value       ゼロでない3次元ベクトル.
+//! @return     32bit八面体形式にパッキングした値を返却します.
+//! @note       展開後の最大角度誤差は 0.0037 度です.
+//-----------------------------------------------------------------------------
+uint32_t EncodeOct32(const Vector3& value);
+
+//-----------------------------------------------------------------------------
+//! @brief      32bit八面体形式を展開します.
+//!
+//! @param[in]      value       32bit八面体形式.
+//! @return     正規化された3次元ベクトルを返却します.
+//-----------------------------------------------------------------------------
+Vector3 DecodeOct32(uint32_t value);
+
+//-----------------------------------------------------------------------------
+//! @brief      16bit八面体形式に一括変換します.
+//!
+//! @param[in]      values      3次元ベクトルの配列です.
+//! @param[out]     results     変換結果の格納先です.
+//! @param[in]      count       要素数です.
+//! @note       結果は EncodeOct16() の1要素版とビット単位で一致します.
+//-----------------------------------------------------------------------------
+void EncodeOct16(const Vector3* values, uint16_t* results, size_t count);
+
+//-----------------------------------------------------------------------------
+//! @brief      16bit八面体形式を一括展開します.
+//!
+//! @param[in]      values      16bit八面体形式の配列です.
+//! @param[out]     results     展開結果の格納先です.
+//! @param[in]      count       要素数です.
+//! @note       結果は DecodeOct16() の1要素版とビット単位で一致します.
+//-----------------------------------------------------------------------------
+void DecodeOct16(const uint16_t* values, Vector3* results, size_t count);
+
+//-----------------------------------------------------------------------------
+//! @brief      24bit八面体形式に一括変換します.
+//!
+//! @param[in]      values      3次元ベクトルの配列です.
+//! @param[out]     results     変換結果の格納先です.
+//! @param[in]      count       要素数です.
+//! @note       結果は EncodeOct24() の1要素版とビット単位で一致します.
+//-----------------------------------------------------------------------------
+void EncodeOct24(const Vector3* values, Oct24* results, size_t count);
+
+//-----------------------------------------------------------------------------
+//! @brief      24bit八面体形式を一括展開します.
+//!
+//! @param[in]      values      24bit八面体形式の配列です.
+//! @param[out]     results     展開結果の格納先です.
+//! @param[in]      count       要素数です.
+//! @note       結果は DecodeOct24() の1要素版とビット単位で一致します.
+//-----------------------------------------------------------------------------
+void DecodeOct24(const Oct24* values, Vector3* results, size_t count);
+
+//-----------------------------------------------------------------------------
+//! @brief      32bit八面体形式に一括変換します.
+//!
+//! @param[in]      values      3次元ベクトルの配列です.
+//! @param[out]     results     変換結果の格納先です.
+//! @param[in]      count       要素数です.
+//! @note       結果は EncodeOct32() の1要素版とビット単位で一致します.
+//-----------------------------------------------------------------------------
+void EncodeOct32(const Vector3* values, uint32_t* results, size_t count);
+
+//-----------------------------------------------------------------------------
+//! @brief      32bit八面体形式を一括展開します.
+//!
+//! @param[in]      values      32bit八面体形式の配列です.
+//! @param[out]     results     展開結果の格納先です.
+//! @param[in]      count       要素数です.
+//! @note       結果は DecodeOct32() の1要素版とビット単位で一致します.
+//-----------------------------------------------------------------------------
+void DecodeOct32(const uint32_t* values, Vector3* results, size_t count);
+
 } // namespace asdx
 
 //-----------------------------------------------------------------------------
@@ -39,29 +39,29 @@ constexpr double ToDegree( double radian ) noexcept
 //      ゼロかどうかチェックします.
 //-----------------------------------------------------------------------------
 inline
-bool IsZero( float value ) noexcept
-{ return fabs( value ) <= F_EPSILON; }
+constexpr bool IsZero( float value ) noexcept
+{ return ( -F_EPSILON <= value ) && ( value <= F_EPSILON ); }
 
 //-----------------------------------------------------------------------------
 //      ゼロかどうかチェックします.
 //-----------------------------------------------------------------------------
 inline
-bool IsZero( double value ) noexcept
-{ return abs( value ) <= D_EPSILON; }
+constexpr bool IsZero( double value ) noexcept
+{ return ( -D_EPSILON <= value ) && ( value <= D_EPSILON ); }
 
 //-----------------------------------------------------------------------------
 //      値が等しいかどうかチェックします.
 //-----------------------------------------------------------------------------
 inline
-bool IsEqual( float value1, float value2 ) noexcept
-{ return fabs( value1 - value2 ) <= F_EPSILON; }
+constexpr bool IsEqual( float value1, float value2 ) noexcept
+{ return IsZero( value1 - value2 ); }
 
 //-----------------------------------------------------------------------------
 //      値が等しいかどうかチェックします.
 //-----------------------------------------------------------------------------
 inline
-bool IsEqual( double value1, double value2 ) noexcept
-{ return abs( value1 - value2 ) <= D_EPSILON; }
+constexpr bool IsEqual( double value1, double value2 ) noexcept
+{ return IsZero( value1 - value2 ); }
 
 //-----------------------------------------------------------------------------
 //      非数かどうかチェックします.
@@ -203,48 +203,49 @@ uint32_t Comb( uint32_t n, uint32_t r )
 inline 
 half ToHalf( float value )
 {
+    // IEEE 754 準拠の最近接偶数丸め (F16C の vcvtps2ph と同じ結果になる).
     union FP32
     {
         uint32_t u;
         float    f;
     };
 
-    half result;
+    const uint32_t f32Infinity = 255U << 23U;
+    const uint32_t f16Max      = ( 127U + 16U ) << 23U;
+    FP32 denormMagic;
+    denormMagic.u = ( ( 127U - 15U ) + ( 23U - 10U ) + 1U ) << 23U;
 
     // ビット列を崩さないままuint32_t型に変換.
     FP32 fp32;
     fp32.f = value;
-    uint32_t bit = fp32.u;
 
-    // float表現の符号bitを取り出し.
-    uint32_t sign   = ( bit & 0x80000000U) >> 16U;
+    // float表現の符号bitを取り出し, 符号部を削ぎ落す.
+    uint32_t sign = fp32.u & 0x80000000U;
+    fp32.u ^= sign;
 
-    // 符号部を削ぎ落す.
-    bit     = bit & 0x7FFFFFFFU;
+    uint32_t result;
 
-    // halfとして表現する際に値がデカ過ぎる場合は，無限大にクランプ.
-    if ( bit > 0x47FFEFFFU)
-    { result = 0x7FFFU; }
+    // halfとして表現する際に値がデカ過ぎる場合は無限大, 非数はquiet NaNにする.
+    if ( fp32.u >= f16Max )
+    { result = ( fp32.u > f32Infinity ) ? ( 0x7E00U | ( ( fp32.u >> 13U ) & 0x3FFU ) ) : 0x7C00U; }
+    // 正規化されたhalfとして表現するために小さすぎる値は正規化されていない値に変換.
+    else if ( fp32.u < ( 113U << 23U ) )
+    {
+        // 加算時の丸めで仮数部を揃える.
+        fp32.f += denormMagic.f;
+        result = fp32.u - denormMagic.u;
+    }
     else
     {
-        // 正規化されたhalfとして表現するために小さすぎる値は正規化されていない値に変換.
-        if ( bit < 0x38800000U)
-        {
-            uint32_t shift = 113U - ( bit >> 23U);
-            bit    = (0x800000U | ( bit & 0x7FFFFFU)) >> shift;
-        }
-        else
-        {
-            // 正規化されたhalfとして表現するために指数部に再度バイアスをかける
-            bit += 0xC8000000U;
-        }
-
-        // half型表現にする.
-        result = (( bit + 0x0FFFU + (( bit >> 13U) & 1U)) >> 13U) & 0x7FFFU; 
+        // 指数部に再度バイアスをかけて丸める.
+        uint32_t mantissaOdd = ( fp32.u >> 13U ) & 1U;
+        fp32.u += ( uint32_t( 15 - 127 ) << 23U ) + 0xFFFU;
+        fp32.u += mantissaOdd;
+        result = fp32.u >> 13U;
     }
 
     // 符号部を付け足して返却.
-    return static_cast<half>( result | sign );
+    return static_cast<half>( result | ( sign >> 16U ) );
 }
 
 //-----------------------------------------------------------------------------
@@ -265,8 +266,16 @@ float ToFloat( half value )
     // 仮数
     uint32_t mantissa = static_cast<uint32_t>( value & 0x03FF );
 
+    // 無限大または非数の場合.
+    if ( ( value & 0x7C00 ) == 0x7C00 )
+    {
+        // float の指数部を全て1にし, 非数は quiet NaN にする (F16C と同じ).
+        exponent = 143;
+        if ( mantissa != 0 )
+        { mantissa |= 0x0200; }
+    }
     // 正規化済みの場合.
-    if ( ( value & 0x7C00 ) != 0 )
+    else if ( ( value & 0x7C00 ) != 0 )
     {
         // 指数部を計算.
         exponent = static_cast<uint32_t>( ( value >> 10 ) & 0x1F );
@@ -301,6 +310,138 @@ float ToFloat( half value )
     return fp32.f;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// HalfTable structure
+// half -> float 変換テーブルです (Jeroen van der Zijp, "Fast Half Float Conversions").
+///////////////////////////////////////////////////////////////////////////////
+struct HalfTable
+{
+    uint32_t    Mantissa[3072];
+    uint32_t    Exponent[64];
+    uint16_t    Offset  [64];
+
+    //-------------------------------------------------------------------------
+    //      テーブルを構築します.
+    //-------------------------------------------------------------------------
+    HalfTable()
+    {
+        Mantissa[0] = 0;
+        for( uint32_t i=1; i<1024; ++i )
+        {
+            uint32_t m = i << 13;
+            uint32_t e = 0;
+            while( ( m & 0x00800000 ) == 0 )
+            {
+                e -= 0x00800000;
+                m <<= 1;
+            }
+            m &= ~0x00800000U;
+            e += 0x38800000;
+            Mantissa[i] = m | e;
+        }
+        for( uint32_t i=1024; i<2048; ++i )
+        { Mantissa[i] = 0x38000000 + ( ( i - 1024 ) << 13 ); }
+
+        // 無限大・非数用 (非数は quiet NaN にする).
+        Mantissa[2048] = 0x38000000;
+        for( uint32_t i=2049; i<3072; ++i )
+        { Mantissa[i] = ( 0x38000000 + ( ( i - 2048 ) << 13 ) ) | 0x00400000; }
+
+        Exponent[ 0] = 0;
+        Exponent[31] = 0x47800000;
+        Exponent[32] = 0x80000000;
+        Exponent[63] = 0xC7800000;
+        for( uint32_t i=1; i<31; ++i )
+        {
+            Exponent[i]      = i << 23;
+            Exponent[i + 32] = 0x80000000 + ( i << 23 );
+        }
+
+        for( uint32_t i=0; i<64; ++i )
+        { Offset[i] = 1024; }
+        Offset[ 0] = 0;
+        Offset[32] = 0;
+        Offset[31] = 2048;
+        Offset[63] = 2048;
+    }
+
+    //-------------------------------------------------------------------------
+    //      テーブルを用いてfloat型のビット列に変換します.
+    //-------------------------------------------------------------------------
+    uint32_t ToFloatBits( half value ) const
+    { return Mantissa[ Offset[ value >> 10 ] + ( value & 0x3FF ) ] + Exponent[ value >> 10 ]; }
+
+    //-------------------------------------------------------------------------
+    //      インスタンスを取得します.
+    //-------------------------------------------------------------------------
+    static const HalfTable& Get()
+    {
+        static const HalfTable s_Table;
+        return s_Table;
+    }
+};
+
+//-----------------------------------------------------------------------------
+//      float型配列をhalf型配列に一括変換します.
+//-----------------------------------------------------------------------------
+inline
+void ToHalf( const float* values, half* results, size_t count )
+{
+    size_t i = 0;
+
+#if ASDX_SIMD_AVX512
+    for( ; i + 16 <= count; i += 16 )
+    {
+        auto v = _mm512_loadu_ps( values + i );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( results + i ), _mm512_cvtps_ph( v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC ) );
+    }
+#endif
+
+#if ASDX_SIMD_F16C
+    for( ; i + 8 <= count; i += 8 )
+    {
+        auto v = _mm256_loadu_ps( values + i );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( results + i ), _mm256_cvtps_ph( v, _MM_FROUND_TO_NEAREST_INT ) );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    { results[i] = ToHalf( values[i] ); }
+}
+
+//-----------------------------------------------------------------------------
+//      half型配列をfloat型配列に一括変換します.
+//-----------------------------------------------------------------------------
+inline
+void ToFloat( const half* values, float* results, size_t count )
+{
+    size_t i = 0;
+
+#if ASDX_SIMD_AVX512
+    for( ; i + 16 <= count; i += 16 )
+    {
+        auto v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( values + i ) );
+        _mm512_storeu_ps( results + i, _mm512_cvtph_ps( v ) );
+    }
+#endif
+
+#if ASDX_SIMD_F16C
+    for( ; i + 8 <= count; i += 8 )
+    {
+        auto v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( values + i ) );
+        _mm256_storeu_ps( results + i, _mm256_cvtph_ps( v ) );
+    }
+#endif
+
+    if ( i < count )
+    {
+        const auto& table = HalfTable::Get();
+        auto bits = reinterpret_cast<uint32_t*>( results );
+        for( ; i < count; ++i )
+        { bits[i] = table.ToFloatBits( values[i] ); }
+    }
+}
+
 //-----------------------------------------------------------------------------
 //      線形補間を行います.
 //-----------------------------------------------------------------------------
@@ -315,6 +456,292 @@ inline
 constexpr double Lerp( double a, double b, double amount ) noexcept
 { return a + amount * ( b - a ); }
 
+#if ASDX_SIMD
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SIMD Functions
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace simd {
+
+//-----------------------------------------------------------------------------
+//      4要素をロードします.
+//-----------------------------------------------------------------------------
+inline
+__m128 Load4( const float* p )
+{ return _mm_loadu_ps( p ); }
+
+//-----------------------------------------------------------------------------
+//      4要素をストアします.
+//-----------------------------------------------------------------------------
+inline
+void Store4( float* p, __m128 value )
+{ _mm_storeu_ps( p, value ); }
+
+//-----------------------------------------------------------------------------
+//      a * b + c を求めます.
+//-----------------------------------------------------------------------------
+inline
+__m128 MulAdd( __m128 a, __m128 b, __m128 c )
+{
+#if ASDX_SIMD_AVX2
+    return _mm_fmadd_ps( a, b, c );
+#else
+    return _mm_add_ps( _mm_mul_ps( a, b ), c );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      指定要素を全要素に複製します.
+//-----------------------------------------------------------------------------
+#define ASDX_SIMD_SPLAT( v, i )     _mm_shuffle_ps( (v), (v), _MM_SHUFFLE(i, i, i, i) )
+
+//-----------------------------------------------------------------------------
+//      4要素の内積を全要素に格納して返却します.
+//-----------------------------------------------------------------------------
+inline
+__m128 Dot4( __m128 a, __m128 b )
+{
+    // _mm_dp_ps は命令数もレイテンシも大きいので, 積を2回の入れ替えで足し合わせる.
+    // 加算順は _mm_dp_ps と同じ (x + y) + (z + w) になる.
+    auto m = _mm_mul_ps( a, b );
+    auto s = _mm_add_ps( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE(2, 3, 0, 1) ) );
+    return _mm_add_ps( s, _mm_shuffle_ps( s, s, _MM_SHUFFLE(1, 0, 3, 2) ) );
+}
+
+//-----------------------------------------------------------------------------
+//      4要素ベクトルを正規化します.
+//-----------------------------------------------------------------------------
+inline
+__m128 Normalize4( __m128 value )
+{ return _mm_div_ps( value, _mm_sqrt_ps( Dot4( value, value ) ) ); }
+
+//-----------------------------------------------------------------------------
+//      行ベクトルと行列を乗算します.
+//-----------------------------------------------------------------------------
+inline
+__m128 Transform4( __m128 v, __m128 r0, __m128 r1, __m128 r2, __m128 r3 )
+{
+    auto result = _mm_mul_ps( ASDX_SIMD_SPLAT( v, 0 ), r0 );
+    result = MulAdd( ASDX_SIMD_SPLAT( v, 1 ), r1, result );
+    result = MulAdd( ASDX_SIMD_SPLAT( v, 2 ), r2, result );
+    result = MulAdd( ASDX_SIMD_SPLAT( v, 3 ), r3, result );
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      行列同士を乗算します(result は a, b と同一でも構いません).
+//-----------------------------------------------------------------------------
+inline
+void MultiplyMatrix( const float* a, const float* b, float* result )
+{
+#if ASDX_SIMD_AVX2
+    // 2行ずつ256bitで処理.
+    auto b0 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( b +  0 ) );
+    auto b1 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( b +  4 ) );
+    auto b2 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( b +  8 ) );
+    auto b3 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( b + 12 ) );
+
+    auto a01 = _mm256_loadu_ps( a + 0 );
+    auto a23 = _mm256_loadu_ps( a + 8 );
+
+    auto r01 = _mm256_mul_ps( _mm256_shuffle_ps( a01, a01, _MM_SHUFFLE(0, 0, 0, 0) ), b0 );
+    r01 = _mm256_fmadd_ps( _mm256_shuffle_ps( a01, a01, _MM_SHUFFLE(1, 1, 1, 1) ), b1, r01 );
+    r01 = _mm256_fmadd_ps( _mm256_shuffle_ps( a01, a01, _MM_SHUFFLE(2, 2, 2, 2) ), b2, r01 );
+    r01 = _mm256_fmadd_ps( _mm256_shuffle_ps( a01, a01, _MM_SHUFFLE(3, 3, 3, 3) ), b3, r01 );
+
+    auto r23 = _mm256_mul_ps( _mm256_shuffle_ps( a23, a23, _MM_SHUFFLE(0, 0, 0, 0) ), b0 );
+    r23 = _mm256_fmadd_ps( _mm256_shuffle_ps( a23, a23, _MM_SHUFFLE(1, 1, 1, 1) ), b1, r23 );
+    r23 = _mm256_fmadd_ps( _mm256_shuffle_ps( a23, a23, _MM_SHUFFLE(2, 2, 2, 2) ), b2, r23 );
+    r23 = _mm256_fmadd_ps( _mm256_shuffle_ps( a23, a23, _MM_SHUFFLE(3, 3, 3, 3) ), b3, r23 );
+
+    _mm256_storeu_ps( result + 0, r01 );
+    _mm256_storeu_ps( result + 8, r23 );
+#else
+    auto b0 = Load4( b +  0 );
+    auto b1 = Load4( b +  4 );
+    auto b2 = Load4( b +  8 );
+    auto b3 = Load4( b + 12 );
+
+    auto r0 = Transform4( Load4( a +  0 ), b0, b1, b2, b3 );
+    auto r1 = Transform4( Load4( a +  4 ), b0, b1, b2, b3 );
+    auto r2 = Transform4( Load4( a +  8 ), b0, b1, b2, b3 );
+    auto r3 = Transform4( Load4( a + 12 ), b0, b1, b2, b3 );
+
+    Store4( result +  0, r0 );
+    Store4( result +  4, r1 );
+    Store4( result +  8, r2 );
+    Store4( result + 12, r3 );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      行列を転置します(result は value と同一でも構いません).
+//-----------------------------------------------------------------------------
+inline
+void TransposeMatrix( const float* value, float* result )
+{
+    auto r0 = Load4( value +  0 );
+    auto r1 = Load4( value +  4 );
+    auto r2 = Load4( value +  8 );
+    auto r3 = Load4( value + 12 );
+    _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+    Store4( result +  0, r0 );
+    Store4( result +  4, r1 );
+    Store4( result +  8, r2 );
+    Store4( result + 12, r3 );
+}
+
+//-----------------------------------------------------------------------------
+//      四元数同士を乗算します.
+//-----------------------------------------------------------------------------
+inline
+__m128 MultiplyQuaternion( __m128 a, __m128 b )
+{
+    const auto signX = _mm_setr_ps(  1.0f,  1.0f, -1.0f, -1.0f );
+    const auto signY = _mm_setr_ps( -1.0f,  1.0f,  1.0f, -1.0f );
+    const auto signZ = _mm_setr_ps(  1.0f, -1.0f,  1.0f, -1.0f );
+
+    auto result = _mm_mul_ps( ASDX_SIMD_SPLAT( a, 3 ), b );
+    result = MulAdd( ASDX_SIMD_SPLAT( a, 0 ), _mm_mul_ps( _mm_shuffle_ps( b, b, _MM_SHUFFLE(0, 1, 2, 3) ), signX ), result );
+    result = MulAdd( ASDX_SIMD_SPLAT( a, 1 ), _mm_mul_ps( _mm_shuffle_ps( b, b, _MM_SHUFFLE(1, 0, 3, 2) ), signY ), result );
+    result = MulAdd( ASDX_SIMD_SPLAT( a, 2 ), _mm_mul_ps( _mm_shuffle_ps( b, b, _MM_SHUFFLE(2, 3, 0, 1) ), signZ ), result );
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      3要素の外積を求めます(w成分は0になります).
+//-----------------------------------------------------------------------------
+inline
+__m128 Cross3( __m128 a, __m128 b )
+{
+    auto a_yzx = _mm_shuffle_ps( a, a, _MM_SHUFFLE(3, 0, 2, 1) );
+    auto b_yzx = _mm_shuffle_ps( b, b, _MM_SHUFFLE(3, 0, 2, 1) );
+    auto c     = _mm_sub_ps( _mm_mul_ps( a, b_yzx ), _mm_mul_ps( a_yzx, b ) );
+    return _mm_shuffle_ps( c, c, _MM_SHUFFLE(3, 0, 2, 1) );
+}
+
+//-----------------------------------------------------------------------------
+//      アフィン変換行列の逆行列を求めます(result は value と同一でも構いません).
+//-----------------------------------------------------------------------------
+inline
+void InvertAffineMatrix( const float* value, float* result )
+{
+    auto r0 = Load4( value +  0 );
+    auto r1 = Load4( value +  4 );
+    auto r2 = Load4( value +  8 );
+    auto t  = Load4( value + 12 );
+
+    // 余因子 (3x3部分の逆行列の列ベクトル × det).
+    auto c0 = Cross3( r1, r2 );
+    auto c1 = Cross3( r2, r0 );
+    auto c2 = Cross3( r0, r1 );
+    auto c3 = _mm_setzero_ps();
+
+    auto det = _mm_dp_ps( r0, c0, 0x7F );
+    assert( _mm_cvtss_f32( det ) != 0.0f );
+    auto invDet = _mm_div_ps( _mm_set1_ps( 1.0f ), det );
+
+    _MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+    c0 = _mm_mul_ps( c0, invDet );
+    c1 = _mm_mul_ps( c1, invDet );
+    c2 = _mm_mul_ps( c2, invDet );
+
+    auto it = _mm_mul_ps( ASDX_SIMD_SPLAT( t, 0 ), c0 );
+    it = MulAdd( ASDX_SIMD_SPLAT( t, 1 ), c1, it );
+    it = MulAdd( ASDX_SIMD_SPLAT( t, 2 ), c2, it );
+    it = _mm_sub_ps( _mm_setr_ps( 0.0f, 0.0f, 0.0f, 1.0f ), it );
+
+    Store4( result +  0, c0 );
+    Store4( result +  4, c1 );
+    Store4( result +  8, c2 );
+    Store4( result + 12, it );
+}
+
+//-----------------------------------------------------------------------------
+//      剛体変換行列の逆行列を求めます(result は value と同一でも構いません).
+//-----------------------------------------------------------------------------
+inline
+void InvertRigidMatrix( const float* value, float* result )
+{
+    auto r0 = Load4( value +  0 );
+    auto r1 = Load4( value +  4 );
+    auto r2 = Load4( value +  8 );
+    auto t  = Load4( value + 12 );
+    auto r3 = _mm_setzero_ps();
+
+    // 回転部分は転置で逆行列になる.
+    _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+
+    auto it = _mm_mul_ps( ASDX_SIMD_SPLAT( t, 0 ), r0 );
+    it = MulAdd( ASDX_SIMD_SPLAT( t, 1 ), r1, it );
+    it = MulAdd( ASDX_SIMD_SPLAT( t, 2 ), r2, it );
+    it = _mm_sub_ps( _mm_setr_ps( 0.0f, 0.0f, 0.0f, 1.0f ), it );
+
+    Store4( result +  0, r0 );
+    Store4( result +  4, r1 );
+    Store4( result +  8, r2 );
+    Store4( result + 12, it );
+}
+
+//-----------------------------------------------------------------------------
+//      4個の3次元ベクトル(SoA)を八面体写像で2次元座標に変換します.
+//-----------------------------------------------------------------------------
+inline
+void EncodeOct4( __m128 x, __m128 y, __m128 z, __m128& u, __m128& v )
+{
+    const auto signMask = _mm_set1_ps( -0.0f );
+    const auto one      = _mm_set1_ps( 1.0f );
+    const auto zero     = _mm_setzero_ps();
+
+    auto ax  = _mm_andnot_ps( signMask, x );
+    auto ay  = _mm_andnot_ps( signMask, y );
+    auto az  = _mm_andnot_ps( signMask, z );
+    auto inv = _mm_div_ps( one, _mm_add_ps( _mm_add_ps( ax, ay ), az ) );
+
+    auto px = _mm_mul_ps( x, inv );
+    auto py = _mm_mul_ps( y, inv );
+
+    // 下半球は対角線で折り返す.
+    auto sx = _mm_blendv_ps( _mm_set1_ps( -1.0f ), one, _mm_cmpge_ps( px, zero ) );
+    auto sy = _mm_blendv_ps( _mm_set1_ps( -1.0f ), one, _mm_cmpge_ps( py, zero ) );
+    auto fx = _mm_mul_ps( _mm_sub_ps( one, _mm_andnot_ps( signMask, py ) ), sx );
+    auto fy = _mm_mul_ps( _mm_sub_ps( one, _mm_andnot_ps( signMask, px ) ), sy );
+
+    auto lower = _mm_cmplt_ps( z, zero );
+    u = _mm_blendv_ps( px, fx, lower );
+    v = _mm_blendv_ps( py, fy, lower );
+}
+
+//-----------------------------------------------------------------------------
+//      4個の八面体写像の2次元座標を単位ベクトル(SoA)に展開します.
+//-----------------------------------------------------------------------------
+inline
+void DecodeOct4( __m128 u, __m128 v, __m128& x, __m128& y, __m128& z )
+{
+    const auto signMask = _mm_set1_ps( -0.0f );
+    const auto zero     = _mm_setzero_ps();
+
+    auto au = _mm_andnot_ps( signMask, u );
+    auto av = _mm_andnot_ps( signMask, v );
+    z = _mm_sub_ps( _mm_sub_ps( _mm_set1_ps( 1.0f ), au ), av );
+
+    auto t  = _mm_max_ps( _mm_xor_ps( z, signMask ), zero );
+    auto nt = _mm_xor_ps( t, signMask );
+    auto tu = _mm_blendv_ps( t, nt, _mm_cmpge_ps( u, zero ) );
+    auto tv = _mm_blendv_ps( t, nt, _mm_cmpge_ps( v, zero ) );
+    x = _mm_add_ps( u, tu );
+    y = _mm_add_ps( v, tv );
+
+    // スカラー版 DecodeOct() と同じ順序で乗算と加算を分けて計算し, ビット単位で一致させる.
+    auto lenSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+    auto inv   = _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_sqrt_ps( lenSq ) );
+    x = _mm_mul_ps( x, inv );
+    y = _mm_mul_ps( y, inv );
+    z = _mm_mul_ps( z, inv );
+}
+
+} // namespace simd
+#endif//ASDX_SIMD
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Vector2 structure
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -341,7 +768,7 @@ Vector2::Vector2( const float* pf )
 //      引数付きコンストラクタ.
 //-----------------------------------------------------------------------------
 inline
-Vector2::Vector2( float nx, float ny )
+constexpr Vector2::Vector2( float nx, float ny )
 : x( nx )
 , y( ny )
 { /* DO_NOTHING */ }
@@ -364,7 +791,7 @@ Vector2::operator const float *() const
 //      加算代入演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2& Vector2::operator += ( const Vector2& v )
+constexpr Vector2& Vector2::operator += ( const Vector2& v )
 {
     x += v.x;
     y += v.y;
@@ -375,7 +802,7 @@ Vector2& Vector2::operator += ( const Vector2& v )
 //      減算代入演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2& Vector2::operator -= ( const Vector2& v )
+constexpr Vector2& Vector2::operator -= ( const Vector2& v )
 {
     x -= v.x;
     y -= v.y;
@@ -386,7 +813,7 @@ Vector2& Vector2::operator -= ( const Vector2& v )
 //      乗算代入演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2& Vector2::operator *= ( float f )
+constexpr Vector2& Vector2::operator *= ( float f )
 {
     x *= f;
     y *= f;
@@ -397,7 +824,7 @@ Vector2& Vector2::operator *= ( float f )
 //      除算代入演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2& Vector2::operator /= ( float f )
+constexpr Vector2& Vector2::operator /= ( float f )
 {
     assert( !IsZero( f ) );
     x /= f;
@@ -409,7 +836,7 @@ Vector2& Vector2::operator /= ( float f )
 //      代入演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2& Vector2::operator = ( const Vector2& value )
+constexpr Vector2& Vector2::operator = ( const Vector2& value )
 {
     x = value.x;
     y = value.y;
@@ -420,42 +847,42 @@ Vector2& Vector2::operator = ( const Vector2& value )
 //      正符号演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::operator + () const
+constexpr Vector2 Vector2::operator + () const
 { return (*this); }
 
 //-----------------------------------------------------------------------------
 //      負符号演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::operator - () const
+constexpr Vector2 Vector2::operator - () const
 { return Vector2( -x, -y ); }
 
 //-----------------------------------------------------------------------------
 //      加算演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::operator + ( const Vector2& v ) const
+constexpr Vector2 Vector2::operator + ( const Vector2& v ) const
 { return Vector2( x + v.x, y + v.y ); }
 
 //-----------------------------------------------------------------------------
 //      減算演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::operator - ( const Vector2& v ) const
+constexpr Vector2 Vector2::operator - ( const Vector2& v ) const
 { return Vector2( x - v.x, y - v.y ); }
 
 //-----------------------------------------------------------------------------
 //      乗算演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::operator * ( float f ) const
+constexpr Vector2 Vector2::operator * ( float f ) const
 { return Vector2( x * f, y * f ); }
 
 //-----------------------------------------------------------------------------
 //      除算演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::operator / ( float f ) const
+constexpr Vector2 Vector2::operator / ( float f ) const
 {
     assert( !IsZero( f ) );
     return Vector2( x / f, y / f );
@@ -465,7 +892,7 @@ Vector2 Vector2::operator / ( float f ) const
 //      乗算演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector2 operator * ( float f, const Vector2& v )
+constexpr Vector2 operator * ( float f, const Vector2& v )
 { return Vector2( f * v.x, f * v.y ); }
 
 //-----------------------------------------------------------------------------
@@ -499,7 +926,7 @@ float Vector2::Length() const
 //      長さの2乗を求めます.
 //-----------------------------------------------------------------------------
 inline
-float Vector2::LengthSq() const
+constexpr float Vector2::LengthSq() const
 { return ( x * x + y * y ); }
 
 //-----------------------------------------------------------------------------
@@ -645,7 +1072,7 @@ void Vector2::DistanceSq( const Vector2 &a, const Vector2 &b, float &result )
 //      内積を求めます.
 //-----------------------------------------------------------------------------
 inline
-float Vector2::Dot( const Vector2& a, const Vector2& b )
+constexpr float Vector2::Dot( const Vector2& a, const Vector2& b )
 { return ( a.x * b.x + a.y * b.y ); }
 
 //-----------------------------------------------------------------------------
@@ -771,7 +1198,7 @@ void Vector2::ComputeCrossingAngle( const Vector2 &a, const Vector2 &b, float &r
 //      各成分の最小値を求めます.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::Min( const Vector2& a, const Vector2& b )
+constexpr Vector2 Vector2::Min( const Vector2& a, const Vector2& b )
 { 
     return Vector2(
         asdx::Min( a.x, b.x ),
@@ -793,7 +1220,7 @@ void Vector2::Min( const Vector2 &a, const Vector2 &b, Vector2 &result )
 //      各成分の最大値を求めます.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::Max( const Vector2& a, const Vector2& b )
+constexpr Vector2 Vector2::Max( const Vector2& a, const Vector2& b )
 {
     return Vector2(
         asdx::Max( a.x, b.x ),
@@ -815,7 +1242,7 @@ void Vector2::Max( const Vector2 &a, const Vector2 &b, Vector2 &result )
 //      反射ベクトルを求めます.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::Reflect( const Vector2& i, const Vector2& n )
+constexpr Vector2 Vector2::Reflect( const Vector2& i, const Vector2& n )
 {
     auto dot = n.x * i.x + n.y * i.y;
     return Vector2(
@@ -1022,7 +1449,7 @@ void Vector2::CatmullRom
 //      線形補間を行います.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::Lerp( const Vector2& a, const Vector2& b, float amount )
+constexpr Vector2 Vector2::Lerp( const Vector2& a, const Vector2& b, float amount )
 {
     return Vector2(
         a.x + amount * ( b.x - a.x ),
@@ -1070,7 +1497,7 @@ void Vector2::SmoothStep( const Vector2 &a, const Vector2 &b, float t, Vector2 &
 //      指定された行列を用いて，ベクトルを変換します.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::Transform( const Vector2& position, const Matrix& matrix )
+constexpr Vector2 Vector2::Transform( const Vector2& position, const Matrix& matrix )
 {
     return Vector2(
         ((position.x * matrix._11) + (position.y * matrix._21)) + matrix._41,
@@ -1091,7 +1518,7 @@ void Vector2::Transform( const Vector2 &position, const Matrix &matrix, Vector2
 //      指定された行列を用いて，法線ベクトルを変換します.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Vector2::TransformNormal( const Vector2& normal, const Matrix& matrix )
+constexpr Vector2 Vector2::TransformNormal( const Vector2& normal, const Matrix& matrix )
 {
     return Vector2(
         (normal.x * matrix._11) + (normal.y * matrix._21),
@@ -1165,7 +1592,7 @@ Vector3::Vector3( const float* pf )
 //      引数付きコンストラクタです.
 //-----------------------------------------------------------------------------
 inline
-Vector3::Vector3( const Vector2& value, float nz )
+constexpr Vector3::Vector3( const Vector2& value, float nz )
 : x( value.x )
 , y( value.y )
 , z( nz )
@@ -1175,7 +1602,7 @@ Vector3::Vector3( const Vector2& value, float nz )
 //      引数付きコンストラクタです.
 //-----------------------------------------------------------------------------
 inline
-Vector3::Vector3( float nx, float ny, float nz )
+constexpr Vector3::Vector3( float nx, float ny, float nz )
 : x( nx )
 , y( ny )
 , z( nz )
@@ -1199,7 +1626,7 @@ Vector3::operator const float *() const
 //      加算代入演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3& Vector3::operator += ( const Vector3& v )
+constexpr Vector3& Vector3::operator += ( const Vector3& v )
 {
     x += v.x;
     y += v.y;
@@ -1211,7 +1638,7 @@ Vector3& Vector3::operator += ( const Vector3& v )
 //      減算代入演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3& Vector3::operator -= ( const Vector3& v )
+constexpr Vector3& Vector3::operator -= ( const Vector3& v )
 {
     x -= v.x;
     y -= v.y;
@@ -1223,7 +1650,7 @@ Vector3& Vector3::operator -= ( const Vector3& v )
 //      乗算代入演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3& Vector3::operator *= ( float f )
+constexpr Vector3& Vector3::operator *= ( float f )
 {
     x *= f;
     y *= f;
@@ -1235,7 +1662,7 @@ Vector3& Vector3::operator *= ( float f )
 //      除算代入演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3& Vector3::operator /= ( float f )
+constexpr Vector3& Vector3::operator /= ( float f )
 {
     assert( !IsZero( f ) );
     x /= f;
@@ -1248,7 +1675,7 @@ Vector3& Vector3::operator /= ( float f )
 //      代入演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3& Vector3::operator = ( const Vector3& value )
+constexpr Vector3& Vector3::operator = ( const Vector3& value )
 {
     x = value.x;
     y = value.y;
@@ -1260,42 +1687,42 @@ Vector3& Vector3::operator = ( const Vector3& value )
 //      正符号演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::operator + () const
+constexpr Vector3 Vector3::operator + () const
 { return (*this); }
 
 //-----------------------------------------------------------------------------
 //      負符号演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::operator - () const
+constexpr Vector3 Vector3::operator - () const
 { return Vector3( -x, -y, -z ); }
 
 //-----------------------------------------------------------------------------
 //      加算演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::operator + ( const Vector3& v ) const
+constexpr Vector3 Vector3::operator + ( const Vector3& v ) const
 { return Vector3( x + v.x, y + v.y, z + v.z ); }
 
 //-----------------------------------------------------------------------------
 //      減算演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::operator - ( const Vector3& v ) const
+constexpr Vector3 Vector3::operator - ( const Vector3& v ) const
 { return Vector3( x - v.x, y - v.y, z - v.z ); }
 
 //-----------------------------------------------------------------------------
 //      乗算演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::operator * ( float f ) const
+constexpr Vector3 Vector3::operator * ( float f ) const
 { return Vector3( x * f, y * f, z * f ); }
 
 //-----------------------------------------------------------------------------
 //      除算演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::operator / ( float f ) const
+constexpr Vector3 Vector3::operator / ( float f ) const
 {
     assert( !IsZero( f ) );
     return Vector3( x / f, y / f, z / f );
@@ -1305,7 +1732,7 @@ Vector3 Vector3::operator / ( float f ) const
 //      乗算演算子です.
 //-----------------------------------------------------------------------------
 inline
-Vector3 operator * ( float f, const Vector3& v )
+constexpr Vector3 operator * ( float f, const Vector3& v )
 { return Vector3( f * v.x, f * v.y, f * v.z ); }
 
 //-----------------------------------------------------------------------------
@@ -1341,7 +1768,7 @@ float Vector3::Length() const
 //      ベクトルの大きさの2乗値を求めます.
 //-----------------------------------------------------------------------------
 inline
-float Vector3::LengthSq() const
+constexpr float Vector3::LengthSq() const
 { return ( x * x + y * y + z * z); }
 
 //-----------------------------------------------------------------------------
@@ -1352,9 +1779,10 @@ Vector3& Vector3::Normalize()
 {
     auto mag = Length();
     assert( mag > 0.0f );
-    x /= mag;
-    y /= mag;
-    z /= mag;
+    auto invMag = 1.0f / mag;
+    x *= invMag;
+    y *= invMag;
+    z *= invMag;
     return (*this);
 }
 
@@ -1498,7 +1926,7 @@ void Vector3::DistanceSq( const Vector3 &a, const Vector3 &b, float &result )
 //      内積を求めます.
 //-----------------------------------------------------------------------------
 inline
-float Vector3::Dot( const Vector3& a, const Vector3& b )
+constexpr float Vector3::Dot( const Vector3& a, const Vector3& b )
 { return ( a.x * b.x + a.y * b.y + a.z * b.z ); }
 
 //-----------------------------------------------------------------------------
@@ -1512,7 +1940,7 @@ void Vector3::Dot( const Vector3 &a, const Vector3 &b, float &result )
 //      外積を求めます.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::Cross( const Vector3& a, const Vector3& b )
+constexpr Vector3 Vector3::Cross( const Vector3& a, const Vector3& b )
 {
     return Vector3( 
         ( a.y * b.z ) - ( a.z * b.y ),
@@ -1540,10 +1968,11 @@ Vector3 Vector3::Normalize( const Vector3& value )
 {
     auto mag = value.Length();
     assert( mag > 0.0f );
+    auto invMag = 1.0f / mag;
     return Vector3(
-        value.x / mag,
-        value.y / mag,
-        value.z / mag 
+        value.x * invMag,
+        value.y * invMag,
+        value.z * invMag
     );
 }
 
@@ -1555,9 +1984,10 @@ void Vector3::Normalize( const Vector3& value, Vector3 &result )
 {
     auto mag = value.Length();
     assert( mag > 0.0f );
-    result.x = value.x / mag;
-    result.y = value.y / mag;
-    result.z = value.z / mag;
+    auto invMag = 1.0f / mag;
+    result.x = value.x * invMag;
+    result.y = value.y * invMag;
+    result.z = value.z * invMag;
 }
 
 //-----------------------------------------------------------------------------
@@ -1736,7 +2166,7 @@ void Vector3::ComputeCrossingAngle( const Vector3 &a, const Vector3 &b, float &r
 //      各成分の最小値を求めます.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::Min( const Vector3& a, const Vector3& b )
+constexpr Vector3 Vector3::Min( const Vector3& a, const Vector3& b )
 { 
     return Vector3( 
         asdx::Min( a.x, b.x ),
@@ -1760,7 +2190,7 @@ void Vector3::Min( const Vector3 &a, const Vector3 &b, Vector3 &result )
 //      各成分の最大値を求めます.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::Max( const Vector3& a, const Vector3& b )
+constexpr Vector3 Vector3::Max( const Vector3& a, const Vector3& b )
 {
     return Vector3(
         asdx::Max( a.x, b.x ),
@@ -1784,7 +2214,7 @@ void Vector3::Max( const Vector3 &a, const Vector3 &b, Vector3 &result )
 //      反射ベクトルを求めます.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::Reflect( const Vector3& i, const Vector3& n )
+constexpr Vector3 Vector3::Reflect( const Vector3& i, const Vector3& n )
 {
     auto dot = n.x * i.x + n.y * i.y + n.z * i.z;
     return Vector3(
@@ -2005,7 +2435,7 @@ void Vector3::CatmullRom
 //      線形補間を行います.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::Lerp( const Vector3& a, const Vector3& b, float amount )
+constexpr Vector3 Vector3::Lerp( const Vector3& a, const Vector3& b, float amount )
 {
     return Vector3(
         a.x + amount * ( b.x - a.x ),
@@ -2057,7 +2487,7 @@ void Vector3::SmoothStep( const Vector3 &a, const Vector3 &b, float amount, Vect
 //      指定された行列を用いて，ベクトルを変換します.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::Transform( const Vector3& position, const Matrix& matrix )
+constexpr Vector3 Vector3::Transform( const Vector3& position, const Matrix& matrix )
 {
     return Vector3(
         ( ((position.x * matrix._11) + (position.y * matrix._21)) + (position.z * matrix._31)) + matrix._41,
@@ -2080,7 +2510,7 @@ void Vector3::Transform( const Vector3 &position, const Matrix &matrix, Vector3
 //      指定された行列を用いて，法線ベクトルを変換します.
 //-----------------------------------------------------------------------------
 inline
-Vector3 Vector3::TransformNormal( const Vector3& normal, const Matrix& matrix )
+constexpr Vector3 Vector3::TransformNormal( const Vector3& normal, const Matrix& matrix )
 {
     return Vector3(
         ((normal.x * matrix._11) + (normal.y * matrix._21)) + (normal.z * matrix._31),
@@ -2275,7 +2705,7 @@ Vector4::Vector4( const float* pf )
 //      引数付きコンストラクタです.
 //-----------------------------------------------------------------------------
 inline
-Vector4::Vector4( const Vector2& value, float nz, float nw )
+constexpr Vector4::Vector4( const Vector2& value, float nz, float nw )
 : x( value.x )
 , y( value.y )
 , z( nz )
@@ -2286,7 +2716,7 @@ Vector4::Vector4( const Vector2& value, float nz, float nw )
 //      引数付きコンストラクタです.
 //-----------------------------------------------------------------------------
 inline
-Vector4::Vector4( const Vector3& value, float nw )
+constexpr Vector4::Vector4( const Vector3& value, float nw )
 : x( value.x )
 , y( value.y )
 , z( value.z )
@@ -2297,7 +2727,7 @@ Vector4::Vector4( const Vector3& value, float nw )
 //      引数付きコンストラクタです.
 //-----------------------------------------------------------------------------
 inline
-Vector4::Vector4( float nx, float ny, float nz, float nw )
+constexpr Vector4::Vector4( float nx, float ny, float nz, float nw )
 : x( nx )
 , y( ny )
 , z( nz )
@@ -2324,10 +2754,14 @@ Vector4::operator const float *() const
 inline
 Vector4& Vector4::operator += ( const Vector4& v )
 {
+#if ASDX_SIMD
+    simd::Store4( &x, _mm_add_ps( simd::Load4( &x ), simd::Load4( &v.x ) ) );
+#else
     x += v.x;
     y += v.y;
     z += v.z;
     w += v.w;
+#endif
     return (*this);
 }
 
@@ -2337,10 +2771,14 @@ Vector4& Vector4::operator += ( const Vector4& v )
 inline
 Vector4& Vector4::operator -= ( const Vector4& v )
 {
+#if ASDX_SIMD
+    simd::Store4( &x, _mm_sub_ps( simd::Load4( &x ), simd::Load4( &v.x ) ) );
+#else
     x -= v.x;
     y -= v.y;
     z -= v.z;
     w -= v.w;
+#endif
     return (*this);
 }
 
@@ -2350,10 +2788,14 @@ Vector4& Vector4::operator -= ( const Vector4& v )
 inline
 Vector4& Vector4::operator *= ( float f )
 {
+#if ASDX_SIMD
+    simd::Store4( &x, _mm_mul_ps( simd::Load4( &x ), _mm_set1_ps( f ) ) );
+#else
     x *= f;
     y *= f;
     z *= f;
     w *= f;
+#endif
     return (*this);
 }
 
@@ -2403,21 +2845,45 @@ Vector4 Vector4::operator - () const
 //-----------------------------------------------------------------------------
 inline
 Vector4 Vector4::operator + ( const Vector4& v ) const
-{ return Vector4( x + v.x, y + v.y, z + v.z, w + v.w ); }
+{
+#if ASDX_SIMD
+    Vector4 result;
+    simd::Store4( &result.x, _mm_add_ps( simd::Load4( &x ), simd::Load4( &v.x ) ) );
+    return result;
+#else
+    return Vector4( x + v.x, y + v.y, z + v.z, w + v.w );
+#endif
+}
 
 //-----------------------------------------------------------------------------
 //      減算演算子です.
 //-----------------------------------------------------------------------------
 inline
 Vector4 Vector4::operator - ( const Vector4& v ) const
-{ return Vector4( x - v.x, y - v.y, z - v.z, w - v.w ); }
+{
+#if ASDX_SIMD
+    Vector4 result;
+    simd::Store4( &result.x, _mm_sub_ps( simd::Load4( &x ), simd::Load4( &v.x ) ) );
+    return result;
+#else
+    return Vector4( x - v.x, y - v.y, z - v.z, w - v.w );
+#endif
+}
 
 //-----------------------------------------------------------------------------
 //      乗算演算子です.
 //-----------------------------------------------------------------------------
 inline
 Vector4 Vector4::operator * ( float f ) const
-{ return Vector4( x * f, y * f, z * f, w * f ); }
+{
+#if ASDX_SIMD
+    Vector4 result;
+    simd::Store4( &result.x, _mm_mul_ps( simd::Load4( &x ), _mm_set1_ps( f ) ) );
+    return result;
+#else
+    return Vector4( x * f, y * f, z * f, w * f );
+#endif
+}
 
 //-----------------------------------------------------------------------------
 //      除算演算子です.
@@ -2480,12 +2946,16 @@ float Vector4::LengthSq() const
 inline
 Vector4& Vector4::Normalize()
 {
-    auto mag = Length();
-    assert( mag > 0.0f );
-    x /= mag;
-    y /= mag;
-    z /= mag;
-    w /= mag;
+    assert( LengthSq() > 0.0f );
+#if ASDX_SIMD
+    simd::Store4( &x, simd::Normalize4( simd::Load4( &x ) ) );
+#else
+    auto invMag = 1.0f / Length();
+    x *= invMag;
+    y *= invMag;
+    z *= invMag;
+    w *= invMag;
+#endif
     return (*this);
 }
 
@@ -2642,14 +3112,20 @@ void Vector4::DistanceSq( const Vector4 &a, const Vector4 &b, float &result )
 //-----------------------------------------------------------------------------
 inline
 float Vector4::Dot( const Vector4& a, const Vector4& b )
-{ return ( a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w ); }
+{
+#if ASDX_SIMD
+    return _mm_cvtss_f32( simd::Dot4( simd::Load4( &a.x ), simd::Load4( &b.x ) ) );
+#else
+    return ( a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w );
+#endif
+}
 
 //-----------------------------------------------------------------------------
 //      内積を求めます.
 //-----------------------------------------------------------------------------
 inline
 void Vector4::Dot( const Vector4 &a, const Vector4 &b, float &result )
-{ result = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+{ result = Dot( a, b ); }
 
 //-----------------------------------------------------------------------------
 //      正規化を行います.
@@ -2657,14 +3133,9 @@ void Vector4::Dot( const Vector4 &a, const Vector4 &b, float &result )
 inline
 Vector4 Vector4::Normalize( const Vector4& value )
 {
-    auto mag = value.Length();
-    assert( mag > 0.0f );
-    return Vector4(
-        value.x / mag,
-        value.y / mag,
-        value.z / mag,
-        value.w / mag
-    );
+    Vector4 result;
+    Normalize( value, result );
+    return result;
 }
 
 //-----------------------------------------------------------------------------
@@ -2673,12 +3144,16 @@ Vector4 Vector4::Normalize( const Vector4& value )
 inline
 void Vector4::Normalize( const Vector4 &value, Vector4 &result )
 {
-    auto mag = value.Length();
-    assert( mag > 0.0f );
-    result.x = value.x / mag;
-    result.y = value.y / mag;
-    result.z = value.z / mag;
-    result.w = value.w / mag;
+    assert( value.LengthSq() > 0.0f );
+#if ASDX_SIMD
+    simd::Store4( &result.x, simd::Normalize4( simd::Load4( &value.x ) ) );
+#else
+    auto invMag = 1.0f / value.Length();
+    result.x = value.x * invMag;
+    result.y = value.y * invMag;
+    result.z = value.z * invMag;
+    result.w = value.w * invMag;
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -3000,12 +3475,9 @@ void Vector4::CatmullRom
 inline
 Vector4 Vector4::Lerp( const Vector4& a, const Vector4& b, float amount )
 {
-    return Vector4(
-        a.x + amount * ( b.x - a.x ),
-        a.y + amount * ( b.y - a.y ),
-        a.z + amount * ( b.z - a.z ),
-        a.w + amount * ( b.w - a.w )
-    );
+    Vector4 result;
+    Lerp( a, b, amount, result );
+    return result;
 }
 
 //-----------------------------------------------------------------------------
@@ -3014,10 +3486,16 @@ Vector4 Vector4::Lerp( const Vector4& a, const Vector4& b, float amount )
 inline
 void Vector4::Lerp( const Vector4 &a, const Vector4 &b, float amount, Vector4 &result )
 {
+#if ASDX_SIMD
+    auto va = simd::Load4( &a.x );
+    auto vb = simd::Load4( &b.x );
+    simd::Store4( &result.x, simd::MulAdd( _mm_set1_ps( amount ), _mm_sub_ps( vb, va ), va ) );
+#else
     result.x = a.x + amount * ( b.x - a.x );
     result.y = a.y + amount * ( b.y - a.y );
     result.z = a.z + amount * ( b.z - a.z );
     result.w = a.w + amount * ( b.w - a.w );
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -3056,11 +3534,17 @@ void Vector4::SmoothStep( const Vector4 &a, const Vector4 &b, float amount, Vect
 inline
 Vector4 Vector4::Transform( const Vector4& position, const Matrix& matrix )
 {
+#if ASDX_SIMD
+    Vector4 result;
+    Transform( position, matrix, result );
+    return result;
+#else
     return Vector4(
         ( ( ((position.x * matrix._11) + (position.y * matrix._21)) + (position.z * matrix._31) ) + (position.w * matrix._41)),
         ( ( ((position.x * matrix._12) + (position.y * matrix._22)) + (position.z * matrix._32) ) + (position.w * matrix._42)),
         ( ( ((position.x * matrix._13) + (position.y * matrix._23)) + (position.z * matrix._33) ) + (position.w * matrix._43)),
         ( ( ((position.x * matrix._14) + (position.y * matrix._24)) + (position.z * matrix._34) ) + (position.w * matrix._44)) );
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -3069,10 +3553,19 @@ Vector4 Vector4::Transform( const Vector4& position, const Matrix& matrix )
 inline
 void Vector4::Transform( const Vector4 &position, const Matrix &matrix, Vector4 &result )
 {
+#if ASDX_SIMD
+    simd::Store4( &result.x, simd::Transform4(
+        simd::Load4( &position.x ),
+        simd::Load4( &matrix._11 ),
+        simd::Load4( &matrix._21 ),
+        simd::Load4( &matrix._31 ),
+        simd::Load4( &matrix._41 ) ) );
+#else
     result.x = ( ( ((position.x * matrix._11) + (position.y * matrix._21)) + (position.z * matrix._31) ) + (position.w * matrix._41));
     result.y = ( ( ((position.x * matrix._12) + (position.y * matrix._22)) + (position.z * matrix._32) ) + (position.w * matrix._42));
     result.z = ( ( ((position.x * matrix._13) + (position.y * matrix._23)) + (position.z * matrix._33) ) + (position.w * matrix._43));
     result.w = ( ( ((position.x * matrix._14) + (position.y * matrix._24)) + (position.z * matrix._34) ) + (position.w * matrix._44));
+#endif
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -3100,31 +3593,29 @@ Matrix::Matrix( const float* pf )
 //      引数付きコンストラクタです.
 //-----------------------------------------------------------------------------
 inline
-Matrix::Matrix
+constexpr Matrix::Matrix
 (
     float _f11, float _f12, float _f13, float _f14,
     float _f21, float _f22, float _f23, float _f24,
     float _f31, float _f32, float _f33, float _f34,
     float _f41, float _f42, float _f43, float _f44 
 )
-{
-    _11 = _f11; _12 = _f12; _13 = _f13; _14 = _f14;
-    _21 = _f21; _22 = _f22; _23 = _f23; _24 = _f24;
-    _31 = _f31; _32 = _f32; _33 = _f33; _34 = _f34;
-    _41 = _f41; _42 = _f42; _43 = _f43; _44 = _f44;
-}
+: _11( _f11 ), _12( _f12 ), _13( _f13 ), _14( _f14 )
+, _21( _f21 ), _22( _f22 ), _23( _f23 ), _24( _f24 )
+, _31( _f31 ), _32( _f32 ), _33( _f33 ), _34( _f34 )
+, _41( _f41 ), _42( _f42 ), _43( _f43 ), _44( _f44 )
+{ /* DO_NOTHING */ }
 
 //-----------------------------------------------------------------------------
 //      引数付きコンストラクタです.
 //-----------------------------------------------------------------------------
 inline
-Matrix::Matrix( const Vector4& v1, const Vector4& v2, const Vector4& v3, const Vector4& v4 )
-{
-    _11 = v1.x; _12 = v1.y; _13 = v1.z; _14 = v1.z;
-    _21 = v2.x; _22 = v2.y; _23 = v2.z; _24 = v2.z;
-    _31 = v3.x; _32 = v3.y; _33 = v3.z; _34 = v3.z;
-    _41 = v4.x; _42 = v4.y; _43 = v4.z; _44 = v4.z;
-}
+constexpr Matrix::Matrix( const Vector4& v1, const Vector4& v2, const Vector4& v3, const Vector4& v4 )
+: _11( v1.x ), _12( v1.y ), _13( v1.z ), _14( v1.w )
+, _21( v2.x ), _22( v2.y ), _23( v2.z ), _24( v2.w )
+, _31( v3.x ), _32( v3.y ), _33( v3.z ), _34( v3.w )
+, _41( v4.x ), _42( v4.y ), _43( v4.z ), _44( v4.w )
+{ /* DO_NOTHING */ }
 
 //-----------------------------------------------------------------------------
 //      インデクサです.
@@ -3160,6 +3651,9 @@ Matrix::operator const float* () const
 inline 
 Matrix& Matrix::operator *= ( const Matrix &value )
 {
+#if ASDX_SIMD
+    simd::MultiplyMatrix( &_11, &value._11, &_11 );
+#else
     auto m11 = ( _11 * value._11 ) + ( _12 * value._21 ) + ( _13 * value._31 ) + ( _14 * value._41 );
     auto m12 = ( _11 * value._12 ) + ( _12 * value._22 ) + ( _13 * value._32 ) + ( _14 * value._42 );
     auto m13 = ( _11 * value._13 ) + ( _12 * value._23 ) + ( _13 * value._33 ) + ( _14 * value._43 );
@@ -3184,7 +3678,7 @@ Matrix& Matrix::operator *= ( const Matrix &value )
     _21 = m21;  _22 = m22;  _23 = m23;  _24 = m24;
     _31 = m31;  _32 = m32;  _33 = m33;  _34 = m34;
     _41 = m41;  _42 = m42;  _43 = m43;  _44 = m44;
-
+#endif
     return (*this);
 }
 
@@ -3277,6 +3771,11 @@ Matrix Matrix::operator - () const
 inline 
 Matrix Matrix::operator * ( const Matrix& value ) const
 {
+#if ASDX_SIMD
+    Matrix result;
+    simd::MultiplyMatrix( &_11, &value._11, &result._11 );
+    return result;
+#else
     return Matrix(
         ( _11 * value._11 ) + ( _12 * value._21 ) + ( _13 * value._31 ) + ( _14 * value._41 ),
         ( _11 * value._12 ) + ( _12 * value._22 ) + ( _13 * value._32 ) + ( _14 * value._42 ),
@@ -3298,6 +3797,7 @@ Matrix Matrix::operator * ( const Matrix& value ) const
         ( _41 * value._13 ) + ( _42 * value._23 ) + ( _43 * value._33 ) + ( _44 * value._43 ),
         ( _41 * value._14 ) + ( _42 * value._24 ) + ( _43 * value._34 ) + ( _44 * value._44 )
     );
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -3424,7 +3924,7 @@ Matrix& Matrix::Identity()
 //      単位行列を生成します.
 //-----------------------------------------------------------------------------
 inline
-Matrix Matrix::CreateIdentity()
+constexpr Matrix Matrix::CreateIdentity()
 {
     return Matrix(
         1.0f, 0.0f, 0.0f, 0.0f,
@@ -3452,11 +3952,17 @@ bool Matrix::IsIdentity( const Matrix &value )
 inline
 Matrix Matrix::Transpose( const Matrix& value )
 {
+#if ASDX_SIMD
+    Matrix result;
+    simd::TransposeMatrix( &value._11, &result._11 );
+    return result;
+#else
     return Matrix(
         value._11, value._21, value._31, value._41,
         value._12, value._22, value._32, value._42,
         value._13, value._23, value._33, value._43,
         value._14, value._24, value._34, value._44 );
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -3465,6 +3971,9 @@ Matrix Matrix::Transpose( const Matrix& value )
 inline
 void Matrix::Transpose( const Matrix &value, Matrix &result )
 {
+#if ASDX_SIMD
+    simd::TransposeMatrix( &value._11, &result._11 );
+#else
     result._11 = value._11;
     result._12 = value._21;
     result._13 = value._31;
@@ -3478,12 +3987,13 @@ void Matrix::Transpose( const Matrix &value, Matrix &result )
     result._31 = value._13;
     result._32 = value._23;
     result._33 = value._33;
-    result._34 = value._34;
+    result._34 = value._43;
 
     result._41 = value._14;
     result._42 = value._24;
     result._43 = value._34;
     result._44 = value._44;
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -3492,6 +4002,11 @@ void Matrix::Transpose( const Matrix &value, Matrix &result )
 inline
 Matrix Matrix::Multiply( const Matrix& a, const Matrix& b )
 {
+#if ASDX_SIMD
+    Matrix result;
+    simd::MultiplyMatrix( &a._11, &b._11, &result._11 );
+    return result;
+#else
     return Matrix(
         ( a._11 * b._11 ) + ( a._12 * b._21 ) + ( a._13 * b._31 ) + ( a._14 * b._41 ),
         ( a._11 * b._12 ) + ( a._12 * b._22 ) + ( a._13 * b._32 ) + ( a._14 * b._42 ),
@@ -3513,6 +4028,7 @@ Matrix Matrix::Multiply( const Matrix& a, const Matrix& b )
         ( a._41 * b._13 ) + ( a._42 * b._23 ) + ( a._43 * b._33 ) + ( a._44 * b._43 ),
         ( a._41 * b._14 ) + ( a._42 * b._24 ) + ( a._43 * b._34 ) + ( a._44 * b._44 )
     );
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -3521,6 +4037,9 @@ Matrix Matrix::Multiply( const Matrix& a, const Matrix& b )
 inline
 void Matrix::Multiply( const Matrix &a, const Matrix &b, Matrix &result )
 {
+#if ASDX_SIMD
+    simd::MultiplyMatrix( &a._11, &b._11, &result._11 );
+#else
     result._11 = ( a._11 * b._11 ) + ( a._12 * b._21 ) + ( a._13 * b._31 ) + ( a._14 * b._41 );
     result._12 = ( a._11 * b._12 ) + ( a._12 * b._22 ) + ( a._13 * b._32 ) + ( a._14 * b._42 );
     result._13 = ( a._11 * b._13 ) + ( a._12 * b._23 ) + ( a._13 * b._33 ) + ( a._14 * b._43 );
@@ -3540,6 +4059,7 @@ void Matrix::Multiply( const Matrix &a, const Matrix &b, Matrix &result )
     result._42 = ( a._41 * b._12 ) + ( a._42 * b._22 ) + ( a._43 * b._32 ) + ( a._44 * b._42 );
     result._43 = ( a._41 * b._13 ) + ( a._42 * b._23 ) + ( a._43 * b._33 ) + ( a._44 * b._43 );
     result._44 = ( a._41 * b._14 ) + ( a._42 * b._24 ) + ( a._43 * b._34 ) + ( a._44 * b._44 );
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -3588,6 +4108,12 @@ void Matrix::Multiply( const Matrix &value, float scaleFactor, Matrix &result )
 inline
 Matrix Matrix::MultiplyTranspose( const Matrix& a, const Matrix& b )
 {
+#if ASDX_SIMD
+    Matrix result;
+    simd::MultiplyMatrix( &a._11, &b._11, &result._11 );
+    simd::TransposeMatrix( &result._11, &result._11 );
+    return result;
+#else
     return Matrix(
         ( a._11 * b._11 ) + ( a._12 * b._21 ) + ( a._13 * b._31 ) + ( a._14 * b._41 ),
         ( a._21 * b._11 ) + ( a._22 * b._21 ) + ( a._23 * b._31 ) + ( a._24 * b._41 ),
@@ -3609,6 +4135,7 @@ Matrix Matrix::MultiplyTranspose( const Matrix& a, const Matrix& b )
         ( a._31 * b._14 ) + ( a._32 * b._24 ) + ( a._33 * b._34 ) + ( a._34 * b._44 ),
         ( a._41 * b._14 ) + ( a._42 * b._24 ) + ( a._43 * b._34 ) + ( a._44 * b._44 )
     );
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -3617,6 +4144,10 @@ Matrix Matrix::MultiplyTranspose( const Matrix& a, const Matrix& b )
 inline
 void Matrix::MultiplyTranspose( const Matrix &a, const Matrix &b, Matrix &result )
 {
+#if ASDX_SIMD
+    simd::MultiplyMatrix( &a._11, &b._11, &result._11 );
+    simd::TransposeMatrix( &result._11, &result._11 );
+#else
     result._11 = ( a._11 * b._11 ) + ( a._12 * b._21 ) + ( a._13 * b._31 ) + ( a._14 * b._41 );
     result._21 = ( a._11 * b._12 ) + ( a._12 * b._22 ) + ( a._13 * b._32 ) + ( a._14 * b._42 );
     result._31 = ( a._11 * b._13 ) + ( a._12 * b._23 ) + ( a._13 * b._33 ) + ( a._14 * b._43 );
@@ -3636,6 +4167,7 @@ void Matrix::MultiplyTranspose( const Matrix &a, const Matrix &b, Matrix &result
     result._24 = ( a._41 * b._12 ) + ( a._42 * b._22 ) + ( a._43 * b._32 ) + ( a._44 * b._42 );
     result._34 = ( a._41 * b._13 ) + ( a._42 * b._23 ) + ( a._43 * b._33 ) + ( a._44 * b._43 );
     result._44 = ( a._41 * b._14 ) + ( a._42 * b._24 ) + ( a._43 * b._34 ) + ( a._44 * b._44 );
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -3725,50 +4257,183 @@ void Matrix::Invert( const Matrix &value, Matrix &result )
 }
 
 //-----------------------------------------------------------------------------
-//      拡大・縮小行列を生成します.
+//      アフィン変換行列の逆行列を求めます.
 //-----------------------------------------------------------------------------
 inline
-Matrix Matrix::CreateScale( float scale )
+Matrix Matrix::InvertAffine( const Matrix& value )
 {
-    return Matrix(
-        scale, 0.0f, 0.0f, 0.0f,
-        0.0f, scale, 0.0f, 0.0f,
-        0.0f, 0.0f, scale, 0.0f,
-        0.0f, 0.0f, 0.0f, 1.0f );
+    Matrix result;
+    InvertAffine( value, result );
+    return result;
 }
 
 //-----------------------------------------------------------------------------
-//      拡大・縮小行列を生成します.
+//      アフィン変換行列の逆行列を求めます.
 //-----------------------------------------------------------------------------
-inline 
-void Matrix::CreateScale( float scale, Matrix &result )
+inline
+void Matrix::InvertAffine( const Matrix& value, Matrix& result )
 {
-    result._11 = scale;    result._12 = 0.0f;    result._13 = 0.0f;     result._14 = 0.0f;
-    result._21 = 0.0f;     result._22 = scale;   result._23 = 0.0f;     result._24 = 0.0f;
-    result._31 = 0.0f;     result._32 = 0.0f;    result._33 = scale;    result._34 = 0.0f;
-    result._41 = 0.0f;     result._42 = 0.0f;    result._43 = 0.0f;     result._44 = 1.0f;
+    assert( value._14 == 0.0f && value._24 == 0.0f && value._34 == 0.0f && value._44 == 1.0f );
+#if ASDX_SIMD
+    simd::InvertAffineMatrix( &value._11, &result._11 );
+#else
+    // 3x3部分の余因子.
+    auto c11 = value._22 * value._33 - value._23 * value._32;
+    auto c12 = value._13 * value._32 - value._12 * value._33;
+    auto c13 = value._12 * value._23 - value._13 * value._22;
+    auto c21 = value._23 * value._31 - value._21 * value._33;
+    auto c22 = value._11 * value._33 - value._13 * value._31;
+    auto c23 = value._13 * value._21 - value._11 * value._23;
+    auto c31 = value._21 * value._32 - value._22 * value._31;
+    auto c32 = value._12 * value._31 - value._11 * value._32;
+    auto c33 = value._11 * value._22 - value._12 * value._21;
+
+    auto det = value._11 * c11 + value._12 * c21 + value._13 * c31;
+    assert( det != 0.0f );
+    auto invDet = 1.0f / det;
+
+    auto tx = value._41;
+    auto ty = value._42;
+    auto tz = value._43;
+
+    result._11 = c11 * invDet;
+    result._12 = c12 * invDet;
+    result._13 = c13 * invDet;
+    result._14 = 0.0f;
+
+    result._21 = c21 * invDet;
+    result._22 = c22 * invDet;
+    result._23 = c23 * invDet;
+    result._24 = 0.0f;
+
+    result._31 = c31 * invDet;
+    result._32 = c32 * invDet;
+    result._33 = c33 * invDet;
+    result._34 = 0.0f;
+
+    result._41 = -( tx * result._11 + ty * result._21 + tz * result._31 );
+    result._42 = -( tx * result._12 + ty * result._22 + tz * result._32 );
+    result._43 = -( tx * result._13 + ty * result._23 + tz * result._33 );
+    result._44 = 1.0f;
+#endif
 }
 
 //-----------------------------------------------------------------------------
-//      拡大・縮小行列を生成します.
+//      アフィン変換行列の逆行列をまとめて求めます.
 //-----------------------------------------------------------------------------
-inline 
-Matrix Matrix::CreateScale( float xScale, float yScale, float zScale )
+inline
+void Matrix::InvertAffine( const Matrix* values, Matrix* results, size_t count )
 {
-    return Matrix(
-        xScale, 0.0f,   0.0f,   0.0f,
-        0.0f,   yScale, 0.0f,   0.0f,
-        0.0f,   0.0f,   zScale, 0.0f,
-        0.0f,   0.0f,   0.0f,   1.0f );
+    for( size_t i=0; i<count; ++i )
+    { InvertAffine( values[i], results[i] ); }
 }
 
 //-----------------------------------------------------------------------------
-//      拡大・縮小行列を生成します.
+//      剛体変換行列の逆行列を求めます.
 //-----------------------------------------------------------------------------
 inline
-void Matrix::CreateScale( float xScale, float yScale, float zScale, Matrix &result )
+Matrix Matrix::InvertRigid( const Matrix& value )
 {
-    result._11 = xScale;    result._12 = 0.0f;      result._13 = 0.0f;      result._14 = 0.0f;
+    Matrix result;
+    InvertRigid( value, result );
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      剛体変換行列の逆行列を求めます.
+//-----------------------------------------------------------------------------
+inline
+void Matrix::InvertRigid( const Matrix& value, Matrix& result )
+{
+    assert( value._14 == 0.0f && value._24 == 0.0f && value._34 == 0.0f && value._44 == 1.0f );
+#if ASDX_SIMD
+    simd::InvertRigidMatrix( &value._11, &result._11 );
+#else
+    auto tx = value._41;
+    auto ty = value._42;
+    auto tz = value._43;
+
+    auto m12 = value._12;
+    auto m13 = value._13;
+    auto m23 = value._23;
+
+    result._11 = value._11;
+    result._12 = value._21;
+    result._13 = value._31;
+    result._14 = 0.0f;
+
+    result._21 = m12;
+    result._22 = value._22;
+    result._23 = value._32;
+    result._24 = 0.0f;
+
+    result._31 = m13;
+    result._32 = m23;
+    result._33 = value._33;
+    result._34 = 0.0f;
+
+    result._41 = -( tx * result._11 + ty * result._21 + tz * result._31 );
+    result._42 = -( tx * result._12 + ty * result._22 + tz * result._32 );
+    result._43 = -( tx * result._13 + ty * result._23 + tz * result._33 );
+    result._44 = 1.0f;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      剛体変換行列の逆行列をまとめて求めます.
+//-----------------------------------------------------------------------------
+inline
+void Matrix::InvertRigid( const Matrix* values, Matrix* results, size_t count )
+{
+    for( size_t i=0; i<count; ++i )
+    { InvertRigid( values[i], results[i] ); }
+}
+
+//-----------------------------------------------------------------------------
+//      拡大・縮小行列を生成します.
+//-----------------------------------------------------------------------------
+inline
+Matrix Matrix::CreateScale( float scale )
+{
+    return Matrix(
+        scale, 0.0f, 0.0f, 0.0f,
+        0.0f, scale, 0.0f, 0.0f,
+        0.0f, 0.0f, scale, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f );
+}
+
+//-----------------------------------------------------------------------------
+//      拡大・縮小行列を生成します.
+//-----------------------------------------------------------------------------
+inline 
+void Matrix::CreateScale( float scale, Matrix &result )
+{
+    result._11 = scale;    result._12 = 0.0f;    result._13 = 0.0f;     result._14 = 0.0f;
+    result._21 = 0.0f;     result._22 = scale;   result._23 = 0.0f;     result._24 = 0.0f;
+    result._31 = 0.0f;     result._32 = 0.0f;    result._33 = scale;    result._34 = 0.0f;
+    result._41 = 0.0f;     result._42 = 0.0f;    result._43 = 0.0f;     result._44 = 1.0f;
+}
+
+//-----------------------------------------------------------------------------
+//      拡大・縮小行列を生成します.
+//-----------------------------------------------------------------------------
+inline 
+Matrix Matrix::CreateScale( float xScale, float yScale, float zScale )
+{
+    return Matrix(
+        xScale, 0.0f,   0.0f,   0.0f,
+        0.0f,   yScale, 0.0f,   0.0f,
+        0.0f,   0.0f,   zScale, 0.0f,
+        0.0f,   0.0f,   0.0f,   1.0f );
+}
+
+//-----------------------------------------------------------------------------
+//      拡大・縮小行列を生成します.
+//-----------------------------------------------------------------------------
+inline
+void Matrix::CreateScale( float xScale, float yScale, float zScale, Matrix &result )
+{
+    result._11 = xScale;    result._12 = 0.0f;      result._13 = 0.0f;      result._14 = 0.0f;
     result._21 = 0.0f;      result._22 = yScale;    result._23 = 0.0f;      result._24 = 0.0f;
     result._31 = 0.0f;      result._32 = 0.0f;      result._33 = zScale;    result._34 = 0.0f;
     result._41 = 0.0f;      result._42 = 0.0f;      result._43 = 0.0f;      result._44 = 1.0f;
@@ -5207,7 +5872,7 @@ Quaternion::Quaternion( const float* pf )
 //      引数付きコンストラクタです.
 //-----------------------------------------------------------------------------
 inline
-Quaternion::Quaternion( float nx, float ny, float nz, float nw )
+constexpr Quaternion::Quaternion( float nx, float ny, float nz, float nw )
 : x( nx )
 , y( ny )
 , z( nz )
@@ -5260,14 +5925,18 @@ Quaternion& Quaternion::operator -= ( const Quaternion& q )
 inline
 Quaternion& Quaternion::operator *= ( const Quaternion& q )
 {
+#if ASDX_SIMD
+    simd::Store4( &x, simd::MultiplyQuaternion( simd::Load4( &x ), simd::Load4( &q.x ) ) );
+#else
     auto X = ( q.x * w ) + ( x * q.w ) + ( q.y * z ) - ( q.z * y );
     auto Y = ( q.y * w ) + ( y * q.w ) + ( q.z * x ) - ( q.x * z );
     auto Z = ( q.z * w ) + ( z * q.w ) + ( q.x * y ) - ( q.y * x );
-    auto W = ( q.w * w ) - ( q.x * x ) - ( q.y * y ) + ( q.z * z );
+    auto W = ( q.w * w ) - ( q.x * x ) - ( q.y * y ) - ( q.z * z );
     x = X;
     y = Y;
     z = Z;
     w = W;
+#endif
     return (*this);
 }
 
@@ -5317,27 +5986,33 @@ Quaternion Quaternion::operator - () const
 //-----------------------------------------------------------------------------
 inline 
 Quaternion Quaternion::operator + ( const Quaternion& q ) const
-{ return Quaternion( x + q.x, y + q.y, z + q.z, w + q.z ); }
+{ return Quaternion( x + q.x, y + q.y, z + q.z, w + q.w ); }
 
 //-----------------------------------------------------------------------------
 //      減算演算子です.
 //-----------------------------------------------------------------------------
 inline 
 Quaternion Quaternion::operator - ( const Quaternion& q ) const
-{ return Quaternion( x - q.x, y - q.y, z - q.z, w - q.z ); }
+{ return Quaternion( x - q.x, y - q.y, z - q.z, w - q.w ); }
 
 //-----------------------------------------------------------------------------
 //      乗算演算子です.
 //-----------------------------------------------------------------------------
 inline 
 Quaternion Quaternion::operator * ( const Quaternion& q ) const
-{ 
+{
+#if ASDX_SIMD
+    Quaternion result;
+    simd::Store4( &result.x, simd::MultiplyQuaternion( simd::Load4( &x ), simd::Load4( &q.x ) ) );
+    return result;
+#else
     return Quaternion(
         ( q.x * w ) + ( x * q.w ) + ( q.y * z ) - ( q.z * y ),
         ( q.y * w ) + ( y * q.w ) + ( q.z * x ) - ( q.x * z ),
         ( q.z * w ) + ( z * q.w ) + ( q.x * y ) - ( q.y * x ),
-        ( q.w * w ) - ( q.x * x ) - ( q.y * y ) + ( q.z * z )
+        ( q.w * w ) - ( q.x * x ) - ( q.y * y ) - ( q.z * z )
    );
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -5408,12 +6083,7 @@ float Quaternion::LengthSq() const
 inline 
 Quaternion& Quaternion::Normalize()
 {
-    auto mag = Length();
-    assert( mag > 0.0f );
-    x /= mag;
-    y /= mag;
-    z /= mag;
-    w /= mag;
+    Normalize( *this, *this );
     return (*this);
 }
 
@@ -5462,7 +6132,7 @@ Quaternion& Quaternion::Identity()
 //      単位四元数を生成します.
 //-----------------------------------------------------------------------------
 inline
-Quaternion Quaternion::CreateIdentity()
+constexpr Quaternion Quaternion::CreateIdentity()
 { return Quaternion( 0.0f, 0.0f, 0.0f, 1.0f ); }
 
 //-----------------------------------------------------------------------------
@@ -5492,12 +6162,18 @@ bool Quaternion::IsNormalized( const Quaternion& value )
 inline
 Quaternion Quaternion::Multiply( const Quaternion& a, const Quaternion& b )
 {
+#if ASDX_SIMD
+    Quaternion result;
+    simd::Store4( &result.x, simd::MultiplyQuaternion( simd::Load4( &a.x ), simd::Load4( &b.x ) ) );
+    return result;
+#else
     return Quaternion(
         ( b.x * a.w ) + ( a.x * b.w ) + ( b.y * a.z ) - ( b.z * a.y ),
         ( b.y * a.w ) + ( a.y * b.w ) + ( b.z * a.x ) - ( b.x * a.z ),
         ( b.z * a.w ) + ( a.z * b.w ) + ( b.x * a.y ) - ( b.y * a.x ),
-        ( b.w * a.w ) - ( b.x * a.x ) - ( b.y * a.y ) + ( b.z * a.z )
+        ( b.w * a.w ) - ( b.x * a.x ) - ( b.y * a.y ) - ( b.z * a.z )
    );
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -5506,10 +6182,14 @@ Quaternion Quaternion::Multiply( const Quaternion& a, const Quaternion& b )
 inline
 void Quaternion::Multiply( const Quaternion& a, const Quaternion& b, Quaternion& result )
 {
+#if ASDX_SIMD
+    simd::Store4( &result.x, simd::MultiplyQuaternion( simd::Load4( &a.x ), simd::Load4( &b.x ) ) );
+#else
     result.x = ( b.x * a.w ) + ( a.x * b.w ) + ( b.y * a.z ) - ( b.z * a.y );
     result.y = ( b.y * a.w ) + ( a.y * b.w ) + ( b.z * a.x ) - ( b.x * a.z );
     result.z = ( b.z * a.w ) + ( a.z * b.w ) + ( b.x * a.y ) - ( b.y * a.x );
-    result.w = ( b.w * a.w ) - ( b.x * a.x ) - ( b.y * a.y ) + ( b.z * a.z );
+    result.w = ( b.w * a.w ) - ( b.x * a.x ) - ( b.y * a.y ) - ( b.z * a.z );
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -5517,14 +6197,20 @@ void Quaternion::Multiply( const Quaternion& a, const Quaternion& b, Quaternion&
 //-----------------------------------------------------------------------------
 inline
 float Quaternion::Dot( const Quaternion& a, const Quaternion& b )
-{ return ( a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w ); }
+{
+#if ASDX_SIMD
+    return _mm_cvtss_f32( simd::Dot4( simd::Load4( &a.x ), simd::Load4( &b.x ) ) );
+#else
+    return ( a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w );
+#endif
+}
 
 //-----------------------------------------------------------------------------
 //      内積を求めます.
 //-----------------------------------------------------------------------------
 inline
 void Quaternion::Dot( const Quaternion &a, const Quaternion &b, float &result )
-{ result = ( a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w ); }
+{ result = Dot( a, b ); }
 
 //-----------------------------------------------------------------------------
 //      共役な四元数を求めます.
@@ -5551,14 +6237,9 @@ void Quaternion::Conjugate( const Quaternion &value, Quaternion &result )
 inline
 Quaternion Quaternion::Normalize( const Quaternion& value )
 {
-    auto mag = value.Length();
-    assert( mag > 0.0f );
-    return Quaternion(
-        value.x / mag,
-        value.y / mag,
-        value.z / mag,
-        value.w / mag
-    );
+    Quaternion result;
+    Normalize( value, result );
+    return result;
 }
 
 //-----------------------------------------------------------------------------
@@ -5567,12 +6248,16 @@ Quaternion Quaternion::Normalize( const Quaternion& value )
 inline
 void Quaternion::Normalize( const Quaternion& value, Quaternion &result )
 {
-    auto mag = value.Length();
-    assert( mag > 0.0f );
-    result.x /= mag;
-    result.y /= mag;
-    result.z /= mag;
-    result.w /= mag;
+    assert( value.LengthSq() > 0.0f );
+#if ASDX_SIMD
+    simd::Store4( &result.x, simd::Normalize4( simd::Load4( &value.x ) ) );
+#else
+    auto invMag = 1.0f / value.Length();
+    result.x = value.x * invMag;
+    result.y = value.y * invMag;
+    result.z = value.z * invMag;
+    result.w = value.w * invMag;
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -6020,6 +6705,190 @@ void Quaternion::Squad
     Quaternion::Slerp( d, e, 2.0f * amount * ( 1.0f - amount ), result );
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Ray structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+inline
+Ray::Ray()
+: pos   ( 0.0f, 0.0f, 0.0f )
+, tmin  ( 0.0f )
+, dir   ( 0.0f, 0.0f, 1.0f )
+, tmax  ( FLT_MAX )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      引数付きコンストラクタです.
+//-----------------------------------------------------------------------------
+inline
+Ray::Ray( const Vector3& position, const Vector3& direction, float nearClip, float farClip )
+: pos   ( position )
+, tmin  ( nearClip )
+, dir   ( direction )
+, tmax  ( farClip )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      指定距離の位置を求めます.
+//-----------------------------------------------------------------------------
+inline
+Vector3 Ray::GetPoint( float t ) const
+{ return Vector3( pos.x + dir.x * t, pos.y + dir.y * t, pos.z + dir.z * t ); }
+
+//-----------------------------------------------------------------------------
+//      方向ベクトルの逆数を求めます.
+//-----------------------------------------------------------------------------
+inline
+Vector3 Ray::GetInvDir() const
+{ return Vector3( 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z ); }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AABB structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+inline
+AABB::AABB()
+: mini(  FLT_MAX,  FLT_MAX,  FLT_MAX )
+, maxi( -FLT_MAX, -FLT_MAX, -FLT_MAX )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      引数付きコンストラクタです.
+//-----------------------------------------------------------------------------
+inline
+AABB::AABB( const Vector3& minValue, const Vector3& maxValue )
+: mini( minValue )
+, maxi( maxValue )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      点を含むように拡張します.
+//-----------------------------------------------------------------------------
+inline
+void AABB::Expand( const Vector3& point )
+{
+    mini = Vector3::Min( mini, point );
+    maxi = Vector3::Max( maxi, point );
+}
+
+//-----------------------------------------------------------------------------
+//      ボックスを含むように拡張します.
+//-----------------------------------------------------------------------------
+inline
+void AABB::Merge( const AABB& box )
+{
+    mini = Vector3::Min( mini, box.mini );
+    maxi = Vector3::Max( maxi, box.maxi );
+}
+
+//-----------------------------------------------------------------------------
+//      空かどうかチェックします.
+//-----------------------------------------------------------------------------
+inline
+bool AABB::IsEmpty() const
+{ return ( mini.x > maxi.x ) || ( mini.y > maxi.y ) || ( mini.z > maxi.z ); }
+
+//-----------------------------------------------------------------------------
+//      中心を求めます.
+//-----------------------------------------------------------------------------
+inline
+Vector3 AABB::GetCenter() const
+{ return ( mini + maxi ) * 0.5f; }
+
+//-----------------------------------------------------------------------------
+//      大きさを求めます.
+//-----------------------------------------------------------------------------
+inline
+Vector3 AABB::GetExtent() const
+{ return maxi - mini; }
+
+//-----------------------------------------------------------------------------
+//      表面積を求めます.
+//-----------------------------------------------------------------------------
+inline
+float AABB::GetSurfaceArea() const
+{
+    auto e = maxi - mini;
+    return 2.0f * ( e.x * e.y + e.y * e.z + e.z * e.x );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AABBx4 structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      指定レーンにボックスを設定します.
+//-----------------------------------------------------------------------------
+inline
+void AABBx4::Set( uint32_t lane, const AABB& box )
+{
+    assert( lane < 4 );
+    minX[lane] = box.mini.x;
+    minY[lane] = box.mini.y;
+    minZ[lane] = box.mini.z;
+    maxX[lane] = box.maxi.x;
+    maxY[lane] = box.maxi.y;
+    maxZ[lane] = box.maxi.z;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trianglex4 structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      指定レーンに三角形を設定します.
+//-----------------------------------------------------------------------------
+inline
+void Trianglex4::Set( uint32_t lane, const Vector3& v0, const Vector3& v1, const Vector3& v2 )
+{
+    assert( lane < 4 );
+    v0x[lane] = v0.x; v0y[lane] = v0.y; v0z[lane] = v0.z;
+    v1x[lane] = v1.x; v1y[lane] = v1.y; v1z[lane] = v1.z;
+    v2x[lane] = v2.x; v2y[lane] = v2.y; v2z[lane] = v2.z;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// WatertightRay structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      レイから剪断係数を求めます.
+//-----------------------------------------------------------------------------
+inline
+WatertightRay::WatertightRay( const Ray& ray )
+{
+    auto ax = fabs( ray.dir.x );
+    auto ay = fabs( ray.dir.y );
+    auto az = fabs( ray.dir.z );
+    kz = ( ax > ay ) ? ( ( ax > az ) ? 0 : 2 ) : ( ( ay > az ) ? 1 : 2 );
+    kx = ( kz + 1 ) % 3;
+    ky = ( kx + 1 ) % 3;
+
+    const float d[3] = { ray.dir.x, ray.dir.y, ray.dir.z };
+
+    // 巻き順を保つため, Z成分が負の場合はX, Yを入れ替える.
+    if ( d[kz] < 0.0f )
+    {
+        auto tmp = kx;
+        kx = ky;
+        ky = tmp;
+    }
+
+    sx = d[kx] / d[kz];
+    sy = d[ky] / d[kz];
+    sz = 1.0f / d[kz];
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // XorShift class
 ///////////////////////////////////////////////////////////////////////////////
@@ -6031,6 +6900,13 @@ inline
 XorShift::XorShift( int seed )
 { SetSeed( seed ); }
 
+//-----------------------------------------------------------------------------
+//      ストリーム番号付きコンストラクタです.
+//-----------------------------------------------------------------------------
+inline
+XorShift::XorShift( int seed, uint64_t streamId )
+{ SetSeed( seed, streamId ); }
+
 //-----------------------------------------------------------------------------
 //      コピーコンストラクタです.
 //-----------------------------------------------------------------------------
@@ -6062,6 +6938,121 @@ void XorShift::SetSeed( int seed )
     m_W = ( seed <= 0 ) ? 88675123 : seed;
 }
 
+//-----------------------------------------------------------------------------
+//      ランダム種とストリーム番号を設定します.
+//-----------------------------------------------------------------------------
+inline
+void XorShift::SetSeed( int seed, uint64_t streamId )
+{
+    SetSeed( seed );
+    if ( streamId == 0 )
+    { return; }
+
+    uint64_t poly[2];
+    PowMod( s_Jump, streamId, poly );
+    JumpPoly( poly );
+}
+
+//-----------------------------------------------------------------------------
+//      数列を n 個先に進めます.
+//-----------------------------------------------------------------------------
+inline
+void XorShift::Advance( uint64_t n )
+{
+    // x^n mod P(x) を求めて適用.
+    static const uint64_t kX[2] = { 2, 0 };
+
+    uint64_t poly[2];
+    PowMod( kX, n, poly );
+    JumpPoly( poly );
+}
+
+//-----------------------------------------------------------------------------
+//      数列を 2^64 個先に進めます.
+//-----------------------------------------------------------------------------
+inline
+void XorShift::Jump()
+{ JumpPoly( s_Jump ); }
+
+//-----------------------------------------------------------------------------
+//      GF(2)上で a * b mod P(x) を求めます.
+//-----------------------------------------------------------------------------
+inline
+void XorShift::MulMod( const uint64_t* a, const uint64_t* b, uint64_t* result )
+{
+    uint64_t r[2] = { 0, 0 };
+    for( auto i=127; i>=0; --i )
+    {
+        // r *= x.
+        auto carry = r[1] >> 63;
+        r[1] = ( r[1] << 1 ) | ( r[0] >> 63 );
+        r[0] = ( r[0] << 1 );
+        if ( carry )
+        {
+            r[0] ^= s_Poly[0];
+            r[1] ^= s_Poly[1];
+        }
+
+        // r += b (a の i 次の係数が 1 の場合).
+        if ( ( a[i >> 6] >> ( i & 63 ) ) & 1 )
+        {
+            r[0] ^= b[0];
+            r[1] ^= b[1];
+        }
+    }
+
+    result[0] = r[0];
+    result[1] = r[1];
+}
+
+//-----------------------------------------------------------------------------
+//      GF(2)上で base^exponent mod P(x) を求めます.
+//-----------------------------------------------------------------------------
+inline
+void XorShift::PowMod( const uint64_t* base, uint64_t exponent, uint64_t* result )
+{
+    uint64_t r[2] = { 1, 0 };
+    uint64_t b[2] = { base[0], base[1] };
+    while( exponent > 0 )
+    {
+        if ( exponent & 1 )
+        { MulMod( r, b, r ); }
+        MulMod( b, b, b );
+        exponent >>= 1;
+    }
+    result[0] = r[0];
+    result[1] = r[1];
+}
+
+//-----------------------------------------------------------------------------
+//      ジャンプ多項式を適用して状態を進めます.
+//-----------------------------------------------------------------------------
+inline
+void XorShift::JumpPoly( const uint64_t* poly )
+{
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t z = 0;
+    uint32_t w = 0;
+
+    for( auto i=0; i<128; ++i )
+    {
+        if ( ( poly[i >> 6] >> ( i & 63 ) ) & 1 )
+        {
+            x ^= m_X;
+            y ^= m_Y;
+            z ^= m_Z;
+            w ^= m_W;
+        }
+        GetAsU32();
+    }
+
+    m_X = x;
+    m_Y = y;
+    m_Z = z;
+    m_W = w;
+}
+
 //-----------------------------------------------------------------------------
 //      乱数をuint32_t型として取得します.
 //-----------------------------------------------------------------------------
@@ -6210,12 +7201,20 @@ PCG::PCG( uint64_t seed )
 { SetSeed( seed ); }
 
 //-----------------------------------------------------------------------------
-//      コピーコンストラクタです.
+//      ストリーム番号付きコンストラクタです.
 //-----------------------------------------------------------------------------
 inline
-PCG::PCG( const PCG& random )
-: m_State(random.m_State)
-{ /* DO_NOTHING */ }
+PCG::PCG( uint64_t seed, uint64_t streamId )
+{ SetSeed( seed, streamId ); }
+
+//-----------------------------------------------------------------------------
+//      コピーコンストラクタです.
+//-----------------------------------------------------------------------------
+inline
+PCG::PCG( const PCG& random )
+: m_State    (random.m_State)
+, m_Increment(random.m_Increment)
+{ /* DO_NOTHING */ }
 
 //-----------------------------------------------------------------------------
 //      デストラクタです.
@@ -6230,10 +7229,48 @@ PCG::~PCG()
 inline
 void PCG::SetSeed( uint64_t seed )
 {
-    m_State = seed + s_Increment;
+    m_State = seed + m_Increment;
     GetAsU32();
 }
 
+//-----------------------------------------------------------------------------
+//      ランダム種とストリーム番号を設定します.
+//-----------------------------------------------------------------------------
+inline
+void PCG::SetSeed( uint64_t seed, uint64_t streamId )
+{
+    // 増分は奇数である必要がある.
+    m_Increment = ( streamId << 1u ) | 1u;
+    SetSeed( seed );
+}
+
+//-----------------------------------------------------------------------------
+//      数列を n 個先に進めます.
+//-----------------------------------------------------------------------------
+inline
+void PCG::Advance( uint64_t n )
+{
+    // F. Brown, "Random Number Generation with Arbitrary Stride".
+    uint64_t accMul  = 1u;
+    uint64_t accPlus = 0u;
+    uint64_t curMul  = s_Multiplier;
+    uint64_t curPlus = m_Increment;
+
+    while( n > 0 )
+    {
+        if ( n & 1 )
+        {
+            accMul  *= curMul;
+            accPlus  = accPlus * curMul + curPlus;
+        }
+        curPlus = ( curMul + 1 ) * curPlus;
+        curMul *= curMul;
+        n >>= 1;
+    }
+
+    m_State = accMul * m_State + accPlus;
+}
+
 //-----------------------------------------------------------------------------
 //      乱数をuint32_t型として取得します.
 //-----------------------------------------------------------------------------
@@ -6243,7 +7280,7 @@ uint32_t PCG::GetAsU32()
     uint64_t x = m_State;
     uint32_t count = uint32_t(x >> 59);
 
-    m_State = x * s_Multiplier + s_Increment;
+    m_State = x * s_Multiplier + m_Increment;
     x ^= x >> 18;
     return Rotate(uint32_t(x >> 27), count);
 }
@@ -6348,7 +7385,8 @@ double PCG::GetAsF64( double a, double b )
 inline
 PCG& PCG::operator = ( const PCG& random )
 {
-    m_State = random.m_State;
+    m_State     = random.m_State;
+    m_Increment = random.m_Increment;
     return (*this);
 }
 
@@ -6388,10 +7426,10 @@ void CalcONB(const Vector3& N, Vector3& T, Vector3& B)
 }
 
 //-----------------------------------------------------------------------------
-//      Hammersleyサンプルを行います.
+//      底2の Radical Inverse を求めます.
 //-----------------------------------------------------------------------------
 inline
-Vector2 Hammersley( uint32_t i, uint32_t numSamples )
+constexpr float RadicalInverse2( uint32_t i )
 {
     uint32_t bits = i;
     bits = (bits << 16u) | (bits >> 16u);
@@ -6399,9 +7437,51 @@ Vector2 Hammersley( uint32_t i, uint32_t numSamples )
     bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
     bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
     bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
-    float result = float(bits) * 2.3283064365386963e-10f; // / 0x100000000
+    return float(bits) * 2.3283064365386963e-10f; // / 0x100000000
+}
+
+//-----------------------------------------------------------------------------
+//      任意の底の Radical Inverse を求めます.
+//-----------------------------------------------------------------------------
+inline
+constexpr float RadicalInverse( uint32_t base, uint32_t i )
+{
+    double invBase = 1.0 / double(base);
+    double factor  = invBase;
+    double result  = 0.0;
+    while( i > 0 )
+    {
+        result += double(i % base) * factor;
+        i      /= base;
+        factor *= invBase;
+    }
+    return float(result);
+}
+
+//-----------------------------------------------------------------------------
+//      Hammersleyサンプルを行います.
+//-----------------------------------------------------------------------------
+inline
+constexpr Vector2 Hammersley( uint32_t i, uint32_t numSamples )
+{ return Vector2( float(i)/float(numSamples), RadicalInverse2(i) ); }
+
+//-----------------------------------------------------------------------------
+//      Haltonサンプル(底2, 3)を行います.
+//-----------------------------------------------------------------------------
+inline
+constexpr Vector2 Halton23( uint32_t i )
+{ return Vector2( RadicalInverse2(i), RadicalInverse(3, i) ); }
 
-    return Vector2( float(i)/float(numSamples), result );
+//-----------------------------------------------------------------------------
+//      R2列によるサンプルを行います.
+//-----------------------------------------------------------------------------
+inline
+constexpr Vector2 R2( uint32_t i )
+{
+    // 1/g, 1/g^2 (g は x^3 = x + 1 の実数解).
+    double x = 0.5 + 0.7548776662466927 * double(i);
+    double y = 0.5 + 0.5698402909980532 * double(i);
+    return Vector2( float(x - double(uint64_t(x))), float(y - double(uint64_t(y))) );
 }
 
 //-----------------------------------------------------------------------------
@@ -6481,6 +7561,321 @@ void GetCorners(const Vector4* planes, Vector3* corners)
     corners[6] = ComputeIntersection(planes[5], orig, dir);
 }
 
+namespace detail {
+
+//-----------------------------------------------------------------------------
+//      スラブ法で遠方側に掛ける係数 1 + 2γ(3) です.
+//-----------------------------------------------------------------------------
+static constexpr float SLAB_FAR_SCALE = 1.0000007152557373f;
+
+//-----------------------------------------------------------------------------
+//      ベクトルの成分を番号で取得します.
+//-----------------------------------------------------------------------------
+inline float GetComponent(const Vector3& value, int index)
+{ return (index == 0) ? value.x : ((index == 1) ? value.y : value.z); }
+
+} // namespace detail
+
+//-----------------------------------------------------------------------------
+//      レイとAABBの交差判定を行います.
+//-----------------------------------------------------------------------------
+inline
+bool IntersectRayAABB(const Ray& ray, const Vector3& invDir, const AABB& box, float& tnear)
+{
+    auto t0x = (box.mini.x - ray.pos.x) * invDir.x;
+    auto t1x = (box.maxi.x - ray.pos.x) * invDir.x;
+    auto t0y = (box.mini.y - ray.pos.y) * invDir.y;
+    auto t1y = (box.maxi.y - ray.pos.y) * invDir.y;
+    auto t0z = (box.mini.z - ray.pos.z) * invDir.z;
+    auto t1z = (box.maxi.z - ray.pos.z) * invDir.z;
+
+    auto tn = Max(Max(Min(t0x, t1x), Min(t0y, t1y)), Max(Min(t0z, t1z), ray.tmin));
+    auto tf = Min(Min(Max(t0x, t1x), Max(t0y, t1y)), Max(t0z, t1z)) * detail::SLAB_FAR_SCALE;
+    tf = Min(tf, ray.tmax);
+
+    tnear = tn;
+    return tn <= tf;
+}
+
+//-----------------------------------------------------------------------------
+//      レイと4個のAABBの交差判定を行います.
+//-----------------------------------------------------------------------------
+inline
+uint32_t IntersectRayAABB(const Ray& ray, const Vector3& invDir, const AABBx4& boxes, float* tnear)
+{
+#if ASDX_SIMD
+    auto px = _mm_set1_ps(ray.pos.x);
+    auto py = _mm_set1_ps(ray.pos.y);
+    auto pz = _mm_set1_ps(ray.pos.z);
+    auto ix = _mm_set1_ps(invDir.x);
+    auto iy = _mm_set1_ps(invDir.y);
+    auto iz = _mm_set1_ps(invDir.z);
+
+    auto t0x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.minX), px), ix);
+    auto t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.maxX), px), ix);
+    auto t0y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.minY), py), iy);
+    auto t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.maxY), py), iy);
+    auto t0z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.minZ), pz), iz);
+    auto t1z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.maxZ), pz), iz);
+
+    auto tn = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)), _mm_max_ps(_mm_min_ps(t0z, t1z), _mm_set1_ps(ray.tmin)));
+    auto tf = _mm_mul_ps(_mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)), _mm_max_ps(t0z, t1z)), _mm_set1_ps(detail::SLAB_FAR_SCALE));
+    tf = _mm_min_ps(tf, _mm_set1_ps(ray.tmax));
+
+    _mm_storeu_ps(tnear, tn);
+    return uint32_t(_mm_movemask_ps(_mm_cmple_ps(tn, tf)));
+#else
+    uint32_t mask = 0;
+    for(auto i=0; i<4; ++i)
+    {
+        AABB box(Vector3(boxes.minX[i], boxes.minY[i], boxes.minZ[i]), Vector3(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]));
+        if (IntersectRayAABB(ray, invDir, box, tnear[i]))
+        { mask |= (1u << i); }
+    }
+    return mask;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      レイと三角形の交差判定を行います(Moller-Trumbore法).
+//-----------------------------------------------------------------------------
+inline
+bool IntersectRayTriangle(const Ray& ray, const Vector3& v0, const Vector3& v1, const Vector3& v2, float& t, float& u, float& v)
+{
+    auto e1  = v1 - v0;
+    auto e2  = v2 - v0;
+    auto p   = Vector3::Cross(ray.dir, e2);
+    auto det = Vector3::Dot(e1, p);
+    if (det == 0.0f)
+    { return false; }
+
+    auto invDet = 1.0f / det;
+    auto s  = ray.pos - v0;
+    auto bu = Vector3::Dot(s, p) * invDet;
+    if (bu < 0.0f || bu > 1.0f)
+    { return false; }
+
+    auto q  = Vector3::Cross(s, e1);
+    auto bv = Vector3::Dot(ray.dir, q) * invDet;
+    if (bv < 0.0f || bu + bv > 1.0f)
+    { return false; }
+
+    auto dist = Vector3::Dot(e2, q) * invDet;
+    if (dist < ray.tmin || dist > ray.tmax)
+    { return false; }
+
+    t = dist;
+    u = bu;
+    v = bv;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      レイと4個の三角形の交差判定を行います(Moller-Trumbore法).
+//-----------------------------------------------------------------------------
+inline
+uint32_t IntersectRayTriangle(const Ray& ray, const Trianglex4& tris, float* t, float* u, float* v)
+{
+#if ASDX_SIMD
+    auto dx = _mm_set1_ps(ray.dir.x);
+    auto dy = _mm_set1_ps(ray.dir.y);
+    auto dz = _mm_set1_ps(ray.dir.z);
+
+    auto v0x = _mm_load_ps(tris.v0x);
+    auto v0y = _mm_load_ps(tris.v0y);
+    auto v0z = _mm_load_ps(tris.v0z);
+
+    auto e1x = _mm_sub_ps(_mm_load_ps(tris.v1x), v0x);
+    auto e1y = _mm_sub_ps(_mm_load_ps(tris.v1y), v0y);
+    auto e1z = _mm_sub_ps(_mm_load_ps(tris.v1z), v0z);
+    auto e2x = _mm_sub_ps(_mm_load_ps(tris.v2x), v0x);
+    auto e2y = _mm_sub_ps(_mm_load_ps(tris.v2y), v0y);
+    auto e2z = _mm_sub_ps(_mm_load_ps(tris.v2z), v0z);
+
+    // p = dir x e2.
+    auto px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    auto py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    auto pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+    auto det    = simd::MulAdd(e1z, pz, simd::MulAdd(e1y, py, _mm_mul_ps(e1x, px)));
+    auto invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+    auto sx = _mm_sub_ps(_mm_set1_ps(ray.pos.x), v0x);
+    auto sy = _mm_sub_ps(_mm_set1_ps(ray.pos.y), v0y);
+    auto sz = _mm_sub_ps(_mm_set1_ps(ray.pos.z), v0z);
+    auto bu = _mm_mul_ps(simd::MulAdd(sz, pz, simd::MulAdd(sy, py, _mm_mul_ps(sx, px))), invDet);
+
+    // q = s x e1.
+    auto qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+    auto qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+    auto qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+    auto bv   = _mm_mul_ps(simd::MulAdd(dz, qz, simd::MulAdd(dy, qy, _mm_mul_ps(dx, qx))), invDet);
+    auto dist = _mm_mul_ps(simd::MulAdd(e2z, qz, simd::MulAdd(e2y, qy, _mm_mul_ps(e2x, qx))), invDet);
+
+    auto zero = _mm_setzero_ps();
+    auto hit  = _mm_cmpneq_ps(det, zero);
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(bu, zero));
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(bv, zero));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(bu, bv), _mm_set1_ps(1.0f)));
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(dist, _mm_set1_ps(ray.tmin)));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(dist, _mm_set1_ps(ray.tmax)));
+
+    _mm_storeu_ps(t, dist);
+    _mm_storeu_ps(u, bu);
+    _mm_storeu_ps(v, bv);
+    return uint32_t(_mm_movemask_ps(hit));
+#else
+    uint32_t mask = 0;
+    for(auto i=0; i<4; ++i)
+    {
+        Vector3 v0(tris.v0x[i], tris.v0y[i], tris.v0z[i]);
+        Vector3 v1(tris.v1x[i], tris.v1y[i], tris.v1z[i]);
+        Vector3 v2(tris.v2x[i], tris.v2y[i], tris.v2z[i]);
+        if (IntersectRayTriangle(ray, v0, v1, v2, t[i], u[i], v[i]))
+        { mask |= (1u << i); }
+    }
+    return mask;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      レイと三角形の交差判定を行います(Woop らの水密な判定).
+//-----------------------------------------------------------------------------
+inline
+bool IntersectRayTriangleWatertight(const Ray& ray, const Vector3& v0, const Vector3& v1, const Vector3& v2, float& t, float& u, float& v)
+{
+    WatertightRay wr(ray);
+
+    auto a = v0 - ray.pos;
+    auto b = v1 - ray.pos;
+    auto c = v2 - ray.pos;
+
+    auto az = detail::GetComponent(a, wr.kz);
+    auto bz = detail::GetComponent(b, wr.kz);
+    auto cz = detail::GetComponent(c, wr.kz);
+
+    auto ax = detail::GetComponent(a, wr.kx) - wr.sx * az;
+    auto ay = detail::GetComponent(a, wr.ky) - wr.sy * az;
+    auto bx = detail::GetComponent(b, wr.kx) - wr.sx * bz;
+    auto by = detail::GetComponent(b, wr.ky) - wr.sy * bz;
+    auto cx = detail::GetComponent(c, wr.kx) - wr.sx * cz;
+    auto cy = detail::GetComponent(c, wr.ky) - wr.sy * cz;
+
+    // 辺関数. 隣接三角形と同じ値になるように積は縮約させない.
+    auto cxby = cx * by;
+    auto cybx = cy * bx;
+    auto axcy = ax * cy;
+    auto aycx = ay * cx;
+    auto bxay = bx * ay;
+    auto byax = by * ax;
+    auto U = cxby - cybx;
+    auto V = axcy - aycx;
+    auto W = bxay - byax;
+
+    if ((U < 0.0f || V < 0.0f || W < 0.0f) && (U > 0.0f || V > 0.0f || W > 0.0f))
+    { return false; }
+
+    auto det = U + V + W;
+    if (det == 0.0f)
+    { return false; }
+
+    auto T = (U * (wr.sz * az) + V * (wr.sz * bz)) + W * (wr.sz * cz);
+
+    // det の符号に合わせて区間判定.
+    auto sign = (det < 0.0f) ? -1.0f : 1.0f;
+    auto absDet = det * sign;
+    auto signT  = T * sign;
+    if (signT < ray.tmin * absDet || signT > ray.tmax * absDet)
+    { return false; }
+
+    auto invDet = 1.0f / det;
+    t = T * invDet;
+    u = V * invDet;
+    v = W * invDet;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      レイと4個の三角形の交差判定を行います(Woop らの水密な判定).
+//-----------------------------------------------------------------------------
+inline
+uint32_t IntersectRayTriangleWatertight(const Ray& ray, const Trianglex4& tris, float* t, float* u, float* v)
+{ return IntersectRayTriangleWatertight(ray, WatertightRay(ray), tris, t, u, v); }
+
+//-----------------------------------------------------------------------------
+//      求めておいた剪断係数を使って4個の三角形の交差判定を行います.
+//-----------------------------------------------------------------------------
+inline
+uint32_t IntersectRayTriangleWatertight(const Ray& ray, const WatertightRay& wr, const Trianglex4& tris, float* t, float* u, float* v)
+{
+#if ASDX_SIMD
+
+    const float* p0[3] = { tris.v0x, tris.v0y, tris.v0z };
+    const float* p1[3] = { tris.v1x, tris.v1y, tris.v1z };
+    const float* p2[3] = { tris.v2x, tris.v2y, tris.v2z };
+    const float  o[3]  = { ray.pos.x, ray.pos.y, ray.pos.z };
+
+    auto ox = _mm_set1_ps(o[wr.kx]);
+    auto oy = _mm_set1_ps(o[wr.ky]);
+    auto oz = _mm_set1_ps(o[wr.kz]);
+    auto sx = _mm_set1_ps(wr.sx);
+    auto sy = _mm_set1_ps(wr.sy);
+    auto sz = _mm_set1_ps(wr.sz);
+
+    auto az = _mm_sub_ps(_mm_load_ps(p0[wr.kz]), oz);
+    auto bz = _mm_sub_ps(_mm_load_ps(p1[wr.kz]), oz);
+    auto cz = _mm_sub_ps(_mm_load_ps(p2[wr.kz]), oz);
+
+    auto ax = _mm_sub_ps(_mm_sub_ps(_mm_load_ps(p0[wr.kx]), ox), _mm_mul_ps(sx, az));
+    auto ay = _mm_sub_ps(_mm_sub_ps(_mm_load_ps(p0[wr.ky]), oy), _mm_mul_ps(sy, az));
+    auto bx = _mm_sub_ps(_mm_sub_ps(_mm_load_ps(p1[wr.kx]), ox), _mm_mul_ps(sx, bz));
+    auto by = _mm_sub_ps(_mm_sub_ps(_mm_load_ps(p1[wr.ky]), oy), _mm_mul_ps(sy, bz));
+    auto cx = _mm_sub_ps(_mm_sub_ps(_mm_load_ps(p2[wr.kx]), ox), _mm_mul_ps(sx, cz));
+    auto cy = _mm_sub_ps(_mm_sub_ps(_mm_load_ps(p2[wr.ky]), oy), _mm_mul_ps(sy, cz));
+
+    auto U = _mm_sub_ps(_mm_mul_ps(cx, by), _mm_mul_ps(cy, bx));
+    auto V = _mm_sub_ps(_mm_mul_ps(ax, cy), _mm_mul_ps(ay, cx));
+    auto W = _mm_sub_ps(_mm_mul_ps(bx, ay), _mm_mul_ps(by, ax));
+
+    auto zero = _mm_setzero_ps();
+    auto anyNeg = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(U, zero), _mm_cmplt_ps(V, zero)), _mm_cmplt_ps(W, zero));
+    auto anyPos = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(U, zero), _mm_cmpgt_ps(V, zero)), _mm_cmpgt_ps(W, zero));
+    auto hit    = _mm_andnot_ps(_mm_and_ps(anyNeg, anyPos), _mm_castsi128_ps(_mm_set1_epi32(-1)));
+
+    auto det = _mm_add_ps(_mm_add_ps(U, V), W);
+    hit = _mm_and_ps(hit, _mm_cmpneq_ps(det, zero));
+
+    auto T = _mm_add_ps(_mm_add_ps(_mm_mul_ps(U, _mm_mul_ps(sz, az)), _mm_mul_ps(V, _mm_mul_ps(sz, bz))), _mm_mul_ps(W, _mm_mul_ps(sz, cz)));
+
+    auto signMask = _mm_and_ps(det, _mm_set1_ps(-0.0f));
+    auto absDet   = _mm_xor_ps(det, signMask);
+    auto signT    = _mm_xor_ps(T, signMask);
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(signT, _mm_mul_ps(_mm_set1_ps(ray.tmin), absDet)));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(signT, _mm_mul_ps(_mm_set1_ps(ray.tmax), absDet)));
+
+    auto invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    _mm_storeu_ps(t, _mm_mul_ps(T, invDet));
+    _mm_storeu_ps(u, _mm_mul_ps(V, invDet));
+    _mm_storeu_ps(v, _mm_mul_ps(W, invDet));
+    return uint32_t(_mm_movemask_ps(hit));
+#else
+    // スカラー版は三角形ごとに剪断係数を求め直すので使わない.
+    (void)wr;
+
+    uint32_t mask = 0;
+    for(auto i=0; i<4; ++i)
+    {
+        Vector3 v0(tris.v0x[i], tris.v0y[i], tris.v0z[i]);
+        Vector3 v1(tris.v1x[i], tris.v1y[i], tris.v1z[i]);
+        Vector3 v2(tris.v2x[i], tris.v2y[i], tris.v2z[i]);
+        if (IntersectRayTriangleWatertight(ray, v0, v1, v2, t[i], u[i], v[i]))
+        { mask |= (1u << i); }
+    }
+    return mask;
+#endif
+}
+
 //-----------------------------------------------------------------------------
 //      半精度浮動小数に変換します.
 //-----------------------------------------------------------------------------
@@ -6559,6 +7954,72 @@ Vector4 DecodeHalf4(const Half4& value)
     return unpacked;
 }
 
+//-----------------------------------------------------------------------------
+//      半精度浮動小数に一括変換します.
+//-----------------------------------------------------------------------------
+inline
+void EncodeHalf2(const Vector2* values, Half2* results, size_t count)
+{
+    static_assert(sizeof(Vector2) == sizeof(float) * 2, "Invalid Layout");
+    static_assert(sizeof(Half2) == sizeof(half) * 2, "Invalid Layout");
+    ToHalf(reinterpret_cast<const float*>(values), reinterpret_cast<half*>(results), count * 2);
+}
+
+//-----------------------------------------------------------------------------
+//      単精度浮動小数に一括変換します.
+//-----------------------------------------------------------------------------
+inline
+void DecodeHalf2(const Half2* values, Vector2* results, size_t count)
+{
+    static_assert(sizeof(Vector2) == sizeof(float) * 2, "Invalid Layout");
+    static_assert(sizeof(Half2) == sizeof(half) * 2, "Invalid Layout");
+    ToFloat(reinterpret_cast<const half*>(values), reinterpret_cast<float*>(results), count * 2);
+}
+
+//-----------------------------------------------------------------------------
+//      半精度浮動小数に一括変換します.
+//-----------------------------------------------------------------------------
+inline
+void EncodeHalf3(const Vector3* values, Half3* results, size_t count)
+{
+    static_assert(sizeof(Vector3) == sizeof(float) * 3, "Invalid Layout");
+    static_assert(sizeof(Half3) == sizeof(half) * 3, "Invalid Layout");
+    ToHalf(reinterpret_cast<const float*>(values), reinterpret_cast<half*>(results), count * 3);
+}
+
+//-----------------------------------------------------------------------------
+//      単精度浮動小数に一括変換します.
+//-----------------------------------------------------------------------------
+inline
+void DecodeHalf3(const Half3* values, Vector3* results, size_t count)
+{
+    static_assert(sizeof(Vector3) == sizeof(float) * 3, "Invalid Layout");
+    static_assert(sizeof(Half3) == sizeof(half) * 3, "Invalid Layout");
+    ToFloat(reinterpret_cast<const half*>(values), reinterpret_cast<float*>(results), count * 3);
+}
+
+//-----------------------------------------------------------------------------
+//      半精度浮動小数に一括変換します.
+//-----------------------------------------------------------------------------
+inline
+void EncodeHalf4(const Vector4* values, Half4* results, size_t count)
+{
+    static_assert(sizeof(Vector4) == sizeof(float) * 4, "Invalid Layout");
+    static_assert(sizeof(Half4) == sizeof(half) * 4, "Invalid Layout");
+    ToHalf(reinterpret_cast<const float*>(values), reinterpret_cast<half*>(results), count * 4);
+}
+
+//-----------------------------------------------------------------------------
+//      単精度浮動小数に一括変換します.
+//-----------------------------------------------------------------------------
+inline
+void DecodeHalf4(const Half4* values, Vector4* results, size_t count)
+{
+    static_assert(sizeof(Vector4) == sizeof(float) * 4, "Invalid Layout");
+    static_assert(sizeof(Half4) == sizeof(half) * 4, "Invalid Layout");
+    ToFloat(reinterpret_cast<const half*>(values), reinterpret_cast<float*>(results), count * 4);
+}
+
 //-----------------------------------------------------------------------------
 //      4要素UNORM形式に変換します.
 //-----------------------------------------------------------------------------
@@ -6763,6 +8224,292 @@ Vector2 DecodeSnorm2(uint16_t value)
     return result;
 }
 
+//-----------------------------------------------------------------------------
+//      八面体写像で2次元座標に変換します.
+//-----------------------------------------------------------------------------
+inline
+Vector2 EncodeOct(const Vector3& value)
+{
+    auto inv = 1.0f / (fabsf(value.x) + fabsf(value.y) + fabsf(value.z));
+
+    Vector2 result(value.x * inv, value.y * inv);
+    if (value.z < 0.0f)
+    {
+        auto x = (1.0f - fabsf(result.y)) * ((result.x >= 0.0f) ? 1.0f : -1.0f);
+        auto y = (1.0f - fabsf(result.x)) * ((result.y >= 0.0f) ? 1.0f : -1.0f);
+        result.x = x;
+        result.y = y;
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      八面体写像の2次元座標を展開します.
+//-----------------------------------------------------------------------------
+inline
+Vector3 DecodeOct(const Vector2& value)
+{
+    Vector3 result(value.x, value.y, 1.0f - fabsf(value.x) - fabsf(value.y));
+    auto t = Max(-result.z, 0.0f);
+    result.x += (result.x >= 0.0f) ? -t : t;
+    result.y += (result.y >= 0.0f) ? -t : t;
+
+    auto inv = 1.0f / sqrtf(result.x * result.x + result.y * result.y + result.z * result.z);
+    result.x *= inv;
+    result.y *= inv;
+    result.z *= inv;
+    return result;
+}
+
+namespace detail {
+
+//-----------------------------------------------------------------------------
+//      八面体形式を格納型に詰めます.
+//-----------------------------------------------------------------------------
+template<typename T>
+inline T PackOct(uint32_t value)
+{ return T(value); }
+
+template<>
+inline Oct24 PackOct<Oct24>(uint32_t value)
+{
+    Oct24 result;
+    result.bytes[0] = uint8_t(value);
+    result.bytes[1] = uint8_t(value >> 8);
+    result.bytes[2] = uint8_t(value >> 16);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      格納型から八面体形式を取り出します.
+//-----------------------------------------------------------------------------
+inline uint32_t UnpackOct(uint16_t value)
+{ return value; }
+
+inline uint32_t UnpackOct(uint32_t value)
+{ return value; }
+
+inline uint32_t UnpackOct(const Oct24& value)
+{ return uint32_t(value.bytes[0]) | (uint32_t(value.bytes[1]) << 8) | (uint32_t(value.bytes[2]) << 16); }
+
+//-----------------------------------------------------------------------------
+//      Bits bit SNORM x 2 の八面体形式に変換します.
+//-----------------------------------------------------------------------------
+template<uint32_t Bits>
+inline uint32_t EncodeOct(const Vector3& value)
+{
+    const auto scale = float((1u << (Bits - 1)) - 1);
+    const auto mask  = (1u << Bits) - 1;
+
+    auto p = asdx::EncodeOct(value);
+    auto x = int32_t(floorf(p.x * scale + 0.5f));
+    auto y = int32_t(floorf(p.y * scale + 0.5f));
+    return (uint32_t(x) & mask) | ((uint32_t(y) & mask) << Bits);
+}
+
+//-----------------------------------------------------------------------------
+//      Bits bit SNORM x 2 の八面体形式を展開します.
+//-----------------------------------------------------------------------------
+template<uint32_t Bits>
+inline Vector3 DecodeOct(uint32_t value)
+{
+    const auto invScale = 1.0f / float((1u << (Bits - 1)) - 1);
+
+    // 符号拡張.
+    auto x = int32_t(value << (32 - Bits))     >> (32 - Bits);
+    auto y = int32_t(value << (32 - Bits * 2)) >> (32 - Bits);
+
+    Vector2 p(Max(float(x) * invScale, -1.0f), Max(float(y) * invScale, -1.0f));
+    return asdx::DecodeOct(p);
+}
+
+//-----------------------------------------------------------------------------
+//      Bits bit SNORM x 2 の八面体形式に一括変換します.
+//-----------------------------------------------------------------------------
+template<uint32_t Bits, typename T>
+inline void EncodeOct(const Vector3* values, T* results, size_t count)
+{
+    size_t i = 0;
+
+#if ASDX_SIMD
+    const auto scale = _mm_set1_ps(float((1u << (Bits - 1)) - 1));
+    const auto half  = _mm_set1_ps(0.5f);
+    const auto mask  = _mm_set1_epi32(int32_t((1u << Bits) - 1));
+
+    for( ; i + 4 <= count; i += 4 )
+    {
+        auto p = values + i;
+        auto x = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+        auto y = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+        auto z = _mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z);
+
+        __m128 u, v;
+        simd::EncodeOct4(x, y, z, u, v);
+
+        auto qu = _mm_cvttps_epi32(_mm_floor_ps(_mm_add_ps(_mm_mul_ps(u, scale), half)));
+        auto qv = _mm_cvttps_epi32(_mm_floor_ps(_mm_add_ps(_mm_mul_ps(v, scale), half)));
+        auto packed = _mm_or_si128(_mm_and_si128(qu, mask), _mm_slli_epi32(_mm_and_si128(qv, mask), Bits));
+
+        if constexpr (sizeof(T) == sizeof(uint16_t))
+        { _mm_storel_epi64(reinterpret_cast<__m128i*>(results + i), _mm_packus_epi32(packed, packed)); }
+        else if constexpr (sizeof(T) == sizeof(Oct24))
+        {
+            // 各レーンの下位3バイトを詰めて, ちょうど12バイトだけ書き込む.
+            const auto compact = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+            auto bytes = _mm_shuffle_epi8(packed, compact);
+            auto dst   = reinterpret_cast<uint8_t*>(results + i);
+            auto tail  = _mm_extract_epi32(bytes, 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), bytes);
+            memcpy(dst + 8, &tail, sizeof(tail));
+        }
+        else
+        { _mm_storeu_si128(reinterpret_cast<__m128i*>(results + i), packed); }
+    }
+#endif
+
+    for( ; i < count; ++i )
+    { results[i] = PackOct<T>(EncodeOct<Bits>(values[i])); }
+}
+
+//-----------------------------------------------------------------------------
+//      Bits bit SNORM x 2 の八面体形式を一括展開します.
+//-----------------------------------------------------------------------------
+template<uint32_t Bits, typename T>
+inline void DecodeOct(const T* values, Vector3* results, size_t count)
+{
+    size_t i = 0;
+
+#if ASDX_SIMD
+    const auto invScale = _mm_set1_ps(1.0f / float((1u << (Bits - 1)) - 1));
+    const auto minusOne = _mm_set1_ps(-1.0f);
+
+    for( ; i + 4 <= count; i += 4 )
+    {
+        __m128i packed;
+        if constexpr (sizeof(T) == sizeof(uint16_t))
+        { packed = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(values + i))); }
+        else if constexpr (sizeof(T) == sizeof(Oct24))
+        {
+            // 配列の末尾を越えないよう12バイトだけ読み, 3バイトずつ各レーンに広げる.
+            const auto expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+            auto src = reinterpret_cast<const uint8_t*>(values + i);
+            int32_t tail;
+            memcpy(&tail, src + 8, sizeof(tail));
+            auto bytes = _mm_insert_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)), tail, 2);
+            packed = _mm_shuffle_epi8(bytes, expand);
+        }
+        else
+        { packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)); }
+
+        // 符号拡張.
+        auto qu = _mm_srai_epi32(_mm_slli_epi32(packed, 32 - Bits), 32 - Bits);
+        auto qv = _mm_srai_epi32(_mm_slli_epi32(packed, 32 - Bits * 2), 32 - Bits);
+
+        auto u = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(qu), invScale), minusOne);
+        auto v = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(qv), invScale), minusOne);
+
+        __m128 x, y, z;
+        simd::DecodeOct4(u, v, x, y, z);
+
+        alignas(16) float fx[4], fy[4], fz[4];
+        _mm_store_ps(fx, x);
+        _mm_store_ps(fy, y);
+        _mm_store_ps(fz, z);
+        for( auto j=0; j<4; ++j )
+        { results[i + j] = Vector3(fx[j], fy[j], fz[j]); }
+    }
+#endif
+
+    for( ; i < count; ++i )
+    { results[i] = DecodeOct<Bits>(UnpackOct(values[i])); }
+}
+
+} // namespace detail
+
+//-----------------------------------------------------------------------------
+//      16bit八面体形式に変換します.
+//-----------------------------------------------------------------------------
+inline
+uint16_t EncodeOct16(const Vector3& value)
+{ return uint16_t(detail::EncodeOct<8>(value)); }
+
+//-----------------------------------------------------------------------------
+//      16bit八面体形式を展開します.
+//-----------------------------------------------------------------------------
+inline
+Vector3 DecodeOct16(uint16_t value)
+{ return detail::DecodeOct<8>(value); }
+
+//-----------------------------------------------------------------------------
+//      24bit八面体形式に変換します.
+//-----------------------------------------------------------------------------
+inline
+Oct24 EncodeOct24(const Vector3& value)
+{ return detail::PackOct<Oct24>(detail::EncodeOct<12>(value)); }
+
+//-----------------------------------------------------------------------------
+//      24bit八面体形式を展開します.
+//-----------------------------------------------------------------------------
+inline
+Vector3 DecodeOct24(const Oct24& value)
+{ return detail::DecodeOct<12>(detail::UnpackOct(value)); }
+
+//-----------------------------------------------------------------------------
+//      32bit八面体形式に変換します.
+//-----------------------------------------------------------------------------
+inline
+uint32_t EncodeOct32(const Vector3& value)
+{ return detail::EncodeOct<16>(value); }
+
+//-----------------------------------------------------------------------------
+//      32bit八面体形式を展開します.
+//-----------------------------------------------------------------------------
+inline
+Vector3 DecodeOct32(uint32_t value)
+{ return detail::DecodeOct<16>(value); }
+
+//-----------------------------------------------------------------------------
+//      16bit八面体形式に一括変換します.
+//-----------------------------------------------------------------------------
+inline
+void EncodeOct16(const Vector3* values, uint16_t* results, size_t count)
+{ detail::EncodeOct<8>(values, results, count); }
+
+//-----------------------------------------------------------------------------
+//      16bit八面体形式を一括展開します.
+//-----------------------------------------------------------------------------
+inline
+void DecodeOct16(const uint16_t* values, Vector3* results, size_t count)
+{ detail::DecodeOct<8>(values, results, count); }
+
+//-----------------------------------------------------------------------------
+//      24bit八面体形式に一括変換します.
+//-----------------------------------------------------------------------------
+inline
+void EncodeOct24(const Vector3* values, Oct24* results, size_t count)
+{ detail::EncodeOct<12>(values, results, count); }
+
+//-----------------------------------------------------------------------------
+//      24bit八面体形式を一括展開します.
+//-----------------------------------------------------------------------------
+inline
+void DecodeOct24(const Oct24* values, Vector3* results, size_t count)
+{ detail::DecodeOct<12>(values, results, count); }
+
+//-----------------------------------------------------------------------------
+//      32bit八面体形式に一括変換します.
+//-----------------------------------------------------------------------------
+inline
+void EncodeOct32(const Vector3* values, uint32_t* results, size_t count)
+{ detail::EncodeOct<16>(values, results, count); }
+
+//-----------------------------------------------------------------------------
+//      32bit八面体形式を一括展開します.
+//-----------------------------------------------------------------------------
+inline
+void DecodeOct32(const uint32_t* values, Vector3* results, size_t count)
+{ detail::DecodeOct<16>(values, results, count); }
+
 
 } // namespace asdx
 
@@ -0,0 +1,459 @@
+﻿//-----------------------------------------------------------------------------
+// File : asdxMathFast.h
+// Desc : Fast Approximate Transcendental Functions.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asdxMathPacket.h>
+
+
+namespace asdx {
+namespace fast {
+
+//-----------------------------------------------------------------------------
+// 誤差は float の正規化数の範囲で倍精度 libm との比較により計測した値です(salty2_bench --verify).
+// 非正規化数の入力・出力は 0 として扱います.
+// スカラー版と Floatx8 版は同じ式で計算するため同じ誤差になります.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+//! @brief      2を底とする指数関数を求めます.
+//!
+//! @note       最大誤差 1.2 ULP. x < -126 は 0, x >= 128 は +∞ を返却します.
+//-----------------------------------------------------------------------------
+float   Exp2( float x );
+Floatx8 Exp2( const Floatx8& x );
+
+//-----------------------------------------------------------------------------
+//! @brief      2を底とする対数関数を求めます.
+//!
+//! @note       最大誤差 1.4 ULP.
+//!             x = 0 は -∞, x < 0 は NaN, x = +∞ は +∞ を返却します.
+//-----------------------------------------------------------------------------
+float   Log2( float x );
+Floatx8 Log2( const Floatx8& x );
+
+//-----------------------------------------------------------------------------
+//! @brief      べき乗を求めます (Exp2( y * Log2( x ) )).
+//!
+//! @note       最大誤差 (2 + 1.4 * |y * log2(x)|) ULP.
+//!             例えば sRGB の OETF (x ∈ [0.0031308, 1], y = 1/2.4) では 3 ULP,
+//!             x ∈ (0, 1] 全体では y = 1/2.4 で 40 ULP, y = 2.2 で 91 ULP です.
+//!             x = 0 は 0 (y > 0), x < 0 は NaN を返却します.
+//-----------------------------------------------------------------------------
+float   Pow( float x, float y );
+Floatx8 Pow( const Floatx8& x, const Floatx8& y );
+
+//-----------------------------------------------------------------------------
+//! @brief      正弦と余弦を同時に求めます.
+//!
+//! @note       |x| <= π で最大誤差 1.6 ULP, |x| <= 8192 で絶対誤差 1e-7 以下.
+//!             それ以上の引数では範囲縮約の精度が落ちます.
+//-----------------------------------------------------------------------------
+void SinCos( float x, float& s, float& c );
+void SinCos( const Floatx8& x, Floatx8& s, Floatx8& c );
+
+//-----------------------------------------------------------------------------
+//! @brief      逆余弦を求めます.
+//!
+//! @note       最大誤差 1.3 ULP. |x| > 1 は NaN を返却します.
+//-----------------------------------------------------------------------------
+float   Acos( float x );
+Floatx8 Acos( const Floatx8& x );
+
+//-----------------------------------------------------------------------------
+//! @brief      2引数の逆正接を求めます.
+//!
+//! @note       最大誤差 3.1 ULP. x = y = 0 は 0 を返却します. 無限大の入力は未対応です.
+//-----------------------------------------------------------------------------
+float   Atan2( float y, float x );
+Floatx8 Atan2( const Floatx8& y, const Floatx8& x );
+
+//-----------------------------------------------------------------------------
+//! @brief      誤差関数を求めます.
+//!
+//! @note       最大誤差 1.4 ULP.
+//-----------------------------------------------------------------------------
+float   Erf( float x );
+Floatx8 Erf( const Floatx8& x );
+
+
+namespace detail {
+
+//-----------------------------------------------------------------------------
+//      スカラー値を指定型に変換します.
+//-----------------------------------------------------------------------------
+template<typename T> T Splat( float value );
+template<> inline float   Splat<float>  ( float value ) { return value; }
+template<> inline Floatx8 Splat<Floatx8>( float value ) { return Floatx8::Set1( value ); }
+
+//-----------------------------------------------------------------------------
+//      基本演算 (float 版).
+//-----------------------------------------------------------------------------
+inline float Select( bool mask, float a, float b )      { return mask ? a : b; }
+inline float MulAdd( float a, float b, float c )        { return a * b + c; }
+inline float Abs   ( float value )                      { return fabsf( value ); }
+inline float Sqrt  ( float value )                      { return sqrtf( value ); }
+inline float Min   ( float a, float b )                 { return ( a < b ) ? a : b; }
+inline float Max   ( float a, float b )                 { return ( a > b ) ? a : b; }
+
+//-----------------------------------------------------------------------------
+//      基本演算 (Floatx8 版).
+//-----------------------------------------------------------------------------
+inline Floatx8 Select( const Maskx8& mask, const Floatx8& a, const Floatx8& b )    { return Floatx8::Select( mask, a, b ); }
+inline Floatx8 MulAdd( const Floatx8& a, const Floatx8& b, const Floatx8& c )     { return Floatx8::MulAdd( a, b, c ); }
+inline Floatx8 Abs   ( const Floatx8& value )                                     { return Floatx8::Abs( value ); }
+inline Floatx8 Sqrt  ( const Floatx8& value )                                     { return Floatx8::Sqrt( value ); }
+inline Floatx8 Min   ( const Floatx8& a, const Floatx8& b )                       { return Floatx8::Min( a, b ); }
+inline Floatx8 Max   ( const Floatx8& a, const Floatx8& b )                       { return Floatx8::Max( a, b ); }
+
+inline float Floor( float value )
+{
+#if ASDX_SIMD
+    auto v = _mm_set_ss( value );
+    return _mm_cvtss_f32( _mm_floor_ss( v, v ) );
+#else
+    return floorf( value );
+#endif
+}
+
+inline Floatx8 Floor( const Floatx8& value )
+{
+    Floatx8 result;
+#if ASDX_PACKET_AVX
+    result.v = _mm256_floor_ps( value.v );
+#else
+    for( auto i=0; i<8; ++i )
+    { result.v[i] = floorf( value.v[i] ); }
+#endif
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      2^i を求めます (i は [-126, 127] の整数値).
+//-----------------------------------------------------------------------------
+inline float Pow2i( float i )
+{
+    auto bits = uint32_t( int32_t( i ) + 127 ) << 23;
+    float result;
+    memcpy( &result, &bits, sizeof(result) );
+    return result;
+}
+
+inline Floatx8 Pow2i( const Floatx8& i )
+{
+    Floatx8 result;
+#if ASDX_SIMD_AVX2
+    auto bits = _mm256_add_epi32( _mm256_cvttps_epi32( i.v ), _mm256_set1_epi32( 127 ) );
+    result.v = _mm256_castsi256_ps( _mm256_slli_epi32( bits, 23 ) );
+#else
+    alignas(32) float values[8];
+    i.Store( values );
+    for( auto j=0; j<8; ++j )
+    { values[j] = Pow2i( values[j] ); }
+    result = Floatx8::Load( values );
+#endif
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      仮数部 [1, 2) と指数部に分解します.
+//-----------------------------------------------------------------------------
+inline void SplitExponent( float value, float& mantissa, float& exponent )
+{
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof(bits) );
+    exponent = float( int32_t( ( bits >> 23 ) & 0xFF ) - 127 );
+    bits = ( bits & 0x007FFFFF ) | 0x3F800000;
+    memcpy( &mantissa, &bits, sizeof(mantissa) );
+}
+
+inline void SplitExponent( const Floatx8& value, Floatx8& mantissa, Floatx8& exponent )
+{
+#if ASDX_SIMD_AVX2
+    auto bits = _mm256_castps_si256( value.v );
+    auto e    = _mm256_sub_epi32( _mm256_and_si256( _mm256_srli_epi32( bits, 23 ), _mm256_set1_epi32( 0xFF ) ), _mm256_set1_epi32( 127 ) );
+    auto m    = _mm256_or_si256( _mm256_and_si256( bits, _mm256_set1_epi32( 0x007FFFFF ) ), _mm256_set1_epi32( 0x3F800000 ) );
+    exponent.v = _mm256_cvtepi32_ps( e );
+    mantissa.v = _mm256_castsi256_ps( m );
+#else
+    alignas(32) float v[8], m[8], e[8];
+    value.Store( v );
+    for( auto i=0; i<8; ++i )
+    { SplitExponent( v[i], m[i], e[i] ); }
+    mantissa = Floatx8::Load( m );
+    exponent = Floatx8::Load( e );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      sign の符号ビットを value に掛け合わせます.
+//-----------------------------------------------------------------------------
+inline float MulSign( float value, float sign )
+{ return ( sign < 0.0f ) ? -value : value; }
+
+inline Floatx8 MulSign( const Floatx8& value, const Floatx8& sign )
+{
+#if ASDX_PACKET_AVX
+    Floatx8 result;
+    result.v = _mm256_xor_ps( value.v, _mm256_and_ps( sign.v, _mm256_set1_ps( -0.0f ) ) );
+    return result;
+#else
+    return Floatx8::Select( sign < Floatx8::Set1( 0.0f ), -value, value );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      多項式 c0 + c1 * x + c2 * x^2 + ... を Horner 法で求めます.
+//-----------------------------------------------------------------------------
+template<typename T>
+inline T Horner( const T&, float c )
+{ return Splat<T>( c ); }
+
+template<typename T, typename... Args>
+inline T Horner( const T& x, float c, Args... rest )
+{ return MulAdd( Horner( x, rest... ), x, Splat<T>( c ) ); }
+
+//-----------------------------------------------------------------------------
+//      2を底とする指数関数.
+//-----------------------------------------------------------------------------
+template<typename T>
+inline T Exp2Impl( const T& value )
+{
+    auto x = Min( Max( value, Splat<T>( -126.0f ) ), Splat<T>( 128.0f ) );
+
+    // x = i + f, f ∈ [-0.5, 0.5].
+    auto i = Floor( x + Splat<T>( 0.5f ) );
+    auto f = x - i;
+
+    // Cephes exp2f の多項式.
+    auto p = Horner( f,
+        1.0f,
+        6.931472028550421e-1f,
+        2.402264791363012e-1f,
+        5.550332471162809e-2f,
+        9.618437357674640e-3f,
+        1.339887440266574e-3f,
+        1.535336188319500e-4f );
+
+    // 2^128 は表現できないので 2 * 2^127 として掛ける.
+    auto hi = i > Splat<T>( 127.0f );
+    p = Select( hi, p + p, p );
+    i = Select( hi, i - Splat<T>( 1.0f ), i );
+
+    auto result = p * Pow2i( i );
+    result = Select( value < Splat<T>( -126.0f ), Splat<T>( 0.0f ), result );
+    result = Select( value >= Splat<T>( 128.0f ), Splat<T>( INFINITY ), result );
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      2を底とする対数関数.
+//-----------------------------------------------------------------------------
+template<typename T>
+inline T Log2Impl( const T& value )
+{
+    T m, e;
+    SplitExponent( value, m, e );
+
+    // m ∈ [sqrt(0.5), sqrt(2)) に寄せる.
+    auto big = m > Splat<T>( 1.41421356f );
+    m = Select( big, m * Splat<T>( 0.5f ), m );
+    e = Select( big, e + Splat<T>( 1.0f ), e );
+
+    // Cephes logf の多項式で ln(m) を求める.
+    auto t = m - Splat<T>( 1.0f );
+    auto z = t * t;
+    auto y = Horner( t,
+         3.3333331174e-1f,
+        -2.4999993993e-1f,
+         2.0000714765e-1f,
+        -1.6668057665e-1f,
+         1.4249322787e-1f,
+        -1.2420140846e-1f,
+         1.1676998740e-1f,
+        -1.1514610310e-1f,
+         7.0376836292e-2f );
+    y = y * t * z;
+    y = y - Splat<T>( 0.5f ) * z;
+
+    // log2(m) = (t + y) * log2(e) を誤差が溜まらないように分けて計算.
+    const auto log2eM1 = Splat<T>( 0.44269504088896340736f );
+    auto result = MulAdd( y, log2eM1, MulAdd( t, log2eM1, y ) ) + t + e;
+
+    result = Select( value == Splat<T>( 0.0f ),      Splat<T>( -INFINITY ), result );
+    result = Select( value <  Splat<T>( 0.0f ),      Splat<T>( NAN ),       result );
+    result = Select( value == Splat<T>( INFINITY ),  Splat<T>( INFINITY ),  result );
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      正弦と余弦.
+//-----------------------------------------------------------------------------
+template<typename T>
+inline void SinCosImpl( const T& value, T& s, T& c )
+{
+    auto x = Abs( value );
+
+    // π/4 単位の偶数象限 j に丸める.
+    auto j = Floor( x * Splat<T>( 1.27323954473516f ) );
+    j = j + ( j - Splat<T>( 2.0f ) * Floor( j * Splat<T>( 0.5f ) ) );
+
+    // Cody-Waite 法で範囲縮約.
+    x = ( ( x - j * Splat<T>( 0.78515625f ) ) - j * Splat<T>( 2.4187564849853515625e-4f ) ) - j * Splat<T>( 3.77489497744594108e-8f );
+
+    auto z  = x * x;
+    auto ps = MulAdd( Horner( z, -1.6666654611e-1f, 8.3321608736e-3f, -1.9515295891e-4f ) * z, x, x );
+    auto pc = MulAdd( Horner( z, 4.166664568298827e-2f, -1.388731625493765e-3f, 2.443315711809948e-5f ) * z, z, Splat<T>( 1.0f ) - Splat<T>( 0.5f ) * z );
+
+    // j mod 8 ∈ {0, 2, 4, 6}.
+    auto k    = j - Splat<T>( 8.0f ) * Floor( j * Splat<T>( 0.125f ) );
+    auto swap = ( k == Splat<T>( 2.0f ) ) | ( k == Splat<T>( 6.0f ) );
+    auto sinS = Select( k >= Splat<T>( 4.0f ), Splat<T>( -1.0f ), Splat<T>( 1.0f ) );
+    auto cosS = Select( ( k == Splat<T>( 2.0f ) ) | ( k == Splat<T>( 4.0f ) ), Splat<T>( -1.0f ), Splat<T>( 1.0f ) );
+
+    s = MulSign( Select( swap, pc, ps ) * sinS, value );
+    c = Select( swap, ps, pc ) * cosS;
+}
+
+//-----------------------------------------------------------------------------
+//      逆余弦.
+//-----------------------------------------------------------------------------
+template<typename T>
+inline T AcosImpl( const T& value )
+{
+    auto a    = Abs( value );
+    auto big  = a > Splat<T>( 0.5f );
+    auto z    = Select( big, Splat<T>( 0.5f ) * ( Splat<T>( 1.0f ) - a ), a * a );
+    auto s    = Select( big, Sqrt( z ), a );
+
+    // Cephes asinf の多項式.
+    auto p = MulAdd( Horner( z,
+        1.6666752422e-1f,
+        7.4953002686e-2f,
+        4.5470025998e-2f,
+        2.4181311049e-2f,
+        4.2163199048e-2f ) * z, s, s );
+
+    // |x| > 0.5 では acos(x) = 2 asin( sqrt( (1 - |x|) / 2 ) ) で桁落ちを避ける.
+    auto small  = Splat<T>( 1.57079632679489661923f ) - MulSign( p, value );
+    auto twoP   = p + p;
+    auto large  = Select( value > Splat<T>( 0.0f ), twoP, Splat<T>( 3.14159265358979323846f ) - twoP );
+    return Select( big, large, small );
+}
+
+//-----------------------------------------------------------------------------
+//      2引数の逆正接.
+//-----------------------------------------------------------------------------
+template<typename T>
+inline T Atan2Impl( const T& y, const T& x )
+{
+    auto ax = Abs( x );
+    auto ay = Abs( y );
+    auto mn = Min( ax, ay );
+    auto mx = Max( ax, ay );
+    auto a  = Select( mx == Splat<T>( 0.0f ), Splat<T>( 0.0f ), mn / mx );
+
+    // tan(π/8) より大きい場合は π/4 だけずらす.
+    auto shift = a > Splat<T>( 0.4142135623730950f );
+    auto t     = Select( shift, ( a - Splat<T>( 1.0f ) ) / ( a + Splat<T>( 1.0f ) ), a );
+
+    // Cephes atanf の多項式.
+    auto z = t * t;
+    auto r = MulAdd( Horner( z,
+        -3.33329491539e-1f,
+         1.99777106478e-1f,
+        -1.38776856032e-1f,
+         8.05374449538e-2f ) * z, t, t );
+    r = Select( shift, r + Splat<T>( 0.78539816339744830962f ), r );
+
+    r = Select( ay > ax, Splat<T>( 1.57079632679489661923f ) - r, r );
+    r = Select( x < Splat<T>( 0.0f ), Splat<T>( 3.14159265358979323846f ) - r, r );
+    return MulSign( r, y );
+}
+
+//-----------------------------------------------------------------------------
+//      誤差関数.
+//-----------------------------------------------------------------------------
+template<typename T>
+inline T ErfImpl( const T& value )
+{
+    auto t = Abs( value );
+    auto s = value * value;
+
+    // |x| < 1 : x + x * P(x^2).
+    auto rs = MulAdd( Horner( s,
+         1.2837916573e-01f,
+        -3.7612625825e-01f,
+         1.1283585153e-01f,
+        -2.6853812096e-02f,
+         5.1883279864e-03f,
+        -8.0101962387e-04f,
+         7.8538699079e-05f ), t, t );
+
+    // |x| >= 1 : 1 - 2^Q(|x|), Q は log2( erfc(|x|) ) の [1, 3.95] での近似多項式.
+    auto q = Horner( t,
+        -5.1047579530e-04f,
+        -1.6259744005e+00f,
+        -9.2076612316e-01f,
+        -1.4865055025e-01f,
+         3.1457972572e-02f,
+        -4.2408443145e-03f,
+         2.6771522657e-04f );
+    auto rl = Splat<T>( 1.0f ) - Exp2Impl( q );
+    rl = Min( rl, Splat<T>( 1.0f ) );
+
+    return MulSign( Select( t < Splat<T>( 1.0f ), rs, rl ), value );
+}
+
+} // namespace detail
+
+
+//-----------------------------------------------------------------------------
+//      2を底とする指数関数を求めます.
+//-----------------------------------------------------------------------------
+inline float   Exp2( float x )          { return detail::Exp2Impl( x ); }
+inline Floatx8 Exp2( const Floatx8& x ) { return detail::Exp2Impl( x ); }
+
+//-----------------------------------------------------------------------------
+//      2を底とする対数関数を求めます.
+//-----------------------------------------------------------------------------
+inline float   Log2( float x )          { return detail::Log2Impl( x ); }
+inline Floatx8 Log2( const Floatx8& x ) { return detail::Log2Impl( x ); }
+
+//-----------------------------------------------------------------------------
+//      べき乗を求めます.
+//-----------------------------------------------------------------------------
+inline float   Pow( float x, float y )                   { return detail::Exp2Impl( y * detail::Log2Impl( x ) ); }
+inline Floatx8 Pow( const Floatx8& x, const Floatx8& y ) { return detail::Exp2Impl( y * detail::Log2Impl( x ) ); }
+
+//-----------------------------------------------------------------------------
+//      正弦と余弦を同時に求めます.
+//-----------------------------------------------------------------------------
+inline void SinCos( float x, float& s, float& c )                       { detail::SinCosImpl( x, s, c ); }
+inline void SinCos( const Floatx8& x, Floatx8& s, Floatx8& c )          { detail::SinCosImpl( x, s, c ); }
+
+//-----------------------------------------------------------------------------
+//      逆余弦を求めます.
+//-----------------------------------------------------------------------------
+inline float   Acos( float x )          { return detail::AcosImpl( x ); }
+inline Floatx8 Acos( const Floatx8& x ) { return detail::AcosImpl( x ); }
+
+//-----------------------------------------------------------------------------
+//      2引数の逆正接を求めます.
+//-----------------------------------------------------------------------------
+inline float   Atan2( float y, float x )                   { return detail::Atan2Impl( y, x ); }
+inline Floatx8 Atan2( const Floatx8& y, const Floatx8& x ) { return detail::Atan2Impl( y, x ); }
+
+//-----------------------------------------------------------------------------
+//      誤差関数を求めます.
+//-----------------------------------------------------------------------------
+inline float   Erf( float x )          { return detail::ErfImpl( x ); }
+inline Floatx8 Erf( const Floatx8& x ) { return detail::ErfImpl( x ); }
+
+} // namespace fast
+} // namespace asdx
@@ -0,0 +1,1578 @@
+﻿//-----------------------------------------------------------------------------
+// File : asdxMathPacket.h
+// Desc : SoA Packet Math Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asdxMath.h>
+
+#if defined(__AVX__) && !defined(ASDX_DISABLE_SIMD)
+    #ifndef ASDX_PACKET_AVX
+    #define ASDX_PACKET_AVX     1
+    #endif//ASDX_PACKET_AVX
+    #include <immintrin.h>
+#endif
+
+
+namespace asdx {
+
+//-----------------------------------------------------------------------------
+// Forward Declarations
+//-----------------------------------------------------------------------------
+struct Maskx8;
+struct Floatx8;
+struct Vector3x8;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Maskx8 structure
+// 8レーン分の比較結果 (各レーン全ビット1で真).
+///////////////////////////////////////////////////////////////////////////////
+struct alignas(32) Maskx8
+{
+#if ASDX_PACKET_AVX
+    __m256      v;
+#else
+    uint32_t    v[8];
+#endif
+
+    //-------------------------------------------------------------------------
+    //! @brief      全レーンを指定値で初期化します.
+    //-------------------------------------------------------------------------
+    static Maskx8 Set1( bool value );
+
+    //-------------------------------------------------------------------------
+    //! @brief      Embree形式の有効マスク(有効レーンが-1)から読み込みます.
+    //-------------------------------------------------------------------------
+    static Maskx8 Load( const int* valid );
+
+    //-------------------------------------------------------------------------
+    //! @brief      Embree形式の有効マスク(有効レーンが-1)として書き出します.
+    //-------------------------------------------------------------------------
+    void Store( int* valid ) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      各レーンの真偽をビットにまとめて返却します.
+    //-------------------------------------------------------------------------
+    uint32_t Bits() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定レーンが真かどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool Get( uint32_t lane ) const { return ( Bits() >> lane ) & 0x1; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      いずれかのレーンが真かどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool Any () const { return Bits() != 0; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      全レーンが真かどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool All () const { return Bits() == 0xFF; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      全レーンが偽かどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool None() const { return Bits() == 0; }
+
+    Maskx8 operator & ( const Maskx8& value ) const;
+    Maskx8 operator | ( const Maskx8& value ) const;
+    Maskx8 operator ^ ( const Maskx8& value ) const;
+    Maskx8 operator ~ () const;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Floatx8 structure
+///////////////////////////////////////////////////////////////////////////////
+struct alignas(32) Floatx8
+{
+#if ASDX_PACKET_AVX
+    __m256  v;
+#else
+    float   v[8];
+#endif
+
+    //-------------------------------------------------------------------------
+    //! @brief      全レーンを指定値で初期化します.
+    //-------------------------------------------------------------------------
+    static Floatx8 Set1( float value );
+
+    //-------------------------------------------------------------------------
+    //! @brief      連続した8要素を読み込みます.
+    //-------------------------------------------------------------------------
+    static Floatx8 Load( const float* p );
+
+    //-------------------------------------------------------------------------
+    //! @brief      連続した8要素に書き出します.
+    //-------------------------------------------------------------------------
+    void Store( float* p ) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      有効レーンのみ書き出します.
+    //-------------------------------------------------------------------------
+    void Store( float* p, const Maskx8& mask ) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定レーンの値を取得します.
+    //-------------------------------------------------------------------------
+    float Get( uint32_t lane ) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定レーンの値を設定します.
+    //-------------------------------------------------------------------------
+    void Set( uint32_t lane, float value );
+
+    Floatx8 operator - () const;
+    Floatx8 operator + ( const Floatx8& value ) const;
+    Floatx8 operator - ( const Floatx8& value ) const;
+    Floatx8 operator * ( const Floatx8& value ) const;
+    Floatx8 operator / ( const Floatx8& value ) const;
+
+    Maskx8 operator <  ( const Floatx8& value ) const;
+    Maskx8 operator <= ( const Floatx8& value ) const;
+    Maskx8 operator >  ( const Floatx8& value ) const;
+    Maskx8 operator >= ( const Floatx8& value ) const;
+    Maskx8 operator == ( const Floatx8& value ) const;
+    Maskx8 operator != ( const Floatx8& value ) const;
+
+    static Floatx8 Min   ( const Floatx8& a, const Floatx8& b );
+    static Floatx8 Max   ( const Floatx8& a, const Floatx8& b );
+    static Floatx8 Abs   ( const Floatx8& value );
+    static Floatx8 Sqrt  ( const Floatx8& value );
+    static Floatx8 MulAdd( const Floatx8& a, const Floatx8& b, const Floatx8& c );
+
+    //-------------------------------------------------------------------------
+    //! @brief      マスクが真のレーンはa, 偽のレーンはbを選択します.
+    //-------------------------------------------------------------------------
+    static Floatx8 Select( const Maskx8& mask, const Floatx8& a, const Floatx8& b );
+
+    //-------------------------------------------------------------------------
+    //! @brief      値を[mini, maxi]に制限します.
+    //-------------------------------------------------------------------------
+    static Floatx8 Clamp( const Floatx8& value, const Floatx8& mini, const Floatx8& maxi );
+
+    //-------------------------------------------------------------------------
+    //! @brief      値を[0, 1]に制限します.
+    //-------------------------------------------------------------------------
+    static Floatx8 Saturate( const Floatx8& value );
+
+    //-------------------------------------------------------------------------
+    //! @brief      線形補間を行います.
+    //-------------------------------------------------------------------------
+    static Floatx8 Lerp( const Floatx8& a, const Floatx8& b, const Floatx8& amount );
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Vector3x8 structure
+// 8本分の3次元ベクトルをSoA形式で保持します.
+///////////////////////////////////////////////////////////////////////////////
+struct Vector3x8
+{
+    Floatx8 x;      //!< X成分です.
+    Floatx8 y;      //!< Y成分です.
+    Floatx8 z;      //!< Z成分です.
+
+    //-------------------------------------------------------------------------
+    //! @brief      全レーンを同じベクトルで初期化します.
+    //-------------------------------------------------------------------------
+    static Vector3x8 Set1( const Vector3& value );
+
+    //-------------------------------------------------------------------------
+    //! @brief      SoA配列(RTCRay8::dir_x 等)から読み込みます.
+    //-------------------------------------------------------------------------
+    static Vector3x8 Load( const float* px, const float* py, const float* pz );
+
+    //-------------------------------------------------------------------------
+    //! @brief      SoA配列に書き出します.
+    //-------------------------------------------------------------------------
+    void Store( float* px, float* py, float* pz ) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      有効レーンのみSoA配列に書き出します.
+    //-------------------------------------------------------------------------
+    void Store( float* px, float* py, float* pz, const Maskx8& mask ) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定レーンのベクトルを取得します.
+    //-------------------------------------------------------------------------
+    Vector3 Get( uint32_t lane ) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定レーンのベクトルを設定します.
+    //-------------------------------------------------------------------------
+    void Set( uint32_t lane, const Vector3& value );
+
+    Vector3x8 operator - () const;
+    Vector3x8 operator + ( const Vector3x8& value ) const;
+    Vector3x8 operator - ( const Vector3x8& value ) const;
+    Vector3x8 operator * ( const Vector3x8& value ) const;
+    Vector3x8 operator * ( const Floatx8& scalar ) const;
+    Vector3x8 operator / ( const Floatx8& scalar ) const;
+
+    Floatx8 Length  () const;
+    Floatx8 LengthSq() const;
+
+    static Floatx8   Dot      ( const Vector3x8& a, const Vector3x8& b );
+    static Vector3x8 Cross    ( const Vector3x8& a, const Vector3x8& b );
+    static Vector3x8 Normalize( const Vector3x8& value );
+    static Vector3x8 Min      ( const Vector3x8& a, const Vector3x8& b );
+    static Vector3x8 Max      ( const Vector3x8& a, const Vector3x8& b );
+
+    //-------------------------------------------------------------------------
+    //! @brief      反射ベクトルを求めます(Vector3::Reflect と同じ定義).
+    //-------------------------------------------------------------------------
+    static Vector3x8 Reflect( const Vector3x8& i, const Vector3x8& n );
+
+    //-------------------------------------------------------------------------
+    //! @brief      屈折ベクトルを求めます(Vector3::Refract と同じ定義).
+    //-------------------------------------------------------------------------
+    static Vector3x8 Refract( const Vector3x8& i, const Vector3x8& n, const Floatx8& eta );
+
+    //-------------------------------------------------------------------------
+    //! @brief      線形補間を行います.
+    //-------------------------------------------------------------------------
+    static Vector3x8 Lerp( const Vector3x8& a, const Vector3x8& b, const Floatx8& amount );
+
+    //-------------------------------------------------------------------------
+    //! @brief      位置ベクトルを変換します(Vector3::Transform と同じ定義).
+    //-------------------------------------------------------------------------
+    static Vector3x8 Transform( const Vector3x8& position, const Matrix& matrix );
+
+    //-------------------------------------------------------------------------
+    //! @brief      法線ベクトルを変換します(Vector3::TransformNormal と同じ定義).
+    //-------------------------------------------------------------------------
+    static Vector3x8 TransformNormal( const Vector3x8& normal, const Matrix& matrix );
+
+    //-------------------------------------------------------------------------
+    //! @brief      マスクが真のレーンはa, 偽のレーンはbを選択します.
+    //-------------------------------------------------------------------------
+    static Vector3x8 Select( const Maskx8& mask, const Vector3x8& a, const Vector3x8& b );
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AABBx8 structure
+// 8個の軸平行境界ボックスをSoA形式で保持します.
+///////////////////////////////////////////////////////////////////////////////
+struct AABBx8
+{
+    Vector3x8   mini;   //!< 最小値です.
+    Vector3x8   maxi;   //!< 最大値です.
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定レーンにボックスを設定します.
+    //-------------------------------------------------------------------------
+    void Set( uint32_t lane, const AABB& box );
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trianglex8 structure
+// 8個の三角形をSoA形式で保持します.
+///////////////////////////////////////////////////////////////////////////////
+struct Trianglex8
+{
+    Vector3x8   v0;     //!< 頂点0です.
+    Vector3x8   v1;     //!< 頂点1です.
+    Vector3x8   v2;     //!< 頂点2です.
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定レーンに三角形を設定します.
+    //-------------------------------------------------------------------------
+    void Set( uint32_t lane, const Vector3& p0, const Vector3& p1, const Vector3& p2 );
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      レイと8個のAABBの交差判定を行います(IntersectRayAABB と同じ定義).
+//!
+//! @param[in]      ray         レイ.
+//! @param[in]      invDir      レイの方向ベクトルの逆数.
+//! @param[in]      boxes       判定するボックス.
+//! @param[out]     tnear       レーンごとの進入距離.
+//! @return     交差したレーンが真となるマスクを返却します.
+//-----------------------------------------------------------------------------
+Maskx8 IntersectRayAABB( const Ray& ray, const Vector3& invDir, const AABBx8& boxes, Floatx8& tnear );
+
+//-----------------------------------------------------------------------------
+//! @brief      レイと8個の三角形の交差判定を行います(Moller-Trumbore法).
+//!
+//! @param[in]      ray         レイ.
+//! @param[in]      tris        判定する三角形.
+//! @param[out]     t           レーンごとの交差距離.
+//! @param[out]     u           レーンごとの重心座標(頂点1の重み).
+//! @param[out]     v           レーンごとの重心座標(頂点2の重み).
+//! @return     交差したレーンが真となるマスクを返却します.
+//-----------------------------------------------------------------------------
+Maskx8 IntersectRayTriangle( const Ray& ray, const Trianglex8& tris, Floatx8& t, Floatx8& u, Floatx8& v );
+
+//-----------------------------------------------------------------------------
+//! @brief      レイと8個の三角形の水密な交差判定を行います(IntersectRayTriangleWatertight と同じ定義).
+//!
+//! @param[in]      ray         レイ.
+//! @param[in]      tris        判定する三角形.
+//! @param[out]     t           レーンごとの交差距離.
+//! @param[out]     u           レーンごとの重心座標(頂点1の重み).
+//! @param[out]     v           レーンごとの重心座標(頂点2の重み).
+//! @return     交差したレーンが真となるマスクを返却します.
+//-----------------------------------------------------------------------------
+Maskx8 IntersectRayTriangleWatertight( const Ray& ray, const Trianglex8& tris, Floatx8& t, Floatx8& u, Floatx8& v );
+
+
+///////////////////////////////////////////////////////////////////////////////
+// XorShiftx8 class
+// 8本の XorShift を同時に進めます (レーン i は XorShift( seeds[i] ) と同じ数列).
+///////////////////////////////////////////////////////////////////////////////
+class XorShiftx8
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //!
+    //! @param [in]     seeds       レーンごとの種(要素数8).
+    //-------------------------------------------------------------------------
+    explicit XorShiftx8( const int* seeds );
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //!
+    //! @param [in]     generators  レーンごとの初期状態(要素数8).
+    //-------------------------------------------------------------------------
+    explicit XorShiftx8( const XorShift* generators );
+
+    //-------------------------------------------------------------------------
+    //! @brief      ランダム種を設定します.
+    //!
+    //! @param [in]     seeds       レーンごとの種(要素数8).
+    //-------------------------------------------------------------------------
+    void SetSeed( const int* seeds );
+
+    //-------------------------------------------------------------------------
+    //! @brief      乱数をuint32_t型として取得します.
+    //!
+    //! @param [out]    result      レーンごとの乱数(要素数8).
+    //-------------------------------------------------------------------------
+    void GetAsU32( uint32_t* result );
+
+    //-------------------------------------------------------------------------
+    //! @brief      乱数を[0, 1]のfloat型として取得します.
+    //-------------------------------------------------------------------------
+    Floatx8 GetAsF32();
+
+    //-------------------------------------------------------------------------
+    //! @brief      配列を乱数で埋めます.
+    //!
+    //! @param [out]    values      格納先(values[8 * k + i] がレーン i の k 番目).
+    //! @param [in]     count       要素数.
+    //-------------------------------------------------------------------------
+    void Fill( uint32_t* values, size_t count );
+
+    //-------------------------------------------------------------------------
+    //! @brief      配列を[0, 1]の乱数で埋めます.
+    //!
+    //! @param [out]    values      格納先(values[8 * k + i] がレーン i の k 番目).
+    //! @param [in]     count       要素数.
+    //-------------------------------------------------------------------------
+    void Fill( float* values, size_t count );
+
+private:
+    //=========================================================================
+    // private variables
+    //=========================================================================
+#if ASDX_SIMD_AVX2
+    __m256i     m_X;
+    __m256i     m_Y;
+    __m256i     m_Z;
+    __m256i     m_W;
+#else
+    uint32_t    m_X[8];
+    uint32_t    m_Y[8];
+    uint32_t    m_Z[8];
+    uint32_t    m_W[8];
+#endif
+
+    //=========================================================================
+    // private methods
+    //=========================================================================
+    void Next( uint32_t* result );
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PCGx8 class
+// 8本の PCG を同時に進めます (レーン i は PCG( seeds[i] ) と同じ数列).
+///////////////////////////////////////////////////////////////////////////////
+class PCGx8
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //!
+    //! @param [in]     seeds       レーンごとの種(要素数8).
+    //-------------------------------------------------------------------------
+    explicit PCGx8( const uint64_t* seeds );
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //!
+    //! @param [in]     generators  レーンごとの初期状態(要素数8).
+    //-------------------------------------------------------------------------
+    explicit PCGx8( const PCG* generators );
+
+    //-------------------------------------------------------------------------
+    //! @brief      ランダム種を設定します.
+    //!
+    //! @param [in]     seeds       レーンごとの種(要素数8).
+    //-------------------------------------------------------------------------
+    void SetSeed( const uint64_t* seeds );
+
+    //-------------------------------------------------------------------------
+    //! @brief      乱数をuint32_t型として取得します.
+    //!
+    //! @param [out]    result      レーンごとの乱数(要素数8).
+    //-------------------------------------------------------------------------
+    void GetAsU32( uint32_t* result );
+
+    //-------------------------------------------------------------------------
+    //! @brief      乱数を[0, 1]のfloat型として取得します.
+    //-------------------------------------------------------------------------
+    Floatx8 GetAsF32();
+
+    //-------------------------------------------------------------------------
+    //! @brief      配列を乱数で埋めます.
+    //!
+    //! @param [out]    values      格納先(values[8 * k + i] がレーン i の k 番目).
+    //! @param [in]     count       要素数.
+    //-------------------------------------------------------------------------
+    void Fill( uint32_t* values, size_t count );
+
+    //-------------------------------------------------------------------------
+    //! @brief      配列を[0, 1]の乱数で埋めます.
+    //!
+    //! @param [out]    values      格納先(values[8 * k + i] がレーン i の k 番目).
+    //! @param [in]     count       要素数.
+    //-------------------------------------------------------------------------
+    void Fill( float* values, size_t count );
+
+private:
+    //=========================================================================
+    // private variables
+    //=========================================================================
+#if ASDX_SIMD_AVX2
+    __m256i     m_State    [2];     //!< レーン0-3, 4-7 の状態です.
+    __m256i     m_Increment[2];     //!< レーン0-3, 4-7 の増分です.
+#else
+    uint64_t    m_State    [8];
+    uint64_t    m_Increment[8];
+#endif
+
+    //=========================================================================
+    // private methods
+    //=========================================================================
+    void Next( uint32_t* result );
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Maskx8 structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      全レーンを指定値で初期化します.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Maskx8::Set1( bool value )
+{
+    Maskx8 result;
+#if ASDX_PACKET_AVX
+    result.v = _mm256_castsi256_ps( _mm256_set1_epi32( value ? -1 : 0 ) );
+#else
+    for( auto i=0; i<8; ++i )
+    { result.v[i] = value ? 0xFFFFFFFFu : 0u; }
+#endif
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      有効マスクから読み込みます.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Maskx8::Load( const int* valid )
+{
+    Maskx8 result;
+#if ASDX_PACKET_AVX
+    auto value = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( valid ) );
+    result.v = _mm256_cmp_ps( _mm256_cvtepi32_ps( value ), _mm256_setzero_ps(), _CMP_NEQ_UQ );
+#else
+    for( auto i=0; i<8; ++i )
+    { result.v[i] = ( valid[i] != 0 ) ? 0xFFFFFFFFu : 0u; }
+#endif
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      有効マスクとして書き出します.
+//-----------------------------------------------------------------------------
+inline
+void Maskx8::Store( int* valid ) const
+{
+#if ASDX_PACKET_AVX
+    _mm256_storeu_ps( reinterpret_cast<float*>( valid ), v );
+#else
+    for( auto i=0; i<8; ++i )
+    { valid[i] = ( v[i] != 0 ) ? -1 : 0; }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      各レーンの真偽をビットにまとめて返却します.
+//-----------------------------------------------------------------------------
+inline
+uint32_t Maskx8::Bits() const
+{
+#if ASDX_PACKET_AVX
+    return uint32_t( _mm256_movemask_ps( v ) );
+#else
+    uint32_t result = 0;
+    for( auto i=0; i<8; ++i )
+    { result |= ( v[i] >> 31 ) << i; }
+    return result;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      論理積を求めます.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Maskx8::operator & ( const Maskx8& value ) const
+{
+    Maskx8 result;
+#if ASDX_PACKET_AVX
+    result.v = _mm256_and_ps( v, value.v );
+#else
+    for( auto i=0; i<8; ++i )
+    { result.v[i] = v[i] & value.v[i]; }
+#endif
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      論理和を求めます.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Maskx8::operator | ( const Maskx8& value ) const
+{
+    Maskx8 result;
+#if ASDX_PACKET_AVX
+    result.v = _mm256_or_ps( v, value.v );
+#else
+    for( auto i=0; i<8; ++i )
+    { result.v[i] = v[i] | value.v[i]; }
+#endif
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      排他的論理和を求めます.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Maskx8::operator ^ ( const Maskx8& value ) const
+{
+    Maskx8 result;
+#if ASDX_PACKET_AVX
+    result.v = _mm256_xor_ps( v, value.v );
+#else
+    for( auto i=0; i<8; ++i )
+    { result.v[i] = v[i] ^ value.v[i]; }
+#endif
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      否定を求めます.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Maskx8::operator ~ () const
+{ return (*this) ^ Maskx8::Set1( true ); }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Floatx8 structure
+///////////////////////////////////////////////////////////////////////////////
+
+#if ASDX_PACKET_AVX
+    #define ASDX_PACKET_OP( op_avx, op_scalar )                 \
+        Floatx8 result;                                         \
+        result.v = op_avx;                                      \
+        return result;
+    #define ASDX_PACKET_CMP( a, b, cmp, op_scalar )             \
+        Maskx8 result;                                          \
+        result.v = _mm256_cmp_ps( (a).v, (b).v, cmp );          \
+        return result;
+#else
+    #define ASDX_PACKET_OP( op_avx, op_scalar )                 \
+        Floatx8 result;                                         \
+        for( auto i=0; i<8; ++i ) { result.v[i] = op_scalar; }  \
+        return result;
+    #define ASDX_PACKET_CMP( a, b, cmp, op_scalar )             \
+        Maskx8 result;                                          \
+        for( auto i=0; i<8; ++i )                               \
+        { result.v[i] = ( op_scalar ) ? 0xFFFFFFFFu : 0u; }     \
+        return result;
+#endif
+
+//-----------------------------------------------------------------------------
+//      全レーンを指定値で初期化します.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::Set1( float value )
+{ ASDX_PACKET_OP( _mm256_set1_ps( value ), value ) }
+
+//-----------------------------------------------------------------------------
+//      連続した8要素を読み込みます.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::Load( const float* p )
+{ ASDX_PACKET_OP( _mm256_loadu_ps( p ), p[i] ) }
+
+//-----------------------------------------------------------------------------
+//      連続した8要素に書き出します.
+//-----------------------------------------------------------------------------
+inline
+void Floatx8::Store( float* p ) const
+{
+#if ASDX_PACKET_AVX
+    _mm256_storeu_ps( p, v );
+#else
+    for( auto i=0; i<8; ++i )
+    { p[i] = v[i]; }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      有効レーンのみ書き出します.
+//-----------------------------------------------------------------------------
+inline
+void Floatx8::Store( float* p, const Maskx8& mask ) const
+{
+#if ASDX_PACKET_AVX
+    _mm256_maskstore_ps( p, _mm256_castps_si256( mask.v ), v );
+#else
+    for( auto i=0; i<8; ++i )
+    {
+        if ( mask.v[i] != 0 )
+        { p[i] = v[i]; }
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      指定レーンの値を取得します.
+//-----------------------------------------------------------------------------
+inline
+float Floatx8::Get( uint32_t lane ) const
+{
+    assert( lane < 8 );
+    alignas(32) float values[8];
+    Store( values );
+    return values[lane];
+}
+
+//-----------------------------------------------------------------------------
+//      指定レーンの値を設定します.
+//-----------------------------------------------------------------------------
+inline
+void Floatx8::Set( uint32_t lane, float value )
+{
+    assert( lane < 8 );
+    alignas(32) float values[8];
+    Store( values );
+    values[lane] = value;
+    *this = Load( values );
+}
+
+//-----------------------------------------------------------------------------
+//      負符号演算子です.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::operator - () const
+{ ASDX_PACKET_OP( _mm256_xor_ps( v, _mm256_set1_ps( -0.0f ) ), -v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      加算演算子です.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::operator + ( const Floatx8& value ) const
+{ ASDX_PACKET_OP( _mm256_add_ps( v, value.v ), v[i] + value.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      減算演算子です.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::operator - ( const Floatx8& value ) const
+{ ASDX_PACKET_OP( _mm256_sub_ps( v, value.v ), v[i] - value.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      乗算演算子です.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::operator * ( const Floatx8& value ) const
+{ ASDX_PACKET_OP( _mm256_mul_ps( v, value.v ), v[i] * value.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      除算演算子です.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::operator / ( const Floatx8& value ) const
+{ ASDX_PACKET_OP( _mm256_div_ps( v, value.v ), v[i] / value.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      比較演算子です.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Floatx8::operator < ( const Floatx8& value ) const
+{ ASDX_PACKET_CMP( *this, value, _CMP_LT_OQ, v[i] < value.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      比較演算子です.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Floatx8::operator <= ( const Floatx8& value ) const
+{ ASDX_PACKET_CMP( *this, value, _CMP_LE_OQ, v[i] <= value.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      比較演算子です.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Floatx8::operator > ( const Floatx8& value ) const
+{ ASDX_PACKET_CMP( *this, value, _CMP_GT_OQ, v[i] > value.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      比較演算子です.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Floatx8::operator >= ( const Floatx8& value ) const
+{ ASDX_PACKET_CMP( *this, value, _CMP_GE_OQ, v[i] >= value.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      等価比較演算子です.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Floatx8::operator == ( const Floatx8& value ) const
+{ ASDX_PACKET_CMP( *this, value, _CMP_EQ_OQ, v[i] == value.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      非等価比較演算子です.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 Floatx8::operator != ( const Floatx8& value ) const
+{ ASDX_PACKET_CMP( *this, value, _CMP_NEQ_UQ, v[i] != value.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      最小値を求めます.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::Min( const Floatx8& a, const Floatx8& b )
+{ ASDX_PACKET_OP( _mm256_min_ps( a.v, b.v ), ( a.v[i] < b.v[i] ) ? a.v[i] : b.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      最大値を求めます.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::Max( const Floatx8& a, const Floatx8& b )
+{ ASDX_PACKET_OP( _mm256_max_ps( a.v, b.v ), ( a.v[i] > b.v[i] ) ? a.v[i] : b.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      絶対値を求めます.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::Abs( const Floatx8& value )
+{ ASDX_PACKET_OP( _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), value.v ), fabsf( value.v[i] ) ) }
+
+//-----------------------------------------------------------------------------
+//      平方根を求めます.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::Sqrt( const Floatx8& value )
+{ ASDX_PACKET_OP( _mm256_sqrt_ps( value.v ), sqrtf( value.v[i] ) ) }
+
+//-----------------------------------------------------------------------------
+//      a * b + c を求めます.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::MulAdd( const Floatx8& a, const Floatx8& b, const Floatx8& c )
+{
+#if ASDX_PACKET_AVX && defined(__FMA__)
+    ASDX_PACKET_OP( _mm256_fmadd_ps( a.v, b.v, c.v ), 0.0f )
+#else
+    return a * b + c;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      マスクに応じて値を選択します.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::Select( const Maskx8& mask, const Floatx8& a, const Floatx8& b )
+{ ASDX_PACKET_OP( _mm256_blendv_ps( b.v, a.v, mask.v ), ( mask.v[i] != 0 ) ? a.v[i] : b.v[i] ) }
+
+//-----------------------------------------------------------------------------
+//      値を範囲内に制限します.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::Clamp( const Floatx8& value, const Floatx8& mini, const Floatx8& maxi )
+{ return Max( mini, Min( maxi, value ) ); }
+
+//-----------------------------------------------------------------------------
+//      値を[0, 1]に制限します.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::Saturate( const Floatx8& value )
+{ return Clamp( value, Set1( 0.0f ), Set1( 1.0f ) ); }
+
+//-----------------------------------------------------------------------------
+//      線形補間を行います.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Floatx8::Lerp( const Floatx8& a, const Floatx8& b, const Floatx8& amount )
+{ return MulAdd( amount, b - a, a ); }
+
+#undef ASDX_PACKET_OP
+#undef ASDX_PACKET_CMP
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Vector3x8 structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      全レーンを同じベクトルで初期化します.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::Set1( const Vector3& value )
+{ return Vector3x8{ Floatx8::Set1( value.x ), Floatx8::Set1( value.y ), Floatx8::Set1( value.z ) }; }
+
+//-----------------------------------------------------------------------------
+//      SoA配列から読み込みます.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::Load( const float* px, const float* py, const float* pz )
+{ return Vector3x8{ Floatx8::Load( px ), Floatx8::Load( py ), Floatx8::Load( pz ) }; }
+
+//-----------------------------------------------------------------------------
+//      SoA配列に書き出します.
+//-----------------------------------------------------------------------------
+inline
+void Vector3x8::Store( float* px, float* py, float* pz ) const
+{
+    x.Store( px );
+    y.Store( py );
+    z.Store( pz );
+}
+
+//-----------------------------------------------------------------------------
+//      有効レーンのみSoA配列に書き出します.
+//-----------------------------------------------------------------------------
+inline
+void Vector3x8::Store( float* px, float* py, float* pz, const Maskx8& mask ) const
+{
+    x.Store( px, mask );
+    y.Store( py, mask );
+    z.Store( pz, mask );
+}
+
+//-----------------------------------------------------------------------------
+//      指定レーンのベクトルを取得します.
+//-----------------------------------------------------------------------------
+inline
+Vector3 Vector3x8::Get( uint32_t lane ) const
+{ return Vector3( x.Get( lane ), y.Get( lane ), z.Get( lane ) ); }
+
+//-----------------------------------------------------------------------------
+//      指定レーンのベクトルを設定します.
+//-----------------------------------------------------------------------------
+inline
+void Vector3x8::Set( uint32_t lane, const Vector3& value )
+{
+    x.Set( lane, value.x );
+    y.Set( lane, value.y );
+    z.Set( lane, value.z );
+}
+
+//-----------------------------------------------------------------------------
+//      負符号演算子です.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::operator - () const
+{ return Vector3x8{ -x, -y, -z }; }
+
+//-----------------------------------------------------------------------------
+//      加算演算子です.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::operator + ( const Vector3x8& value ) const
+{ return Vector3x8{ x + value.x, y + value.y, z + value.z }; }
+
+//-----------------------------------------------------------------------------
+//      減算演算子です.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::operator - ( const Vector3x8& value ) const
+{ return Vector3x8{ x - value.x, y - value.y, z - value.z }; }
+
+//-----------------------------------------------------------------------------
+//      成分ごとの乗算演算子です.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::operator * ( const Vector3x8& value ) const
+{ return Vector3x8{ x * value.x, y * value.y, z * value.z }; }
+
+//-----------------------------------------------------------------------------
+//      乗算演算子です.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::operator * ( const Floatx8& scalar ) const
+{ return Vector3x8{ x * scalar, y * scalar, z * scalar }; }
+
+//-----------------------------------------------------------------------------
+//      除算演算子です.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::operator / ( const Floatx8& scalar ) const
+{
+    auto inv = Floatx8::Set1( 1.0f ) / scalar;
+    return Vector3x8{ x * inv, y * inv, z * inv };
+}
+
+//-----------------------------------------------------------------------------
+//      ベクトルの大きさを求めます.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Vector3x8::Length() const
+{ return Floatx8::Sqrt( LengthSq() ); }
+
+//-----------------------------------------------------------------------------
+//      ベクトルの大きさの2乗値を求めます.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Vector3x8::LengthSq() const
+{ return Dot( *this, *this ); }
+
+//-----------------------------------------------------------------------------
+//      内積を求めます.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 Vector3x8::Dot( const Vector3x8& a, const Vector3x8& b )
+{ return Floatx8::MulAdd( a.z, b.z, Floatx8::MulAdd( a.y, b.y, a.x * b.x ) ); }
+
+//-----------------------------------------------------------------------------
+//      外積を求めます.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::Cross( const Vector3x8& a, const Vector3x8& b )
+{
+    return Vector3x8{
+        ( a.y * b.z ) - ( a.z * b.y ),
+        ( a.z * b.x ) - ( a.x * b.z ),
+        ( a.x * b.y ) - ( a.y * b.x )
+    };
+}
+
+//-----------------------------------------------------------------------------
+//      正規化を行います.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::Normalize( const Vector3x8& value )
+{ return value / value.Length(); }
+
+//-----------------------------------------------------------------------------
+//      成分ごとの最小値を求めます.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::Min( const Vector3x8& a, const Vector3x8& b )
+{ return Vector3x8{ Floatx8::Min( a.x, b.x ), Floatx8::Min( a.y, b.y ), Floatx8::Min( a.z, b.z ) }; }
+
+//-----------------------------------------------------------------------------
+//      成分ごとの最大値を求めます.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::Max( const Vector3x8& a, const Vector3x8& b )
+{ return Vector3x8{ Floatx8::Max( a.x, b.x ), Floatx8::Max( a.y, b.y ), Floatx8::Max( a.z, b.z ) }; }
+
+//-----------------------------------------------------------------------------
+//      反射ベクトルを求めます.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::Reflect( const Vector3x8& i, const Vector3x8& n )
+{
+    auto dot2 = Floatx8::Set1( 2.0f ) * Dot( n, i );
+    return i - n * dot2;
+}
+
+//-----------------------------------------------------------------------------
+//      屈折ベクトルを求めます.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::Refract( const Vector3x8& i, const Vector3x8& n, const Floatx8& eta )
+{
+    const auto zero = Floatx8::Set1( 0.0f );
+    const auto one  = Floatx8::Set1( 1.0f );
+
+    auto cosi   = -Dot( i, n );
+    auto cost2  = one - eta * eta * ( one - cosi * cosi );
+    auto sign   = Floatx8::Select( cost2 > zero, one, Floatx8::Select( cost2 < zero, -one, zero ) );
+    auto sqrtC2 = Floatx8::Sqrt( Floatx8::Abs( cost2 ) );
+    auto coeff  = eta * cosi - sqrtC2;
+
+    return ( i * eta + n * coeff ) * sign;
+}
+
+//-----------------------------------------------------------------------------
+//      線形補間を行います.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::Lerp( const Vector3x8& a, const Vector3x8& b, const Floatx8& amount )
+{
+    return Vector3x8{
+        Floatx8::Lerp( a.x, b.x, amount ),
+        Floatx8::Lerp( a.y, b.y, amount ),
+        Floatx8::Lerp( a.z, b.z, amount )
+    };
+}
+
+//-----------------------------------------------------------------------------
+//      位置ベクトルを変換します.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::Transform( const Vector3x8& position, const Matrix& matrix )
+{
+    auto result = TransformNormal( position, matrix );
+    result.x = result.x + Floatx8::Set1( matrix._41 );
+    result.y = result.y + Floatx8::Set1( matrix._42 );
+    result.z = result.z + Floatx8::Set1( matrix._43 );
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      法線ベクトルを変換します.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::TransformNormal( const Vector3x8& normal, const Matrix& matrix )
+{
+    return Vector3x8{
+        Floatx8::MulAdd( normal.z, Floatx8::Set1( matrix._31 ), Floatx8::MulAdd( normal.y, Floatx8::Set1( matrix._21 ), normal.x * Floatx8::Set1( matrix._11 ) ) ),
+        Floatx8::MulAdd( normal.z, Floatx8::Set1( matrix._32 ), Floatx8::MulAdd( normal.y, Floatx8::Set1( matrix._22 ), normal.x * Floatx8::Set1( matrix._12 ) ) ),
+        Floatx8::MulAdd( normal.z, Floatx8::Set1( matrix._33 ), Floatx8::MulAdd( normal.y, Floatx8::Set1( matrix._23 ), normal.x * Floatx8::Set1( matrix._13 ) ) )
+    };
+}
+
+//-----------------------------------------------------------------------------
+//      マスクに応じて値を選択します.
+//-----------------------------------------------------------------------------
+inline
+Vector3x8 Vector3x8::Select( const Maskx8& mask, const Vector3x8& a, const Vector3x8& b )
+{
+    return Vector3x8{
+        Floatx8::Select( mask, a.x, b.x ),
+        Floatx8::Select( mask, a.y, b.y ),
+        Floatx8::Select( mask, a.z, b.z )
+    };
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AABBx8 structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      指定レーンにボックスを設定します.
+//-----------------------------------------------------------------------------
+inline
+void AABBx8::Set( uint32_t lane, const AABB& box )
+{
+    mini.Set( lane, box.mini );
+    maxi.Set( lane, box.maxi );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trianglex8 structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      指定レーンに三角形を設定します.
+//-----------------------------------------------------------------------------
+inline
+void Trianglex8::Set( uint32_t lane, const Vector3& p0, const Vector3& p1, const Vector3& p2 )
+{
+    v0.Set( lane, p0 );
+    v1.Set( lane, p1 );
+    v2.Set( lane, p2 );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Intersection Functions
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      レイと8個のAABBの交差判定を行います.
+//-----------------------------------------------------------------------------
+inline
+Maskx8 IntersectRayAABB( const Ray& ray, const Vector3& invDir, const AABBx8& boxes, Floatx8& tnear )
+{
+    auto pos = Vector3x8::Set1( ray.pos );
+    auto inv = Vector3x8::Set1( invDir );
+    auto t0  = ( boxes.mini - pos ) * inv;
+    auto t1  = ( boxes.maxi - pos ) * inv;
+    auto tn  = Vector3x8::Min( t0, t1 );
+    auto tf  = Vector3x8::Max( t0, t1 );
+
+    auto n = Floatx8::Max( Floatx8::Max( tn.x, tn.y ), Floatx8::Max( tn.z, Floatx8::Set1( ray.tmin ) ) );
+    auto f = Floatx8::Min( Floatx8::Min( tf.x, tf.y ), tf.z ) * Floatx8::Set1( detail::SLAB_FAR_SCALE );
+    f = Floatx8::Min( f, Floatx8::Set1( ray.tmax ) );
+
+    tnear = n;
+    return n <= f;
+}
+
+//-----------------------------------------------------------------------------
+//      レイと8個の三角形の交差判定を行います(Moller-Trumbore法).
+//-----------------------------------------------------------------------------
+inline
+Maskx8 IntersectRayTriangle( const Ray& ray, const Trianglex8& tris, Floatx8& t, Floatx8& u, Floatx8& v )
+{
+    auto dir = Vector3x8::Set1( ray.dir );
+    auto e1  = tris.v1 - tris.v0;
+    auto e2  = tris.v2 - tris.v0;
+    auto p   = Vector3x8::Cross( dir, e2 );
+    auto det = Vector3x8::Dot( e1, p );
+
+    auto invDet = Floatx8::Set1( 1.0f ) / det;
+    auto s  = Vector3x8::Set1( ray.pos ) - tris.v0;
+    auto bu = Vector3x8::Dot( s, p ) * invDet;
+    auto q  = Vector3x8::Cross( s, e1 );
+    auto bv = Vector3x8::Dot( dir, q ) * invDet;
+    auto dist = Vector3x8::Dot( e2, q ) * invDet;
+
+    auto zero = Floatx8::Set1( 0.0f );
+    auto hit  = ( det != zero )
+              & ( bu >= zero )
+              & ( bv >= zero )
+              & ( bu + bv <= Floatx8::Set1( 1.0f ) )
+              & ( dist >= Floatx8::Set1( ray.tmin ) )
+              & ( dist <= Floatx8::Set1( ray.tmax ) );
+
+    t = dist;
+    u = bu;
+    v = bv;
+    return hit;
+}
+
+//-----------------------------------------------------------------------------
+//      レイと8個の三角形の交差判定を行います(Woop らの水密な判定).
+//-----------------------------------------------------------------------------
+inline
+Maskx8 IntersectRayTriangleWatertight( const Ray& ray, const Trianglex8& tris, Floatx8& t, Floatx8& u, Floatx8& v )
+{
+    WatertightRay wr( ray );
+
+    auto pos = Vector3x8::Set1( ray.pos );
+    auto a = tris.v0 - pos;
+    auto b = tris.v1 - pos;
+    auto c = tris.v2 - pos;
+
+    const Floatx8* pa[3] = { &a.x, &a.y, &a.z };
+    const Floatx8* pb[3] = { &b.x, &b.y, &b.z };
+    const Floatx8* pc[3] = { &c.x, &c.y, &c.z };
+
+    auto sx = Floatx8::Set1( wr.sx );
+    auto sy = Floatx8::Set1( wr.sy );
+    auto sz = Floatx8::Set1( wr.sz );
+
+    auto az = *pa[wr.kz];
+    auto bz = *pb[wr.kz];
+    auto cz = *pc[wr.kz];
+
+    auto ax = *pa[wr.kx] - sx * az;
+    auto ay = *pa[wr.ky] - sy * az;
+    auto bx = *pb[wr.kx] - sx * bz;
+    auto by = *pb[wr.ky] - sy * bz;
+    auto cx = *pc[wr.kx] - sx * cz;
+    auto cy = *pc[wr.ky] - sy * cz;
+
+    // 辺関数. 隣接三角形と同じ値になるように MulAdd は使わない.
+    auto U = cx * by - cy * bx;
+    auto V = ax * cy - ay * cx;
+    auto W = bx * ay - by * ax;
+
+    auto zero   = Floatx8::Set1( 0.0f );
+    auto anyNeg = ( U < zero ) | ( V < zero ) | ( W < zero );
+    auto anyPos = ( U > zero ) | ( V > zero ) | ( W > zero );
+
+    auto det = U + V + W;
+    auto T   = U * ( sz * az ) + V * ( sz * bz ) + W * ( sz * cz );
+
+    auto negative = det < zero;
+    auto absDet   = Floatx8::Abs( det );
+    auto signT    = Floatx8::Select( negative, -T, T );
+
+    auto hit = ~( anyNeg & anyPos )
+             & ( det != zero )
+             & ( signT >= Floatx8::Set1( ray.tmin ) * absDet )
+             & ( signT <= Floatx8::Set1( ray.tmax ) * absDet );
+
+    auto invDet = Floatx8::Set1( 1.0f ) / det;
+    t = T * invDet;
+    u = V * invDet;
+    v = W * invDet;
+    return hit;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Random Functions
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      8要素の uint32_t を [0, 1] の float に変換します (XorShift::GetAsF32 と同じ結果).
+//-----------------------------------------------------------------------------
+inline
+Floatx8 ToUnitFloatx8( const uint32_t* bits )
+{
+    Floatx8 result;
+#if ASDX_SIMD_AVX2
+    auto u  = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( bits ) );
+    // 上位16bitと下位16bitを個別に変換して1回だけ丸める (float(uint32_t) と一致).
+    auto hi = _mm256_cvtepi32_ps( _mm256_srli_epi32( u, 16 ) );
+    auto lo = _mm256_cvtepi32_ps( _mm256_and_si256( u, _mm256_set1_epi32( 0xFFFF ) ) );
+    auto f  = _mm256_add_ps( _mm256_mul_ps( hi, _mm256_set1_ps( 65536.0f ) ), lo );
+    result.v = _mm256_div_ps( f, _mm256_set1_ps( static_cast<float>( UINT32_MAX ) ) );
+#else
+    alignas(32) float values[8];
+    for( auto i=0; i<8; ++i )
+    { values[i] = static_cast<float>( bits[i] ) / static_cast<float>( UINT32_MAX ); }
+    result = Floatx8::Load( values );
+#endif
+    return result;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// XorShiftx8 class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+inline
+XorShiftx8::XorShiftx8( const int* seeds )
+{ SetSeed( seeds ); }
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+inline
+XorShiftx8::XorShiftx8( const XorShift* generators )
+{
+    alignas(32) uint32_t x[8], y[8], z[8], w[8];
+    for( auto i=0; i<8; ++i )
+    {
+        x[i] = generators[i].m_X;
+        y[i] = generators[i].m_Y;
+        z[i] = generators[i].m_Z;
+        w[i] = generators[i].m_W;
+    }
+#if ASDX_SIMD_AVX2
+    m_X = _mm256_load_si256( reinterpret_cast<const __m256i*>( x ) );
+    m_Y = _mm256_load_si256( reinterpret_cast<const __m256i*>( y ) );
+    m_Z = _mm256_load_si256( reinterpret_cast<const __m256i*>( z ) );
+    m_W = _mm256_load_si256( reinterpret_cast<const __m256i*>( w ) );
+#else
+    memcpy( m_X, x, sizeof(m_X) );
+    memcpy( m_Y, y, sizeof(m_Y) );
+    memcpy( m_Z, z, sizeof(m_Z) );
+    memcpy( m_W, w, sizeof(m_W) );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      ランダム種を設定します.
+//-----------------------------------------------------------------------------
+inline
+void XorShiftx8::SetSeed( const int* seeds )
+{
+    XorShift generators[8] = {
+        XorShift( seeds[0] ), XorShift( seeds[1] ), XorShift( seeds[2] ), XorShift( seeds[3] ),
+        XorShift( seeds[4] ), XorShift( seeds[5] ), XorShift( seeds[6] ), XorShift( seeds[7] ),
+    };
+    *this = XorShiftx8( generators );
+}
+
+//-----------------------------------------------------------------------------
+//      全レーンを1つ進めます.
+//-----------------------------------------------------------------------------
+inline
+void XorShiftx8::Next( uint32_t* result )
+{
+#if ASDX_SIMD_AVX2
+    auto t = _mm256_xor_si256( m_X, _mm256_slli_epi32( m_X, 11 ) );
+    m_X = m_Y;
+    m_Y = m_Z;
+    m_Z = m_W;
+    m_W = _mm256_xor_si256(
+        _mm256_xor_si256( m_W, _mm256_srli_epi32( m_W, 19 ) ),
+        _mm256_xor_si256( t,   _mm256_srli_epi32( t,    8 ) ) );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( result ), m_W );
+#else
+    for( auto i=0; i<8; ++i )
+    {
+        auto t = m_X[i] ^ ( m_X[i] << 11 );
+        m_X[i] = m_Y[i];
+        m_Y[i] = m_Z[i];
+        m_Z[i] = m_W[i];
+        m_W[i] = ( m_W[i] ^ ( m_W[i] >> 19 ) ) ^ ( t ^ ( t >> 8 ) );
+        result[i] = m_W[i];
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      乱数をuint32_t型として取得します.
+//-----------------------------------------------------------------------------
+inline
+void XorShiftx8::GetAsU32( uint32_t* result )
+{ Next( result ); }
+
+//-----------------------------------------------------------------------------
+//      乱数をfloat型として取得します.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 XorShiftx8::GetAsF32()
+{
+    alignas(32) uint32_t bits[8];
+    Next( bits );
+    return ToUnitFloatx8( bits );
+}
+
+//-----------------------------------------------------------------------------
+//      配列を乱数で埋めます.
+//-----------------------------------------------------------------------------
+inline
+void XorShiftx8::Fill( uint32_t* values, size_t count )
+{
+    size_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    { Next( values + i ); }
+
+    if ( i < count )
+    {
+        alignas(32) uint32_t bits[8];
+        Next( bits );
+        memcpy( values + i, bits, sizeof(uint32_t) * ( count - i ) );
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      配列を[0, 1]の乱数で埋めます.
+//-----------------------------------------------------------------------------
+inline
+void XorShiftx8::Fill( float* values, size_t count )
+{
+    size_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    { GetAsF32().Store( values + i ); }
+
+    if ( i < count )
+    {
+        alignas(32) float f[8];
+        GetAsF32().Store( f );
+        memcpy( values + i, f, sizeof(float) * ( count - i ) );
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PCGx8 class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+inline
+PCGx8::PCGx8( const uint64_t* seeds )
+{ SetSeed( seeds ); }
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+inline
+PCGx8::PCGx8( const PCG* generators )
+{
+    alignas(32) uint64_t state[8];
+    alignas(32) uint64_t inc  [8];
+    for( auto i=0; i<8; ++i )
+    {
+        state[i] = generators[i].m_State;
+        inc  [i] = generators[i].m_Increment;
+    }
+#if ASDX_SIMD_AVX2
+    m_State    [0] = _mm256_load_si256( reinterpret_cast<const __m256i*>( state + 0 ) );
+    m_State    [1] = _mm256_load_si256( reinterpret_cast<const __m256i*>( state + 4 ) );
+    m_Increment[0] = _mm256_load_si256( reinterpret_cast<const __m256i*>( inc   + 0 ) );
+    m_Increment[1] = _mm256_load_si256( reinterpret_cast<const __m256i*>( inc   + 4 ) );
+#else
+    memcpy( m_State,     state, sizeof(m_State) );
+    memcpy( m_Increment, inc,   sizeof(m_Increment) );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      ランダム種を設定します.
+//-----------------------------------------------------------------------------
+inline
+void PCGx8::SetSeed( const uint64_t* seeds )
+{
+    PCG generators[8] = {
+        PCG( seeds[0] ), PCG( seeds[1] ), PCG( seeds[2] ), PCG( seeds[3] ),
+        PCG( seeds[4] ), PCG( seeds[5] ), PCG( seeds[6] ), PCG( seeds[7] ),
+    };
+    *this = PCGx8( generators );
+}
+
+//-----------------------------------------------------------------------------
+//      全レーンを1つ進めます.
+//-----------------------------------------------------------------------------
+inline
+void PCGx8::Next( uint32_t* result )
+{
+#if ASDX_SIMD_AVX2
+    const auto mul   = _mm256_set1_epi64x( int64_t( PCG::s_Multiplier ) );
+    const auto mulHi = _mm256_srli_epi64( mul, 32 );
+
+    __m128i packed[2];
+    __m128i counts[2];
+    for( auto i=0; i<2; ++i )
+    {
+        auto x = m_State[i];
+
+        // 64bit 乗算 (下位64bitのみ).
+        auto lo = _mm256_mul_epu32( x, mul );
+        auto t1 = _mm256_mul_epu32( _mm256_srli_epi64( x, 32 ), mul );
+        auto t2 = _mm256_mul_epu32( x, mulHi );
+        m_State[i] = _mm256_add_epi64( _mm256_add_epi64( lo, _mm256_slli_epi64( _mm256_add_epi64( t1, t2 ), 32 ) ), m_Increment[i] );
+
+        auto count = _mm256_srli_epi64( x, 59 );
+        auto value = _mm256_srli_epi64( _mm256_xor_si256( x, _mm256_srli_epi64( x, 18 ) ), 27 );
+
+        // 各64bitレーンの下位32bitを詰める.
+        const auto idx = _mm256_setr_epi32( 0, 2, 4, 6, 0, 2, 4, 6 );
+        packed[i] = _mm256_castsi256_si128( _mm256_permutevar8x32_epi32( value, idx ) );
+        counts[i] = _mm256_castsi256_si128( _mm256_permutevar8x32_epi32( count, idx ) );
+    }
+
+    auto v = _mm256_inserti128_si256( _mm256_castsi128_si256( packed[0] ), packed[1], 1 );
+    auto r = _mm256_inserti128_si256( _mm256_castsi128_si256( counts[0] ), counts[1], 1 );
+    auto l = _mm256_and_si256( _mm256_sub_epi32( _mm256_setzero_si256(), r ), _mm256_set1_epi32( 31 ) );
+    auto bits = _mm256_or_si256( _mm256_srlv_epi32( v, r ), _mm256_sllv_epi32( v, l ) );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( result ), bits );
+#else
+    for( auto i=0; i<8; ++i )
+    {
+        uint64_t x = m_State[i];
+        uint32_t count = uint32_t( x >> 59 );
+
+        m_State[i] = x * PCG::s_Multiplier + m_Increment[i];
+        x ^= x >> 18;
+        result[i] = PCG::Rotate( uint32_t( x >> 27 ), count );
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      乱数をuint32_t型として取得します.
+//-----------------------------------------------------------------------------
+inline
+void PCGx8::GetAsU32( uint32_t* result )
+{ Next( result ); }
+
+//-----------------------------------------------------------------------------
+//      乱数をfloat型として取得します.
+//-----------------------------------------------------------------------------
+inline
+Floatx8 PCGx8::GetAsF32()
+{
+    alignas(32) uint32_t bits[8];
+    Next( bits );
+    return ToUnitFloatx8( bits );
+}
+
+//-----------------------------------------------------------------------------
+//      配列を乱数で埋めます.
+//-----------------------------------------------------------------------------
+inline
+void PCGx8::Fill( uint32_t* values, size_t count )
+{
+    size_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    { Next( values + i ); }
+
+    if ( i < count )
+    {
+        alignas(32) uint32_t bits[8];
+        Next( bits );
+        memcpy( values + i, bits, sizeof(uint32_t) * ( count - i ) );
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      配列を[0, 1]の乱数で埋めます.
+//-----------------------------------------------------------------------------
+inline
+void PCGx8::Fill( float* values, size_t count )
+{
+    size_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    { GetAsF32().Store( values + i ); }
+
+    if ( i < count )
+    {
+        alignas(32) float f[8];
+        GetAsF32().Store( f );
+        memcpy( values + i, f, sizeof(float) * ( count - i ) );
+    }
+}
+
+} // namespace asdx
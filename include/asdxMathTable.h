@@ -0,0 +1,127 @@
+﻿//-----------------------------------------------------------------------------
+// File : asdxMathTable.h
+// Desc : Compile-Time Math Tables.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <array>
+#include <utility>
+#include <asdxMath.h>
+
+
+namespace asdx {
+
+//-----------------------------------------------------------------------------
+//! @brief      3x3の色変換行列を生成します.
+//!
+//! @param[in]      m11 ～ m33      列ベクトル形式(文献での表記)の行列要素.
+//! @return     行ベクトル形式(Vector3::TransformNormal で適用できる形)に転置した行列を返却します.
+//-----------------------------------------------------------------------------
+constexpr Matrix CreateColorMatrix
+(
+    float m11, float m12, float m13,
+    float m21, float m22, float m23,
+    float m31, float m32, float m33
+) noexcept
+{
+    return Matrix(
+        m11,  m21,  m31,  0.0f,
+        m12,  m22,  m32,  0.0f,
+        m13,  m23,  m33,  0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f );
+}
+
+//-----------------------------------------------------------------------------
+// 色空間変換行列 (全て線形値, 適用は Vector3::TransformNormal( color, matrix ) ).
+//-----------------------------------------------------------------------------
+
+//! sRGB(D65) から CIE XYZ への変換行列です.
+inline constexpr Matrix SRGB_TO_XYZ = CreateColorMatrix(
+     0.4123908f,  0.3575843f,  0.1804808f,
+     0.2126390f,  0.7151687f,  0.0721923f,
+     0.0193308f,  0.1191948f,  0.9505322f );
+
+//! CIE XYZ から sRGB(D65) への変換行列です.
+inline constexpr Matrix XYZ_TO_SRGB = CreateColorMatrix(
+     3.2409699f, -1.5373832f, -0.4986108f,
+    -0.9692436f,  1.8759675f,  0.0415551f,
+     0.0556301f, -0.2039770f,  1.0569715f );
+
+//! sRGB から ACES2065-1(AP0) への変換行列です(Bradford順応 D65 -> D60).
+inline constexpr Matrix SRGB_TO_ACES2065 = CreateColorMatrix(
+     0.4396330f,  0.3829887f,  0.1773783f,
+     0.0897764f,  0.8134394f,  0.0967841f,
+     0.0175412f,  0.1115466f,  0.8709123f );
+
+//! ACES2065-1(AP0) から sRGB への変換行列です(Bradford順応 D60 -> D65).
+inline constexpr Matrix ACES2065_TO_SRGB = CreateColorMatrix(
+     2.5216862f, -1.1341310f, -0.3875552f,
+    -0.2764799f,  1.3727191f, -0.0962392f,
+    -0.0153781f, -0.1529753f,  1.1683534f );
+
+//! sRGB から ACEScg(AP1) への変換行列です(Bradford順応 D65 -> D60).
+inline constexpr Matrix SRGB_TO_ACESCG = CreateColorMatrix(
+     0.6130974f,  0.3395231f,  0.0473795f,
+     0.0701937f,  0.9163539f,  0.0134524f,
+     0.0206156f,  0.1095698f,  0.8698146f );
+
+//! ACEScg(AP1) から sRGB への変換行列です(Bradford順応 D60 -> D65).
+inline constexpr Matrix ACESCG_TO_SRGB = CreateColorMatrix(
+     1.7050510f, -0.6217921f, -0.0832589f,
+    -0.1302564f,  1.1408047f, -0.0105483f,
+    -0.0240034f, -0.1289690f,  1.1529723f );
+
+
+namespace detail {
+
+template<uint32_t N, size_t... I>
+constexpr std::array<Vector2, N> CreateHammersley( std::index_sequence<I...> ) noexcept
+{ return {{ Hammersley( uint32_t( I ), N )... }}; }
+
+template<uint32_t N, size_t... I>
+constexpr std::array<Vector2, N> CreateHalton23( std::index_sequence<I...> ) noexcept
+{ return {{ Halton23( uint32_t( I ) + 1 )... }}; }
+
+template<uint32_t N, size_t... I>
+constexpr std::array<Vector2, N> CreateR2( std::index_sequence<I...> ) noexcept
+{ return {{ R2( uint32_t( I ) )... }}; }
+
+} // namespace detail
+
+//-----------------------------------------------------------------------------
+//! @brief      N点のHammersley点列をコンパイル時に生成します.
+//-----------------------------------------------------------------------------
+template<uint32_t N>
+constexpr std::array<Vector2, N> CreateHammersley() noexcept
+{ return detail::CreateHammersley<N>( std::make_index_sequence<N>() ); }
+
+//-----------------------------------------------------------------------------
+//! @brief      N点のHalton点列(底2, 3, 0番目を除く)をコンパイル時に生成します.
+//-----------------------------------------------------------------------------
+template<uint32_t N>
+constexpr std::array<Vector2, N> CreateHalton23() noexcept
+{ return detail::CreateHalton23<N>( std::make_index_sequence<N>() ); }
+
+//-----------------------------------------------------------------------------
+//! @brief      N点のR2列をコンパイル時に生成します.
+//-----------------------------------------------------------------------------
+template<uint32_t N>
+constexpr std::array<Vector2, N> CreateR2() noexcept
+{ return detail::CreateR2<N>( std::make_index_sequence<N>() ); }
+
+//-----------------------------------------------------------------------------
+// 事前計算済みサンプルセット ([0, 1)^2 ).
+//-----------------------------------------------------------------------------
+inline constexpr auto HAMMERSLEY_16  = CreateHammersley<16>();     //!< Hammersley 16点です.
+inline constexpr auto HAMMERSLEY_64  = CreateHammersley<64>();     //!< Hammersley 64点です.
+inline constexpr auto HAMMERSLEY_256 = CreateHammersley<256>();    //!< Hammersley 256点です.
+inline constexpr auto HALTON23_64    = CreateHalton23<64>();       //!< Halton(2, 3) 64点です.
+inline constexpr auto HALTON23_256   = CreateHalton23<256>();      //!< Halton(2, 3) 256点です.
+inline constexpr auto R2_64          = CreateR2<64>();             //!< R2列 64点です.
+inline constexpr auto R2_256         = CreateR2<256>();            //!< R2列 256点です.
+
+} // namespace asdx
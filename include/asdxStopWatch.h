@@ -9,7 +9,7 @@
 // Includes
 //-----------------------------------------------------------------------------
 #include <cstdint>
-#include <Windows.h>
+#include <chrono>
 
 
 namespace asdx {
@@ -40,29 +40,25 @@ public:
     StopWatch()
     : m_Start   ()
     , m_End     ()
-    {
-        LARGE_INTEGER freq;
-        QueryPerformanceFrequency(&freq);
-        m_InvTicksPerSec = 1.0 / double(freq.QuadPart);
-    }
+    { /* DO_NOTHING */ }
 
     //-------------------------------------------------------------------------
     //! @brief      開始点を記録します.
     //-------------------------------------------------------------------------
     void Start()
-    { QueryPerformanceCounter(&m_Start); }
+    { m_Start = Clock::now(); }
 
     //-------------------------------------------------------------------------
     //! @brief      終了点を記録します.
     //-------------------------------------------------------------------------
     void End()
-    { QueryPerformanceCounter(&m_End); }
+    { m_End = Clock::now(); }
 
     //-------------------------------------------------------------------------
     //! @brief      経過時間を秒単位で取得します.
     //-------------------------------------------------------------------------
     double GetElapsedSec() const
-    { return (m_End.QuadPart - m_Start.QuadPart) * m_InvTicksPerSec; }
+    { return std::chrono::duration<double>(m_End - m_Start).count(); }
 
     //-------------------------------------------------------------------------
     //! @brief      経過時間をミリ秒単位で取得します.
@@ -74,9 +70,11 @@ private:
     //=========================================================================
     // private variables.
     //=========================================================================
-    LARGE_INTEGER   m_Start;
-    LARGE_INTEGER   m_End;
-    double          m_InvTicksPerSec;
+    // steady_clock は Windows では QueryPerformanceCounter で実装されているので精度は変わらない.
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point   m_Start;
+    Clock::time_point   m_End;
 
     //=========================================================================
     // private methods.
@@ -0,0 +1,145 @@
+﻿//-----------------------------------------------------------------------------
+// File : attribute.h
+// Desc : Quantized Vertex Attributes.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <mesh.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SurfaceAttributes structure
+///////////////////////////////////////////////////////////////////////////////
+struct SurfaceAttributes
+{
+    asdx::Vector3   Position;       //!< 重心座標で補間した位置です(メッシュの座標系).
+    asdx::Vector3   GeometryNormal; //!< 三角形の幾何法線です(正規化済み, 頂点の巡回順で向きが決まります).
+    asdx::Vector3   Normal;         //!< 補間したシェーディング法線です(正規化済み).
+    asdx::Vector3   Tangent;        //!< Normal に直交する接線です(正規化済み).
+    asdx::Vector3   Bitangent;      //!< Normal と Tangent に直交する従法線です(正規化済み).
+    asdx::Vector2   TexCoord;       //!< 補間したテクスチャ座標です.
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      単位ベクトルを八面体写像で 32bit に量子化します.
+//!
+//! @param[in]      value       単位ベクトルです.
+//! @return     下位16bitに x, 上位16bitに y を snorm16 で格納した値を返却します.
+//! @note       丸め方向の4通りから復元誤差が最小のものを選ぶので, 誤差は最大でも 0.0075 度程度に収まります.
+//-----------------------------------------------------------------------------
+uint32_t EncodeOctNormal(const asdx::Vector3& value);
+
+//-----------------------------------------------------------------------------
+//! @brief      八面体写像で量子化した方向を正規化せずに復元します.
+//!
+//! @param[in]      value       EncodeOctNormal() で量子化した値です.
+//! @return     |x| + |y| + |z| = 1 のベクトルを返却します.
+//! @note       後で直交化して正規化する接線のように, 向きだけが必要な場合に使います.
+//-----------------------------------------------------------------------------
+inline asdx::Vector3 DecodeOctDirection(uint32_t value)
+{
+    // 交差のたびに呼ぶので, 除算は逆数の乗算にしておく.
+    auto x = std::max(float(int16_t(value & 0xffff)) * (1.0f / 32767.0f), -1.0f);
+    auto y = std::max(float(int16_t(value >> 16))    * (1.0f / 32767.0f), -1.0f);
+    auto z = 1.0f - fabsf(x) - fabsf(y);
+
+    // 下半球は折り返して格納しているので戻す.
+    auto t = std::max(-z, 0.0f);
+    x += (x >= 0.0f) ? -t : t;
+    y += (y >= 0.0f) ? -t : t;
+
+    return asdx::Vector3(x, y, z);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief      八面体写像で量子化した単位ベクトルを復元します.
+//!
+//! @param[in]      value       EncodeOctNormal() で量子化した値です.
+//! @return     正規化したベクトルを返却します.
+//-----------------------------------------------------------------------------
+inline asdx::Vector3 DecodeOctNormal(uint32_t value)
+{
+    auto v = DecodeOctDirection(value);
+    return v * (1.0f / sqrtf(asdx::Vector3::Dot(v, v)));
+}
+
+//-----------------------------------------------------------------------------
+//! @brief      テクスチャ座標を 32bit に量子化します.
+//!
+//! @param[in]      value       テクスチャ座標です.
+//! @param[in]      range       量子化の範囲です(最小値 xy, 幅 zw).
+//! @return     下位16bitに u, 上位16bitに v を unorm16 で格納した値を返却します.
+//-----------------------------------------------------------------------------
+inline uint32_t EncodeTexCoord(const asdx::Vector2& value, const asdx::Vector4& range)
+{
+    auto u = asdx::Saturate((value.x - range.x) / range.z);
+    auto v = asdx::Saturate((value.y - range.y) / range.w);
+    return uint32_t(u * 65535.0f + 0.5f) | (uint32_t(v * 65535.0f + 0.5f) << 16);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief      量子化したテクスチャ座標を復元します.
+//!
+//! @param[in]      value       EncodeTexCoord() で量子化した値です.
+//! @param[in]      range       量子化の範囲です(最小値 xy, 幅 zw).
+//! @return     テクスチャ座標を返却します.
+//-----------------------------------------------------------------------------
+inline asdx::Vector2 DecodeTexCoord(uint32_t value, const asdx::Vector4& range)
+{
+    return asdx::Vector2(
+        range.x + float(value & 0xffff) * (range.z / 65535.0f),
+        range.y + float(value >> 16)    * (range.w / 65535.0f));
+}
+
+//-----------------------------------------------------------------------------
+//! @brief      頂点属性を量子化して格納します.
+//!
+//! @param[in]      mesh        頂点座標とインデックスを設定済みのメッシュです.
+//! @param[in]      normals     頂点法線です. nullptr の場合は面積で重み付けした頂点法線を生成します.
+//! @param[in]      texcoords   テクスチャ座標です. nullptr の場合はテクスチャ座標と接線を持ちません.
+//! @param[out]     result      量子化した頂点属性です.
+//! @retval true    格納に成功.
+//! @retval false   メモリの確保に失敗.
+//! @note       テクスチャ座標がある場合は, その勾配から接線と従法線の向きを求めて格納します.
+//!             テクスチャ座標はメッシュごとの最小値と幅で量子化するので, 範囲が狭いほど精度が上がります.
+//-----------------------------------------------------------------------------
+bool EncodeAttributes
+(
+    const Mesh&             mesh,
+    const asdx::Vector3*    normals,
+    const asdx::Vector2*    texcoords,
+    VertexAttributes&       result
+);
+
+//-----------------------------------------------------------------------------
+//! @brief      交差位置の頂点属性を復元します.
+//!
+//! @param[in]      mesh        交差したメッシュです.
+//! @param[in]      primID      三角形番号です(RTCHit::primID).
+//! @param[in]      u           重心座標です(RTCHit::u).
+//! @param[in]      v           重心座標です(RTCHit::v).
+//! @param[out]     result      復元した頂点属性です.
+//! @note       三角形の3頂点分だけ復元して補間します.
+//!             法線が無い場合は幾何法線を, テクスチャ座標が無い場合は (u, v) を, 接線が無い場合は法線から求めた正規直交基底を返却します.
+//-----------------------------------------------------------------------------
+void DecodeAttributes(const Mesh& mesh, uint32_t primID, float u, float v, SurfaceAttributes& result);
+
+//-----------------------------------------------------------------------------
+//! @brief      交差位置のテクスチャ座標だけを復元します.
+//!
+//! @param[in]      mesh        交差したメッシュです.
+//! @param[in]      primID      三角形番号です(RTCHit::primID).
+//! @param[in]      u           重心座標です(RTCHit::u).
+//! @param[in]      v           重心座標です(RTCHit::v).
+//! @return     テクスチャ座標を返却します. テクスチャ座標が無い場合は (u, v) を返却します.
+//! @note       走査中のアルファテストのように, 法線や接線が不要な場合に使います.
+//-----------------------------------------------------------------------------
+asdx::Vector2 DecodeTexCoord(const Mesh& mesh, uint32_t primID, float u, float v);
@@ -0,0 +1,617 @@
+﻿//-----------------------------------------------------------------------------
+// File : bvh.h
+// Desc : Bounding Volume Hierarchy.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <asdxMath.h>
+#include <motion.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BVHHit structure
+///////////////////////////////////////////////////////////////////////////////
+struct BVHHit
+{
+    asdx::Vector3   Normal;     //!< 正規化されていない幾何法線です(Embree の Ng と同じ定義).
+    float           U;          //!< 重心座標(頂点1の重み)です.
+    float           V;          //!< 重心座標(頂点2の重み)です.
+    uint32_t        PrimID;     //!< プリミティブ番号です.
+    uint32_t        GeomID;     //!< ジオメトリ番号です.
+    uint32_t        InstID;     //!< インスタンス番号です(インスタンス経由でなければ BVH::INVALID_ID).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BVHStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct BVHStats
+{
+    uint32_t    NodeCount;      //!< 内部ノード数です.
+    uint32_t    LeafCount;      //!< リーフ数です.
+    uint32_t    TriangleCount;  //!< 三角形数です.
+    uint32_t    MaxDepth;       //!< 最大深度です.
+    size_t      MemorySize;     //!< ノードとリーフの合計サイズ(バイト)です.
+    size_t      PeakMemorySize; //!< 構築中の一時領域を含めた最大サイズ(バイト)です.
+    double      BuildMsec;      //!< 構築時間(ミリ秒)です.
+    double      RefitMsec;      //!< 直近の Refit() にかかった時間(ミリ秒)です.
+    float       NodeCost;       //!< 子の表面積の合計をルートの表面積で割った値です(走査コストの目安).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BVH class
+// 三角形専用の4分岐BVHです.
+// SAHビニングで並列構築し, 子ノードの境界を8bitに量子化して1ノード64バイトに収めます.
+// リーフは最大4個の三角形を Trianglex4 に詰め, 水密な判定でまとめて交差判定します.
+///////////////////////////////////////////////////////////////////////////////
+class BVH
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static constexpr uint32_t WIDTH         = 4;            //!< 分岐数です.
+    static constexpr uint32_t MAX_LEAF_SIZE = 4;            //!< リーフあたりの最大三角形数です.
+    static constexpr uint32_t MAX_DEPTH     = 64;           //!< 最大深度です.
+    static constexpr uint32_t INVALID_ID    = 0xFFFFFFFF;   //!< 無効な番号です.
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Node structure
+    // 子ノードの境界は Origin + Q * Scale で復元します(常に元の境界を包含).
+    ///////////////////////////////////////////////////////////////////////////
+    struct alignas(64) Node
+    {
+        float       Origin[3];      //!< 量子化の原点です.
+        float       Scale [3];      //!< 量子化の刻み幅です.
+        uint8_t     LoX[WIDTH];     //!< 子ノードの最小値(X)です.
+        uint8_t     LoY[WIDTH];     //!< 子ノードの最小値(Y)です.
+        uint8_t     LoZ[WIDTH];     //!< 子ノードの最小値(Z)です.
+        uint8_t     HiX[WIDTH];     //!< 子ノードの最大値(X)です.
+        uint8_t     HiY[WIDTH];     //!< 子ノードの最大値(Y)です.
+        uint8_t     HiZ[WIDTH];     //!< 子ノードの最大値(Z)です.
+        uint32_t    Child[WIDTH];   //!< 子ノード参照です(LEAF_BIT が立っていればリーフ番号).
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Leaf structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct alignas(16) Leaf
+    {
+        asdx::Trianglex4    Triangles;          //!< 三角形です(空きレーンは縮退三角形).
+        uint32_t            GeomID[WIDTH];      //!< ジオメトリ番号です.
+        uint32_t            PrimID[WIDTH];      //!< プリミティブ番号です.
+    };
+
+    static constexpr uint32_t LEAF_BIT  = 0x80000000;   //!< リーフを示すビットです.
+    static constexpr uint32_t EMPTY_REF = 0xFFFFFFFF;   //!< 空の子ノード参照です.
+
+    ///////////////////////////////////////////////////////////////////////////
+    // View structure
+    // 構築済みのノードとリーフへの参照です.
+    ///////////////////////////////////////////////////////////////////////////
+    struct View
+    {
+        const Node*     pNodes;         //!< ノードです(先頭がルート).
+        uint32_t        NodeCount;      //!< ノード数です.
+        const Leaf*     pLeaves;        //!< リーフです.
+        uint32_t        LeafCount;      //!< リーフ数です.
+        asdx::AABB      Bounds;         //!< シーン全体の境界です.
+    };
+
+    //-------------------------------------------------------------------------
+    //! @brief      交差を受け入れるかどうかを判定する関数です(アルファテストなど).
+    //!
+    //! @param[in]      userPtr     SetFilter() に渡したポインタです.
+    //! @param[in]      primID      プリミティブ番号です.
+    //! @param[in]      u           重心座標(頂点1の重み)です.
+    //! @param[in]      v           重心座標(頂点2の重み)です.
+    //! @retval true    交差を受け入れる.
+    //! @retval false   交差を棄却して走査を続ける.
+    //! @note       走査中に複数のスレッドから呼ばれるので, 状態を書き換えないでください.
+    //-------------------------------------------------------------------------
+    typedef bool (*FilterFunc)(const void* userPtr, uint32_t primID, float u, float v);
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    BVH() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      三角形メッシュを追加します.
+    //!
+    //! @param[in]      vertices        頂点座標です.
+    //! @param[in]      indices         インデックスです(三角形あたり3個).
+    //! @param[in]      triangleCount   三角形数です.
+    //! @return     ジオメトリ番号を返却します.
+    //! @note       頂点とインデックスは Build() が終わるまで保持してください.
+    //!             メッシュを追加して Build() し直す場合や Refit() する場合は Clear() まで保持してください.
+    //-------------------------------------------------------------------------
+    uint32_t AddTriangles(const asdx::Vector3* vertices, const uint32_t* indices, uint32_t triangleCount);
+
+    //-------------------------------------------------------------------------
+    //! @brief      時間ステップごとの頂点を持つ三角形メッシュを追加します.
+    //!
+    //! @param[in]      vertices        時間ステップごとの頂点座標の配列です.
+    //! @param[in]      stepCount       時間ステップ数です.
+    //! @param[in]      indices         インデックスです(三角形あたり3個).
+    //! @param[in]      triangleCount   三角形数です.
+    //! @return     ジオメトリ番号を返却します. 時間ステップ数が追加済みのものと異なる場合は INVALID_ID を返却します.
+    //! @note       時間ステップは [0, 1] を等間隔に分割した時刻に置き, 間は線形に補間します.
+    //!             時間ステップを持たないメッシュは全時刻で同じ頂点を使います.
+    //!             頂点とインデックスは Build() が終わるまで保持してください.
+    //!             メッシュを追加して Build() し直す場合や Refit() する場合は Clear() まで保持してください.
+    //-------------------------------------------------------------------------
+    uint32_t AddMotionTriangles(
+        const asdx::Vector3* const* vertices,
+        uint32_t                    stepCount,
+        const uint32_t*             indices,
+        uint32_t                    triangleCount);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ジオメトリの交差を判定する関数を設定します.
+    //!
+    //! @param[in]      geomID          AddTriangles() で取得したジオメトリ番号です.
+    //! @param[in]      func            判定関数です. nullptr なら設定を解除します.
+    //! @param[in]      userPtr         判定関数に渡すポインタです. Clear() を呼ぶまで破棄しないでください.
+    //! @note       リーフの判定で棄却した三角形は交差しなかったものとして走査を続けるので,
+    //!             抜き型のある葉や柵でも根から辿り直さずに済みます. 再構築は不要で, 直後の判定から反映します.
+    //-------------------------------------------------------------------------
+    void SetFilter(uint32_t geomID, FilterFunc func, const void* userPtr);
+
+    //-------------------------------------------------------------------------
+    //! @brief      BVHを構築します.
+    //!
+    //! @param[in]      threadCount     構築スレッド数です(0ならハードウェアスレッド数).
+    //! @retval true    構築に成功.
+    //! @retval false   構築に失敗.
+    //-------------------------------------------------------------------------
+    bool Build(uint32_t threadCount = 0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      トポロジーを変えずに境界を更新します.
+    //!
+    //! @param[in]      threadCount     更新スレッド数です(0ならハードウェアスレッド数).
+    //! @retval true    更新に成功.
+    //! @retval false   Attach() したデータなので更新できない.
+    //! @note       頂点を書き換えた後に呼び出します. 頂点とインデックスは保持しておく必要があります.
+    //!             変形が大きいと境界が重なって走査が遅くなるので, NodeCost を見て Build() し直してください.
+    //-------------------------------------------------------------------------
+    bool Refit(uint32_t threadCount = 0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      構築済みのデータを複製せずに設定します.
+    //!
+    //! @param[in]      view        構築済みのデータです.
+    //! @retval true    設定に成功.
+    //! @retval false   データが不正.
+    //! @note       参照先は Clear() を呼ぶまで解放しないでください.
+    //!             リーフは三角形を保持しているので, 元の頂点とインデックスは不要です.
+    //!             リーフの三角形番号を検証するので, 先に AddTriangles() でメッシュを登録しておいてください.
+    //-------------------------------------------------------------------------
+    bool Attach(const View& view);
+
+    //-------------------------------------------------------------------------
+    //! @brief      構築済みのデータを取得します.
+    //!
+    //! @note       時間ステップを持つ場合は View で表せないので, 空のデータを返却します.
+    //-------------------------------------------------------------------------
+    View GetView() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      全データを破棄します.
+    //-------------------------------------------------------------------------
+    void Clear();
+
+    //-------------------------------------------------------------------------
+    //! @brief      最近傍の交差を求めます.
+    //!
+    //! @param[in,out]  ray     レイです. 交差した場合は tmax を交差距離に更新します.
+    //! @param[out]     hit     交差情報です.
+    //! @param[in]      time    時刻です([0, 1]. 時間ステップを持たなければ無視します).
+    //! @retval true    交差あり.
+    //! @retval false   交差なし.
+    //-------------------------------------------------------------------------
+    bool Intersect(asdx::Ray& ray, BVHHit& hit, float time = 0.0f) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      遮蔽されているかどうかチェックします.
+    //!
+    //! @param[in]      ray     レイです.
+    //! @param[in]      time    時刻です([0, 1]. 時間ステップを持たなければ無視します).
+    //! @retval true    [tmin, tmax] の間に交差あり.
+    //! @retval false   交差なし.
+    //-------------------------------------------------------------------------
+    bool Occluded(const asdx::Ray& ray, float time = 0.0f) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------
+    inline const BVHStats& GetStats() const { return m_Stats; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      シーン全体の境界を取得します.
+    //!
+    //! @note       時間ステップを持つ場合は全時刻の境界を包含します.
+    //-------------------------------------------------------------------------
+    inline const asdx::AABB& GetBounds() const { return m_Bounds; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      時間ステップ数を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetTimeStepCount() const { return m_StepCount; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      登録された三角形メッシュ数を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetGeometryCount() const { return uint32_t(m_Geometries.size()); }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Geometry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Geometry
+    {
+        const asdx::Vector3*    pVertices;      // 時間ステップ0の頂点です.
+        const uint32_t*         pIndices;
+        uint32_t                TriangleCount;
+        uint32_t                StepOffset;     // m_Steps の先頭番号です(時間ステップを持たなければ INVALID_ID).
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Filter structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Filter
+    {
+        FilterFunc              Func;
+        const void*             pUserPtr;
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<Geometry>               m_Geometries;
+    std::vector<const asdx::Vector3*>   m_Steps;                // 時間ステップごとの頂点です.
+    std::vector<Node>                   m_Nodes;
+    std::vector<Leaf>                   m_Leaves;
+    std::vector<Node>                   m_MotionNodes;          // 時間ステップ1以降のノードです(トポロジーは m_Nodes と同じ).
+    std::vector<asdx::Trianglex4>       m_MotionLeaves;         // リーフごとの時間ステップ1以降の三角形です.
+    std::vector<Filter>                 m_Filters;              // ジオメトリごとの判定関数です(設定が無ければ空).
+    const Node*                         m_pNodes    = nullptr;  // 走査するノード(m_Nodes か外部のメモリ).
+    const Leaf*                         m_pLeaves   = nullptr;  // 走査するリーフ(m_Leaves か外部のメモリ).
+    uint32_t                            m_NodeCount = 0;
+    uint32_t                            m_LeafCount = 0;
+    uint32_t                            m_StepCount = 1;
+    asdx::AABB                          m_Bounds;
+    BVHStats                            m_Stats = {};
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    const asdx::Vector3* GetVertices(const Geometry& geometry, uint32_t step) const;
+    void PackLeaf(const Leaf& leaf, uint32_t step, asdx::Trianglex4& result, asdx::AABB& bounds) const;
+    void RefitSteps(uint32_t threadCount);
+    const Node* GetNodes(uint32_t step) const;
+    const asdx::Trianglex4& GetTriangles(uint32_t index, uint32_t segment, float f, asdx::Trianglex4& temp) const;
+
+    inline bool IsRejected(uint32_t geomID, uint32_t primID, float u, float v) const
+    {
+        if (geomID >= m_Filters.size() || m_Filters[geomID].Func == nullptr)
+        { return false; }
+
+        return !m_Filters[geomID].Func(m_Filters[geomID].pUserPtr, primID, u, v);
+    }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// InstanceBVH class
+// 構築済みのBVH(プロトタイプ)を変換行列付きで配置する上位のBVHです.
+// インスタンスはワールド→オブジェクト空間の3x4行列とプロトタイプ番号だけを持ち,
+// 三角形を複製しないので, 同じメッシュを大量に配置してもメモリはインスタンス数に比例します.
+///////////////////////////////////////////////////////////////////////////////
+class InstanceBVH
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    InstanceBVH() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      プロトタイプを追加します.
+    //!
+    //! @param[in]      bvh         構築済みのBVHです. このクラスより先に破棄しないでください.
+    //! @return     プロトタイプ番号を返却します.
+    //-------------------------------------------------------------------------
+    uint32_t AddPrototype(const BVH* bvh);
+
+    //-------------------------------------------------------------------------
+    //! @brief      インスタンスを追加します.
+    //!
+    //! @param[in]      prototype   プロトタイプ番号です.
+    //! @param[in]      transform   オブジェクト空間からワールド空間への変換行列です.
+    //! @param[in]      id          交差時に BVHHit::InstID に設定する番号です.
+    //! @return     インスタンス番号を返却します. 失敗時は BVH::INVALID_ID を返却します.
+    //-------------------------------------------------------------------------
+    uint32_t AddInstance(uint32_t prototype, const asdx::Matrix& transform, uint32_t id);
+
+    //-------------------------------------------------------------------------
+    //! @brief      時間ステップごとの変換行列を持つインスタンスを追加します.
+    //!
+    //! @param[in]      prototype   プロトタイプ番号です.
+    //! @param[in]      transforms  時間ステップごとのオブジェクト空間からワールド空間への変換行列です.
+    //! @param[in]      stepCount   時間ステップ数です.
+    //! @param[in]      id          交差時に BVHHit::InstID に設定する番号です.
+    //! @return     インスタンス番号を返却します. 失敗時は BVH::INVALID_ID を返却します.
+    //! @note       行列は 平行移動 * 回転 * 拡縮・せん断 に分解して保持し, レイの時刻で補間します.
+    //-------------------------------------------------------------------------
+    uint32_t AddMotionInstance(uint32_t prototype, const asdx::Matrix* transforms, uint32_t stepCount, uint32_t id);
+
+    //-------------------------------------------------------------------------
+    //! @brief      インスタンスの変換行列を設定します.
+    //!
+    //! @param[in]      index       インスタンス番号です.
+    //! @param[in]      transform   オブジェクト空間からワールド空間への変換行列です.
+    //! @retval true    設定に成功.
+    //! @retval false   不正な番号.
+    //! @note       走査に反映するには Refit() か Build() を呼び出してください.
+    //!             時間ステップを持つインスタンスは, 全時刻でこの行列を使うようになります.
+    //-------------------------------------------------------------------------
+    bool SetTransform(uint32_t index, const asdx::Matrix& transform);
+
+    //-------------------------------------------------------------------------
+    //! @brief      インスタンスのBVHを構築します.
+    //!
+    //! @param[in]      threadCount     構築スレッド数です(0ならハードウェアスレッド数).
+    //! @retval true    構築に成功.
+    //! @retval false   構築に失敗.
+    //! @note       プロトタイプは構築済みである必要があります.
+    //-------------------------------------------------------------------------
+    bool Build(uint32_t threadCount = 0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      トポロジーを変えずにインスタンスの境界を更新します.
+    //!
+    //! @param[in]      threadCount     更新スレッド数です(0ならハードウェアスレッド数).
+    //! @retval true    更新に成功.
+    //! @retval false   更新に失敗.
+    //! @note       変換行列やプロトタイプの境界が変わった後に呼び出します.
+    //!             インスタンス数が変わっている場合は Build() します.
+    //-------------------------------------------------------------------------
+    bool Refit(uint32_t threadCount = 0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      全データを破棄します.
+    //-------------------------------------------------------------------------
+    void Clear();
+
+    //-------------------------------------------------------------------------
+    //! @brief      最近傍の交差を求めます.
+    //!
+    //! @param[in,out]  ray     レイです. 交差した場合は tmax を交差距離に更新します.
+    //! @param[out]     hit     交差情報です. 法線はオブジェクト空間のままです.
+    //! @param[in]      time    時刻です([0, 1]).
+    //! @retval true    交差あり.
+    //! @retval false   交差なし.
+    //-------------------------------------------------------------------------
+    bool Intersect(asdx::Ray& ray, BVHHit& hit, float time = 0.0f) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      遮蔽されているかどうかチェックします.
+    //!
+    //! @param[in]      ray     レイです.
+    //! @param[in]      time    時刻です([0, 1]).
+    //! @retval true    [tmin, tmax] の間に交差あり.
+    //! @retval false   交差なし.
+    //-------------------------------------------------------------------------
+    bool Occluded(const asdx::Ray& ray, float time = 0.0f) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      インスタンスが参照するプロトタイプ番号を取得します.
+    //!
+    //! @param[in]      index       インスタンス番号です.
+    //! @return     プロトタイプ番号を返却します. 不正な番号の場合は BVH::INVALID_ID を返却します.
+    //-------------------------------------------------------------------------
+    uint32_t GetPrototype(uint32_t index) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      インスタンスの変換行列を取得します.
+    //!
+    //! @param[in]      index       インスタンス番号です.
+    //! @param[out]     transform   オブジェクト空間からワールド空間への変換行列です.
+    //! @param[in]      time        時刻です([0, 1]. 時間ステップを持たなければ無視します).
+    //! @retval true    取得に成功.
+    //! @retval false   不正な番号.
+    //! @note       保持している逆行列や分解した変換から求め直すので, 追加時の行列とは丸め誤差の分だけ異なります.
+    //-------------------------------------------------------------------------
+    bool GetTransform(uint32_t index, asdx::Matrix& transform, float time = 0.0f) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      インスタンス数を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetInstanceCount() const { return uint32_t(m_Instances.size()); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //!
+    //! @note       MemorySize は上位のノードとインスタンスの合計で, プロトタイプは含みません.
+    //-------------------------------------------------------------------------
+    inline const BVHStats& GetStats() const { return m_Stats; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      シーン全体の境界を取得します.
+    //-------------------------------------------------------------------------
+    inline const asdx::AABB& GetBounds() const { return m_Bounds; }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Instance structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Instance
+    {
+        float       WorldToObject[12];  // 3x3 の回転・拡縮と平行移動です(行ベクトル形式).
+        uint32_t    Prototype;
+        uint32_t    ID;
+        uint32_t    MotionOffset;       // m_MotionKeys の先頭番号です.
+        uint32_t    MotionCount;        // 時間ステップ数です(時間ステップを持たなければ 0).
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<const BVH*>     m_Prototypes;
+    std::vector<Instance>       m_Instances;
+    std::vector<MotionKey>      m_MotionKeys;
+    std::vector<BVH::Node>      m_Nodes;
+    asdx::AABB                  m_Bounds;
+    BVHStats                    m_Stats = {};
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    asdx::AABB CalcBounds(const Instance& instance) const;
+    asdx::Ray ToObject(const Instance& instance, const asdx::Ray& ray, float time) const;
+    static asdx::Matrix ToWorld(const Instance& instance);
+
+    InstanceBVH            (const InstanceBVH&) = delete;
+    InstanceBVH& operator= (const InstanceBVH&) = delete;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BoxBVH class
+// 境界だけを持つプリミティブ(ユーザー定義の形状など)の4分岐BVHです.
+// プリミティブとの交差判定は呼び出し側の関数で行います.
+///////////////////////////////////////////////////////////////////////////////
+class BoxBVH
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      プリミティブとの最近傍の交差を求める関数です.
+    //!
+    //! @param[in]      userPtr     Intersect() に渡したポインタです.
+    //! @param[in]      primID      プリミティブ番号です.
+    //! @param[in,out]  ray         レイです. 交差した場合は tmax を交差距離に更新します.
+    //! @param[out]     hit         交差情報です.
+    //! @retval true    tmax より手前で交差あり.
+    //! @retval false   交差なし.
+    //-------------------------------------------------------------------------
+    typedef bool (*IntersectFunc)(void* userPtr, uint32_t primID, asdx::Ray& ray, BVHHit& hit);
+
+    //-------------------------------------------------------------------------
+    //! @brief      プリミティブで遮蔽されているかどうかを求める関数です.
+    //-------------------------------------------------------------------------
+    typedef bool (*OccludedFunc)(void* userPtr, uint32_t primID, const asdx::Ray& ray);
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    BoxBVH() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      BVHを構築します.
+    //!
+    //! @param[in]      bounds          プリミティブごとの境界です.
+    //! @param[in]      count           プリミティブ数です.
+    //! @param[in]      threadCount     構築スレッド数です(0ならハードウェアスレッド数).
+    //! @retval true    構築に成功.
+    //! @retval false   構築に失敗.
+    //! @note       空の境界を持つプリミティブは辿りません.
+    //-------------------------------------------------------------------------
+    bool Build(const asdx::AABB* bounds, uint32_t count, uint32_t threadCount = 0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      全データを破棄します.
+    //-------------------------------------------------------------------------
+    void Clear();
+
+    //-------------------------------------------------------------------------
+    //! @brief      最近傍の交差を求めます.
+    //!
+    //! @param[in,out]  ray         レイです. 交差した場合は tmax を交差距離に更新します.
+    //! @param[out]     hit         交差情報です.
+    //! @param[in]      func        境界と交差したプリミティブごとに呼び出す関数です.
+    //! @param[in]      userPtr     関数に渡すポインタです.
+    //! @retval true    交差あり.
+    //! @retval false   交差なし.
+    //-------------------------------------------------------------------------
+    bool Intersect(asdx::Ray& ray, BVHHit& hit, IntersectFunc func, void* userPtr) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      遮蔽されているかどうかチェックします.
+    //!
+    //! @param[in]      ray         レイです.
+    //! @param[in]      func        境界と交差したプリミティブごとに呼び出す関数です.
+    //! @param[in]      userPtr     関数に渡すポインタです.
+    //! @retval true    [tmin, tmax] の間に交差あり.
+    //! @retval false   交差なし.
+    //-------------------------------------------------------------------------
+    bool Occluded(const asdx::Ray& ray, OccludedFunc func, void* userPtr) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------
+    inline const BVHStats& GetStats() const { return m_Stats; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      全体の境界を取得します.
+    //-------------------------------------------------------------------------
+    inline const asdx::AABB& GetBounds() const { return m_Bounds; }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<BVH::Node>      m_Nodes;
+    asdx::AABB                  m_Bounds;
+    BVHStats                    m_Stats = {};
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    BoxBVH            (const BoxBVH&) = delete;
+    BoxBVH& operator= (const BoxBVH&) = delete;
+};
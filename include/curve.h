@@ -0,0 +1,233 @@
+﻿//-----------------------------------------------------------------------------
+// File : curve.h
+// Desc : B-Spline Curves.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <asdxMath.h>
+#include <bvh.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CURVE_TYPE enum
+///////////////////////////////////////////////////////////////////////////////
+enum CURVE_TYPE : uint32_t
+{
+    CURVE_TYPE_FLAT = 0,    //!< 常にレイの方を向く帯です(RTC_GEOMETRY_TYPE_FLAT_BSPLINE_CURVE). 遠景の髪向け.
+    CURVE_TYPE_ROUND,       //!< 円形断面の管です(RTC_GEOMETRY_TYPE_ROUND_BSPLINE_CURVE). 近景の髪や毛皮向け.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CurveHit structure
+///////////////////////////////////////////////////////////////////////////////
+struct CurveHit
+{
+    uint32_t        Strand;     //!< 毛の番号です.
+    float           U;          //!< 毛の根元を 0, 毛先を 1 とするパラメータです.
+    asdx::Vector3   Tangent;    //!< 毛先に向かう正規化された接線です(髪のシェーディングに使います).
+    float           Radius;     //!< 交差位置の半径です(広げた後の値).
+    float           Coverage;   //!< 広げる前の半径との比です(1 未満なら透過として扱ってください).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Curves class
+// 一様3次Bスプラインの毛の集まりです.
+// 制御点は (x, y, z, 半径) の float4 で, Embree の頂点バッファとしてそのまま共有します.
+// 毛ごとには先頭の制御点番号だけを持ち, セグメント(連続する4制御点)は先頭の制御点番号で表します.
+///////////////////////////////////////////////////////////////////////////////
+class Curves
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static constexpr uint32_t MIN_POINT_COUNT = 4;  //!< 毛あたりの最小の制御点数です.
+    static constexpr uint32_t MAX_PART_COUNT  = 8;  //!< セグメントを判定する折れ線の数です(区間に分ける数の上限).
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    Curves() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      type            曲線の種類です.
+    //! @param[in]      points          制御点です(x, y, z, 半径). 毛ごとに根元から順に並べます.
+    //! @param[in]      pointCounts     毛ごとの制御点数です(MIN_POINT_COUNT 以上).
+    //! @param[in]      strandCount     毛の数です.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //! @note       制御点数 n の毛は n - 3 個のセグメントになります.
+    //!             Bスプラインは端の制御点を通らないので, 根元と毛先を通したい場合は端の制御点を重ねてください.
+    //-------------------------------------------------------------------------
+    bool Init(
+        CURVE_TYPE              type,
+        const asdx::Vector4*    points,
+        const uint32_t*         pointCounts,
+        uint32_t                strandCount);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      画素の大きさより細い部分を広げます.
+    //!
+    //! @param[in]      eye             視点の位置です.
+    //! @param[in]      pixelAngle      1画素あたりのレイの広がり(ラジアン)です. CalcPixelAngle() で求めます.
+    //! @param[in]      minPixelWidth   最小の幅(画素数)です.
+    //! @return     広げた制御点の数を返却します.
+    //! @note       視点からの距離とレイの広がりから画素の幅を求め, それより細い制御点の半径を広げます.
+    //!             広げた割合は CurveHit::Coverage に入るので, シェーディングで透過させると見た目の太さが保たれます.
+    //!             細い毛を点でしかサンプリングできずに途切れるのを防ぎます. 加速構造に追加する前に呼び出してください.
+    //-------------------------------------------------------------------------
+    uint32_t WidenToPixel(const asdx::Vector3& eye, float pixelAngle, float minPixelWidth = 1.0f);
+
+    //-------------------------------------------------------------------------
+    //! @brief      セグメントの境界を求めます.
+    //!
+    //! @param[in]      segment         セグメント番号です.
+    //! @param[in]      part            セグメントを等分した区間の番号です.
+    //! @param[in]      partCount       セグメントを等分する数です(MAX_PART_COUNT の約数).
+    //! @return     区間の曲線を包含するベジェ制御点の凸包を, 半径分広げた境界を返却します.
+    //! @note       髪のセグメントは細長く斜めに伸びるので, 等分すると境界の重なりが大きく減ります.
+    //-------------------------------------------------------------------------
+    asdx::AABB GetSegmentBounds(uint32_t segment, uint32_t part = 0, uint32_t partCount = 1) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      セグメントとの最近傍の交差を求めます.
+    //!
+    //! @param[in]      segment         セグメント番号です.
+    //! @param[in,out]  ray             レイです. 交差した場合は tmax を交差距離に更新します.
+    //! @param[out]     hit             交差情報です. U はセグメント内のパラメータ, V は幅方向の位置([-1, 1])です.
+    //! @param[in]      part            判定する区間の番号です.
+    //! @param[in]      partCount       セグメントを等分する数です(MAX_PART_COUNT の約数).
+    //! @retval true    交差あり.
+    //! @retval false   交差なし.
+    //! @note       レイ空間でセグメントを MAX_PART_COUNT 本の折れ線に分割し, 折れ線とレイとの最近点で判定します.
+    //-------------------------------------------------------------------------
+    bool Intersect(uint32_t segment, asdx::Ray& ray, BVHHit& hit, uint32_t part = 0, uint32_t partCount = 1) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      セグメントで遮蔽されているかどうかチェックします.
+    //!
+    //! @param[in]      segment         セグメント番号です.
+    //! @param[in]      ray             レイです.
+    //! @param[in]      part            判定する区間の番号です.
+    //! @param[in]      partCount       セグメントを等分する数です(MAX_PART_COUNT の約数).
+    //! @retval true    [tmin, tmax] の間に交差あり.
+    //! @retval false   交差なし.
+    //-------------------------------------------------------------------------
+    bool Occluded(uint32_t segment, const asdx::Ray& ray, uint32_t part = 0, uint32_t partCount = 1) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      セグメント上の点を求めます.
+    //!
+    //! @param[in]      segment         セグメント番号です.
+    //! @param[in]      u               セグメント内のパラメータです([0, 1]).
+    //! @return     位置(x, y, z)と半径(w)を返却します.
+    //-------------------------------------------------------------------------
+    asdx::Vector4 Evaluate(uint32_t segment, float u) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      交差位置の毛の情報を求めます.
+    //!
+    //! @param[in]      segment         セグメント番号です(hit.primID).
+    //! @param[in]      u               セグメント内のパラメータです(hit.u).
+    //! @param[out]     result          毛の情報です.
+    //! @retval true    取得に成功.
+    //! @retval false   セグメント番号が不正.
+    //-------------------------------------------------------------------------
+    bool GetHit(uint32_t segment, float u, CurveHit& result) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      曲線の種類を取得します.
+    //-------------------------------------------------------------------------
+    inline CURVE_TYPE GetType() const
+    { return m_Type; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      毛の数を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetStrandCount() const
+    { return m_Offsets.empty() ? 0 : uint32_t(m_Offsets.size() - 1); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      セグメント数を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetSegmentCount() const
+    { return m_SegmentCount; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      制御点数を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetPointCount() const
+    { return uint32_t(m_Points.size()); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      制御点を取得します(Embree の RTC_FORMAT_FLOAT4 の頂点バッファ).
+    //-------------------------------------------------------------------------
+    inline const asdx::Vector4* GetPoints() const
+    { return m_Points.data(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      セグメントごとの先頭の制御点番号を取得します(Embree の RTC_FORMAT_UINT のインデックスバッファ).
+    //-------------------------------------------------------------------------
+    inline const uint32_t* GetSegments() const
+    { return m_Segments.data(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      使用メモリ(バイト)を取得します.
+    //-------------------------------------------------------------------------
+    size_t GetMemorySize() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<asdx::Vector4>  m_Points;           // 制御点です(x, y, z, 半径).
+    std::vector<uint32_t>       m_Segments;         // セグメントの先頭の制御点番号です(末尾に16バイトの余白を持つ).
+    std::vector<uint32_t>       m_Offsets;          // 毛ごとの先頭の制御点番号です(末尾は制御点数).
+    std::vector<float>          m_Coverage;         // 制御点ごとの広げる前の半径との比です(広げていなければ空).
+    uint32_t                    m_SegmentCount  = 0;
+    CURVE_TYPE                  m_Type          = CURVE_TYPE_FLAT;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    bool IntersectSegment(uint32_t segment, uint32_t part, uint32_t partCount, const asdx::Ray& ray, float& t, float& u, float& v, asdx::Vector3& normal) const;
+
+    Curves            (const Curves&) = delete;
+    Curves& operator= (const Curves&) = delete;
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      1画素あたりのレイの広がりを求めます.
+//!
+//! @param[in]      fovY        垂直画角(ラジアン)です.
+//! @param[in]      height      画像の高さ(画素数)です.
+//! @return     画面中央での1画素あたりの角度(ラジアン)を返却します.
+//! @note       ピンホールカメラの一次レイのレイ微分の大きさです.
+//-----------------------------------------------------------------------------
+inline float CalcPixelAngle(float fovY, uint32_t height)
+{ return 2.0f * tanf(fovY * 0.5f) / float(height); }
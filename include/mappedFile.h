@@ -0,0 +1,87 @@
+﻿//-----------------------------------------------------------------------------
+// File : mappedFile.h
+// Desc : Read-Only Memory Mapped File.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <cstddef>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedFile class
+///////////////////////////////////////////////////////////////////////////////
+class MappedFile
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    MappedFile() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~MappedFile();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルをメモリにマップします.
+    //!
+    //! @param[in]      path        ファイルパスです.
+    //! @param[in]      copyOnWrite 書き込み時コピーでマップする場合は true を指定します.
+    //! @retval true    マップに成功.
+    //! @retval false   マップに失敗.
+    //! @note       書き込み時コピーの場合, 書き込んだページだけが複製されファイルには反映されません.
+    //-------------------------------------------------------------------------
+    bool Init(const char* path, bool copyOnWrite = false);
+
+    //-------------------------------------------------------------------------
+    //! @brief      マップを解除します.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      先頭ポインタを取得します.
+    //! @note       書き込みは書き込み時コピーでマップした場合のみ有効です.
+    //-------------------------------------------------------------------------
+    inline uint8_t* GetData() { return m_pData; }
+    inline const uint8_t* GetData() const { return m_pData; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルサイズを取得します.
+    //-------------------------------------------------------------------------
+    inline size_t GetSize() const { return m_Size; }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    void*       m_File      = nullptr;
+    void*       m_Mapping   = nullptr;
+    uint8_t*    m_pData     = nullptr;
+    size_t      m_Size      = 0;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    MappedFile             (const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+};
@@ -0,0 +1,316 @@
+﻿//-----------------------------------------------------------------------------
+// File : mesh.h
+// Desc : Mesh Data.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <asdxMath.h>
+
+
+//-----------------------------------------------------------------------------
+//! @brief      ジオメトリ用のメモリを確保します.
+//!
+//! @param[in]      size        確保するサイズ(バイト)です.
+//! @param[in]      alignment   アライメントです.
+//! @return     確保したメモリを返却します. 失敗時は nullptr を返却します.
+//! @note       確保量は GetGeometryMemorySize() で集計されます.
+//-----------------------------------------------------------------------------
+void* AllocGeometryMemory(size_t size, size_t alignment);
+
+//-----------------------------------------------------------------------------
+//! @brief      ジオメトリ用のメモリを解放します.
+//!
+//! @param[in]      ptr         AllocGeometryMemory() で確保したメモリです.
+//! @param[in]      size        確保時のサイズ(バイト)です.
+//-----------------------------------------------------------------------------
+void FreeGeometryMemory(void* ptr, size_t size);
+
+//-----------------------------------------------------------------------------
+//! @brief      確保中のジオメトリ用メモリの合計サイズを取得します.
+//-----------------------------------------------------------------------------
+size_t GetGeometryMemorySize();
+
+//-----------------------------------------------------------------------------
+//! @brief      ジオメトリ用メモリの最大使用量を取得します.
+//-----------------------------------------------------------------------------
+size_t GetGeometryMemoryPeak();
+
+//-----------------------------------------------------------------------------
+//! @brief      ジオメトリ用メモリの最大使用量を現在の使用量にリセットします.
+//-----------------------------------------------------------------------------
+void ResetGeometryMemoryPeak();
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AlignedArray class
+// 64バイト境界に配置し, 末尾に16バイトの余白を持つ配列です.
+// Embree は最後の要素を16バイト単位で読み込むので, 共有バッファにはこの余白が必要です.
+///////////////////////////////////////////////////////////////////////////////
+template<typename T>
+class AlignedArray
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static constexpr size_t ALIGNMENT = 64;     //!< 先頭アドレスのアライメントです.
+    static constexpr size_t PADDING   = 16;     //!< 末尾の余白です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    AlignedArray() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ムーブコンストラクタです.
+    //-------------------------------------------------------------------------
+    AlignedArray(AlignedArray&& value) noexcept
+    : m_pData   (value.m_pData)
+    , m_Count   (value.m_Count)
+    , m_Size    (value.m_Size)
+    , m_External(value.m_External)
+    {
+        value.m_pData    = nullptr;
+        value.m_Count    = 0;
+        value.m_Size     = 0;
+        value.m_External = false;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~AlignedArray()
+    { Clear(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ムーブ代入演算子です.
+    //-------------------------------------------------------------------------
+    AlignedArray& operator = (AlignedArray&& value) noexcept
+    {
+        if (this != &value)
+        {
+            Clear();
+            m_pData    = value.m_pData;
+            m_Count    = value.m_Count;
+            m_Size     = value.m_Size;
+            m_External = value.m_External;
+            value.m_pData    = nullptr;
+            value.m_Count    = 0;
+            value.m_Size     = 0;
+            value.m_External = false;
+        }
+        return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      要素数を変更します.
+    //!
+    //! @param[in]      count       要素数です.
+    //! @retval true    確保に成功.
+    //! @retval false   確保に失敗.
+    //! @note       既存の要素は保持しません.
+    //-------------------------------------------------------------------------
+    bool Resize(size_t count)
+    {
+        Clear();
+        if (count == 0)
+        { return true; }
+
+        auto size = (sizeof(T) * count + PADDING + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        m_pData = static_cast<T*>(AllocGeometryMemory(size, ALIGNMENT));
+        if (m_pData == nullptr)
+        { return false; }
+
+        // 余白は読み込まれるだけだが, 未初期化のままにしない.
+        memset(reinterpret_cast<uint8_t*>(m_pData) + sizeof(T) * count, 0, size - sizeof(T) * count);
+
+        m_Count = count;
+        m_Size  = size;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      外部のメモリを所有せずに参照します.
+    //!
+    //! @param[in]      data        先頭ポインタです(64バイト境界, 末尾に16バイト以上の余白が必要).
+    //! @param[in]      count       要素数です.
+    //! @param[in]      size        余白を含めたサイズ(バイト)です.
+    //! @note       メモリは Clear() を呼ぶまで解放しないでください.
+    //-------------------------------------------------------------------------
+    void Attach(T* data, size_t count, size_t size)
+    {
+        Clear();
+        m_pData    = data;
+        m_Count    = count;
+        m_Size     = size;
+        m_External = true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      メモリを解放します.
+    //-------------------------------------------------------------------------
+    void Clear()
+    {
+        if (m_pData != nullptr && !m_External)
+        { FreeGeometryMemory(m_pData, m_Size); }
+
+        m_pData    = nullptr;
+        m_Count    = 0;
+        m_Size     = 0;
+        m_External = false;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      先頭ポインタを取得します.
+    //-------------------------------------------------------------------------
+    inline T* GetData() { return m_pData; }
+    inline const T* GetData() const { return m_pData; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      要素数を取得します.
+    //-------------------------------------------------------------------------
+    inline size_t GetCount() const { return m_Count; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      余白を含めた確保サイズ(バイト)を取得します.
+    //-------------------------------------------------------------------------
+    inline size_t GetSize() const { return m_Size; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      外部のメモリを参照しているかどうかチェックします.
+    //-------------------------------------------------------------------------
+    inline bool IsExternal() const { return m_External; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      要素を取得します.
+    //-------------------------------------------------------------------------
+    inline T& operator [] (size_t index) { return m_pData[index]; }
+    inline const T& operator [] (size_t index) const { return m_pData[index]; }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    T*      m_pData     = nullptr;
+    size_t  m_Count     = 0;
+    size_t  m_Size      = 0;
+    bool    m_External  = false;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    AlignedArray            (const AlignedArray&) = delete;
+    AlignedArray& operator= (const AlignedArray&) = delete;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// VertexAttributes structure
+// 交差位置のシェーディングでのみ参照する頂点属性です.
+// トラバーサルでは読まないので量子化して保持し, 交差時に DecodeAttributes() で復元します.
+///////////////////////////////////////////////////////////////////////////////
+struct VertexAttributes
+{
+    AlignedArray<uint32_t>  Normals;        //!< 法線です(八面体写像, snorm16 x 2).
+    AlignedArray<uint32_t>  Tangents;       //!< 接線です(八面体写像, snorm16 x 2). 最下位ビットが1なら従法線を反転します.
+    AlignedArray<uint32_t>  TexCoords;      //!< テクスチャ座標です(TexCoordRange 内の unorm16 x 2).
+    asdx::Vector4           TexCoordRange;  //!< テクスチャ座標の最小値(xy)と幅(zw)です. メッシュごとに量子化の範囲を決めます.
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    VertexAttributes()
+    : TexCoordRange(0.0f, 0.0f, 1.0f, 1.0f)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      メモリを解放します.
+    //-------------------------------------------------------------------------
+    void Clear()
+    {
+        Normals  .Clear();
+        Tangents .Clear();
+        TexCoords.Clear();
+        TexCoordRange = asdx::Vector4(0.0f, 0.0f, 1.0f, 1.0f);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      使用メモリ(バイト)を取得します.
+    //-------------------------------------------------------------------------
+    inline size_t GetMemorySize() const
+    { return Normals.GetSize() + Tangents.GetSize() + TexCoords.GetSize(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      同じ属性を float で保持した場合のメモリ(バイト)を取得します.
+    //! @note       法線 float3, 接線 float4(w が従法線の向き), テクスチャ座標 float2 として求めます.
+    //-------------------------------------------------------------------------
+    inline size_t GetFloatMemorySize() const
+    {
+        return Normals  .GetCount() * sizeof(float) * 3
+             + Tangents .GetCount() * sizeof(float) * 4
+             + TexCoords.GetCount() * sizeof(float) * 2;
+    }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Mesh structure
+// 加速構造と共有する三角形メッシュです. 加速構造より先に破棄しないでください.
+///////////////////////////////////////////////////////////////////////////////
+struct Mesh
+{
+    AlignedArray<asdx::Vector3>     Positions;  //!< 頂点座標です.
+    AlignedArray<uint32_t>          Indices;    //!< インデックスです(三角形あたり3個).
+    VertexAttributes                Attributes; //!< シェーディング用の頂点属性です(加速構造とは共有しません).
+
+    //-------------------------------------------------------------------------
+    //! @brief      頂点数を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetVertexCount() const
+    { return uint32_t(Positions.GetCount()); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      三角形数を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetTriangleCount() const
+    { return uint32_t(Indices.GetCount() / 3); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      使用メモリ(バイト)を取得します.
+    //-------------------------------------------------------------------------
+    inline size_t GetMemorySize() const
+    { return Positions.GetSize() + Indices.GetSize() + Attributes.GetMemorySize(); }
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      メッシュファイルを読み込みます.
+//!
+//! @param[in]      path        ファイルパスです(.obj, .ply).
+//! @param[out]     mesh        読み込んだメッシュです.
+//! @param[in]      threadCount 解析スレッド数です(0ならハードウェアスレッド数).
+//! @retval true    読み込みに成功.
+//! @retval false   読み込みに失敗.
+//! @note       ファイルをメモリにマップして行単位のチャンクに分け, 要素数を数えてから
+//!             最終的なサイズで確保して並列に書き込むので, 一時的な複製は作りません.
+//!             OBJ の法線(vn)とテクスチャ座標(vt), PLY の法線(nx, ny, nz)とテクスチャ座標(u, v / s, t)は
+//!             量子化して mesh.Attributes に格納します. OBJ は v/vt/vn の組ごとに頂点を分けます.
+//!             法線が無い場合は面積で重み付けした頂点法線を生成します.
+//-----------------------------------------------------------------------------
+bool LoadMesh(const char* path, Mesh& mesh, uint32_t threadCount = 0);
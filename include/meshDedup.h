@@ -0,0 +1,48 @@
+﻿//-----------------------------------------------------------------------------
+// File : meshDedup.h
+// Desc : Mesh Deduplication.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <mesh.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MeshDedupResult structure
+///////////////////////////////////////////////////////////////////////////////
+struct MeshDedupResult
+{
+    std::vector<uint32_t>       Prototypes;         //!< メッシュごとの代表メッシュ番号です(重複が無ければ自身).
+    std::vector<uint32_t>       GroupSizes;         //!< 代表メッシュごとの重複数(自身を含む)です. 代表でなければ 0 です.
+    std::vector<asdx::Matrix>   Transforms;         //!< 代表メッシュの座標から各メッシュの座標への変換行列です.
+    uint32_t                    DuplicateCount;     //!< 代表メッシュ以外に重複していたメッシュ数です.
+    uint32_t                    SavedTriangleCount; //!< 重複していたメッシュの三角形数の合計です.
+    size_t                      SavedMemorySize;    //!< 重複していたメッシュのジオメトリサイズ(バイト)の合計です.
+    double                      Msec;               //!< 検出にかかった時間(ミリ秒)です.
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      変換行列を除いて同一のメッシュを検出します.
+//!
+//! @param[in]      meshes      メッシュの配列です.
+//! @param[in]      count       メッシュ数です.
+//! @param[out]     result      検出結果です.
+//! @param[in]      tolerance   一致とみなす誤差(メッシュの対角線長に対する比)です.
+//! @note       インデックスと頂点の並びが同じで, 頂点座標がアフィン変換で一致するものを重複とします.
+//!             法線と接線も同じ変換で一致し, テクスチャ座標と従法線の向きが等しい必要があります.
+//!             重心と共分散で白色化し, 頂点の並び順から回転を決めた座標系(正準空間)での頂点座標と
+//!             位相をハッシュして候補を絞り込んでから, 全頂点を比較して確定します.
+//!             代表メッシュは各グループで最も番号の小さいものです.
+//-----------------------------------------------------------------------------
+void FindDuplicateMeshes(
+    const Mesh* const*  meshes,
+    uint32_t            count,
+    MeshDedupResult&    result,
+    float               tolerance = 1e-4f);
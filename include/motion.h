@@ -0,0 +1,87 @@
+﻿//-----------------------------------------------------------------------------
+// File : motion.h
+// Desc : Motion Blur Transform.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <asdxMath.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MotionKey structure
+// 変換行列を 平行移動 * 回転 * 拡縮・せん断 に分解したものです(RTCQuaternionDecomposition と同じ定義).
+// 拡縮・せん断と平行移動は線形に, 回転は球面線形に補間するので, 回転しても物体が潰れません.
+///////////////////////////////////////////////////////////////////////////////
+struct MotionKey
+{
+    float   Scale[3];           //!< 拡縮です(X, Y, Z).
+    float   Skew[3];            //!< せん断です(XY, XZ, YZ).
+    float   Rotation[4];        //!< 回転の四元数です(実部, i, j, k).
+    float   Translation[3];     //!< 平行移動です.
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      変換行列を分解します.
+//!
+//! @param[in]      transform   オブジェクト空間からワールド空間へのアフィン変換行列です.
+//! @param[out]     result      分解結果です.
+//! @note       上3x3を QR 分解し, 回転を四元数に, 上三角行列を拡縮とせん断にします.
+//!             鏡映を含む場合は Z の拡縮を負にします.
+//-----------------------------------------------------------------------------
+void DecomposeTransform(const asdx::Matrix& transform, MotionKey& result);
+
+//-----------------------------------------------------------------------------
+//! @brief      分解した変換を行列に戻します.
+//!
+//! @param[in]      key         分解した変換です.
+//! @param[out]     result      オブジェクト空間からワールド空間への変換行列です.
+//-----------------------------------------------------------------------------
+void ComposeTransform(const MotionKey& key, asdx::Matrix& result);
+
+//-----------------------------------------------------------------------------
+//! @brief      時刻に対応する変換を補間します.
+//!
+//! @param[in]      keys        時間ステップごとの変換です.
+//! @param[in]      count       時間ステップ数です.
+//! @param[in]      time        時刻です([0, 1] にクランプします).
+//! @param[out]     result      補間した変換です.
+//! @note       時間ステップは [0, 1] を等間隔に分割した時刻に置きます. 回転は最短経路で補間します.
+//-----------------------------------------------------------------------------
+void InterpolateMotion(const MotionKey* keys, uint32_t count, float time, MotionKey& result);
+
+//-----------------------------------------------------------------------------
+//! @brief      全時刻の境界を包含する境界を求めます.
+//!
+//! @param[in]      keys        時間ステップごとの変換です.
+//! @param[in]      count       時間ステップ数です.
+//! @param[in]      box         オブジェクト空間の境界です.
+//! @return     ワールド空間の境界を返却します.
+//! @note       回転量に応じて区間を分割して8頂点を変換し, 分割した間の回転で膨らむ分だけ広げます.
+//-----------------------------------------------------------------------------
+asdx::AABB CalcMotionBounds(const MotionKey* keys, uint32_t count, const asdx::AABB& box);
+
+//-----------------------------------------------------------------------------
+//! @brief      時刻を時間ステップの区間と区間内の位置に変換します.
+//!
+//! @param[in]      count       時間ステップ数です(2以上).
+//! @param[in]      time        時刻です([0, 1] にクランプします).
+//! @param[out]     segment     区間の番号です(0 から count - 2).
+//! @return     区間内の位置([0, 1])を返却します.
+//-----------------------------------------------------------------------------
+inline float GetMotionSegment(uint32_t count, float time, uint32_t& segment)
+{
+    // NaN も 0 として扱う.
+    auto t = (time > 0.0f) ? ((time < 1.0f) ? time : 1.0f) * float(count - 1) : 0.0f;
+    auto i = uint32_t(t);
+    if (i > count - 2)
+    { i = count - 2; }
+
+    segment = i;
+    return t - float(i);
+}
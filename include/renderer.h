@@ -1,4 +1,4 @@
-//-----------------------------------------------------------------------------
+﻿//-----------------------------------------------------------------------------
 // File : renderer.h
 // Desc : Renderer.
 // Copyright(c) Project Asura. All right reserved.
@@ -9,17 +9,37 @@
 // Includes
 //-----------------------------------------------------------------------------
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 #include <asdxMath.h>
 #include <asdxStopWatch.h>
-#include <embree3/rtcore.h>
+#include <sharedFrame.h>
+#include <accel.h>
+#include <mesh.h>
+#include <attribute.h>
+#include <alphaMask.h>
+#include <sceneCache.h>
+
+// OpenImageDenoise を使用するかどうか(既定ではビルド済みライブラリがある Windows のみ).
+#ifndef SALTY2_USE_OIDN
+    #if defined(_WIN32)
+        #define SALTY2_USE_OIDN     1
+    #else
+        #define SALTY2_USE_OIDN     0
+    #endif
+#endif//SALTY2_USE_OIDN
+
+#if SALTY2_USE_OIDN
 #include <OpenImageDenoise/oidn.h>
 
 //-----------------------------------------------------------------------------
 // Linker
 //-----------------------------------------------------------------------------
-#pragma comment(lib, "embree3.lib")
+#if defined(_MSC_VER)
 #pragma comment(lib, "OpenImageDenoise.lib")
+#endif
+#endif//SALTY2_USE_OIDN
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -30,25 +50,190 @@ class Renderer
 public:
     struct Desc
     {
-        uint32_t    Width;
-        uint32_t    Height;
-        uint32_t    MaxBounce;
-        uint32_t    Seconds;
+        uint32_t        Width;
+        uint32_t        Height;
+        uint32_t        MaxBounce;
+        uint32_t        Seconds;
+        const char*     SharedMemoryName;       //!< 共有フレームバッファの名前です. nullptr なら無効です.
+        ACCEL_BACKEND   Backend;                //!< 交差判定のバックエンドです. Embree が無効なら組み込み BVH を使用します.
+        const char*     DeviceConfig;           //!< rtcNewDevice() の設定文字列です. nullptr なら既定値です.
+        RTCBuildQuality BuildQuality = RTC_BUILD_QUALITY_MEDIUM;   //!< シーンの構築品質です. Desc{} でも RTC_BUILD_QUALITY_LOW(0) にはなりません.
+        RTCSceneFlags   SceneFlags;             //!< シーンフラグです(RTC_SCENE_FLAG_COMPACT | RTC_SCENE_FLAG_ROBUST など).
+        const char*     SceneCachePath;         //!< バイナリシーンキャッシュのパスです. nullptr なら無効です.
+        bool            DedupMeshes;            //!< 変換行列だけが異なる LoadMesh() のメッシュをインスタンスにするかどうか.
+        float           RebuildThreshold;       //!< リフィットをやめて再構築する変形量(頂点移動量の RMS / 対角線長)です. 0 なら既定値です.
+        double          RebuildBudgetMsec;      //!< 1フレームあたりの再構築時間(ミリ秒)です. 超えたメッシュは次のフレーム以降までリフィットします. 0 なら無制限です.
+        float           ShutterOpen;            //!< モーションブラー用のシャッター開始時刻 [0, 1] です. Open == Close ならサンプリングしません.
+        float           ShutterClose;           //!< モーションブラー用のシャッター終了時刻 [0, 1] です.
+        size_t          TessellationCacheSize;  //!< パッチのテッセレーション結果を保持するキャッシュの上限(バイト)です. 0 なら既定値です.
     };
 
     bool Init(const Desc& desc);
     void Term();
     void Run();
 
+    //-------------------------------------------------------------------------
+    //! @brief      連続したフレームを描画します.
+    //!
+    //! @param[in]      frameCount      フレーム数です.
+    //! @note       デバイス, シーン, バッファを維持したまま result_0000.png, ... を出力します.
+    //!             リフィットするには RTC_SCENE_FLAG_DYNAMIC が必要です.
+    //-------------------------------------------------------------------------
+    void RunSequence(uint32_t frameCount);
+
 protected:
     virtual bool OnInit() = 0;
     virtual void OnTerm() = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      レイを生成します.
+    //!
+    //! @note       ray.time には画素ごとのシャッター時刻が設定済みです. 全バウンスで同じ値を使います.
+    //-------------------------------------------------------------------------
     virtual void OnRayGen(RTCRay& ray, uint32_t x, uint32_t y) = 0;
+
     virtual bool OnHit(const RTCHit& hit, RTCRay& ray, size_t idx) = 0;
     virtual void OnMiss(const RTCRay& ray, size_t idx) = 0;
 
-    inline RTCDevice GetDevice() const { return m_Device; }
-    inline RTCScene  GetScene () const { return m_Scene; }
+    //-------------------------------------------------------------------------
+    //! @brief      RunSequence() の各フレームの前に呼び出される更新処理です.
+    //!
+    //! @param[in]      frame       フレーム番号です.
+    //! @retval true    描画を続ける.
+    //! @retval false   描画を中断する.
+    //-------------------------------------------------------------------------
+    virtual bool OnUpdate(uint32_t frame) { (void)frame; return true; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッシュを読み込みます.
+    //!
+    //! @param[in]      path        ファイルパスです.
+    //! @return     ジオメトリ番号を返却します. 失敗時は RTC_INVALID_GEOMETRY_ID を返却します.
+    //! @note       OnInit() から呼び出してください. シーンキャッシュが最新ならキャッシュを使用します.
+    //-------------------------------------------------------------------------
+    uint32_t LoadMesh(const char* path);
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッシュを取得します.
+    //!
+    //! @note       重複排除したメッシュはプロトタイプ(オブジェクト空間)を返却します.
+    //-------------------------------------------------------------------------
+    const Mesh* GetMesh(uint32_t geomID) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      変形するメッシュを読み込みます.
+    //!
+    //! @param[in]      paths           時間ステップごとのファイルパスです.
+    //! @param[in]      timeStepCount   時間ステップ数です.
+    //! @return     ジオメトリ番号を返却します. 失敗時は RTC_INVALID_GEOMETRY_ID を返却します.
+    //! @note       OnInit() から呼び出してください. 時間ステップは [0, 1] を等間隔に分割し, トポロジーは一致している必要があります.
+    //-------------------------------------------------------------------------
+    uint32_t LoadMotionMesh(const char* const* paths, uint32_t timeStepCount);
+
+    //-------------------------------------------------------------------------
+    //! @brief      プロトタイプを読み込みます.
+    //!
+    //! @param[in]      path        ファイルパスです.
+    //! @return     プロトタイプ番号を返却します.
+    //! @note       OnInit() から呼び出してください. インスタンスを追加するまでは走査されません.
+    //-------------------------------------------------------------------------
+    uint32_t LoadPrototype(const char* path);
+
+    //-------------------------------------------------------------------------
+    //! @brief      インスタンスを追加します.
+    //!
+    //! @return     hit.instID[0] で通知されるジオメトリ番号を返却します.
+    //-------------------------------------------------------------------------
+    uint32_t AddInstance(uint32_t prototype, const asdx::Matrix& transform);
+
+    //-------------------------------------------------------------------------
+    //! @brief      移動するインスタンスを追加します.
+    //!
+    //! @note       変換行列は [0, 1] を等間隔に分割した時間ステップごとに指定します.
+    //-------------------------------------------------------------------------
+    uint32_t AddMotionInstance(uint32_t prototype, const asdx::Matrix* transforms, uint32_t timeStepCount);
+
+    //-------------------------------------------------------------------------
+    //! @brief      パッチを追加します.
+    //!
+    //! @note       パッチの境界に最初にレイが当たった時にテッセレーションします.
+    //!             hit.primID はパッチ番号, hit.u/v はパッチのパラメータです.
+    //-------------------------------------------------------------------------
+    uint32_t AddPatches(const PatchSource* source);
+
+    //-------------------------------------------------------------------------
+    //! @brief      髪や毛皮の B-スプライン曲線を追加します.
+    //!
+    //! @note       curves は Term() まで保持してください. 追加前に WidenToPixel() を呼び出してください.
+    //-------------------------------------------------------------------------
+    uint32_t AddCurves(const Curves* curves);
+
+    const Mesh* GetPrototype(uint32_t prototype) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      交差したメッシュを取得します.
+    //!
+    //! @note       インスタンスはプロトタイプのメッシュを返却します. インスタンスの hit.Ng はオブジェクト空間です.
+    //-------------------------------------------------------------------------
+    const Mesh* GetHitMesh(const RTCHit& hit) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      曲線の交差情報(ストランド, ストランド上のパラメータ, 接線)を取得します.
+    //!
+    //! @retval true    AddCurves() のジオメトリとの交差.
+    //! @retval false   それ以外.
+    //-------------------------------------------------------------------------
+    bool GetCurveHit(const RTCHit& hit, CurveHit& result) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      交差位置の量子化された法線, テクスチャ座標, 接線空間を復元します.
+    //!
+    //! @retval true    復元に成功. インスタンスはオブジェクト空間です.
+    //! @retval false   曲線とパッチの場合.
+    //-------------------------------------------------------------------------
+    bool GetHitAttributes(const RTCHit& hit, SurfaceAttributes& result) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      アルファマスクを設定します.
+    //!
+    //! @param[in]      geomID      ジオメトリ番号です.
+    //! @param[in]      mask        アルファマスクです. nullptr なら解除します.
+    //! @note       OnInit() から呼び出してください. 走査中にメッシュのテクスチャ座標で判定するので, 抜けた交差は OnHit() に届きません.
+    //!             インスタンス(重複排除したメッシュを含む)は共有するプロトタイプに設定します.
+    //!             mask は Term() まで保持してください.
+    //-------------------------------------------------------------------------
+    bool SetAlphaMask(uint32_t geomID, const AlphaMask* mask);
+
+    //-------------------------------------------------------------------------
+    //! @brief      プロトタイプの全インスタンスにアルファマスクを設定します.
+    //!
+    //! @note       SetAlphaMask() と同じです.
+    //-------------------------------------------------------------------------
+    bool SetPrototypeAlphaMask(uint32_t prototype, const AlphaMask* mask);
+
+    bool GetInstanceTransform(uint32_t instID, asdx::Matrix& transform, float time = 0.0f) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      LoadMesh() のメッシュの頂点座標を書き込み用に取得します.
+    //!
+    //! @return     インスタンス(重複排除したメッシュを含む)と変形するメッシュは nullptr を返却します.
+    //! @note       頂点属性は読み込み時の値のままです.
+    //-------------------------------------------------------------------------
+    asdx::Vector3* MapPositions(uint32_t geomID);
+
+    //-------------------------------------------------------------------------
+    //! @brief      書き込んだ頂点座標を RunSequence() の次のフレームで反映します.
+    //-------------------------------------------------------------------------
+    bool UnmapPositions(uint32_t geomID);
+
+    bool SetInstanceTransform(uint32_t instID, const asdx::Matrix& transform);
+
+    inline Accel*    GetAccel () const { return m_Accel.get(); }
+#if SALTY2_USE_EMBREE
+    // 以前の Embree 直結版との互換用です. 組み込みBVHの場合は nullptr を返却します.
+    inline RTCDevice GetDevice() const { return (m_Accel) ? m_Accel->GetDevice() : nullptr; }
+    inline RTCScene  GetScene () const { return (m_Accel) ? m_Accel->GetScene () : nullptr; }
+#endif//SALTY2_USE_EMBREE
     inline uint32_t  GetWidth () const { return m_Width; }
     inline uint32_t  GetHeight() const { return m_Height; }
     inline void SetColor (size_t idx, const asdx::Vector3& value) { m_ColorBuffer [idx] = value; }
@@ -64,19 +249,45 @@ protected:
     inline size_t CalcIndex(size_t x, size_t y) const { return m_Width * y + x; }
 
 private:
-    RTCDevice                   m_Device;
-    RTCScene                    m_Scene;
+    std::unique_ptr<Accel>                          m_Accel;
+    std::vector<std::unique_ptr<Mesh>>              m_Meshes;               // ジオメトリ番号順です. m_Accel と共有します.
+    std::vector<std::unique_ptr<Mesh>>              m_Prototypes;           // プロトタイプ番号順です. m_Accel と共有します.
+    std::vector<std::unique_ptr<Mesh>>              m_PendingMeshes;        // 重複排除待ちの LoadMesh() の結果です.
+    std::vector<std::vector<std::unique_ptr<Mesh>>> m_MotionSteps;          // ジオメトリ番号順です. LoadMotionMesh() の時間ステップ 1 以降です(0 は m_Meshes).
+    std::vector<const Curves*>                      m_Curves;               // ジオメトリ番号順です. 呼び出し側が所有し, m_Accel と共有します.
+    std::vector<std::unique_ptr<AlphaTestSource>>   m_AlphaTests;           // m_Accel が参照するヒットフィルタの引数です.
+    uint32_t                    m_GeometryCount;        // 発行済みのトップレベルのジオメトリ番号の数です(重複排除待ちを含む).
+    uint32_t                    m_DedupInstanceCount;
+    uint32_t                    m_DedupTriangleCount;   // 重複排除で BVH 構築から外した三角形数です.
+    uint32_t                    m_UniqueTriangleCount;  // 重複排除したメッシュのうち, 構築する三角形数です.
+    bool                        m_DedupMeshes;
+    SceneCache                  m_SceneCache;           // m_Meshes と m_Accel より長く保持します.
+    std::string                 m_SceneCachePath;
+    std::vector<std::string>    m_MeshPaths;            // LoadMesh() の呼び出し順のファイルパスです.
+    uint32_t                    m_CachedMeshCount;
+    bool                        m_SceneCachePending;    // "<path>.tmp" に書き出した新しいキャッシュです. Term() で置き換えます.
+#if SALTY2_USE_OIDN
     OIDNDevice                  m_Denoiser;
     OIDNFilter                  m_Filter;
+#endif
     uint32_t                    m_Width;
     uint32_t                    m_Height;
     uint32_t                    m_MaxBounce;
     uint32_t                    m_Seconds;
+    float                       m_ShutterOpen;
+    float                       m_ShutterClose;
     std::vector<asdx::Vector3>  m_ColorBuffer;
     std::vector<asdx::Vector3>  m_AlbedoBuffer;
     std::vector<asdx::Vector3>  m_NormalBuffer;
     std::vector<asdx::Vector3>  m_OutputBuffer;
     asdx::StopWatch             m_Timer;
+    asdx::StopWatch             m_PublishTimer;
+    SharedFrame                 m_SharedFrame;
 
+    void Render(const char* path);
+    void ClearBuffers();
     void SavePNG(const char* path);
+    void WriteSceneCache();
+    bool FlushMeshes();
+    uint32_t AddMeshGeometry(std::unique_ptr<Mesh>& mesh);
 };
\ No newline at end of file
@@ -0,0 +1,327 @@
+﻿//-----------------------------------------------------------------------------
+// File : sceneCache.h
+// Desc : Binary Scene Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mesh.h>
+#include <bvh.h>
+#include <mappedFile.h>
+
+
+//-----------------------------------------------------------------------------
+// Constant Values
+//-----------------------------------------------------------------------------
+static constexpr uint32_t SCENE_CACHE_VERSION = 2;  //!< 形式のバージョンです(変更したら更新すること).
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SCENE_CACHE_SEMANTIC enum
+///////////////////////////////////////////////////////////////////////////////
+enum SCENE_CACHE_SEMANTIC : uint32_t
+{
+    SCENE_CACHE_SEMANTIC_NORMAL = 0,    //!< 法線です.
+    SCENE_CACHE_SEMANTIC_TEXCOORD,      //!< テクスチャ座標です.
+    SCENE_CACHE_SEMANTIC_MATERIAL_ID,   //!< 三角形ごとのマテリアル番号です.
+    SCENE_CACHE_SEMANTIC_USER,          //!< これ以降はアプリケーションで定義します.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Material structure
+///////////////////////////////////////////////////////////////////////////////
+struct Material
+{
+    float       BaseColor[3];   //!< ベースカラーです.
+    float       Roughness;      //!< ラフネスです.
+    float       Emissive[3];    //!< 自己発光です.
+    float       Metalness;      //!< メタルネスです.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SceneCacheAttribute structure
+///////////////////////////////////////////////////////////////////////////////
+struct SceneCacheAttribute
+{
+    const void*     pData;      //!< 先頭ポインタです.
+    uint32_t        Stride;     //!< 要素のサイズ(バイト)です.
+    uint32_t        Count;      //!< 要素数です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SceneCacheWriter class
+///////////////////////////////////////////////////////////////////////////////
+class SceneCacheWriter
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SceneCacheWriter() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッシュを追加します.
+    //!
+    //! @param[in]      path        読み込み元のファイルパスです(更新の検出に使います).
+    //! @param[in]      mesh        メッシュです. Write() が終わるまで保持してください.
+    //! @return     メッシュ番号を返却します.
+    //-------------------------------------------------------------------------
+    uint32_t AddMesh(const char* path, const Mesh& mesh);
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッシュの頂点属性を追加します.
+    //!
+    //! @param[in]      meshIndex   メッシュ番号です.
+    //! @param[in]      semantic    属性の種類です.
+    //! @param[in]      attribute   属性データです. Write() が終わるまで保持してください.
+    //! @note       要素数は SCENE_CACHE_SEMANTIC_MATERIAL_ID なら三角形数, それ以外は頂点数にしてください.
+    //!             一致しない属性は SceneCache::Open() で読み捨てます.
+    //-------------------------------------------------------------------------
+    void AddAttribute(uint32_t meshIndex, uint32_t semantic, const SceneCacheAttribute& attribute);
+
+    //-------------------------------------------------------------------------
+    //! @brief      マテリアルテーブルを設定します.
+    //!
+    //! @param[in]      materials   マテリアルです. Write() が終わるまで保持してください.
+    //! @param[in]      count       マテリアル数です.
+    //-------------------------------------------------------------------------
+    void SetMaterials(const Material* materials, uint32_t count);
+
+    //-------------------------------------------------------------------------
+    //! @brief      構築済みの組み込みBVHを設定します.
+    //!
+    //! @param[in]      view        AddMesh() と同じ順序で構築したBVHです.
+    //-------------------------------------------------------------------------
+    void SetBVH(const BVH::View& view);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルに書き出します.
+    //!
+    //! @param[in]      path        出力ファイルパスです.
+    //! @retval true    書き出しに成功.
+    //! @retval false   書き出しに失敗.
+    //-------------------------------------------------------------------------
+    bool Write(const char* path) const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // MeshEntry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct MeshEntry
+    {
+        std::string     Path;
+        uint64_t        SourceSize;
+        int64_t         SourceTime;
+        const Mesh*     pMesh;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // AttributeEntry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct AttributeEntry
+    {
+        uint32_t            MeshIndex;
+        uint32_t            Semantic;
+        SceneCacheAttribute Attribute;
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<MeshEntry>      m_Meshes;
+    std::vector<AttributeEntry> m_Attributes;
+    const Material*             m_pMaterials    = nullptr;
+    uint32_t                    m_MaterialCount = 0;
+    BVH::View                   m_BVH           = {};
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    SceneCacheWriter            (const SceneCacheWriter&) = delete;
+    SceneCacheWriter& operator= (const SceneCacheWriter&) = delete;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SceneCache class
+// 書き出したキャッシュをメモリにマップし, 複製せずに参照します.
+///////////////////////////////////////////////////////////////////////////////
+class SceneCache
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SceneCache() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャッシュファイルを開きます.
+    //!
+    //! @param[in]      path        キャッシュファイルパスです.
+    //! @retval true    オープンに成功.
+    //! @retval false   ファイルが無いか, 形式やバージョンが異なる.
+    //-------------------------------------------------------------------------
+    bool Open(const char* path);
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャッシュファイルを閉じます.
+    //!
+    //! @note       参照しているメッシュやBVHを破棄してから呼び出してください.
+    //-------------------------------------------------------------------------
+    void Close();
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャッシュファイルを開いているかどうかチェックします.
+    //-------------------------------------------------------------------------
+    inline bool IsOpen() const { return m_File.GetData() != nullptr; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルサイズを取得します.
+    //-------------------------------------------------------------------------
+    inline size_t GetFileSize() const { return m_File.GetSize(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッシュ数を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetMeshCount() const { return uint32_t(m_Meshes.size()); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッシュが読み込み元のファイルと一致するかどうかチェックします.
+    //!
+    //! @param[in]      index       メッシュ番号です.
+    //! @param[in]      path        読み込み元のファイルパスです.
+    //! @retval true    パス, サイズ, 更新日時が一致.
+    //! @retval false   一致しない.
+    //-------------------------------------------------------------------------
+    bool IsMeshValid(uint32_t index, const char* path) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッシュをキャッシュのメモリを参照するように設定します.
+    //!
+    //! @param[in]      index       メッシュ番号です.
+    //! @param[out]     mesh        設定するメッシュです.
+    //! @retval true    設定に成功.
+    //! @retval false   メッシュ番号が不正.
+    //! @note       書き込み時コピーでマップしているので, 書き換えてもファイルには反映されません.
+    //!             量子化した頂点属性(Mesh::Attributes)も同じように参照します.
+    //-------------------------------------------------------------------------
+    bool AttachMesh(uint32_t index, Mesh& mesh);
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッシュの頂点属性を取得します.
+    //!
+    //! @param[in]      index       メッシュ番号です.
+    //! @param[in]      semantic    属性の種類です.
+    //! @param[out]     attribute   属性データです.
+    //! @retval true    取得に成功.
+    //! @retval false   属性が無い.
+    //-------------------------------------------------------------------------
+    bool GetAttribute(uint32_t index, uint32_t semantic, SceneCacheAttribute& attribute) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      マテリアルテーブルを取得します.
+    //-------------------------------------------------------------------------
+    inline const Material* GetMaterials() const { return m_pMaterials; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      マテリアル数を取得します.
+    //-------------------------------------------------------------------------
+    inline uint32_t GetMaterialCount() const { return m_MaterialCount; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      構築済みの組み込みBVHを取得します.
+    //!
+    //! @param[out]     view        構築済みのデータです.
+    //! @retval true    取得に成功.
+    //! @retval false   BVHが含まれていない.
+    //-------------------------------------------------------------------------
+    bool GetBVH(BVH::View& view) const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // MeshEntry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct MeshEntry
+    {
+        const char*     pPath;
+        uint32_t        PathLength;
+        uint64_t        SourceSize;
+        int64_t         SourceTime;
+        asdx::Vector3*  pPositions;
+        size_t          PositionSize;
+        uint32_t        VertexCount;
+        uint32_t*       pIndices;
+        size_t          IndexSize;
+        uint32_t        TriangleCount;
+        uint32_t*       pNormals;
+        size_t          NormalSize;
+        uint32_t*       pTangents;
+        size_t          TangentSize;
+        uint32_t*       pTexCoords;
+        size_t          TexCoordSize;
+        asdx::Vector4   TexCoordRange;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // AttributeEntry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct AttributeEntry
+    {
+        uint32_t            MeshIndex;
+        uint32_t            Semantic;
+        SceneCacheAttribute Attribute;
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    MappedFile                  m_File;
+    std::vector<MeshEntry>      m_Meshes;
+    std::vector<AttributeEntry> m_Attributes;
+    const Material*             m_pMaterials    = nullptr;
+    uint32_t                    m_MaterialCount = 0;
+    BVH::View                   m_BVH           = {};
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    SceneCache            (const SceneCache&) = delete;
+    SceneCache& operator= (const SceneCache&) = delete;
+};
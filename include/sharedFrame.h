@@ -0,0 +1,113 @@
+﻿//-----------------------------------------------------------------------------
+// File : sharedFrame.h
+// Desc : Shared Memory Frame Buffer.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <atomic>
+#include <asdxMath.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SharedFrameHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct SharedFrameHeader
+{
+    static constexpr uint32_t kMagic   = 0x32544C53;   // 'SLT2'
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t                Magic;          //!< マジックナンバーです.
+    uint32_t                Version;        //!< ヘッダバージョンです.
+    uint32_t                Width;          //!< 横幅です.
+    uint32_t                Height;         //!< 縦幅です.
+    uint32_t                PassCount;      //!< バッファに含まれる完了済みパス数です(描画途中は 0).
+    uint32_t                Reserved;       //!< 予約領域です.
+    std::atomic<uint64_t>   Generation;     //!< シーケンスロック世代番号です(奇数の間は書き込み中).
+    uint64_t                ColorOffset;    //!< 先頭からカラーバッファまでのオフセットです.
+    uint64_t                OutputOffset;   //!< 先頭から出力バッファまでのオフセットです.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SharedFrame class
+///////////////////////////////////////////////////////////////////////////////
+class SharedFrame
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SharedFrame() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~SharedFrame();
+
+    //-------------------------------------------------------------------------
+    //! @brief      共有メモリを生成します.
+    //!
+    //! @param[in]      name        共有メモリ名です.
+    //! @param[in]      width       横幅です.
+    //! @param[in]      height      縦幅です.
+    //! @retval true    生成に成功.
+    //! @retval false   生成に失敗.
+    //! @note       生成済みの場合は, 先に Term() で破棄してから作り直します.
+    //-------------------------------------------------------------------------
+    bool Init(const char* name, uint32_t width, uint32_t height);
+
+    //-------------------------------------------------------------------------
+    //! @brief      共有メモリを破棄します.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      フレームバッファを公開します.
+    //!
+    //! @param[in]      colors      カラーバッファです.
+    //! @param[in]      outputs     出力バッファです.
+    //! @param[in]      passCount   バッファに含まれる完了済みパス数です.
+    //! @note       読み取り側は passCount が 0 のフレームを描画途中の結果として扱います.
+    //-------------------------------------------------------------------------
+    void Publish(const asdx::Vector3* colors, const asdx::Vector3* outputs, uint32_t passCount);
+
+    //-------------------------------------------------------------------------
+    //! @brief      有効かどうかチェックします.
+    //-------------------------------------------------------------------------
+    inline bool IsValid() const { return m_pHeader != nullptr; }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    void*               m_Handle    = nullptr;
+    uint8_t*            m_pBase     = nullptr;
+    SharedFrameHeader*  m_pHeader   = nullptr;
+    size_t              m_Size      = 0;
+    char                m_Name[256] = {};
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    SharedFrame             (const SharedFrame&) = delete;
+    SharedFrame& operator = (const SharedFrame&) = delete;
+};
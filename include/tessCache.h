@@ -0,0 +1,259 @@
+﻿//-----------------------------------------------------------------------------
+// File : tessCache.h
+// Desc : Tessellation Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <asdxMath.h>
+#include <bvh.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PatchMesh structure
+///////////////////////////////////////////////////////////////////////////////
+struct PatchMesh
+{
+    std::vector<asdx::Vector3>  Positions;  //!< 頂点座標です.
+    std::vector<asdx::Vector2>  Params;     //!< 頂点ごとのパッチ上のパラメータです(交差時に hit.u, hit.v として補間します).
+    std::vector<uint32_t>       Indices;    //!< インデックスです(三角形あたり3個).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PatchSource class
+// 交差判定の時点で初めて三角形に分割するパッチ群(ディスプレイスメントや手続き的な曲面)です.
+///////////////////////////////////////////////////////////////////////////////
+class PatchSource
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    virtual ~PatchSource() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      パッチ数を取得します.
+    //-------------------------------------------------------------------------
+    virtual uint32_t GetPatchCount() const = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      パッチの境界を取得します.
+    //!
+    //! @param[in]      patch       パッチ番号です.
+    //! @return     分割後の三角形(変位を含む)を全て包含する境界を返却します.
+    //! @note       構築時に呼び出します. 分割せずに求められる保守的な境界を返してください.
+    //-------------------------------------------------------------------------
+    virtual asdx::AABB GetPatchBounds(uint32_t patch) const = 0;
+
+    //-------------------------------------------------------------------------
+    //! @brief      パッチを三角形に分割します.
+    //!
+    //! @param[in]      patch       パッチ番号です.
+    //! @param[out]     result      分割結果です.
+    //! @retval true    分割に成功.
+    //! @retval false   分割に失敗.
+    //! @note       描画スレッドから並列に呼び出されます. 同じパッチに対して常に同じ結果を返してください.
+    //-------------------------------------------------------------------------
+    virtual bool Tessellate(uint32_t patch, PatchMesh& result) const = 0;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TessellationStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct TessellationStats
+{
+    size_t      Capacity;           //!< 上限サイズ(バイト)です.
+    size_t      MemorySize;         //!< 保持している分割結果のサイズ(バイト)です.
+    size_t      PeakMemorySize;     //!< 保持した分割結果のサイズの最大値(バイト)です.
+    size_t      SlotMemorySize;     //!< パッチごとの管理領域のサイズ(バイト)です.
+    uint64_t    TessellateCount;    //!< 分割した回数です(追い出し後の再分割を含み, 同時に分割して捨てたものは含みません).
+    uint64_t    EvictCount;         //!< 追い出した回数です.
+    uint64_t    TriangleCount;      //!< 分割で生成した三角形数の合計です.
+    uint32_t    ResidentCount;      //!< 保持しているパッチ数です.
+    double      TessellateMsec;     //!< 分割にかかった時間(全スレッドの合計, ミリ秒)です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TessellationCache class
+// パッチの分割結果を全スレッドで共有する, サイズ上限付きのキャッシュです.
+// 参照はパッチごとの参照カウントとポインタの読み込みだけで, ロックを取りません.
+// 上限を超えた場合は最後に参照された時刻の古いものから, 参照中でないものを追い出します.
+// 参照中のものは追い出せないので, 保持するサイズは上限にスレッドごとに分割結果1つ分を加えた値まで超えることがあります.
+///////////////////////////////////////////////////////////////////////////////
+class TessellationCache
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static constexpr size_t DEFAULT_CAPACITY = 256 * 1024 * 1024;  //!< 既定の上限サイズ(バイト)です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    TessellationCache() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~TessellationCache();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      capacity    分割結果を保持する上限サイズ(バイト)です. 0 なら既定値.
+    //! @note       参照中の分割結果は追い出さないので, 上限を超えるのは参照中の分(スレッドごとに高々1つ)だけです.
+    //-------------------------------------------------------------------------
+    void Init(size_t capacity);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      パッチ群を登録します.
+    //!
+    //! @param[in]      source      パッチ群です. Term() を呼ぶまで破棄しないでください.
+    //! @return     グループ番号を返却します.
+    //! @note       交差判定と並行して呼び出さないでください.
+    //-------------------------------------------------------------------------
+    uint32_t Register(const PatchSource* source);
+
+    //-------------------------------------------------------------------------
+    //! @brief      パッチとの最近傍の交差を求めます.
+    //!
+    //! @param[in]      group       グループ番号です.
+    //! @param[in]      patch       パッチ番号です.
+    //! @param[in,out]  ray         レイです. 交差した場合は tmax を交差距離に更新します.
+    //! @param[out]     hit         交差情報です. PrimID はパッチ番号, U と V はパッチ上のパラメータです.
+    //! @retval true    交差あり.
+    //! @retval false   交差なし.
+    //! @note       分割されていなければ, その場で分割してキャッシュに入れます.
+    //-------------------------------------------------------------------------
+    bool Intersect(uint32_t group, uint32_t patch, asdx::Ray& ray, BVHHit& hit);
+
+    //-------------------------------------------------------------------------
+    //! @brief      パッチで遮蔽されているかどうかチェックします.
+    //!
+    //! @param[in]      group       グループ番号です.
+    //! @param[in]      patch       パッチ番号です.
+    //! @param[in]      ray         レイです.
+    //! @retval true    [tmin, tmax] の間に交差あり.
+    //! @retval false   交差なし.
+    //-------------------------------------------------------------------------
+    bool Occluded(uint32_t group, uint32_t patch, const asdx::Ray& ray);
+
+    //-------------------------------------------------------------------------
+    //! @brief      パッチ群を取得します.
+    //-------------------------------------------------------------------------
+    inline const PatchSource* GetSource(uint32_t group) const
+    { return (group < m_Groups.size()) ? m_Groups[group].pSource : nullptr; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------
+    TessellationStats GetStats() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        BVH                         Bvh;        // リーフに三角形を詰めているので, 頂点座標は保持しない.
+        std::vector<asdx::Vector2>  Params;
+        std::vector<uint32_t>       Indices;
+        size_t                      Size;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Slot structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Slot
+    {
+        std::atomic<Entry*>     pEntry;     // 分割結果です. 分割されていなければ nullptr.
+        std::atomic<uint32_t>   Pins;       // 参照中のスレッド数です. 0 でなければ追い出さない.
+        std::atomic<uint32_t>   LastUse;    // 最後に参照した時刻です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Group structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Group
+    {
+        const PatchSource*      pSource;
+        std::unique_ptr<Slot[]> pSlots;
+        uint32_t                Count;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Resident structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Resident
+    {
+        uint32_t    Group;
+        uint32_t    Patch;
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<Group>      m_Groups;
+    mutable std::mutex      m_Mutex;        // 追加と追い出しを保護します.
+    std::vector<Resident>   m_Residents;    // 分割結果を持つパッチです(m_Mutex で保護).
+    std::atomic<uint32_t>   m_Clock     = {};
+    size_t                  m_Capacity  = DEFAULT_CAPACITY;
+    size_t                  m_Size      = 0;
+    size_t                  m_PeakSize  = 0;
+    size_t                  m_SlotSize  = 0;
+    uint64_t                m_TessellateCount = 0;
+    uint64_t                m_EvictCount      = 0;
+    uint64_t                m_TriangleCount   = 0;
+    double                  m_TessellateMsec  = 0.0;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    const Entry* Acquire(uint32_t group, uint32_t patch);
+    void Release(uint32_t group, uint32_t patch);
+    const Entry* Insert(uint32_t group, uint32_t patch);
+    void Evict();
+
+    TessellationCache            (const TessellationCache&) = delete;
+    TessellationCache& operator= (const TessellationCache&) = delete;
+};
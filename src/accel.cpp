@@ -0,0 +1,1997 @@
+﻿//-----------------------------------------------------------------------------
+// File : accel.cpp
+// Desc : Acceleration Structure.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <accel.h>
+#include <bvh.h>
+#include <motion.h>
+#include <asdxLogger.h>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Linker
+//-----------------------------------------------------------------------------
+#if SALTY2_USE_EMBREE
+#if defined(_MSC_VER)
+#pragma comment(lib, "embree3.lib")
+#endif
+#endif
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+//      経過時間をミリ秒で求めます.
+//-----------------------------------------------------------------------------
+inline double GetElapsedMsec(const std::chrono::steady_clock::time_point& begin)
+{ return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count(); }
+
+//-----------------------------------------------------------------------------
+//      時間ステップ数が有効かどうかチェックします.
+//-----------------------------------------------------------------------------
+inline bool IsValidTimeStepCount(uint32_t count)
+{
+    if (count == 0 || count > RTC_MAX_TIME_STEP_COUNT)
+    {
+        ELOG("Error : Invalid Time Step Count. count = %u", count);
+        return false;
+    }
+    return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DeformTracker class
+// 前回の再構築からの変形量を, 間引いた頂点の変位から見積もります.
+///////////////////////////////////////////////////////////////////////////////
+class DeformTracker
+{
+public:
+    static constexpr uint32_t SAMPLE_COUNT = 32;    // 記録する頂点数の上限です.
+
+    //-------------------------------------------------------------------------
+    //      頂点を設定し, 現在の形状を基準にします.
+    //-------------------------------------------------------------------------
+    void Init(const asdx::Vector3* vertices, uint32_t vertexCount)
+    {
+        m_pVertices   = vertices;
+        m_VertexCount = vertexCount;
+        m_Samples.resize(std::min(SAMPLE_COUNT, vertexCount));
+        m_Samples.shrink_to_fit();
+        Reset();
+    }
+
+    //-------------------------------------------------------------------------
+    //      現在の形状を基準にします.
+    //-------------------------------------------------------------------------
+    void Reset()
+    {
+        // 対角線長は全頂点から求める(再構築に比べれば十分に軽い).
+        asdx::AABB box;
+        for(auto i=0u; i<m_VertexCount; ++i)
+        { box.Expand(m_pVertices[i]); }
+        m_Diagonal = (m_VertexCount > 0) ? asdx::Vector3::Distance(box.mini, box.maxi) : 0.0f;
+
+        for(auto i=0u; i<m_Samples.size(); ++i)
+        { m_Samples[i] = m_pVertices[GetSampleIndex(i)]; }
+    }
+
+    //-------------------------------------------------------------------------
+    //      基準からの変形量を求めます.
+    //-------------------------------------------------------------------------
+    float Measure() const
+    {
+        if (m_Samples.empty())
+        { return 0.0f; }
+
+        // 平行移動だけならリフィットでも劣化しないので, 平均の変位を除いてから測る.
+        const auto count = float(m_Samples.size());
+        asdx::Vector3 mean(0.0f, 0.0f, 0.0f);
+        for(auto i=0u; i<m_Samples.size(); ++i)
+        { mean += m_pVertices[GetSampleIndex(i)] - m_Samples[i]; }
+        mean /= count;
+
+        auto sum = 0.0f;
+        for(auto i=0u; i<m_Samples.size(); ++i)
+        {
+            auto d = m_pVertices[GetSampleIndex(i)] - m_Samples[i] - mean;
+            sum += asdx::Vector3::Dot(d, d);
+        }
+
+        return sqrtf(sum / count) / std::max(m_Diagonal, FLT_MIN);
+    }
+
+private:
+    const asdx::Vector3*        m_pVertices     = nullptr;
+    uint32_t                    m_VertexCount   = 0;
+    float                       m_Diagonal      = 0.0f;
+    std::vector<asdx::Vector3>  m_Samples;
+
+    //-------------------------------------------------------------------------
+    //      記録する頂点の番号を求めます(頂点全体から等間隔に取る).
+    //-------------------------------------------------------------------------
+    inline uint32_t GetSampleIndex(uint32_t i) const
+    { return uint32_t(uint64_t(i) * m_VertexCount / m_Samples.size()); }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RefitPlanner class
+// 書き換えられたメッシュごとに, リフィットか再構築かを変形量と時間の目安から決めます.
+///////////////////////////////////////////////////////////////////////////////
+class RefitPlanner
+{
+public:
+    static constexpr float FORCE_REBUILD_SCALE = 4.0f;  // 閾値のこの倍を超えたら時間の目安を超えても再構築する.
+
+    //-------------------------------------------------------------------------
+    //      初期化処理を行います.
+    //-------------------------------------------------------------------------
+    void Init(const AccelDesc& desc)
+    {
+        m_Threshold  = desc.RebuildThreshold;
+        m_BudgetMsec = desc.RebuildBudgetMsec;
+        m_Track      = (desc.SceneFlags & RTC_SCENE_FLAG_DYNAMIC) != 0;
+    }
+
+    //-------------------------------------------------------------------------
+    //      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term()
+    {
+        m_Meshes .clear();
+        m_Indices.clear();
+        m_Dirty  .clear();
+        m_MsecPerTriangle = 0.0;
+    }
+
+    //-------------------------------------------------------------------------
+    //      更新できるメッシュを登録します.
+    //-------------------------------------------------------------------------
+    void Add(uint32_t geomID, const asdx::Vector3* vertices, uint32_t vertexCount, uint32_t triangleCount)
+    {
+        if (geomID >= m_Indices.size())
+        { m_Indices.resize(geomID + 1, RTC_INVALID_GEOMETRY_ID); }
+        m_Indices[geomID] = uint32_t(m_Meshes.size());
+
+        Entry entry;
+        entry.GeomID        = geomID;
+        entry.TriangleCount = triangleCount;
+        entry.Dirty         = false;
+
+        // 変形量を測らない場合は常に再構築するので, 頂点も記録しない.
+        if (m_Track)
+        { entry.Tracker.Init(vertices, vertexCount); }
+
+        m_Meshes.push_back(std::move(entry));
+    }
+
+    //-------------------------------------------------------------------------
+    //      登録済みのメッシュかどうかチェックします.
+    //-------------------------------------------------------------------------
+    inline bool Contains(uint32_t geomID) const
+    { return geomID < m_Indices.size() && m_Indices[geomID] != RTC_INVALID_GEOMETRY_ID; }
+
+    //-------------------------------------------------------------------------
+    //      メッシュが書き換えられたことを記録します.
+    //-------------------------------------------------------------------------
+    bool MarkDirty(uint32_t geomID)
+    {
+        if (!Contains(geomID))
+        { return false; }
+
+        auto& entry = m_Meshes[m_Indices[geomID]];
+        if (!entry.Dirty)
+        {
+            entry.Dirty = true;
+            m_Dirty.push_back(m_Indices[geomID]);
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      書き換えられたメッシュがあるかどうかチェックします.
+    //-------------------------------------------------------------------------
+    inline bool HasDirty() const
+    { return !m_Dirty.empty(); }
+
+    //-------------------------------------------------------------------------
+    //      書き換えられたメッシュの更新方法を決めます.
+    //-------------------------------------------------------------------------
+    template<typename Func>
+    void Plan(const Func& func)
+    {
+        std::vector<std::pair<float, uint32_t>> candidates(m_Dirty.size());
+        for(size_t i=0; i<m_Dirty.size(); ++i)
+        {
+            const auto& entry = m_Meshes[m_Dirty[i]];
+            candidates[i] = std::make_pair(m_Track ? entry.Tracker.Measure() : FLT_MAX, m_Dirty[i]);
+        }
+
+        // 変形の大きい順に, 時間の目安に収まる分だけ再構築する.
+        std::sort(candidates.begin(), candidates.end(),
+            [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; });
+
+        auto spent = 0.0;
+        for(const auto& itr : candidates)
+        {
+            auto& entry   = m_Meshes[itr.second];
+            auto  rebuild = false;
+            if (itr.first >= m_Threshold)
+            {
+                auto cost = double(entry.TriangleCount) * m_MsecPerTriangle;
+                rebuild = (m_BudgetMsec <= 0.0)
+                       || (spent + cost <= m_BudgetMsec)
+                       || (itr.first >= m_Threshold * FORCE_REBUILD_SCALE);
+                if (rebuild)
+                { spent += cost; }
+            }
+
+            func(entry.GeomID, entry.TriangleCount, rebuild);
+
+            if (rebuild && m_Track)
+            { entry.Tracker.Reset(); }
+            entry.Dirty = false;
+        }
+
+        m_Dirty.clear();
+    }
+
+    //-------------------------------------------------------------------------
+    //      再構築にかかった時間から三角形あたりの構築時間を見積もり直します.
+    //-------------------------------------------------------------------------
+    void Feedback(uint64_t triangleCount, double msec)
+    {
+        if (triangleCount == 0)
+        { return; }
+
+        auto value = msec / double(triangleCount);
+        m_MsecPerTriangle = (m_MsecPerTriangle > 0.0) ? (m_MsecPerTriangle + value) * 0.5 : value;
+    }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        uint32_t        GeomID;
+        uint32_t        TriangleCount;
+        DeformTracker   Tracker;
+        bool            Dirty;
+    };
+
+    std::vector<Entry>      m_Meshes;
+    std::vector<uint32_t>   m_Indices;          // ジオメトリ番号から m_Meshes の番号への対応です.
+    std::vector<uint32_t>   m_Dirty;
+    float                   m_Threshold         = 0.05f;
+    double                  m_BudgetMsec        = 0.0;
+    double                  m_MsecPerTriangle   = 0.0;
+    bool                    m_Track             = false;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PatchGeometry structure
+// 遅延分割するパッチ群です. 交差判定の関数にユーザーデータとして渡します.
+///////////////////////////////////////////////////////////////////////////////
+struct PatchGeometry
+{
+    TessellationCache*  pCache;
+    uint32_t            Group;
+    uint32_t            GeomID;
+    BoxBVH              Bvh;        // 組み込みBVHで使う, パッチの境界のBVHです.
+    bool                Built;
+};
+
+//-----------------------------------------------------------------------------
+// Constant Values
+//-----------------------------------------------------------------------------
+static constexpr uint32_t CURVE_PART_COUNT = 2;    // 組み込みBVHで曲線のセグメントを等分する数です(増やすとBVHが大きくなる).
+
+///////////////////////////////////////////////////////////////////////////////
+// CurveGeometry structure
+// 組み込みBVHで判定するBスプライン曲線です. 交差判定の関数にユーザーデータとして渡します.
+///////////////////////////////////////////////////////////////////////////////
+struct CurveGeometry
+{
+    const Curves*       pCurves;
+    uint32_t            GeomID;
+    BoxBVH              Bvh;        // セグメントを CURVE_PART_COUNT 等分した区間の境界のBVHです.
+    bool                Built;
+};
+
+#if SALTY2_USE_EMBREE
+///////////////////////////////////////////////////////////////////////////////
+// HitFilter structure
+// Embree のフィルタ関数に渡す判定関数です.
+///////////////////////////////////////////////////////////////////////////////
+struct HitFilter
+{
+    BVH::FilterFunc     Func;
+    const void*         pUserPtr;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// AccelEmbree class
+///////////////////////////////////////////////////////////////////////////////
+class AccelEmbree : public Accel
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~AccelEmbree() override
+    { Term(); }
+
+    //-------------------------------------------------------------------------
+    //      初期化処理を行います.
+    //-------------------------------------------------------------------------
+    bool Init(const AccelDesc& desc) override
+    {
+        m_Device = rtcNewDevice(desc.DeviceConfig);
+        if (m_Device == nullptr)
+        {
+            ELOG("Error : rtcNewDevice() Failed. config = %" ASDX_PRIs ", error = %d",
+                (desc.DeviceConfig != nullptr) ? desc.DeviceConfig : "(default)", int(rtcGetDeviceError(nullptr)));
+            return false;
+        }
+
+        rtcSetDeviceErrorFunction(m_Device, OnError, nullptr);
+        rtcSetDeviceMemoryMonitorFunction(m_Device, OnMemory, this);
+
+        m_Scene = rtcNewScene(m_Device);
+        if (m_Scene == nullptr)
+        {
+            ELOG("Error : rtcNewScene() Failed.");
+            return false;
+        }
+
+        rtcSetSceneBuildQuality(m_Scene, desc.BuildQuality);
+        rtcSetSceneFlags(m_Scene, desc.SceneFlags);
+
+        m_BuildQuality  = desc.BuildQuality;
+        m_TriangleCount = 0;
+        m_Committed     = false;
+        m_Planner.Init(desc);
+        m_TessCache.Init(desc.TessellationCacheSize);
+        rtcInitIntersectContext(&m_Context);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term() override
+    {
+        if (m_Scene != nullptr)
+        {
+            rtcReleaseScene(m_Scene);
+            m_Scene = nullptr;
+        }
+
+        // インスタンスが参照を持つので, 上位のシーンの後に解放する.
+        for(auto& itr : m_Prototypes)
+        { rtcReleaseScene(itr); }
+        m_Prototypes        .clear();
+        m_InstancePrototypes.clear();
+        m_TriangleMeshes    .clear();
+        m_Planner.Term();
+
+        // 交差判定の関数から参照されなくなってから解放する.
+        m_PatchGeometries.clear();
+        m_HitFilters     .clear();
+        m_TessCache.Term();
+
+        if (m_Device != nullptr)
+        {
+            rtcReleaseDevice(m_Device);
+            m_Device = nullptr;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    //      三角形メッシュを追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddTriangles
+    (
+        const asdx::Vector3*    vertices,
+        uint32_t                vertexCount,
+        const uint32_t*         indices,
+        uint32_t                triangleCount
+    ) override
+    {
+        auto geometry = rtcNewGeometry(m_Device, RTC_GEOMETRY_TYPE_TRIANGLE);
+        if (geometry == nullptr)
+        {
+            ELOG("Error : rtcNewGeometry() Failed.");
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        rtcSetGeometryBuildQuality(geometry, m_BuildQuality);
+
+        auto pVertices = rtcSetNewGeometryBuffer(
+            geometry, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, sizeof(asdx::Vector3), vertexCount);
+        auto pIndices = rtcSetNewGeometryBuffer(
+            geometry, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3, sizeof(uint32_t) * 3, triangleCount);
+        if (pVertices == nullptr || pIndices == nullptr)
+        {
+            ELOG("Error : rtcSetNewGeometryBuffer() Failed.");
+            rtcReleaseGeometry(geometry);
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        memcpy(pVertices, vertices, sizeof(asdx::Vector3) * vertexCount);
+        memcpy(pIndices,  indices,  sizeof(uint32_t) * 3 * triangleCount);
+
+        m_TriangleCount += triangleCount;
+
+        rtcCommitGeometry(geometry);
+        auto geomID = rtcAttachGeometry(m_Scene, geometry);
+        rtcReleaseGeometry(geometry);
+
+        if (geomID != RTC_INVALID_GEOMETRY_ID)
+        {
+            SetInstancePrototype(geomID, RTC_INVALID_GEOMETRY_ID);
+            m_TriangleMeshes[geomID] = true;
+        }
+
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      三角形メッシュを複製せずに追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddSharedTriangles
+    (
+        const asdx::Vector3*    vertices,
+        uint32_t                vertexCount,
+        const uint32_t*         indices,
+        uint32_t                triangleCount
+    ) override
+    {
+        auto geomID = AttachSharedTriangles(m_Scene, &vertices, 1, vertexCount, indices, triangleCount);
+        if (geomID != RTC_INVALID_GEOMETRY_ID)
+        {
+            SetInstancePrototype(geomID, RTC_INVALID_GEOMETRY_ID);
+            m_TriangleMeshes[geomID] = true;
+            m_Planner.Add(geomID, vertices, vertexCount, triangleCount);
+        }
+
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      時間ステップごとの頂点を持つ三角形メッシュを複製せずに追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddSharedMotionTriangles
+    (
+        const asdx::Vector3* const* vertices,
+        uint32_t                    timeStepCount,
+        uint32_t                    vertexCount,
+        const uint32_t*             indices,
+        uint32_t                    triangleCount
+    ) override
+    {
+        if (!IsValidTimeStepCount(timeStepCount))
+        { return RTC_INVALID_GEOMETRY_ID; }
+
+        auto geomID = AttachSharedTriangles(m_Scene, vertices, timeStepCount, vertexCount, indices, triangleCount);
+        if (geomID != RTC_INVALID_GEOMETRY_ID)
+        {
+            SetInstancePrototype(geomID, RTC_INVALID_GEOMETRY_ID);
+            m_TriangleMeshes[geomID] = true;
+        }
+
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      インスタンスで参照するプロトタイプを複製せずに追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddPrototype
+    (
+        const asdx::Vector3*    vertices,
+        uint32_t                vertexCount,
+        const uint32_t*         indices,
+        uint32_t                triangleCount
+    ) override
+    {
+        auto scene = rtcNewScene(m_Device);
+        if (scene == nullptr)
+        {
+            ELOG("Error : rtcNewScene() Failed.");
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        rtcSetSceneBuildQuality(scene, m_BuildQuality);
+
+        if (AttachSharedTriangles(scene, &vertices, 1, vertexCount, indices, triangleCount) == RTC_INVALID_GEOMETRY_ID)
+        {
+            rtcReleaseScene(scene);
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        m_Prototypes.push_back(scene);
+        return uint32_t(m_Prototypes.size() - 1);
+    }
+
+    //-------------------------------------------------------------------------
+    //      プロトタイプのインスタンスを追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddInstance(uint32_t prototype, const asdx::Matrix& transform) override
+    {
+        if (prototype >= m_Prototypes.size())
+        {
+            ELOG("Error : Invalid Prototype. prototype = %u", prototype);
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        auto geometry = rtcNewGeometry(m_Device, RTC_GEOMETRY_TYPE_INSTANCE);
+        if (geometry == nullptr)
+        {
+            ELOG("Error : rtcNewGeometry() Failed.");
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        // asdx::Matrix は行ベクトル形式なので, メモリ上の並びは列優先の 4x4 と一致する.
+        rtcSetGeometryInstancedScene(geometry, m_Prototypes[prototype]);
+        rtcSetGeometryTimeStepCount(geometry, 1);
+        rtcSetGeometryTransform(geometry, 0, RTC_FORMAT_FLOAT4X4_COLUMN_MAJOR, &transform._11);
+        rtcCommitGeometry(geometry);
+
+        auto geomID = rtcAttachGeometry(m_Scene, geometry);
+        rtcReleaseGeometry(geometry);
+
+        if (geomID != RTC_INVALID_GEOMETRY_ID)
+        { SetInstancePrototype(geomID, prototype); }
+
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      時間ステップごとの変換行列を持つインスタンスを追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddMotionInstance(uint32_t prototype, const asdx::Matrix* transforms, uint32_t timeStepCount) override
+    {
+        if (!IsValidTimeStepCount(timeStepCount))
+        { return RTC_INVALID_GEOMETRY_ID; }
+
+        if (prototype >= m_Prototypes.size())
+        {
+            ELOG("Error : Invalid Prototype. prototype = %u", prototype);
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        auto geometry = rtcNewGeometry(m_Device, RTC_GEOMETRY_TYPE_INSTANCE);
+        if (geometry == nullptr)
+        {
+            ELOG("Error : rtcNewGeometry() Failed.");
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        // 行列のまま渡すと線形に補間されるので, 分解して四元数で渡す.
+        rtcSetGeometryInstancedScene(geometry, m_Prototypes[prototype]);
+        rtcSetGeometryTimeStepCount(geometry, timeStepCount);
+        for(auto i=0u; i<timeStepCount; ++i)
+        {
+            MotionKey key;
+            DecomposeTransform(transforms[i], key);
+
+            RTCQuaternionDecomposition qd;
+            rtcInitQuaternionDecomposition(&qd);
+            qd.scale_x       = key.Scale[0];
+            qd.scale_y       = key.Scale[1];
+            qd.scale_z       = key.Scale[2];
+            qd.skew_xy       = key.Skew[0];
+            qd.skew_xz       = key.Skew[1];
+            qd.skew_yz       = key.Skew[2];
+            qd.quaternion_r  = key.Rotation[0];
+            qd.quaternion_i  = key.Rotation[1];
+            qd.quaternion_j  = key.Rotation[2];
+            qd.quaternion_k  = key.Rotation[3];
+            qd.translation_x = key.Translation[0];
+            qd.translation_y = key.Translation[1];
+            qd.translation_z = key.Translation[2];
+            rtcSetGeometryTransformQuaternion(geometry, i, &qd);
+        }
+        rtcCommitGeometry(geometry);
+
+        auto geomID = rtcAttachGeometry(m_Scene, geometry);
+        rtcReleaseGeometry(geometry);
+
+        if (geomID != RTC_INVALID_GEOMETRY_ID)
+        { SetInstancePrototype(geomID, prototype); }
+
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      交差判定の時点で三角形に分割するパッチ群を追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddPatches(const PatchSource* source) override
+    {
+        auto geometry = rtcNewGeometry(m_Device, RTC_GEOMETRY_TYPE_USER);
+        if (geometry == nullptr)
+        {
+            ELOG("Error : rtcNewGeometry() Failed.");
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        std::unique_ptr<PatchGeometry> patches(new PatchGeometry());
+        patches->pCache = &m_TessCache;
+        patches->Group  = m_TessCache.Register(source);
+        patches->Built  = true;
+
+        rtcSetGeometryBuildQuality(geometry, m_BuildQuality);
+        rtcSetGeometryUserPrimitiveCount(geometry, source->GetPatchCount());
+        rtcSetGeometryUserData(geometry, patches.get());
+        rtcSetGeometryBoundsFunction(geometry, OnPatchBounds, nullptr);
+        rtcSetGeometryIntersectFunction(geometry, OnPatchIntersect);
+        rtcSetGeometryOccludedFunction(geometry, OnPatchOccluded);
+
+        rtcCommitGeometry(geometry);
+        auto geomID = rtcAttachGeometry(m_Scene, geometry);
+        rtcReleaseGeometry(geometry);
+
+        if (geomID == RTC_INVALID_GEOMETRY_ID)
+        { return RTC_INVALID_GEOMETRY_ID; }
+
+        patches->GeomID = geomID;
+        m_PatchGeometries.push_back(std::move(patches));
+        SetInstancePrototype(geomID, RTC_INVALID_GEOMETRY_ID);
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      Bスプライン曲線を複製せずに追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddCurves(const Curves* curves) override
+    {
+        auto type = (curves->GetType() == CURVE_TYPE_ROUND)
+            ? RTC_GEOMETRY_TYPE_ROUND_BSPLINE_CURVE
+            : RTC_GEOMETRY_TYPE_FLAT_BSPLINE_CURVE;
+
+        auto geometry = rtcNewGeometry(m_Device, type);
+        if (geometry == nullptr)
+        {
+            ELOG("Error : rtcNewGeometry() Failed.");
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        rtcSetGeometryBuildQuality(geometry, m_BuildQuality);
+
+        // 制御点とセグメントは Curves のものをそのまま使う. Embree は読み込みにしか使わないので const を外して渡す.
+        rtcSetSharedGeometryBuffer(geometry, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4,
+            const_cast<asdx::Vector4*>(curves->GetPoints()), 0, sizeof(asdx::Vector4), curves->GetPointCount());
+        rtcSetSharedGeometryBuffer(geometry, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT,
+            const_cast<uint32_t*>(curves->GetSegments()), 0, sizeof(uint32_t), curves->GetSegmentCount());
+        if (rtcGetDeviceError(m_Device) != RTC_ERROR_NONE)
+        {
+            ELOG("Error : rtcSetSharedGeometryBuffer() Failed.");
+            rtcReleaseGeometry(geometry);
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        rtcCommitGeometry(geometry);
+        auto geomID = rtcAttachGeometry(m_Scene, geometry);
+        rtcReleaseGeometry(geometry);
+
+        if (geomID == RTC_INVALID_GEOMETRY_ID)
+        { return RTC_INVALID_GEOMETRY_ID; }
+
+        SetInstancePrototype(geomID, RTC_INVALID_GEOMETRY_ID);
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      三角形メッシュの交差を判定する関数を設定します.
+    //-------------------------------------------------------------------------
+    bool SetHitFilter(uint32_t geomID, BVH::FilterFunc func, const void* userPtr) override
+    {
+        if (geomID >= m_TriangleMeshes.size() || !m_TriangleMeshes[geomID])
+        { return false; }
+
+        SetFilterFunction(rtcGetGeometry(m_Scene, geomID), func, userPtr);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      プロトタイプの交差を判定する関数を設定します.
+    //-------------------------------------------------------------------------
+    bool SetPrototypeHitFilter(uint32_t prototype, BVH::FilterFunc func, const void* userPtr) override
+    {
+        if (prototype >= m_Prototypes.size())
+        { return false; }
+
+        // プロトタイプのシーンは三角形メッシュ1つだけを持つ.
+        SetFilterFunction(rtcGetGeometry(m_Prototypes[prototype], 0), func, userPtr);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      インスタンスが参照するプロトタイプ番号を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetInstancePrototype(uint32_t instID) const override
+    {
+        if (instID >= m_InstancePrototypes.size())
+        { return RTC_INVALID_GEOMETRY_ID; }
+
+        return m_InstancePrototypes[instID];
+    }
+
+    //-------------------------------------------------------------------------
+    //      インスタンスの変換行列を取得します.
+    //-------------------------------------------------------------------------
+    bool GetInstanceTransform(uint32_t instID, asdx::Matrix& transform, float time) const override
+    {
+        if (GetInstancePrototype(instID) == RTC_INVALID_GEOMETRY_ID)
+        { return false; }
+
+        rtcGetGeometryTransform(rtcGetGeometry(m_Scene, instID), time, RTC_FORMAT_FLOAT4X4_COLUMN_MAJOR, &transform._11);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      三角形メッシュの頂点を書き換えたことを通知します.
+    //-------------------------------------------------------------------------
+    bool UpdateTriangles(uint32_t geomID) override
+    {
+        if (!m_Planner.MarkDirty(geomID))
+        { return false; }
+
+        // 共有したバッファをそのまま読み直させる.
+        rtcUpdateGeometryBuffer(rtcGetGeometry(m_Scene, geomID), RTC_BUFFER_TYPE_VERTEX, 0);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      インスタンスの変換行列を変更します.
+    //-------------------------------------------------------------------------
+    bool SetInstanceTransform(uint32_t instID, const asdx::Matrix& transform) override
+    {
+        if (GetInstancePrototype(instID) == RTC_INVALID_GEOMETRY_ID)
+        { return false; }
+
+        auto geometry = rtcGetGeometry(m_Scene, instID);
+        rtcSetGeometryTimeStepCount(geometry, 1);
+        rtcSetGeometryTransform(geometry, 0, RTC_FORMAT_FLOAT4X4_COLUMN_MAJOR, &transform._11);
+        rtcCommitGeometry(geometry);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      加速構造を構築します.
+    //-------------------------------------------------------------------------
+    bool Commit() override
+    {
+        auto begin = std::chrono::steady_clock::now();
+
+        // 書き換えられたメッシュは構築品質を切り替えて確定させる.
+        // 上位のシーンは確定したジオメトリだけを作り直す(RTC_SCENE_FLAG_DYNAMIC の2段構成の場合).
+        uint64_t rebuildTriangles = 0;
+        m_RefitCount   = 0;
+        m_RebuildCount = 0;
+        m_Planner.Plan([&](uint32_t geomID, uint32_t triangleCount, bool rebuild)
+        {
+            auto geometry = rtcGetGeometry(m_Scene, geomID);
+            rtcSetGeometryBuildQuality(geometry, rebuild ? m_BuildQuality : RTC_BUILD_QUALITY_REFIT);
+            rtcCommitGeometry(geometry);
+
+            if (rebuild)
+            {
+                rebuildTriangles += triangleCount;
+                m_RebuildCount++;
+            }
+            else
+            { m_RefitCount++; }
+        });
+
+        // インスタンスが参照するシーンを先に確定させる.
+        for(auto& itr : m_Prototypes)
+        { rtcCommitScene(itr); }
+
+        rtcCommitScene(m_Scene);
+        m_BuildMsec = GetElapsedMsec(begin);
+
+        // 初回は全三角形を構築するので, その時間を再構築の見積もりの初期値にする.
+        // 以降はリフィットの時間も含むので, 見積もりは安全側に寄る.
+        if (!m_Committed)
+        {
+            m_Planner.Feedback(m_TriangleCount, m_BuildMsec);
+            m_Committed = true;
+        }
+        else
+        { m_Planner.Feedback(rebuildTriangles, m_BuildMsec); }
+
+        return rtcGetDeviceError(m_Device) == RTC_ERROR_NONE;
+    }
+
+    //-------------------------------------------------------------------------
+    //      最近傍の交差を求めます.
+    //-------------------------------------------------------------------------
+    void Intersect1(RTCRayHit& rayHit) const override
+    { rtcIntersect1(m_Scene, const_cast<RTCIntersectContext*>(&m_Context), &rayHit); }
+
+    //-------------------------------------------------------------------------
+    //      遮蔽されているかどうかチェックします.
+    //-------------------------------------------------------------------------
+    void Occluded1(RTCRay& ray) const override
+    { rtcOccluded1(m_Scene, const_cast<RTCIntersectContext*>(&m_Context), &ray); }
+
+    //-------------------------------------------------------------------------
+    //      バックエンドを取得します.
+    //-------------------------------------------------------------------------
+    ACCEL_BACKEND GetBackend() const override
+    { return ACCEL_BACKEND_EMBREE; }
+
+    //-------------------------------------------------------------------------
+    //      デバイスを取得します.
+    //-------------------------------------------------------------------------
+    RTCDevice GetDevice() const override
+    { return m_Device; }
+
+    //-------------------------------------------------------------------------
+    //      シーンを取得します.
+    //-------------------------------------------------------------------------
+    RTCScene GetScene() const override
+    { return m_Scene; }
+
+    //-------------------------------------------------------------------------
+    //      統計情報を取得します.
+    //-------------------------------------------------------------------------
+    AccelStats GetStats() const override
+    {
+        AccelStats result = {};
+        result.BuildMsec      = m_BuildMsec;
+        result.MemorySize     = size_t(std::max<int64_t>(m_MemorySize.load(), 0));
+        result.PeakMemorySize = size_t(std::max<int64_t>(m_PeakMemorySize.load(), 0));
+        result.RefitCount     = m_RefitCount;
+        result.RebuildCount   = m_RebuildCount;
+        result.Tessellation   = m_TessCache.GetStats();
+        return result;
+    }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    RTCDevice               m_Device        = nullptr;
+    RTCScene                m_Scene         = nullptr;
+    std::vector<RTCScene>   m_Prototypes;
+    std::vector<uint32_t>   m_InstancePrototypes;   // ジオメトリ番号からプロトタイプ番号への対応です.
+    std::vector<bool>       m_TriangleMeshes;       // ジオメトリ番号ごとの, 三角形メッシュかどうかです.
+    RTCIntersectContext     m_Context       = {};
+    RTCBuildQuality         m_BuildQuality  = RTC_BUILD_QUALITY_MEDIUM;
+    double                  m_BuildMsec     = 0.0;
+    std::atomic<int64_t>    m_MemorySize    = {};
+    std::atomic<int64_t>    m_PeakMemorySize= {};
+    RefitPlanner            m_Planner;
+    uint64_t                m_TriangleCount = 0;
+    uint32_t                m_RefitCount    = 0;
+    uint32_t                m_RebuildCount  = 0;
+    bool                    m_Committed     = false;
+    TessellationCache       m_TessCache;
+    std::vector<std::unique_ptr<PatchGeometry>> m_PatchGeometries;
+    std::vector<std::unique_ptr<HitFilter>>     m_HitFilters;
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //      三角形メッシュを複製せずにシーンに追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AttachSharedTriangles
+    (
+        RTCScene                    scene,
+        const asdx::Vector3* const* vertices,
+        uint32_t                    timeStepCount,
+        uint32_t                    vertexCount,
+        const uint32_t*             indices,
+        uint32_t                    triangleCount
+    )
+    {
+        auto geometry = rtcNewGeometry(m_Device, RTC_GEOMETRY_TYPE_TRIANGLE);
+        if (geometry == nullptr)
+        {
+            ELOG("Error : rtcNewGeometry() Failed.");
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        rtcSetGeometryBuildQuality(geometry, m_BuildQuality);
+
+        // 時間ステップごとの頂点は頂点バッファのスロットに割り当てる.
+        // Embree は読み込みにしか使わないので const を外して渡す.
+        rtcSetGeometryTimeStepCount(geometry, timeStepCount);
+        for(auto i=0u; i<timeStepCount; ++i)
+        {
+            rtcSetSharedGeometryBuffer(geometry, RTC_BUFFER_TYPE_VERTEX, i, RTC_FORMAT_FLOAT3,
+                const_cast<asdx::Vector3*>(vertices[i]), 0, sizeof(asdx::Vector3), vertexCount);
+        }
+        rtcSetSharedGeometryBuffer(geometry, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3,
+            const_cast<uint32_t*>(indices), 0, sizeof(uint32_t) * 3, triangleCount);
+        if (rtcGetDeviceError(m_Device) != RTC_ERROR_NONE)
+        {
+            ELOG("Error : rtcSetSharedGeometryBuffer() Failed.");
+            rtcReleaseGeometry(geometry);
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        m_TriangleCount += triangleCount;
+
+        rtcCommitGeometry(geometry);
+        auto geomID = rtcAttachGeometry(scene, geometry);
+        rtcReleaseGeometry(geometry);
+
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      ジオメトリ番号に対応するプロトタイプ番号を設定します.
+    //-------------------------------------------------------------------------
+    void SetInstancePrototype(uint32_t geomID, uint32_t prototype)
+    {
+        if (geomID >= m_InstancePrototypes.size())
+        {
+            m_InstancePrototypes.resize(geomID + 1, RTC_INVALID_GEOMETRY_ID);
+            m_TriangleMeshes    .resize(geomID + 1, false);
+        }
+
+        m_InstancePrototypes[geomID] = prototype;
+    }
+
+    //-------------------------------------------------------------------------
+    //      ジオメトリに交差と遮蔽のフィルタ関数を設定します.
+    //-------------------------------------------------------------------------
+    void SetFilterFunction(RTCGeometry geometry, BVH::FilterFunc func, const void* userPtr)
+    {
+        if (func == nullptr)
+        {
+            rtcSetGeometryIntersectFilterFunction(geometry, nullptr);
+            rtcSetGeometryOccludedFilterFunction (geometry, nullptr);
+        }
+        else
+        {
+            // ユーザーデータはジオメトリが参照し続けるので, Term() まで保持する.
+            std::unique_ptr<HitFilter> filter(new HitFilter());
+            filter->Func     = func;
+            filter->pUserPtr = userPtr;
+
+            rtcSetGeometryUserData(geometry, filter.get());
+            rtcSetGeometryIntersectFilterFunction(geometry, OnHitFilter);
+            rtcSetGeometryOccludedFilterFunction (geometry, OnHitFilter);
+            m_HitFilters.push_back(std::move(filter));
+        }
+
+        rtcCommitGeometry(geometry);
+    }
+
+    //-------------------------------------------------------------------------
+    //      パッチの境界を求めます.
+    //-------------------------------------------------------------------------
+    static void OnPatchBounds(const RTCBoundsFunctionArguments* args)
+    {
+        auto patches = static_cast<const PatchGeometry*>(args->geometryUserPtr);
+        auto box     = patches->pCache->GetSource(patches->Group)->GetPatchBounds(args->primID);
+
+        auto& result = *args->bounds_o;
+        result.lower_x = box.mini.x;
+        result.lower_y = box.mini.y;
+        result.lower_z = box.mini.z;
+        result.upper_x = box.maxi.x;
+        result.upper_y = box.maxi.y;
+        result.upper_z = box.maxi.z;
+    }
+
+    //-------------------------------------------------------------------------
+    //      パッチとの最近傍の交差を求めます(レイが境界に入った時に呼ばれます).
+    //-------------------------------------------------------------------------
+    static void OnPatchIntersect(const RTCIntersectFunctionNArguments* args)
+    {
+        auto patches = static_cast<const PatchGeometry*>(args->geometryUserPtr);
+        auto rays    = RTCRayHitN_RayN(args->rayhit, args->N);
+        auto hits    = RTCRayHitN_HitN(args->rayhit, args->N);
+
+        for(auto i=0u; i<args->N; ++i)
+        {
+            if (args->valid[i] != -1)
+            { continue; }
+
+            auto r = rtcGetRayFromRayN(rays, args->N, i);
+            asdx::Ray ray(
+                asdx::Vector3(r.org_x, r.org_y, r.org_z),
+                asdx::Vector3(r.dir_x, r.dir_y, r.dir_z),
+                r.tnear,
+                r.tfar);
+
+            BVHHit hit;
+            if (!patches->pCache->Intersect(patches->Group, args->primID, ray, hit))
+            { continue; }
+
+            RTCHit h;
+            h.Ng_x      = hit.Normal.x;
+            h.Ng_y      = hit.Normal.y;
+            h.Ng_z      = hit.Normal.z;
+            h.u         = hit.U;
+            h.v         = hit.V;
+            h.primID    = args->primID;
+            h.geomID    = args->geomID;
+            h.instID[0] = args->context->instID[0];
+
+            RTCRayN_tfar(rays, args->N, i) = ray.tmax;
+            rtcCopyHitToHitN(hits, &h, args->N, i);
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    //      パッチで遮蔽されているかどうかチェックします.
+    //-------------------------------------------------------------------------
+    static void OnPatchOccluded(const RTCOccludedFunctionNArguments* args)
+    {
+        auto patches = static_cast<const PatchGeometry*>(args->geometryUserPtr);
+
+        for(auto i=0u; i<args->N; ++i)
+        {
+            if (args->valid[i] != -1)
+            { continue; }
+
+            auto r = rtcGetRayFromRayN(args->ray, args->N, i);
+            asdx::Ray ray(
+                asdx::Vector3(r.org_x, r.org_y, r.org_z),
+                asdx::Vector3(r.dir_x, r.dir_y, r.dir_z),
+                r.tnear,
+                r.tfar);
+
+            if (patches->pCache->Occluded(patches->Group, args->primID, ray))
+            { RTCRayN_tfar(args->ray, args->N, i) = -INFINITY; }
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    //      交差の候補を受け入れるかどうか判定します(走査中に候補ごとに呼ばれます).
+    //-------------------------------------------------------------------------
+    static void OnHitFilter(const RTCFilterFunctionNArguments* args)
+    {
+        auto filter = static_cast<const HitFilter*>(args->geometryUserPtr);
+
+        for(auto i=0u; i<args->N; ++i)
+        {
+            if (args->valid[i] != -1)
+            { continue; }
+
+            // 棄却すると Embree はこの候補を無視して走査を続ける.
+            auto primID = RTCHitN_primID(args->hit, args->N, i);
+            auto u      = RTCHitN_u     (args->hit, args->N, i);
+            auto v      = RTCHitN_v     (args->hit, args->N, i);
+            if (!filter->Func(filter->pUserPtr, primID, u, v))
+            { args->valid[i] = 0; }
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    //      エラー発生時の処理です.
+    //-------------------------------------------------------------------------
+    static void OnError(void*, RTCError code, const char* message)
+    { ELOG("Error : Embree error. code = %d, message = %" ASDX_PRIs, int(code), (message != nullptr) ? message : ""); }
+
+    //-------------------------------------------------------------------------
+    //      メモリ確保・解放時の処理です(構築スレッドから並列に呼ばれます).
+    //-------------------------------------------------------------------------
+    static bool OnMemory(void* userPtr, ssize_t bytes, bool post)
+    {
+        // 確保は事前(post = false)に, 解放は事後(post = true)に負の値で通知される.
+        if (bytes > 0 && post)
+        { return true; }
+
+        auto self = static_cast<AccelEmbree*>(userPtr);
+        auto size = self->m_MemorySize.fetch_add(bytes) + bytes;
+
+        auto peak = self->m_PeakMemorySize.load();
+        while(size > peak && !self->m_PeakMemorySize.compare_exchange_weak(peak, size))
+        { /* DO_NOTHING */ }
+
+        return true;
+    }
+};
+#endif//SALTY2_USE_EMBREE
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AccelBVH class
+///////////////////////////////////////////////////////////////////////////////
+class AccelBVH : public Accel
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //      初期化処理を行います.
+    //-------------------------------------------------------------------------
+    bool Init(const AccelDesc& desc) override
+    {
+        // 構築品質は使用しない. デバイス設定はスレッド数のみ反映する.
+        // RTC_SCENE_FLAG_DYNAMIC の場合は共有したメッシュを個別のBVHにして更新できるようにする.
+        m_ThreadCount = ParseThreadCount(desc.DeviceConfig);
+        m_Dynamic     = (desc.SceneFlags & RTC_SCENE_FLAG_DYNAMIC) != 0;
+        m_Planner.Init(desc);
+        m_TessCache.Init(desc.TessellationCacheSize);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term() override
+    {
+        m_Instances.Clear();
+        m_Prototypes.clear();
+        m_BVH.Clear();
+        m_Meshes.clear();
+        m_MeshIDs.clear();
+        m_InstanceIndices.clear();
+        m_MeshInstances.clear();
+        m_Planner.Term();
+        m_PatchGeometries.clear();
+        m_CurveGeometries.clear();
+        m_TessCache.Term();
+        m_MeshSize       = 0;
+        m_Attached       = false;
+        m_AttachedGeometryCount = 0;
+        m_Committed      = false;
+        m_InstancesDirty = false;
+    }
+
+    //-------------------------------------------------------------------------
+    //      三角形メッシュを追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddTriangles
+    (
+        const asdx::Vector3*    vertices,
+        uint32_t                vertexCount,
+        const uint32_t*         indices,
+        uint32_t                triangleCount
+    ) override
+    {
+        // Embree と同様に呼び出し側のバッファは複製して保持する.
+        Mesh mesh;
+        mesh.Vertices.assign(vertices, vertices + vertexCount);
+        mesh.Indices .assign(indices,  indices  + size_t(triangleCount) * 3);
+        m_Meshes.push_back(std::move(mesh));
+
+        m_MeshSize += sizeof(asdx::Vector3) * vertexCount + sizeof(uint32_t) * 3 * size_t(triangleCount);
+
+        const auto& added = m_Meshes.back();
+        m_BVH.AddTriangles(added.Vertices.data(), added.Indices.data(), triangleCount);
+        return AddMeshID();
+    }
+
+    //-------------------------------------------------------------------------
+    //      三角形メッシュを複製せずに追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddSharedTriangles
+    (
+        const asdx::Vector3*    vertices,
+        uint32_t                vertexCount,
+        const uint32_t*         indices,
+        uint32_t                triangleCount
+    ) override
+    {
+        // 更新できるように, 単位行列のインスタンスとして個別のBVHを持たせる.
+        // 交差時はインスタンスではなくメッシュとして報告する.
+        if (m_Dynamic)
+        {
+            auto prototype = AddPrototype(vertices, vertexCount, indices, triangleCount);
+            auto geomID    = AddMeshInstance(prototype);
+            if (geomID != RTC_INVALID_GEOMETRY_ID)
+            { m_Planner.Add(geomID, vertices, vertexCount, triangleCount); }
+            return geomID;
+        }
+
+        // BVH は構築時にリーフへ三角形を詰めるので, 構築まで参照するだけ.
+        m_BVH.AddTriangles(vertices, indices, triangleCount);
+        return AddMeshID();
+    }
+
+    //-------------------------------------------------------------------------
+    //      時間ステップごとの頂点を持つ三角形メッシュを複製せずに追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddSharedMotionTriangles
+    (
+        const asdx::Vector3* const* vertices,
+        uint32_t                    timeStepCount,
+        uint32_t                    /*vertexCount*/,
+        const uint32_t*             indices,
+        uint32_t                    triangleCount
+    ) override
+    {
+        if (!IsValidTimeStepCount(timeStepCount))
+        { return RTC_INVALID_GEOMETRY_ID; }
+
+        // 静止したメッシュのBVHに補間を持ち込まないように, 単位行列のインスタンスとして個別のBVHを持たせる.
+        std::unique_ptr<BVH> bvh(new BVH());
+        bvh->AddMotionTriangles(vertices, timeStepCount, indices, triangleCount);
+        m_Prototypes.push_back(std::move(bvh));
+
+        return AddMeshInstance(m_Instances.AddPrototype(m_Prototypes.back().get()));
+    }
+
+    //-------------------------------------------------------------------------
+    //      インスタンスで参照するプロトタイプを複製せずに追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddPrototype
+    (
+        const asdx::Vector3*    vertices,
+        uint32_t                /*vertexCount*/,
+        const uint32_t*         indices,
+        uint32_t                triangleCount
+    ) override
+    {
+        std::unique_ptr<BVH> bvh(new BVH());
+        bvh->AddTriangles(vertices, indices, triangleCount);
+        m_Prototypes.push_back(std::move(bvh));
+
+        return m_Instances.AddPrototype(m_Prototypes.back().get());
+    }
+
+    //-------------------------------------------------------------------------
+    //      プロトタイプのインスタンスを追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddInstance(uint32_t prototype, const asdx::Matrix& transform) override
+    {
+        // メッシュと同じ番号空間で採番する(Embree の rtcAttachGeometry() と同じ).
+        auto geomID = uint32_t(m_InstanceIndices.size());
+        auto index  = m_Instances.AddInstance(prototype, transform, geomID);
+        if (index == BVH::INVALID_ID)
+        {
+            ELOG("Error : Invalid Prototype. prototype = %u", prototype);
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        m_InstanceIndices.push_back(index);
+        m_MeshInstances  .push_back(false);
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      時間ステップごとの変換行列を持つインスタンスを追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddMotionInstance(uint32_t prototype, const asdx::Matrix* transforms, uint32_t timeStepCount) override
+    {
+        if (!IsValidTimeStepCount(timeStepCount))
+        { return RTC_INVALID_GEOMETRY_ID; }
+
+        auto geomID = uint32_t(m_InstanceIndices.size());
+        auto index  = m_Instances.AddMotionInstance(prototype, transforms, timeStepCount, geomID);
+        if (index == BVH::INVALID_ID)
+        {
+            ELOG("Error : Invalid Prototype. prototype = %u", prototype);
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        m_InstanceIndices.push_back(index);
+        m_MeshInstances  .push_back(false);
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      交差判定の時点で三角形に分割するパッチ群を追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddPatches(const PatchSource* source) override
+    {
+        // パッチの境界のBVHは Commit() で構築する.
+        auto geomID = uint32_t(m_InstanceIndices.size());
+        m_InstanceIndices.push_back(BVH::INVALID_ID);
+        m_MeshInstances  .push_back(false);
+
+        std::unique_ptr<PatchGeometry> patches(new PatchGeometry());
+        patches->pCache = &m_TessCache;
+        patches->Group  = m_TessCache.Register(source);
+        patches->GeomID = geomID;
+        patches->Built  = false;
+        m_PatchGeometries.push_back(std::move(patches));
+
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      Bスプライン曲線を複製せずに追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddCurves(const Curves* curves) override
+    {
+        // セグメントの境界のBVHは Commit() で構築する.
+        auto geomID = uint32_t(m_InstanceIndices.size());
+        m_InstanceIndices.push_back(BVH::INVALID_ID);
+        m_MeshInstances  .push_back(false);
+
+        std::unique_ptr<CurveGeometry> geometry(new CurveGeometry());
+        geometry->pCurves = curves;
+        geometry->GeomID  = geomID;
+        geometry->Built   = false;
+        m_CurveGeometries.push_back(std::move(geometry));
+
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      三角形メッシュの交差を判定する関数を設定します.
+    //-------------------------------------------------------------------------
+    bool SetHitFilter(uint32_t geomID, BVH::FilterFunc func, const void* userPtr) override
+    {
+        if (geomID >= m_InstanceIndices.size())
+        { return false; }
+
+        // 単位行列のインスタンスとして持つメッシュは, プロトタイプのBVHに設定する.
+        if (m_MeshInstances[geomID])
+        { return SetPrototypeHitFilter(m_Instances.GetPrototype(m_InstanceIndices[geomID]), func, userPtr); }
+
+        if (m_InstanceIndices[geomID] != BVH::INVALID_ID)
+        { return false; }
+
+        // パッチと曲線は m_MeshIDs に含まれない.
+        auto itr = std::find(m_MeshIDs.begin(), m_MeshIDs.end(), geomID);
+        if (itr == m_MeshIDs.end())
+        { return false; }
+
+        m_BVH.SetFilter(uint32_t(itr - m_MeshIDs.begin()), func, userPtr);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      プロトタイプの交差を判定する関数を設定します.
+    //-------------------------------------------------------------------------
+    bool SetPrototypeHitFilter(uint32_t prototype, BVH::FilterFunc func, const void* userPtr) override
+    {
+        if (prototype >= m_Prototypes.size())
+        { return false; }
+
+        // プロトタイプのBVHは三角形メッシュ1つだけを持つ.
+        m_Prototypes[prototype]->SetFilter(0, func, userPtr);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      インスタンスが参照するプロトタイプ番号を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetInstancePrototype(uint32_t instID) const override
+    {
+        if (!IsInstance(instID))
+        { return RTC_INVALID_GEOMETRY_ID; }
+
+        return m_Instances.GetPrototype(m_InstanceIndices[instID]);
+    }
+
+    //-------------------------------------------------------------------------
+    //      インスタンスの変換行列を取得します.
+    //-------------------------------------------------------------------------
+    bool GetInstanceTransform(uint32_t instID, asdx::Matrix& transform, float time) const override
+    {
+        if (!IsInstance(instID))
+        { return false; }
+
+        return m_Instances.GetTransform(m_InstanceIndices[instID], transform, time);
+    }
+
+    //-------------------------------------------------------------------------
+    //      三角形メッシュの頂点を書き換えたことを通知します.
+    //-------------------------------------------------------------------------
+    bool UpdateTriangles(uint32_t geomID) override
+    {
+        // 1つのBVHにまとめたメッシュは更新できない.
+        if (!m_Planner.MarkDirty(geomID))
+        {
+            if (!m_Dynamic)
+            { ELOG("Error : RTC_SCENE_FLAG_DYNAMIC is required to update triangles. geomID = %u", geomID); }
+            return false;
+        }
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      インスタンスの変換行列を変更します.
+    //-------------------------------------------------------------------------
+    bool SetInstanceTransform(uint32_t instID, const asdx::Matrix& transform) override
+    {
+        if (!IsInstance(instID))
+        { return false; }
+
+        m_InstancesDirty = true;
+        return m_Instances.SetTransform(m_InstanceIndices[instID], transform);
+    }
+
+    //-------------------------------------------------------------------------
+    //      加速構造を構築します.
+    //-------------------------------------------------------------------------
+    bool Commit() override
+    {
+        // ジオメトリが増えていなければ, 変更のあったものだけを更新する.
+        if (m_Committed && m_CommittedGeometryCount == m_InstanceIndices.size())
+        { return Update(); }
+
+        m_Committed              = true;
+        m_CommittedGeometryCount = m_InstanceIndices.size();
+        m_InstancesDirty         = false;
+
+        if (!CommitInstances())
+        { return false; }
+
+        if (!CommitPatches())
+        { return false; }
+
+        if (!CommitCurves())
+        { return false; }
+
+        // 構築済みのデータを設定した場合は, メッシュが増えていなければ構築しない.
+        if (m_Attached && m_BVH.GetGeometryCount() == m_AttachedGeometryCount)
+        {
+            const auto& stats = m_BVH.GetStats();
+            ILOG("BVH : attached. nodes = %u, leaves = %u, memory = %.2lf MB",
+                stats.NodeCount, stats.LeafCount, double(stats.MemorySize) / (1024.0 * 1024.0));
+
+            m_BuildMsec = m_InstanceBuildMsec + m_CurveBuildMsec;
+            return true;
+        }
+
+        // インスタンスや曲線だけのシーンでは三角形のBVHを構築しない.
+        if (m_BVH.GetGeometryCount() == 0)
+        {
+            m_BuildMsec = m_InstanceBuildMsec + m_CurveBuildMsec;
+            m_Planner.Feedback(m_PrototypeTriangleCount, m_InstanceBuildMsec);
+            return true;
+        }
+
+        // 追加したメッシュを含めて構築し直すので, 構築済みのデータは使わない.
+        m_Attached = false;
+
+        // 複製したメッシュは, ジオメトリを追加した後の再構築でも参照するので Term() まで保持する.
+        if (!m_BVH.Build(m_ThreadCount))
+        {
+            ELOG("Error : BVH::Build() Failed.");
+            return false;
+        }
+
+        const auto& stats = m_BVH.GetStats();
+        m_PeakMemorySize = std::max(m_PeakMemorySize, m_MeshSize + stats.PeakMemorySize);
+
+        ILOG("BVH : triangles = %u, nodes = %u, leaves = %u, depth = %u, memory = %.2lf MB, build = %.2lf ms",
+            stats.TriangleCount, stats.NodeCount, stats.LeafCount, stats.MaxDepth,
+            double(stats.MemorySize) / (1024.0 * 1024.0), stats.BuildMsec);
+
+        // 初回は全三角形を構築するので, その時間を再構築の見積もりの初期値にする.
+        m_BuildMsec = stats.BuildMsec + m_InstanceBuildMsec + m_CurveBuildMsec;
+        m_Planner.Feedback(uint64_t(stats.TriangleCount) + m_PrototypeTriangleCount, stats.BuildMsec + m_InstanceBuildMsec);
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      構築済みの組み込みBVHを設定します.
+    //-------------------------------------------------------------------------
+    bool AttachBVH(const BVH::View& view) override
+    {
+        // 共有したメッシュは個別のBVHにしているので, まとめて構築したBVHは使えない.
+        if (m_Dynamic)
+        { return false; }
+
+        m_Attached = m_BVH.Attach(view);
+        m_AttachedGeometryCount = m_BVH.GetGeometryCount();
+        return m_Attached;
+    }
+
+    //-------------------------------------------------------------------------
+    //      構築済みの組み込みBVHを取得します.
+    //-------------------------------------------------------------------------
+    bool GetBVH(BVH::View& view) const override
+    {
+        view = m_BVH.GetView();
+        return view.NodeCount != 0;
+    }
+
+    //-------------------------------------------------------------------------
+    //      最近傍の交差を求めます.
+    //-------------------------------------------------------------------------
+    void Intersect1(RTCRayHit& rayHit) const override
+    {
+        auto& r = rayHit.ray;
+        asdx::Ray ray(
+            asdx::Vector3(r.org_x, r.org_y, r.org_z),
+            asdx::Vector3(r.dir_x, r.dir_y, r.dir_z),
+            r.tnear,
+            r.tfar);
+
+        // メッシュで縮めた tmax でインスタンスを判定する.
+        BVHHit hit;
+        auto found = m_BVH.Intersect(ray, hit);
+        if (found)
+        { hit.GeomID = m_MeshIDs[hit.GeomID]; }
+
+        found |= m_Instances.Intersect(ray, hit, r.time);
+
+        for(const auto& itr : m_PatchGeometries)
+        { found |= itr->Bvh.Intersect(ray, hit, IntersectPatch, itr.get()); }
+
+        for(const auto& itr : m_CurveGeometries)
+        { found |= itr->Bvh.Intersect(ray, hit, IntersectCurve, itr.get()); }
+
+        if (!found)
+        { return; }
+
+        // 更新できるメッシュや時間ステップを持つメッシュは単位行列のインスタンスなので, メッシュとして報告する.
+        if (hit.InstID != BVH::INVALID_ID && m_MeshInstances[hit.InstID])
+        {
+            hit.GeomID = hit.InstID;
+            hit.InstID = BVH::INVALID_ID;
+        }
+
+        r.tfar = ray.tmax;
+
+        auto& h = rayHit.hit;
+        h.Ng_x      = hit.Normal.x;
+        h.Ng_y      = hit.Normal.y;
+        h.Ng_z      = hit.Normal.z;
+        h.u         = hit.U;
+        h.v         = hit.V;
+        h.primID    = hit.PrimID;
+        h.geomID    = hit.GeomID;
+        h.instID[0] = (hit.InstID != BVH::INVALID_ID) ? hit.InstID : RTC_INVALID_GEOMETRY_ID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      遮蔽されているかどうかチェックします.
+    //-------------------------------------------------------------------------
+    void Occluded1(RTCRay& r) const override
+    {
+        asdx::Ray ray(
+            asdx::Vector3(r.org_x, r.org_y, r.org_z),
+            asdx::Vector3(r.dir_x, r.dir_y, r.dir_z),
+            r.tnear,
+            r.tfar);
+
+        if (m_BVH.Occluded(ray) || m_Instances.Occluded(ray, r.time))
+        {
+            r.tfar = -INFINITY;
+            return;
+        }
+
+        for(const auto& itr : m_PatchGeometries)
+        {
+            if (itr->Bvh.Occluded(ray, OccludedPatch, itr.get()))
+            {
+                r.tfar = -INFINITY;
+                return;
+            }
+        }
+
+        for(const auto& itr : m_CurveGeometries)
+        {
+            if (itr->Bvh.Occluded(ray, OccludedCurve, itr.get()))
+            {
+                r.tfar = -INFINITY;
+                return;
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    //      バックエンドを取得します.
+    //-------------------------------------------------------------------------
+    ACCEL_BACKEND GetBackend() const override
+    { return ACCEL_BACKEND_BVH; }
+
+    //-------------------------------------------------------------------------
+    //      統計情報を取得します.
+    //-------------------------------------------------------------------------
+    AccelStats GetStats() const override
+    {
+        const auto& stats = m_BVH.GetStats();
+
+        AccelStats result = {};
+        result.BuildMsec      = m_BuildMsec;
+        result.MemorySize     = stats.MemorySize + m_MeshSize + m_InstanceMemorySize + m_PatchMemorySize + m_CurveMemorySize;
+        result.PeakMemorySize = std::max(m_PeakMemorySize, result.MemorySize);
+        result.RefitCount     = m_RefitCount;
+        result.RebuildCount   = m_RebuildCount;
+        result.Tessellation   = m_TessCache.GetStats();
+        return result;
+    }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Mesh structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Mesh
+    {
+        std::vector<asdx::Vector3>  Vertices;
+        std::vector<uint32_t>       Indices;
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    BVH                                 m_BVH;
+    InstanceBVH                         m_Instances;
+    std::vector<std::unique_ptr<BVH>>   m_Prototypes;
+    std::vector<Mesh>                   m_Meshes;
+    std::vector<uint32_t>               m_MeshIDs;              // BVH 内の番号からジオメトリ番号への対応です.
+    std::vector<uint32_t>               m_InstanceIndices;      // ジオメトリ番号から InstanceBVH 内の番号への対応です.
+    std::vector<bool>                   m_MeshInstances;        // ジオメトリ番号ごとの, メッシュとして報告するインスタンスかどうかです.
+    RefitPlanner                        m_Planner;              // 更新できるメッシュ(RTC_SCENE_FLAG_DYNAMIC の場合)です.
+    TessellationCache                   m_TessCache;
+    std::vector<std::unique_ptr<PatchGeometry>> m_PatchGeometries;
+    size_t                              m_PatchMemorySize       = 0;
+    std::vector<std::unique_ptr<CurveGeometry>> m_CurveGeometries;
+    size_t                              m_CurveMemorySize       = 0;
+    double                              m_CurveBuildMsec        = 0.0;
+    size_t                              m_InstanceMemorySize    = 0;
+    double                              m_InstanceBuildMsec     = 0.0;
+    uint64_t                            m_PrototypeTriangleCount= 0;
+    float                               m_TopNodeCost           = 0.0f; // 上位のBVHを構築した時点の走査コストです.
+    double                              m_BuildMsec             = 0.0;
+    size_t                              m_MeshSize              = 0;
+    size_t                              m_PeakMemorySize        = 0;
+    size_t                              m_CommittedGeometryCount= 0;
+    uint32_t                            m_AttachedGeometryCount = 0;    // Attach() した時点のメッシュ数です.
+    uint32_t                            m_ThreadCount           = 0;
+    uint32_t                            m_RefitCount            = 0;
+    uint32_t                            m_RebuildCount          = 0;
+    bool                                m_Attached              = false;
+    bool                                m_Dynamic               = false;
+    bool                                m_Committed             = false;
+    bool                                m_InstancesDirty        = false;
+
+    static constexpr float TOP_REBUILD_RATIO = 1.5f;   // 上位のBVHの走査コストが構築時のこの倍を超えたら作り直す.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //      メッシュのジオメトリ番号を採番します.
+    //-------------------------------------------------------------------------
+    uint32_t AddMeshID()
+    {
+        auto geomID = uint32_t(m_InstanceIndices.size());
+        m_MeshIDs        .push_back(geomID);
+        m_InstanceIndices.push_back(BVH::INVALID_ID);
+        m_MeshInstances  .push_back(false);
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      メッシュとして報告する単位行列のインスタンスを追加します.
+    //-------------------------------------------------------------------------
+    uint32_t AddMeshInstance(uint32_t prototype)
+    {
+        auto geomID = AddInstance(prototype, asdx::Matrix::CreateIdentity());
+        if (geomID != RTC_INVALID_GEOMETRY_ID)
+        { m_MeshInstances[geomID] = true; }
+        return geomID;
+    }
+
+    //-------------------------------------------------------------------------
+    //      インスタンスかどうかチェックします.
+    //-------------------------------------------------------------------------
+    inline bool IsInstance(uint32_t geomID) const
+    {
+        return geomID < m_InstanceIndices.size()
+            && m_InstanceIndices[geomID] != BVH::INVALID_ID
+            && !m_MeshInstances[geomID];
+    }
+
+    //-------------------------------------------------------------------------
+    //      プロトタイプとインスタンスのBVHを構築します.
+    //-------------------------------------------------------------------------
+    bool CommitInstances()
+    {
+        m_InstanceMemorySize     = 0;
+        m_InstanceBuildMsec      = 0.0;
+        m_PrototypeTriangleCount = 0;
+        if (m_Instances.GetInstanceCount() == 0)
+        { return true; }
+
+        auto begin = std::chrono::steady_clock::now();
+
+        size_t protoSize = 0;
+        for(auto& itr : m_Prototypes)
+        {
+            if (!itr->Build(m_ThreadCount))
+            {
+                ELOG("Error : BVH::Build() Failed.");
+                return false;
+            }
+            protoSize                += itr->GetStats().MemorySize;
+            m_PrototypeTriangleCount += itr->GetStats().TriangleCount;
+        }
+
+        if (!m_Instances.Build(m_ThreadCount))
+        {
+            ELOG("Error : InstanceBVH::Build() Failed.");
+            return false;
+        }
+        m_TopNodeCost = m_Instances.GetStats().NodeCost;
+
+        const auto& stats = m_Instances.GetStats();
+        m_InstanceMemorySize = protoSize + stats.MemorySize;
+        m_InstanceBuildMsec  = GetElapsedMsec(begin);
+        m_PeakMemorySize     = std::max(m_PeakMemorySize, protoSize + stats.PeakMemorySize);
+
+        ILOG("BVH : prototypes = %u, instances = %u, prototype memory = %.2lf MB, instance memory = %.2lf MB (%.1lf bytes/instance), build = %.2lf ms",
+            uint32_t(m_Prototypes.size()), m_Instances.GetInstanceCount(),
+            double(protoSize) / (1024.0 * 1024.0), double(stats.MemorySize) / (1024.0 * 1024.0),
+            double(stats.MemorySize) / double(m_Instances.GetInstanceCount()), m_InstanceBuildMsec);
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      パッチの境界のBVHを構築します.
+    //-------------------------------------------------------------------------
+    bool CommitPatches()
+    {
+        std::vector<asdx::AABB> bounds;
+        m_PatchMemorySize = 0;
+        for(auto& itr : m_PatchGeometries)
+        {
+            if (!itr->Built)
+            {
+                auto source = m_TessCache.GetSource(itr->Group);
+                auto count  = source->GetPatchCount();
+                bounds.resize(count);
+                for(auto i=0u; i<count; ++i)
+                { bounds[i] = source->GetPatchBounds(i); }
+
+                if (!itr->Bvh.Build(bounds.data(), count, m_ThreadCount))
+                {
+                    ELOG("Error : BoxBVH::Build() Failed. geomID = %u", itr->GeomID);
+                    return false;
+                }
+                itr->Built = true;
+            }
+
+            m_PatchMemorySize += itr->Bvh.GetStats().MemorySize;
+        }
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      曲線のセグメントの境界のBVHを構築します.
+    //-------------------------------------------------------------------------
+    bool CommitCurves()
+    {
+        auto begin = std::chrono::steady_clock::now();
+
+        std::vector<asdx::AABB> bounds;
+        m_CurveMemorySize = 0;
+        for(auto& itr : m_CurveGeometries)
+        {
+            if (!itr->Built)
+            {
+                // 細長いセグメントを等分して境界の重なりを減らす. 区間の番号はセグメント番号 * CURVE_PART_COUNT + 区間.
+                auto count = itr->pCurves->GetSegmentCount() * CURVE_PART_COUNT;
+                bounds.resize(count);
+                for(auto i=0u; i<count; ++i)
+                { bounds[i] = itr->pCurves->GetSegmentBounds(i / CURVE_PART_COUNT, i % CURVE_PART_COUNT, CURVE_PART_COUNT); }
+
+                if (!itr->Bvh.Build(bounds.data(), count, m_ThreadCount))
+                {
+                    ELOG("Error : BoxBVH::Build() Failed. geomID = %u", itr->GeomID);
+                    return false;
+                }
+                itr->Built = true;
+            }
+
+            m_CurveMemorySize += itr->Bvh.GetStats().MemorySize;
+        }
+
+        m_CurveBuildMsec = GetElapsedMsec(begin);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      変更のあったメッシュとインスタンスを更新します.
+    //-------------------------------------------------------------------------
+    bool Update()
+    {
+        auto begin = std::chrono::steady_clock::now();
+
+        const auto changed = m_Planner.HasDirty() || m_InstancesDirty;
+
+        uint64_t rebuildTriangles = 0;
+        auto     rebuildMsec      = 0.0;
+        auto     result           = true;
+        m_RefitCount   = 0;
+        m_RebuildCount = 0;
+        m_Planner.Plan([&](uint32_t geomID, uint32_t triangleCount, bool rebuild)
+        {
+            auto& bvh = *m_Prototypes[m_Instances.GetPrototype(m_InstanceIndices[geomID])];
+            if (rebuild)
+            {
+                result &= bvh.Build(m_ThreadCount);
+                rebuildTriangles += triangleCount;
+                rebuildMsec      += bvh.GetStats().BuildMsec;
+                m_RebuildCount++;
+            }
+            else
+            {
+                result &= bvh.Refit(m_ThreadCount);
+                m_RefitCount++;
+            }
+        });
+        if (!result)
+        {
+            ELOG("Error : BVH Update Failed.");
+            return false;
+        }
+        m_Planner.Feedback(rebuildTriangles, rebuildMsec);
+
+        // 上位はインスタンスの境界だけ更新し, 重なりが増えて走査コストが悪化したら作り直す.
+        if (changed)
+        {
+            if (!m_Instances.Refit(m_ThreadCount))
+            {
+                ELOG("Error : InstanceBVH::Refit() Failed.");
+                return false;
+            }
+
+            if (m_Instances.GetStats().NodeCost > m_TopNodeCost * TOP_REBUILD_RATIO)
+            {
+                if (!m_Instances.Build(m_ThreadCount))
+                {
+                    ELOG("Error : InstanceBVH::Build() Failed.");
+                    return false;
+                }
+                m_TopNodeCost = m_Instances.GetStats().NodeCost;
+            }
+
+            m_InstancesDirty = false;
+        }
+
+        m_BuildMsec = GetElapsedMsec(begin);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      パッチとの最近傍の交差を求めます(レイが境界に入った時に呼ばれます).
+    //-------------------------------------------------------------------------
+    static bool IntersectPatch(void* userPtr, uint32_t primID, asdx::Ray& ray, BVHHit& hit)
+    {
+        auto patches = static_cast<const PatchGeometry*>(userPtr);
+        if (!patches->pCache->Intersect(patches->Group, primID, ray, hit))
+        { return false; }
+
+        hit.GeomID = patches->GeomID;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      パッチで遮蔽されているかどうかチェックします.
+    //-------------------------------------------------------------------------
+    static bool OccludedPatch(void* userPtr, uint32_t primID, const asdx::Ray& ray)
+    {
+        auto patches = static_cast<const PatchGeometry*>(userPtr);
+        return patches->pCache->Occluded(patches->Group, primID, ray);
+    }
+
+    //-------------------------------------------------------------------------
+    //      曲線のセグメントとの最近傍の交差を求めます.
+    //-------------------------------------------------------------------------
+    static bool IntersectCurve(void* userPtr, uint32_t primID, asdx::Ray& ray, BVHHit& hit)
+    {
+        auto geometry = static_cast<const CurveGeometry*>(userPtr);
+        if (!geometry->pCurves->Intersect(primID / CURVE_PART_COUNT, ray, hit, primID % CURVE_PART_COUNT, CURVE_PART_COUNT))
+        { return false; }
+
+        hit.GeomID = geometry->GeomID;
+        hit.InstID = BVH::INVALID_ID;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      曲線のセグメントで遮蔽されているかどうかチェックします.
+    //-------------------------------------------------------------------------
+    static bool OccludedCurve(void* userPtr, uint32_t primID, const asdx::Ray& ray)
+    {
+        auto geometry = static_cast<const CurveGeometry*>(userPtr);
+        return geometry->pCurves->Occluded(primID / CURVE_PART_COUNT, ray, primID % CURVE_PART_COUNT, CURVE_PART_COUNT);
+    }
+
+    //-------------------------------------------------------------------------
+    //      デバイス設定文字列からスレッド数を取り出します.
+    //-------------------------------------------------------------------------
+    static uint32_t ParseThreadCount(const char* config)
+    {
+        if (config == nullptr)
+        { return 0; }
+
+        auto pos = strstr(config, "threads=");
+        if (pos == nullptr)
+        { return 0; }
+
+        return uint32_t(strtoul(pos + strlen("threads="), nullptr, 10));
+    }
+};
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      加速構造を生成します.
+//-----------------------------------------------------------------------------
+std::unique_ptr<Accel> CreateAccel(ACCEL_BACKEND backend)
+{
+#if SALTY2_USE_EMBREE
+    if (backend == ACCEL_BACKEND_EMBREE)
+    { return std::make_unique<AccelEmbree>(); }
+#else
+    if (backend == ACCEL_BACKEND_EMBREE)
+    { WLOG("Warning : Embree is disabled in this build. Falling back to built-in BVH."); }
+#endif
+
+    return std::make_unique<AccelBVH>();
+}
+
+//-----------------------------------------------------------------------------
+//      構築品質の名前を取得します.
+//-----------------------------------------------------------------------------
+const char* GetBuildQualityName(RTCBuildQuality quality)
+{
+    switch(quality)
+    {
+    case RTC_BUILD_QUALITY_LOW:     return "low";
+    case RTC_BUILD_QUALITY_MEDIUM:  return "medium";
+    case RTC_BUILD_QUALITY_HIGH:    return "high";
+    case RTC_BUILD_QUALITY_REFIT:   return "refit";
+    default:                        return "unknown";
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      バックエンド名を取得します.
+//-----------------------------------------------------------------------------
+const char* GetAccelBackendName(ACCEL_BACKEND backend)
+{
+    switch(backend)
+    {
+    case ACCEL_BACKEND_EMBREE:  return "embree";
+    case ACCEL_BACKEND_BVH:     return "bvh";
+    default:                    return "unknown";
+    }
+}
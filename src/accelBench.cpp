@@ -0,0 +1,874 @@
+﻿//-----------------------------------------------------------------------------
+// File : accelBench.cpp
+// Desc : Acceleration Structure Benchmark.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <accelBench.h>
+#include <alphaMask.h>
+#include <attribute.h>
+#include <asdxLogger.h>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Constant Values
+//-----------------------------------------------------------------------------
+static constexpr uint32_t STRAND_POINT_COUNT    = 8;    // 毛あたりの制御点数です.
+static constexpr uint32_t TUBE_SIDES            = 6;    // 管の断面の頂点数です.
+static constexpr uint32_t TUBE_RINGS            = 4;    // セグメントあたりの管の断面数です.
+static constexpr uint32_t MASK_SIZE             = 64;   // 葉の抜き型の画素数(辺)です.
+static constexpr uint32_t BRANCH_LEAF_COUNT     = 256;  // インスタンス化する枝あたりの葉の数です.
+static constexpr uint32_t MAX_RESTART_COUNT     = 256;  // 透明な層ごとに辿り直す回数の上限です.
+static constexpr float    RESTART_EPSILON       = 1e-5f;    // 辿り直す際に交差位置から進める距離(相対値)です.
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Setting structure
+///////////////////////////////////////////////////////////////////////////////
+struct Setting
+{
+    ACCEL_BACKEND   Backend;
+    RTCBuildQuality BuildQuality;
+    RTCSceneFlags   SceneFlags;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Scene structure
+///////////////////////////////////////////////////////////////////////////////
+struct Scene
+{
+    std::vector<asdx::Vector3>  Vertices;
+    std::vector<uint32_t>       Indices;
+    std::vector<RTCRay>         PrimaryRays;    // カメラからのコヒーレントなレイ.
+    std::vector<RTCRay>         RandomRays;     // 二次レイを模したインコヒーレントなレイ.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Fur structure
+///////////////////////////////////////////////////////////////////////////////
+struct Fur
+{
+    std::vector<asdx::Vector4>  Points;         // 制御点です(x, y, z, 半径).
+    std::vector<uint32_t>       PointCounts;
+    std::vector<asdx::Vector3>  TubeVertices;   // 曲線を三角形の管に分割したもの(末尾に余白を持つ).
+    std::vector<uint32_t>       TubeIndices;
+    uint32_t                    TubeVertexCount;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Foliage structure
+///////////////////////////////////////////////////////////////////////////////
+struct Foliage
+{
+    Mesh                        Crown;          // 茂み全体の葉です(テクスチャ座標付き).
+    Mesh                        Branch;         // インスタンス化する枝の葉です.
+    std::vector<asdx::Matrix>   Transforms;     // 枝のインスタンスの変換行列です.
+    AlphaMask                   Mask;           // 葉の抜き型です.
+    std::vector<RTCRay>         PrimaryRays;    // 茂みを正面から見るレイ.
+    std::vector<RTCRay>         RandomRays;     // 茂みの中から任意方向に飛ばすレイ(影のレイを模したもの).
+};
+
+//-----------------------------------------------------------------------------
+//      レイを設定します.
+//-----------------------------------------------------------------------------
+RTCRay MakeRay(const asdx::Vector3& pos, const asdx::Vector3& dir, float tfar)
+{
+    RTCRay ray = {};
+    ray.org_x = pos.x;
+    ray.org_y = pos.y;
+    ray.org_z = pos.z;
+    ray.tnear = 0.0f;
+    ray.dir_x = dir.x;
+    ray.dir_y = dir.y;
+    ray.dir_z = dir.z;
+    ray.time  = 0.0f;
+    ray.tfar  = tfar;
+    ray.mask  = 0xFFFFFFFF;
+    return ray;
+}
+
+//-----------------------------------------------------------------------------
+//      計測用のシーンを生成します.
+//-----------------------------------------------------------------------------
+void CreateScene(const AccelBenchDesc& desc, Scene& scene)
+{
+    // 凹凸を付けた球(経度方向は緯度方向の2倍に分割).
+    auto stacks = std::max(2u, uint32_t(sqrtf(float(desc.TriangleCount) / 4.0f)));
+    auto slices = stacks * 2;
+
+    scene.Vertices.reserve(size_t(stacks + 1) * (slices + 1));
+    for(auto i=0u; i<=stacks; ++i)
+    {
+        auto theta = asdx::F_PI * float(i) / float(stacks);
+        for(auto j=0u; j<=slices; ++j)
+        {
+            auto phi    = asdx::F_2PI * float(j) / float(slices);
+            auto radius = 1.0f + 0.05f * sinf(theta * 23.0f) * cosf(phi * 17.0f);
+            scene.Vertices.push_back(asdx::Vector3(
+                radius * sinf(theta) * cosf(phi),
+                radius * cosf(theta),
+                radius * sinf(theta) * sinf(phi)));
+        }
+    }
+
+    scene.Indices.reserve(size_t(stacks) * slices * 6);
+    for(auto i=0u; i<stacks; ++i)
+    {
+        for(auto j=0u; j<slices; ++j)
+        {
+            auto i0 = i * (slices + 1) + j;
+            auto i1 = i0 + 1;
+            auto i2 = i0 + (slices + 1);
+            auto i3 = i2 + 1;
+
+            scene.Indices.push_back(i0); scene.Indices.push_back(i2); scene.Indices.push_back(i1);
+            scene.Indices.push_back(i1); scene.Indices.push_back(i2); scene.Indices.push_back(i3);
+        }
+    }
+
+    // 球を正面から覆うピンホールカメラ.
+    auto size = std::max(1u, uint32_t(sqrtf(float(desc.RayCount))));
+    scene.PrimaryRays.reserve(size_t(size) * size);
+    for(auto y=0u; y<size; ++y)
+    {
+        for(auto x=0u; x<size; ++x)
+        {
+            auto px = (float(x) + 0.5f) / float(size) * 2.0f - 1.0f;
+            auto py = (float(y) + 0.5f) / float(size) * 2.0f - 1.0f;
+            auto dir = asdx::Vector3::Normalize(asdx::Vector3(px * 0.5f, py * 0.5f, 1.0f));
+            scene.PrimaryRays.push_back(MakeRay(asdx::Vector3(0.0f, 0.0f, -3.0f), dir, FLT_MAX));
+        }
+    }
+
+    // 球の内外から任意方向に飛ばす短めのレイ.
+    asdx::XorShift rng(12345);
+    scene.RandomRays.reserve(desc.RayCount);
+    for(auto i=0u; i<desc.RayCount; ++i)
+    {
+        auto pos = asdx::Vector3(rng.GetAsF32(-1.5f, 1.5f), rng.GetAsF32(-1.5f, 1.5f), rng.GetAsF32(-1.5f, 1.5f));
+        auto dir = asdx::Vector3(rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f));
+        if (asdx::Vector3::Dot(dir, dir) < 1e-4f)
+        { dir = asdx::Vector3(0.0f, 1.0f, 0.0f); }
+
+        scene.RandomRays.push_back(MakeRay(pos, asdx::Vector3::Normalize(dir), 2.0f));
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      計測用の毛皮を生成します.
+//-----------------------------------------------------------------------------
+void CreateFur(const AccelBenchDesc& desc, Fur& fur)
+{
+    // 単位球に一様に生やし, 法線方向に伸ばしながら横に曲げる.
+    asdx::XorShift rng(54321);
+    fur.Points     .reserve(size_t(desc.StrandCount) * STRAND_POINT_COUNT);
+    fur.PointCounts.reserve(desc.StrandCount);
+    for(auto i=0u; i<desc.StrandCount; ++i)
+    {
+        auto z   = rng.GetAsF32(-1.0f, 1.0f);
+        auto phi = rng.GetAsF32(0.0f, asdx::F_2PI);
+        auto s   = sqrtf(std::max(0.0f, 1.0f - z * z));
+        auto n   = asdx::Vector3(s * cosf(phi), z, s * sinf(phi));
+
+        auto side = asdx::Vector3::Cross(n, asdx::Vector3(rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f)));
+        if (side.LengthSq() < 1e-4f)
+        { side = asdx::Vector3::Cross(n, asdx::Vector3(0.0f, 0.0f, 1.0f)); }
+        side = asdx::Vector3::Normalize(side);
+
+        for(auto j=0u; j<STRAND_POINT_COUNT; ++j)
+        {
+            auto t   = float(j) / float(STRAND_POINT_COUNT - 1);
+            auto pos = n * (1.0f + 0.25f * t) + side * (0.08f * t * t);
+            fur.Points.push_back(asdx::Vector4(pos.x, pos.y, pos.z, 0.004f + (0.0005f - 0.004f) * t));
+        }
+        fur.PointCounts.push_back(STRAND_POINT_COUNT);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      曲線を三角形の管に分割します.
+//-----------------------------------------------------------------------------
+void TessellateTubes(const Curves& curves, Fur& fur)
+{
+    uint32_t segment = 0;
+    for(auto count : fur.PointCounts)
+    {
+        auto segmentCount = count - 3;
+        auto ringCount    = segmentCount * TUBE_RINGS + 1;
+        auto base         = uint32_t(fur.TubeVertices.size());
+
+        for(auto i=0u; i<ringCount; ++i)
+        {
+            auto local = std::min(i / TUBE_RINGS, segmentCount - 1);
+            auto u     = float(i - local * TUBE_RINGS) / float(TUBE_RINGS);
+            auto point = curves.Evaluate(segment + local, u);
+
+            CurveHit hit;
+            curves.GetHit(segment + local, u, hit);
+            auto up = (fabsf(hit.Tangent.y) < 0.9f) ? asdx::Vector3(0.0f, 1.0f, 0.0f) : asdx::Vector3(1.0f, 0.0f, 0.0f);
+            auto bx = asdx::Vector3::Normalize(asdx::Vector3::Cross(hit.Tangent, up));
+            auto by = asdx::Vector3::Cross(hit.Tangent, bx);
+
+            for(auto j=0u; j<TUBE_SIDES; ++j)
+            {
+                auto angle  = asdx::F_2PI * float(j) / float(TUBE_SIDES);
+                auto offset = (bx * cosf(angle) + by * sinf(angle)) * point.w;
+                fur.TubeVertices.push_back(asdx::Vector3(point.x + offset.x, point.y + offset.y, point.z + offset.z));
+            }
+        }
+
+        for(auto i=0u; i<ringCount - 1; ++i)
+        {
+            for(auto j=0u; j<TUBE_SIDES; ++j)
+            {
+                auto i0 = base + i * TUBE_SIDES + j;
+                auto i1 = base + i * TUBE_SIDES + (j + 1) % TUBE_SIDES;
+                auto i2 = i0 + TUBE_SIDES;
+                auto i3 = i1 + TUBE_SIDES;
+
+                fur.TubeIndices.push_back(i0); fur.TubeIndices.push_back(i2); fur.TubeIndices.push_back(i1);
+                fur.TubeIndices.push_back(i1); fur.TubeIndices.push_back(i2); fur.TubeIndices.push_back(i3);
+            }
+        }
+
+        segment += segmentCount;
+    }
+
+    // 共有する頂点バッファは末尾に16バイト以上の余白が必要.
+    fur.TubeVertexCount = uint32_t(fur.TubeVertices.size());
+    fur.TubeVertices.resize(fur.TubeVertices.size() + 2, asdx::Vector3(0.0f, 0.0f, 0.0f));
+}
+
+//-----------------------------------------------------------------------------
+//      球の中の一様な点を求めます.
+//-----------------------------------------------------------------------------
+asdx::Vector3 SampleBall(asdx::XorShift& rng, float radius)
+{
+    for(;;)
+    {
+        auto p = asdx::Vector3(rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f), rng.GetAsF32(-1.0f, 1.0f));
+        if (asdx::Vector3::Dot(p, p) <= 1.0f)
+        { return p * radius; }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      向きをばらつかせた四角形の葉を生成します.
+//-----------------------------------------------------------------------------
+bool CreateLeaves(asdx::XorShift& rng, uint32_t count, float radius, float size, Mesh& mesh)
+{
+    if (!mesh.Positions.Resize(size_t(count) * 4) || !mesh.Indices.Resize(size_t(count) * 6))
+    { return false; }
+
+    std::vector<asdx::Vector2> texcoords(size_t(count) * 4);
+    const auto half = size * 0.5f;
+
+    for(auto i=0u; i<count; ++i)
+    {
+        auto center = SampleBall(rng, radius);
+        auto normal = SampleBall(rng, 1.0f);
+        if (asdx::Vector3::Dot(normal, normal) < 1e-4f)
+        { normal = asdx::Vector3(0.0f, 1.0f, 0.0f); }
+
+        asdx::Vector3 t, b;
+        asdx::CalcONB(asdx::Vector3::Normalize(normal), t, b);
+
+        auto v = i * 4;
+        mesh.Positions[v + 0] = center - t * half - b * half;
+        mesh.Positions[v + 1] = center + t * half - b * half;
+        mesh.Positions[v + 2] = center - t * half + b * half;
+        mesh.Positions[v + 3] = center + t * half + b * half;
+        texcoords[v + 0] = asdx::Vector2(0.0f, 0.0f);
+        texcoords[v + 1] = asdx::Vector2(1.0f, 0.0f);
+        texcoords[v + 2] = asdx::Vector2(0.0f, 1.0f);
+        texcoords[v + 3] = asdx::Vector2(1.0f, 1.0f);
+
+        auto idx = mesh.Indices.GetData() + size_t(i) * 6;
+        idx[0] = v + 0; idx[1] = v + 1; idx[2] = v + 2;
+        idx[3] = v + 2; idx[4] = v + 1; idx[5] = v + 3;
+    }
+
+    return EncodeAttributes(mesh, nullptr, texcoords.data(), mesh.Attributes);
+}
+
+//-----------------------------------------------------------------------------
+//      計測用の葉の茂みを生成します.
+//-----------------------------------------------------------------------------
+bool CreateFoliage(const AccelBenchDesc& desc, Foliage& foliage)
+{
+    // 対角線に沿った細長い葉の形(不透明な画素は約1/3).
+    std::vector<uint8_t> alpha(MASK_SIZE * MASK_SIZE);
+    for(auto y=0u; y<MASK_SIZE; ++y)
+    {
+        for(auto x=0u; x<MASK_SIZE; ++x)
+        {
+            auto px = (float(x) + 0.5f) / float(MASK_SIZE) - 0.5f;
+            auto py = (float(y) + 0.5f) / float(MASK_SIZE) - 0.5f;
+            auto a  = (px + py) * 0.7071f / 0.48f;
+            auto b  = (px - py) * 0.7071f / 0.22f;
+            alpha[y * MASK_SIZE + x] = (a * a + b * b < 1.0f) ? 255 : 0;
+        }
+    }
+
+    if (!foliage.Mask.Init(MASK_SIZE, MASK_SIZE, alpha.data()))
+    { return false; }
+
+    // 葉の数によらず茂みを通り抜けるレイが交差する層の数が同じになるように, 葉の大きさを決める.
+    const auto size = 0.05f * sqrtf(65536.0f / float(desc.LeafCount));
+
+    asdx::XorShift rng(24680);
+    if (!CreateLeaves(rng, desc.LeafCount, 1.0f, size, foliage.Crown))
+    { return false; }
+
+    // 同じ数の葉を, 小さな枝のインスタンスで茂みに散らす.
+    auto branchCount = std::max(1u, desc.LeafCount / BRANCH_LEAF_COUNT);
+    auto leafCount   = std::min(desc.LeafCount, BRANCH_LEAF_COUNT);
+    if (!CreateLeaves(rng, leafCount, 0.2f, size, foliage.Branch))
+    { return false; }
+
+    foliage.Transforms.reserve(branchCount);
+    for(auto i=0u; i<branchCount; ++i)
+    {
+        auto axis  = SampleBall(rng, 1.0f);
+        if (asdx::Vector3::Dot(axis, axis) < 1e-4f)
+        { axis = asdx::Vector3(0.0f, 1.0f, 0.0f); }
+
+        auto angle = rng.GetAsF32(0.0f, asdx::F_2PI);
+        foliage.Transforms.push_back(
+            asdx::Matrix::CreateFromAxisAngle(asdx::Vector3::Normalize(axis), angle)
+          * asdx::Matrix::CreateTranslation(SampleBall(rng, 0.8f)));
+    }
+
+    // 茂みを正面から覆うピンホールカメラ.
+    auto frame = std::max(1u, uint32_t(sqrtf(float(desc.RayCount))));
+    foliage.PrimaryRays.reserve(size_t(frame) * frame);
+    for(auto y=0u; y<frame; ++y)
+    {
+        for(auto x=0u; x<frame; ++x)
+        {
+            auto px = (float(x) + 0.5f) / float(frame) * 2.0f - 1.0f;
+            auto py = (float(y) + 0.5f) / float(frame) * 2.0f - 1.0f;
+            auto dir = asdx::Vector3::Normalize(asdx::Vector3(px * 0.35f, py * 0.35f, 1.0f));
+            foliage.PrimaryRays.push_back(MakeRay(asdx::Vector3(0.0f, 0.0f, -3.0f), dir, FLT_MAX));
+        }
+    }
+
+    foliage.RandomRays.reserve(desc.RayCount);
+    for(auto i=0u; i<desc.RayCount; ++i)
+    {
+        auto dir = SampleBall(rng, 1.0f);
+        if (asdx::Vector3::Dot(dir, dir) < 1e-4f)
+        { dir = asdx::Vector3(0.0f, 1.0f, 0.0f); }
+
+        foliage.RandomRays.push_back(MakeRay(SampleBall(rng, 1.0f), asdx::Vector3::Normalize(dir), 2.0f));
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      最近傍の不透明な交差を求めます.
+//      restart が nullptr でなければ, フィルタ関数を使わずに透明な層ごとに辿り直します.
+//-----------------------------------------------------------------------------
+bool TraceAlpha(const Accel* accel, RTCRayHit& record, const AlphaTestSource* restart, uint64_t& traceCount)
+{
+    const auto tfar = record.ray.tfar;
+
+    for(auto i=0u; i<MAX_RESTART_COUNT; ++i)
+    {
+        record.hit.geomID    = RTC_INVALID_GEOMETRY_ID;
+        record.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
+        accel->Intersect1(record);
+        traceCount++;
+
+        if (record.hit.geomID == RTC_INVALID_GEOMETRY_ID)
+        { return false; }
+
+        if (restart == nullptr || AlphaTest(restart, record.hit.primID, record.hit.u, record.hit.v))
+        { return true; }
+
+        // 交差距離は丸めてあるので, 直後からでは同じ三角形に再び当たる. 少し先から辿り直す.
+        record.ray.tnear = record.ray.tfar * (1.0f + RESTART_EPSILON) + RESTART_EPSILON;
+        record.ray.tfar  = tfar;
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//      抜き型のある葉との最近傍交差の性能を計測します(Mrays/s).
+//-----------------------------------------------------------------------------
+double MeasureAlphaIntersect(const Accel* accel, const std::vector<RTCRay>& rays, const AlphaTestSource* restart, uint64_t& traceCount)
+{
+    auto trace = [&](uint64_t& count)
+    {
+        for(const auto& ray : rays)
+        {
+            RTCRayHit record = {};
+            record.ray = ray;
+            TraceAlpha(accel, record, restart, count);
+        }
+    };
+
+    // 初回の走査はページフォルトやキャッシュミスの分だけ遅いので, 1回空回ししてから計測する.
+    uint64_t warmupCount = 0;
+    trace(warmupCount);
+
+    auto begin = std::chrono::steady_clock::now();
+    trace(traceCount);
+    auto sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return double(rays.size()) / sec * 1e-6;
+}
+
+//-----------------------------------------------------------------------------
+//      抜き型のある葉での遮蔽判定の性能を計測します(Mrays/s).
+//      Occluded1() は交差位置を返さないので, 辿り直す場合は最近傍交差で代用します.
+//-----------------------------------------------------------------------------
+double MeasureAlphaOccluded(const Accel* accel, const std::vector<RTCRay>& rays, const AlphaTestSource* restart, uint64_t& traceCount)
+{
+    auto trace = [&](uint64_t& count)
+    {
+        for(const auto& ray : rays)
+        {
+            if (restart != nullptr)
+            {
+                RTCRayHit record = {};
+                record.ray = ray;
+                TraceAlpha(accel, record, restart, count);
+            }
+            else
+            {
+                auto shadow = ray;
+                accel->Occluded1(shadow);
+                count++;
+            }
+        }
+    };
+
+    uint64_t warmupCount = 0;
+    trace(warmupCount);
+
+    auto begin = std::chrono::steady_clock::now();
+    trace(traceCount);
+    auto sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return double(rays.size()) / sec * 1e-6;
+}
+
+//-----------------------------------------------------------------------------
+//      最近傍交差の性能を計測します(Mrays/s).
+//-----------------------------------------------------------------------------
+double MeasureIntersect(const Accel* accel, const std::vector<RTCRay>& rays)
+{
+    auto trace = [&]()
+    {
+        for(const auto& ray : rays)
+        {
+            RTCRayHit record = {};
+            record.ray           = ray;
+            record.hit.geomID    = RTC_INVALID_GEOMETRY_ID;
+            record.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
+            accel->Intersect1(record);
+        }
+    };
+
+    // 初回の走査はページフォルトやキャッシュミスの分だけ遅いので, 1回空回ししてから計測する.
+    trace();
+
+    auto begin = std::chrono::steady_clock::now();
+    trace();
+    auto sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return double(rays.size()) / sec * 1e-6;
+}
+
+//-----------------------------------------------------------------------------
+//      遮蔽判定の性能を計測します(Mrays/s).
+//-----------------------------------------------------------------------------
+double MeasureOccluded(const Accel* accel, const std::vector<RTCRay>& rays)
+{
+    auto trace = [&]()
+    {
+        for(const auto& ray : rays)
+        {
+            auto shadow = ray;
+            accel->Occluded1(shadow);
+        }
+    };
+
+    trace();
+
+    auto begin = std::chrono::steady_clock::now();
+    trace();
+    auto sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return double(rays.size()) / sec * 1e-6;
+}
+
+//-----------------------------------------------------------------------------
+//      シーンフラグの名前を取得します.
+//-----------------------------------------------------------------------------
+const char* GetSceneFlagsName(RTCSceneFlags flags)
+{
+    const auto compact = (uint32_t(flags) & uint32_t(RTC_SCENE_FLAG_COMPACT)) != 0;
+    const auto robust  = (uint32_t(flags) & uint32_t(RTC_SCENE_FLAG_ROBUST )) != 0;
+
+    if (compact && robust)
+    { return "compact|robust"; }
+    else if (compact)
+    { return "compact"; }
+    else if (robust)
+    { return "robust"; }
+
+    return "none";
+}
+
+//-----------------------------------------------------------------------------
+//      曲線と三角形の管を比較します.
+//-----------------------------------------------------------------------------
+bool RunCurveBench(const AccelBenchDesc& desc, const Scene& scene)
+{
+    Fur fur;
+    CreateFur(desc, fur);
+
+    Curves curves[2];
+    if (!curves[0].Init(CURVE_TYPE_FLAT,  fur.Points.data(), fur.PointCounts.data(), desc.StrandCount)
+     || !curves[1].Init(CURVE_TYPE_ROUND, fur.Points.data(), fur.PointCounts.data(), desc.StrandCount))
+    {
+        ELOG("Error : Curves::Init() Failed.");
+        return false;
+    }
+
+    TessellateTubes(curves[0], fur);
+
+    const char* names[] = { "flat", "round", "tube" };
+    const auto tubeSize = fur.TubeVertices.size() * sizeof(asdx::Vector3) + fur.TubeIndices.size() * sizeof(uint32_t);
+
+    std::vector<ACCEL_BACKEND> backends;
+#if SALTY2_USE_EMBREE
+    backends.push_back(ACCEL_BACKEND_EMBREE);
+#endif
+    backends.push_back(ACCEL_BACKEND_BVH);
+
+    ILOG( "--------------------------------------------------------------------" );
+    ILOG( " Curve Benchmark : " );
+    ILOG( "     strands    = %u (%u points, %u segments)", desc.StrandCount, curves[0].GetPointCount(), curves[0].GetSegmentCount() );
+    ILOG( "     tubes      = %zu triangles (%u sides, %u rings/segment)", fur.TubeIndices.size() / 3, TUBE_SIDES, TUBE_RINGS );
+    ILOG( "--------------------------------------------------------------------" );
+    ILOG( "%-8" ASDX_PRIs " %-8" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs,
+        "backend", "geometry", "build(ms)", "data(MB)", "accel(MB)", "B/strand", "primary", "random", "occluded" );
+
+    auto result = true;
+    for(auto backend : backends)
+    {
+        for(auto i=0u; i<3; ++i)
+        {
+            AccelDesc accelDesc;
+            accelDesc.Backend      = backend;
+            accelDesc.DeviceConfig = desc.DeviceConfig;
+
+            auto accel = CreateAccel(backend);
+            if (!accel->Init(accelDesc))
+            {
+                ELOG("Error : Accel::Init() Failed.");
+                result = false;
+                continue;
+            }
+
+            // どちらも呼び出し側のバッファを共有するので, 元データと加速構造を分けて数える.
+            size_t dataSize = 0;
+            if (i < 2)
+            {
+                accel->AddCurves(&curves[i]);
+                dataSize = curves[i].GetMemorySize();
+            }
+            else
+            {
+                accel->AddSharedTriangles(
+                    fur.TubeVertices.data(), fur.TubeVertexCount,
+                    fur.TubeIndices .data(), uint32_t(fur.TubeIndices.size() / 3));
+                dataSize = tubeSize;
+            }
+
+            if (!accel->Commit())
+            {
+                ELOG("Error : Accel::Commit() Failed.");
+                accel->Term();
+                result = false;
+                continue;
+            }
+
+            auto primary  = MeasureIntersect(accel.get(), scene.PrimaryRays);
+            auto random   = MeasureIntersect(accel.get(), scene.RandomRays);
+            auto occluded = MeasureOccluded (accel.get(), scene.RandomRays);
+            auto stats    = accel->GetStats();
+
+            const auto MB = 1.0 / (1024.0 * 1024.0);
+            ILOG( "%-8" ASDX_PRIs " %-8" ASDX_PRIs " %10.2lf %10.2lf %10.2lf %10.1lf %10.3lf %10.3lf %10.3lf",
+                GetAccelBackendName(accel->GetBackend()),
+                names[i],
+                stats.BuildMsec,
+                double(dataSize) * MB,
+                double(stats.MemorySize) * MB,
+                double(dataSize + stats.MemorySize) / double(desc.StrandCount),
+                primary, random, occluded );
+
+            accel->Term();
+        }
+    }
+
+    ILOG( "--------------------------------------------------------------------" );
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      走査中のアルファテストと辿り直しを比較します.
+//-----------------------------------------------------------------------------
+bool RunAlphaBench(const AccelBenchDesc& desc)
+{
+    Foliage foliage;
+    if (!CreateFoliage(desc, foliage))
+    {
+        ELOG("Error : CreateFoliage() Failed.");
+        return false;
+    }
+
+    const char* sceneNames [] = { "mesh", "instance" };
+    const char* methodNames[] = { "restart", "filter" };
+
+    // 辿り直す場合は呼び出し側で, フィルタ関数の場合は走査中に同じ判定をする.
+    AlphaTestSource sources[2];
+    sources[0].pMesh = &foliage.Crown;
+    sources[0].pMask = &foliage.Mask;
+    sources[1].pMesh = &foliage.Branch;
+    sources[1].pMask = &foliage.Mask;
+
+    std::vector<ACCEL_BACKEND> backends;
+#if SALTY2_USE_EMBREE
+    backends.push_back(ACCEL_BACKEND_EMBREE);
+#endif
+    backends.push_back(ACCEL_BACKEND_BVH);
+
+    ILOG( "--------------------------------------------------------------------" );
+    ILOG( " Alpha Test Benchmark : " );
+    ILOG( "     leaves     = %u (mesh), %zu x %u (instance)", foliage.Crown.GetTriangleCount() / 2, foliage.Transforms.size(), foliage.Branch.GetTriangleCount() / 2 );
+    ILOG( "     mask       = %ux%u, coverage = %.1lf%%", foliage.Mask.GetWidth(), foliage.Mask.GetHeight(), 100.0 * foliage.Mask.GetCoverage() );
+    ILOG( "--------------------------------------------------------------------" );
+    ILOG( "%-8" ASDX_PRIs " %-8" ASDX_PRIs " %-8" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs,
+        "backend", "scene", "method", "primary", "random", "occluded", "trace/ray" );
+
+    auto result = true;
+    for(auto backend : backends)
+    {
+        for(auto i=0u; i<2; ++i)
+        {
+            double rates[2][3] = {};
+            for(auto j=0u; j<2; ++j)
+            {
+                AccelDesc accelDesc;
+                accelDesc.Backend      = backend;
+                accelDesc.DeviceConfig = desc.DeviceConfig;
+
+                auto accel = CreateAccel(backend);
+                if (!accel->Init(accelDesc))
+                {
+                    ELOG("Error : Accel::Init() Failed.");
+                    result = false;
+                    continue;
+                }
+
+                const auto filter = (j == 1) ? AlphaTest : nullptr;
+                auto added = true;
+                if (i == 0)
+                {
+                    auto geomID = accel->AddSharedTriangles(
+                        foliage.Crown.Positions.GetData(), foliage.Crown.GetVertexCount(),
+                        foliage.Crown.Indices  .GetData(), foliage.Crown.GetTriangleCount());
+                    added = (geomID != RTC_INVALID_GEOMETRY_ID) && accel->SetHitFilter(geomID, filter, &sources[i]);
+                }
+                else
+                {
+                    auto prototype = accel->AddPrototype(
+                        foliage.Branch.Positions.GetData(), foliage.Branch.GetVertexCount(),
+                        foliage.Branch.Indices  .GetData(), foliage.Branch.GetTriangleCount());
+                    added = (prototype != RTC_INVALID_GEOMETRY_ID) && accel->SetPrototypeHitFilter(prototype, filter, &sources[i]);
+                    for(const auto& transform : foliage.Transforms)
+                    { added &= accel->AddInstance(prototype, transform) != RTC_INVALID_GEOMETRY_ID; }
+                }
+
+                if (!added || !accel->Commit())
+                {
+                    ELOG("Error : Accel Setup Failed.");
+                    accel->Term();
+                    result = false;
+                    continue;
+                }
+
+                const auto* restart = (j == 0) ? &sources[i] : nullptr;
+                uint64_t traceCount = 0;
+                rates[j][0] = MeasureAlphaIntersect(accel.get(), foliage.PrimaryRays, restart, traceCount);
+                rates[j][1] = MeasureAlphaIntersect(accel.get(), foliage.RandomRays,  restart, traceCount);
+                rates[j][2] = MeasureAlphaOccluded (accel.get(), foliage.RandomRays,  restart, traceCount);
+
+                auto rayCount = foliage.PrimaryRays.size() + foliage.RandomRays.size() * 2;
+                ILOG( "%-8" ASDX_PRIs " %-8" ASDX_PRIs " %-8" ASDX_PRIs " %10.3lf %10.3lf %10.3lf %10.2lf",
+                    GetAccelBackendName(accel->GetBackend()),
+                    sceneNames[i],
+                    methodNames[j],
+                    rates[j][0], rates[j][1], rates[j][2],
+                    double(traceCount) / double(rayCount) );
+
+                accel->Term();
+            }
+
+            if (rates[0][0] > 0.0 && rates[1][0] > 0.0)
+            {
+                ILOG( "%-8" ASDX_PRIs " %-8" ASDX_PRIs " %-8" ASDX_PRIs " %9.2lfx %9.2lfx %9.2lfx",
+                    "", "", "speedup",
+                    rates[1][0] / rates[0][0],
+                    rates[1][1] / rates[0][1],
+                    rates[1][2] / rates[0][2] );
+            }
+        }
+    }
+
+    ILOG( "--------------------------------------------------------------------" );
+    ILOG( " trace/ray counts Intersect1() and Occluded1() calls per ray." );
+    return result;
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      加速構造のベンチマークを実行します.
+//-----------------------------------------------------------------------------
+bool RunAccelBench(const AccelBenchDesc& desc)
+{
+    Scene scene;
+    CreateScene(desc, scene);
+
+    // 計測する設定の一覧(組み込みBVHは構築品質とシーンフラグを使わないので1つだけ).
+    std::vector<Setting> settings;
+#if SALTY2_USE_EMBREE
+    {
+        const RTCBuildQuality qualities[] = {
+            RTC_BUILD_QUALITY_LOW,
+            RTC_BUILD_QUALITY_MEDIUM,
+            RTC_BUILD_QUALITY_HIGH,
+        };
+        const RTCSceneFlags flags[] = {
+            RTC_SCENE_FLAG_NONE,
+            RTC_SCENE_FLAG_COMPACT,
+            RTC_SCENE_FLAG_ROBUST,
+            RTCSceneFlags(RTC_SCENE_FLAG_COMPACT | RTC_SCENE_FLAG_ROBUST),
+        };
+
+        for(auto quality : qualities)
+        {
+            for(auto flag : flags)
+            { settings.push_back({ ACCEL_BACKEND_EMBREE, quality, flag }); }
+        }
+    }
+#endif
+    settings.push_back({ ACCEL_BACKEND_BVH, RTC_BUILD_QUALITY_MEDIUM, RTC_SCENE_FLAG_NONE });
+
+    ILOG( "--------------------------------------------------------------------" );
+    ILOG( " Accel Benchmark : " );
+    ILOG( "     triangles  = %zu", scene.Indices.size() / 3 );
+    ILOG( "     rays       = %zu (primary), %zu (random)", scene.PrimaryRays.size(), scene.RandomRays.size() );
+    ILOG( "     device     = %" ASDX_PRIs, (desc.DeviceConfig != nullptr) ? desc.DeviceConfig : "(default)" );
+    ILOG( "--------------------------------------------------------------------" );
+    ILOG( "%-8" ASDX_PRIs " %-8" ASDX_PRIs " %-16" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs " %10" ASDX_PRIs,
+        "backend", "quality", "flags", "build(ms)", "mem(MB)", "peak(MB)", "primary", "random", "occluded" );
+
+    // 比較用のスループット(primary, random, occluded)です. 0 は未計測を表します.
+    double embreeThroughput[3] = {};
+    double bvhThroughput   [3] = {};
+
+    auto result = true;
+    for(const auto& setting : settings)
+    {
+        AccelDesc accelDesc;
+        accelDesc.Backend      = setting.Backend;
+        accelDesc.DeviceConfig = desc.DeviceConfig;
+        accelDesc.BuildQuality = setting.BuildQuality;
+        accelDesc.SceneFlags   = setting.SceneFlags;
+
+        auto accel = CreateAccel(setting.Backend);
+        if (!accel->Init(accelDesc))
+        {
+            ELOG("Error : Accel::Init() Failed.");
+            result = false;
+            continue;
+        }
+
+        accel->AddTriangles(
+            scene.Vertices.data(), uint32_t(scene.Vertices.size()),
+            scene.Indices .data(), uint32_t(scene.Indices .size() / 3));
+
+        if (!accel->Commit())
+        {
+            ELOG("Error : Accel::Commit() Failed.");
+            accel->Term();
+            result = false;
+            continue;
+        }
+
+        auto primary  = MeasureIntersect(accel.get(), scene.PrimaryRays);
+        auto random   = MeasureIntersect(accel.get(), scene.RandomRays);
+        auto occluded = MeasureOccluded (accel.get(), scene.RandomRays);
+        auto stats    = accel->GetStats();
+
+        const auto MB = 1.0 / (1024.0 * 1024.0);
+        ILOG( "%-8" ASDX_PRIs " %-8" ASDX_PRIs " %-16" ASDX_PRIs " %10.2lf %10.2lf %10.2lf %10.3lf %10.3lf %10.3lf",
+            GetAccelBackendName(accel->GetBackend()),
+            GetBuildQualityName(setting.BuildQuality),
+            GetSceneFlagsName(setting.SceneFlags),
+            stats.BuildMsec,
+            double(stats.MemorySize) * MB,
+            double(stats.PeakMemorySize) * MB,
+            primary, random, occluded );
+
+        // Embree は既定の設定(MEDIUM, NONE)と比較する.
+        double* throughput = nullptr;
+        if (setting.Backend == ACCEL_BACKEND_BVH)
+        { throughput = bvhThroughput; }
+        else if (setting.BuildQuality == RTC_BUILD_QUALITY_MEDIUM && setting.SceneFlags == RTC_SCENE_FLAG_NONE)
+        { throughput = embreeThroughput; }
+
+        if (throughput != nullptr)
+        {
+            throughput[0] = primary;
+            throughput[1] = random;
+            throughput[2] = occluded;
+        }
+
+        accel->Term();
+    }
+
+    ILOG( "--------------------------------------------------------------------" );
+    ILOG( " throughput is Mrays/s on the calling thread." );
+
+    // 両方のバックエンドを計測できた場合は速度比を出力する.
+    if (embreeThroughput[0] > 0.0 && bvhThroughput[0] > 0.0)
+    {
+        ILOG( " bvh / embree(medium, none) = %.2lfx (primary), %.2lfx (random), %.2lfx (occluded)",
+            bvhThroughput[0] / embreeThroughput[0],
+            bvhThroughput[1] / embreeThroughput[1],
+            bvhThroughput[2] / embreeThroughput[2] );
+    }
+
+    if (desc.StrandCount > 0)
+    { result &= RunCurveBench(desc, scene); }
+
+    if (desc.LeafCount > 0)
+    { result &= RunAlphaBench(desc); }
+
+    return result;
+}
@@ -0,0 +1,91 @@
+﻿//-----------------------------------------------------------------------------
+// File : alphaMask.cpp
+// Desc : Alpha Mask for Cutout Geometry.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <alphaMask.h>
+#include <attribute.h>
+#include <asdxLogger.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AlphaMask class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool AlphaMask::Init
+(
+    uint32_t        width,
+    uint32_t        height,
+    const uint8_t*  alpha,
+    uint32_t        pixelStride,
+    uint32_t        rowPitch,
+    uint8_t         threshold
+)
+{
+    Term();
+
+    if (width == 0 || height == 0 || alpha == nullptr || pixelStride == 0)
+    {
+        ELOG("Error : Invalid Argument. width = %u, height = %u", width, height);
+        return false;
+    }
+
+    if (rowPitch == 0)
+    { rowPitch = width * pixelStride; }
+
+    m_Width      = width;
+    m_Height     = height;
+    m_TileCountX = (width  + TILE_SIZE - 1) / TILE_SIZE;
+    auto tileCountY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    m_Tiles.resize(size_t(m_TileCountX) * tileCountY, 0);
+
+    uint64_t opaqueCount = 0;
+    for(auto y=0u; y<height; ++y)
+    {
+        const auto* row   = alpha + size_t(y) * rowPitch;
+        auto*       tiles = m_Tiles.data() + size_t(y / TILE_SIZE) * m_TileCountX;
+        auto        shift = (y % TILE_SIZE) * TILE_SIZE;
+
+        for(auto x=0u; x<width; ++x)
+        {
+            if (row[size_t(x) * pixelStride] < threshold)
+            { continue; }
+
+            tiles[x / TILE_SIZE] |= uint64_t(1) << (shift + x % TILE_SIZE);
+            opaqueCount++;
+        }
+    }
+
+    m_Coverage = float(double(opaqueCount) / (double(width) * double(height)));
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void AlphaMask::Term()
+{
+    m_Tiles.clear();
+    m_Tiles.shrink_to_fit();
+    m_Width      = 0;
+    m_Height     = 0;
+    m_TileCountX = 0;
+    m_Coverage   = 0.0f;
+}
+
+//-----------------------------------------------------------------------------
+//      交差位置のアルファテストを行います.
+//-----------------------------------------------------------------------------
+bool AlphaTest(const void* userPtr, uint32_t primID, float u, float v)
+{
+    auto source   = static_cast<const AlphaTestSource*>(userPtr);
+    auto texcoord = DecodeTexCoord(*source->pMesh, primID, u, v);
+    return source->pMask->IsOpaque(texcoord.x, texcoord.y);
+}
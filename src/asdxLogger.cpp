@@ -9,9 +9,16 @@
 //-----------------------------------------------------------------------------
 #include <cstdio>
 #include <cstdarg>
-#include <Windows.h>
+#include <cstdlib>
+#include <cwchar>
 #include <asdxLogger.h>
 
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
 
 namespace /* anonymous */ {
 
@@ -40,6 +47,7 @@ public:
     //!
     //! @param[in]      level       ログレベルです.
     //-------------------------------------------------------------------------
+#if defined(_WIN32)
     explicit ConsoleColor(asdx::LOG_LEVEL level)
     {
         const auto handle = GetStdHandle( STD_OUTPUT_HANDLE );
@@ -81,11 +89,47 @@ public:
         SetConsoleTextAttribute( handle, m_Info.wAttributes );
     }
 
+#else
+    explicit ConsoleColor(asdx::LOG_LEVEL level)
+    {
+        // リダイレクト先にエスケープシーケンスを書き込まないよう, 端末の場合だけ色を付ける.
+        m_Enable = (isatty(STDOUT_FILENO) != 0);
+        if (!m_Enable)
+        { return; }
+
+        const char* sequence = "\x1b[0m";
+        switch( level )
+        {
+        case asdx::LOG_VERBOSE: sequence = "\x1b[97m"; break;
+        case asdx::LOG_INFO:    sequence = "\x1b[92m"; break;
+        case asdx::LOG_DEBUG:   sequence = "\x1b[94m"; break;
+        case asdx::LOG_WARNING: sequence = "\x1b[93m"; break;
+        case asdx::LOG_ERROR:   sequence = "\x1b[91m"; break;
+        }
+
+        fputs( sequence, stdout );
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~ConsoleColor()
+    {
+        if (m_Enable)
+        { fputs( "\x1b[0m", stdout ); }
+    }
+
+#endif
+
 private:
     //=========================================================================
     // private variables.
     //=========================================================================
+#if defined(_WIN32)
     CONSOLE_SCREEN_BUFFER_INFO  m_Info = {};
+#else
+    bool                        m_Enable = false;
+#endif
 
     //=========================================================================
     // private methods.
@@ -130,12 +174,20 @@ void SystemLogger::WriteA(LOG_LEVEL level, const char* format, ... )
             va_list arg;
 
             va_start( arg, format );
+        #if defined(_WIN32)
             vsprintf_s( msg, format, arg );
+        #else
+            vsnprintf( msg, sizeof(msg), format, arg );
+        #endif
             va_end( arg );
 
+        #if defined(_WIN32)
             printf_s( "%s", msg );
 
             OutputDebugStringA( msg );
+        #else
+            fputs( msg, stdout );
+        #endif
         }
     }
 }
@@ -154,12 +206,23 @@ void SystemLogger::WriteW(LOG_LEVEL level, const wchar_t* format, ... )
             va_list arg;
 
             va_start( arg, format );
+        #if defined(_WIN32)
             vswprintf_s( msg, format, arg );
+        #else
+            vswprintf( msg, 2048, format, arg );
+        #endif
             va_end( arg );
 
+        #if defined(_WIN32)
             wprintf_s( L"%s", msg );
 
             OutputDebugStringW( msg );
+        #else
+            // stdout を狭い文字の向きのまま使うため, マルチバイトに変換して出力する.
+            char mbs[ 2048 * 4 ] = "\0";
+            if ( wcstombs( mbs, msg, sizeof(mbs) - 1 ) != size_t(-1) )
+            { fputs( mbs, stdout ); }
+        #endif
         }
     }
 }
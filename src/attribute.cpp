@@ -0,0 +1,355 @@
+﻿//-----------------------------------------------------------------------------
+// File : attribute.cpp
+// Desc : Quantized Vertex Attributes.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <attribute.h>
+#include <asdxLogger.h>
+#include <vector>
+#include <cfloat>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+//      snorm16 に量子化します.
+//-----------------------------------------------------------------------------
+inline int32_t ToSnorm16(float value, bool roundUp)
+{
+    auto scaled = asdx::Clamp(value, -1.0f, 1.0f) * 32767.0f;
+    return int32_t(roundUp ? ceilf(scaled) : floorf(scaled));
+}
+
+//-----------------------------------------------------------------------------
+//      snorm16 x 2 を格納します.
+//-----------------------------------------------------------------------------
+inline uint32_t PackSnorm16(int32_t x, int32_t y)
+{ return (uint32_t(x) & 0xffff) | ((uint32_t(y) & 0xffff) << 16); }
+
+//-----------------------------------------------------------------------------
+//      正規化します. 長さが 0 の場合は代わりの値を返却します.
+//-----------------------------------------------------------------------------
+inline asdx::Vector3 NormalizeOr(const asdx::Vector3& value, const asdx::Vector3& fallback)
+{
+    auto lengthSq = asdx::Vector3::Dot(value, value);
+    if (lengthSq <= FLT_MIN)
+    { return fallback; }
+
+    return value * (1.0f / sqrtf(lengthSq));
+}
+
+//-----------------------------------------------------------------------------
+//      面積で重み付けした頂点法線を生成します.
+//-----------------------------------------------------------------------------
+void CalcVertexNormals(const Mesh& mesh, std::vector<asdx::Vector3>& normals)
+{
+    normals.assign(mesh.GetVertexCount(), asdx::Vector3(0.0f, 0.0f, 0.0f));
+
+    // 外積の長さが面積の2倍なので, 正規化せずに足せば面積の重みになる.
+    const auto* indices = mesh.Indices.GetData();
+    for(auto i=0u; i<mesh.GetTriangleCount(); ++i)
+    {
+        auto i0 = indices[i * 3 + 0];
+        auto i1 = indices[i * 3 + 1];
+        auto i2 = indices[i * 3 + 2];
+        const auto& p0 = mesh.Positions[i0];
+        auto n = asdx::Vector3::Cross(mesh.Positions[i1] - p0, mesh.Positions[i2] - p0);
+        normals[i0] += n;
+        normals[i1] += n;
+        normals[i2] += n;
+    }
+
+    // 参照されない頂点や縮退面だけの頂点は +Z にしておく.
+    for(auto& n : normals)
+    { n = asdx::Vector3::SafeNormalize(n, asdx::Vector3(0.0f, 0.0f, 1.0f)); }
+}
+
+//-----------------------------------------------------------------------------
+//      テクスチャ座標の勾配から接線を求めます.
+//-----------------------------------------------------------------------------
+void CalcVertexTangents
+(
+    const Mesh&                 mesh,
+    const asdx::Vector3*        normals,
+    const asdx::Vector2*        texcoords,
+    std::vector<asdx::Vector4>& tangents
+)
+{
+    const auto vertexCount = mesh.GetVertexCount();
+    std::vector<asdx::Vector3> tu(vertexCount, asdx::Vector3(0.0f, 0.0f, 0.0f));
+    std::vector<asdx::Vector3> tv(vertexCount, asdx::Vector3(0.0f, 0.0f, 0.0f));
+
+    const auto* indices = mesh.Indices.GetData();
+    for(auto i=0u; i<mesh.GetTriangleCount(); ++i)
+    {
+        uint32_t idx[3] = { indices[i * 3 + 0], indices[i * 3 + 1], indices[i * 3 + 2] };
+
+        auto e1 = mesh.Positions[idx[1]] - mesh.Positions[idx[0]];
+        auto e2 = mesh.Positions[idx[2]] - mesh.Positions[idx[0]];
+        auto d1 = texcoords[idx[1]] - texcoords[idx[0]];
+        auto d2 = texcoords[idx[2]] - texcoords[idx[0]];
+
+        // テクスチャ空間の面積で割らず, 符号だけを合わせて足すことで三角形の面積で重み付けする.
+        auto det = d1.x * d2.y - d2.x * d1.y;
+        if (fabsf(det) <= FLT_MIN)
+        { continue; }
+
+        auto s  = (det > 0.0f) ? 1.0f : -1.0f;
+        auto du = (e1 * d2.y - e2 * d1.y) * s;
+        auto dv = (e2 * d1.x - e1 * d2.x) * s;
+        for(auto j=0; j<3; ++j)
+        {
+            tu[idx[j]] += du;
+            tv[idx[j]] += dv;
+        }
+    }
+
+    tangents.resize(vertexCount);
+    for(auto i=0u; i<vertexCount; ++i)
+    {
+        // 法線に直交化し, 従法線の向きは v 方向の勾配との比較で決める.
+        const auto& n = normals[i];
+        auto t = tu[i] - n * asdx::Vector3::Dot(n, tu[i]);
+        if (asdx::Vector3::Dot(t, t) <= FLT_MIN)
+        {
+            asdx::Vector3 b;
+            asdx::CalcONB(n, t, b);
+        }
+        t = asdx::Vector3::Normalize(t);
+
+        auto w = (asdx::Vector3::Dot(asdx::Vector3::Cross(n, t), tv[i]) < 0.0f) ? -1.0f : 1.0f;
+        tangents[i] = asdx::Vector4(t, w);
+    }
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      単位ベクトルを八面体写像で量子化します.
+//-----------------------------------------------------------------------------
+uint32_t EncodeOctNormal(const asdx::Vector3& value)
+{
+    auto l1 = fabsf(value.x) + fabsf(value.y) + fabsf(value.z);
+    if (l1 <= FLT_MIN)
+    { return PackSnorm16(0, 0); }
+
+    auto x = value.x / l1;
+    auto y = value.y / l1;
+    if (value.z < 0.0f)
+    {
+        auto fx = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+        auto fy = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+
+    // 最近傍に丸めるより, 復元した向きが最も近い組み合わせを選ぶ方が誤差が小さい.
+    auto n = asdx::Vector3::Normalize(value);
+    auto best    = PackSnorm16(ToSnorm16(x, false), ToSnorm16(y, false));
+    auto bestDot = -FLT_MAX;
+    for(auto i=0; i<4; ++i)
+    {
+        auto packed = PackSnorm16(ToSnorm16(x, (i & 1) != 0), ToSnorm16(y, (i & 2) != 0));
+        auto dot    = asdx::Vector3::Dot(DecodeOctNormal(packed), n);
+        if (dot > bestDot)
+        {
+            best    = packed;
+            bestDot = dot;
+        }
+    }
+
+    return best;
+}
+
+//-----------------------------------------------------------------------------
+//      頂点属性を量子化して格納します.
+//-----------------------------------------------------------------------------
+bool EncodeAttributes
+(
+    const Mesh&             mesh,
+    const asdx::Vector3*    normals,
+    const asdx::Vector2*    texcoords,
+    VertexAttributes&       result
+)
+{
+    result.Clear();
+
+    const auto vertexCount = mesh.GetVertexCount();
+    if (vertexCount == 0)
+    { return true; }
+
+    std::vector<asdx::Vector3> generated;
+    if (normals == nullptr)
+    {
+        CalcVertexNormals(mesh, generated);
+        normals = generated.data();
+    }
+
+    if (!result.Normals.Resize(vertexCount))
+    {
+        ELOG("Error : Out of Memory. vertices = %u", vertexCount);
+        return false;
+    }
+
+    for(auto i=0u; i<vertexCount; ++i)
+    { result.Normals[i] = EncodeOctNormal(normals[i]); }
+
+    if (texcoords == nullptr)
+    { return true; }
+
+    // メッシュ単位の範囲で量子化する. 幅が 0 の軸は割らずに済むよう 1 にしておく.
+    asdx::Vector2 mini( FLT_MAX,  FLT_MAX);
+    asdx::Vector2 maxi(-FLT_MAX, -FLT_MAX);
+    for(auto i=0u; i<vertexCount; ++i)
+    {
+        mini = asdx::Vector2::Min(mini, texcoords[i]);
+        maxi = asdx::Vector2::Max(maxi, texcoords[i]);
+    }
+
+    auto size = maxi - mini;
+    result.TexCoordRange = asdx::Vector4(
+        mini.x, mini.y,
+        (size.x > 0.0f) ? size.x : 1.0f,
+        (size.y > 0.0f) ? size.y : 1.0f);
+
+    std::vector<asdx::Vector4> tangents;
+    CalcVertexTangents(mesh, normals, texcoords, tangents);
+
+    if (!result.TexCoords.Resize(vertexCount) || !result.Tangents.Resize(vertexCount))
+    {
+        ELOG("Error : Out of Memory. vertices = %u", vertexCount);
+        result.Clear();
+        return false;
+    }
+
+    for(auto i=0u; i<vertexCount; ++i)
+    {
+        result.TexCoords[i] = EncodeTexCoord(texcoords[i], result.TexCoordRange);
+
+        // 従法線の向きは x の最下位ビットに入れる. 向きの誤差は 1/32767 以下なので影響は無い.
+        auto packed = EncodeOctNormal(asdx::Vector3(tangents[i].x, tangents[i].y, tangents[i].z));
+        result.Tangents[i] = (packed & ~1u) | ((tangents[i].w < 0.0f) ? 1u : 0u);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      交差位置の頂点属性を復元します.
+//-----------------------------------------------------------------------------
+void DecodeAttributes(const Mesh& mesh, uint32_t primID, float u, float v, SurfaceAttributes& result)
+{
+    const auto* indices = mesh.Indices.GetData() + size_t(primID) * 3;
+    const auto  i0 = indices[0];
+    const auto  i1 = indices[1];
+    const auto  i2 = indices[2];
+    const auto  w  = 1.0f - u - v;
+
+    // 交差位置はキャッシュに乗っていないことが多いので, 計算の前に全ストリームを読み込んでミスを重ねる.
+    const auto& attributes  = mesh.Attributes;
+    const auto  hasNormal   = attributes.Normals  .GetCount() > 0;
+    const auto  hasTangent  = attributes.Tangents .GetCount() > 0;
+    const auto  hasTexCoord = attributes.TexCoords.GetCount() > 0;
+    const auto  range       = attributes.TexCoordRange;
+
+    const auto p0 = mesh.Positions[i0];
+    const auto p1 = mesh.Positions[i1];
+    const auto p2 = mesh.Positions[i2];
+
+    uint32_t n[3] = {}, t[3] = {}, c[3] = {};
+    if (hasNormal)
+    {
+        n[0] = attributes.Normals[i0];
+        n[1] = attributes.Normals[i1];
+        n[2] = attributes.Normals[i2];
+    }
+    if (hasTangent)
+    {
+        t[0] = attributes.Tangents[i0];
+        t[1] = attributes.Tangents[i1];
+        t[2] = attributes.Tangents[i2];
+    }
+    if (hasTexCoord)
+    {
+        c[0] = attributes.TexCoords[i0];
+        c[1] = attributes.TexCoords[i1];
+        c[2] = attributes.TexCoords[i2];
+    }
+
+    result.Position       = p0 * w + p1 * u + p2 * v;
+    result.GeometryNormal = NormalizeOr(asdx::Vector3::Cross(p1 - p0, p2 - p0), asdx::Vector3(0.0f, 0.0f, 1.0f));
+
+    if (hasNormal)
+    {
+        auto normal = DecodeOctNormal(n[0]) * w
+                    + DecodeOctNormal(n[1]) * u
+                    + DecodeOctNormal(n[2]) * v;
+        result.Normal = NormalizeOr(normal, result.GeometryNormal);
+    }
+    else
+    { result.Normal = result.GeometryNormal; }
+
+    if (hasTexCoord)
+    {
+        // 範囲の変換は線形なので, 量子化値のまま補間してから1回だけ戻す.
+        auto qu = float(c[0] & 0xffff) * w + float(c[1] & 0xffff) * u + float(c[2] & 0xffff) * v;
+        auto qv = float(c[0] >> 16)    * w + float(c[1] >> 16)    * u + float(c[2] >> 16)    * v;
+        result.TexCoord = asdx::Vector2(
+            range.x + qu * (range.z / 65535.0f),
+            range.y + qv * (range.w / 65535.0f));
+    }
+    else
+    { result.TexCoord = asdx::Vector2(u, v); }
+
+    if (hasTangent)
+    {
+        // 補間した法線に直交化して正規化するので, 頂点ごとの正規化は省く.
+        // 隣接頂点の接線はほぼ同じ向きなので, 長さの違いによる重みの偏りは無視できる.
+        auto tangent = DecodeOctDirection(t[0]) * w
+                     + DecodeOctDirection(t[1]) * u
+                     + DecodeOctDirection(t[2]) * v;
+
+        const auto& normal = result.Normal;
+        tangent -= normal * asdx::Vector3::Dot(normal, tangent);
+
+        // 縮退した場合は基底を作り直す.
+        auto lengthSq = asdx::Vector3::Dot(tangent, tangent);
+        if (lengthSq > FLT_MIN)
+        {
+            auto sign = ((t[0] & 1u) != 0) ? -1.0f : 1.0f;
+            result.Tangent   = tangent * (1.0f / sqrtf(lengthSq));
+            result.Bitangent = asdx::Vector3::Cross(normal, result.Tangent) * sign;
+            return;
+        }
+    }
+
+    asdx::CalcONB(result.Normal, result.Tangent, result.Bitangent);
+}
+
+//-----------------------------------------------------------------------------
+//      交差位置のテクスチャ座標だけを復元します.
+//-----------------------------------------------------------------------------
+asdx::Vector2 DecodeTexCoord(const Mesh& mesh, uint32_t primID, float u, float v)
+{
+    const auto& texcoords = mesh.Attributes.TexCoords;
+    if (texcoords.GetCount() == 0)
+    { return asdx::Vector2(u, v); }
+
+    const auto* indices = mesh.Indices.GetData() + size_t(primID) * 3;
+    const auto  c0 = texcoords[indices[0]];
+    const auto  c1 = texcoords[indices[1]];
+    const auto  c2 = texcoords[indices[2]];
+    const auto  w  = 1.0f - u - v;
+    const auto& range = mesh.Attributes.TexCoordRange;
+
+    auto qu = float(c0 & 0xffff) * w + float(c1 & 0xffff) * u + float(c2 & 0xffff) * v;
+    auto qv = float(c0 >> 16)    * w + float(c1 >> 16)    * u + float(c2 >> 16)    * v;
+    return asdx::Vector2(
+        range.x + qu * (range.z / 65535.0f),
+        range.y + qv * (range.w / 65535.0f));
+}
@@ -0,0 +1,1949 @@
+﻿//-----------------------------------------------------------------------------
+// File : bvh.cpp
+// Desc : Bounding Volume Hierarchy.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <bvh.h>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <future>
+#include <thread>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Constant Values
+//-----------------------------------------------------------------------------
+static constexpr uint32_t BIN_COUNT          = 32;       // SAHのビン数.
+static constexpr uint32_t PARALLEL_TASK_SIZE = 4096;     // これ以上の部分木は別スレッドで構築.
+static constexpr uint32_t PARALLEL_BIN_SIZE  = 65536;    // これ以上の範囲はビニングを分割.
+static constexpr uint32_t MEDIAN_DEPTH       = BVH::MAX_DEPTH - 16;    // これより深い場合は中央値で分割.
+static constexpr uint32_t STACK_SIZE         = 3 * BVH::MAX_DEPTH + 1; // 走査スタックのサイズ.
+static constexpr float    SLAB_NEAR_SCALE    = 0.9999992847442627f;    // 手前側に掛ける係数 1 - 2γ(3).
+static constexpr float    MOTION_EPSILON     = 1.0f / (1 << 20);      // 時刻で補間した境界を広げる相対幅.
+static constexpr float    RCP_EPSILON        = 1e-18f;                 // 逆数を取る前に方向成分へ与える最小の大きさ.
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PrimRef structure
+///////////////////////////////////////////////////////////////////////////////
+struct PrimRef
+{
+    asdx::AABB  Box;
+    uint32_t    GeomID;
+    uint32_t    PrimID;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Range structure
+///////////////////////////////////////////////////////////////////////////////
+struct Range
+{
+    uint32_t    Begin;
+    uint32_t    End;
+    asdx::AABB  Bounds;     // プリミティブの境界.
+    asdx::AABB  Centroids;  // 重心の境界.
+
+    inline uint32_t Count() const { return End - Begin; }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Bin structure
+///////////////////////////////////////////////////////////////////////////////
+struct Bin
+{
+    asdx::AABB  Bounds;
+    asdx::AABB  Centroids;
+    uint32_t    Count = 0;
+
+    inline void Merge(const Bin& value)
+    {
+        Bounds   .Merge(value.Bounds);
+        Centroids.Merge(value.Centroids);
+        Count += value.Count;
+    }
+};
+
+//-----------------------------------------------------------------------------
+//      重心を求めます.
+//-----------------------------------------------------------------------------
+inline asdx::Vector3 GetCentroid(const PrimRef& ref)
+{ return (ref.Box.mini + ref.Box.maxi) * 0.5f; }
+
+//-----------------------------------------------------------------------------
+//      ベクトルの成分を番号で取得します.
+//-----------------------------------------------------------------------------
+inline float GetAxis(const asdx::Vector3& value, uint32_t axis)
+{ return (axis == 0) ? value.x : ((axis == 1) ? value.y : value.z); }
+
+//-----------------------------------------------------------------------------
+//      並列に処理します.
+//-----------------------------------------------------------------------------
+template<typename Func>
+void ParallelFor(uint32_t count, uint32_t threadCount, const Func& func)
+{
+    if (threadCount <= 1 || count < PARALLEL_BIN_SIZE)
+    {
+        func(0, count, 0);
+        return;
+    }
+
+    auto chunk = (count + threadCount - 1) / threadCount;
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for(auto i=1u; i<threadCount; ++i)
+    {
+        auto begin = std::min(count, chunk * i);
+        auto end   = std::min(count, begin + chunk);
+        threads.emplace_back(func, begin, end, i);
+    }
+
+    func(0, std::min(count, chunk), 0);
+
+    for(auto& itr : threads)
+    { itr.join(); }
+}
+
+//-----------------------------------------------------------------------------
+//      量子化された値を復元します.
+//-----------------------------------------------------------------------------
+inline float Dequantize(float origin, uint8_t q, float scale)
+{
+#if ASDX_SIMD
+    // 走査時と同じ丸めになるように FMA を使わずに計算する.
+    auto r = _mm_add_ss(_mm_set_ss(origin), _mm_mul_ss(_mm_set_ss(float(q)), _mm_set_ss(scale)));
+    return _mm_cvtss_f32(r);
+#else
+    auto r = float(q) * scale;
+    return origin + r;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      ノードの子の境界を復元します.
+//-----------------------------------------------------------------------------
+inline void DecodeNode(const BVH::Node& node, asdx::AABBx4& result)
+{
+    for(auto i=0u; i<BVH::WIDTH; ++i)
+    {
+        result.minX[i] = Dequantize(node.Origin[0], node.LoX[i], node.Scale[0]);
+        result.minY[i] = Dequantize(node.Origin[1], node.LoY[i], node.Scale[1]);
+        result.minZ[i] = Dequantize(node.Origin[2], node.LoZ[i], node.Scale[2]);
+        result.maxX[i] = Dequantize(node.Origin[0], node.HiX[i], node.Scale[0]);
+        result.maxY[i] = Dequantize(node.Origin[1], node.HiY[i], node.Scale[1]);
+        result.maxZ[i] = Dequantize(node.Origin[2], node.HiZ[i], node.Scale[2]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      量子化の刻み幅を求めます.
+//-----------------------------------------------------------------------------
+inline float QuantizeScale(float origin, float scale)
+{
+    // 幅が0の軸でも量子化で0除算しないように最小の刻み幅を設ける.
+    auto minScale = std::max(fabsf(origin), 1.0f) * (1.0f / (65536.0f * 255.0f));
+    return std::max(scale, minScale);
+}
+
+//-----------------------------------------------------------------------------
+//      最小値を包含するように量子化します.
+//-----------------------------------------------------------------------------
+inline uint8_t QuantizeLo(float origin, float value, float scale)
+{
+    auto q = int(floorf((value - origin) / scale));
+    q = asdx::Clamp(q, 0, 255);
+    while (q > 0 && Dequantize(origin, uint8_t(q), scale) > value)
+    { q--; }
+
+    // 走査時の丸め誤差を吸収するために1段外側に広げる.
+    return uint8_t(std::max(q - 1, 0));
+}
+
+//-----------------------------------------------------------------------------
+//      最大値を包含するように量子化します.
+//-----------------------------------------------------------------------------
+inline uint8_t QuantizeHi(float origin, float value, float scale)
+{
+    auto q = int(ceilf((value - origin) / scale));
+    q = asdx::Clamp(q, 0, 255);
+    while (q < 255 && Dequantize(origin, uint8_t(q), scale) < value)
+    { q++; }
+    assert(Dequantize(origin, uint8_t(q), scale) >= value);
+
+    // 走査時の丸め誤差を吸収するために1段外側に広げる.
+    return uint8_t(std::min(q + 1, 255));
+}
+
+//-----------------------------------------------------------------------------
+//      子の境界を量子化してノードに設定します.
+//-----------------------------------------------------------------------------
+inline void EncodeNode(BVH::Node& node, const asdx::AABB& bounds, const asdx::AABB* children, uint32_t childCount)
+{
+    const auto& mini = bounds.mini;
+    const auto  ext  = bounds.GetExtent();
+
+    // 両端に1段ずつ余白を取り, どの子も1段外側に広げられるようにする.
+    // 刻み幅は僅かに広げて 254 で必ず最大値を包含させる.
+    const float scale = (1.0f + 1.0f / 65536.0f) / 253.0f;
+    node.Scale [0] = QuantizeScale(mini.x, ext.x * scale);
+    node.Scale [1] = QuantizeScale(mini.y, ext.y * scale);
+    node.Scale [2] = QuantizeScale(mini.z, ext.z * scale);
+    node.Origin[0] = mini.x - node.Scale[0];
+    node.Origin[1] = mini.y - node.Scale[1];
+    node.Origin[2] = mini.z - node.Scale[2];
+
+    for(auto i=0u; i<BVH::WIDTH; ++i)
+    {
+        if (i >= childCount)
+        {
+            // 空の子は最小値 > 最大値 にしておく(走査では参照でも除外する).
+            node.LoX[i] = node.LoY[i] = node.LoZ[i] = 255;
+            node.HiX[i] = node.HiY[i] = node.HiZ[i] = 0;
+            continue;
+        }
+
+        const auto& box = children[i];
+        node.LoX[i] = QuantizeLo(node.Origin[0], box.mini.x, node.Scale[0]);
+        node.LoY[i] = QuantizeLo(node.Origin[1], box.mini.y, node.Scale[1]);
+        node.LoZ[i] = QuantizeLo(node.Origin[2], box.mini.z, node.Scale[2]);
+        node.HiX[i] = QuantizeHi(node.Origin[0], box.maxi.x, node.Scale[0]);
+        node.HiY[i] = QuantizeHi(node.Origin[1], box.maxi.y, node.Scale[1]);
+        node.HiZ[i] = QuantizeHi(node.Origin[2], box.maxi.z, node.Scale[2]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ノードの走査コストを求めます.
+//-----------------------------------------------------------------------------
+float CalcNodeCost(const BVH::Node* nodes, uint32_t count, const asdx::AABB& bounds)
+{
+    // 子の表面積の合計をルートの表面積で割った値(レイ1本あたりの子の判定回数の期待値).
+    auto rootArea = bounds.GetSurfaceArea();
+    if (count == 0 || !(rootArea > 0.0f))
+    { return 0.0f; }
+
+    double area = 0.0;
+    for(auto i=0u; i<count; ++i)
+    {
+        asdx::AABBx4 boxes;
+        DecodeNode(nodes[i], boxes);
+        for(auto j=0u; j<BVH::WIDTH; ++j)
+        {
+            if (nodes[i].Child[j] == BVH::EMPTY_REF)
+            { continue; }
+
+            auto dx = boxes.maxX[j] - boxes.minX[j];
+            auto dy = boxes.maxY[j] - boxes.minY[j];
+            auto dz = boxes.maxZ[j] - boxes.minZ[j];
+            area += 2.0 * double(dx * dy + dy * dz + dz * dx);
+        }
+    }
+
+    return float(area / double(rootArea));
+}
+
+//-----------------------------------------------------------------------------
+//      トポロジーを変えずにノードの境界を更新します.
+//-----------------------------------------------------------------------------
+template<typename LeafFunc>
+asdx::AABB RefitNodes(BVH::Node* nodes, uint32_t count, const LeafFunc& leafBounds)
+{
+    // 子ノードは必ず親より後ろにあるので, 末尾から辿れば子が先に確定する.
+    std::vector<asdx::AABB> bounds(count);
+    for(auto i=count; i-- > 0;)
+    {
+        auto& node = nodes[i];
+
+        asdx::AABB children[BVH::WIDTH];
+        auto childCount = 0u;
+        while (childCount < BVH::WIDTH && node.Child[childCount] != BVH::EMPTY_REF)
+        {
+            auto ref = node.Child[childCount];
+            children[childCount] = (ref & BVH::LEAF_BIT) ? leafBounds(ref & ~BVH::LEAF_BIT) : bounds[ref];
+            bounds[i].Merge(children[childCount]);
+            childCount++;
+        }
+
+        EncodeNode(node, bounds[i], children, childCount);
+    }
+
+    return (count > 0) ? bounds[0] : asdx::AABB();
+}
+
+//-----------------------------------------------------------------------------
+//      4bitマスクの最下位ビット番号です.
+//-----------------------------------------------------------------------------
+static constexpr uint8_t LOWEST_BIT[16] = { 0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+
+//-----------------------------------------------------------------------------
+//      4bitマスクの立っているビット数です.
+//-----------------------------------------------------------------------------
+static constexpr uint8_t BIT_COUNT[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+//-----------------------------------------------------------------------------
+//      0 の成分を避けて方向ベクトルの逆数を求めます.
+//-----------------------------------------------------------------------------
+inline asdx::Vector3 SafeRcp(const asdx::Vector3& dir)
+{
+    // 0 の成分の逆数は無限大になり, 量子化値 0 や原点と一致する面との積が NaN になる.
+    // NaN は min/max で片側が捨てられスラブ判定が素通りになるので, 符号を保ったまま
+    // 十分小さな値に置き換えてから逆数を取る.
+    auto rcp = [](float value)
+    { return 1.0f / ((fabsf(value) < RCP_EPSILON) ? copysignf(RCP_EPSILON, value) : value); };
+    return asdx::Vector3(rcp(dir.x), rcp(dir.y), rcp(dir.z));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TraceRay structure
+// 走査中に使い回すレイの前計算値です.
+///////////////////////////////////////////////////////////////////////////////
+struct TraceRay
+{
+    asdx::WatertightRay Shear;
+    asdx::Vector3       InvDir;
+    uint32_t            Near[3];    // 手前側の量子化値のノード先頭からのオフセット.
+    uint32_t            Far [3];    // 奥側の量子化値のノード先頭からのオフセット.
+#if ASDX_SIMD
+    __m128  Pos[3];
+    __m128  Inv[3];
+    __m128  TMin;
+#endif
+
+    explicit TraceRay(const asdx::Ray& ray)
+    : Shear (ray)
+    , InvDir(SafeRcp(ray.dir))
+    {
+        // 方向の符号で手前側の面を決めておき, スラブ判定の min/max を省く.
+        const float dir[3] = { ray.dir.x, ray.dir.y, ray.dir.z };
+        const uint32_t lo[3] = { offsetof(BVH::Node, LoX), offsetof(BVH::Node, LoY), offsetof(BVH::Node, LoZ) };
+        const uint32_t hi[3] = { offsetof(BVH::Node, HiX), offsetof(BVH::Node, HiY), offsetof(BVH::Node, HiZ) };
+        for(auto i=0; i<3; ++i)
+        {
+            Near[i] = (dir[i] >= 0.0f) ? lo[i] : hi[i];
+            Far [i] = (dir[i] >= 0.0f) ? hi[i] : lo[i];
+        }
+
+    #if ASDX_SIMD
+        Pos[0] = _mm_set1_ps(ray.pos.x);
+        Pos[1] = _mm_set1_ps(ray.pos.y);
+        Pos[2] = _mm_set1_ps(ray.pos.z);
+        Inv[0] = _mm_set1_ps(InvDir.x);
+        Inv[1] = _mm_set1_ps(InvDir.y);
+        Inv[2] = _mm_set1_ps(InvDir.z);
+        TMin   = _mm_set1_ps(ray.tmin);
+    #endif
+    }
+};
+
+#if ASDX_SIMD
+//-----------------------------------------------------------------------------
+//      量子化された4要素を読み込みます.
+//-----------------------------------------------------------------------------
+inline __m128 LoadQuantized(const BVH::Node& node, uint32_t offset)
+{
+    int32_t bits;
+    memcpy(&bits, reinterpret_cast<const uint8_t*>(&node) + offset, sizeof(bits));
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bits)));
+}
+#endif
+
+//-----------------------------------------------------------------------------
+//      ノードの子とレイの交差判定を行います.
+//-----------------------------------------------------------------------------
+inline uint32_t IntersectNode(const asdx::Ray& ray, const TraceRay& trace, const BVH::Node& node, float* tnear)
+{
+#if ASDX_SIMD
+    // t = (Origin + q * Scale - pos) * inv = q * (Scale * inv) + (Origin - pos) * inv として
+    // 量子化値の読み込みから積和1回で距離を求める. 丸め誤差は量子化を1段外側に広げた分と
+    // 下の係数で吸収する.
+    auto scaleX  = _mm_mul_ps(_mm_set1_ps(node.Scale[0]), trace.Inv[0]);
+    auto scaleY  = _mm_mul_ps(_mm_set1_ps(node.Scale[1]), trace.Inv[1]);
+    auto scaleZ  = _mm_mul_ps(_mm_set1_ps(node.Scale[2]), trace.Inv[2]);
+    auto offsetX = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Origin[0]), trace.Pos[0]), trace.Inv[0]);
+    auto offsetY = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Origin[1]), trace.Pos[1]), trace.Inv[1]);
+    auto offsetZ = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Origin[2]), trace.Pos[2]), trace.Inv[2]);
+
+    auto nx = asdx::simd::MulAdd(LoadQuantized(node, trace.Near[0]), scaleX, offsetX);
+    auto ny = asdx::simd::MulAdd(LoadQuantized(node, trace.Near[1]), scaleY, offsetY);
+    auto nz = asdx::simd::MulAdd(LoadQuantized(node, trace.Near[2]), scaleZ, offsetZ);
+    auto fx = asdx::simd::MulAdd(LoadQuantized(node, trace.Far [0]), scaleX, offsetX);
+    auto fy = asdx::simd::MulAdd(LoadQuantized(node, trace.Far [1]), scaleY, offsetY);
+    auto fz = asdx::simd::MulAdd(LoadQuantized(node, trace.Far [2]), scaleZ, offsetZ);
+
+    auto tn = _mm_mul_ps(_mm_max_ps(_mm_max_ps(nx, ny), nz), _mm_set1_ps(SLAB_NEAR_SCALE));
+    auto tf = _mm_mul_ps(_mm_min_ps(_mm_min_ps(fx, fy), fz), _mm_set1_ps(asdx::detail::SLAB_FAR_SCALE));
+    tn = _mm_max_ps(tn, trace.TMin);
+    tf = _mm_min_ps(tf, _mm_set1_ps(ray.tmax));
+
+    // 空の子は境界に関わらず外す.
+    auto child = _mm_loadu_si128(reinterpret_cast<const __m128i*>(node.Child));
+    auto empty = _mm_castsi128_ps(_mm_cmpeq_epi32(child, _mm_set1_epi32(-1)));
+
+    _mm_storeu_ps(tnear, tn);
+    return uint32_t(_mm_movemask_ps(_mm_andnot_ps(empty, _mm_cmple_ps(tn, tf))));
+#else
+    asdx::AABBx4 boxes;
+    DecodeNode(node, boxes);
+
+    auto mask = asdx::IntersectRayAABB(ray, trace.InvDir, boxes, tnear);
+    for(auto i=0u; i<BVH::WIDTH; ++i)
+    {
+        if (node.Child[i] == BVH::EMPTY_REF)
+        { mask &= ~(1u << i); }
+    }
+    return mask;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      時間ステップ間で補間したノードの子とレイの交差判定を行います.
+//-----------------------------------------------------------------------------
+inline uint32_t IntersectMotionNode
+(
+    const asdx::Ray&    ray,
+    const TraceRay&     trace,
+    const BVH::Node&    start,
+    const BVH::Node&    end,
+    float               f,
+    float*              tnear
+)
+{
+    // 頂点が線形に動くなら, 両端の境界を線形に補間した境界に収まる.
+    // 頂点の補間と丸めが異なる分だけ広げておく.
+    asdx::AABBx4 a, b, boxes;
+    DecodeNode(start, a);
+    DecodeNode(end,   b);
+
+    const auto* pa = reinterpret_cast<const float*>(&a);
+    const auto* pb = reinterpret_cast<const float*>(&b);
+    auto*       pt = reinterpret_cast<float*>(&boxes);
+    const auto half = uint32_t(sizeof(asdx::AABBx4) / sizeof(float) / 2);    // 前半が最小値, 後半が最大値.
+    for(auto i=0u; i<half * 2; ++i)
+    {
+        auto margin = (fabsf(pa[i]) + fabsf(pb[i])) * MOTION_EPSILON;
+        pt[i] = pa[i] + (pb[i] - pa[i]) * f + ((i < half) ? -margin : margin);
+    }
+
+    auto mask = asdx::IntersectRayAABB(ray, trace.InvDir, boxes, tnear);
+    for(auto i=0u; i<BVH::WIDTH; ++i)
+    {
+        if (start.Child[i] == BVH::EMPTY_REF)
+        { mask &= ~(1u << i); }
+    }
+    return mask;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NodeTester structure
+// 静止したノードの判定です.
+///////////////////////////////////////////////////////////////////////////////
+struct NodeTester
+{
+    const BVH::Node*    pNodes;
+    const asdx::Ray&    Ray;
+    const TraceRay&     Trace;
+
+    inline uint32_t operator()(uint32_t index, float* tnear) const
+    { return IntersectNode(Ray, Trace, pNodes[index], tnear); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MotionNodeTester structure
+// 時間ステップの区間の両端のノードを補間して判定します.
+///////////////////////////////////////////////////////////////////////////////
+struct MotionNodeTester
+{
+    const BVH::Node*    pStart;
+    const BVH::Node*    pEnd;
+    float               F;
+    const asdx::Ray&    Ray;
+    const TraceRay&     Trace;
+
+    inline uint32_t operator()(uint32_t index, float* tnear) const
+    { return IntersectMotionNode(Ray, Trace, pStart[index], pEnd[index], F, tnear); }
+};
+
+
+//-----------------------------------------------------------------------------
+//      最近傍の交差を求めて走査します.
+//-----------------------------------------------------------------------------
+template<typename NodeFunc, typename LeafFunc>
+void TraverseClosest(const BVH::Node* nodes, asdx::Ray& ray, const NodeFunc& nodeFunc, const LeafFunc& leafFunc)
+{
+    uint32_t stackRef[STACK_SIZE];
+    float    stackT  [STACK_SIZE];
+    auto     top = 0u;
+
+    uint32_t ref = 0;
+    for(;;)
+    {
+        // 内部ノードを手前の子から降りていく.
+        while ((ref & BVH::LEAF_BIT) == 0)
+        {
+            const auto& node = nodes[ref];
+
+            alignas(16) float tnear[4];
+            auto mask = nodeFunc(ref, tnear);
+            if (mask == 0)
+            { break; }
+
+            if (BIT_COUNT[mask] == 1)
+            {
+                ref = node.Child[LOWEST_BIT[mask]];
+                continue;
+            }
+
+            // 最も手前の子以外は遠い順にスタックに積む.
+            auto nearest = uint32_t(LOWEST_BIT[mask]);
+            for(auto i=nearest + 1; i<BVH::WIDTH; ++i)
+            {
+                if ((mask & (1u << i)) && tnear[i] < tnear[nearest])
+                { nearest = i; }
+            }
+
+            auto base = top;
+            for(auto i=0u; i<BVH::WIDTH; ++i)
+            {
+                if ((mask & (1u << i)) == 0 || i == nearest)
+                { continue; }
+
+                auto j = top++;
+                while (j > base && stackT[j - 1] < tnear[i])
+                {
+                    stackRef[j] = stackRef[j - 1];
+                    stackT  [j] = stackT  [j - 1];
+                    j--;
+                }
+                stackRef[j] = node.Child[i];
+                stackT  [j] = tnear[i];
+            }
+
+            ref = node.Child[nearest];
+        }
+
+        // リーフで ray.tmax が縮む.
+        if (ref & BVH::LEAF_BIT)
+        { leafFunc(ref & ~BVH::LEAF_BIT); }
+
+        // 交差距離より奥にある子は読み飛ばす.
+        while (top > 0 && stackT[top - 1] > ray.tmax)
+        { top--; }
+
+        if (top == 0)
+        { break; }
+
+        ref = stackRef[--top];
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      いずれかの交差が見つかるまで走査します.
+//-----------------------------------------------------------------------------
+template<typename NodeFunc, typename LeafFunc>
+bool TraverseAny(const BVH::Node* nodes, const NodeFunc& nodeFunc, const LeafFunc& leafFunc)
+{
+    uint32_t stack[STACK_SIZE];
+    auto     top = 0u;
+
+    uint32_t ref = 0;
+    for(;;)
+    {
+        while ((ref & BVH::LEAF_BIT) == 0)
+        {
+            const auto& node = nodes[ref];
+
+            alignas(16) float tnear[4];
+            auto mask = nodeFunc(ref, tnear);
+            if (mask == 0)
+            { break; }
+
+            // 順序は問わないので最下位の子へ降り, 残りは積んでおく.
+            ref = node.Child[LOWEST_BIT[mask]];
+            mask &= mask - 1;
+            while (mask)
+            {
+                stack[top++] = node.Child[LOWEST_BIT[mask]];
+                mask &= mask - 1;
+            }
+        }
+
+        if ((ref & BVH::LEAF_BIT) && leafFunc(ref & ~BVH::LEAF_BIT))
+        { return true; }
+
+        if (top == 0)
+        { break; }
+
+        ref = stack[--top];
+    }
+
+    return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Builder class
+///////////////////////////////////////////////////////////////////////////////
+class Builder
+{
+public:
+    //-------------------------------------------------------------------------
+    //      コンストラクタです.
+    //-------------------------------------------------------------------------
+    Builder
+    (
+        std::vector<PrimRef>&       refs,
+        std::vector<BVH::Node>&     nodes,
+        std::vector<BVH::Leaf>*     leaves,
+        const asdx::Vector3* const* vertices,
+        const uint32_t* const*      indices,
+        uint32_t                    threadCount
+    )
+    : m_Refs        (refs)
+    , m_Nodes       (nodes)
+    , m_pLeaves     (leaves)
+    , m_pVertices   (vertices)
+    , m_pIndices    (indices)
+    , m_MaxLeafSize ((leaves != nullptr) ? BVH::MAX_LEAF_SIZE : 1)
+    , m_ThreadCount (threadCount)
+    , m_NodeCount   (0)
+    , m_LeafCount   (0)
+    , m_MaxDepth    (0)
+    , m_TaskCount   (1)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //      ルートから構築します.
+    //-------------------------------------------------------------------------
+    void Build(const Range& range)
+    { CreateNode(range, 1); }
+
+    inline uint32_t GetNodeCount() const { return m_NodeCount; }
+    inline uint32_t GetLeafCount() const { return m_LeafCount; }
+    inline uint32_t GetMaxDepth () const { return m_MaxDepth; }
+
+private:
+    std::vector<PrimRef>&       m_Refs;
+    std::vector<BVH::Node>&     m_Nodes;
+    std::vector<BVH::Leaf>*     m_pLeaves;      // nullptr の場合はリーフを作らず, 子ノード参照にプリミティブ番号を直接入れる.
+    const asdx::Vector3* const* m_pVertices;
+    const uint32_t* const*      m_pIndices;
+    uint32_t                    m_MaxLeafSize;
+    uint32_t                    m_ThreadCount;
+    std::atomic<uint32_t>       m_NodeCount;
+    std::atomic<uint32_t>       m_LeafCount;
+    std::atomic<uint32_t>       m_MaxDepth;
+    std::atomic<uint32_t>       m_TaskCount;
+
+    //-------------------------------------------------------------------------
+    //      内部ノードを生成します.
+    //-------------------------------------------------------------------------
+    uint32_t CreateNode(const Range& range, uint32_t depth)
+    {
+        auto index = m_NodeCount++;
+
+        uint32_t prev = m_MaxDepth;
+        while (prev < depth && !m_MaxDepth.compare_exchange_weak(prev, depth))
+        { /* DO_NOTHING */ }
+
+        // 表面積が最大の子を分割して4分岐にする.
+        Range children[BVH::WIDTH];
+        children[0] = range;
+        auto childCount = 1u;
+        while (childCount < BVH::WIDTH)
+        {
+            auto best     = -1;
+            auto bestArea = -1.0f;
+            for(auto i=0u; i<childCount; ++i)
+            {
+                if (children[i].Count() <= m_MaxLeafSize)
+                { continue; }
+
+                auto area = children[i].Bounds.GetSurfaceArea();
+                if (area > bestArea)
+                {
+                    best     = int(i);
+                    bestArea = area;
+                }
+            }
+
+            if (best < 0)
+            { break; }
+
+            Range left, right;
+            Split(children[best], depth, left, right);
+            children[best]         = left;
+            children[childCount++] = right;
+        }
+
+        // 子を構築.
+        uint32_t              childRefs[BVH::WIDTH];
+        std::future<uint32_t> tasks    [BVH::WIDTH];
+        for(auto i=0u; i<BVH::WIDTH; ++i)
+        {
+            childRefs[i] = BVH::EMPTY_REF;
+            if (i >= childCount)
+            { continue; }
+
+            const auto& child = children[i];
+            if (child.Count() <= m_MaxLeafSize)
+            { childRefs[i] = CreateLeaf(child); }
+            else if (child.Count() >= PARALLEL_TASK_SIZE && AcquireTask())
+            {
+                tasks[i] = std::async(std::launch::async, [this, child, depth]()
+                {
+                    auto result = CreateNode(child, depth + 1);
+                    m_TaskCount--;
+                    return result;
+                });
+            }
+            else
+            { childRefs[i] = CreateNode(child, depth + 1); }
+        }
+
+        for(auto i=0u; i<childCount; ++i)
+        {
+            if (tasks[i].valid())
+            { childRefs[i] = tasks[i].get(); }
+        }
+
+        // 子の境界を量子化.
+        asdx::AABB bounds[BVH::WIDTH];
+        auto& node = m_Nodes[index];
+        for(auto i=0u; i<BVH::WIDTH; ++i)
+        {
+            node.Child[i] = childRefs[i];
+            if (i < childCount)
+            { bounds[i] = children[i].Bounds; }
+        }
+        EncodeNode(node, range.Bounds, bounds, childCount);
+
+        return index;
+    }
+
+    //-------------------------------------------------------------------------
+    //      リーフを生成します.
+    //-------------------------------------------------------------------------
+    uint32_t CreateLeaf(const Range& range)
+    {
+        if (m_pLeaves == nullptr)
+        { return BVH::LEAF_BIT | m_Refs[range.Begin].PrimID; }
+
+        auto  index = m_LeafCount++;
+        auto& leaf  = (*m_pLeaves)[index];
+
+        // 空きレーンは縮退三角形にし, 走査では無効な番号で除外する.
+        memset(&leaf.Triangles, 0, sizeof(leaf.Triangles));
+
+        for(auto i=0u; i<BVH::WIDTH; ++i)
+        {
+            if (i >= range.Count())
+            {
+                leaf.GeomID[i] = BVH::INVALID_ID;
+                leaf.PrimID[i] = BVH::INVALID_ID;
+                continue;
+            }
+
+            const auto& ref      = m_Refs[range.Begin + i];
+            const auto* vertices = m_pVertices[ref.GeomID];
+            const auto* indices  = m_pIndices [ref.GeomID] + ref.PrimID * 3;
+            leaf.Triangles.Set(i, vertices[indices[0]], vertices[indices[1]], vertices[indices[2]]);
+            leaf.GeomID[i] = ref.GeomID;
+            leaf.PrimID[i] = ref.PrimID;
+        }
+
+        return BVH::LEAF_BIT | index;
+    }
+
+    //-------------------------------------------------------------------------
+    //      並列タスクを確保します.
+    //-------------------------------------------------------------------------
+    bool AcquireTask()
+    {
+        auto count = m_TaskCount.load();
+        while (count < m_ThreadCount)
+        {
+            if (m_TaskCount.compare_exchange_weak(count, count + 1))
+            { return true; }
+        }
+        return false;
+    }
+
+    //-------------------------------------------------------------------------
+    //      範囲を2つに分割します.
+    //-------------------------------------------------------------------------
+    void Split(const Range& range, uint32_t depth, Range& left, Range& right)
+    {
+        if (depth < MEDIAN_DEPTH && SplitSAH(range, left, right))
+        { return; }
+
+        SplitMedian(range, left, right);
+    }
+
+    //-------------------------------------------------------------------------
+    //      SAHビニングで分割します.
+    //-------------------------------------------------------------------------
+    bool SplitSAH(const Range& range, Range& left, Range& right)
+    {
+        const auto& cmin = range.Centroids.mini;
+        const auto  ext  = range.Centroids.GetExtent();
+
+        float scale[3];
+        for(auto axis=0u; axis<3; ++axis)
+        {
+            auto e = GetAxis(ext, axis);
+            scale[axis] = (e > 0.0f) ? (float(BIN_COUNT) * 0.99999f / e) : 0.0f;
+        }
+
+        auto binIndex = [&](const PrimRef& ref, uint32_t axis)
+        {
+            auto c = GetAxis(GetCentroid(ref), axis);
+            auto b = int((c - GetAxis(cmin, axis)) * scale[axis]);
+            return uint32_t(asdx::Clamp(b, 0, int(BIN_COUNT - 1)));
+        };
+
+        // ビニング(大きな範囲はスレッドごとに集計してから合算).
+        auto threadCount = (range.Count() >= PARALLEL_BIN_SIZE) ? m_ThreadCount : 1u;
+        std::vector<Bin> bins(threadCount * 3 * BIN_COUNT);
+        ParallelFor(range.Count(), threadCount, [&](uint32_t begin, uint32_t end, uint32_t thread)
+        {
+            auto* local = &bins[thread * 3 * BIN_COUNT];
+            for(auto i=range.Begin + begin; i<range.Begin + end; ++i)
+            {
+                const auto& ref = m_Refs[i];
+                auto centroid = GetCentroid(ref);
+                for(auto axis=0u; axis<3; ++axis)
+                {
+                    auto& bin = local[axis * BIN_COUNT + binIndex(ref, axis)];
+                    bin.Bounds   .Merge(ref.Box);
+                    bin.Centroids.Expand(centroid);
+                    bin.Count++;
+                }
+            }
+        });
+        for(auto t=1u; t<threadCount; ++t)
+        {
+            for(auto i=0u; i<3 * BIN_COUNT; ++i)
+            { bins[i].Merge(bins[t * 3 * BIN_COUNT + i]); }
+        }
+
+        // 左右から掃引して最小コストの分割位置を探す.
+        auto bestCost = FLT_MAX;
+        auto bestAxis = 0u;
+        auto bestBin  = 0u;
+        for(auto axis=0u; axis<3; ++axis)
+        {
+            if (scale[axis] == 0.0f)
+            { continue; }
+
+            const auto* axisBins = &bins[axis * BIN_COUNT];
+
+            float rightCost[BIN_COUNT];
+            Bin   accum;
+            for(auto i=BIN_COUNT - 1; i>0; --i)
+            {
+                accum.Merge(axisBins[i]);
+                rightCost[i] = (accum.Count > 0) ? accum.Bounds.GetSurfaceArea() * float(accum.Count) : 0.0f;
+            }
+
+            accum = Bin();
+            for(auto i=1u; i<BIN_COUNT; ++i)
+            {
+                accum.Merge(axisBins[i - 1]);
+                if (accum.Count == 0 || accum.Count == range.Count())
+                { continue; }
+
+                auto cost = accum.Bounds.GetSurfaceArea() * float(accum.Count) + rightCost[i];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin  = i;
+                }
+            }
+        }
+
+        if (bestCost == FLT_MAX)
+        { return false; }
+
+        auto mid = std::partition(m_Refs.begin() + range.Begin, m_Refs.begin() + range.End, [&](const PrimRef& ref)
+        { return binIndex(ref, bestAxis) < bestBin; });
+
+        Bin l, r;
+        const auto* axisBins = &bins[bestAxis * BIN_COUNT];
+        for(auto i=0u; i<BIN_COUNT; ++i)
+        { (i < bestBin) ? l.Merge(axisBins[i]) : r.Merge(axisBins[i]); }
+
+        auto split = uint32_t(mid - m_Refs.begin());
+        assert(split - range.Begin == l.Count);
+
+        left .Begin     = range.Begin;
+        left .End       = split;
+        left .Bounds    = l.Bounds;
+        left .Centroids = l.Centroids;
+        right.Begin     = split;
+        right.End       = range.End;
+        right.Bounds    = r.Bounds;
+        right.Centroids = r.Centroids;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //      重心の中央値で分割します.
+    //-------------------------------------------------------------------------
+    void SplitMedian(const Range& range, Range& left, Range& right)
+    {
+        auto ext  = range.Centroids.GetExtent();
+        auto axis = (ext.x >= ext.y && ext.x >= ext.z) ? 0u : ((ext.y >= ext.z) ? 1u : 2u);
+        auto mid  = range.Begin + range.Count() / 2;
+
+        std::nth_element(m_Refs.begin() + range.Begin, m_Refs.begin() + mid, m_Refs.begin() + range.End,
+            [axis](const PrimRef& a, const PrimRef& b)
+            { return GetAxis(GetCentroid(a), axis) < GetAxis(GetCentroid(b), axis); });
+
+        left  = ComputeRange(range.Begin, mid);
+        right = ComputeRange(mid, range.End);
+    }
+
+    //-------------------------------------------------------------------------
+    //      範囲の境界を求めます.
+    //-------------------------------------------------------------------------
+    Range ComputeRange(uint32_t begin, uint32_t end) const
+    {
+        Range result;
+        result.Begin = begin;
+        result.End   = end;
+        for(auto i=begin; i<end; ++i)
+        {
+            result.Bounds   .Merge (m_Refs[i].Box);
+            result.Centroids.Expand(GetCentroid(m_Refs[i]));
+        }
+        return result;
+    }
+};
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BVH class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      三角形メッシュを追加します.
+//-----------------------------------------------------------------------------
+uint32_t BVH::AddTriangles(const asdx::Vector3* vertices, const uint32_t* indices, uint32_t triangleCount)
+{
+    Geometry geometry;
+    geometry.pVertices     = vertices;
+    geometry.pIndices      = indices;
+    geometry.TriangleCount = triangleCount;
+    geometry.StepOffset    = INVALID_ID;
+
+    m_Geometries.push_back(geometry);
+    return uint32_t(m_Geometries.size() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      時間ステップごとの頂点を持つ三角形メッシュを追加します.
+//-----------------------------------------------------------------------------
+uint32_t BVH::AddMotionTriangles
+(
+    const asdx::Vector3* const* vertices,
+    uint32_t                    stepCount,
+    const uint32_t*             indices,
+    uint32_t                    triangleCount
+)
+{
+    if (stepCount == 0 || (m_StepCount > 1 && stepCount > 1 && stepCount != m_StepCount))
+    { return INVALID_ID; }
+
+    if (stepCount == 1)
+    { return AddTriangles(vertices[0], indices, triangleCount); }
+
+    Geometry geometry;
+    geometry.pVertices     = vertices[0];
+    geometry.pIndices      = indices;
+    geometry.TriangleCount = triangleCount;
+    geometry.StepOffset    = uint32_t(m_Steps.size());
+
+    m_Steps.insert(m_Steps.end(), vertices, vertices + stepCount);
+    m_StepCount = stepCount;
+
+    m_Geometries.push_back(geometry);
+    return uint32_t(m_Geometries.size() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      ジオメトリの交差を判定する関数を設定します.
+//-----------------------------------------------------------------------------
+void BVH::SetFilter(uint32_t geomID, FilterFunc func, const void* userPtr)
+{
+    if (geomID >= m_Filters.size())
+    {
+        if (func == nullptr)
+        { return; }
+
+        m_Filters.resize(geomID + 1, Filter{ nullptr, nullptr });
+    }
+
+    m_Filters[geomID].Func     = func;
+    m_Filters[geomID].pUserPtr = userPtr;
+}
+
+//-----------------------------------------------------------------------------
+//      BVHを構築します.
+//-----------------------------------------------------------------------------
+bool BVH::Build(uint32_t threadCount)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    if (threadCount == 0)
+    { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+
+    m_Nodes       .clear();
+    m_Leaves      .clear();
+    m_MotionNodes .clear();
+    m_MotionLeaves.clear();
+    m_pNodes    = nullptr;
+    m_pLeaves   = nullptr;
+    m_NodeCount = 0;
+    m_LeafCount = 0;
+    m_Bounds = asdx::AABB();
+    m_Stats  = {};
+
+    // プリミティブ参照を生成. 時間ステップを持つ場合は全時刻の境界を包含させる.
+    std::vector<uint32_t>             offsets (m_Geometries.size() + 1);
+    std::vector<const asdx::Vector3*> vertices(m_Geometries.size());
+    std::vector<const uint32_t*>      indices (m_Geometries.size());
+    for(size_t i=0; i<m_Geometries.size(); ++i)
+    {
+        offsets [i + 1] = offsets[i] + m_Geometries[i].TriangleCount;
+        vertices[i]     = m_Geometries[i].pVertices;
+        indices [i]     = m_Geometries[i].pIndices;
+    }
+
+    const auto count = offsets.back();
+    if (count == 0)
+    { return true; }
+
+    std::vector<PrimRef> refs(count);
+    std::vector<Range>   ranges(threadCount);
+    ParallelFor(count, threadCount, [&](uint32_t begin, uint32_t end, uint32_t thread)
+    {
+        auto& range = ranges[thread];
+        auto  geomID = uint32_t(std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin()) - 1;
+        for(auto i=begin; i<end; ++i)
+        {
+            while (i >= offsets[geomID + 1])
+            { geomID++; }
+
+            auto primID = i - offsets[geomID];
+            auto index  = indices[geomID] + primID * 3;
+
+            auto& ref = refs[i];
+            ref.Box    = asdx::AABB();
+            for(auto step=0u; step<m_StepCount; ++step)
+            {
+                const auto* v = GetVertices(m_Geometries[geomID], step);
+                ref.Box.Expand(v[index[0]]);
+                ref.Box.Expand(v[index[1]]);
+                ref.Box.Expand(v[index[2]]);
+            }
+            ref.GeomID = geomID;
+            ref.PrimID = primID;
+
+            range.Bounds   .Merge (ref.Box);
+            range.Centroids.Expand(GetCentroid(ref));
+        }
+    });
+
+    Range root;
+    root.Begin = 0;
+    root.End   = count;
+    for(const auto& itr : ranges)
+    {
+        root.Bounds   .Merge(itr.Bounds);
+        root.Centroids.Merge(itr.Centroids);
+    }
+    m_Bounds = root.Bounds;
+
+    // 内部ノード数もリーフ数も三角形数を超えない.
+    m_Nodes .resize(count);
+    m_Leaves.resize(count);
+
+    Builder builder(refs, m_Nodes, &m_Leaves, vertices.data(), indices.data(), threadCount);
+    builder.Build(root);
+
+    m_Nodes .resize(builder.GetNodeCount());
+    m_Leaves.resize(builder.GetLeafCount());
+    m_Nodes .shrink_to_fit();
+    m_Leaves.shrink_to_fit();
+
+    m_pNodes    = m_Nodes .data();
+    m_pLeaves   = m_Leaves.data();
+    m_NodeCount = uint32_t(m_Nodes .size());
+    m_LeafCount = uint32_t(m_Leaves.size());
+
+    // 時間ステップを持つ場合は, 全時刻を包含する境界で決めたトポロジーを共有し,
+    // 時間ステップごとのノードの境界とリーフの三角形を詰め直す.
+    if (m_StepCount > 1)
+    {
+        m_MotionNodes .resize(size_t(m_NodeCount) * (m_StepCount - 1));
+        m_MotionLeaves.resize(size_t(m_LeafCount) * (m_StepCount - 1));
+        for(auto step=1u; step<m_StepCount; ++step)
+        { std::copy(m_Nodes.begin(), m_Nodes.end(), m_MotionNodes.begin() + size_t(step - 1) * m_NodeCount); }
+
+        RefitSteps(threadCount);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    m_Stats.NodeCount     = uint32_t(m_Nodes .size());
+    m_Stats.LeafCount     = uint32_t(m_Leaves.size());
+    m_Stats.TriangleCount = count;
+    m_Stats.MaxDepth      = builder.GetMaxDepth();
+    m_Stats.MemorySize    = m_Nodes.size() * sizeof(Node) + m_Leaves.size() * sizeof(Leaf)
+                          + m_MotionNodes.size() * sizeof(Node) + m_MotionLeaves.size() * sizeof(asdx::Trianglex4);
+    m_Stats.NodeCost      = CalcNodeCost(m_pNodes, m_NodeCount, m_Bounds);
+
+    // 縮小時のコピー先も含めた構築中の最大値.
+    m_Stats.PeakMemorySize = refs.size() * sizeof(PrimRef) + size_t(count) * (sizeof(Node) + sizeof(Leaf)) + m_Stats.MemorySize;
+    m_Stats.BuildMsec     = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      トポロジーを変えずに境界を更新します.
+//-----------------------------------------------------------------------------
+bool BVH::Refit(uint32_t threadCount)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    if (threadCount == 0)
+    { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+
+    if (m_NodeCount == 0)
+    { return true; }
+
+    // 外部のメモリを参照している場合は元の頂点が無いので更新できない.
+    if (m_pNodes != m_Nodes.data())
+    { return false; }
+
+    RefitSteps(threadCount);
+
+    m_Stats.NodeCost  = CalcNodeCost(m_pNodes, m_NodeCount, m_Bounds);
+    m_Stats.RefitMsec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      構築済みのデータを複製せずに設定します.
+//-----------------------------------------------------------------------------
+bool BVH::Attach(const View& view)
+{
+    if (view.pNodes == nullptr || view.NodeCount == 0 || (view.pLeaves == nullptr && view.LeafCount != 0))
+    { return false; }
+
+    // 走査中に範囲外を参照しないように, 子ノード参照だけは検証しておく.
+    for(auto i=0u; i<view.NodeCount; ++i)
+    {
+        for(auto j=0u; j<WIDTH; ++j)
+        {
+            auto ref = view.pNodes[i].Child[j];
+            if (ref == EMPTY_REF)
+            { continue; }
+
+            if ((ref & LEAF_BIT) ? ((ref & ~LEAF_BIT) >= view.LeafCount) : (ref <= i || ref >= view.NodeCount))
+            { return false; }
+        }
+    }
+
+    // 交差結果の番号で頂点属性を参照するので, リーフの三角形が登録済みのメッシュを指すことも検証する.
+    for(auto i=0u; i<view.LeafCount; ++i)
+    {
+        const auto& leaf = view.pLeaves[i];
+        for(auto lane=0u; lane<WIDTH; ++lane)
+        {
+            if (leaf.PrimID[lane] == INVALID_ID)
+            { continue; }
+
+            if (leaf.GeomID[lane] >= m_Geometries.size()
+             || leaf.PrimID[lane] >= m_Geometries[leaf.GeomID[lane]].TriangleCount)
+            { return false; }
+        }
+    }
+
+    m_Nodes       .clear();
+    m_Leaves      .clear();
+    m_MotionNodes .clear();
+    m_MotionLeaves.clear();
+    m_Nodes       .shrink_to_fit();
+    m_Leaves      .shrink_to_fit();
+    m_MotionNodes .shrink_to_fit();
+    m_MotionLeaves.shrink_to_fit();
+
+    m_pNodes    = view.pNodes;
+    m_pLeaves   = view.pLeaves;
+    m_NodeCount = view.NodeCount;
+    m_LeafCount = view.LeafCount;
+    m_Bounds    = view.Bounds;
+
+    m_Stats = {};
+    m_Stats.NodeCount  = view.NodeCount;
+    m_Stats.LeafCount  = view.LeafCount;
+    m_Stats.MemorySize = size_t(view.NodeCount) * sizeof(Node) + size_t(view.LeafCount) * sizeof(Leaf);
+    m_Stats.PeakMemorySize = m_Stats.MemorySize;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      構築済みのデータを取得します.
+//-----------------------------------------------------------------------------
+BVH::View BVH::GetView() const
+{
+    if (!m_MotionLeaves.empty())
+    { return View(); }
+
+    View view;
+    view.pNodes    = m_pNodes;
+    view.NodeCount = m_NodeCount;
+    view.pLeaves   = m_pLeaves;
+    view.LeafCount = m_LeafCount;
+    view.Bounds    = m_Bounds;
+    return view;
+}
+
+//-----------------------------------------------------------------------------
+//      全データを破棄します.
+//-----------------------------------------------------------------------------
+void BVH::Clear()
+{
+    m_Geometries  .clear();
+    m_Steps       .clear();
+    m_Nodes       .clear();
+    m_Leaves      .clear();
+    m_MotionNodes .clear();
+    m_MotionLeaves.clear();
+    m_Filters     .clear();
+    m_Geometries  .shrink_to_fit();
+    m_Steps       .shrink_to_fit();
+    m_Nodes       .shrink_to_fit();
+    m_Leaves      .shrink_to_fit();
+    m_MotionNodes .shrink_to_fit();
+    m_MotionLeaves.shrink_to_fit();
+    m_Filters     .shrink_to_fit();
+    m_pNodes    = nullptr;
+    m_pLeaves   = nullptr;
+    m_NodeCount = 0;
+    m_LeafCount = 0;
+    m_StepCount = 1;
+    m_Bounds = asdx::AABB();
+    m_Stats  = {};
+}
+
+//-----------------------------------------------------------------------------
+//      最近傍の交差を求めます.
+//-----------------------------------------------------------------------------
+bool BVH::Intersect(asdx::Ray& ray, BVHHit& hit, float time) const
+{
+    if (m_NodeCount == 0)
+    { return false; }
+
+    TraceRay trace(ray);
+
+    // 時間ステップを持つ場合は, リーフの三角形をレイの時刻で補間して判定する.
+    uint32_t segment = 0;
+    auto     f       = 0.0f;
+    if (!m_MotionLeaves.empty())
+    { f = GetMotionSegment(m_StepCount, time, segment); }
+
+    const Leaf* hitLeaf  = nullptr;
+    auto        hitIndex = 0u;
+    auto        hitLane  = 0u;
+
+    auto leafFunc = [&](uint32_t index)
+    {
+        const auto& leaf = m_pLeaves[index];
+
+        asdx::Trianglex4 temp;
+        const auto& tris = GetTriangles(index, segment, f, temp);
+
+        alignas(16) float t[4], u[4], v[4];
+        auto mask = asdx::IntersectRayTriangleWatertight(ray, trace.Shear, tris, t, u, v);
+        for(auto lane=0u; lane<WIDTH; ++lane)
+        {
+            // 判定関数は手前の候補にだけ呼ぶ. 棄却したレーンは tmax を縮めないので, 奥の三角形を引き続き探す.
+            if ((mask & (1u << lane)) && t[lane] < ray.tmax && leaf.PrimID[lane] != INVALID_ID
+                && !IsRejected(leaf.GeomID[lane], leaf.PrimID[lane], u[lane], v[lane]))
+            {
+                ray.tmax = t[lane];
+                hit.U    = u[lane];
+                hit.V    = v[lane];
+                hitLeaf  = &leaf;
+                hitIndex = index;
+                hitLane  = lane;
+            }
+        }
+    };
+
+    // 時間ステップを持つ場合はノードの境界も区間の両端を補間し, その時刻で重なる部分だけを辿る.
+    if (m_MotionNodes.empty())
+    { TraverseClosest(m_pNodes, ray, NodeTester{ m_pNodes, ray, trace }, leafFunc); }
+    else
+    { TraverseClosest(m_pNodes, ray, MotionNodeTester{ GetNodes(segment), GetNodes(segment + 1), f, ray, trace }, leafFunc); }
+
+    if (hitLeaf == nullptr)
+    { return false; }
+
+    // 幾何法線は Embree と同じく (v1 - v0) x (v2 - v0).
+    asdx::Trianglex4 temp;
+    const auto& tris = GetTriangles(hitIndex, segment, f, temp);
+    asdx::Vector3 v0(tris.v0x[hitLane], tris.v0y[hitLane], tris.v0z[hitLane]);
+    asdx::Vector3 v1(tris.v1x[hitLane], tris.v1y[hitLane], tris.v1z[hitLane]);
+    asdx::Vector3 v2(tris.v2x[hitLane], tris.v2y[hitLane], tris.v2z[hitLane]);
+    hit.Normal = asdx::Vector3::Cross(v1 - v0, v2 - v0);
+    hit.PrimID = hitLeaf->PrimID[hitLane];
+    hit.GeomID = hitLeaf->GeomID[hitLane];
+    hit.InstID = INVALID_ID;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      遮蔽されているかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool BVH::Occluded(const asdx::Ray& ray, float time) const
+{
+    if (m_NodeCount == 0)
+    { return false; }
+
+    TraceRay trace(ray);
+
+    uint32_t segment = 0;
+    auto     f       = 0.0f;
+    if (!m_MotionLeaves.empty())
+    { f = GetMotionSegment(m_StepCount, time, segment); }
+
+    auto leafFunc = [&](uint32_t index)
+    {
+        const auto& leaf = m_pLeaves[index];
+
+        asdx::Trianglex4 temp;
+        const auto& tris = GetTriangles(index, segment, f, temp);
+
+        alignas(16) float t[4], u[4], v[4];
+        auto mask = asdx::IntersectRayTriangleWatertight(ray, trace.Shear, tris, t, u, v);
+        for(auto lane=0u; lane<WIDTH; ++lane)
+        {
+            if ((mask & (1u << lane)) && leaf.PrimID[lane] != INVALID_ID
+                && !IsRejected(leaf.GeomID[lane], leaf.PrimID[lane], u[lane], v[lane]))
+            { return true; }
+        }
+        return false;
+    };
+
+    if (m_MotionNodes.empty())
+    { return TraverseAny(m_pNodes, NodeTester{ m_pNodes, ray, trace }, leafFunc); }
+
+    return TraverseAny(m_pNodes, MotionNodeTester{ GetNodes(segment), GetNodes(segment + 1), f, ray, trace }, leafFunc);
+}
+
+//-----------------------------------------------------------------------------
+//      時間ステップの頂点を取得します.
+//-----------------------------------------------------------------------------
+const asdx::Vector3* BVH::GetVertices(const Geometry& geometry, uint32_t step) const
+{
+    // 時間ステップを持たないメッシュは全時刻で同じ頂点を使う.
+    return (geometry.StepOffset != INVALID_ID) ? m_Steps[geometry.StepOffset + step] : geometry.pVertices;
+}
+
+//-----------------------------------------------------------------------------
+//      リーフの三角形を時間ステップの頂点で詰めます.
+//-----------------------------------------------------------------------------
+void BVH::PackLeaf(const Leaf& leaf, uint32_t step, asdx::Trianglex4& result, asdx::AABB& bounds) const
+{
+    for(auto lane=0u; lane<WIDTH; ++lane)
+    {
+        if (leaf.PrimID[lane] == INVALID_ID)
+        {
+            result.Set(lane, asdx::Vector3(0.0f, 0.0f, 0.0f), asdx::Vector3(0.0f, 0.0f, 0.0f), asdx::Vector3(0.0f, 0.0f, 0.0f));
+            continue;
+        }
+
+        const auto& geometry = m_Geometries[leaf.GeomID[lane]];
+        const auto* vertices = GetVertices(geometry, step);
+        const auto* indices  = geometry.pIndices + leaf.PrimID[lane] * 3;
+        const auto& v0 = vertices[indices[0]];
+        const auto& v1 = vertices[indices[1]];
+        const auto& v2 = vertices[indices[2]];
+        result.Set(lane, v0, v1, v2);
+        bounds.Expand(v0);
+        bounds.Expand(v1);
+        bounds.Expand(v2);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      全時間ステップのリーフの三角形とノードの境界を更新します.
+//-----------------------------------------------------------------------------
+void BVH::RefitSteps(uint32_t threadCount)
+{
+    // リーフの三角形を現在の頂点で詰め直す.
+    const auto stride = size_t(m_StepCount - 1);
+    std::vector<asdx::AABB> leafBounds(size_t(m_LeafCount) * m_StepCount);
+    ParallelFor(m_LeafCount, threadCount, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for(auto i=begin; i<end; ++i)
+        {
+            auto& leaf = m_Leaves[i];
+            auto* box  = &leafBounds[size_t(i) * m_StepCount];
+            PackLeaf(leaf, 0, leaf.Triangles, box[0]);
+
+            for(auto step=1u; step<m_StepCount; ++step)
+            { PackLeaf(leaf, step, m_MotionLeaves[i * stride + step - 1], box[step]); }
+        }
+    });
+
+    // ノードは時間ステップごとに境界を求め, 全体の境界は全時刻を包含させる.
+    m_Bounds = asdx::AABB();
+    for(auto step=0u; step<m_StepCount; ++step)
+    {
+        auto* nodes = (step == 0) ? m_Nodes.data() : &m_MotionNodes[(step - 1) * size_t(m_NodeCount)];
+        m_Bounds.Merge(RefitNodes(nodes, m_NodeCount,
+            [&](uint32_t index) { return leafBounds[size_t(index) * m_StepCount + step]; }));
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      時間ステップのノードを取得します.
+//-----------------------------------------------------------------------------
+const BVH::Node* BVH::GetNodes(uint32_t step) const
+{ return (step == 0) ? m_pNodes : &m_MotionNodes[(step - 1) * size_t(m_NodeCount)]; }
+
+//-----------------------------------------------------------------------------
+//      リーフの三角形を時間ステップの区間内で補間して取得します.
+//-----------------------------------------------------------------------------
+const asdx::Trianglex4& BVH::GetTriangles(uint32_t index, uint32_t segment, float f, asdx::Trianglex4& temp) const
+{
+    if (m_MotionLeaves.empty())
+    { return m_pLeaves[index].Triangles; }
+
+    const auto  stride = size_t(m_StepCount - 1);
+    const auto& a = (segment == 0) ? m_pLeaves[index].Triangles : m_MotionLeaves[index * stride + segment - 1];
+    const auto& b = m_MotionLeaves[index * stride + segment];
+
+    // 共有する頂点は同じ計算で補間されるので, 補間後も水密になる.
+    const auto* pa = reinterpret_cast<const float*>(&a);
+    const auto* pb = reinterpret_cast<const float*>(&b);
+    auto*       pt = reinterpret_cast<float*>(&temp);
+    for(auto i=0u; i<sizeof(asdx::Trianglex4) / sizeof(float); ++i)
+    { pt[i] = pa[i] + (pb[i] - pa[i]) * f; }
+
+    return temp;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// InstanceBVH class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      プロトタイプを追加します.
+//-----------------------------------------------------------------------------
+uint32_t InstanceBVH::AddPrototype(const BVH* bvh)
+{
+    m_Prototypes.push_back(bvh);
+    return uint32_t(m_Prototypes.size() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      インスタンスを追加します.
+//-----------------------------------------------------------------------------
+uint32_t InstanceBVH::AddInstance(uint32_t prototype, const asdx::Matrix& transform, uint32_t id)
+{
+    if (prototype >= m_Prototypes.size())
+    { return BVH::INVALID_ID; }
+
+    Instance instance;
+    instance.Prototype    = prototype;
+    instance.ID           = id;
+    instance.MotionOffset = 0;
+    instance.MotionCount  = 0;
+
+    m_Instances.push_back(instance);
+
+    auto index = uint32_t(m_Instances.size() - 1);
+    SetTransform(index, transform);
+    return index;
+}
+
+//-----------------------------------------------------------------------------
+//      時間ステップごとの変換行列を持つインスタンスを追加します.
+//-----------------------------------------------------------------------------
+uint32_t InstanceBVH::AddMotionInstance
+(
+    uint32_t            prototype,
+    const asdx::Matrix* transforms,
+    uint32_t            stepCount,
+    uint32_t            id
+)
+{
+    if (stepCount == 0)
+    { return BVH::INVALID_ID; }
+
+    auto index = AddInstance(prototype, transforms[0], id);
+    if (index == BVH::INVALID_ID || stepCount == 1)
+    { return index; }
+
+    auto& instance = m_Instances[index];
+    instance.MotionOffset = uint32_t(m_MotionKeys.size());
+    instance.MotionCount  = stepCount;
+
+    for(auto i=0u; i<stepCount; ++i)
+    {
+        MotionKey key;
+        DecomposeTransform(transforms[i], key);
+        m_MotionKeys.push_back(key);
+    }
+
+    return index;
+}
+
+//-----------------------------------------------------------------------------
+//      インスタンスの変換行列を設定します.
+//-----------------------------------------------------------------------------
+bool InstanceBVH::SetTransform(uint32_t index, const asdx::Matrix& transform)
+{
+    if (index >= m_Instances.size())
+    { return false; }
+
+    // 走査ではワールド空間からオブジェクト空間への変換しか使わないので, 逆行列だけ保持する.
+    // 時間ステップを持っていた場合は, 以降はこの行列で静止させる.
+    asdx::Matrix inverse;
+    asdx::Matrix::InvertAffine(transform, inverse);
+
+    auto& instance = m_Instances[index];
+    instance.MotionCount = 0;
+    instance.WorldToObject[ 0] = inverse._11; instance.WorldToObject[ 1] = inverse._12; instance.WorldToObject[ 2] = inverse._13;
+    instance.WorldToObject[ 3] = inverse._21; instance.WorldToObject[ 4] = inverse._22; instance.WorldToObject[ 5] = inverse._23;
+    instance.WorldToObject[ 6] = inverse._31; instance.WorldToObject[ 7] = inverse._32; instance.WorldToObject[ 8] = inverse._33;
+    instance.WorldToObject[ 9] = inverse._41; instance.WorldToObject[10] = inverse._42; instance.WorldToObject[11] = inverse._43;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      インスタンスのBVHを構築します.
+//-----------------------------------------------------------------------------
+bool InstanceBVH::Build(uint32_t threadCount)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    if (threadCount == 0)
+    { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+
+    m_Nodes.clear();
+    m_Stats = {};
+
+    const auto count = uint32_t(m_Instances.size());
+    if (count == 0)
+    { return true; }
+
+    if (m_Instances.size() >= size_t(BVH::LEAF_BIT))
+    { return false; }
+
+    std::vector<PrimRef> refs(count);
+    std::vector<Range>   ranges(threadCount);
+    ParallelFor(count, threadCount, [&](uint32_t begin, uint32_t end, uint32_t thread)
+    {
+        auto& range = ranges[thread];
+        for(auto i=begin; i<end; ++i)
+        {
+            auto& ref = refs[i];
+            ref.Box    = CalcBounds(m_Instances[i]);
+            ref.GeomID = 0;
+            ref.PrimID = i;
+
+            range.Bounds   .Merge (ref.Box);
+            range.Centroids.Expand(GetCentroid(ref));
+        }
+    });
+
+    Range root;
+    root.Begin = 0;
+    root.End   = count;
+    for(const auto& itr : ranges)
+    {
+        root.Bounds   .Merge(itr.Bounds);
+        root.Centroids.Merge(itr.Centroids);
+    }
+    m_Bounds = root.Bounds;
+
+    // リーフは作らず, 子ノード参照にインスタンス番号を直接入れる.
+    m_Nodes.resize(count);
+
+    Builder builder(refs, m_Nodes, nullptr, nullptr, nullptr, threadCount);
+    builder.Build(root);
+
+    m_Nodes.resize(builder.GetNodeCount());
+    m_Nodes.shrink_to_fit();
+
+    auto end = std::chrono::steady_clock::now();
+
+    m_Stats.NodeCount      = uint32_t(m_Nodes.size());
+    m_Stats.LeafCount      = count;
+    m_Stats.MaxDepth       = builder.GetMaxDepth();
+    m_Stats.MemorySize     = m_Nodes.size() * sizeof(BVH::Node) + m_Instances.size() * sizeof(Instance)
+                           + m_MotionKeys.size() * sizeof(MotionKey);
+    m_Stats.NodeCost       = CalcNodeCost(m_Nodes.data(), m_Stats.NodeCount, m_Bounds);
+    m_Stats.PeakMemorySize = refs.size() * sizeof(PrimRef) + size_t(count) * sizeof(BVH::Node) + m_Stats.MemorySize;
+    m_Stats.BuildMsec      = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      トポロジーを変えずに境界を更新します.
+//-----------------------------------------------------------------------------
+bool InstanceBVH::Refit(uint32_t threadCount)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    if (threadCount == 0)
+    { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+
+    // インスタンス数が変わった場合は作り直す.
+    const auto count = uint32_t(m_Instances.size());
+    if (m_Nodes.empty() || m_Stats.LeafCount != count)
+    { return Build(threadCount); }
+
+    std::vector<asdx::AABB> bounds(count);
+    ParallelFor(count, threadCount, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for(auto i=begin; i<end; ++i)
+        { bounds[i] = CalcBounds(m_Instances[i]); }
+    });
+
+    m_Bounds = RefitNodes(m_Nodes.data(), uint32_t(m_Nodes.size()), [&](uint32_t index) { return bounds[index]; });
+
+    m_Stats.NodeCost  = CalcNodeCost(m_Nodes.data(), uint32_t(m_Nodes.size()), m_Bounds);
+    m_Stats.RefitMsec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      全データを破棄します.
+//-----------------------------------------------------------------------------
+void InstanceBVH::Clear()
+{
+    m_Prototypes.clear();
+    m_Instances .clear();
+    m_MotionKeys.clear();
+    m_Nodes     .clear();
+    m_Prototypes.shrink_to_fit();
+    m_Instances .shrink_to_fit();
+    m_MotionKeys.shrink_to_fit();
+    m_Nodes     .shrink_to_fit();
+    m_Bounds = asdx::AABB();
+    m_Stats  = {};
+}
+
+//-----------------------------------------------------------------------------
+//      最近傍の交差を求めます.
+//-----------------------------------------------------------------------------
+bool InstanceBVH::Intersect(asdx::Ray& ray, BVHHit& hit, float time) const
+{
+    if (m_Nodes.empty())
+    { return false; }
+
+    TraceRay trace(ray);
+
+    auto found = false;
+    TraverseClosest(m_Nodes.data(), ray, NodeTester{ m_Nodes.data(), ray, trace }, [&](uint32_t index)
+    {
+        const auto& instance = m_Instances[index];
+
+        // 長さを変えずに変換するので, 距離はそのまま比較できる.
+        auto local = ToObject(instance, ray, time);
+        if (m_Prototypes[instance.Prototype]->Intersect(local, hit, time))
+        {
+            ray.tmax   = local.tmax;
+            hit.InstID = instance.ID;
+            found      = true;
+        }
+    });
+
+    return found;
+}
+
+//-----------------------------------------------------------------------------
+//      遮蔽されているかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool InstanceBVH::Occluded(const asdx::Ray& ray, float time) const
+{
+    if (m_Nodes.empty())
+    { return false; }
+
+    TraceRay trace(ray);
+
+    return TraverseAny(m_Nodes.data(), NodeTester{ m_Nodes.data(), ray, trace }, [&](uint32_t index)
+    {
+        const auto& instance = m_Instances[index];
+        return m_Prototypes[instance.Prototype]->Occluded(ToObject(instance, ray, time), time);
+    });
+}
+
+//-----------------------------------------------------------------------------
+//      インスタンスが参照するプロトタイプ番号を取得します.
+//-----------------------------------------------------------------------------
+uint32_t InstanceBVH::GetPrototype(uint32_t index) const
+{
+    if (index >= m_Instances.size())
+    { return BVH::INVALID_ID; }
+
+    return m_Instances[index].Prototype;
+}
+
+//-----------------------------------------------------------------------------
+//      インスタンスの変換行列を取得します.
+//-----------------------------------------------------------------------------
+bool InstanceBVH::GetTransform(uint32_t index, asdx::Matrix& transform, float time) const
+{
+    if (index >= m_Instances.size())
+    { return false; }
+
+    const auto& instance = m_Instances[index];
+    if (instance.MotionCount == 0)
+    {
+        transform = ToWorld(instance);
+        return true;
+    }
+
+    MotionKey key;
+    InterpolateMotion(&m_MotionKeys[instance.MotionOffset], instance.MotionCount, time, key);
+    ComposeTransform(key, transform);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      インスタンスのワールド空間での境界を求めます.
+//-----------------------------------------------------------------------------
+asdx::AABB InstanceBVH::CalcBounds(const Instance& instance) const
+{
+    const auto& box = m_Prototypes[instance.Prototype]->GetBounds();
+
+    // 空のプロトタイプは原点の点として扱う(交差はしない).
+    asdx::AABB result;
+    if (box.mini.x > box.maxi.x)
+    {
+        result.Expand(asdx::Vector3(0.0f, 0.0f, 0.0f));
+        return result;
+    }
+
+    if (instance.MotionCount != 0)
+    {
+        // 時間ステップを持つ場合は全時刻の境界を包含させる.
+        result = CalcMotionBounds(&m_MotionKeys[instance.MotionOffset], instance.MotionCount, box);
+    }
+    else
+    {
+        // プロトタイプの境界の8頂点をワールド空間に変換して求める.
+        const auto transform = ToWorld(instance);
+        for(auto c=0u; c<8; ++c)
+        {
+            asdx::Vector3 corner(
+                (c & 1) ? box.maxi.x : box.mini.x,
+                (c & 2) ? box.maxi.y : box.mini.y,
+                (c & 4) ? box.maxi.z : box.mini.z);
+            result.Expand(asdx::Vector3::Transform(corner, transform));
+        }
+    }
+
+    // 逆行列を経由した丸め誤差の分だけ広げておく.
+    auto margin = asdx::Vector3::Max(asdx::Vector3::Abs(result.mini), asdx::Vector3::Abs(result.maxi)) * 1e-5f;
+    result.mini -= margin;
+    result.maxi += margin;
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      オブジェクト空間からワールド空間への変換行列を求めます.
+//-----------------------------------------------------------------------------
+asdx::Matrix InstanceBVH::ToWorld(const Instance& instance)
+{
+    const auto* m = instance.WorldToObject;
+    asdx::Matrix inverse(
+        m[0], m[ 1], m[ 2], 0.0f,
+        m[3], m[ 4], m[ 5], 0.0f,
+        m[6], m[ 7], m[ 8], 0.0f,
+        m[9], m[10], m[11], 1.0f);
+
+    asdx::Matrix result;
+    asdx::Matrix::InvertAffine(inverse, result);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      レイをオブジェクト空間に変換します.
+//-----------------------------------------------------------------------------
+asdx::Ray InstanceBVH::ToObject(const Instance& instance, const asdx::Ray& ray, float time) const
+{
+    const auto* m = instance.WorldToObject;
+
+    // 時間ステップを持つ場合は, レイの時刻で補間した変換の逆行列を求める.
+    float motion[12];
+    if (instance.MotionCount != 0)
+    {
+        MotionKey key;
+        InterpolateMotion(&m_MotionKeys[instance.MotionOffset], instance.MotionCount, time, key);
+
+        asdx::Matrix transform, inverse;
+        ComposeTransform(key, transform);
+        asdx::Matrix::InvertAffine(transform, inverse);
+
+        motion[0] = inverse._11; motion[ 1] = inverse._12; motion[ 2] = inverse._13;
+        motion[3] = inverse._21; motion[ 4] = inverse._22; motion[ 5] = inverse._23;
+        motion[6] = inverse._31; motion[ 7] = inverse._32; motion[ 8] = inverse._33;
+        motion[9] = inverse._41; motion[10] = inverse._42; motion[11] = inverse._43;
+        m = motion;
+    }
+
+    const auto& p = ray.pos;
+    const auto& d = ray.dir;
+
+    asdx::Vector3 pos(
+        p.x * m[0] + p.y * m[3] + p.z * m[6] + m[ 9],
+        p.x * m[1] + p.y * m[4] + p.z * m[7] + m[10],
+        p.x * m[2] + p.y * m[5] + p.z * m[8] + m[11]);
+    asdx::Vector3 dir(
+        d.x * m[0] + d.y * m[3] + d.z * m[6],
+        d.x * m[1] + d.y * m[4] + d.z * m[7],
+        d.x * m[2] + d.y * m[5] + d.z * m[8]);
+
+    return asdx::Ray(pos, dir, ray.tmin, ray.tmax);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BoxBVH class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      BVHを構築します.
+//-----------------------------------------------------------------------------
+bool BoxBVH::Build(const asdx::AABB* bounds, uint32_t count, uint32_t threadCount)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    if (threadCount == 0)
+    { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+
+    m_Nodes.clear();
+    m_Bounds = asdx::AABB();
+    m_Stats  = {};
+
+    if (count >= BVH::LEAF_BIT)
+    { return false; }
+
+    // 空の境界は重心が求まらないので, 参照から外す.
+    std::vector<PrimRef> refs;
+    refs.reserve(count);
+
+    Range root;
+    root.Begin = 0;
+    for(auto i=0u; i<count; ++i)
+    {
+        if (bounds[i].IsEmpty())
+        { continue; }
+
+        PrimRef ref;
+        ref.Box    = bounds[i];
+        ref.GeomID = 0;
+        ref.PrimID = i;
+        refs.push_back(ref);
+
+        root.Bounds   .Merge (ref.Box);
+        root.Centroids.Expand(GetCentroid(ref));
+    }
+    root.End = uint32_t(refs.size());
+    if (root.End == 0)
+    { return true; }
+
+    m_Bounds = root.Bounds;
+
+    // リーフは作らず, 子ノード参照にプリミティブ番号を直接入れる.
+    m_Nodes.resize(root.End);
+
+    Builder builder(refs, m_Nodes, nullptr, nullptr, nullptr, threadCount);
+    builder.Build(root);
+
+    m_Nodes.resize(builder.GetNodeCount());
+    m_Nodes.shrink_to_fit();
+
+    auto end = std::chrono::steady_clock::now();
+
+    m_Stats.NodeCount      = uint32_t(m_Nodes.size());
+    m_Stats.LeafCount      = root.End;
+    m_Stats.MaxDepth       = builder.GetMaxDepth();
+    m_Stats.MemorySize     = m_Nodes.size() * sizeof(BVH::Node);
+    m_Stats.NodeCost       = CalcNodeCost(m_Nodes.data(), m_Stats.NodeCount, m_Bounds);
+    m_Stats.PeakMemorySize = refs.size() * sizeof(PrimRef) + size_t(root.End) * sizeof(BVH::Node);
+    m_Stats.BuildMsec      = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      全データを破棄します.
+//-----------------------------------------------------------------------------
+void BoxBVH::Clear()
+{
+    m_Nodes.clear();
+    m_Nodes.shrink_to_fit();
+    m_Bounds = asdx::AABB();
+    m_Stats  = {};
+}
+
+//-----------------------------------------------------------------------------
+//      最近傍の交差を求めます.
+//-----------------------------------------------------------------------------
+bool BoxBVH::Intersect(asdx::Ray& ray, BVHHit& hit, IntersectFunc func, void* userPtr) const
+{
+    if (m_Nodes.empty())
+    { return false; }
+
+    TraceRay trace(ray);
+
+    // 関数が tmax を縮めるので, 以降のノードは縮めた範囲で判定される.
+    auto found = false;
+    TraverseClosest(m_Nodes.data(), ray, NodeTester{ m_Nodes.data(), ray, trace }, [&](uint32_t index)
+    { found |= func(userPtr, index, ray, hit); });
+
+    return found;
+}
+
+//-----------------------------------------------------------------------------
+//      遮蔽されているかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool BoxBVH::Occluded(const asdx::Ray& ray, OccludedFunc func, void* userPtr) const
+{
+    if (m_Nodes.empty())
+    { return false; }
+
+    TraceRay trace(ray);
+
+    return TraverseAny(m_Nodes.data(), NodeTester{ m_Nodes.data(), ray, trace }, [&](uint32_t index)
+    { return func(userPtr, index, ray); });
+}
@@ -0,0 +1,491 @@
+﻿//-----------------------------------------------------------------------------
+// File : curve.cpp
+// Desc : B-Spline Curves.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <curve.h>
+#include <asdxLogger.h>
+#include <algorithm>
+#include <cmath>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+//      一様3次Bスプラインの基底関数を求めます.
+//-----------------------------------------------------------------------------
+inline void EvalBasis(float u, float* w)
+{
+    auto s  = 1.0f - u;
+    auto u2 = u * u;
+    auto u3 = u2 * u;
+    w[0] = s * s * s / 6.0f;
+    w[1] = (3.0f * u3 - 6.0f * u2 + 4.0f) / 6.0f;
+    w[2] = (-3.0f * u3 + 3.0f * u2 + 3.0f * u + 1.0f) / 6.0f;
+    w[3] = u3 / 6.0f;
+}
+
+//-----------------------------------------------------------------------------
+//      一様3次Bスプラインの基底関数の導関数を求めます.
+//-----------------------------------------------------------------------------
+inline void EvalDerivative(float u, float* w)
+{
+    auto s  = 1.0f - u;
+    auto u2 = u * u;
+    w[0] = -0.5f * s * s;
+    w[1] = 0.5f * (3.0f * u2 - 4.0f * u);
+    w[2] = 0.5f * (-3.0f * u2 + 2.0f * u + 1.0f);
+    w[3] = 0.5f * u2;
+}
+
+//-----------------------------------------------------------------------------
+//      セグメントの接線を求めます(正規化しません).
+//-----------------------------------------------------------------------------
+asdx::Vector3 EvalTangent(const asdx::Vector4* p, float u)
+{
+    float w[4];
+    EvalDerivative(u, w);
+
+    asdx::Vector3 result(0.0f, 0.0f, 0.0f);
+    for(auto i=0; i<4; ++i)
+    {
+        result.x += p[i].x * w[i];
+        result.y += p[i].y * w[i];
+        result.z += p[i].z * w[i];
+    }
+
+    // 制御点が重なっていると端で接線が消えるので, 制御点の差で代用する.
+    if (result.LengthSq() <= FLT_MIN)
+    {
+        result = asdx::Vector3(p[2].x - p[1].x, p[2].y - p[1].y, p[2].z - p[1].z);
+        if (result.LengthSq() <= FLT_MIN)
+        { result = asdx::Vector3(p[3].x - p[0].x, p[3].y - p[0].y, p[3].z - p[0].z); }
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      折れ線の頂点での基底関数の値を求めます.
+//-----------------------------------------------------------------------------
+struct BasisTable
+{
+    float Weights[Curves::MAX_PART_COUNT + 1][4];
+
+    BasisTable()
+    {
+        for(auto i=0u; i<=Curves::MAX_PART_COUNT; ++i)
+        { EvalBasis(float(i) / float(Curves::MAX_PART_COUNT), Weights[i]); }
+    }
+
+    const float* operator[] (uint32_t index) const
+    { return Weights[index]; }
+};
+
+const BasisTable BASIS_TABLE;
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Curves class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool Curves::Init
+(
+    CURVE_TYPE              type,
+    const asdx::Vector4*    points,
+    const uint32_t*         pointCounts,
+    uint32_t                strandCount
+)
+{
+    Term();
+
+    if (type != CURVE_TYPE_FLAT && type != CURVE_TYPE_ROUND)
+    {
+        ELOG("Error : Invalid Argument. type = %u", uint32_t(type));
+        return false;
+    }
+
+    if (points == nullptr || pointCounts == nullptr || strandCount == 0)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    uint64_t pointCount   = 0;
+    uint64_t segmentCount = 0;
+    for(auto i=0u; i<strandCount; ++i)
+    {
+        if (pointCounts[i] < MIN_POINT_COUNT)
+        {
+            ELOG("Error : Strand has too few points. strand = %u, count = %u", i, pointCounts[i]);
+            return false;
+        }
+
+        pointCount   += pointCounts[i];
+        segmentCount += pointCounts[i] - 3;
+    }
+
+    if (pointCount > UINT32_MAX)
+    {
+        ELOG("Error : Too many points. count = %llu", (unsigned long long)pointCount);
+        return false;
+    }
+
+    for(uint64_t i=0; i<pointCount; ++i)
+    {
+        if (!(points[i].w >= 0.0f))
+        {
+            ELOG("Error : Invalid radius. point = %llu", (unsigned long long)i);
+            return false;
+        }
+    }
+
+    m_Type = type;
+    m_Points.assign(points, points + pointCount);
+
+    m_Offsets.resize(size_t(strandCount) + 1);
+    m_Segments.reserve(size_t(segmentCount) + 4);
+
+    uint32_t offset = 0;
+    for(auto i=0u; i<strandCount; ++i)
+    {
+        m_Offsets[i] = offset;
+        for(auto j=0u; j<pointCounts[i] - 3; ++j)
+        { m_Segments.push_back(offset + j); }
+
+        offset += pointCounts[i];
+    }
+    m_Offsets[strandCount] = offset;
+    m_SegmentCount = uint32_t(segmentCount);
+
+    // Embree は16バイト単位で読み込むので, 末尾に余白を付けておく.
+    m_Segments.resize(m_Segments.size() + 4, 0);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void Curves::Term()
+{
+    m_Points  .clear();
+    m_Points  .shrink_to_fit();
+    m_Segments.clear();
+    m_Segments.shrink_to_fit();
+    m_Offsets .clear();
+    m_Offsets .shrink_to_fit();
+    m_Coverage.clear();
+    m_Coverage.shrink_to_fit();
+    m_SegmentCount = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      画素の大きさより細い部分を広げます.
+//-----------------------------------------------------------------------------
+uint32_t Curves::WidenToPixel(const asdx::Vector3& eye, float pixelAngle, float minPixelWidth)
+{
+    if (!(pixelAngle > 0.0f) || !(minPixelWidth > 0.0f))
+    { return 0; }
+
+    // 2回目以降は元の半径に戻してから広げ直す.
+    if (m_Coverage.empty())
+    { m_Coverage.resize(m_Points.size(), 1.0f); }
+
+    const auto scale = 0.5f * pixelAngle * minPixelWidth;
+
+    uint32_t count = 0;
+    for(size_t i=0; i<m_Points.size(); ++i)
+    {
+        auto& p = m_Points[i];
+        auto original = p.w * m_Coverage[i];
+        auto minimum  = scale * asdx::Vector3(p.x - eye.x, p.y - eye.y, p.z - eye.z).Length();
+
+        if (original < minimum)
+        {
+            p.w           = minimum;
+            m_Coverage[i] = original / minimum;
+            count++;
+        }
+        else
+        {
+            p.w           = original;
+            m_Coverage[i] = 1.0f;
+        }
+    }
+
+    // 広げた制御点がなければ比は全て 1 なので持たない.
+    if (count == 0)
+    {
+        m_Coverage.clear();
+        m_Coverage.shrink_to_fit();
+    }
+
+    return count;
+}
+
+//-----------------------------------------------------------------------------
+//      セグメントの境界を求めます.
+//-----------------------------------------------------------------------------
+asdx::AABB Curves::GetSegmentBounds(uint32_t segment, uint32_t part, uint32_t partCount) const
+{
+    const auto* p = m_Points.data() + m_Segments[segment];
+
+    // 区間 [u0, u1] の曲線は3次多項式なので, 同じ区間のベジェ制御点の凸包に含まれる.
+    // 半径も u の3次多項式なので, 同じ形のベジェ制御点の最大値を超えない.
+    auto u0 = float(part    ) / float(partCount);
+    auto u1 = float(part + 1) / float(partCount);
+    auto h  = (u1 - u0) / 3.0f;
+
+    float w0[4], w1[4], d0[4], d1[4];
+    EvalBasis(u0, w0);
+    EvalBasis(u1, w1);
+    EvalDerivative(u0, d0);
+    EvalDerivative(u1, d1);
+
+    asdx::Vector4 b[4];
+    b[0] = p[0] * w0[0] + p[1] * w0[1] + p[2] * w0[2] + p[3] * w0[3];
+    b[3] = p[0] * w1[0] + p[1] * w1[1] + p[2] * w1[2] + p[3] * w1[3];
+    b[1] = b[0] + (p[0] * d0[0] + p[1] * d0[1] + p[2] * d0[2] + p[3] * d0[3]) * h;
+    b[2] = b[3] - (p[0] * d1[0] + p[1] * d1[1] + p[2] * d1[2] + p[3] * d1[3]) * h;
+
+    asdx::Vector3 mini( FLT_MAX,  FLT_MAX,  FLT_MAX);
+    asdx::Vector3 maxi(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    auto radius = 0.0f;
+    for(auto i=0; i<4; ++i)
+    {
+        mini.x = std::min(mini.x, b[i].x);
+        mini.y = std::min(mini.y, b[i].y);
+        mini.z = std::min(mini.z, b[i].z);
+        maxi.x = std::max(maxi.x, b[i].x);
+        maxi.y = std::max(maxi.y, b[i].y);
+        maxi.z = std::max(maxi.z, b[i].z);
+        radius = std::max(radius, b[i].w);
+    }
+
+    return asdx::AABB(
+        asdx::Vector3(mini.x - radius, mini.y - radius, mini.z - radius),
+        asdx::Vector3(maxi.x + radius, maxi.y + radius, maxi.z + radius));
+}
+
+//-----------------------------------------------------------------------------
+//      セグメントとの最近傍の交差を求めます.
+//-----------------------------------------------------------------------------
+bool Curves::Intersect(uint32_t segment, asdx::Ray& ray, BVHHit& hit, uint32_t part, uint32_t partCount) const
+{
+    auto t = ray.tmax;
+    auto u = 0.0f;
+    auto v = 0.0f;
+    asdx::Vector3 normal;
+    if (!IntersectSegment(segment, part, partCount, ray, t, u, v, normal))
+    { return false; }
+
+    ray.tmax   = t;
+    hit.Normal = normal;
+    hit.U      = u;
+    hit.V      = v;
+    hit.PrimID = segment;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      セグメントで遮蔽されているかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool Curves::Occluded(uint32_t segment, const asdx::Ray& ray, uint32_t part, uint32_t partCount) const
+{
+    auto t = ray.tmax;
+    auto u = 0.0f;
+    auto v = 0.0f;
+    asdx::Vector3 normal;
+    return IntersectSegment(segment, part, partCount, ray, t, u, v, normal);
+}
+
+//-----------------------------------------------------------------------------
+//      セグメント上の点を求めます.
+//-----------------------------------------------------------------------------
+asdx::Vector4 Curves::Evaluate(uint32_t segment, float u) const
+{
+    const auto* p = m_Points.data() + m_Segments[segment];
+
+    float w[4];
+    EvalBasis(asdx::Saturate(u), w);
+    return p[0] * w[0] + p[1] * w[1] + p[2] * w[2] + p[3] * w[3];
+}
+
+//-----------------------------------------------------------------------------
+//      交差位置の毛の情報を求めます.
+//-----------------------------------------------------------------------------
+bool Curves::GetHit(uint32_t segment, float u, CurveHit& result) const
+{
+    if (segment >= m_SegmentCount)
+    { return false; }
+
+    auto first = m_Segments[segment];
+    const auto* p = m_Points.data() + first;
+    u = asdx::Saturate(u);
+
+    // 毛ごとには先頭の制御点番号しか持たないので, 二分探索で毛を求める.
+    auto itr    = std::upper_bound(m_Offsets.begin(), m_Offsets.end(), first);
+    auto strand = uint32_t(itr - m_Offsets.begin()) - 1;
+    auto count  = m_Offsets[strand + 1] - m_Offsets[strand] - 3;
+
+    float w[4];
+    EvalBasis(u, w);
+
+    result.Strand   = strand;
+    result.U        = (float(first - m_Offsets[strand]) + u) / float(count);
+    result.Tangent  = asdx::Vector3::Normalize(EvalTangent(p, u));
+    result.Radius   = p[0].w * w[0] + p[1].w * w[1] + p[2].w * w[2] + p[3].w * w[3];
+    result.Coverage = 1.0f;
+
+    if (!m_Coverage.empty())
+    {
+        const auto* c = m_Coverage.data() + first;
+        result.Coverage = c[0] * w[0] + c[1] * w[1] + c[2] * w[2] + c[3] * w[3];
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      使用メモリ(バイト)を取得します.
+//-----------------------------------------------------------------------------
+size_t Curves::GetMemorySize() const
+{
+    return m_Points  .capacity() * sizeof(asdx::Vector4)
+         + m_Segments.capacity() * sizeof(uint32_t)
+         + m_Offsets .capacity() * sizeof(uint32_t)
+         + m_Coverage.capacity() * sizeof(float);
+}
+
+//-----------------------------------------------------------------------------
+//      セグメントとの交差を求めます(t は入力時に区間の最大値, 交差時に交差距離です).
+//-----------------------------------------------------------------------------
+bool Curves::IntersectSegment
+(
+    uint32_t            segment,
+    uint32_t            part,
+    uint32_t            partCount,
+    const asdx::Ray&    ray,
+    float&              t,
+    float&              u,
+    float&              v,
+    asdx::Vector3&      normal
+) const
+{
+    const auto* p = m_Points.data() + m_Segments[segment];
+
+    auto length = ray.dir.Length();
+    if (length <= 0.0f)
+    { return false; }
+
+    // 原点をレイの始点, z軸をレイの方向とするレイ空間に制御点を移す.
+    auto dz = ray.dir / length;
+    asdx::Vector3 dx, dy;
+    asdx::CalcONB(dz, dx, dy);
+
+    asdx::Vector4 q[4];
+    auto radius = 0.0f;
+    for(auto i=0; i<4; ++i)
+    {
+        asdx::Vector3 d(p[i].x - ray.pos.x, p[i].y - ray.pos.y, p[i].z - ray.pos.z);
+        q[i] = asdx::Vector4(
+            asdx::Vector3::Dot(d, dx),
+            asdx::Vector3::Dot(d, dy),
+            asdx::Vector3::Dot(d, dz),
+            p[i].w);
+        radius = std::max(radius, p[i].w);
+    }
+
+    // 凸包がレイにかからなければ交差しない.
+    {
+        auto minX = std::min(std::min(q[0].x, q[1].x), std::min(q[2].x, q[3].x));
+        auto maxX = std::max(std::max(q[0].x, q[1].x), std::max(q[2].x, q[3].x));
+        auto minY = std::min(std::min(q[0].y, q[1].y), std::min(q[2].y, q[3].y));
+        auto maxY = std::max(std::max(q[0].y, q[1].y), std::max(q[2].y, q[3].y));
+        auto minZ = std::min(std::min(q[0].z, q[1].z), std::min(q[2].z, q[3].z));
+        auto maxZ = std::max(std::max(q[0].z, q[1].z), std::max(q[2].z, q[3].z));
+        if (minX > radius || maxX < -radius || minY > radius || maxY < -radius
+         || maxZ + radius < ray.tmin * length || minZ - radius > t * length)
+        { return false; }
+    }
+
+    // 担当する区間を折れ線にする. 区間の境界は折れ線の頂点に揃える.
+    auto begin = part * MAX_PART_COUNT / partCount;
+    auto end   = (part + 1) * MAX_PART_COUNT / partCount;
+
+    asdx::Vector4 c[MAX_PART_COUNT + 1];
+    for(auto i=begin; i<=end; ++i)
+    {
+        const auto& w = BASIS_TABLE[i];
+        c[i] = q[0] * w[0] + q[1] * w[1] + q[2] * w[2] + q[3] * w[3];
+    }
+
+    // 折れ線ごとにレイとの最近点を求め, 半径以内なら交差とする.
+    auto found = false;
+    asdx::Vector3 center;
+    for(auto i=begin; i<end; ++i)
+    {
+        const auto& a = c[i];
+        const auto& b = c[i + 1];
+
+        auto abX = b.x - a.x;
+        auto abY = b.y - a.y;
+        auto len2 = abX * abX + abY * abY;
+        auto s = (len2 > 0.0f) ? asdx::Saturate(-(a.x * abX + a.y * abY) / len2) : 0.0f;
+
+        auto qx = a.x + abX * s;
+        auto qy = a.y + abY * s;
+        auto qz = a.z + (b.z - a.z) * s;
+        auto r  = a.w + (b.w - a.w) * s;
+
+        auto d2 = qx * qx + qy * qy;
+        auto r2 = r * r;
+        if (d2 > r2)
+        { continue; }
+
+        // 円形断面なら手前の表面まで戻す.
+        auto depth = qz;
+        if (m_Type == CURVE_TYPE_ROUND)
+        { depth -= sqrtf(r2 - d2); }
+
+        auto hitT = depth / length;
+        if (hitT <= ray.tmin || hitT >= t)
+        { continue; }
+
+        t = hitT;
+        u = (float(i) + s) / float(MAX_PART_COUNT);
+        v = (len2 > 0.0f && r > 0.0f) ? asdx::Clamp((abX * qy - abY * qx) / (sqrtf(len2) * r), -1.0f, 1.0f) : 0.0f;
+        center = asdx::Vector3(qx, qy, qz);
+        found  = true;
+    }
+
+    if (!found)
+    { return false; }
+
+    // 法線は接線に垂直にする. 平らな帯はレイの方を向き, 管は中心線から交差位置へ向かう.
+    auto tangent = EvalTangent(p, u);
+    asdx::Vector3 n = -dz;
+    if (m_Type == CURVE_TYPE_ROUND)
+    {
+        auto offset = dx * -center.x + dy * -center.y + dz * (t * length - center.z);
+        if (offset.LengthSq() > FLT_MIN)
+        { n = offset; }
+    }
+
+    auto tt = asdx::Vector3::Dot(tangent, tangent);
+    if (tt > FLT_MIN)
+    { n -= tangent * (asdx::Vector3::Dot(n, tangent) / tt); }
+
+    normal = (n.LengthSq() > FLT_MIN) ? n : -dz;
+    return true;
+}
@@ -8,7 +8,10 @@
 // Includes
 //-----------------------------------------------------------------------------
 #include <renderer.h>
+#include <accelBench.h>
 #include <asdxLogger.h>
+#include <cstdlib>
+#include <cstring>
 
 
 //-----------------------------------------------------------------------------
@@ -16,15 +19,67 @@
 //-----------------------------------------------------------------------------
 int main(int argc, char** argv)
 {
+    // 加速構造のベンチマーク.
+    //   salty2 -bench [-tris <count>] [-rays <count>] [-strands <count>] [-leaves <count>] [-device <config>]
+    if (argc > 1 && strcmp(argv[1], "-bench") == 0)
+    {
+        AccelBenchDesc bench;
+        for(auto i=2; i<argc; ++i)
+        {
+            if (strcmp(argv[i], "-tris") == 0 && i + 1 < argc)
+            { bench.TriangleCount = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+            else if (strcmp(argv[i], "-rays") == 0 && i + 1 < argc)
+            { bench.RayCount = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+            else if (strcmp(argv[i], "-strands") == 0 && i + 1 < argc)
+            { bench.StrandCount = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+            else if (strcmp(argv[i], "-leaves") == 0 && i + 1 < argc)
+            { bench.LeafCount = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+            else if (strcmp(argv[i], "-device") == 0 && i + 1 < argc)
+            { bench.DeviceConfig = argv[++i]; }
+        }
+
+        return RunAccelBench(bench) ? 0 : -1;
+    }
+
+    // 通常の描画.
+    //   salty2 [-cache <path>] [-dedup] [-frames <count>] [-budget <msec>]
+    const char* sceneCachePath = nullptr;
+    bool        dedupMeshes    = false;
+    uint32_t    frameCount     = 0;
+    double      rebuildBudget  = 0.0;
+    for(auto i=1; i<argc; ++i)
+    {
+        if (strcmp(argv[i], "-cache") == 0 && i + 1 < argc)
+        { sceneCachePath = argv[++i]; }
+        else if (strcmp(argv[i], "-dedup") == 0)
+        { dedupMeshes = true; }
+        else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+        { frameCount = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "-budget") == 0 && i + 1 < argc)
+        { rebuildBudget = strtod(argv[++i], nullptr); }
+    }
+
     Renderer::Desc desc = {};
     desc.Width      = 3840;
     desc.Height     = 2160;
     desc.MaxBounce  = 16;
     desc.Seconds    = 0;
+    desc.SharedMemoryName = "salty2_frame";
+    desc.Backend    = ACCEL_BACKEND_EMBREE;
+    desc.DeviceConfig = nullptr;
+    desc.BuildQuality = RTC_BUILD_QUALITY_MEDIUM;
+    desc.SceneFlags   = (frameCount > 0) ? RTC_SCENE_FLAG_DYNAMIC : RTC_SCENE_FLAG_NONE;
+    desc.SceneCachePath = sceneCachePath;
+    desc.DedupMeshes    = dedupMeshes;
+    desc.RebuildThreshold  = 0.0f;
+    desc.RebuildBudgetMsec = rebuildBudget;
+    desc.ShutterOpen       = 0.0f;
+    desc.ShutterClose      = 1.0f;
+    desc.TessellationCacheSize = 0;
 
     // 起動画面.
     ILOG( "//=================================================================" );
-    ILOG( "//  Renderer : salty2" )
+    ILOG( "//  Renderer : salty2" );
     ILOG( "//  Author   : Pocol" );
     ILOG( "//=================================================================" );
     ILOG( " Configuration : " );
@@ -32,11 +87,28 @@ int main(int argc, char** argv)
     ILOG( "     height     = %u", desc.Height );
     ILOG( "     max bounce = %u", desc.MaxBounce );
     ILOG( "     seconds    = %u", desc.Seconds );
+    ILOG( "     shared mem = %" ASDX_PRIs, (desc.SharedMemoryName != nullptr) ? desc.SharedMemoryName : "(disabled)" );
+    ILOG( "     accel      = %" ASDX_PRIs, GetAccelBackendName(desc.Backend) );
+    ILOG( "     device     = %" ASDX_PRIs, (desc.DeviceConfig != nullptr) ? desc.DeviceConfig : "(default)" );
+    ILOG( "     quality    = %" ASDX_PRIs, GetBuildQualityName(desc.BuildQuality) );
+    ILOG( "     flags      = 0x%x", uint32_t(desc.SceneFlags) );
+    ILOG( "     cache      = %" ASDX_PRIs, (desc.SceneCachePath != nullptr) ? desc.SceneCachePath : "(disabled)" );
+    ILOG( "     dedup      = %" ASDX_PRIs, desc.DedupMeshes ? "on" : "off" );
+    ILOG( "     frames     = %u", frameCount );
+    ILOG( "     budget     = %.2lf ms", desc.RebuildBudgetMsec );
+    ILOG( "     shutter    = [%.2f, %.2f]", desc.ShutterOpen, desc.ShutterClose );
     ILOG( "--------------------------------------------------------------------" );
 
+    // Renderer は OnInit() や OnRayGen() などを純粋仮想関数として持つ基底クラスなので, ここでは生成できない.
+    // 描画はそれらを実装した派生クラスを用意する側で行う. 以下はその呼び出し方の例.
     //Renderer renderer;
     //if (renderer.Init(desc))
-    //{ renderer.Run(); }
+    //{
+    //    if (frameCount > 0)
+    //    { renderer.RunSequence(frameCount); }
+    //    else
+    //    { renderer.Run(); }
+    //}
     //renderer.Term();
 
     return 0;
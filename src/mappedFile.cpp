@@ -0,0 +1,140 @@
+﻿//-----------------------------------------------------------------------------
+// File : mappedFile.cpp
+// Desc : Read-Only Memory Mapped File.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <mappedFile.h>
+#include <asdxLogger.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedFile class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      ファイルをメモリにマップします.
+//-----------------------------------------------------------------------------
+bool MappedFile::Init(const char* path, bool copyOnWrite)
+{
+    Term();
+
+    if (path == nullptr)
+    { return false; }
+
+#if defined(_WIN32)
+    auto file = CreateFileA(
+        path,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        ELOGA("Error : CreateFileA() Failed. path = %s", path);
+        return false;
+    }
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        ELOGA("Error : Invalid File Size. path = %s", path);
+        CloseHandle(file);
+        return false;
+    }
+
+    auto mapping = CreateFileMappingA(file, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        ELOGA("Error : CreateFileMappingA() Failed. path = %s", path);
+        CloseHandle(file);
+        return false;
+    }
+
+    auto ptr = MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+    if (ptr == nullptr)
+    {
+        ELOGA("Error : MapViewOfFile() Failed. path = %s", path);
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_File    = file;
+    m_Mapping = mapping;
+    m_Size    = size_t(size.QuadPart);
+#else
+    auto fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        ELOGA("Error : open() Failed. path = %s", path);
+        return false;
+    }
+
+    struct stat info = {};
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        ELOGA("Error : Invalid File Size. path = %s", path);
+        close(fd);
+        return false;
+    }
+
+    auto ptr = mmap(nullptr, size_t(info.st_size), copyOnWrite ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+    {
+        ELOGA("Error : mmap() Failed. path = %s", path);
+        return false;
+    }
+
+    // 並列に解析するので, 先読みはカーネルに任せる.
+    madvise(ptr, size_t(info.st_size), MADV_WILLNEED);
+
+    m_Size = size_t(info.st_size);
+#endif
+
+    m_pData = static_cast<uint8_t*>(ptr);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      マップを解除します.
+//-----------------------------------------------------------------------------
+void MappedFile::Term()
+{
+    if (m_pData == nullptr)
+    { return; }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(m_pData);
+    CloseHandle(m_Mapping);
+    CloseHandle(m_File);
+#else
+    munmap(m_pData, m_Size);
+#endif
+
+    m_File    = nullptr;
+    m_Mapping = nullptr;
+    m_pData   = nullptr;
+    m_Size    = 0;
+}
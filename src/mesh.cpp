@@ -0,0 +1,1479 @@
+﻿//-----------------------------------------------------------------------------
+// File : mesh.cpp
+// Desc : Mesh Data.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <mesh.h>
+#include <attribute.h>
+#include <mappedFile.h>
+#include <asdxLogger.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Constant Values
+//-----------------------------------------------------------------------------
+static constexpr size_t   MIN_CHUNK_SIZE     = 1024 * 1024;    // テキストを分割する最小サイズ.
+static constexpr uint32_t CHUNKS_PER_THREAD  = 8;              // スレッドあたりの分割数(負荷分散用).
+static constexpr uint32_t PLY_FACE_CHUNK     = 65536;          // バイナリPLYの面を分割する単位.
+static constexpr uint32_t PLY_VERTEX_CHUNK   = 65536;          // バイナリPLYの頂点を分割する単位.
+
+// 10の累乗(double で正確に表せる範囲).
+static constexpr double POW10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+//-----------------------------------------------------------------------------
+// Global Varaibles.
+//-----------------------------------------------------------------------------
+std::atomic<size_t>     g_GeometryMemorySize = {};
+std::atomic<size_t>     g_GeometryMemoryPeak = {};
+
+///////////////////////////////////////////////////////////////////////////////
+// TextChunk structure
+///////////////////////////////////////////////////////////////////////////////
+struct TextChunk
+{
+    const char* Begin;
+    const char* End;
+    size_t      LineOffset;         // 先頭行の通し番号.
+    size_t      VertexOffset;       // 先頭の頂点番号.
+    size_t      TexCoordOffset;     // 先頭のテクスチャ座標番号(OBJ の vt).
+    size_t      NormalOffset;       // 先頭の法線番号(OBJ の vn).
+    size_t      TriangleOffset;     // 先頭の三角形番号.
+    size_t      LineCount;
+    size_t      VertexCount;
+    size_t      TexCoordCount;
+    size_t      NormalCount;
+    size_t      TriangleCount;
+};
+
+//-----------------------------------------------------------------------------
+//      空白文字かどうか判定します.
+//-----------------------------------------------------------------------------
+inline bool IsSpace(char c)
+{ return c == ' ' || c == '\t' || c == '\r'; }
+
+//-----------------------------------------------------------------------------
+//      数字かどうか判定します.
+//-----------------------------------------------------------------------------
+inline bool IsDigit(char c)
+{ return uint32_t(c - '0') < 10; }
+
+//-----------------------------------------------------------------------------
+//      空白を読み飛ばします.
+//-----------------------------------------------------------------------------
+inline const char* SkipSpace(const char* ptr, const char* end)
+{
+    while(ptr < end && IsSpace(*ptr))
+    { ptr++; }
+    return ptr;
+}
+
+//-----------------------------------------------------------------------------
+//      空白以外を読み飛ばします.
+//-----------------------------------------------------------------------------
+inline const char* SkipToken(const char* ptr, const char* end)
+{
+    while(ptr < end && !IsSpace(*ptr))
+    { ptr++; }
+    return ptr;
+}
+
+//-----------------------------------------------------------------------------
+//      行末を探します.
+//-----------------------------------------------------------------------------
+inline const char* FindLineEnd(const char* ptr, const char* end)
+{
+    auto next = static_cast<const char*>(memchr(ptr, '\n', size_t(end - ptr)));
+    return (next != nullptr) ? next : end;
+}
+
+//-----------------------------------------------------------------------------
+//      整数を解析します.
+//-----------------------------------------------------------------------------
+inline bool ParseInt(const char*& ptr, const char* end, int64_t& value)
+{
+    auto p   = ptr;
+    auto neg = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        neg = (*p == '-');
+        p++;
+    }
+
+    if (p >= end || !IsDigit(*p))
+    { return false; }
+
+    int64_t result = 0;
+    while(p < end && IsDigit(*p))
+    {
+        result = result * 10 + (*p - '0');
+        p++;
+    }
+
+    value = neg ? -result : result;
+    ptr   = p;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      浮動小数を解析します(strtod() を使わない高速版).
+//-----------------------------------------------------------------------------
+inline bool ParseFloat(const char*& ptr, const char* end, float& value)
+{
+    auto p   = ptr;
+    auto neg = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        neg = (*p == '-');
+        p++;
+    }
+
+    // 有効数字は19桁まで仮数に積み, 残りは指数で表す.
+    uint64_t mantissa = 0;
+    int      digits   = 0;
+    int      exponent = 0;
+    auto     any      = false;
+
+    while(p < end && IsDigit(*p))
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + uint64_t(*p - '0');
+            digits  += (mantissa != 0) ? 1 : 0;
+        }
+        else
+        { exponent++; }
+        any = true;
+        p++;
+    }
+
+    if (p < end && *p == '.')
+    {
+        p++;
+        while(p < end && IsDigit(*p))
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + uint64_t(*p - '0');
+                digits  += (mantissa != 0) ? 1 : 0;
+                exponent--;
+            }
+            any = true;
+            p++;
+        }
+    }
+
+    if (!any)
+    { return false; }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        auto    q = p + 1;
+        int64_t e = 0;
+        if (ParseInt(q, end, e))
+        {
+            exponent += int(std::max<int64_t>(-1000, std::min<int64_t>(1000, e)));
+            p = q;
+        }
+    }
+
+    // 仮数が 2^53 未満で指数が22以内なら double の1回の演算で正確に求まる.
+    auto result = double(mantissa);
+    if (mantissa != 0)
+    {
+        while(exponent > 22)
+        {
+            result   *= POW10[22];
+            exponent -= 22;
+        }
+        while(exponent < -22)
+        {
+            result   /= POW10[22];
+            exponent += 22;
+        }
+        result = (exponent < 0) ? result / POW10[-exponent] : result * POW10[exponent];
+    }
+
+    value = float(neg ? -result : result);
+    ptr   = p;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      並列に処理します.
+//-----------------------------------------------------------------------------
+template<typename Func>
+void ParallelFor(size_t count, uint32_t threadCount, const Func& func)
+{
+    threadCount = uint32_t(std::min<size_t>(threadCount, count));
+    if (threadCount <= 1)
+    {
+        for(size_t i=0; i<count; ++i)
+        { func(i); }
+        return;
+    }
+
+    // 処理量の偏りを吸収するため, 空いたスレッドから順に取る.
+    std::atomic<size_t> next = {};
+    auto worker = [&]()
+    {
+        for(auto i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        { func(i); }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for(auto i=1u; i<threadCount; ++i)
+    { threads.emplace_back(worker); }
+
+    worker();
+
+    for(auto& itr : threads)
+    { itr.join(); }
+}
+
+//-----------------------------------------------------------------------------
+//      テキストを行境界で分割します.
+//-----------------------------------------------------------------------------
+std::vector<TextChunk> SplitLines(const char* begin, const char* end, uint32_t threadCount)
+{
+    auto size  = size_t(end - begin);
+    auto count = std::max<size_t>(1, std::min<size_t>(size / MIN_CHUNK_SIZE, size_t(threadCount) * CHUNKS_PER_THREAD));
+    auto step  = size / count;
+
+    std::vector<TextChunk> chunks;
+    chunks.reserve(count);
+
+    auto ptr = begin;
+    for(size_t i=0; i<count && ptr < end; ++i)
+    {
+        auto last = (i + 1 == count) ? end : std::max(ptr, begin + step * (i + 1));
+        if (last < end)
+        {
+            last = FindLineEnd(last, end);
+            if (last < end)
+            { last++; }
+        }
+
+        TextChunk chunk = {};
+        chunk.Begin = ptr;
+        chunk.End   = last;
+        chunks.push_back(chunk);
+
+        ptr = last;
+    }
+
+    return chunks;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// OBJ_LINE enum
+///////////////////////////////////////////////////////////////////////////////
+enum OBJ_LINE
+{
+    OBJ_LINE_OTHER,
+    OBJ_LINE_POSITION,      // v
+    OBJ_LINE_TEXCOORD,      // vt
+    OBJ_LINE_NORMAL,        // vn
+    OBJ_LINE_FACE,          // f
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ObjCorner structure
+///////////////////////////////////////////////////////////////////////////////
+struct ObjCorner
+{
+    uint32_t    Position;
+    uint32_t    TexCoord;       // 参照が無ければ UINT32_MAX.
+    uint32_t    Normal;         // 参照が無ければ UINT32_MAX.
+};
+
+//-----------------------------------------------------------------------------
+//      OBJの行の種類を判定し, キーワードを読み飛ばします.
+//-----------------------------------------------------------------------------
+inline OBJ_LINE GetObjLine(const char*& ptr, const char* end)
+{
+    auto p = SkipSpace(ptr, end);
+    auto n = end - p;
+
+    if (n >= 2 && p[0] == 'f' && IsSpace(p[1]))
+    {
+        ptr = p + 1;
+        return OBJ_LINE_FACE;
+    }
+
+    if (n >= 2 && p[0] == 'v' && IsSpace(p[1]))
+    {
+        ptr = p + 1;
+        return OBJ_LINE_POSITION;
+    }
+
+    if (n >= 3 && p[0] == 'v' && IsSpace(p[2]))
+    {
+        ptr = p + 2;
+        if (p[1] == 't') { return OBJ_LINE_TEXCOORD; }
+        if (p[1] == 'n') { return OBJ_LINE_NORMAL; }
+    }
+
+    return OBJ_LINE_OTHER;
+}
+
+//-----------------------------------------------------------------------------
+//      面の頂点("v", "v/vt", "v//vn", "v/vt/vn")を解析します. 参照の無い番号は0にします.
+//-----------------------------------------------------------------------------
+inline bool ParseObjCorner(const char*& ptr, const char* end, int64_t& v, int64_t& vt, int64_t& vn)
+{
+    vt = 0;
+    vn = 0;
+    if (!ParseInt(ptr, end, v))
+    { return false; }
+
+    if (ptr < end && *ptr == '/')
+    {
+        ptr++;
+        if (ptr < end && *ptr != '/' && !ParseInt(ptr, end, vt))
+        { return false; }
+
+        if (ptr < end && *ptr == '/')
+        {
+            ptr++;
+            if (!ParseInt(ptr, end, vn))
+            { return false; }
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      OBJの番号(1始まり, 負の値はその行までの要素数からの相対参照)を解決します.
+//-----------------------------------------------------------------------------
+inline bool ResolveObjIndex(int64_t value, size_t current, size_t count, uint32_t& result)
+{
+    auto id = (value < 0) ? int64_t(current) + value : value - 1;
+    if (value == 0 || id < 0 || id >= int64_t(count))
+    { return false; }
+
+    result = uint32_t(id);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      OBJファイルを読み込みます.
+//-----------------------------------------------------------------------------
+bool LoadOBJ
+(
+    const char*                     path,
+    const MappedFile&               file,
+    Mesh&                           mesh,
+    uint32_t                        threadCount,
+    AlignedArray<asdx::Vector3>&    normals,
+    AlignedArray<asdx::Vector2>&    texcoords
+)
+{
+    auto data   = reinterpret_cast<const char*>(file.GetData());
+    auto chunks = SplitLines(data, data + file.GetSize(), threadCount);
+
+    // 1パス目 : チャンクごとに頂点数と三角形数を数える.
+    ParallelFor(chunks.size(), threadCount, [&](size_t index)
+    {
+        auto& chunk = chunks[index];
+        for(auto ptr = chunk.Begin; ptr < chunk.End;)
+        {
+            auto end = FindLineEnd(ptr, chunk.End);
+            auto p   = ptr;
+            ptr = end + 1;
+
+            switch(GetObjLine(p, end))
+            {
+            case OBJ_LINE_POSITION: chunk.VertexCount++;   break;
+            case OBJ_LINE_TEXCOORD: chunk.TexCoordCount++; break;
+            case OBJ_LINE_NORMAL:   chunk.NormalCount++;   break;
+            case OBJ_LINE_FACE:
+                {
+                    size_t count = 0;
+                    for(p = SkipSpace(p, end); p < end; p = SkipSpace(SkipToken(p, end), end))
+                    { count++; }
+
+                    if (count >= 3)
+                    { chunk.TriangleCount += count - 2; }
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    });
+
+    size_t vertexCount   = 0;
+    size_t texcoordCount = 0;
+    size_t normalCount   = 0;
+    size_t triangleCount = 0;
+    for(auto& chunk : chunks)
+    {
+        chunk.VertexOffset   = vertexCount;
+        chunk.TexCoordOffset = texcoordCount;
+        chunk.NormalOffset   = normalCount;
+        chunk.TriangleOffset = triangleCount;
+        vertexCount   += chunk.VertexCount;
+        texcoordCount += chunk.TexCoordCount;
+        normalCount   += chunk.NormalCount;
+        triangleCount += chunk.TriangleCount;
+    }
+
+    if (vertexCount == 0 || triangleCount == 0 || vertexCount > UINT32_MAX || triangleCount * 3 > UINT32_MAX)
+    {
+        ELOG("Error : Invalid Mesh. path = %" ASDX_PRIs ", vertices = %zu, triangles = %zu", path, vertexCount, triangleCount);
+        return false;
+    }
+
+    // vt, vn が無ければ最終的なサイズで一度だけ確保し, 各チャンクが自分の範囲に直接書き込む.
+    // ある場合は v/vt/vn の組ごとに頂点を分けるので, 一旦ファイルの順に読み込んでから組み立てる.
+    const auto split = (texcoordCount > 0 || normalCount > 0);
+
+    AlignedArray<asdx::Vector3> positions;
+    AlignedArray<asdx::Vector2> sourceTexCoords;
+    AlignedArray<asdx::Vector3> sourceNormals;
+    AlignedArray<ObjCorner>     corners;
+    auto allocated = true;
+    if (split)
+    {
+        allocated &= positions      .Resize(vertexCount);
+        allocated &= sourceTexCoords.Resize(texcoordCount);
+        allocated &= sourceNormals  .Resize(normalCount);
+        allocated &= corners        .Resize(triangleCount * 3);
+    }
+    else
+    {
+        allocated &= mesh.Positions.Resize(vertexCount);
+        allocated &= mesh.Indices  .Resize(triangleCount * 3);
+    }
+
+    if (!allocated)
+    {
+        ELOG("Error : Out of Memory. path = %" ASDX_PRIs, path);
+        return false;
+    }
+
+    // 2パス目 : 値を書き込む.
+    std::atomic<bool> failed        = {};
+    std::atomic<bool> missTexCoord  = {};
+    std::atomic<bool> missNormal    = {};
+    ParallelFor(chunks.size(), threadCount, [&](size_t index)
+    {
+        const auto& chunk = chunks[index];
+        auto vertexIndex   = chunk.VertexOffset;
+        auto texcoordIndex = chunk.TexCoordOffset;
+        auto normalIndex   = chunk.NormalOffset;
+        auto dstPositions  = split ? positions.GetData() : mesh.Positions.GetData();
+        auto dstIndices    = split ? nullptr : mesh.Indices.GetData() + chunk.TriangleOffset * 3;
+        auto dstCorners    = split ? corners.GetData() + chunk.TriangleOffset * 3 : nullptr;
+
+        for(auto ptr = chunk.Begin; ptr < chunk.End && !failed.load(std::memory_order_relaxed);)
+        {
+            auto end = FindLineEnd(ptr, chunk.End);
+            auto p   = ptr;
+            ptr = end + 1;
+
+            switch(GetObjLine(p, end))
+            {
+            case OBJ_LINE_POSITION:
+                {
+                    auto& pos = dstPositions[vertexIndex++];
+                    p = SkipSpace(p, end);
+                    auto ret = ParseFloat(p, end, pos.x);
+                    p = SkipSpace(p, end);
+                    ret &= ParseFloat(p, end, pos.y);
+                    p = SkipSpace(p, end);
+                    ret &= ParseFloat(p, end, pos.z);
+                    if (!ret)
+                    {
+                        ELOG("Error : Invalid Vertex. path = %" ASDX_PRIs ", vertex = %zu", path, vertexIndex - 1);
+                        failed = true;
+                    }
+                }
+                break;
+
+            case OBJ_LINE_TEXCOORD:
+                {
+                    // v は省略できる(w は使わない).
+                    auto& uv = sourceTexCoords[texcoordIndex++];
+                    uv.y = 0.0f;
+                    p = SkipSpace(p, end);
+                    if (!ParseFloat(p, end, uv.x))
+                    {
+                        ELOG("Error : Invalid TexCoord. path = %" ASDX_PRIs ", texcoord = %zu", path, texcoordIndex - 1);
+                        failed = true;
+                        break;
+                    }
+                    p = SkipSpace(p, end);
+                    ParseFloat(p, end, uv.y);
+                }
+                break;
+
+            case OBJ_LINE_NORMAL:
+                {
+                    auto& n = sourceNormals[normalIndex++];
+                    p = SkipSpace(p, end);
+                    auto ret = ParseFloat(p, end, n.x);
+                    p = SkipSpace(p, end);
+                    ret &= ParseFloat(p, end, n.y);
+                    p = SkipSpace(p, end);
+                    ret &= ParseFloat(p, end, n.z);
+                    if (!ret)
+                    {
+                        ELOG("Error : Invalid Normal. path = %" ASDX_PRIs ", normal = %zu", path, normalIndex - 1);
+                        failed = true;
+                    }
+                }
+                break;
+
+            case OBJ_LINE_FACE:
+                {
+                    ObjCorner first = {};
+                    ObjCorner prev  = {};
+                    size_t    count = 0;
+
+                    for(p = SkipSpace(p, end); p < end; p = SkipSpace(SkipToken(p, end), end))
+                    {
+                        int64_t v, vt, vn;
+                        auto    q = p;
+                        ObjCorner corner = { 0, UINT32_MAX, UINT32_MAX };
+
+                        auto ret = ParseObjCorner(q, end, v, vt, vn);
+                        ret = ret && ResolveObjIndex(v, vertexIndex, vertexCount, corner.Position);
+                        ret = ret && (vt == 0 || ResolveObjIndex(vt, texcoordIndex, texcoordCount, corner.TexCoord));
+                        ret = ret && (vn == 0 || ResolveObjIndex(vn, normalIndex,   normalCount,   corner.Normal));
+                        if (!ret)
+                        {
+                            ELOG("Error : Invalid Index. path = %" ASDX_PRIs ", line = \"%.*s\"", path, int(end - p), p);
+                            failed = true;
+                            break;
+                        }
+
+                        if (corner.TexCoord == UINT32_MAX)
+                        { missTexCoord.store(true, std::memory_order_relaxed); }
+                        if (corner.Normal == UINT32_MAX)
+                        { missNormal.store(true, std::memory_order_relaxed); }
+
+                        if (count == 0)
+                        { first = corner; }
+                        else if (count >= 2)
+                        {
+                            if (split)
+                            {
+                                *(dstCorners++) = first;
+                                *(dstCorners++) = prev;
+                                *(dstCorners++) = corner;
+                            }
+                            else
+                            {
+                                *(dstIndices++) = first .Position;
+                                *(dstIndices++) = prev  .Position;
+                                *(dstIndices++) = corner.Position;
+                            }
+                        }
+
+                        prev = corner;
+                        count++;
+                    }
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+    });
+
+    if (failed || !split)
+    { return !failed; }
+
+    // 一部の面にしか無い属性は使わない(頂点ごとに揃っていないと補間できない).
+    const auto hasTexCoord = (texcoordCount > 0 && !missTexCoord);
+    const auto hasNormal   = (normalCount   > 0 && !missNormal);
+    if (texcoordCount > 0 && !hasTexCoord)
+    { WLOG("Warning : Some Faces Have No TexCoords. path = %" ASDX_PRIs ", texcoords are ignored.", path); }
+    if (normalCount > 0 && !hasNormal)
+    { WLOG("Warning : Some Faces Have No Normals. path = %" ASDX_PRIs ", normals are generated.", path); }
+
+    // 位置ごとに属性の組が異なる頂点を連結リストで辿り, v/vt/vn の組ごとに頂点を1つ作る.
+    const auto cornerCount = corners.GetCount();
+    AlignedArray<uint32_t> heads;       // 位置ごとの先頭の頂点番号です.
+    AlignedArray<uint32_t> nexts;       // 同じ位置を持つ次の頂点番号です.
+    AlignedArray<uint32_t> origins;     // 頂点ごとの最初の参照元(corners の番号)です.
+    if (!heads  .Resize(vertexCount)
+     || !nexts  .Resize(cornerCount)
+     || !origins.Resize(cornerCount)
+     || !mesh.Indices.Resize(cornerCount))
+    {
+        ELOG("Error : Out of Memory. path = %" ASDX_PRIs, path);
+        return false;
+    }
+    std::fill(heads.GetData(), heads.GetData() + vertexCount, UINT32_MAX);
+
+    uint32_t uniqueCount = 0;
+    for(size_t i=0; i<cornerCount; ++i)
+    {
+        const auto& corner = corners[i];
+
+        auto id = heads[corner.Position];
+        while(id != UINT32_MAX)
+        {
+            const auto& other = corners[origins[id]];
+            if ((!hasTexCoord || other.TexCoord == corner.TexCoord)
+             && (!hasNormal   || other.Normal   == corner.Normal))
+            { break; }
+            id = nexts[id];
+        }
+
+        if (id == UINT32_MAX)
+        {
+            id = uniqueCount++;
+            origins[id] = uint32_t(i);
+            nexts  [id] = heads[corner.Position];
+            heads[corner.Position] = id;
+        }
+
+        mesh.Indices[i] = id;
+    }
+
+    if (!mesh.Positions.Resize(uniqueCount)
+     || !normals  .Resize(hasNormal   ? uniqueCount : 0)
+     || !texcoords.Resize(hasTexCoord ? uniqueCount : 0))
+    {
+        ELOG("Error : Out of Memory. path = %" ASDX_PRIs, path);
+        return false;
+    }
+
+    for(auto i=0u; i<uniqueCount; ++i)
+    {
+        const auto& corner = corners[origins[i]];
+        mesh.Positions[i] = positions[corner.Position];
+        if (hasNormal)
+        { normals[i] = sourceNormals[corner.Normal]; }
+        if (hasTexCoord)
+        { texcoords[i] = sourceTexCoords[corner.TexCoord]; }
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PLY_FORMAT enum
+///////////////////////////////////////////////////////////////////////////////
+enum PLY_FORMAT
+{
+    PLY_FORMAT_ASCII,
+    PLY_FORMAT_BINARY_LE,
+    PLY_FORMAT_BINARY_BE,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PLY_TYPE enum
+///////////////////////////////////////////////////////////////////////////////
+enum PLY_TYPE
+{
+    PLY_TYPE_INVALID,
+    PLY_TYPE_INT8,
+    PLY_TYPE_UINT8,
+    PLY_TYPE_INT16,
+    PLY_TYPE_UINT16,
+    PLY_TYPE_INT32,
+    PLY_TYPE_UINT32,
+    PLY_TYPE_FLOAT32,
+    PLY_TYPE_FLOAT64,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PlyProperty structure
+///////////////////////////////////////////////////////////////////////////////
+struct PlyProperty
+{
+    std::string Name;
+    PLY_TYPE    Type;           // 値の型(リストの場合は要素の型).
+    PLY_TYPE    CountType;      // リストの要素数の型(リストでなければ PLY_TYPE_INVALID).
+    uint32_t    Offset;         // 要素先頭からのオフセット(固定長の場合のみ有効).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PlyElement structure
+///////////////////////////////////////////////////////////////////////////////
+struct PlyElement
+{
+    std::string                 Name;
+    size_t                      Count;
+    std::vector<PlyProperty>    Properties;
+    uint32_t                    Stride;     // 固定長の場合のサイズ(リストを含む場合は0).
+};
+
+//-----------------------------------------------------------------------------
+//      PLYの型を取得します.
+//-----------------------------------------------------------------------------
+PLY_TYPE GetPlyType(const std::string& name)
+{
+    if (name == "char"   || name == "int8")    { return PLY_TYPE_INT8; }
+    if (name == "uchar"  || name == "uint8")   { return PLY_TYPE_UINT8; }
+    if (name == "short"  || name == "int16")   { return PLY_TYPE_INT16; }
+    if (name == "ushort" || name == "uint16")  { return PLY_TYPE_UINT16; }
+    if (name == "int"    || name == "int32")   { return PLY_TYPE_INT32; }
+    if (name == "uint"   || name == "uint32")  { return PLY_TYPE_UINT32; }
+    if (name == "float"  || name == "float32") { return PLY_TYPE_FLOAT32; }
+    if (name == "double" || name == "float64") { return PLY_TYPE_FLOAT64; }
+    return PLY_TYPE_INVALID;
+}
+
+//-----------------------------------------------------------------------------
+//      PLYの型のサイズを取得します.
+//-----------------------------------------------------------------------------
+inline uint32_t GetPlyTypeSize(PLY_TYPE type)
+{
+    static const uint32_t SIZES[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+    return SIZES[type];
+}
+
+//-----------------------------------------------------------------------------
+//      バイナリPLYの値を読み込みます.
+//-----------------------------------------------------------------------------
+inline double ReadPlyValue(const uint8_t* ptr, PLY_TYPE type, bool swap)
+{
+    uint8_t bytes[8];
+    auto size = GetPlyTypeSize(type);
+    for(auto i=0u; i<size; ++i)
+    { bytes[i] = ptr[swap ? (size - 1 - i) : i]; }
+
+    switch(type)
+    {
+    case PLY_TYPE_INT8:     { int8_t   v; memcpy(&v, bytes, 1); return double(v); }
+    case PLY_TYPE_UINT8:    { uint8_t  v; memcpy(&v, bytes, 1); return double(v); }
+    case PLY_TYPE_INT16:    { int16_t  v; memcpy(&v, bytes, 2); return double(v); }
+    case PLY_TYPE_UINT16:   { uint16_t v; memcpy(&v, bytes, 2); return double(v); }
+    case PLY_TYPE_INT32:    { int32_t  v; memcpy(&v, bytes, 4); return double(v); }
+    case PLY_TYPE_UINT32:   { uint32_t v; memcpy(&v, bytes, 4); return double(v); }
+    case PLY_TYPE_FLOAT32:  { float    v; memcpy(&v, bytes, 4); return double(v); }
+    case PLY_TYPE_FLOAT64:  { double   v; memcpy(&v, bytes, 8); return v; }
+    default:                return 0.0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      PLYのヘッダを解析します.
+//-----------------------------------------------------------------------------
+bool ParsePlyHeader
+(
+    const char*                 path,
+    const MappedFile&           file,
+    PLY_FORMAT&                 format,
+    std::vector<PlyElement>&    elements,
+    size_t&                     bodyOffset
+)
+{
+    auto data = reinterpret_cast<const char*>(file.GetData());
+    auto end  = data + file.GetSize();
+
+    auto ptr = data;
+    auto first = true;
+    for(;;)
+    {
+        if (ptr >= end)
+        {
+            ELOG("Error : end_header Not Found. path = %" ASDX_PRIs, path);
+            return false;
+        }
+
+        auto lineEnd = FindLineEnd(ptr, end);
+
+        // 行を空白で区切る.
+        std::vector<std::string> tokens;
+        for(auto p = SkipSpace(ptr, lineEnd); p < lineEnd; p = SkipSpace(p, lineEnd))
+        {
+            auto q = SkipToken(p, lineEnd);
+            tokens.emplace_back(p, q);
+            p = q;
+        }
+        ptr = (lineEnd < end) ? lineEnd + 1 : end;
+
+        if (first)
+        {
+            if (tokens.empty() || tokens[0] != "ply")
+            {
+                ELOG("Error : Invalid PLY Magic. path = %" ASDX_PRIs, path);
+                return false;
+            }
+            first = false;
+            continue;
+        }
+
+        if (tokens.empty() || tokens[0] == "comment" || tokens[0] == "obj_info")
+        { continue; }
+
+        if (tokens[0] == "end_header")
+        { break; }
+
+        if (tokens[0] == "format" && tokens.size() >= 2)
+        {
+            if (tokens[1] == "ascii")
+            { format = PLY_FORMAT_ASCII; }
+            else if (tokens[1] == "binary_little_endian")
+            { format = PLY_FORMAT_BINARY_LE; }
+            else if (tokens[1] == "binary_big_endian")
+            { format = PLY_FORMAT_BINARY_BE; }
+            else
+            {
+                ELOG("Error : Unknown PLY Format. path = %" ASDX_PRIs ", format = %" ASDX_PRIs, path, tokens[1].c_str());
+                return false;
+            }
+        }
+        else if (tokens[0] == "element" && tokens.size() >= 3)
+        {
+            PlyElement element;
+            element.Name   = tokens[1];
+            element.Count  = size_t(strtoull(tokens[2].c_str(), nullptr, 10));
+            element.Stride = 0;
+            elements.push_back(element);
+        }
+        else if (tokens[0] == "property" && !elements.empty())
+        {
+            PlyProperty prop;
+            prop.Offset = 0;
+            if (tokens.size() >= 5 && tokens[1] == "list")
+            {
+                prop.CountType = GetPlyType(tokens[2]);
+                prop.Type      = GetPlyType(tokens[3]);
+                prop.Name      = tokens[4];
+                if (prop.CountType == PLY_TYPE_INVALID)
+                {
+                    ELOG("Error : Unknown PLY Type. path = %" ASDX_PRIs ", type = %" ASDX_PRIs, path, tokens[2].c_str());
+                    return false;
+                }
+            }
+            else if (tokens.size() >= 3)
+            {
+                prop.CountType = PLY_TYPE_INVALID;
+                prop.Type      = GetPlyType(tokens[1]);
+                prop.Name      = tokens[2];
+            }
+            else
+            { continue; }
+
+            if (prop.Type == PLY_TYPE_INVALID)
+            {
+                ELOG("Error : Unknown PLY Type. path = %" ASDX_PRIs, path);
+                return false;
+            }
+
+            elements.back().Properties.push_back(prop);
+        }
+    }
+
+    // 固定長の要素はストライドとオフセットを求めておく.
+    for(auto& element : elements)
+    {
+        uint32_t offset = 0;
+        auto     fixed  = true;
+        for(auto& prop : element.Properties)
+        {
+            if (prop.CountType != PLY_TYPE_INVALID)
+            {
+                fixed = false;
+                break;
+            }
+            prop.Offset = offset;
+            offset += GetPlyTypeSize(prop.Type);
+        }
+        element.Stride = fixed ? offset : 0;
+    }
+
+    bodyOffset = size_t(ptr - data);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      PLYファイルを読み込みます.
+//-----------------------------------------------------------------------------
+bool LoadPLY
+(
+    const char*                 path,
+    const MappedFile&           file,
+    Mesh&                       mesh,
+    uint32_t                    threadCount,
+    AlignedArray<asdx::Vector3>&    normals,
+    AlignedArray<asdx::Vector2>&    texcoords
+)
+{
+    auto format     = PLY_FORMAT_ASCII;
+    auto bodyOffset = size_t(0);
+    std::vector<PlyElement> elements;
+    if (!ParsePlyHeader(path, file, format, elements, bodyOffset))
+    { return false; }
+
+    // 頂点座標と面インデックスの位置を調べる.
+    auto vertexElement = SIZE_MAX;
+    auto faceElement   = SIZE_MAX;
+    uint32_t propX = UINT32_MAX, propY = UINT32_MAX, propZ = UINT32_MAX, propIndex = UINT32_MAX;
+    uint32_t propNX = UINT32_MAX, propNY = UINT32_MAX, propNZ = UINT32_MAX, propU = UINT32_MAX, propV = UINT32_MAX;
+    for(size_t i=0; i<elements.size(); ++i)
+    {
+        const auto& element = elements[i];
+        for(auto j=0u; j<uint32_t(element.Properties.size()); ++j)
+        {
+            const auto& prop = element.Properties[j];
+            if (element.Name == "vertex")
+            {
+                vertexElement = i;
+                if      (prop.Name == "x")  { propX  = j; }
+                else if (prop.Name == "y")  { propY  = j; }
+                else if (prop.Name == "z")  { propZ  = j; }
+                else if (prop.Name == "nx") { propNX = j; }
+                else if (prop.Name == "ny") { propNY = j; }
+                else if (prop.Name == "nz") { propNZ = j; }
+                else if (prop.Name == "u" || prop.Name == "s" || prop.Name == "texture_u" || prop.Name == "texture_s") { propU = j; }
+                else if (prop.Name == "v" || prop.Name == "t" || prop.Name == "texture_v" || prop.Name == "texture_t") { propV = j; }
+            }
+            else if (element.Name == "face")
+            {
+                faceElement = i;
+                if (prop.CountType != PLY_TYPE_INVALID && (prop.Name == "vertex_indices" || prop.Name == "vertex_index"))
+                { propIndex = j; }
+            }
+        }
+    }
+
+    if (vertexElement == SIZE_MAX || faceElement == SIZE_MAX
+     || propX == UINT32_MAX || propY == UINT32_MAX || propZ == UINT32_MAX || propIndex == UINT32_MAX)
+    {
+        ELOG("Error : PLY Has No Triangle Mesh. path = %" ASDX_PRIs, path);
+        return false;
+    }
+
+    const auto& vertex      = elements[vertexElement];
+    const auto& face        = elements[faceElement];
+    const auto  vertexCount = vertex.Count;
+    if (vertexCount == 0 || vertexCount > UINT32_MAX)
+    {
+        ELOG("Error : Invalid Vertex Count. path = %" ASDX_PRIs ", count = %zu", path, vertexCount);
+        return false;
+    }
+
+    // 法線とテクスチャ座標は量子化する前に範囲を調べるので, 一時配列に読み込む.
+    // 一時配列もジオメトリ用メモリから確保し, 読み込み中の最大使用量に含める.
+    const auto hasNormal   = (propNX != UINT32_MAX && propNY != UINT32_MAX && propNZ != UINT32_MAX);
+    const auto hasTexCoord = (propU  != UINT32_MAX && propV  != UINT32_MAX);
+    if (!normals  .Resize(hasNormal   ? vertexCount : 0)
+     || !texcoords.Resize(hasTexCoord ? vertexCount : 0))
+    {
+        ELOG("Error : Out of Memory. path = %" ASDX_PRIs ", vertices = %zu", path, vertexCount);
+        return false;
+    }
+    std::fill(normals  .GetData(), normals  .GetData() + normals  .GetCount(), asdx::Vector3(0.0f, 0.0f, 0.0f));
+    std::fill(texcoords.GetData(), texcoords.GetData() + texcoords.GetCount(), asdx::Vector2(0.0f, 0.0f));
+
+    std::atomic<bool> failed = {};
+
+    if (format == PLY_FORMAT_ASCII)
+    {
+        auto data   = reinterpret_cast<const char*>(file.GetData());
+        auto chunks = SplitLines(data + bodyOffset, data + file.GetSize(), threadCount);
+
+        // 各要素が始まる行番号.
+        std::vector<size_t> firstLine(elements.size() + 1);
+        for(size_t i=0; i<elements.size(); ++i)
+        { firstLine[i + 1] = firstLine[i] + elements[i].Count; }
+
+        const auto vertexBegin = firstLine[vertexElement];
+        const auto faceBegin   = firstLine[faceElement];
+        const auto faceEnd     = firstLine[faceElement + 1];
+
+        // 1パス目 : 行数を数える.
+        ParallelFor(chunks.size(), threadCount, [&](size_t index)
+        {
+            auto& chunk = chunks[index];
+            for(auto ptr = chunk.Begin; ptr < chunk.End; ptr = FindLineEnd(ptr, chunk.End) + 1)
+            { chunk.LineCount++; }
+        });
+
+        size_t lineCount = 0;
+        for(auto& chunk : chunks)
+        {
+            chunk.LineOffset = lineCount;
+            lineCount += chunk.LineCount;
+        }
+
+        // 面の各行を解析して頂点番号の並びを返す.
+        auto parseFace = [&](const char* p, const char* end, auto&& func)
+        {
+            for(auto j=0u; j<uint32_t(face.Properties.size()); ++j)
+            {
+                const auto& prop = face.Properties[j];
+                p = SkipSpace(p, end);
+                if (prop.CountType == PLY_TYPE_INVALID)
+                {
+                    p = SkipToken(p, end);
+                    continue;
+                }
+
+                int64_t count = 0;
+                if (!ParseInt(p, end, count) || count < 0)
+                { return false; }
+
+                for(int64_t k=0; k<count; ++k)
+                {
+                    p = SkipSpace(p, end);
+                    if (j == propIndex)
+                    {
+                        int64_t value = 0;
+                        if (!ParseInt(p, end, value) || value < 0 || value >= int64_t(vertexCount))
+                        { return false; }
+                        func(uint32_t(value), k);
+                    }
+                    else
+                    { p = SkipToken(p, end); }
+                }
+            }
+            return true;
+        };
+
+        // 2パス目 : 面の三角形数を数える.
+        ParallelFor(chunks.size(), threadCount, [&](size_t index)
+        {
+            auto& chunk = chunks[index];
+            auto  line  = chunk.LineOffset;
+            for(auto ptr = chunk.Begin; ptr < chunk.End; ++line)
+            {
+                auto end = FindLineEnd(ptr, chunk.End);
+                if (faceBegin <= line && line < faceEnd)
+                {
+                    int64_t count = 0;
+                    auto ret = parseFace(ptr, end, [&](uint32_t, int64_t k) { count = k + 1; });
+                    if (!ret)
+                    {
+                        ELOG("Error : Invalid Face. path = %" ASDX_PRIs ", face = %zu", path, line - faceBegin);
+                        failed = true;
+                        return;
+                    }
+                    if (count >= 3)
+                    { chunk.TriangleCount += size_t(count - 2); }
+                }
+                ptr = end + 1;
+            }
+        });
+        if (failed)
+        { return false; }
+
+        size_t triangleCount = 0;
+        for(auto& chunk : chunks)
+        {
+            chunk.TriangleOffset = triangleCount;
+            triangleCount += chunk.TriangleCount;
+        }
+
+        if (triangleCount == 0 || triangleCount * 3 > UINT32_MAX)
+        {
+            ELOG("Error : Invalid Triangle Count. path = %" ASDX_PRIs ", count = %zu", path, triangleCount);
+            return false;
+        }
+
+        if (!mesh.Positions.Resize(vertexCount) || !mesh.Indices.Resize(triangleCount * 3))
+        {
+            ELOG("Error : Out of Memory. path = %" ASDX_PRIs, path);
+            return false;
+        }
+
+        // 3パス目 : 値を書き込む.
+        ParallelFor(chunks.size(), threadCount, [&](size_t index)
+        {
+            const auto& chunk = chunks[index];
+            auto line = chunk.LineOffset;
+            auto dst  = mesh.Indices.GetData() + chunk.TriangleOffset * 3;
+
+            for(auto ptr = chunk.Begin; ptr < chunk.End; ++line)
+            {
+                auto end = FindLineEnd(ptr, chunk.End);
+                if (vertexBegin <= line && line < vertexBegin + vertexCount)
+                {
+                    auto  id  = line - vertexBegin;
+                    auto& pos = mesh.Positions[id];
+                    auto  p   = ptr;
+                    for(auto j=0u; j<uint32_t(vertex.Properties.size()); ++j)
+                    {
+                        p = SkipSpace(p, end);
+                        float value = 0.0f;
+                        if (!ParseFloat(p, end, value))
+                        {
+                            ELOG("Error : Invalid Vertex. path = %" ASDX_PRIs ", vertex = %zu", path, line - vertexBegin);
+                            failed = true;
+                            return;
+                        }
+
+                        if      (j == propX)  { pos.x = value; }
+                        else if (j == propY)  { pos.y = value; }
+                        else if (j == propZ)  { pos.z = value; }
+                        else if (j == propNX && hasNormal)   { normals  [id].x = value; }
+                        else if (j == propNY && hasNormal)   { normals  [id].y = value; }
+                        else if (j == propNZ && hasNormal)   { normals  [id].z = value; }
+                        else if (j == propU  && hasTexCoord) { texcoords[id].x = value; }
+                        else if (j == propV  && hasTexCoord) { texcoords[id].y = value; }
+                    }
+                }
+                else if (faceBegin <= line && line < faceEnd)
+                {
+                    uint32_t first = 0, prev = 0;
+                    parseFace(ptr, end, [&](uint32_t value, int64_t k)
+                    {
+                        if (k == 0)
+                        { first = value; }
+                        else if (k >= 2)
+                        {
+                            *(dst++) = first;
+                            *(dst++) = prev;
+                            *(dst++) = value;
+                        }
+                        prev = value;
+                    });
+                }
+                ptr = end + 1;
+            }
+        });
+
+        return !failed;
+    }
+
+    // バイナリ形式.
+    const auto swap  = (format == PLY_FORMAT_BINARY_BE);
+    const auto data  = file.GetData();
+    const auto end   = data + file.GetSize();
+
+    if (vertex.Stride == 0)
+    {
+        ELOG("Error : PLY Vertex With List Property Is Not Supported. path = %" ASDX_PRIs, path);
+        return false;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FaceChunk structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct FaceChunk
+    {
+        const uint8_t*  Ptr;
+        size_t          Count;
+        size_t          TriangleOffset;
+    };
+
+    // 要素を順に辿って頂点の先頭を求め, 面は一定数ごとに区切りを記録しながら三角形数を数える.
+    const uint8_t*          vertexData = nullptr;
+    std::vector<FaceChunk>  faceChunks;
+    size_t                  triangleCount = 0;
+
+    auto ptr = data + bodyOffset;
+    for(size_t i=0; i<elements.size(); ++i)
+    {
+        const auto& element = elements[i];
+        if (element.Stride != 0)
+        {
+            if (i == vertexElement)
+            { vertexData = ptr; }
+
+            if (size_t(end - ptr) / element.Stride < element.Count)
+            {
+                ELOG("Error : Unexpected End Of File. path = %" ASDX_PRIs, path);
+                return false;
+            }
+            ptr += element.Stride * element.Count;
+            continue;
+        }
+
+        for(size_t k=0; k<element.Count; ++k)
+        {
+            if (i == faceElement && (k % PLY_FACE_CHUNK) == 0)
+            { faceChunks.push_back({ ptr, std::min<size_t>(PLY_FACE_CHUNK, element.Count - k), triangleCount }); }
+
+            for(auto j=0u; j<uint32_t(element.Properties.size()); ++j)
+            {
+                const auto& prop = element.Properties[j];
+                if (prop.CountType == PLY_TYPE_INVALID)
+                {
+                    ptr += GetPlyTypeSize(prop.Type);
+                    continue;
+                }
+
+                auto countSize = GetPlyTypeSize(prop.CountType);
+                if (ptr + countSize > end)
+                {
+                    ELOG("Error : Unexpected End Of File. path = %" ASDX_PRIs, path);
+                    return false;
+                }
+
+                auto count = size_t(ReadPlyValue(ptr, prop.CountType, swap));
+                ptr += countSize + count * GetPlyTypeSize(prop.Type);
+
+                if (i == faceElement && j == propIndex && count >= 3)
+                { triangleCount += count - 2; }
+            }
+
+            if (ptr > end)
+            {
+                ELOG("Error : Unexpected End Of File. path = %" ASDX_PRIs, path);
+                return false;
+            }
+        }
+    }
+
+    if (triangleCount == 0 || triangleCount * 3 > UINT32_MAX)
+    {
+        ELOG("Error : Invalid Triangle Count. path = %" ASDX_PRIs ", count = %zu", path, triangleCount);
+        return false;
+    }
+
+    if (!mesh.Positions.Resize(vertexCount) || !mesh.Indices.Resize(triangleCount * 3))
+    {
+        ELOG("Error : Out of Memory. path = %" ASDX_PRIs, path);
+        return false;
+    }
+
+    // 頂点は固定長なので番号で分割できる.
+    const auto& px = vertex.Properties[propX];
+    const auto& py = vertex.Properties[propY];
+    const auto& pz = vertex.Properties[propZ];
+    ParallelFor((vertexCount + PLY_VERTEX_CHUNK - 1) / PLY_VERTEX_CHUNK, threadCount, [&](size_t index)
+    {
+        auto begin = index * PLY_VERTEX_CHUNK;
+        auto last  = std::min(vertexCount, begin + PLY_VERTEX_CHUNK);
+        for(auto i=begin; i<last; ++i)
+        {
+            auto src = vertexData + i * vertex.Stride;
+            auto& pos = mesh.Positions[i];
+            pos.x = float(ReadPlyValue(src + px.Offset, px.Type, swap));
+            pos.y = float(ReadPlyValue(src + py.Offset, py.Type, swap));
+            pos.z = float(ReadPlyValue(src + pz.Offset, pz.Type, swap));
+
+            if (hasNormal)
+            {
+                const auto& nx = vertex.Properties[propNX];
+                const auto& ny = vertex.Properties[propNY];
+                const auto& nz = vertex.Properties[propNZ];
+                normals[i].x = float(ReadPlyValue(src + nx.Offset, nx.Type, swap));
+                normals[i].y = float(ReadPlyValue(src + ny.Offset, ny.Type, swap));
+                normals[i].z = float(ReadPlyValue(src + nz.Offset, nz.Type, swap));
+            }
+
+            if (hasTexCoord)
+            {
+                const auto& tu = vertex.Properties[propU];
+                const auto& tv = vertex.Properties[propV];
+                texcoords[i].x = float(ReadPlyValue(src + tu.Offset, tu.Type, swap));
+                texcoords[i].y = float(ReadPlyValue(src + tv.Offset, tv.Type, swap));
+            }
+        }
+    });
+
+    // 面は記録した区切りから並列に展開する.
+    ParallelFor(faceChunks.size(), threadCount, [&](size_t index)
+    {
+        const auto& chunk = faceChunks[index];
+        auto src = chunk.Ptr;
+        auto dst = mesh.Indices.GetData() + chunk.TriangleOffset * 3;
+
+        for(size_t k=0; k<chunk.Count; ++k)
+        {
+            for(auto j=0u; j<uint32_t(face.Properties.size()); ++j)
+            {
+                const auto& prop = face.Properties[j];
+                if (prop.CountType == PLY_TYPE_INVALID)
+                {
+                    src += GetPlyTypeSize(prop.Type);
+                    continue;
+                }
+
+                auto count    = size_t(ReadPlyValue(src, prop.CountType, swap));
+                auto itemSize = GetPlyTypeSize(prop.Type);
+                src += GetPlyTypeSize(prop.CountType);
+
+                if (j == propIndex)
+                {
+                    uint32_t first = 0, prev = 0;
+                    for(size_t n=0; n<count; ++n)
+                    {
+                        auto value = ReadPlyValue(src + n * itemSize, prop.Type, swap);
+                        if (value < 0.0 || value >= double(vertexCount))
+                        {
+                            ELOG("Error : Invalid Index. path = %" ASDX_PRIs ", index = %lf", path, value);
+                            failed = true;
+                            return;
+                        }
+
+                        auto id = uint32_t(value);
+                        if (n == 0)
+                        { first = id; }
+                        else if (n >= 2)
+                        {
+                            *(dst++) = first;
+                            *(dst++) = prev;
+                            *(dst++) = id;
+                        }
+                        prev = id;
+                    }
+                }
+
+                src += count * itemSize;
+            }
+        }
+    });
+
+    return !failed;
+}
+
+//-----------------------------------------------------------------------------
+//      拡張子を比較します.
+//-----------------------------------------------------------------------------
+bool HasExtension(const char* path, const char* ext)
+{
+    auto dot = strrchr(path, '.');
+    if (dot == nullptr)
+    { return false; }
+
+    for(dot++; *dot != '\0' && *ext != '\0'; ++dot, ++ext)
+    {
+        if (tolower(*dot) != *ext)
+        { return false; }
+    }
+
+    return *dot == '\0' && *ext == '\0';
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      ジオメトリ用のメモリを確保します.
+//-----------------------------------------------------------------------------
+void* AllocGeometryMemory(size_t size, size_t alignment)
+{
+#if defined(_WIN32)
+    auto ptr = _aligned_malloc(size, alignment);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, size) != 0)
+    { ptr = nullptr; }
+#endif
+
+    if (ptr == nullptr)
+    { return nullptr; }
+
+    auto current = g_GeometryMemorySize.fetch_add(size) + size;
+    auto peak    = g_GeometryMemoryPeak.load();
+    while(current > peak && !g_GeometryMemoryPeak.compare_exchange_weak(peak, current))
+    { /* DO_NOTHING */ }
+
+    return ptr;
+}
+
+//-----------------------------------------------------------------------------
+//      ジオメトリ用のメモリを解放します.
+//-----------------------------------------------------------------------------
+void FreeGeometryMemory(void* ptr, size_t size)
+{
+    if (ptr == nullptr)
+    { return; }
+
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+
+    g_GeometryMemorySize.fetch_sub(size);
+}
+
+//-----------------------------------------------------------------------------
+//      確保中のジオメトリ用メモリの合計サイズを取得します.
+//-----------------------------------------------------------------------------
+size_t GetGeometryMemorySize()
+{ return g_GeometryMemorySize.load(); }
+
+//-----------------------------------------------------------------------------
+//      ジオメトリ用メモリの最大使用量を取得します.
+//-----------------------------------------------------------------------------
+size_t GetGeometryMemoryPeak()
+{ return g_GeometryMemoryPeak.load(); }
+
+//-----------------------------------------------------------------------------
+//      ジオメトリ用メモリの最大使用量をリセットします.
+//-----------------------------------------------------------------------------
+void ResetGeometryMemoryPeak()
+{ g_GeometryMemoryPeak.store(g_GeometryMemorySize.load()); }
+
+//-----------------------------------------------------------------------------
+//      メッシュファイルを読み込みます.
+//-----------------------------------------------------------------------------
+bool LoadMesh(const char* path, Mesh& mesh, uint32_t threadCount)
+{
+    if (path == nullptr)
+    { return false; }
+
+    if (threadCount == 0)
+    { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+
+    auto begin = std::chrono::steady_clock::now();
+
+    MappedFile file;
+    if (!file.Init(path))
+    { return false; }
+
+    AlignedArray<asdx::Vector3> normals;
+    AlignedArray<asdx::Vector2> texcoords;
+
+    auto ret = false;
+    if (HasExtension(path, "obj"))
+    { ret = LoadOBJ(path, file, mesh, threadCount, normals, texcoords); }
+    else if (HasExtension(path, "ply"))
+    { ret = LoadPLY(path, file, mesh, threadCount, normals, texcoords); }
+    else
+    { ELOG("Error : Unsupported File Format. path = %" ASDX_PRIs, path); }
+
+    // 頂点属性は交差位置でしか使わないので, 量子化して保持する.
+    ret = ret && EncodeAttributes(mesh, normals.GetData(), texcoords.GetData(), mesh.Attributes);
+
+    if (!ret)
+    {
+        mesh.Positions .Clear();
+        mesh.Indices   .Clear();
+        mesh.Attributes.Clear();
+        return false;
+    }
+
+    auto sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    ILOG("Info : Mesh Loaded. path = %" ASDX_PRIs ", vertices = %u, triangles = %u, file = %.2lf MB, time = %.2lf ms, %.3lf GB/s (%u threads), memory = %.2lf MB, geometry peak = %.2lf MB, attributes = %.2lf MB (float %.2lf MB)",
+        path,
+        mesh.GetVertexCount(),
+        mesh.GetTriangleCount(),
+        double(file.GetSize()) / (1024.0 * 1024.0),
+        sec * 1000.0,
+        double(file.GetSize()) / sec * 1e-9,
+        threadCount,
+        double(mesh.GetMemorySize()) / (1024.0 * 1024.0),
+        double(GetGeometryMemoryPeak()) / (1024.0 * 1024.0),
+        double(mesh.Attributes.GetMemorySize()) / (1024.0 * 1024.0),
+        double(mesh.Attributes.GetFloatMemorySize()) / (1024.0 * 1024.0));
+
+    return true;
+}
@@ -0,0 +1,639 @@
+﻿//-----------------------------------------------------------------------------
+// File : meshDedup.cpp
+// Desc : Mesh Deduplication.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <meshDedup.h>
+#include <attribute.h>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Constant Values
+//-----------------------------------------------------------------------------
+static constexpr double   MIN_VARIANCE_RATIO = 1e-8;    // 平面とみなす分散(最大の分散に対する比).
+static constexpr double   MIN_AXIS_LENGTH    = 0.5;     // 白色化した空間で軸に使う頂点の最小距離.
+static constexpr double   ROUNDING_SCALE     = 4.0;     // 頂点座標の丸め誤差として許容する FLT_EPSILON の倍数.
+static constexpr uint32_t SAMPLE_COUNT       = 8;       // ハッシュに含める頂点数.
+static constexpr double   SAMPLE_GRID        = 16.0;    // ハッシュに含める正準座標の量子化単位.
+static constexpr double   DIRECTION_GRID     = 4.0;     // ハッシュに含める正準空間の法線と接線の量子化単位.
+static constexpr double   DIRECTION_TOLERANCE = 1e-3;   // 一致とみなす法線と接線の差(単位ベクトルの差の長さ).
+static constexpr uint64_t FNV_OFFSET         = 14695981039346656037ull;
+static constexpr uint64_t FNV_PRIME          = 1099511628211ull;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Affine structure
+// 行ベクトル形式のアフィン変換です(p' = p.x * Row[0] + p.y * Row[1] + p.z * Row[2] + Row[3]).
+// 位置が原点から離れていても誤差が出ないように倍精度で扱います.
+///////////////////////////////////////////////////////////////////////////////
+struct Affine
+{
+    double  Row[4][3];
+
+    //-------------------------------------------------------------------------
+    //      点を変換します.
+    //-------------------------------------------------------------------------
+    inline void Transform(const asdx::Vector3& p, double result[3]) const
+    {
+        for(auto i=0; i<3; ++i)
+        { result[i] = p.x * Row[0][i] + p.y * Row[1][i] + p.z * Row[2][i] + Row[3][i]; }
+    }
+
+    //-------------------------------------------------------------------------
+    //      方向を変換します(平行移動は含めません).
+    //-------------------------------------------------------------------------
+    inline void TransformDirection(const asdx::Vector3& d, double result[3]) const
+    {
+        for(auto i=0; i<3; ++i)
+        { result[i] = d.x * Row[0][i] + d.y * Row[1][i] + d.z * Row[2][i]; }
+    }
+
+    //-------------------------------------------------------------------------
+    //      逆変換として法線を変換します(この変換の転置を掛けます).
+    //-------------------------------------------------------------------------
+    inline void TransformNormalInverse(const asdx::Vector3& n, double result[3]) const
+    {
+        for(auto i=0; i<3; ++i)
+        { result[i] = n.x * Row[i][0] + n.y * Row[i][1] + n.z * Row[i][2]; }
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Signature structure
+///////////////////////////////////////////////////////////////////////////////
+struct Signature
+{
+    uint64_t    Hash;       // 位相と正準空間の座標のハッシュ値.
+    Affine      Frame;      // 正準空間からメッシュの座標への変換.
+    Affine      Inverse;    // メッシュの座標から正準空間への変換.
+    double      Diagonal;   // 境界箱の対角線長.
+    double      Magnitude;  // 座標の絶対値の最大値.
+    bool        Valid;      // 局所座標系を作れたかどうか.
+};
+
+//-----------------------------------------------------------------------------
+//      ハッシュ値に加算します.
+//-----------------------------------------------------------------------------
+inline void HashBytes(uint64_t& hash, const void* data, size_t size)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+    for(size_t i=0; i<size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      アフィン変換の逆変換を求めます.
+//-----------------------------------------------------------------------------
+bool Invert(const Affine& value, Affine& result)
+{
+    const auto& m = value.Row;
+
+    double c[3][3];
+    c[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    c[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+    c[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    c[1][0] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    c[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+    c[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+    c[2][0] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    c[2][1] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+    c[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+    auto det = m[0][0] * c[0][0] + m[0][1] * c[1][0] + m[0][2] * c[2][0];
+    if (det == 0.0 || !std::isfinite(det))
+    { return false; }
+
+    auto invDet = 1.0 / det;
+    for(auto i=0; i<3; ++i)
+    {
+        for(auto j=0; j<3; ++j)
+        { result.Row[i][j] = c[i][j] * invDet; }
+    }
+
+    for(auto j=0; j<3; ++j)
+    {
+        result.Row[3][j] = -(m[3][0] * result.Row[0][j]
+                           + m[3][1] * result.Row[1][j]
+                           + m[3][2] * result.Row[2][j]);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      アフィン変換を合成します(lhs を適用してから rhs を適用).
+//-----------------------------------------------------------------------------
+Affine Multiply(const Affine& lhs, const Affine& rhs)
+{
+    Affine result;
+    for(auto i=0; i<4; ++i)
+    {
+        for(auto j=0; j<3; ++j)
+        {
+            result.Row[i][j] = lhs.Row[i][0] * rhs.Row[0][j]
+                             + lhs.Row[i][1] * rhs.Row[1][j]
+                             + lhs.Row[i][2] * rhs.Row[2][j]
+                             + ((i == 3) ? rhs.Row[3][j] : 0.0);
+        }
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      対称行列を固有値分解します(ヤコビ法).
+//-----------------------------------------------------------------------------
+void Eigen(const double (&matrix)[3][3], double (&values)[3], double (&vectors)[3][3])
+{
+    double a[3][3];
+    for(auto i=0; i<3; ++i)
+    {
+        for(auto j=0; j<3; ++j)
+        {
+            a[i][j]       = matrix[i][j];
+            vectors[i][j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+
+    for(auto sweep=0; sweep<32; ++sweep)
+    {
+        auto off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        if (off <= 1e-30 * (a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2]))
+        { break; }
+
+        for(auto p=0; p<2; ++p)
+        {
+            for(auto q=p+1; q<3; ++q)
+            {
+                if (a[p][q] == 0.0)
+                { continue; }
+
+                auto theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                auto t     = ((theta >= 0.0) ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                auto c     = 1.0 / sqrt(t * t + 1.0);
+                auto s     = t * c;
+
+                for(auto k=0; k<3; ++k)
+                {
+                    auto akp = a[k][p];
+                    auto akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for(auto k=0; k<3; ++k)
+                {
+                    auto apk = a[p][k];
+                    auto aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for(auto k=0; k<3; ++k)
+                {
+                    auto vkp = vectors[k][p];
+                    auto vkq = vectors[k][q];
+                    vectors[k][p] = c * vkp - s * vkq;
+                    vectors[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    for(auto i=0; i<3; ++i)
+    { values[i] = a[i][i]; }
+}
+
+//-----------------------------------------------------------------------------
+//      3次元ベクトルの内積を求めます.
+//-----------------------------------------------------------------------------
+inline double Dot(const double (&a)[3], const double (&b)[3])
+{ return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+//-----------------------------------------------------------------------------
+//      ベクトルを正規化します.
+//-----------------------------------------------------------------------------
+inline bool Normalize(double (&v)[3])
+{
+    auto length = sqrt(Dot(v, v));
+    if (!(length > 0.0) || !std::isfinite(length))
+    { return false; }
+
+    for(auto c=0; c<3; ++c)
+    { v[c] /= length; }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      正規化した方向を量子化してハッシュ値に加算します.
+//-----------------------------------------------------------------------------
+inline void HashDirection(uint64_t& hash, double (&d)[3])
+{
+    int64_t q[3] = {};
+    if (Normalize(d))
+    {
+        for(auto j=0; j<3; ++j)
+        { q[j] = int64_t(floor(d[j] * DIRECTION_GRID + 0.5)); }
+    }
+    HashBytes(hash, q, sizeof(q));
+}
+
+//-----------------------------------------------------------------------------
+//      変換した方向が単位ベクトルと一致するかどうかチェックします.
+//-----------------------------------------------------------------------------
+inline bool IsSameDirection(double (&d)[3], const asdx::Vector3& expected)
+{
+    if (!Normalize(d))
+    { return false; }
+
+    const double diff[3] = { d[0] - expected.x, d[1] - expected.y, d[2] - expected.z };
+    return Dot(diff, diff) <= DIRECTION_TOLERANCE * DIRECTION_TOLERANCE;
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュのシグネチャを求めます.
+//-----------------------------------------------------------------------------
+void CreateSignature(const Mesh& mesh, Signature& result)
+{
+    result.Hash     = FNV_OFFSET;
+    result.Diagonal  = 0.0;
+    result.Magnitude = 0.0;
+    result.Valid     = false;
+
+    const auto  vertexCount   = mesh.GetVertexCount();
+    const auto  triangleCount = mesh.GetTriangleCount();
+    const auto* positions     = mesh.Positions.GetData();
+    const auto* indices       = mesh.Indices  .GetData();
+    if (vertexCount < 3 || triangleCount == 0)
+    { return; }
+
+    // 位相.
+    HashBytes(result.Hash, &vertexCount,   sizeof(vertexCount));
+    HashBytes(result.Hash, &triangleCount, sizeof(triangleCount));
+    HashBytes(result.Hash, indices, sizeof(uint32_t) * 3 * size_t(triangleCount));
+
+    // 重心, 共分散, 大きさの基準.
+    double mean[3] = {};
+    double mini[3] = {  HUGE_VAL,  HUGE_VAL,  HUGE_VAL };
+    double maxi[3] = { -HUGE_VAL, -HUGE_VAL, -HUGE_VAL };
+    for(auto i=0u; i<vertexCount; ++i)
+    {
+        const double p[3] = { positions[i].x, positions[i].y, positions[i].z };
+        for(auto j=0; j<3; ++j)
+        {
+            mean[j] += p[j];
+            mini[j]  = std::min(mini[j], p[j]);
+            maxi[j]  = std::max(maxi[j], p[j]);
+        }
+    }
+    for(auto j=0; j<3; ++j)
+    { mean[j] /= double(vertexCount); }
+
+    result.Diagonal = sqrt(
+        (maxi[0] - mini[0]) * (maxi[0] - mini[0]) +
+        (maxi[1] - mini[1]) * (maxi[1] - mini[1]) +
+        (maxi[2] - mini[2]) * (maxi[2] - mini[2]));
+    if (!(result.Diagonal > 0.0) || !std::isfinite(result.Diagonal))
+    { return; }
+
+    for(auto j=0; j<3; ++j)
+    { result.Magnitude = std::max(result.Magnitude, std::max(fabs(mini[j]), fabs(maxi[j]))); }
+
+    double cov[3][3] = {};
+    for(auto i=0u; i<vertexCount; ++i)
+    {
+        const double d[3] = { positions[i].x - mean[0], positions[i].y - mean[1], positions[i].z - mean[2] };
+        for(auto r=0; r<3; ++r)
+        {
+            for(auto c=0; c<3; ++c)
+            { cov[r][c] += d[r] * d[c]; }
+        }
+    }
+    for(auto r=0; r<3; ++r)
+    {
+        for(auto c=0; c<3; ++c)
+        { cov[r][c] /= double(vertexCount); }
+    }
+
+    // 共分散を単位行列にする白色化は, アフィン変換の違いを回転(と鏡映)の違いだけにする.
+    // 平面的なメッシュは法線方向の分散が 0 になるので, その軸は最大の分散で代用する.
+    double values[3], vectors[3][3];
+    Eigen(cov, values, vectors);
+
+    auto maxValue   = std::max(values[0], std::max(values[1], values[2]));
+    auto flatCount  = 0;
+    double white[3][3] = {};
+    for(auto k=0; k<3; ++k)
+    {
+        auto value = values[k];
+        if (value <= MIN_VARIANCE_RATIO * maxValue)
+        {
+            value = maxValue;
+            flatCount++;
+        }
+
+        auto scale = 1.0 / sqrt(value);
+        for(auto r=0; r<3; ++r)
+        {
+            for(auto c=0; c<3; ++c)
+            { white[r][c] += vectors[r][k] * vectors[c][k] * scale; }
+        }
+    }
+    if (flatCount > 1)
+    { return; }
+
+    // 白色化した空間で, 頂点の並び順に従って正規直交基底を作り回転を固定する.
+    // 1軸目は中心から離れた最初の頂点, 2軸目はそれと直交する成分が大きい最初の頂点,
+    // 3軸目は外積で求め, 向きは直交する成分が大きい最初の頂点で決める.
+    auto whiten = [&](uint32_t index, double (&w)[3])
+    {
+        const double d[3] = { positions[index].x - mean[0], positions[index].y - mean[1], positions[index].z - mean[2] };
+        for(auto c=0; c<3; ++c)
+        { w[c] = d[0] * white[0][c] + d[1] * white[1][c] + d[2] * white[2][c]; }
+    };
+
+    double axis[3][3];
+    auto   axisCount = 0;
+    auto   sign      = 1.0;
+    for(auto i=0u; i<vertexCount && axisCount < 3; ++i)
+    {
+        double w[3];
+        whiten(i, w);
+
+        // 決めた軸の成分を除く.
+        for(auto k=0; k<axisCount; ++k)
+        {
+            auto d = Dot(w, axis[k]);
+            for(auto c=0; c<3; ++c)
+            { w[c] -= d * axis[k][c]; }
+        }
+
+        auto length = sqrt(Dot(w, w));
+        if (length <= MIN_AXIS_LENGTH)
+        { continue; }
+
+        if (axisCount < 2)
+        {
+            for(auto c=0; c<3; ++c)
+            { axis[axisCount][c] = w[c] / length; }
+
+            if (++axisCount == 2)
+            {
+                axis[2][0] = axis[0][1] * axis[1][2] - axis[0][2] * axis[1][1];
+                axis[2][1] = axis[0][2] * axis[1][0] - axis[0][0] * axis[1][2];
+                axis[2][2] = axis[0][0] * axis[1][1] - axis[0][1] * axis[1][0];
+            }
+        }
+        else
+        {
+            sign      = (Dot(w, axis[2]) < 0.0) ? -1.0 : 1.0;
+            axisCount = 3;
+        }
+    }
+    if (axisCount < 2)
+    { return; }
+
+    for(auto c=0; c<3; ++c)
+    { axis[2][c] *= sign; }
+
+    // メッシュの座標 → 正準空間: c = ((p - mean) * white) * axis^T.
+    auto& inverse = result.Inverse.Row;
+    for(auto r=0; r<3; ++r)
+    {
+        for(auto c=0; c<3; ++c)
+        { inverse[r][c] = white[r][0] * axis[c][0] + white[r][1] * axis[c][1] + white[r][2] * axis[c][2]; }
+    }
+    for(auto c=0; c<3; ++c)
+    { inverse[3][c] = -(mean[0] * inverse[0][c] + mean[1] * inverse[1][c] + mean[2] * inverse[2][c]); }
+
+    if (!Invert(result.Inverse, result.Frame))
+    { return; }
+
+    // 正準空間での代表頂点の座標.
+    for(auto i=0u; i<SAMPLE_COUNT; ++i)
+    {
+        double c[3];
+        result.Inverse.Transform(positions[uint64_t(vertexCount) * i / SAMPLE_COUNT], c);
+
+        int64_t q[3];
+        for(auto j=0; j<3; ++j)
+        { q[j] = int64_t(floor(c[j] * SAMPLE_GRID + 0.5)); }
+        HashBytes(result.Hash, q, sizeof(q));
+    }
+
+    // インスタンスは代表メッシュの法線と接線を変換して使うので, 正準空間での向きもハッシュに含める.
+    // 法線は逆変換の転置で, 接線は方向として変換する. 従法線の向き(最下位ビット)はそのまま含める.
+    const auto& attributes = mesh.Attributes;
+    const auto  hasNormal  = attributes.Normals .GetCount() > 0;
+    const auto  hasTangent = attributes.Tangents.GetCount() > 0;
+    if ((hasNormal  && attributes.Normals .GetCount() != vertexCount)
+     || (hasTangent && attributes.Tangents.GetCount() != vertexCount))
+    { return; }
+
+    const uint32_t layout = (hasNormal ? 1u : 0u) | (hasTangent ? 2u : 0u);
+    HashBytes(result.Hash, &layout, sizeof(layout));
+    for(auto i=0u; i<SAMPLE_COUNT; ++i)
+    {
+        const auto index = uint32_t(uint64_t(vertexCount) * i / SAMPLE_COUNT);
+        if (hasNormal)
+        {
+            double n[3];
+            result.Frame.TransformNormalInverse(DecodeOctNormal(attributes.Normals[index]), n);
+            HashDirection(result.Hash, n);
+        }
+        if (hasTangent)
+        {
+            double t[3];
+            result.Inverse.TransformDirection(DecodeOctDirection(attributes.Tangents[index]), t);
+            HashDirection(result.Hash, t);
+
+            const uint32_t flip = attributes.Tangents[index] & 1u;
+            HashBytes(result.Hash, &flip, sizeof(flip));
+        }
+    }
+
+    result.Valid = true;
+}
+
+//-----------------------------------------------------------------------------
+//      代表メッシュを変換してメッシュと一致するかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool IsSameMesh
+(
+    const Mesh&         prototype,
+    const Mesh&         mesh,
+    const Affine&       transform,
+    double              tolerance
+)
+{
+    if (prototype.GetVertexCount()   != mesh.GetVertexCount()
+     || prototype.GetTriangleCount() != mesh.GetTriangleCount())
+    { return false; }
+
+    // ハッシュの衝突に備えて位相も比較する.
+    if (memcmp(prototype.Indices.GetData(), mesh.Indices.GetData(), sizeof(uint32_t) * mesh.Indices.GetCount()) != 0)
+    { return false; }
+
+    // インスタンスは代表メッシュの頂点属性でシェーディングするので, テクスチャ座標も一致している必要がある.
+    const auto& pa = prototype.Attributes;
+    const auto& ma = mesh.Attributes;
+    if (pa.TexCoords.GetCount() != ma.TexCoords.GetCount())
+    { return false; }
+    if (ma.TexCoords.GetCount() > 0)
+    {
+        if (pa.TexCoordRange.x != ma.TexCoordRange.x || pa.TexCoordRange.y != ma.TexCoordRange.y
+         || pa.TexCoordRange.z != ma.TexCoordRange.z || pa.TexCoordRange.w != ma.TexCoordRange.w
+         || memcmp(pa.TexCoords.GetData(), ma.TexCoords.GetData(), sizeof(uint32_t) * ma.TexCoords.GetCount()) != 0)
+        { return false; }
+    }
+
+    for(auto i=0u; i<mesh.GetVertexCount(); ++i)
+    {
+        double p[3];
+        transform.Transform(prototype.Positions[i], p);
+
+        const auto& q = mesh.Positions[i];
+        if (fabs(p[0] - q.x) > tolerance
+         || fabs(p[1] - q.y) > tolerance
+         || fabs(p[2] - q.z) > tolerance)
+        { return false; }
+    }
+
+    // 法線と接線も代表メッシュのものを変換して使うので, 変換後の向きが一致している必要がある.
+    if (pa.Normals.GetCount() != ma.Normals.GetCount() || pa.Tangents.GetCount() != ma.Tangents.GetCount())
+    { return false; }
+
+    Affine inverse;
+    if (ma.Normals.GetCount() > 0 && !Invert(transform, inverse))
+    { return false; }
+
+    for(size_t i=0; i<ma.Normals.GetCount(); ++i)
+    {
+        double n[3];
+        inverse.TransformNormalInverse(DecodeOctNormal(pa.Normals[i]), n);
+        if (!IsSameDirection(n, DecodeOctNormal(ma.Normals[i])))
+        { return false; }
+    }
+
+    for(size_t i=0; i<ma.Tangents.GetCount(); ++i)
+    {
+        // 従法線の向きは変換に依らず代表メッシュのものを使うので, そのまま一致している必要がある.
+        if (((pa.Tangents[i] ^ ma.Tangents[i]) & 1u) != 0)
+        { return false; }
+
+        double t[3];
+        transform.TransformDirection(DecodeOctDirection(pa.Tangents[i]), t);
+        if (!IsSameDirection(t, DecodeOctNormal(ma.Tangents[i])))
+        { return false; }
+    }
+
+    return true;
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      変換行列を除いて同一のメッシュを検出します.
+//-----------------------------------------------------------------------------
+void FindDuplicateMeshes
+(
+    const Mesh* const*  meshes,
+    uint32_t            count,
+    MeshDedupResult&    result,
+    float               tolerance
+)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    result.Prototypes.resize(count);
+    result.GroupSizes.assign(count, 0);
+    result.Transforms.assign(count, asdx::Matrix::CreateIdentity());
+    result.DuplicateCount     = 0;
+    result.SavedTriangleCount = 0;
+    result.SavedMemorySize    = 0;
+
+    // シグネチャは全頂点を走査するので, メッシュ単位で並列に求める.
+    std::vector<Signature> signatures(count);
+    {
+        std::atomic<uint32_t> next = {};
+        auto func = [&]()
+        {
+            for(auto i = next++; i < count; i = next++)
+            { CreateSignature(*meshes[i], signatures[i]); }
+        };
+
+        auto threadCount = std::min(count, std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<std::thread> threads;
+        for(auto i=1u; i<threadCount; ++i)
+        { threads.emplace_back(func); }
+
+        func();
+
+        for(auto& itr : threads)
+        { itr.join(); }
+    }
+
+    // 同じハッシュ値の代表メッシュと全頂点を比較する.
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+    for(auto i=0u; i<count; ++i)
+    {
+        result.Prototypes[i] = i;
+
+        const auto& signature = signatures[i];
+        if (!signature.Valid)
+        {
+            result.GroupSizes[i] = 1;
+            continue;
+        }
+
+        auto& candidates = buckets[signature.Hash];
+        for(auto candidate : candidates)
+        {
+            // 代表メッシュ → 正準空間 → このメッシュ.
+            // 原点から離れたメッシュは頂点座標自体の丸め誤差が大きいので, その分も許容する.
+            auto transform = Multiply(signatures[candidate].Inverse, signature.Frame);
+            auto magnitude = std::max(signatures[candidate].Magnitude, signature.Magnitude);
+            auto threshold = tolerance * signature.Diagonal + ROUNDING_SCALE * FLT_EPSILON * magnitude;
+            if (!IsSameMesh(*meshes[candidate], *meshes[i], transform, threshold))
+            { continue; }
+
+            const auto& m = transform.Row;
+            result.Prototypes[i] = candidate;
+            result.Transforms[i] = asdx::Matrix(
+                float(m[0][0]), float(m[0][1]), float(m[0][2]), 0.0f,
+                float(m[1][0]), float(m[1][1]), float(m[1][2]), 0.0f,
+                float(m[2][0]), float(m[2][1]), float(m[2][2]), 0.0f,
+                float(m[3][0]), float(m[3][1]), float(m[3][2]), 1.0f);
+            break;
+        }
+
+        if (result.Prototypes[i] == i)
+        {
+            candidates.push_back(i);
+            result.GroupSizes[i] = 1;
+            continue;
+        }
+
+        result.GroupSizes[result.Prototypes[i]]++;
+        result.DuplicateCount++;
+        result.SavedTriangleCount += meshes[i]->GetTriangleCount();
+        result.SavedMemorySize    += meshes[i]->GetMemorySize();
+    }
+
+    result.Msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
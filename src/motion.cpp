@@ -0,0 +1,337 @@
+﻿//-----------------------------------------------------------------------------
+// File : motion.cpp
+// Desc : Motion Blur Transform.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <motion.h>
+#include <algorithm>
+#include <cmath>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Constant Values
+//-----------------------------------------------------------------------------
+static constexpr double MAX_SAMPLE_ANGLE  = 3.1415926535897932 / 256.0;   // 境界を求める際のサンプル間の最大回転角.
+static constexpr double SLERP_THRESHOLD   = 0.9995;                        // これより近い回転は正規化線形補間にする.
+
+
+//-----------------------------------------------------------------------------
+//      内積を求めます.
+//-----------------------------------------------------------------------------
+inline double Dot3(const double* a, const double* b)
+{ return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+//-----------------------------------------------------------------------------
+//      ベクトルを正規化します. 長さが 0 の場合は false を返却します.
+//-----------------------------------------------------------------------------
+inline bool Normalize3(double* value, double& length)
+{
+    length = sqrt(Dot3(value, value));
+    if (!(length > 1e-30))
+    { return false; }
+
+    value[0] /= length;
+    value[1] /= length;
+    value[2] /= length;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      value に直交する単位ベクトルを求めます.
+//-----------------------------------------------------------------------------
+inline void Orthogonal3(const double* value, double* result)
+{
+    // 絶対値が最小の成分の軸と外積をとる.
+    double axis[3] = {};
+    auto x = fabs(value[0]), y = fabs(value[1]), z = fabs(value[2]);
+    axis[(x <= y && x <= z) ? 0 : (y <= z) ? 1 : 2] = 1.0;
+
+    result[0] = value[1] * axis[2] - value[2] * axis[1];
+    result[1] = value[2] * axis[0] - value[0] * axis[2];
+    result[2] = value[0] * axis[1] - value[1] * axis[0];
+
+    double length;
+    Normalize3(result, length);
+}
+
+//-----------------------------------------------------------------------------
+//      四元数から回転行列(列ベクトル形式, r[行][列])を求めます.
+//-----------------------------------------------------------------------------
+void ToRotation(const float* q, float r[3][3])
+{
+    auto w = q[0], x = q[1], y = q[2], z = q[3];
+
+    r[0][0] = 1.0f - 2.0f * (y * y + z * z);
+    r[0][1] = 2.0f * (x * y - w * z);
+    r[0][2] = 2.0f * (x * z + w * y);
+    r[1][0] = 2.0f * (x * y + w * z);
+    r[1][1] = 1.0f - 2.0f * (x * x + z * z);
+    r[1][2] = 2.0f * (y * z - w * x);
+    r[2][0] = 2.0f * (x * z - w * y);
+    r[2][1] = 2.0f * (y * z + w * x);
+    r[2][2] = 1.0f - 2.0f * (x * x + y * y);
+}
+
+//-----------------------------------------------------------------------------
+//      2つの回転の間の角度を求めます(最短経路).
+//-----------------------------------------------------------------------------
+inline double GetRotationAngle(const float* a, const float* b)
+{
+    auto d = fabs(double(a[0]) * b[0] + double(a[1]) * b[1] + double(a[2]) * b[2] + double(a[3]) * b[3]);
+    return 2.0 * acos(std::min(d, 1.0));
+}
+
+//-----------------------------------------------------------------------------
+//      2つの変換を補間します.
+//-----------------------------------------------------------------------------
+void Interpolate(const MotionKey& a, const MotionKey& b, float f, MotionKey& result)
+{
+    for(auto i=0; i<3; ++i)
+    {
+        result.Scale      [i] = a.Scale      [i] + (b.Scale      [i] - a.Scale      [i]) * f;
+        result.Skew       [i] = a.Skew       [i] + (b.Skew       [i] - a.Skew       [i]) * f;
+        result.Translation[i] = a.Translation[i] + (b.Translation[i] - a.Translation[i]) * f;
+    }
+
+    // 最短経路になるように符号を揃えてから球面線形補間する.
+    double qb[4] = { b.Rotation[0], b.Rotation[1], b.Rotation[2], b.Rotation[3] };
+    auto d = a.Rotation[0] * qb[0] + a.Rotation[1] * qb[1] + a.Rotation[2] * qb[2] + a.Rotation[3] * qb[3];
+    if (d < 0.0)
+    {
+        for(auto& itr : qb)
+        { itr = -itr; }
+        d = -d;
+    }
+
+    double wa = 1.0 - f;
+    double wb = f;
+    if (d < SLERP_THRESHOLD)
+    {
+        auto theta = acos(d);
+        auto s     = 1.0 / sin(theta);
+        wa = sin((1.0 - f) * theta) * s;
+        wb = sin(f * theta) * s;
+    }
+
+    double q[4];
+    auto length = 0.0;
+    for(auto i=0; i<4; ++i)
+    {
+        q[i]    = a.Rotation[i] * wa + qb[i] * wb;
+        length += q[i] * q[i];
+    }
+
+    length = 1.0 / sqrt(length);
+    for(auto i=0; i<4; ++i)
+    { result.Rotation[i] = float(q[i] * length); }
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      変換行列を分解します.
+//-----------------------------------------------------------------------------
+void DecomposeTransform(const asdx::Matrix& transform, MotionKey& result)
+{
+    // 行ベクトル形式なので, 行が基底ベクトルの像(列ベクトル形式の列)になる.
+    double a[3][3] = {
+        { transform._11, transform._12, transform._13 },
+        { transform._21, transform._22, transform._23 },
+        { transform._31, transform._32, transform._33 },
+    };
+
+    // Gram-Schmidt で直交化する(A = Q * S, S は上三角).
+    double q[3][3] = {
+        { a[0][0], a[0][1], a[0][2] },
+        { a[1][0], a[1][1], a[1][2] },
+        {},
+    };
+
+    double s11, s22;
+    if (!Normalize3(q[0], s11))
+    {
+        q[0][0] = 1.0; q[0][1] = 0.0; q[0][2] = 0.0;
+        s11 = 0.0;
+    }
+
+    auto s12 = Dot3(q[0], a[1]);
+    q[1][0] -= s12 * q[0][0];
+    q[1][1] -= s12 * q[0][1];
+    q[1][2] -= s12 * q[0][2];
+    if (!Normalize3(q[1], s22))
+    {
+        Orthogonal3(q[0], q[1]);
+        s22 = 0.0;
+    }
+
+    // 第3軸は外積で決めて回転にする. 鏡映は Z の拡縮の符号で表す.
+    q[2][0] = q[0][1] * q[1][2] - q[0][2] * q[1][1];
+    q[2][1] = q[0][2] * q[1][0] - q[0][0] * q[1][2];
+    q[2][2] = q[0][0] * q[1][1] - q[0][1] * q[1][0];
+
+    auto s13 = Dot3(q[0], a[2]);
+    auto s23 = Dot3(q[1], a[2]);
+    auto s33 = Dot3(q[2], a[2]);
+
+    result.Scale[0] = float(s11);
+    result.Scale[1] = float(s22);
+    result.Scale[2] = float(s33);
+    result.Skew [0] = float(s12);
+    result.Skew [1] = float(s13);
+    result.Skew [2] = float(s23);
+
+    // 回転行列 r[行][列] = q[列][行] から四元数を求める.
+    auto r = [&](int row, int col) { return q[col][row]; };
+    auto trace = r(0, 0) + r(1, 1) + r(2, 2);
+
+    double w, x, y, z;
+    if (trace > 0.0)
+    {
+        auto s = 0.5 / sqrt(trace + 1.0);
+        w = 0.25 / s;
+        x = (r(2, 1) - r(1, 2)) * s;
+        y = (r(0, 2) - r(2, 0)) * s;
+        z = (r(1, 0) - r(0, 1)) * s;
+    }
+    else if (r(0, 0) > r(1, 1) && r(0, 0) > r(2, 2))
+    {
+        auto s = 2.0 * sqrt(1.0 + r(0, 0) - r(1, 1) - r(2, 2));
+        w = (r(2, 1) - r(1, 2)) / s;
+        x = 0.25 * s;
+        y = (r(0, 1) + r(1, 0)) / s;
+        z = (r(0, 2) + r(2, 0)) / s;
+    }
+    else if (r(1, 1) > r(2, 2))
+    {
+        auto s = 2.0 * sqrt(1.0 + r(1, 1) - r(0, 0) - r(2, 2));
+        w = (r(0, 2) - r(2, 0)) / s;
+        x = (r(0, 1) + r(1, 0)) / s;
+        y = 0.25 * s;
+        z = (r(1, 2) + r(2, 1)) / s;
+    }
+    else
+    {
+        auto s = 2.0 * sqrt(1.0 + r(2, 2) - r(0, 0) - r(1, 1));
+        w = (r(1, 0) - r(0, 1)) / s;
+        x = (r(0, 2) + r(2, 0)) / s;
+        y = (r(1, 2) + r(2, 1)) / s;
+        z = 0.25 * s;
+    }
+
+    auto length = 1.0 / sqrt(w * w + x * x + y * y + z * z);
+    result.Rotation[0] = float(w * length);
+    result.Rotation[1] = float(x * length);
+    result.Rotation[2] = float(y * length);
+    result.Rotation[3] = float(z * length);
+
+    result.Translation[0] = transform._41;
+    result.Translation[1] = transform._42;
+    result.Translation[2] = transform._43;
+}
+
+//-----------------------------------------------------------------------------
+//      分解した変換を行列に戻します.
+//-----------------------------------------------------------------------------
+void ComposeTransform(const MotionKey& key, asdx::Matrix& result)
+{
+    float r[3][3];
+    ToRotation(key.Rotation, r);
+
+    const float s[3][3] = {
+        { key.Scale[0], key.Skew [0], key.Skew [1] },
+        { 0.0f,         key.Scale[1], key.Skew [2] },
+        { 0.0f,         0.0f,         key.Scale[2] },
+    };
+
+    // A = R * S の列を行ベクトル形式の行にする.
+    float m[3][3];
+    for(auto row=0; row<3; ++row)
+    {
+        for(auto col=0; col<3; ++col)
+        { m[col][row] = r[row][0] * s[0][col] + r[row][1] * s[1][col] + r[row][2] * s[2][col]; }
+    }
+
+    result = asdx::Matrix(
+        m[0][0], m[0][1], m[0][2], 0.0f,
+        m[1][0], m[1][1], m[1][2], 0.0f,
+        m[2][0], m[2][1], m[2][2], 0.0f,
+        key.Translation[0], key.Translation[1], key.Translation[2], 1.0f);
+}
+
+//-----------------------------------------------------------------------------
+//      時刻に対応する変換を補間します.
+//-----------------------------------------------------------------------------
+void InterpolateMotion(const MotionKey* keys, uint32_t count, float time, MotionKey& result)
+{
+    if (count < 2)
+    {
+        result = keys[0];
+        return;
+    }
+
+    uint32_t segment;
+    auto f = GetMotionSegment(count, time, segment);
+    Interpolate(keys[segment], keys[segment + 1], f, result);
+}
+
+//-----------------------------------------------------------------------------
+//      全時刻の境界を包含する境界を求めます.
+//-----------------------------------------------------------------------------
+asdx::AABB CalcMotionBounds(const MotionKey* keys, uint32_t count, const asdx::AABB& box)
+{
+    asdx::AABB result;
+
+    auto segmentCount = (count < 2) ? 1u : count - 1;
+    for(auto i=0u; i<segmentCount; ++i)
+    {
+        const auto& a = keys[i];
+        const auto& b = keys[std::min(i + 1, count - 1)];
+
+        // 回転が無ければ頂点は線形に動くので, 両端の境界で包含できる.
+        // 回転する場合は区間を分割し, サンプル間の回転角 Δθ で頂点が弦から外れる分だけ広げる.
+        // (回転中心からの距離を r とすると, 拡縮の線形補間を含めても 4r sin(Δθ/2) 以内に収まる)
+        auto theta       = GetRotationAngle(a.Rotation, b.Rotation);
+        auto sampleCount = std::min(256u, std::max(1u, uint32_t(ceil(theta / MAX_SAMPLE_ANGLE))));
+        auto radius      = 0.0f;
+
+        asdx::AABB segment;
+        for(auto s=0u; s<=sampleCount; ++s)
+        {
+            MotionKey key;
+            Interpolate(a, b, float(s) / float(sampleCount), key);
+
+            asdx::Matrix transform;
+            ComposeTransform(key, transform);
+
+            asdx::Vector3 center(key.Translation[0], key.Translation[1], key.Translation[2]);
+            for(auto c=0u; c<8; ++c)
+            {
+                asdx::Vector3 corner(
+                    (c & 1) ? box.maxi.x : box.mini.x,
+                    (c & 2) ? box.maxi.y : box.mini.y,
+                    (c & 4) ? box.maxi.z : box.mini.z);
+                auto p = asdx::Vector3::Transform(corner, transform);
+                segment.Expand(p);
+                radius = std::max(radius, (p - center).Length());
+            }
+        }
+
+        if (theta > 0.0)
+        {
+            auto margin = float(4.0 * sin(theta / double(sampleCount) * 0.5)) * radius;
+            segment.mini -= asdx::Vector3(margin, margin, margin);
+            segment.maxi += asdx::Vector3(margin, margin, margin);
+        }
+
+        result.Merge(segment);
+    }
+
+    return result;
+}
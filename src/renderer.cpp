@@ -8,11 +8,18 @@
 // Includes
 //-----------------------------------------------------------------------------
 #include <renderer.h>
+#include <meshDedup.h>
 #include <asdxLogger.h>
 #include <stb/stb_image_write.h>
-#include <ppl.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 
+#if defined(_WIN32)
+#include <ppl.h>
 using namespace concurrency;
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 // Renderer class
@@ -25,25 +32,47 @@ bool Renderer::Init(const Desc& desc)
 {
     m_Timer.Start();
 
-    // Embreȅ.
+    // \̏.
     {
-        m_Device = rtcNewDevice(nullptr);
-        if (m_Device == nullptr)
-        {
-            ELOG("Error : rtcNewDevice() Failed.");
-            return false;
-        }
+        AccelDesc accelDesc;
+        accelDesc.Backend      = desc.Backend;
+        accelDesc.DeviceConfig = desc.DeviceConfig;
+        accelDesc.BuildQuality = desc.BuildQuality;
+        accelDesc.SceneFlags   = desc.SceneFlags;
+        if (desc.RebuildThreshold > 0.0f)
+        { accelDesc.RebuildThreshold = desc.RebuildThreshold; }
+        accelDesc.RebuildBudgetMsec = desc.RebuildBudgetMsec;
+        accelDesc.TessellationCacheSize = desc.TessellationCacheSize;
 
-        m_Scene = rtcNewScene(m_Device);
-        if (m_Scene == nullptr)
+        m_Accel = CreateAccel(desc.Backend);
+        if (!m_Accel->Init(accelDesc))
         {
-            ELOG("Error : rtcNewScene() Failed.");
+            ELOG("Error : Accel::Init() Failed.");
             return false;
         }
     }
 
     m_MaxBounce = desc.MaxBounce;
 
+    // Vb^[JĂ. ԃXebv [0, 1] ɒû, ͈̔͂Ɏ߂.
+    m_ShutterOpen  = asdx::Saturate(desc.ShutterOpen);
+    m_ShutterClose = asdx::Saturate(desc.ShutterClose);
+
+    m_PendingMeshes.clear();
+    m_GeometryCount       = 0;
+    m_DedupInstanceCount  = 0;
+    m_DedupTriangleCount  = 0;
+    m_UniqueTriangleCount = 0;
+    m_DedupMeshes         = desc.DedupMeshes;
+
+    // V[LbVJ. Âꍇ, ǂݍ݌ɍ蒼.
+    m_MeshPaths.clear();
+    m_CachedMeshCount   = 0;
+    m_SceneCachePending = false;
+    m_SceneCachePath    = (desc.SceneCachePath != nullptr) ? desc.SceneCachePath : "";
+    if (!m_SceneCachePath.empty() && !m_SceneCache.Open(desc.SceneCachePath))
+    { ILOG("Info : Scene Cache Not Found. It will be written after loading. path = %" ASDX_PRIs, desc.SceneCachePath); }
+
     // _[^[Qbg.
     {
         auto size = desc.Width * desc.Height;
@@ -55,13 +84,10 @@ bool Renderer::Init(const Desc& desc)
         m_Height = desc.Height;
 
         // _[^[QbgNA.
-        for(auto i=0u; i<size; ++i)
-        {
-            m_ColorBuffer [i] = asdx::Vector3(0.0f, 0.0f, 0.0f);
-            m_OutputBuffer[i] = asdx::Vector3(0.0f, 0.0f, 0.0f);
-        }
+        ClearBuffers();
     }
 
+#if SALTY2_USE_OIDN
     // fmCU[̐ݒ.
     {
         m_Denoiser = oidnNewDevice(OIDN_DEVICE_TYPE_DEFAULT);
@@ -87,15 +113,101 @@ bool Renderer::Init(const Desc& desc)
         oidnSetFilter1b(m_Filter, "hdr", true);
         oidnCommitFilter(m_Filter);
     }
+#endif
 
     m_Seconds = desc.Seconds;
 
+    // Cut[obt@̐ݒ.
+    if (desc.SharedMemoryName != nullptr)
+    {
+        if (!m_SharedFrame.Init(desc.SharedMemoryName, m_Width, m_Height))
+        { WLOG("Warning : SharedFrame::Init() Failed. Live framebuffer is disabled."); }
+    }
+
+    // őgpʂ̓V[ŜŏWv̂, ǂݍ݂̑O1񂾂Zbg.
+    ResetGeometryMemoryPeak();
+
     if (!OnInit())
     {
         ELOG("Error : OnInit() Faield.");
         return false;
     }
 
+    // ďo҂Ă郁bVo^.
+    if (!FlushMeshes())
+    { return false; }
+
+    // SbVLbVƈv, ̃WIg΍\zς݂BVHg.
+    auto cacheHit = m_SceneCache.IsOpen()
+                 && m_CachedMeshCount == m_SceneCache.GetMeshCount()
+                 && m_CachedMeshCount == m_MeshPaths.size()
+                 && m_CachedMeshCount == m_Meshes.size()
+                 && m_DedupInstanceCount == 0;
+    auto bvhHit = false;
+    if (cacheHit)
+    {
+        BVH::View view = {};
+        bvhHit = m_SceneCache.GetBVH(view) && m_Accel->AttachBVH(view);
+
+        ILOG("Info : Scene Cache Loaded. path = %" ASDX_PRIs ", meshes = %u, bvh = %" ASDX_PRIs ", mapped = %.2lf MB",
+            m_SceneCachePath.c_str(),
+            m_CachedMeshCount,
+            bvhHit ? "yes" : "no",
+            double(m_SceneCache.GetFileSize()) / (1024.0 * 1024.0));
+    }
+
+    // OnInit() ŒǉꂽWIg\\z.
+    if (!m_Accel->Commit())
+    {
+        ELOG("Error : Accel::Commit() Failed.");
+        return false;
+    }
+
+    // WIg͉\ƋLĂ̂, vV[̎gpɂȂ.
+    {
+        const auto MB    = 1.0 / (1024.0 * 1024.0);
+        const auto stats = m_Accel->GetStats();
+        ILOG("Info : Scene Built. geometry = %.2lf MB (peak %.2lf MB), accel = %.2lf MB (peak %.2lf MB), build = %.2lf ms",
+            double(GetGeometryMemorySize()) * MB,
+            double(GetGeometryMemoryPeak()) * MB,
+            double(stats.MemorySize) * MB,
+            double(stats.PeakMemorySize) * MB,
+            stats.BuildMsec);
+
+        // _͗ʎqĕێĂ̂, float ŎꍇƔׂč팸ʂo.
+        size_t attributeSize = 0;
+        size_t floatSize     = 0;
+        for(const auto& meshes : { &m_Meshes, &m_Prototypes })
+        {
+            for(const auto& mesh : *meshes)
+            {
+                if (!mesh)
+                { continue; }
+                attributeSize += mesh->Attributes.GetMemorySize();
+                floatSize     += mesh->Attributes.GetFloatMemorySize();
+            }
+        }
+        if (floatSize > 0)
+        {
+            ILOG("Info : Vertex Attributes. quantized = %.2lf MB, float = %.2lf MB (%.1lf%% saved)",
+                double(attributeSize) * MB,
+                double(floatSize) * MB,
+                100.0 * (1.0 - double(attributeSize) / double(floatSize)));
+        }
+
+        // \zԂ͂قڎOp`ɔႷ̂, \zOp`̎Ԃ猩ς.
+        if (m_DedupInstanceCount > 0 && m_UniqueTriangleCount > 0)
+        {
+            ILOG("Info : Mesh Dedup. build time saved = %.2lf ms (estimated from %u triangles not built)",
+                stats.BuildMsec * double(m_DedupTriangleCount) / double(m_UniqueTriangleCount),
+                m_DedupTriangleCount);
+        }
+    }
+
+    // gݍBVHȂ̂ɃLbVɖꍇ.
+    if (!m_SceneCachePath.empty() && (!cacheHit || (!bvhHit && m_Accel->GetBackend() == ACCEL_BACKEND_BVH)))
+    { WriteSceneCache(); }
+
     return true;
 }
 
@@ -106,41 +218,703 @@ void Renderer::Term()
 {
     OnTerm();
 
+    m_SharedFrame.Term();
+
     m_ColorBuffer .clear();
     m_AlbedoBuffer.clear();
     m_NormalBuffer.clear();
     m_OutputBuffer.clear();
 
+#if SALTY2_USE_OIDN
     oidnReleaseFilter(m_Filter);
     oidnReleaseDevice(m_Denoiser);
+#endif
+
+    if (m_Accel)
+    {
+        m_Accel->Term();
+        m_Accel.reset();
+    }
+
+    // \QƂȂȂĂ.
+    m_Meshes.clear();
+    m_Prototypes.clear();
+    m_PendingMeshes.clear();
+    m_MotionSteps.clear();
+    m_Curves.clear();
+    m_AlphaTests.clear();
+
+    // QƂȂĂ}bv, VLbVɍւ.
+    m_SceneCache.Close();
+    if (m_SceneCachePending)
+    {
+        auto temp = m_SceneCachePath + ".tmp";
+        remove(m_SceneCachePath.c_str());
+        if (rename(temp.c_str(), m_SceneCachePath.c_str()) != 0)
+        { WLOG("Warning : Scene Cache Replace Failed. path = %" ASDX_PRIs, m_SceneCachePath.c_str()); }
+        m_SceneCachePending = false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      bVǂݍ, \ɓo^܂.
+//-----------------------------------------------------------------------------
+uint32_t Renderer::LoadMesh(const char* path)
+{
+    std::unique_ptr<Mesh> mesh(new Mesh());
+
+    // LbVœt@CێĂ, ͂ɎQƂ.
+    auto index = uint32_t(m_MeshPaths.size());
+    if (m_SceneCache.IsMeshValid(index, path) && m_SceneCache.AttachMesh(index, *mesh))
+    { m_CachedMeshCount++; }
+    else if (!::LoadMesh(path, *mesh))
+    {
+        ELOG("Error : LoadMesh() Failed. path = %" ASDX_PRIs, path);
+        return RTC_INVALID_GEOMETRY_ID;
+    }
+    m_MeshPaths.push_back(path);
+
+    // d͑SbVĂ猟ô, o^x点ĔԍɕԂ.
+    if (m_DedupMeshes)
+    {
+        m_PendingMeshes.push_back(std::move(mesh));
+        return m_GeometryCount++;
+    }
+
+    auto geomID = AddMeshGeometry(mesh);
+    if (geomID == RTC_INVALID_GEOMETRY_ID)
+    { ELOG("Error : Accel::AddSharedTriangles() Failed. path = %" ASDX_PRIs, path); }
+
+    return geomID;
+}
+
+//-----------------------------------------------------------------------------
+//      bV\ɓo^܂.
+//-----------------------------------------------------------------------------
+uint32_t Renderer::AddMeshGeometry(std::unique_ptr<Mesh>& mesh)
+{
+    auto geomID = m_Accel->AddSharedTriangles(
+        mesh->Positions.GetData(), mesh->GetVertexCount(),
+        mesh->Indices  .GetData(), mesh->GetTriangleCount());
+    if (geomID == RTC_INVALID_GEOMETRY_ID)
+    { return RTC_INVALID_GEOMETRY_ID; }
+
+    if (geomID >= m_Meshes.size())
+    { m_Meshes.resize(geomID + 1); }
+
+    m_Meshes[geomID] = std::move(mesh);
+    m_GeometryCount  = std::max(m_GeometryCount, geomID + 1);
+    return geomID;
+}
+
+//-----------------------------------------------------------------------------
+//      ďo҂Ă郁bVo^܂.
+//-----------------------------------------------------------------------------
+bool Renderer::FlushMeshes()
+{
+    if (m_PendingMeshes.empty())
+    { return true; }
+
+    const auto count    = uint32_t(m_PendingMeshes.size());
+    const auto base     = m_GeometryCount - count;
+    const auto pathBase = m_MeshPaths.size() - count;
+
+    std::vector<const Mesh*> meshes(count);
+    for(auto i=0u; i<count; ++i)
+    { meshes[i] = m_PendingMeshes[i].get(); }
+
+    MeshDedupResult dedup;
+    FindDuplicateMeshes(meshes.data(), count, dedup);
+
+    // d̖bV͂̂܂, dbV͑\bVvg^CvɂCX^XƂēo^.
+    // LoadMesh() ̌Ăяoɓo^̂, ԋpς݂̔ԍ̂܂܃WIgԍɂȂ.
+    m_GeometryCount = base;
+
+    std::vector<uint32_t> prototypes(count, RTC_INVALID_GEOMETRY_ID);
+    auto prototypeCount = 0u;
+    for(auto i=0u; i<count; ++i)
+    {
+        const auto  path  = m_MeshPaths[pathBase + i].c_str();
+        const auto  proto = dedup.Prototypes[i];
+
+        uint32_t geomID;
+        if (dedup.GroupSizes[proto] == 1)
+        {
+            m_UniqueTriangleCount += m_PendingMeshes[i]->GetTriangleCount();
+
+            geomID = AddMeshGeometry(m_PendingMeshes[i]);
+            if (geomID == RTC_INVALID_GEOMETRY_ID)
+            {
+                ELOG("Error : Accel::AddSharedTriangles() Failed. path = %" ASDX_PRIs, path);
+                return false;
+            }
+        }
+        else
+        {
+            // \bV͔ԍł̂, ŏɌꂽ_Ńvg^Cvɂ.
+            if (prototypes[proto] == RTC_INVALID_GEOMETRY_ID)
+            {
+                auto& mesh = m_PendingMeshes[proto];
+                prototypes[proto] = m_Accel->AddPrototype(
+                    mesh->Positions.GetData(), mesh->GetVertexCount(),
+                    mesh->Indices  .GetData(), mesh->GetTriangleCount());
+                if (prototypes[proto] == RTC_INVALID_GEOMETRY_ID)
+                {
+                    ELOG("Error : Accel::AddPrototype() Failed. path = %" ASDX_PRIs, path);
+                    return false;
+                }
+
+                m_UniqueTriangleCount += mesh->GetTriangleCount();
+
+                if (prototypes[proto] >= m_Prototypes.size())
+                { m_Prototypes.resize(prototypes[proto] + 1); }
+                m_Prototypes[prototypes[proto]] = std::move(mesh);
+                prototypeCount++;
+            }
+
+            geomID = m_Accel->AddInstance(prototypes[proto], dedup.Transforms[i]);
+            if (geomID == RTC_INVALID_GEOMETRY_ID)
+            {
+                ELOG("Error : Accel::AddInstance() Failed. path = %" ASDX_PRIs, path);
+                return false;
+            }
+
+            m_GeometryCount = std::max(m_GeometryCount, geomID + 1);
+            m_DedupInstanceCount++;
+
+            // \bVȊO͂ŉ.
+            m_PendingMeshes[i].reset();
+        }
+
+        if (geomID != base + i)
+        {
+            ELOG("Error : Geometry ID Mismatch. expected = %u, actual = %u. Do not add geometries through GetAccel() while deduplicating.",
+                base + i, geomID);
+            return false;
+        }
+    }
+
+    m_PendingMeshes.clear();
+    m_DedupTriangleCount += dedup.SavedTriangleCount;
+
+    ILOG("Info : Mesh Dedup. meshes = %u, prototypes = %u, instances = %u, memory saved = %.2lf MB, triangles saved = %u, time = %.2lf ms",
+        count,
+        prototypeCount,
+        dedup.DuplicateCount + prototypeCount,
+        double(dedup.SavedMemorySize) / (1024.0 * 1024.0),
+        dedup.SavedTriangleCount,
+        dedup.Msec);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      bV擾܂.
+//-----------------------------------------------------------------------------
+const Mesh* Renderer::GetMesh(uint32_t geomID) const
+{
+    if (geomID < m_Meshes.size() && m_Meshes[geomID])
+    { return m_Meshes[geomID].get(); }
+
+    // dbV̓CX^XɂȂĂ.
+    return GetPrototype(m_Accel->GetInstancePrototype(geomID));
+}
+
+//-----------------------------------------------------------------------------
+//      bV̔^ݒ肵܂.
+//-----------------------------------------------------------------------------
+bool Renderer::SetAlphaMask(uint32_t geomID, const AlphaMask* mask)
+{
+    // dbVǂ͓o^܂Ō܂Ȃ.
+    if (!FlushMeshes())
+    { return false; }
+
+    if (geomID >= m_Meshes.size() || !m_Meshes[geomID])
+    {
+        // dbV̓vg^Cvɐݒ肷̂, `̑SbVŋL.
+        auto prototype = m_Accel->GetInstancePrototype(geomID);
+        if (prototype == RTC_INVALID_GEOMETRY_ID)
+        {
+            ELOG("Error : Invalid Mesh. geomID = %u", geomID);
+            return false;
+        }
+
+        return SetPrototypeAlphaMask(prototype, mask);
+    }
+
+    const auto* mesh = m_Meshes[geomID].get();
+    if (mask == nullptr)
+    { return m_Accel->SetHitFilter(geomID, nullptr, nullptr); }
+
+    if (mesh->Attributes.TexCoords.GetCount() == 0)
+    { WLOG("Warning : Mesh Has No TexCoords. geomID = %u, barycentrics are used instead.", geomID); }
+
+    std::unique_ptr<AlphaTestSource> source(new AlphaTestSource());
+    source->pMesh = mesh;
+    source->pMask = mask;
+
+    if (!m_Accel->SetHitFilter(geomID, AlphaTest, source.get()))
+    {
+        ELOG("Error : Accel::SetHitFilter() Failed. geomID = %u", geomID);
+        return false;
+    }
+
+    m_AlphaTests.push_back(std::move(source));
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      vg^Cv̔^ݒ肵܂.
+//-----------------------------------------------------------------------------
+bool Renderer::SetPrototypeAlphaMask(uint32_t prototype, const AlphaMask* mask)
+{
+    const auto* mesh = GetPrototype(prototype);
+    if (mesh == nullptr)
+    {
+        ELOG("Error : Invalid Prototype. prototype = %u", prototype);
+        return false;
+    }
+
+    if (mask == nullptr)
+    { return m_Accel->SetPrototypeHitFilter(prototype, nullptr, nullptr); }
 
-    rtcReleaseScene(m_Scene);
-    rtcReleaseDevice(m_Device);
+    if (mesh->Attributes.TexCoords.GetCount() == 0)
+    { WLOG("Warning : Prototype Has No TexCoords. prototype = %u, barycentrics are used instead.", prototype); }
+
+    std::unique_ptr<AlphaTestSource> source(new AlphaTestSource());
+    source->pMesh = mesh;
+    source->pMask = mask;
+
+    if (!m_Accel->SetPrototypeHitFilter(prototype, AlphaTest, source.get()))
+    {
+        ELOG("Error : Accel::SetPrototypeHitFilter() Failed. prototype = %u", prototype);
+        return false;
+    }
+
+    m_AlphaTests.push_back(std::move(source));
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ԃXebvƂ̃bVǂݍ, \ɓo^܂.
+//-----------------------------------------------------------------------------
+uint32_t Renderer::LoadMotionMesh(const char* const* paths, uint32_t timeStepCount)
+{
+    if (paths == nullptr || timeStepCount == 0)
+    {
+        ELOG("Error : Invalid Argument. timeStepCount = %u", timeStepCount);
+        return RTC_INVALID_GEOMETRY_ID;
+    }
+
+    // ɕԋpԍƑ邽, x点Ă郁bVo^Ă.
+    if (!FlushMeshes())
+    { return RTC_INVALID_GEOMETRY_ID; }
+
+    // _͎ԃXebvԂŕԂ̂, SXebvŒ_ƃCfbNXvĂKv.
+    std::vector<std::unique_ptr<Mesh>> steps(timeStepCount);
+    std::vector<const asdx::Vector3*>  vertices(timeStepCount);
+    for(auto i=0u; i<timeStepCount; ++i)
+    {
+        steps[i].reset(new Mesh());
+        if (!::LoadMesh(paths[i], *steps[i]))
+        {
+            ELOG("Error : LoadMesh() Failed. path = %" ASDX_PRIs, paths[i]);
+            return RTC_INVALID_GEOMETRY_ID;
+        }
+
+        if (i > 0)
+        {
+            // _͎ԃXebv0̂̂ĝ, ̃Xebv͎̕Ȃ.
+            steps[i]->Attributes.Clear();
+
+            const auto& base = *steps[0];
+            const auto& mesh = *steps[i];
+            if (mesh.GetVertexCount() != base.GetVertexCount()
+             || mesh.GetTriangleCount() != base.GetTriangleCount()
+             || memcmp(mesh.Indices.GetData(), base.Indices.GetData(), sizeof(uint32_t) * 3 * base.GetTriangleCount()) != 0)
+            {
+                ELOG("Error : Topology Mismatch. path = %" ASDX_PRIs ", step = %u", paths[i], i);
+                return RTC_INVALID_GEOMETRY_ID;
+            }
+        }
+
+        vertices[i] = steps[i]->Positions.GetData();
+    }
+
+    auto geomID = m_Accel->AddSharedMotionTriangles(
+        vertices.data(), timeStepCount, steps[0]->GetVertexCount(),
+        steps[0]->Indices.GetData(), steps[0]->GetTriangleCount());
+    if (geomID == RTC_INVALID_GEOMETRY_ID)
+    {
+        ELOG("Error : Accel::AddSharedMotionTriangles() Failed. path = %" ASDX_PRIs, paths[0]);
+        return RTC_INVALID_GEOMETRY_ID;
+    }
+
+    // ̎QƂ͎ԃXebv0̃bVg.
+    if (geomID >= m_Meshes.size())
+    { m_Meshes.resize(geomID + 1); }
+    if (geomID >= m_MotionSteps.size())
+    { m_MotionSteps.resize(geomID + 1); }
+
+    m_Meshes[geomID] = std::move(steps[0]);
+    steps.erase(steps.begin());
+    m_MotionSteps[geomID] = std::move(steps);
+    m_GeometryCount = std::max(m_GeometryCount, geomID + 1);
+    return geomID;
+}
+
+//-----------------------------------------------------------------------------
+//      CX^XŎQƂ郁bVǂݍ, \ɓo^܂.
+//-----------------------------------------------------------------------------
+uint32_t Renderer::LoadPrototype(const char* path)
+{
+    std::unique_ptr<Mesh> mesh(new Mesh());
+    if (!::LoadMesh(path, *mesh))
+    {
+        ELOG("Error : LoadMesh() Failed. path = %" ASDX_PRIs, path);
+        return RTC_INVALID_GEOMETRY_ID;
+    }
+
+    auto prototype = m_Accel->AddPrototype(
+        mesh->Positions.GetData(), mesh->GetVertexCount(),
+        mesh->Indices  .GetData(), mesh->GetTriangleCount());
+    if (prototype == RTC_INVALID_GEOMETRY_ID)
+    {
+        ELOG("Error : Accel::AddPrototype() Failed. path = %" ASDX_PRIs, path);
+        return RTC_INVALID_GEOMETRY_ID;
+    }
+
+    if (prototype >= m_Prototypes.size())
+    { m_Prototypes.resize(prototype + 1); }
+
+    m_Prototypes[prototype] = std::move(mesh);
+    return prototype;
+}
+
+//-----------------------------------------------------------------------------
+//      vg^CṽCX^Xǉ܂.
+//-----------------------------------------------------------------------------
+uint32_t Renderer::AddInstance(uint32_t prototype, const asdx::Matrix& transform)
+{
+    // ɕԋpԍƑ邽, x点Ă郁bVo^Ă.
+    if (!FlushMeshes())
+    { return RTC_INVALID_GEOMETRY_ID; }
+
+    auto geomID = m_Accel->AddInstance(prototype, transform);
+    if (geomID == RTC_INVALID_GEOMETRY_ID)
+    {
+        ELOG("Error : Accel::AddInstance() Failed. prototype = %u", prototype);
+        return RTC_INVALID_GEOMETRY_ID;
+    }
+
+    m_GeometryCount = std::max(m_GeometryCount, geomID + 1);
+    return geomID;
+}
+
+//-----------------------------------------------------------------------------
+//      ԃXebvƂ̕ϊsCX^Xǉ܂.
+//-----------------------------------------------------------------------------
+uint32_t Renderer::AddMotionInstance(uint32_t prototype, const asdx::Matrix* transforms, uint32_t timeStepCount)
+{
+    // ɕԋpԍƑ邽, x点Ă郁bVo^Ă.
+    if (!FlushMeshes())
+    { return RTC_INVALID_GEOMETRY_ID; }
+
+    auto geomID = m_Accel->AddMotionInstance(prototype, transforms, timeStepCount);
+    if (geomID == RTC_INVALID_GEOMETRY_ID)
+    {
+        ELOG("Error : Accel::AddMotionInstance() Failed. prototype = %u", prototype);
+        return RTC_INVALID_GEOMETRY_ID;
+    }
+
+    m_GeometryCount = std::max(m_GeometryCount, geomID + 1);
+    return geomID;
+}
+
+//-----------------------------------------------------------------------------
+//      ̎_ŎOp`ɕpb`Qǉ܂.
+//-----------------------------------------------------------------------------
+uint32_t Renderer::AddPatches(const PatchSource* source)
+{
+    // ɕԋpԍƑ邽, x点Ă郁bVo^Ă.
+    if (!FlushMeshes())
+    { return RTC_INVALID_GEOMETRY_ID; }
+
+    auto geomID = m_Accel->AddPatches(source);
+    if (geomID == RTC_INVALID_GEOMETRY_ID)
+    {
+        ELOG("Error : Accel::AddPatches() Failed.");
+        return RTC_INVALID_GEOMETRY_ID;
+    }
+
+    m_GeometryCount = std::max(m_GeometryCount, geomID + 1);
+    return geomID;
+}
+
+//-----------------------------------------------------------------------------
+//      BXvCȐ(є)ǉ܂.
+//-----------------------------------------------------------------------------
+uint32_t Renderer::AddCurves(const Curves* curves)
+{
+    if (curves == nullptr || curves->GetSegmentCount() == 0)
+    {
+        ELOG("Error : Invalid Argument.");
+        return RTC_INVALID_GEOMETRY_ID;
+    }
+
+    // ɕԋpԍƑ邽, x点Ă郁bVo^Ă.
+    if (!FlushMeshes())
+    { return RTC_INVALID_GEOMETRY_ID; }
+
+    auto geomID = m_Accel->AddCurves(curves);
+    if (geomID == RTC_INVALID_GEOMETRY_ID)
+    {
+        ELOG("Error : Accel::AddCurves() Failed.");
+        return RTC_INVALID_GEOMETRY_ID;
+    }
+
+    if (geomID >= m_Curves.size())
+    { m_Curves.resize(geomID + 1, nullptr); }
+    m_Curves[geomID] = curves;
+
+    m_GeometryCount = std::max(m_GeometryCount, geomID + 1);
+
+    ILOG("Info : Curves Added. geomID = %u, type = %" ASDX_PRIs ", strands = %u, segments = %u, memory = %.2lf MB (%.1lf bytes/strand)",
+        geomID,
+        (curves->GetType() == CURVE_TYPE_ROUND) ? "round" : "flat",
+        curves->GetStrandCount(),
+        curves->GetSegmentCount(),
+        double(curves->GetMemorySize()) / (1024.0 * 1024.0),
+        double(curves->GetMemorySize()) / double(curves->GetStrandCount()));
+
+    return geomID;
+}
+
+//-----------------------------------------------------------------------------
+//      vg^CṽbV擾܂.
+//-----------------------------------------------------------------------------
+const Mesh* Renderer::GetPrototype(uint32_t prototype) const
+{
+    if (prototype >= m_Prototypes.size())
+    { return nullptr; }
+
+    return m_Prototypes[prototype].get();
+}
+
+//-----------------------------------------------------------------------------
+//      bV擾܂.
+//-----------------------------------------------------------------------------
+const Mesh* Renderer::GetHitMesh(const RTCHit& hit) const
+{
+    // CX^X̏ꍇ geomID ̓vg^Cv̔ԍȂ̂, CX^X.
+    if (hit.instID[0] != RTC_INVALID_GEOMETRY_ID)
+    { return GetPrototype(m_Accel->GetInstancePrototype(hit.instID[0])); }
+
+    return GetMesh(hit.geomID);
+}
+
+//-----------------------------------------------------------------------------
+//      Ȑ̏擾܂.
+//-----------------------------------------------------------------------------
+bool Renderer::GetCurveHit(const RTCHit& hit, CurveHit& result) const
+{
+    // Ȑ̓CX^XȂ̂, ŏʂ̃WIgԍ.
+    if (hit.instID[0] != RTC_INVALID_GEOMETRY_ID)
+    { return false; }
+
+    if (hit.geomID >= m_Curves.size() || m_Curves[hit.geomID] == nullptr)
+    { return false; }
+
+    return m_Curves[hit.geomID]->GetHit(hit.primID, hit.u, result);
+}
+
+//-----------------------------------------------------------------------------
+//      bV̒_擾܂.
+//-----------------------------------------------------------------------------
+bool Renderer::GetHitAttributes(const RTCHit& hit, SurfaceAttributes& result) const
+{
+    // Ȑpb`̓bVȂ̂ŏ.
+    auto mesh = GetHitMesh(hit);
+    if (mesh == nullptr || hit.primID >= mesh->GetTriangleCount())
+    { return false; }
+
+    DecodeAttributes(*mesh, hit.primID, hit.u, hit.v, result);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      CX^X̕ϊs擾܂.
+//-----------------------------------------------------------------------------
+bool Renderer::GetInstanceTransform(uint32_t instID, asdx::Matrix& transform, float time) const
+{ return m_Accel->GetInstanceTransform(instID, transform, time); }
+
+//-----------------------------------------------------------------------------
+//      bV̒_WpɎ擾܂.
+//-----------------------------------------------------------------------------
+asdx::Vector3* Renderer::MapPositions(uint32_t geomID)
+{
+    // dbV̓vg^CvLĂ̂ŏȂ.
+    if (geomID >= m_Meshes.size() || !m_Meshes[geomID])
+    { return nullptr; }
+
+    // ԃXebvbV͍XVłȂ.
+    if (geomID < m_MotionSteps.size() && !m_MotionSteps[geomID].empty())
+    { return nullptr; }
+
+    return m_Meshes[geomID]->Positions.GetData();
+}
+
+//-----------------------------------------------------------------------------
+//      _W̃t[Ŕf܂.
+//-----------------------------------------------------------------------------
+bool Renderer::UnmapPositions(uint32_t geomID)
+{
+    if (!m_Accel->UpdateTriangles(geomID))
+    {
+        ELOG("Error : Accel::UpdateTriangles() Failed. geomID = %u", geomID);
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      CX^X̕ϊsύX܂.
+//-----------------------------------------------------------------------------
+bool Renderer::SetInstanceTransform(uint32_t instID, const asdx::Matrix& transform)
+{
+    if (!m_Accel->SetInstanceTransform(instID, transform))
+    {
+        ELOG("Error : Accel::SetInstanceTransform() Failed. instID = %u", instID);
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      V[LbVo܂.
+//-----------------------------------------------------------------------------
+void Renderer::WriteSceneCache()
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    // dbV͌̒_ĂȂ̂ŏoȂ.
+    if (m_DedupInstanceCount > 0)
+    {
+        WLOG("Warning : Scene Cache Is Not Written. Meshes are deduplicated into instances.");
+        return;
+    }
+
+    // LbṼbVԍ LoadMesh() ̌ĂяoȂ̂, geomID ɑĂꍇo.
+    if (m_MeshPaths.size() != m_Meshes.size())
+    {
+        WLOG("Warning : Scene Cache Is Not Written. Geometries not loaded by LoadMesh() are found.");
+        return;
+    }
+
+    SceneCacheWriter writer;
+    for(size_t i=0; i<m_Meshes.size(); ++i)
+    { writer.AddMesh(m_MeshPaths[i].c_str(), *m_Meshes[i]); }
+
+    BVH::View view = {};
+    if (m_Accel->GetBVH(view))
+    { writer.SetBVH(view); }
+
+    // JĂLbV̓}bvȂ̂, ꎞt@CɏoďIɍւ.
+    auto path = m_SceneCachePath;
+    if (m_SceneCache.IsOpen())
+    { path += ".tmp"; }
+
+    if (!writer.Write(path.c_str()))
+    {
+        WLOG("Warning : SceneCacheWriter::Write() Failed. path = %" ASDX_PRIs, path.c_str());
+        return;
+    }
+
+    m_SceneCachePending = m_SceneCache.IsOpen();
+
+    auto msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    ILOG("Info : Scene Cache Written. path = %" ASDX_PRIs ", meshes = %zu, bvh = %" ASDX_PRIs ", time = %.2lf ms",
+        path.c_str(), m_Meshes.size(), (view.NodeCount > 0) ? "yes" : "no", msec);
 }
 
 //-----------------------------------------------------------------------------
 //      `揈s܂.
 //-----------------------------------------------------------------------------
 void Renderer::Run()
+{ Render("result.png"); }
+
+//-----------------------------------------------------------------------------
+//      AԂŕ`揈s܂.
+//-----------------------------------------------------------------------------
+void Renderer::RunSequence(uint32_t frameCount)
 {
-    RTCIntersectContext context;
-    rtcInitIntersectContext(&context);
+    // foCXV[, obt@͍蒼, t[ƂɕύX̂WIgXV.
+    for(auto frame=0u; frame<frameCount; ++frame)
+    {
+        if (!OnUpdate(frame))
+        { break; }
+
+        if (!m_Accel->Commit())
+        {
+            ELOG("Error : Accel::Commit() Failed. frame = %u", frame);
+            break;
+        }
+        const auto stats = m_Accel->GetStats();
+
+        ClearBuffers();
 
+        auto begin = std::chrono::steady_clock::now();
+
+        char path[64];
+        snprintf(path, sizeof(path), "result_%04u.png", frame);
+        Render(path);
+
+        auto msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        ILOG("Info : Frame %u. update = %.2lf ms (refit = %u, rebuild = %u), render = %.2lf ms",
+            frame, stats.BuildMsec, stats.RefitCount, stats.RebuildCount, msec);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      1t[`悵, 摜ۑ܂.
+//-----------------------------------------------------------------------------
+void Renderer::Render(const char* path)
+{
     // Axhobt@Ɩ@obt@𐶐.
     {
     }
 
+    // 1t[͑Sf1񂸂ǐՂ1pX, t[Ԃ̒~ς͂Ȃ.
+    // ̂ߋLɍڂ銮ς݃pX, `r 0, Ss`I 1 ŌŒɂȂ.
+    const uint32_t partialPassCount  = 0;
+    const uint32_t completePassCount = 1;
+
+    m_PublishTimer.Start();
+
     // Let's Cg!!
     for(auto y=0u; y<m_Height; ++y)
     {
         for(auto x=0u; x<m_Width; ++x)
         {
+            // Vb^[ԓ̎fƂɂ炷(R2 ). ˌg.
             RTCRayHit record = {};
+            if (m_ShutterOpen != m_ShutterClose)
+            {
+                auto u = 0.5f + float(x) * 0.7548776662f + float(y) * 0.5698402910f;
+                u -= floorf(u);
+                record.ray.time = m_ShutterOpen + (m_ShutterClose - m_ShutterOpen) * u;
+            }
+            else
+            { record.ray.time = m_ShutterOpen; }
             OnRayGen(record.ray, x, y);
 
             for(auto d=0u; d<m_MaxBounce; ++d)
             {
-                rtcIntersect1(m_Scene, &context, &record);
+                record.hit.geomID    = RTC_INVALID_GEOMETRY_ID;
+                record.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
+                m_Accel->Intersect1(record);
                 auto idx = CalcIndex(x, y);
                 if (record.hit.geomID == RTC_INVALID_GEOMETRY_ID)
                 {
@@ -152,16 +926,60 @@ void Renderer::Run()
                 { break; }
             }
         }
+
+        // ro߂ԊuŋLɌJ.
+        if (m_SharedFrame.IsValid())
+        {
+            m_PublishTimer.End();
+            if (m_PublishTimer.GetElapsedSec() >= 1.0)
+            {
+                m_SharedFrame.Publish(m_ColorBuffer.data(), m_OutputBuffer.data(), partialPassCount);
+                m_PublishTimer.Start();
+            }
+        }
+    }
+
+    m_SharedFrame.Publish(m_ColorBuffer.data(), m_OutputBuffer.data(), completePassCount);
+
+    // ʂ̓LbV̏𒴂Ȃ̂, ʐςĂőgpʂ͕ςȂ.
+    {
+        const auto MB    = 1.0 / (1024.0 * 1024.0);
+        const auto stats = m_Accel->GetStats().Tessellation;
+        if (stats.TessellateCount > 0)
+        {
+            ILOG("Info : Tessellation Cache. memory = %.2lf MB (peak %.2lf MB, capacity %.2lf MB, slots %.2lf MB), patches = %u, tessellated = %llu (%llu triangles, %.2lf ms), evicted = %llu",
+                double(stats.MemorySize) * MB,
+                double(stats.PeakMemorySize) * MB,
+                double(stats.Capacity) * MB,
+                double(stats.SlotMemorySize) * MB,
+                stats.ResidentCount,
+                (unsigned long long)stats.TessellateCount,
+                (unsigned long long)stats.TriangleCount,
+                stats.TessellateMsec,
+                (unsigned long long)stats.EvictCount);
+        }
     }
 
     // fmCYsC摜ۑ.
     {
         
 
-        SavePNG("result.png");
+        SavePNG(path);
     }
 }
 
+//-----------------------------------------------------------------------------
+//      _[^[QbgNA܂.
+//-----------------------------------------------------------------------------
+void Renderer::ClearBuffers()
+{
+    const auto zero = asdx::Vector3(0.0f, 0.0f, 0.0f);
+    std::fill(m_ColorBuffer .begin(), m_ColorBuffer .end(), zero);
+    std::fill(m_AlbedoBuffer.begin(), m_AlbedoBuffer.end(), zero);
+    std::fill(m_NormalBuffer.begin(), m_NormalBuffer.end(), zero);
+    std::fill(m_OutputBuffer.begin(), m_OutputBuffer.end(), zero);
+}
+
 //-----------------------------------------------------------------------------
 //      PNGt@Cɕۑ.
 //-----------------------------------------------------------------------------
@@ -170,7 +988,7 @@ void Renderer::SavePNG(const char* path)
     auto size = m_Width * m_Height;
     std::vector<uint8_t> outputs;
     outputs.resize(size * 3);
-    parallel_for<size_t>(0, size, [&](size_t i)
+    auto convert = [&](size_t i)
     {
 #if 0
         auto r = m_OutputBuffer[i].x;
@@ -195,9 +1013,9 @@ void Renderer::SavePNG(const char* path)
         if ( b < 0.0f ) { b = 0.0f; }
 
         // sRGB OETF
-        r = (r <= 0.0031308f) ? 12.92f * r : std::pow(1.055f * r, 1.0f / 2.4f) - 0.055f;
-        g = (g <= 0.0031308f) ? 12.92f * g : std::pow(1.055f * g, 1.0f / 2.4f) - 0.055f;
-        b = (b <= 0.0031308f) ? 12.92f * b : std::pow(1.055f * b, 1.0f / 2.4f) - 0.055f;
+        r = (r <= 0.0031308f) ? 12.92f * r : 1.055f * std::pow(r, 1.0f / 2.4f) - 0.055f;
+        g = (g <= 0.0031308f) ? 12.92f * g : 1.055f * std::pow(g, 1.0f / 2.4f) - 0.055f;
+        b = (b <= 0.0031308f) ? 12.92f * b : 1.055f * std::pow(b, 1.0f / 2.4f) - 0.055f;
 
         auto R = static_cast<uint8_t>( r * 255.0f + 0.5f );
         auto G = static_cast<uint8_t>( g * 255.0f + 0.5f );
@@ -206,7 +1024,14 @@ void Renderer::SavePNG(const char* path)
         outputs[i * 3 + 0] = R;
         outputs[i * 3 + 1] = G;
         outputs[i * 3 + 2] = B;
-    });
+    };
+
+#if defined(_WIN32)
+    parallel_for<size_t>(0, size, convert);
+#else
+    for(size_t i=0; i<size; ++i)
+    { convert(i); }
+#endif
 
     void* ptr = outputs.data();
     stbi_write_png(path, m_Width, m_Height, 3, ptr, 0);
@@ -0,0 +1,691 @@
+﻿//-----------------------------------------------------------------------------
+// File : sceneCache.cpp
+// Desc : Binary Scene Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <sceneCache.h>
+#include <asdxLogger.h>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Constant Values
+//-----------------------------------------------------------------------------
+static constexpr uint32_t FILE_MAGIC    = ('S' << 0) | ('2' << 8) | ('S' << 16) | ('C' << 24);
+static constexpr uint32_t ENDIAN_TAG    = 0x01020304;
+static constexpr uint64_t BLOB_ALIGN    = 64;   // 各データの先頭アドレスのアライメント.
+static constexpr uint64_t BLOB_PADDING  = 16;   // Embree が末尾を16バイト単位で読み込むための余白.
+
+///////////////////////////////////////////////////////////////////////////////
+// CHUNK_TYPE enum
+///////////////////////////////////////////////////////////////////////////////
+enum CHUNK_TYPE : uint32_t
+{
+    CHUNK_TYPE_MESHES = 0,      // MeshRecord の配列.
+    CHUNK_TYPE_STRINGS,         // パス文字列.
+    CHUNK_TYPE_POSITIONS,       // 頂点座標.
+    CHUNK_TYPE_INDICES,         // インデックス.
+    CHUNK_TYPE_ATTRIBUTE,       // 頂点属性.
+    CHUNK_TYPE_MATERIALS,       // マテリアルテーブル.
+    CHUNK_TYPE_BVH_NODES,       // BVHのノード.
+    CHUNK_TYPE_BVH_LEAVES,      // BVHのリーフ.
+    CHUNK_TYPE_BVH_BOUNDS,      // BVHの境界(float x 6).
+    CHUNK_TYPE_NORMALS,         // 量子化した法線(VertexAttributes::Normals).
+    CHUNK_TYPE_TANGENTS,        // 量子化した接線(VertexAttributes::Tangents).
+    CHUNK_TYPE_TEXCOORDS,       // 量子化したテクスチャ座標(VertexAttributes::TexCoords).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// FileHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct FileHeader
+{
+    uint32_t    Magic;          // FILE_MAGIC.
+    uint32_t    Version;        // SCENE_CACHE_VERSION.
+    uint32_t    Endian;         // ENDIAN_TAG.
+    uint32_t    ChunkCount;     // チャンク数.
+    uint64_t    FileSize;       // ファイルサイズ(途中で書き込みが止まったファイルの検出用).
+    uint32_t    NodeSize;       // sizeof(BVH::Node).
+    uint32_t    LeafSize;       // sizeof(BVH::Leaf).
+    uint32_t    MaterialSize;   // sizeof(Material).
+    uint32_t    Reserved[7];
+};
+static_assert(sizeof(FileHeader) == 64, "Invalid FileHeader Size.");
+
+///////////////////////////////////////////////////////////////////////////////
+// ChunkEntry structure
+///////////////////////////////////////////////////////////////////////////////
+struct ChunkEntry
+{
+    uint32_t    Type;           // CHUNK_TYPE.
+    uint32_t    MeshIndex;      // メッシュ番号(メッシュ単位のデータのみ).
+    uint32_t    Semantic;       // 頂点属性の種類(CHUNK_TYPE_ATTRIBUTE のみ).
+    uint32_t    Stride;         // 要素のサイズ(バイト).
+    uint64_t    Count;          // 要素数.
+    uint64_t    Offset;         // ファイル先頭からのオフセット(BLOB_ALIGN の倍数).
+};
+static_assert(sizeof(ChunkEntry) == 32, "Invalid ChunkEntry Size.");
+
+///////////////////////////////////////////////////////////////////////////////
+// MeshRecord structure
+///////////////////////////////////////////////////////////////////////////////
+struct MeshRecord
+{
+    uint64_t    SourceSize;     // 読み込み元のファイルサイズ.
+    int64_t     SourceTime;     // 読み込み元の更新日時.
+    uint32_t    PathOffset;     // パス文字列の位置.
+    uint32_t    PathLength;     // パス文字列の長さ.
+    uint32_t    VertexCount;    // 頂点数.
+    uint32_t    TriangleCount;  // 三角形数.
+    float       TexCoordRange[4];   // テクスチャ座標の量子化の範囲(VertexAttributes::TexCoordRange).
+};
+static_assert(sizeof(MeshRecord) == 48, "Invalid MeshRecord Size.");
+
+///////////////////////////////////////////////////////////////////////////////
+// Blob structure
+///////////////////////////////////////////////////////////////////////////////
+struct Blob
+{
+    ChunkEntry  Entry;
+    const void* pData;
+};
+
+//-----------------------------------------------------------------------------
+//      アライメントを揃えます.
+//-----------------------------------------------------------------------------
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{ return (value + alignment - 1) & ~(alignment - 1); }
+
+//-----------------------------------------------------------------------------
+//      余白を含めたデータの領域サイズを求めます.
+//-----------------------------------------------------------------------------
+inline uint64_t GetBlobSize(const ChunkEntry& entry)
+{ return AlignUp(uint64_t(entry.Stride) * entry.Count + BLOB_PADDING, BLOB_ALIGN); }
+
+//-----------------------------------------------------------------------------
+//      データの領域がファイル内に収まっているかどうかチェックします.
+//-----------------------------------------------------------------------------
+inline bool IsBlobInFile(const ChunkEntry& entry, uint64_t fileSize)
+{
+    if ((entry.Offset % BLOB_ALIGN) != 0 || entry.Offset > fileSize)
+    { return false; }
+
+    // 壊れた要素数で桁あふれしないよう, 残りのサイズから逆算して比べる.
+    auto rest = fileSize - entry.Offset;
+    if (rest < BLOB_PADDING)
+    { return false; }
+
+    if (entry.Stride != 0 && entry.Count > (rest - BLOB_PADDING) / entry.Stride)
+    { return false; }
+
+    return GetBlobSize(entry) <= rest;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルのサイズと更新日時を取得します.
+//-----------------------------------------------------------------------------
+bool GetFileStamp(const char* path, uint64_t& size, int64_t& time)
+{
+#if defined(_WIN32)
+    struct _stat64 info = {};
+    if (_stat64(path, &info) != 0)
+    { return false; }
+#else
+    struct stat info = {};
+    if (stat(path, &info) != 0)
+    { return false; }
+#endif
+
+    size = uint64_t(info.st_size);
+    time = int64_t(info.st_mtime);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      チャンクを生成します.
+//-----------------------------------------------------------------------------
+inline Blob MakeBlob(uint32_t type, uint32_t meshIndex, uint32_t stride, uint64_t count, const void* data)
+{
+    Blob blob = {};
+    blob.Entry.Type      = type;
+    blob.Entry.MeshIndex = meshIndex;
+    blob.Entry.Stride    = stride;
+    blob.Entry.Count     = count;
+    blob.pData           = data;
+    return blob;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SceneCacheWriter class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      メッシュを追加します.
+//-----------------------------------------------------------------------------
+uint32_t SceneCacheWriter::AddMesh(const char* path, const Mesh& mesh)
+{
+    MeshEntry entry = {};
+    entry.Path  = (path != nullptr) ? path : "";
+    entry.pMesh = &mesh;
+
+    // 取得できない場合は次回の照合で必ず不一致になる.
+    if (!GetFileStamp(entry.Path.c_str(), entry.SourceSize, entry.SourceTime))
+    {
+        entry.SourceSize = 0;
+        entry.SourceTime = -1;
+    }
+
+    m_Meshes.push_back(entry);
+    return uint32_t(m_Meshes.size() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュの頂点属性を追加します.
+//-----------------------------------------------------------------------------
+void SceneCacheWriter::AddAttribute(uint32_t meshIndex, uint32_t semantic, const SceneCacheAttribute& attribute)
+{
+    AttributeEntry entry;
+    entry.MeshIndex = meshIndex;
+    entry.Semantic  = semantic;
+    entry.Attribute = attribute;
+    m_Attributes.push_back(entry);
+}
+
+//-----------------------------------------------------------------------------
+//      マテリアルテーブルを設定します.
+//-----------------------------------------------------------------------------
+void SceneCacheWriter::SetMaterials(const Material* materials, uint32_t count)
+{
+    m_pMaterials    = materials;
+    m_MaterialCount = count;
+}
+
+//-----------------------------------------------------------------------------
+//      構築済みの組み込みBVHを設定します.
+//-----------------------------------------------------------------------------
+void SceneCacheWriter::SetBVH(const BVH::View& view)
+{ m_BVH = view; }
+
+//-----------------------------------------------------------------------------
+//      ファイルに書き出します.
+//-----------------------------------------------------------------------------
+bool SceneCacheWriter::Write(const char* path) const
+{
+    if (path == nullptr)
+    { return false; }
+
+    // メッシュ情報とパス文字列.
+    std::vector<MeshRecord> records(m_Meshes.size());
+    std::string             strings;
+    for(size_t i=0; i<m_Meshes.size(); ++i)
+    {
+        const auto& mesh = m_Meshes[i];
+        auto& record = records[i];
+        record.SourceSize    = mesh.SourceSize;
+        record.SourceTime    = mesh.SourceTime;
+        record.PathOffset    = uint32_t(strings.size());
+        record.PathLength    = uint32_t(mesh.Path.size());
+        record.VertexCount   = mesh.pMesh->GetVertexCount();
+        record.TriangleCount = mesh.pMesh->GetTriangleCount();
+
+        const auto& range = mesh.pMesh->Attributes.TexCoordRange;
+        record.TexCoordRange[0] = range.x;
+        record.TexCoordRange[1] = range.y;
+        record.TexCoordRange[2] = range.z;
+        record.TexCoordRange[3] = range.w;
+        strings += mesh.Path;
+        strings += '\0';
+    }
+
+    std::vector<Blob> blobs;
+    blobs.push_back(MakeBlob(CHUNK_TYPE_MESHES,  0, sizeof(MeshRecord), records.size(), records.data()));
+    blobs.push_back(MakeBlob(CHUNK_TYPE_STRINGS, 0, 1, strings.size(), strings.data()));
+
+    for(size_t i=0; i<m_Meshes.size(); ++i)
+    {
+        const auto& mesh = *m_Meshes[i].pMesh;
+        blobs.push_back(MakeBlob(CHUNK_TYPE_POSITIONS, uint32_t(i), sizeof(asdx::Vector3), mesh.Positions.GetCount(), mesh.Positions.GetData()));
+        blobs.push_back(MakeBlob(CHUNK_TYPE_INDICES,   uint32_t(i), sizeof(uint32_t),      mesh.Indices  .GetCount(), mesh.Indices  .GetData()));
+
+        // 量子化した頂点属性も, 読み込み時にそのまま参照できるよう同じ配置で書き出す.
+        const auto& attributes = mesh.Attributes;
+        if (attributes.Normals.GetCount() > 0)
+        { blobs.push_back(MakeBlob(CHUNK_TYPE_NORMALS,   uint32_t(i), sizeof(uint32_t), attributes.Normals  .GetCount(), attributes.Normals  .GetData())); }
+        if (attributes.Tangents.GetCount() > 0)
+        { blobs.push_back(MakeBlob(CHUNK_TYPE_TANGENTS,  uint32_t(i), sizeof(uint32_t), attributes.Tangents .GetCount(), attributes.Tangents .GetData())); }
+        if (attributes.TexCoords.GetCount() > 0)
+        { blobs.push_back(MakeBlob(CHUNK_TYPE_TEXCOORDS, uint32_t(i), sizeof(uint32_t), attributes.TexCoords.GetCount(), attributes.TexCoords.GetData())); }
+    }
+
+    for(const auto& itr : m_Attributes)
+    {
+        auto blob = MakeBlob(CHUNK_TYPE_ATTRIBUTE, itr.MeshIndex, itr.Attribute.Stride, itr.Attribute.Count, itr.Attribute.pData);
+        blob.Entry.Semantic = itr.Semantic;
+        blobs.push_back(blob);
+    }
+
+    if (m_pMaterials != nullptr && m_MaterialCount > 0)
+    { blobs.push_back(MakeBlob(CHUNK_TYPE_MATERIALS, 0, sizeof(Material), m_MaterialCount, m_pMaterials)); }
+
+    float bounds[6] = {};
+    if (m_BVH.NodeCount > 0)
+    {
+        bounds[0] = m_BVH.Bounds.mini.x;
+        bounds[1] = m_BVH.Bounds.mini.y;
+        bounds[2] = m_BVH.Bounds.mini.z;
+        bounds[3] = m_BVH.Bounds.maxi.x;
+        bounds[4] = m_BVH.Bounds.maxi.y;
+        bounds[5] = m_BVH.Bounds.maxi.z;
+        blobs.push_back(MakeBlob(CHUNK_TYPE_BVH_NODES,  0, sizeof(BVH::Node), m_BVH.NodeCount, m_BVH.pNodes));
+        blobs.push_back(MakeBlob(CHUNK_TYPE_BVH_LEAVES, 0, sizeof(BVH::Leaf), m_BVH.LeafCount, m_BVH.pLeaves));
+        blobs.push_back(MakeBlob(CHUNK_TYPE_BVH_BOUNDS, 0, sizeof(bounds), 1, bounds));
+    }
+
+    // 配置を決める.
+    auto offset = AlignUp(sizeof(FileHeader) + sizeof(ChunkEntry) * blobs.size(), BLOB_ALIGN);
+    for(auto& blob : blobs)
+    {
+        blob.Entry.Offset = offset;
+        offset += GetBlobSize(blob.Entry);
+    }
+
+    FileHeader header = {};
+    header.Magic        = FILE_MAGIC;
+    header.Version      = SCENE_CACHE_VERSION;
+    header.Endian       = ENDIAN_TAG;
+    header.ChunkCount   = uint32_t(blobs.size());
+    header.FileSize     = offset;
+    header.NodeSize     = sizeof(BVH::Node);
+    header.LeafSize     = sizeof(BVH::Leaf);
+    header.MaterialSize = sizeof(Material);
+
+    FILE* pFile = nullptr;
+#if defined(_WIN32)
+    if (fopen_s(&pFile, path, "wb") != 0)
+    { pFile = nullptr; }
+#else
+    pFile = fopen(path, "wb");
+#endif
+    if (pFile == nullptr)
+    {
+        ELOG("Error : File Open Failed. path = %" ASDX_PRIs, path);
+        return false;
+    }
+
+    static const uint8_t zeros[BLOB_ALIGN + BLOB_PADDING] = {};
+
+    auto ret = fwrite(&header, sizeof(header), 1, pFile) == 1;
+    for(const auto& blob : blobs)
+    { ret &= fwrite(&blob.Entry, sizeof(blob.Entry), 1, pFile) == 1; }
+
+    auto pos = uint64_t(sizeof(FileHeader) + sizeof(ChunkEntry) * blobs.size());
+    for(const auto& blob : blobs)
+    {
+        ret &= fwrite(zeros, 1, size_t(blob.Entry.Offset - pos), pFile) == size_t(blob.Entry.Offset - pos);
+
+        auto size = size_t(uint64_t(blob.Entry.Stride) * blob.Entry.Count);
+        if (size > 0)
+        { ret &= fwrite(blob.pData, 1, size, pFile) == size; }
+
+        pos = blob.Entry.Offset + size;
+    }
+    ret &= fwrite(zeros, 1, size_t(offset - pos), pFile) == size_t(offset - pos);
+    ret &= fclose(pFile) == 0;
+
+    if (!ret)
+    {
+        ELOG("Error : File Write Failed. path = %" ASDX_PRIs, path);
+        remove(path);
+        return false;
+    }
+
+    return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SceneCache class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      キャッシュファイルを開きます.
+//-----------------------------------------------------------------------------
+bool SceneCache::Open(const char* path)
+{
+    Close();
+
+    // 無いのは初回なので, エラーにはしない.
+    uint64_t size = 0;
+    int64_t  time = 0;
+    if (path == nullptr || !GetFileStamp(path, size, time) || size < sizeof(FileHeader))
+    { return false; }
+
+    // 書き込み時コピーでマップし, メッシュを書き換えられるようにしておく.
+    if (!m_File.Init(path, true))
+    { return false; }
+
+    auto data   = m_File.GetData();
+    auto header = reinterpret_cast<const FileHeader*>(data);
+    if (header->Magic        != FILE_MAGIC
+     || header->Version      != SCENE_CACHE_VERSION
+     || header->Endian       != ENDIAN_TAG
+     || header->FileSize     != m_File.GetSize()
+     || header->MaterialSize != sizeof(Material)
+     || sizeof(FileHeader) + sizeof(ChunkEntry) * uint64_t(header->ChunkCount) > m_File.GetSize())
+    {
+        WLOG("Warning : Scene Cache Is Outdated. path = %" ASDX_PRIs ", version = %u", path, header->Version);
+        Close();
+        return false;
+    }
+
+    auto chunks = reinterpret_cast<const ChunkEntry*>(data + sizeof(FileHeader));
+    for(auto i=0u; i<header->ChunkCount; ++i)
+    {
+        const auto& chunk = chunks[i];
+        if (!IsBlobInFile(chunk, m_File.GetSize()) || chunk.Count > UINT32_MAX)
+        {
+            WLOG("Warning : Scene Cache Is Broken. path = %" ASDX_PRIs, path);
+            Close();
+            return false;
+        }
+    }
+
+    // メッシュ情報.
+    const MeshRecord* records     = nullptr;
+    const char*       strings     = nullptr;
+    uint64_t          stringCount = 0;
+    for(auto i=0u; i<header->ChunkCount; ++i)
+    {
+        const auto& chunk = chunks[i];
+        if (chunk.Type == CHUNK_TYPE_MESHES && chunk.Stride == sizeof(MeshRecord) && records == nullptr)
+        {
+            // 要素数はファイル内に収まることを確認済みなので, ファイルサイズ以上には確保しない.
+            records = reinterpret_cast<const MeshRecord*>(data + chunk.Offset);
+            m_Meshes.resize(size_t(chunk.Count));
+        }
+        else if (chunk.Type == CHUNK_TYPE_STRINGS && chunk.Stride == 1)
+        {
+            strings     = reinterpret_cast<const char*>(data + chunk.Offset);
+            stringCount = chunk.Count;
+        }
+    }
+
+    if (records == nullptr || strings == nullptr)
+    {
+        WLOG("Warning : Scene Cache Is Broken. path = %" ASDX_PRIs, path);
+        Close();
+        return false;
+    }
+
+    for(size_t i=0; i<m_Meshes.size(); ++i)
+    {
+        const auto& record = records[i];
+        auto& mesh = m_Meshes[i];
+        mesh = {};
+        if (uint64_t(record.PathOffset) + record.PathLength < stringCount)
+        {
+            mesh.pPath      = strings + record.PathOffset;
+            mesh.PathLength = record.PathLength;
+        }
+        mesh.SourceSize    = record.SourceSize;
+        mesh.SourceTime    = record.SourceTime;
+        mesh.TexCoordRange = asdx::Vector4(record.TexCoordRange);
+    }
+
+    // 各データを対応付ける.
+    auto nodeSize = (header->NodeSize == sizeof(BVH::Node) && header->LeafSize == sizeof(BVH::Leaf));
+    for(auto i=0u; i<header->ChunkCount; ++i)
+    {
+        const auto& chunk = chunks[i];
+        auto ptr  = const_cast<uint8_t*>(data) + chunk.Offset;
+        auto size = size_t(GetBlobSize(chunk));
+
+        switch(chunk.Type)
+        {
+        case CHUNK_TYPE_POSITIONS:
+            if (chunk.MeshIndex < m_Meshes.size() && chunk.Stride == sizeof(asdx::Vector3))
+            {
+                auto& mesh = m_Meshes[chunk.MeshIndex];
+                mesh.pPositions   = reinterpret_cast<asdx::Vector3*>(ptr);
+                mesh.PositionSize = size;
+                mesh.VertexCount  = uint32_t(chunk.Count);
+            }
+            break;
+
+        case CHUNK_TYPE_INDICES:
+            if (chunk.MeshIndex < m_Meshes.size() && chunk.Stride == sizeof(uint32_t) && (chunk.Count % 3) == 0)
+            {
+                auto& mesh = m_Meshes[chunk.MeshIndex];
+                mesh.pIndices      = reinterpret_cast<uint32_t*>(ptr);
+                mesh.IndexSize     = size;
+                mesh.TriangleCount = uint32_t(chunk.Count / 3);
+            }
+            break;
+
+        case CHUNK_TYPE_NORMALS:
+            if (chunk.MeshIndex < m_Meshes.size() && chunk.Stride == sizeof(uint32_t))
+            {
+                auto& mesh = m_Meshes[chunk.MeshIndex];
+                mesh.pNormals   = reinterpret_cast<uint32_t*>(ptr);
+                mesh.NormalSize = size;
+            }
+            break;
+
+        case CHUNK_TYPE_TANGENTS:
+            if (chunk.MeshIndex < m_Meshes.size() && chunk.Stride == sizeof(uint32_t))
+            {
+                auto& mesh = m_Meshes[chunk.MeshIndex];
+                mesh.pTangents   = reinterpret_cast<uint32_t*>(ptr);
+                mesh.TangentSize = size;
+            }
+            break;
+
+        case CHUNK_TYPE_TEXCOORDS:
+            if (chunk.MeshIndex < m_Meshes.size() && chunk.Stride == sizeof(uint32_t))
+            {
+                auto& mesh = m_Meshes[chunk.MeshIndex];
+                mesh.pTexCoords   = reinterpret_cast<uint32_t*>(ptr);
+                mesh.TexCoordSize = size;
+            }
+            break;
+
+        case CHUNK_TYPE_ATTRIBUTE:
+            if (chunk.MeshIndex < m_Meshes.size())
+            {
+                AttributeEntry entry;
+                entry.MeshIndex        = chunk.MeshIndex;
+                entry.Semantic         = chunk.Semantic;
+                entry.Attribute.pData  = ptr;
+                entry.Attribute.Stride = chunk.Stride;
+                entry.Attribute.Count  = uint32_t(chunk.Count);
+                m_Attributes.push_back(entry);
+            }
+            break;
+
+        case CHUNK_TYPE_MATERIALS:
+            if (chunk.Stride == sizeof(Material))
+            {
+                m_pMaterials    = reinterpret_cast<const Material*>(ptr);
+                m_MaterialCount = uint32_t(chunk.Count);
+            }
+            break;
+
+        case CHUNK_TYPE_BVH_NODES:
+            if (nodeSize)
+            {
+                m_BVH.pNodes    = reinterpret_cast<const BVH::Node*>(ptr);
+                m_BVH.NodeCount = uint32_t(chunk.Count);
+            }
+            break;
+
+        case CHUNK_TYPE_BVH_LEAVES:
+            if (nodeSize)
+            {
+                m_BVH.pLeaves   = reinterpret_cast<const BVH::Leaf*>(ptr);
+                m_BVH.LeafCount = uint32_t(chunk.Count);
+            }
+            break;
+
+        case CHUNK_TYPE_BVH_BOUNDS:
+            if (chunk.Stride == sizeof(float) * 6 && chunk.Count == 1)
+            {
+                auto bounds = reinterpret_cast<const float*>(ptr);
+                m_BVH.Bounds.mini = asdx::Vector3(bounds[0], bounds[1], bounds[2]);
+                m_BVH.Bounds.maxi = asdx::Vector3(bounds[3], bounds[4], bounds[5]);
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // 不完全なメッシュや, 要素数の食い違うメッシュがあるキャッシュは使わない.
+    auto isConsistent = [](const MeshEntry& mesh, const MeshRecord& record)
+    {
+        if (mesh.pPath == nullptr || mesh.pPositions == nullptr || mesh.pIndices == nullptr)
+        { return false; }
+
+        if (mesh.VertexCount != record.VertexCount || mesh.TriangleCount != record.TriangleCount)
+        { return false; }
+
+        // 量子化した頂点属性は頂点ごとに 4 バイト.
+        const auto attributeSize = sizeof(uint32_t) * size_t(mesh.VertexCount);
+        if ((mesh.pNormals   != nullptr && mesh.NormalSize   < attributeSize)
+         || (mesh.pTangents  != nullptr && mesh.TangentSize  < attributeSize)
+         || (mesh.pTexCoords != nullptr && mesh.TexCoordSize < attributeSize))
+        { return false; }
+
+        // 範囲外のインデックスは走査や属性の参照で領域外を読むので, 全て確かめる.
+        uint32_t maxIndex = 0;
+        const auto indexCount = size_t(mesh.TriangleCount) * 3;
+        for(size_t i=0; i<indexCount; ++i)
+        { maxIndex = std::max(maxIndex, mesh.pIndices[i]); }
+
+        return indexCount == 0 || maxIndex < mesh.VertexCount;
+    };
+
+    for(size_t i=0; i<m_Meshes.size(); ++i)
+    {
+        if (!isConsistent(m_Meshes[i], records[i]))
+        {
+            WLOG("Warning : Scene Cache Is Broken. path = %" ASDX_PRIs ", mesh = %zu", path, i);
+            Close();
+            return false;
+        }
+    }
+
+    // マテリアル番号は三角形ごと, それ以外は頂点ごとのデータなので, 要素数が一致するものだけ残す.
+    m_Attributes.erase(std::remove_if(m_Attributes.begin(), m_Attributes.end(),
+        [&](const AttributeEntry& entry)
+        {
+            const auto& mesh  = m_Meshes[entry.MeshIndex];
+            const auto  count = (entry.Semantic == SCENE_CACHE_SEMANTIC_MATERIAL_ID) ? mesh.TriangleCount : mesh.VertexCount;
+            return entry.Attribute.Count != count;
+        }),
+        m_Attributes.end());
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      キャッシュファイルを閉じます.
+//-----------------------------------------------------------------------------
+void SceneCache::Close()
+{
+    m_Meshes    .clear();
+    m_Attributes.clear();
+    m_pMaterials    = nullptr;
+    m_MaterialCount = 0;
+    m_BVH           = {};
+    m_File.Term();
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュが読み込み元のファイルと一致するかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool SceneCache::IsMeshValid(uint32_t index, const char* path) const
+{
+    if (index >= m_Meshes.size() || path == nullptr)
+    { return false; }
+
+    const auto& mesh = m_Meshes[index];
+    if (strlen(path) != mesh.PathLength || strncmp(path, mesh.pPath, mesh.PathLength) != 0)
+    { return false; }
+
+    uint64_t size = 0;
+    int64_t  time = 0;
+    if (!GetFileStamp(path, size, time))
+    { return false; }
+
+    return size == mesh.SourceSize && time == mesh.SourceTime;
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュをキャッシュのメモリを参照するように設定します.
+//-----------------------------------------------------------------------------
+bool SceneCache::AttachMesh(uint32_t index, Mesh& mesh)
+{
+    if (index >= m_Meshes.size())
+    { return false; }
+
+    const auto& entry = m_Meshes[index];
+    mesh.Positions.Attach(entry.pPositions, entry.VertexCount,          entry.PositionSize);
+    mesh.Indices  .Attach(entry.pIndices,   entry.TriangleCount * 3ull, entry.IndexSize);
+
+    // 頂点属性は頂点ごとに 4 バイトなので, 領域の大きさで頂点数と一致するか確かめる.
+    auto attach = [&](AlignedArray<uint32_t>& dst, uint32_t* src, size_t size)
+    {
+        if (src != nullptr && size >= sizeof(uint32_t) * size_t(entry.VertexCount))
+        { dst.Attach(src, entry.VertexCount, size); }
+        else
+        { dst.Clear(); }
+    };
+    attach(mesh.Attributes.Normals,   entry.pNormals,   entry.NormalSize);
+    attach(mesh.Attributes.Tangents,  entry.pTangents,  entry.TangentSize);
+    attach(mesh.Attributes.TexCoords, entry.pTexCoords, entry.TexCoordSize);
+    mesh.Attributes.TexCoordRange = entry.TexCoordRange;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュの頂点属性を取得します.
+//-----------------------------------------------------------------------------
+bool SceneCache::GetAttribute(uint32_t index, uint32_t semantic, SceneCacheAttribute& attribute) const
+{
+    for(const auto& itr : m_Attributes)
+    {
+        if (itr.MeshIndex == index && itr.Semantic == semantic)
+        {
+            attribute = itr.Attribute;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//      構築済みの組み込みBVHを取得します.
+//-----------------------------------------------------------------------------
+bool SceneCache::GetBVH(BVH::View& view) const
+{
+    if (m_BVH.pNodes == nullptr || m_BVH.NodeCount == 0)
+    { return false; }
+
+    view = m_BVH;
+    return true;
+}
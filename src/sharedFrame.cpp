@@ -0,0 +1,177 @@
+﻿//-----------------------------------------------------------------------------
+// File : sharedFrame.cpp
+// Desc : Shared Memory Frame Buffer.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <sharedFrame.h>
+#include <asdxLogger.h>
+#include <new>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+//      アライメントを揃えます.
+//-----------------------------------------------------------------------------
+inline size_t AlignUp(size_t value, size_t alignment)
+{ return (value + alignment - 1) & ~(alignment - 1); }
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SharedFrame class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+SharedFrame::~SharedFrame()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      共有メモリを生成します.
+//-----------------------------------------------------------------------------
+bool SharedFrame::Init(const char* name, uint32_t width, uint32_t height)
+{
+    // 2回呼ばれた場合に古いマッピングを残さないよう, 先に破棄しておく.
+    Term();
+
+    if (name == nullptr || name[0] == '\0')
+    { return false; }
+
+    const auto bufferSize   = size_t(width) * size_t(height) * sizeof(asdx::Vector3);
+    const auto colorOffset  = AlignUp(sizeof(SharedFrameHeader), 64);
+    const auto outputOffset = AlignUp(colorOffset + bufferSize, 64);
+    m_Size = outputOffset + bufferSize;
+
+#if defined(_WIN32)
+    snprintf(m_Name, sizeof(m_Name), "%s", name);
+#else
+    // POSIX共有メモリ名は'/'始まりである必要がある.
+    snprintf(m_Name, sizeof(m_Name), (name[0] == '/') ? "%s" : "/%s", name);
+#endif
+
+#if defined(_WIN32)
+    auto handle = CreateFileMappingA(
+        INVALID_HANDLE_VALUE,
+        nullptr,
+        PAGE_READWRITE,
+        DWORD(uint64_t(m_Size) >> 32),
+        DWORD(uint64_t(m_Size) & 0xffffffff),
+        m_Name);
+    if (handle == nullptr)
+    {
+        ELOGA("Error : CreateFileMappingA() Failed. name = %s", m_Name);
+        return false;
+    }
+
+    auto ptr = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, m_Size);
+    if (ptr == nullptr)
+    {
+        ELOGA("Error : MapViewOfFile() Failed. name = %s", m_Name);
+        CloseHandle(handle);
+        return false;
+    }
+
+    m_Handle = handle;
+#else
+    auto fd = shm_open(m_Name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        ELOGA("Error : shm_open() Failed. name = %s", m_Name);
+        return false;
+    }
+
+    if (ftruncate(fd, off_t(m_Size)) != 0)
+    {
+        ELOGA("Error : ftruncate() Failed. name = %s", m_Name);
+        close(fd);
+        shm_unlink(m_Name);
+        return false;
+    }
+
+    auto ptr = mmap(nullptr, m_Size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+    {
+        ELOGA("Error : mmap() Failed. name = %s", m_Name);
+        shm_unlink(m_Name);
+        return false;
+    }
+#endif
+
+    m_pBase   = static_cast<uint8_t*>(ptr);
+    m_pHeader = new (m_pBase) SharedFrameHeader();
+
+    m_pHeader->Magic        = SharedFrameHeader::kMagic;
+    m_pHeader->Version      = SharedFrameHeader::kVersion;
+    m_pHeader->Width        = width;
+    m_pHeader->Height       = height;
+    m_pHeader->PassCount    = 0;
+    m_pHeader->Reserved     = 0;
+    m_pHeader->ColorOffset  = colorOffset;
+    m_pHeader->OutputOffset = outputOffset;
+    m_pHeader->Generation.store(0, std::memory_order_release);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      共有メモリを破棄します.
+//-----------------------------------------------------------------------------
+void SharedFrame::Term()
+{
+    if (m_pBase == nullptr)
+    { return; }
+
+    m_pHeader->~SharedFrameHeader();
+
+#if defined(_WIN32)
+    UnmapViewOfFile(m_pBase);
+    CloseHandle(m_Handle);
+#else
+    munmap(m_pBase, m_Size);
+    shm_unlink(m_Name);
+#endif
+
+    m_Handle  = nullptr;
+    m_pBase   = nullptr;
+    m_pHeader = nullptr;
+    m_Size    = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      フレームバッファを公開します.
+//-----------------------------------------------------------------------------
+void SharedFrame::Publish(const asdx::Vector3* colors, const asdx::Vector3* outputs, uint32_t passCount)
+{
+    if (m_pHeader == nullptr)
+    { return; }
+
+    // 読み取り側は世代番号が偶数かつコピー前後で一致した場合のみ有効なフレームとして扱う.
+    auto generation = m_pHeader->Generation.load(std::memory_order_relaxed);
+    m_pHeader->Generation.store(generation + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const auto bufferSize = size_t(m_pHeader->Width) * size_t(m_pHeader->Height) * sizeof(asdx::Vector3);
+    memcpy(m_pBase + m_pHeader->ColorOffset,  colors,  bufferSize);
+    memcpy(m_pBase + m_pHeader->OutputOffset, outputs, bufferSize);
+    m_pHeader->PassCount = passCount;
+
+    m_pHeader->Generation.store(generation + 2, std::memory_order_release);
+}
@@ -0,0 +1,314 @@
+﻿//-----------------------------------------------------------------------------
+// File : tessCache.cpp
+// Desc : Tessellation Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <tessCache.h>
+#include <asdxLogger.h>
+#include <algorithm>
+#include <chrono>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TessellationCache class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+TessellationCache::~TessellationCache()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+void TessellationCache::Init(size_t capacity)
+{
+    Term();
+
+    m_Capacity        = (capacity > 0) ? capacity : DEFAULT_CAPACITY;
+    m_Size            = 0;
+    m_PeakSize        = 0;
+    m_SlotSize        = 0;
+    m_TessellateCount = 0;
+    m_EvictCount      = 0;
+    m_TriangleCount   = 0;
+    m_TessellateMsec  = 0.0;
+    m_Clock.store(0);
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void TessellationCache::Term()
+{
+    for(const auto& itr : m_Residents)
+    { delete m_Groups[itr.Group].pSlots[itr.Patch].pEntry.load(); }
+
+    m_Residents.clear();
+    m_Residents.shrink_to_fit();
+    m_Groups.clear();
+    m_Groups.shrink_to_fit();
+    m_Size     = 0;
+    m_SlotSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      パッチ群を登録します.
+//-----------------------------------------------------------------------------
+uint32_t TessellationCache::Register(const PatchSource* source)
+{
+    Group group;
+    group.pSource = source;
+    group.Count   = source->GetPatchCount();
+    group.pSlots.reset(new Slot[group.Count]);
+    for(auto i=0u; i<group.Count; ++i)
+    {
+        auto& slot = group.pSlots[i];
+        slot.pEntry .store(nullptr);
+        slot.Pins   .store(0);
+        slot.LastUse.store(0);
+    }
+
+    // 管理領域はパッチ数に比例するが, 分割結果と違って面積には依らない.
+    m_SlotSize += sizeof(Slot) * group.Count;
+
+    m_Groups.push_back(std::move(group));
+    return uint32_t(m_Groups.size() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      パッチとの最近傍の交差を求めます.
+//-----------------------------------------------------------------------------
+bool TessellationCache::Intersect(uint32_t group, uint32_t patch, asdx::Ray& ray, BVHHit& hit)
+{
+    auto entry = Acquire(group, patch);
+    if (entry == nullptr)
+    { return false; }
+
+    BVHHit local;
+    auto found = entry->Bvh.Intersect(ray, local);
+    if (found)
+    {
+        // 三角形の重心座標でパッチ上のパラメータを補間する.
+        const auto* indices = entry->Indices.data() + local.PrimID * 3;
+        const auto& p0 = entry->Params[indices[0]];
+        const auto& p1 = entry->Params[indices[1]];
+        const auto& p2 = entry->Params[indices[2]];
+        auto w = 1.0f - local.U - local.V;
+
+        hit.Normal = local.Normal;
+        hit.U      = p0.x * w + p1.x * local.U + p2.x * local.V;
+        hit.V      = p0.y * w + p1.y * local.U + p2.y * local.V;
+        hit.PrimID = patch;
+        hit.GeomID = 0;
+        hit.InstID = BVH::INVALID_ID;
+    }
+
+    Release(group, patch);
+    return found;
+}
+
+//-----------------------------------------------------------------------------
+//      パッチで遮蔽されているかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool TessellationCache::Occluded(uint32_t group, uint32_t patch, const asdx::Ray& ray)
+{
+    auto entry = Acquire(group, patch);
+    if (entry == nullptr)
+    { return false; }
+
+    auto result = entry->Bvh.Occluded(ray);
+
+    Release(group, patch);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      統計情報を取得します.
+//-----------------------------------------------------------------------------
+TessellationStats TessellationCache::GetStats() const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    TessellationStats result = {};
+    result.Capacity        = m_Capacity;
+    result.MemorySize      = m_Size;
+    result.PeakMemorySize  = m_PeakSize;
+    result.SlotMemorySize  = m_SlotSize;
+    result.TessellateCount = m_TessellateCount;
+    result.EvictCount      = m_EvictCount;
+    result.TriangleCount   = m_TriangleCount;
+    result.ResidentCount   = uint32_t(m_Residents.size());
+    result.TessellateMsec  = m_TessellateMsec;
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      分割結果を参照します.
+//-----------------------------------------------------------------------------
+const TessellationCache::Entry* TessellationCache::Acquire(uint32_t group, uint32_t patch)
+{
+    auto& slot = m_Groups[group].pSlots[patch];
+
+    // 参照カウントを先に増やしてからポインタを読む. 追い出し側はポインタを外してから参照カウントを読むので,
+    // どちらも seq_cst なら, 読めたポインタは必ず追い出し側に参照中として見える.
+    slot.Pins.fetch_add(1);
+    const Entry* entry = slot.pEntry.load();
+    if (entry == nullptr)
+    {
+        entry = Insert(group, patch);
+        if (entry == nullptr)
+        {
+            slot.Pins.fetch_sub(1);
+            return nullptr;
+        }
+    }
+
+    // 同じ時刻なら書き込まず, キャッシュラインを汚さないようにする.
+    auto now = m_Clock.load(std::memory_order_relaxed);
+    if (slot.LastUse.load(std::memory_order_relaxed) != now)
+    { slot.LastUse.store(now, std::memory_order_relaxed); }
+
+    return entry;
+}
+
+//-----------------------------------------------------------------------------
+//      分割結果の参照を終えます.
+//-----------------------------------------------------------------------------
+void TessellationCache::Release(uint32_t group, uint32_t patch)
+{ m_Groups[group].pSlots[patch].Pins.fetch_sub(1, std::memory_order_release); }
+
+//-----------------------------------------------------------------------------
+//      パッチを分割してキャッシュに入れます.
+//-----------------------------------------------------------------------------
+const TessellationCache::Entry* TessellationCache::Insert(uint32_t group, uint32_t patch)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    // 分割とBVHの構築はロックの外で行う. 同じパッチを複数のスレッドが同時に分割した場合は, 先に入れた方を使う.
+    std::unique_ptr<Entry> entry(new Entry());
+    {
+        PatchMesh mesh;
+        auto valid = m_Groups[group].pSource->Tessellate(patch, mesh)
+                  && mesh.Params .size() == mesh.Positions.size()
+                  && mesh.Indices.size() % 3 == 0;
+        for(size_t i=0; valid && i<mesh.Indices.size(); ++i)
+        { valid = mesh.Indices[i] < mesh.Positions.size(); }
+
+        // 失敗したパッチも空の結果として入れ, 交差のたびに分割し直さないようにする.
+        if (!valid)
+        {
+            WLOG("Warning : PatchSource::Tessellate() Failed. group = %u, patch = %u", group, patch);
+            mesh.Indices.clear();
+        }
+
+        auto triangleCount = uint32_t(mesh.Indices.size() / 3);
+        if (triangleCount > 0)
+        {
+            entry->Bvh.AddTriangles(mesh.Positions.data(), mesh.Indices.data(), triangleCount);
+            entry->Bvh.Build(1);
+        }
+
+        entry->Params  = std::move(mesh.Params);
+        entry->Indices = std::move(mesh.Indices);
+        entry->Params .shrink_to_fit();
+        entry->Indices.shrink_to_fit();
+        entry->Size = sizeof(Entry)
+                    + entry->Bvh.GetStats().MemorySize
+                    + entry->Params .capacity() * sizeof(asdx::Vector2)
+                    + entry->Indices.capacity() * sizeof(uint32_t);
+    }
+
+    auto msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    // 先に入れられた場合は捨てるので, 統計には含めない.
+    auto& slot = m_Groups[group].pSlots[patch];
+    auto current = slot.pEntry.load();
+    if (current != nullptr)
+    { return current; }
+
+    m_TessellateCount++;
+    m_TriangleCount  += entry->Indices.size() / 3;
+    m_TessellateMsec += msec;
+
+    slot.LastUse.store(m_Clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    slot.pEntry .store(entry.get());
+
+    m_Residents.push_back(Resident{ group, patch });
+    m_Size    += entry->Size;
+    m_PeakSize = std::max(m_PeakSize, m_Size);
+
+    if (m_Size > m_Capacity)
+    { Evict(); }
+
+    return entry.release();
+}
+
+//-----------------------------------------------------------------------------
+//      古い分割結果を追い出します(m_Mutex を取った状態で呼び出します).
+//-----------------------------------------------------------------------------
+void TessellationCache::Evict()
+{
+    // 上限の 7/8 まで減らして, 追い出しの頻度を抑える.
+    const auto target = m_Capacity - m_Capacity / 8;
+
+    // 参照時刻は他のスレッドが更新するので, 写し取ってから並べる.
+    std::vector<std::pair<uint32_t, uint32_t>> order(m_Residents.size());
+    for(size_t i=0; i<m_Residents.size(); ++i)
+    {
+        const auto& resident = m_Residents[i];
+        order[i].first  = m_Groups[resident.Group].pSlots[resident.Patch].LastUse.load(std::memory_order_relaxed);
+        order[i].second = uint32_t(i);
+    }
+
+    // ロック中に全体を並べないよう, 追い出す見込みの数だけ古い順に選び出して並べる.
+    // 参照中のものを飛ばして足りなければ, 残りから倍の数を選び直す.
+    const auto average = std::max<size_t>(1, m_Size / order.size());
+    auto batch = std::max<size_t>(1, (m_Size - target + average - 1) / average);
+
+    std::vector<bool> evicted(m_Residents.size(), false);
+    auto first = order.begin();
+    while(m_Size > target && first != order.end())
+    {
+        auto last = first + std::min<ptrdiff_t>(ptrdiff_t(batch), order.end() - first);
+        std::nth_element(first, last - 1, order.end());
+        std::sort(first, last);
+
+        for(auto itr = first; itr != last && m_Size > target; ++itr)
+        {
+            const auto& resident = m_Residents[itr->second];
+            auto& slot = m_Groups[resident.Group].pSlots[resident.Patch];
+
+            // 参照中なら戻す. 戻すまでの間に参照したスレッドは Insert() に入るが, ロックを取った後に戻したものを使う.
+            auto entry = slot.pEntry.exchange(nullptr);
+            if (slot.Pins.load() != 0)
+            {
+                slot.pEntry.store(entry);
+                continue;
+            }
+
+            m_Size -= entry->Size;
+            delete entry;
+            m_EvictCount++;
+            evicted[itr->second] = true;
+        }
+
+        first  = last;
+        batch *= 2;
+    }
+
+    size_t count = 0;
+    for(size_t i=0; i<m_Residents.size(); ++i)
+    {
+        if (!evicted[i])
+        { m_Residents[count++] = m_Residents[i]; }
+    }
+    m_Residents.resize(count);
+}